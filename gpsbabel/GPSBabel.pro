@@ -28,7 +28,7 @@ ALL_FMTS=$$MINIMAL_FMTS gtm.cc gpsutil.cc pcx.cc \
         pocketfms_bc.cc pocketfms_fp.cc pocketfms_wp.cc naviguide.cc enigma.cc \
         vpl.cc teletype.cc jogmap.cc bushnell.cc bushnell_trl.cc wintec_tes.cc \
         subrip.cc garmin_xt.cc garmin_fit.cc lowranceusr4.cc \
-        mtk_locus.cc googledir.cc mapbar_track.cc mapfactor.cc
+        mtk_locus.cc googledir.cc mapbar_track.cc mapfactor.cc gbsnap.cc
 
 DEPRECIATED_FMTS=cetus.cc copilot.cc gpspilot.cc magnav.cc psp.cc gcdb.cc quovadis.cc gpilots.cc geoniche.cc palmdoc.cc hsa_ndv.cc coastexp.cc pathaway.cc coto.cc msroute.cc mag_pdb.cc axim_gpb.cc
 
@@ -39,7 +39,7 @@ DEPRECIATED_SHAPE=pdbfile.cc
 FILTERS=position.cc radius.cc duplicate.cc arcdist.cc polygon.cc smplrout.cc \
         reverse_route.cc sort.cc stackfilter.cc trackfilter.cc discard.cc \
         nukedata.cc interpolate.cc transform.cc height.cc swapdata.cc bend.cc \
-        validate.cc
+        validate.cc timewindow.cc tile.cc
 
 SHAPE=shapelib/shpopen.c shapelib/dbfopen.c shapelib/safileio.c
 
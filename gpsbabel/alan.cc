@@ -524,7 +524,7 @@ static Waypoint* get_wpt(struct wprdata* wprdata, unsigned n)
   } else {
     WP->description = "";
   }
-  WP->notes = "";
+  WP->AllocExt()->notes = "";
 
   return WP;
 }
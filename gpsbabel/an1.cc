@@ -706,7 +706,7 @@ static void Read_AN1_Waypoints(gbfile* f)
     }
     wpt_tmp->longitude = -DecodeOrd(rec->lon);
     wpt_tmp->latitude = DecodeOrd(rec->lat);
-    wpt_tmp->notes = rec->comment;
+    wpt_tmp->AllocExt()->notes = rec->comment;
     wpt_tmp->description = rec->name;
 
     if (rec->url) {
@@ -724,12 +724,12 @@ static void Read_AN1_Waypoints(gbfile* f)
     }
 
     if (rec->image_name) {
-      wpt_tmp->icon_descr = rec->image_name;
+      wpt_tmp->AllocExt()->icon_descr = rec->image_name;
     } else if (FindIconByGuid(&rec->guid, &icon)) {
-      wpt_tmp->icon_descr = icon;
+      wpt_tmp->AllocExt()->icon_descr = icon;
     }
 
-    fs_chain_add(&(wpt_tmp->fs), (format_specific_data*)rec);
+    fs_chain_add(&(wpt_tmp->AllocExt()->fs), (format_specific_data*)rec);
     rec = NULL;
     waypt_add(wpt_tmp);
   }
@@ -742,7 +742,7 @@ Write_One_AN1_Waypoint(const Waypoint* wpt)
   int local;
   format_specific_data* fs = NULL;
 
-  fs = fs_chain_find(wpt->fs, FS_AN1W);
+  fs = fs_chain_find(wpt->ext->fs, FS_AN1W);
   if (fs) {
     rec = (an1_waypoint_record*)fs;
     xfree(rec->name);
@@ -773,16 +773,16 @@ Write_One_AN1_Waypoint(const Waypoint* wpt)
   }
   rec->name = xstrdup(wpt->description);
 
-  if (!nogc && wpt->gc_data->id) {
+  if (!nogc && wpt->ext->gc_data->id) {
 #if NEW_STRINGS
-    char* extra = (char*) xmalloc(25 + wpt->gc_data->placer.length() + wpt->shortname.length());
+    char* extra = (char*) xmalloc(25 + wpt->ext->gc_data->placer.length() + wpt->shortname.length());
 #else
     char* extra = (char*) xmalloc(25 + strlen(CSTR(wpt->gc_data->placer)) + strlen(wpt->shortname));
 #endif
     sprintf(extra, "\r\nBy %s\r\n%s (%1.1f/%1.1f)",
-            CSTR(wpt->gc_data->placer),
-            CSTRc(wpt->shortname), wpt->gc_data->diff/10.0,
-            wpt->gc_data->terr/10.0);
+            CSTR(wpt->ext->gc_data->placer),
+            CSTRc(wpt->shortname), wpt->ext->gc_data->diff/10.0,
+            wpt->ext->gc_data->terr/10.0);
     rec->name = xstrappend(rec->name, extra);
     xfree(extra);
   }
@@ -799,11 +799,11 @@ Write_One_AN1_Waypoint(const Waypoint* wpt)
     }
     rec->url = xstrdup(l.url_);
   }
-  if (!wpt->notes.isEmpty()) {
+  if (!wpt->ext->notes.isEmpty()) {
     if (rec->comment) {
       xfree(rec->comment);
     }
-    rec->comment = xstrdup(wpt->notes);
+    rec->comment = xstrdup(wpt->ext->notes);
   }
 
 
@@ -813,14 +813,14 @@ Write_One_AN1_Waypoint(const Waypoint* wpt)
   rec->serial = serial++;
 
   if (rec->type == 0x12) {    /* image */
-    if (wpt->icon_descr.contains(":\\")) {
-      rec->image_name = xstrdup(wpt->icon_descr);
+    if (wpt->ext->icon_descr.contains(":\\")) {
+      rec->image_name = xstrdup(wpt->ext->icon_descr);
       rec->height = -244;
       rec->width = -1;
     }
   }
-  if (!rec->image_name && !wpt->icon_descr.isNull()) {
-    FindIconByName(CSTR(wpt->icon_descr), &rec->guid);
+  if (!rec->image_name && !wpt->ext->icon_descr.isNull()) {
+    FindIconByName(CSTR(wpt->ext->icon_descr), &rec->guid);
   }
 
   Write_AN1_Waypoint(outfile, rec);
@@ -875,7 +875,7 @@ static void Read_AN1_Lines(gbfile* f)
       wpt_tmp->latitude = DecodeOrd(vert->lat);
       wpt_tmp->longitude = -DecodeOrd(vert->lon);
       wpt_tmp->shortname = QString().sprintf("\\%5.5lx", rtserial++);
-      fs_chain_add(&wpt_tmp->fs,
+      fs_chain_add(&wpt_tmp->AllocExt()->fs,
                    (format_specific_data*)vert);
       route_add_wpt(rte_head, wpt_tmp);
     }
@@ -1008,7 +1008,7 @@ Write_One_AN1_Vertex(const Waypoint* wpt)
   int local;
   format_specific_data* fs = NULL;
 
-  fs = fs_chain_find(wpt->fs, FS_AN1V);
+  fs = fs_chain_find(wpt->ext->fs, FS_AN1V);
 
   if (fs) {
     rec = (an1_vertex_record*)(void*)fs;
@@ -98,8 +98,8 @@ arcdist_arc_disp_wpt_cb(const Waypoint* arcpt2)
     QUEUE_FOR_EACH(&waypt_head, elem, tmp) {
       waypointp = (Waypoint*) elem;
 #endif
-      if (waypointp->extra_data) {
-        ed = (extra_data*) waypointp->extra_data;
+      if (waypointp->ext->extra_data) {
+        ed = (extra_data*) waypointp->ext->extra_data;
       } else {
         ed = (extra_data*) xcalloc(1, sizeof(*ed));
         ed->distance = BADVAL;
@@ -136,7 +136,7 @@ arcdist_arc_disp_wpt_cb(const Waypoint* arcpt2)
             ed->arcpt2 = (Waypoint*) arcpt2;
           }
         }
-        waypointp->extra_data = ed;
+        waypointp->AllocExt()->extra_data = ed;
       }
     }
   }
@@ -213,8 +213,8 @@ arcdist_process(void)
     Waypoint* wp = (Waypoint*) elem;
 #endif
     extra_data* ed;
-    ed = (extra_data*) wp->extra_data;
-    wp->extra_data = NULL;
+    ed = (extra_data*) wp->ext->extra_data;
+    wp->AllocExt()->extra_data = NULL;
     if (ed) {
       if ((ed->distance >= pos_dist) == (exclopt == NULL)) {
         waypt_del(wp);
@@ -223,7 +223,7 @@ arcdist_process(void)
       } else if (projectopt) {
         wp->longitude = ed->prjlongitude;
         wp->latitude = ed->prjlatitude;
-        wp->route_priority = 1;
+        wp->AllocExt()->route_priority = 1;
         if (!arcfileopt &&
             (ed->arcpt2->altitude != unknown_alt) &&
             (ptsopt || (ed->arcpt1->altitude != unknown_alt))) {
@@ -130,7 +130,7 @@ bcr_handle_icon_str(const char* str, Waypoint* wpt)
 {
   bcr_icon_mapping_t* m;
 
-  wpt->icon_descr = BCR_DEF_MPS_ICON;
+  wpt->AllocExt()->icon_descr = BCR_DEF_MPS_ICON;
 
   for (m = bcr_icon_mapping; (m->bcr_name); m++) {
     if (case_ignore_strcmp(str, m->bcr_name) == 0) {
@@ -146,7 +146,7 @@ bcr_handle_icon_str(const char* str, Waypoint* wpt)
       wpt->description = m->symbol_DE;
       if (m->mps_name != NULL) {
         nr = gt_find_icon_number_from_desc(m->mps_name, MAPSOURCE);
-        wpt->icon_descr = gt_find_desc_from_icon_number(nr, MAPSOURCE);
+        wpt->AllocExt()->icon_descr = gt_find_desc_from_icon_number(nr, MAPSOURCE);
       }
       return;
     }
@@ -310,7 +310,7 @@ bcr_data_read(void)
         *c = '\0';
       }
       if (*str) {
-        wpt->notes = str;
+        wpt->AllocExt()->notes = str;
       }
       if ((str = c)) {
         str++;
@@ -415,7 +415,7 @@ bcr_route_header(const route_head* route)
 
     i++;
 
-    icon = get_bcr_icon_from_icon_descr(wpt->icon_descr);
+    icon = get_bcr_icon_from_icon_descr(wpt->ext->icon_descr);
 
     sout = QString("%1,%2").arg(icon).arg(BCR_UNKNOWN,10);
     bcr_write_line(fout, "STATION", &i, sout);
@@ -458,7 +458,7 @@ bcr_route_header(const route_head* route)
 
     i++;
     wpt = (Waypoint*) elem;
-    s1 = wpt->notes;
+    s1 = wpt->ext->notes;
     if (s1.isEmpty()) {
       s1 = wpt->description;
     }
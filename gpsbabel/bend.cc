@@ -39,6 +39,7 @@ static double minAngle;
 
 static queue* routes_orig = NULL;
 static int routes_orig_num = 0;
+static QVector<QList<Waypoint*> > routes_dest;	/* points of each new route */
 
 static
 arglist_t bend_args[] = {
@@ -115,7 +116,7 @@ is_small_angle(double lat_orig, double long_orig, double lat_orig_prev,
 }
 
 static void
-process_route(const route_head* route_orig, route_head* route_dest)
+process_route(const route_head* route_orig, QList<Waypoint*>& route_dest)
 {
   Waypoint* wpt_orig_prev = NULL;
   Waypoint* wpt_orig = NULL;
@@ -127,7 +128,7 @@ process_route(const route_head* route_orig, route_head* route_dest)
     if (wpt_orig_prev == NULL) {
       if (wpt_orig != NULL) {
         Waypoint* waypoint_dest = new Waypoint(*wpt_orig);
-        route_add_wpt(route_dest, waypoint_dest);
+        route_dest.append(waypoint_dest);
       }
     } else {
       double lat_orig = RAD(wpt_orig->latitude);
@@ -143,18 +144,18 @@ process_route(const route_head* route_orig, route_head* route_dest)
       if (is_small_angle(lat_orig, long_orig, lat_orig_prev,
                          long_orig_prev, lat_orig_next, long_orig_next)) {
         Waypoint* waypoint_dest = new Waypoint(*wpt_orig);
-        route_add_wpt(route_dest, waypoint_dest);
+        route_dest.append(waypoint_dest);
       } else {
         Waypoint* wpt_dest_prev = create_wpt_dest(wpt_orig,
                                   lat_orig, long_orig, lat_orig_prev, long_orig_prev);
         if (wpt_dest_prev != NULL) {
-          route_add_wpt(route_dest, wpt_dest_prev);
+          route_dest.append(wpt_dest_prev);
         }
 
         wpt_dest_next = create_wpt_dest(wpt_orig,
                                         lat_orig, long_orig, lat_orig_next, long_orig_next);
         if (wpt_dest_next != NULL) {
-          route_add_wpt(route_dest, wpt_dest_next);
+          route_dest.append(wpt_dest_next);
 
           wpt_orig = wpt_dest_next;
         }
@@ -167,12 +168,18 @@ process_route(const route_head* route_orig, route_head* route_dest)
 
   if (wpt_orig != NULL) {
     Waypoint* waypoint_dest = new Waypoint(*wpt_orig);
-    route_add_wpt(route_dest, waypoint_dest);
+    route_dest.append(waypoint_dest);
   }
 }
 
 static void
-process_route_orig(const route_head* route_orig)
+process_route_orig(route_head* route_orig, int index)
+{
+  process_route(route_orig, routes_dest[index]);
+}
+
+static void
+add_route_dest(route_head* route_orig, int index)
 {
   route_head* route_dest = route_head_alloc();
   route_dest->rte_name = route_orig->rte_name;
@@ -182,17 +189,18 @@ process_route_orig(const route_head* route_orig)
 
   route_add_head(route_dest);
 
-  process_route(route_orig, route_dest);
+  foreach (Waypoint* wpt, routes_dest[index]) {
+    route_add_wpt(route_dest, wpt);
+  }
+  routes_dest[index].clear();
 }
 
 static void
 bend_process(void)
 {
-  queue* elem, *tmp;
-  QUEUE_FOR_EACH(routes_orig, elem, tmp) {
-    route_head* route_orig = (route_head*)elem;
-    process_route_orig(route_orig);
-  }
+  routes_dest.resize(routes_orig_num);
+  route_q_parallel(routes_orig, process_route_orig, add_route_dest);
+  routes_dest.clear();
 }
 
 static void
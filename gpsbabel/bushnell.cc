@@ -211,7 +211,7 @@ bushnell_read(void)
   lon_tmp = gbfgetint32(file_in);
 
   icon = gbfgetc(file_in);
-  wpt_tmp->icon_descr = bushnell_get_name_from_symbol(icon);
+  wpt_tmp->AllocExt()->icon_descr = bushnell_get_name_from_symbol(icon);
   proximity = gbfgetc(file_in); // 1 = off, 3 = proximity alarm.
   (void) proximity;
   wpt_tmp->latitude = lat_tmp /  10000000.0;
@@ -237,7 +237,7 @@ bushnell_write_one(const Waypoint* wpt)
   file_out = gbfopen_le(fname, "wb", MYNAME);
   gbfputint32(round(wpt->latitude  * 10000000), file_out);
   gbfputint32(round(wpt->longitude * 10000000), file_out);
-  gbfputc(bushnell_get_icon_from_name(wpt->icon_descr), file_out);
+  gbfputc(bushnell_get_icon_from_name(wpt->ext->icon_descr), file_out);
   gbfputc(0x01, file_out);  // Proximity alarm.  1 == "off", 3 == armed.
 
   strncpy(tbuf, CSTRc(wpt->shortname), sizeof(tbuf));
@@ -406,7 +406,7 @@ cet_convert_waypt(const Waypoint* wpt)
 
   w->wpt_flags.cet_converted = 1;
 
-  fs = wpt->fs;
+  fs = wpt->ext->fs;
   while (fs != NULL) {
     if (fs->convert != NULL) {
       fs->convert(fs);
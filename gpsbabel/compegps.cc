@@ -245,7 +245,7 @@ parse_wpt_info(const char* buff, Waypoint* wpt)		/* "w" */
 #endif
       switch (col) {
       case 0:
-        wpt->icon_descr = c;
+        wpt->AllocExt()->icon_descr = c;
         break;
       case 1:
         break;			/* Text postion */
@@ -500,10 +500,10 @@ write_waypt_cb(const Waypoint* wpt)
   }
   gbfprintf(fout, "\n");
 
-  if ((!wpt->icon_descr.isNull()) || (wpt->wpt_flags.proximity) || \
+  if ((!wpt->ext->icon_descr.isNull()) || (wpt->wpt_flags.proximity) || \
       (option_icon != NULL)) {
     gbfprintf(fout, "w  %s,0,0.0,16777215,255,1,7,,%.1f\n",
-              wpt->icon_descr.isNull() ? "Waypoint" : CSTR(wpt->icon_descr),
+              wpt->ext->icon_descr.isNull() ? "Waypoint" : CSTR(wpt->ext->icon_descr),
               WAYPT_GET(wpt, proximity, 0));
   }
 }
@@ -63,7 +63,7 @@ cst_add_wpt(const route_head* track, Waypoint* wpt)
     // Rather than creating a new waypt on each read, tis format bizarrely
     // recycles the same one, relying on new waypoint(*) above and then manually
     // resetting fields.  Weird.
-    wpt->url_link_list_.clear();
+    wpt->AllocExt()->url_link_list_.clear();
 
     if (temp_route == NULL) {
       temp_route = route_head_alloc();
@@ -236,7 +236,7 @@ cst_data_read(void)
             line++;
             cin = lrtrim(buff);
             if (*cin != '\0') {
-              wpt->notes = QString::fromLatin1(cin);
+              wpt->AllocExt()->notes = QString::fromLatin1(cin);
             }
           } else if (strcmp(cin + 2, "end") == 0) {
             data = 1;
@@ -168,6 +168,7 @@ static route_head* csv_track, *csv_route;
 static double utm_northing, utm_easting, utm_zone = 0;
 static char utm_zonec;
 static UrlLink* link_;
+static GPS_ODatum_Transform xcsv_datum_xform;
 #endif // CSVFMTS_ENABLED
 
 
@@ -967,7 +968,7 @@ gmsd_init(Waypoint* wpt)
   garmin_fs_t* gmsd = GMSD_FIND(wpt);
   if (gmsd == NULL) {
     gmsd = garmin_fs_alloc(-1);
-    fs_chain_add(&wpt->fs, (format_specific_data*) gmsd);
+    fs_chain_add(&wpt->AllocExt()->fs, (format_specific_data*) gmsd);
   }
   return gmsd;
 }
@@ -1010,7 +1011,7 @@ xcsv_parse_val(const char* s, Waypoint* wpt, const field_map_t* fmp,
     wpt->description = csv_stringtrim(s, enclosure);
     break;
   case XT_NOTES:
-    wpt->notes = csv_stringtrim(s, "");
+    wpt->AllocExt()->notes = csv_stringtrim(s, "");
     break;
   case XT_URL:
     if (!link_) {
@@ -1025,7 +1026,7 @@ xcsv_parse_val(const char* s, Waypoint* wpt, const field_map_t* fmp,
     link_->url_link_text_ = QString(s).trimmed();
     break;
   case XT_ICON_DESCR:
-    wpt->icon_descr = QString(s).trimmed();
+    wpt->AllocExt()->icon_descr = QString(s).trimmed();
     break;
 
     /* LATITUDE CONVERSIONS**************************************************/
@@ -1262,13 +1263,13 @@ xcsv_parse_val(const char* s, Waypoint* wpt, const field_map_t* fmp,
 
     /* GPS STUFF *******************************************************/
   case XT_GPS_HDOP:
-    wpt->hdop = atof(s);
+    wpt->AllocExt()->hdop = atof(s);
     break;
   case XT_GPS_VDOP:
-    wpt->vdop = atof(s);
+    wpt->AllocExt()->vdop = atof(s);
     break;
   case XT_GPS_PDOP:
-    wpt->pdop = atof(s);
+    wpt->AllocExt()->pdop = atof(s);
     break;
   case XT_GPS_SAT:
     wpt->sat = atoi(s);
@@ -1310,28 +1311,28 @@ xcsv_parse_val(const char* s, Waypoint* wpt, const field_map_t* fmp,
 
     /* OTHER STUFF ***************************************************/
   case XT_PATH_DISTANCE_METERS:
-    wpt->odometer_distance = atof(s);
+    wpt->AllocExt()->odometer_distance = atof(s);
     break;
   case XT_PATH_DISTANCE_KM:
-    wpt->odometer_distance = atof(s) * 1000.0;
+    wpt->AllocExt()->odometer_distance = atof(s) * 1000.0;
     break;
   case XT_PATH_DISTANCE_MILES:
-    wpt->odometer_distance = MILES_TO_METERS(atof(s));
+    wpt->AllocExt()->odometer_distance = MILES_TO_METERS(atof(s));
     break;
   case XT_HEART_RATE:
-    wpt->heartrate = atoi(s);
+    wpt->AllocExt()->heartrate = atoi(s);
     break;
   case XT_CADENCE:
-    wpt->cadence = atoi(s);
+    wpt->AllocExt()->cadence = atoi(s);
     break;
   case XT_POWER:
-    wpt->power = atof(s);
+    wpt->AllocExt()->power = atof(s);
     break;
   case XT_TEMPERATURE:
-    wpt->temperature = atof(s);
+    wpt->AllocExt()->temperature = atof(s);
     break;
   case XT_TEMPERATURE_F:
-    wpt->temperature = (FAHRENHEIT_TO_CELSIUS(atof(s)));
+    wpt->AllocExt()->temperature = (FAHRENHEIT_TO_CELSIUS(atof(s)));
     break;
     /* GMSD ****************************************************************/
   case XT_COUNTRY: {
@@ -1405,6 +1406,10 @@ xcsv_data_read(void)
   utm_zone = 0;
   utm_zonec = 'N';
 
+  if ((xcsv_file.gps_datum > -1) && (xcsv_file.gps_datum != GPS_DATUM_WGS84)) {
+    GPS_Math_Datum_Transform_Init(&xcsv_datum_xform, xcsv_file.gps_datum, DATUM_WGS84);
+  }
+
   csv_route = csv_track = NULL;
   if (xcsv_file.datatype == trkdata) {
     csv_track = trk;
@@ -1475,8 +1480,8 @@ xcsv_data_read(void)
 
       if ((xcsv_file.gps_datum > -1) && (xcsv_file.gps_datum != GPS_DATUM_WGS84)) {
         double alt;
-        GPS_Math_Known_Datum_To_WGS84_M(wpt_tmp->latitude, wpt_tmp->longitude, 0.0,
-                                        &wpt_tmp->latitude, &wpt_tmp->longitude, &alt, xcsv_file.gps_datum);
+        GPS_Math_Datum_Transform(&xcsv_datum_xform, wpt_tmp->latitude, wpt_tmp->longitude, 0.0,
+                                 &wpt_tmp->latitude, &wpt_tmp->longitude, &alt);
       }
 
       if (utm_easting || utm_northing) {
@@ -1540,6 +1545,33 @@ xcsv_resetpathlen(const route_head* head)
   }
 }
 
+/*****************************************************************************/
+/* xcsv_fmt_double() - sprintf a double; the plain "%f", "%.Nf" and their    */
+/*                     "%lf" spellings skip the printf machinery.            */
+/*****************************************************************************/
+static QString
+xcsv_fmt_double(const char* fmt, double d)
+{
+  const char* p = fmt;
+  int prec = 6;
+  char buf[32];
+  int len;
+
+  if (*p++ == '%') {
+    if (*p == '.' && isdigit(p[1])) {
+      prec = p[1] - '0';
+      p += 2;
+    }
+    if (*p == 'l') {
+      p++;
+    }
+    if (p[0] == 'f' && p[1] == '\0' && (len = fixed_dtoa(buf, d, prec)) >= 0) {
+      return QString::fromLatin1(buf, len);
+    }
+  }
+  return QString().sprintf(fmt, d);
+}
+
 /*****************************************************************************/
 /* xcsv_waypt_pr() - write output file, handling output conversions          */
 /*                  (the output meat)                                        */
@@ -1603,8 +1635,8 @@ xcsv_waypt_pr(const Waypoint* wpt)
 
   if ((xcsv_file.gps_datum > -1) && (xcsv_file.gps_datum != GPS_DATUM_WGS84)) {
     double alt;
-    GPS_Math_WGS84_To_Known_Datum_M(latitude, longitude, 0.0,
-                                    &latitude, &longitude, &alt, xcsv_file.gps_datum);
+    GPS_Math_Datum_Transform(&xcsv_datum_xform, latitude, longitude, 0.0,
+                             &latitude, &longitude, &alt);
   }
 
   i = 0;
@@ -1664,7 +1696,7 @@ xcsv_waypt_pr(const Waypoint* wpt)
         anyname = mkshort(xcsv_file.mkshort_handle, wpt->description);
       }
       if (anyname.isEmpty()) {
-        anyname = wpt->notes;
+        anyname = wpt->ext->notes;
       }
       if (anyname.isEmpty()) {
         anyname = fmp->val;
@@ -1679,7 +1711,7 @@ xcsv_waypt_pr(const Waypoint* wpt)
       break;
     case XT_NOTES:
       buff = QString().sprintf(fmp->printfc,
-                wpt->notes.isEmpty() ? fmp->val : CSTR(wpt->notes));
+                wpt->ext->notes.isEmpty() ? fmp->val : CSTR(wpt->ext->notes));
       break;
     case XT_URL: {
       if (xcsv_urlbase) {
@@ -1702,14 +1734,14 @@ xcsv_waypt_pr(const Waypoint* wpt)
       break;
     case XT_ICON_DESCR:
       buff = QString().sprintf(fmp->printfc,
-                (!wpt->icon_descr.isNull()) ?
-                CSTR(wpt->icon_descr) : fmp->val);
+                (!wpt->ext->icon_descr.isNull()) ?
+                CSTR(wpt->ext->icon_descr) : fmp->val);
       break;
 
       /* LATITUDE CONVERSION***********************************************/
     case XT_LAT_DECIMAL:
       /* latitude as a pure decimal value */
-      buff = QString().sprintf(fmp->printfc, lat);
+      buff = xcsv_fmt_double(fmp->printfc, lat);
       break;
     case XT_LAT_DECIMALDIR:
       /* latitude as a decimal value with N/S after it */
@@ -1741,7 +1773,7 @@ xcsv_waypt_pr(const Waypoint* wpt)
       /* LONGITUDE CONVERSIONS*********************************************/
     case XT_LON_DECIMAL:
       /* longitude as a pure decimal value */
-      buff = QString().sprintf(fmp->printfc, lon);
+      buff = xcsv_fmt_double(fmp->printfc, lon);
       break;
     case XT_LON_DECIMALDIR:
       /* latitude as a decimal value with N/S after it */
@@ -1847,8 +1879,7 @@ xcsv_waypt_pr(const Waypoint* wpt)
       break;
     case XT_ALT_METERS:
       /* altitude in meters as a decimal value */
-      buff = QString().sprintf(fmp->printfc,
-                wpt->altitude);
+      buff = xcsv_fmt_double(fmp->printfc, wpt->altitude);
       break;
 
       /* DISTANCE CONVERSIONS**********************************************/
@@ -1856,24 +1887,24 @@ xcsv_waypt_pr(const Waypoint* wpt)
       /* if not available, use calculated distance from positions */
     case XT_PATH_DISTANCE_MILES:
       /* path (route/track) distance in miles */
-      if (wpt->odometer_distance) {
-        buff = QString().sprintf(fmp->printfc, METERS_TO_MILES(wpt->odometer_distance));
+      if (wpt->ext->odometer_distance) {
+        buff = QString().sprintf(fmp->printfc, METERS_TO_MILES(wpt->ext->odometer_distance));
       } else {
         buff = QString().sprintf(fmp->printfc, pathdist);
       }
       break;
     case XT_PATH_DISTANCE_METERS:
       /* path (route/track) distance in meters */
-      if (wpt->odometer_distance) {
-        buff = QString().sprintf(fmp->printfc, wpt->odometer_distance);
+      if (wpt->ext->odometer_distance) {
+        buff = QString().sprintf(fmp->printfc, wpt->ext->odometer_distance);
       } else {
         buff = QString().sprintf(fmp->printfc, MILES_TO_METERS(pathdist));
       }
       break;
     case XT_PATH_DISTANCE_KM:
       /* path (route/track) distance in kilometers */
-      if (wpt->odometer_distance) {
-        buff = QString().sprintf(fmp->printfc, wpt->odometer_distance / 1000.0);
+      if (wpt->ext->odometer_distance) {
+        buff = QString().sprintf(fmp->printfc, wpt->ext->odometer_distance / 1000.0);
       } else {
         buff = QString().sprintf(fmp->printfc, MILES_TO_METERS(pathdist) / 1000.0);
       }
@@ -1896,21 +1927,21 @@ xcsv_waypt_pr(const Waypoint* wpt)
 
       /* HEART RATE CONVERSION***********************************************/
     case XT_HEART_RATE:
-      buff = QString().sprintf(fmp->printfc, wpt->heartrate);
+      buff = QString().sprintf(fmp->printfc, wpt->ext->heartrate);
       break;
       /* CADENCE CONVERSION***********************************************/
     case XT_CADENCE:
-      buff = QString().sprintf(fmp->printfc, wpt->cadence);
+      buff = QString().sprintf(fmp->printfc, wpt->ext->cadence);
       break;
       /* POWER CONVERSION***********************************************/
     case XT_POWER:
-      buff = QString().sprintf(fmp->printfc, wpt->power);
+      buff = QString().sprintf(fmp->printfc, wpt->ext->power);
       break;
     case XT_TEMPERATURE:
-      buff = QString().sprintf(fmp->printfc, wpt->temperature);
+      buff = QString().sprintf(fmp->printfc, wpt->ext->temperature);
       break;
     case XT_TEMPERATURE_F:
-      buff = QString().sprintf(fmp->printfc, CELSIUS_TO_FAHRENHEIT(wpt->temperature));
+      buff = QString().sprintf(fmp->printfc, CELSIUS_TO_FAHRENHEIT(wpt->ext->temperature));
       break;
       /* TIME CONVERSIONS**************************************************/
     case XT_EXCEL_TIME:
@@ -1954,50 +1985,50 @@ xcsv_waypt_pr(const Waypoint* wpt)
       buff = wpt->GetCreationTime().toPrettyString();
       break;
     case XT_GEOCACHE_LAST_FOUND:
-      buff = QString().sprintf(fmp->printfc, time_to_yyyymmdd(wpt->gc_data->last_found));
+      buff = QString().sprintf(fmp->printfc, time_to_yyyymmdd(wpt->ext->gc_data->last_found));
       break;
       /* GEOCACHE STUFF **************************************************/
     case XT_GEOCACHE_DIFF:
       /* Geocache Difficulty as a double */
-      buff = QString().sprintf(fmp->printfc, wpt->gc_data->diff / 10.0);
-      field_is_unknown = !wpt->gc_data->diff;
+      buff = QString().sprintf(fmp->printfc, wpt->ext->gc_data->diff / 10.0);
+      field_is_unknown = !wpt->ext->gc_data->diff;
       break;
     case XT_GEOCACHE_TERR:
       /* Geocache Terrain as a double */
-      buff = QString().sprintf(fmp->printfc, wpt->gc_data->terr / 10.0);
-      field_is_unknown = !wpt->gc_data->terr;
+      buff = QString().sprintf(fmp->printfc, wpt->ext->gc_data->terr / 10.0);
+      field_is_unknown = !wpt->ext->gc_data->terr;
       break;
     case XT_GEOCACHE_CONTAINER:
       /* Geocache Container */
-      buff = QString().sprintf(fmp->printfc, gs_get_container(wpt->gc_data->container));
-      field_is_unknown = wpt->gc_data->container == gc_unknown;
+      buff = QString().sprintf(fmp->printfc, gs_get_container(wpt->ext->gc_data->container));
+      field_is_unknown = wpt->ext->gc_data->container == gc_unknown;
       break;
     case XT_GEOCACHE_TYPE:
       /* Geocache Type */
-      buff = QString().sprintf(fmp->printfc, gs_get_cachetype(wpt->gc_data->type));
-      field_is_unknown = wpt->gc_data->type == gt_unknown;
+      buff = QString().sprintf(fmp->printfc, gs_get_cachetype(wpt->ext->gc_data->type));
+      field_is_unknown = wpt->ext->gc_data->type == gt_unknown;
       break;
     case XT_GEOCACHE_HINT:
-      buff = QString().sprintf(fmp->printfc, CSTR(wpt->gc_data->hint));
-      field_is_unknown = !wpt->gc_data->hint.isEmpty();
+      buff = QString().sprintf(fmp->printfc, CSTR(wpt->ext->gc_data->hint));
+      field_is_unknown = !wpt->ext->gc_data->hint.isEmpty();
       break;
     case XT_GEOCACHE_PLACER:
-      buff = QString().sprintf(fmp->printfc, CSTR(wpt->gc_data->placer));
-      field_is_unknown = !wpt->gc_data->placer.isEmpty();
+      buff = QString().sprintf(fmp->printfc, CSTR(wpt->ext->gc_data->placer));
+      field_is_unknown = !wpt->ext->gc_data->placer.isEmpty();
       break;
     case XT_GEOCACHE_ISAVAILABLE:
-      if (wpt->gc_data->is_available == status_false) {
+      if (wpt->ext->gc_data->is_available == status_false) {
         buff = QString().sprintf(fmp->printfc, "False");
-      } else if (wpt->gc_data->is_available == status_true) {
+      } else if (wpt->ext->gc_data->is_available == status_true) {
         buff = QString().sprintf(fmp->printfc, "True");
       } else {
         buff = QString().sprintf(fmp->printfc, "Unknown");
       }
       break;
     case XT_GEOCACHE_ISARCHIVED:
-      if (wpt->gc_data->is_archived == status_false) {
+      if (wpt->ext->gc_data->is_archived == status_false) {
         buff = QString().sprintf(fmp->printfc, "False");
-      } else if (wpt->gc_data->is_archived == status_true) {
+      } else if (wpt->ext->gc_data->is_archived == status_true) {
         buff = QString().sprintf(fmp->printfc, "True");
       } else {
         buff = QString().sprintf(fmp->printfc, "Unknown");
@@ -2028,16 +2059,16 @@ xcsv_waypt_pr(const Waypoint* wpt)
 
       /* GPS STUFF *******************************************************/
     case XT_GPS_HDOP:
-      buff = QString().sprintf(fmp->printfc, wpt->hdop);
-      field_is_unknown = !wpt->hdop;
+      buff = QString().sprintf(fmp->printfc, wpt->ext->hdop);
+      field_is_unknown = !wpt->ext->hdop;
       break;
     case XT_GPS_VDOP:
-      buff = QString().sprintf(fmp->printfc, wpt->vdop);
-      field_is_unknown = !wpt->vdop;
+      buff = QString().sprintf(fmp->printfc, wpt->ext->vdop);
+      field_is_unknown = !wpt->ext->vdop;
       break;
     case XT_GPS_PDOP:
-      buff = QString().sprintf(fmp->printfc, wpt->pdop);
-      field_is_unknown = !wpt->pdop;
+      buff = QString().sprintf(fmp->printfc, wpt->ext->pdop);
+      field_is_unknown = !wpt->ext->pdop;
       break;
     case XT_GPS_SAT:
       buff = QString().sprintf(fmp->printfc, wpt->sat);
@@ -2174,6 +2205,10 @@ xcsv_data_write(void)
   /* reset the index counter */
   waypt_out_count = 0;
 
+  if ((xcsv_file.gps_datum > -1) && (xcsv_file.gps_datum != GPS_DATUM_WGS84)) {
+    GPS_Math_Datum_Transform_Init(&xcsv_datum_xform, DATUM_WGS84, xcsv_file.gps_datum);
+  }
+
   time = gpsbabel_time;
   if (time == 0) {	/* testo script ? */
     tm = *gmtime(&time);
@@ -96,6 +96,37 @@ typedef struct char_map {
   const char* chars;
 } char_map_t;
 
+/*
+ * an internal style, parsed from style/ at build time by mkstyle.sh.
+ * Strings a style doesn't set are NULL; the field lists end with a
+ * NULL key, the prologue and epilogue lists with a NULL line.
+ */
+typedef struct xcsv_field {
+  const char* key;
+  const char* val;
+  const char* printfc;
+  int options;
+} xcsv_field_t;
+
+typedef struct xcsv_style {
+  const char* description;
+  const char* extension;
+  const char* field_delimiter;
+  const char* field_encloser;
+  const char* record_delimiter;
+  const char* badchars;
+  ff_type type;
+  gpsdata_type datatype;
+  int shortlen;			/* -1 if not given */
+  int shortwhite;		/* -1 if not given */
+  const char* encoding;
+  const char* datum;
+  const char* const* prologue;
+  const char* const* epilogue;
+  const xcsv_field_t* ifield;
+  const xcsv_field_t* ofield;
+} xcsv_style_t;
+
 /*
  * a Class describing all the wonderful elements of xcsv files, in a
  * nutshell.
@@ -40,6 +40,7 @@
 #include <QtCore/QDebug>
 #include <QtCore/QTextCodec>
 #include <QtCore/QTextStream>
+#include <QtCore/QVector>
 
 # include "src/core/datetime.h"
 
@@ -201,6 +202,9 @@ typedef struct {
   char* charset_name;
   inifile_t* inifile;
   QTextCodec* codec;
+  int gzlevel;		/* compression level for .gz output, -1 for zlib's default */
+  int gzindex;		/* keep seek indexes beside gzip compressed input */
+  int threads;		/* threads for per-route filter work, 0 for one per CPU */
 } global_options;
 
 extern global_options global_opts;
@@ -415,19 +419,81 @@ public:
     trait_cadence(0),
     trait_power(0),
     trait_depth(0),
-    trait_temperature(0) {}
+    trait_temperature(0),
+    trait_shortname(0),
+    trait_altitude(0),
+    trait_icon(0),
+    trait_description(0),
+    trait_notes(0),
+    trait_url(0),
+    trait_time(0),
+    trait_date(0),
+    trait_fix(0),
+    trait_hdop(0),
+    trait_vdop(0),
+    trait_pdop(0),
+    trait_sat(0),
+    trait_course(0),
+    trait_speed(0),
+    trait_proximity(0),
+    trait_gmsd(0),
+    trait_gc_data(0) {}
   unsigned int trait_geocaches:1;
   unsigned int trait_heartrate:1;
   unsigned int trait_cadence:1;
   unsigned int trait_power:1;
   unsigned int trait_depth:1;
   unsigned int trait_temperature:1;
+  /* Field presence.  "description" and "notes" only count when they
+   * aren't copies of the shortname (or, for notes, the description). */
+  unsigned int trait_shortname:1;
+  unsigned int trait_altitude:1;
+  unsigned int trait_icon:1;
+  unsigned int trait_description:1;
+  unsigned int trait_notes:1;
+  unsigned int trait_url:1;
+  unsigned int trait_time:1;
+  unsigned int trait_date:1;		/* time is past the first day */
+  unsigned int trait_fix:1;
+  unsigned int trait_hdop:1;
+  unsigned int trait_vdop:1;
+  unsigned int trait_pdop:1;
+  unsigned int trait_sat:1;
+  unsigned int trait_course:1;
+  unsigned int trait_speed:1;
+  unsigned int trait_proximity:1;
+  unsigned int trait_gmsd:1;		/* garmin_fs_t attached */
+  unsigned int trait_gc_data:1;		/* any geocache data */
 };
 
 const global_trait* get_traits();
 
-#define WAYPT_SET(wpt,member,val) { wpt->member = (val); wpt->wpt_flags.member = 1; }
-#define WAYPT_GET(wpt,member,def) ((wpt->wpt_flags.member) ? (wpt->member) : (def))
+/*
+ * The same traits kept for each of the waypoint, route and track lists.
+ * Unlike the above these are exact or not available at all: get_traits()
+ * returns NULL once a filter, a deletion, a writer or a reader that keeps
+ * changing points after it handed them over may have made them stale.
+ * Readers that only ever add finished points say so with
+ * traits_add_complete() from their rd_init.
+ */
+const global_trait* get_traits(gpsdata_type type);
+void traits_begin_read(void);
+void traits_add_complete(void);
+void traits_end_read(void);
+void traits_invalidate(void);
+
+/*
+ * Bounds and track statistics are memoized on the lists and kept up to
+ * date by the add/del functions.  Code that edits points in place (filters,
+ * chiefly) must call cache_invalidate() before and after; main does so
+ * around each filter, so a value cached while the filter ran doesn't
+ * outlive its edits.
+ */
+extern unsigned int cache_generation;
+void cache_invalidate(void);
+
+#define WAYPT_SET(wpt,member,val) { WAYPT_WR_##member(wpt) = (val); wpt->wpt_flags.member = 1; }
+#define WAYPT_GET(wpt,member,def) ((wpt->wpt_flags.member) ? (WAYPT_RD_##member(wpt)) : (def))
 #define WAYPT_UNSET(wpt,member) wpt->wpt_flags.member = 0
 #define WAYPT_HAS(wpt,member) (wpt->wpt_flags.member)
 
@@ -439,23 +505,34 @@ const global_trait* get_traits();
 typedef const QString& xg_string;
 
 /*
- * This is a waypoint, as stored in the GPSR.   It tries to not
- * cater to any specific model or protocol.  Anything that needs to
- * be truncated, edited, or otherwise trimmed should be done on the
- * way to the target.
+ * The members of a Waypoint that most points never use.  A Waypoint
+ * starts out pointing at one shared, read-only block of defaults and
+ * only gets a block of its own from AllocExt(), on the way to setting
+ * one of these.  Read them through wpt->ext, set them through
+ * wpt->AllocExt().
  */
-class Waypoint
+class waypt_ext
 {
-private:
+public:
   static geocache_data empty_gc_data;
 
-public:
-  queue Q;			/* Master waypoint q.  Not for use
-					   by modules. */
+  waypt_ext() :
+    geoidheight(0),
+    depth(0),
+    proximity(0),
+    route_priority(0),
+    hdop(0),
+    vdop(0),
+    pdop(0),
+    heartrate(0),
+    cadence(0),
+    power(0),
+    temperature(0),
+    odometer_distance(0),
+    gc_data(&empty_gc_data),
+    fs(NULL),
+    extra_data(NULL) {}
 
-  double latitude;		/* Degrees */
-  double longitude; 		/* Degrees */
-  double altitude; 		/* Meters. */
   double geoidheight;	/* Height (in meters) of geoid (mean sea level) above WGS84 earth ellipsoid. */
 
   /*
@@ -472,22 +549,9 @@ public:
    */
   double proximity;
 
-  /* shortname is a waypoint name as stored in receiver.  It should
-   * strive to be, well, short, and unique.   Enforcing length and
-   * character restrictions is the job of the output.   A typical
-   * minimum length for shortname is 6 characters for NMEA units,
-   * 8 for Magellan and 10 for Vista.   These are only guidelines.
-   */
-  QString shortname;
-  /*
-   * description is typically a human readable description of the
-   * waypoint.   It may be used as a comment field in some receivers.
-   * These are probably under 40 bytes, but that's only a guideline.
-   */
-  QString description;
   /*
    * notes are relatively long - over 100 characters - prose associated
-   * with the above.   Unlike shortname and description, these are never
+   * with the shortname and description.   Unlike shortname and description, these are never
    * used to compute anything else and are strictly "passed through".
    * Few formats support this.
    */
@@ -497,11 +561,8 @@ public:
    */
   QList<UrlLink> url_link_list_;
 
-  wp_flags wpt_flags;
   QString icon_descr;
 
-  gpsbabel::DateTime creation_time;
-
   /*
    * route priority is for use by the simplify filter.  If we have
    * some reason to believe that the route point is more important,
@@ -520,20 +581,84 @@ public:
   float hdop;
   float vdop;
   float pdop;
-  float course;	/* Optional: degrees true */
-  float speed;   	/* Optional: meters per second. */
-  fix_type fix;	/* Optional: 3d, 2d, etc. */
-  int  sat;	/* Optional: number of sats used for fix */
 
   unsigned char heartrate; /* Beats/min. likely to get moved to fs. */
   unsigned char cadence;	 /* revolutions per minute */
   float power; /* watts, as measured by cyclists */
   float temperature; /* Degrees celsius */
   float odometer_distance; /* Meters? */
-  geocache_data* gc_data;
+  geocache_data* gc_data;	/* see AllocGCData() */
   format_specific_data* fs;
-  session_t* session;	/* pointer to a session struct */
   void* extra_data;	/* Extra data added by, say, a filter. */
+};
+
+/* Where the flagged fields of WAYPT_SET() and WAYPT_GET() live. */
+#define WAYPT_RD_course(wpt) ((wpt)->course)
+#define WAYPT_WR_course(wpt) ((wpt)->course)
+#define WAYPT_RD_speed(wpt) ((wpt)->speed)
+#define WAYPT_WR_speed(wpt) ((wpt)->speed)
+#define WAYPT_RD_depth(wpt) ((wpt)->ext->depth)
+#define WAYPT_WR_depth(wpt) ((wpt)->AllocExt()->depth)
+#define WAYPT_RD_proximity(wpt) ((wpt)->ext->proximity)
+#define WAYPT_WR_proximity(wpt) ((wpt)->AllocExt()->proximity)
+#define WAYPT_RD_temperature(wpt) ((wpt)->ext->temperature)
+#define WAYPT_WR_temperature(wpt) ((wpt)->AllocExt()->temperature)
+#define WAYPT_RD_geoidheight(wpt) ((wpt)->ext->geoidheight)
+#define WAYPT_WR_geoidheight(wpt) ((wpt)->AllocExt()->geoidheight)
+
+/*
+ * This is a waypoint, as stored in the GPSR.   It tries to not
+ * cater to any specific model or protocol.  Anything that needs to
+ * be truncated, edited, or otherwise trimmed should be done on the
+ * way to the target.
+ *
+ * On LP64 this is 104 bytes (it was 200 before waypt_ext): the queue
+ * links (16), position (24), names (16), time (8), flags, course,
+ * speed, fix and sat (20, plus 4 of padding), session (8) and ext (8).
+ * Those stay here because nearly every point has them: the constructor
+ * sets session, and the receiver log formats (NMEA, GPX tracks, the
+ * Garmin protocols) set course, speed, fix and sat on most track points,
+ * so moving them into waypt_ext would give each such point a block of
+ * its own and cost more than it saves.
+ */
+class Waypoint
+{
+private:
+  static waypt_ext empty_ext;
+
+public:
+  queue Q;			/* Master waypoint q.  Not for use
+					   by modules. */
+
+  double latitude;		/* Degrees */
+  double longitude; 		/* Degrees */
+  double altitude; 		/* Meters. */
+
+  /* shortname is a waypoint name as stored in receiver.  It should
+   * strive to be, well, short, and unique.   Enforcing length and
+   * character restrictions is the job of the output.   A typical
+   * minimum length for shortname is 6 characters for NMEA units,
+   * 8 for Magellan and 10 for Vista.   These are only guidelines.
+   */
+  QString shortname;
+  /*
+   * description is typically a human readable description of the
+   * waypoint.   It may be used as a comment field in some receivers.
+   * These are probably under 40 bytes, but that's only a guideline.
+   */
+  QString description;
+
+  wp_flags wpt_flags;
+
+  gpsbabel::DateTime creation_time;
+
+  float course;	/* Optional: degrees true */
+  float speed;   	/* Optional: meters per second. */
+  fix_type fix;	/* Optional: 3d, 2d, etc. */
+  int  sat;	/* Optional: number of sats used for fix */
+
+  session_t* session;	/* pointer to a session struct */
+  const waypt_ext* ext;	/* everything else; see waypt_ext */
 
 private:
   Waypoint& operator=(const Waypoint& other);
@@ -554,8 +679,12 @@ public:
   void SetCreationTime(time_t t, int ms);
   geocache_data* AllocGCData();
   int EmptyGCData() const;
+  bool HasExt() const;
+  waypt_ext* AllocExt();
 };
 
+struct route_cache;
+
 class route_head
 {
 public:
@@ -571,6 +700,7 @@ public:
   gb_color line_color;         /* Optional line color for rendering */
   int line_width;         /* in pixels (sigh).  < 0 is unknown. */
   session_t* session;	/* pointer to a session struct */
+  route_cache* cache;	/* memoized bounds and track stats, see route.cc */
 
 public:
   route_head();
@@ -648,6 +778,7 @@ void waypt_init_bounds(bounds* bounds);
 int waypt_bounds_valid(bounds* bounds);
 void waypt_add_to_bounds(bounds* bounds, const Waypoint* waypointp);
 void waypt_compute_bounds(bounds*);
+void waypt_merge_bounds(bounds* bds, const bounds* other);
 double gcgeodist(const double lat1, const double lon1,
                  const double lat2, const double lon2);
 void waypt_flush(queue*);
@@ -659,8 +790,9 @@ void waypt_add_url(Waypoint* wpt, const QString& link,
 void waypt_add_url(Waypoint* wpt, const QString& link,
                    const QString& url_link_text,
                    const QString& url_link_type);
-void xcsv_setup_internal_style(const char* style_buf);
-void xcsv_read_internal_style(const char* style_buf);
+void xcsv_setup_internal_style(const struct xcsv_style* style);
+const struct xcsv_style* xcsv_get_internal_style(void);
+void xcsv_read_internal_style(const struct xcsv_style* style);
 Waypoint* find_waypt_by_name(const QString& name);
 void waypt_backup(signed int* count, queue** head_bak);
 void waypt_restore(signed int count, queue* head_bak);
@@ -688,6 +820,16 @@ void track_insert_head(route_head* rte, route_head* predecessor);
 void route_disp(const route_head* rte, waypt_cb);
 void route_disp_all(route_hdr, route_trl, waypt_cb);
 void track_disp_all(route_hdr, route_trl, waypt_cb);
+/*
+ * Per-route work spread over threads; see route_parallel() in route.cc.
+ * index is the route's position in the list (or array) being walked.
+ */
+typedef void (*route_work)(route_head* rte, int index);
+int route_threads(void);
+void route_parallel(route_head* const* rtes, int n, route_work work, route_work finish);
+void route_q_parallel(queue* qh, route_work work, route_work finish);
+void route_disp_all_parallel(route_work work, route_work finish);
+void track_disp_all_parallel(route_work work, route_work finish);
 void route_disp_session(const session_t* se, route_hdr rh, route_trl rt, waypt_cb wc);
 void track_disp_session(const session_t* se, route_hdr rh, route_trl rt, waypt_cb wc);
 void route_flush(queue*);
@@ -709,6 +851,105 @@ void track_restore(queue* head_bak);
 void track_append(queue* src);
 void route_flush(queue* head);
 void track_recompute(const route_head* trk, computed_trkdata**);
+void route_compute_bounds(const route_head* rte, bounds* bounds);
+void route_add_all_to_bounds(bounds* bounds);
+void track_add_all_to_bounds(bounds* bounds);
+
+/*
+ * A route or track copied into contiguous arrays for the kernels in
+ * grtcirc.h.  lat and lon are in radians, alt in meters, and time in
+ * milliseconds since the epoch (NaN where the point has no valid time).
+ * wpt[i] is the point each element came from.
+ */
+class track_arrays
+{
+public:
+  QVector<Waypoint*> wpt;
+  QVector<double> lat;
+  QVector<double> lon;
+  QVector<double> alt;
+  QVector<double> time;
+
+  explicit track_arrays(const route_head* trk);
+  track_arrays(Waypoint* const* pts, int n);
+  int size() const {
+    return wpt.size();
+  }
+
+private:
+  void add(Waypoint* w);
+};
+
+/*
+ * The timestamped points of a route or track sorted by time, equal
+ * times in route order, for binary searches by time.  Times are
+ * milliseconds since the epoch; points without a valid time are left
+ * out.  route_time_index() builds one on first use and keeps it with
+ * the route until the route changes.
+ */
+class time_index
+{
+public:
+  QVector<qint64> time;
+  QVector<const Waypoint*> wpt;
+
+  explicit time_index(const route_head* rte);
+  time_index(Waypoint* const* pts, int n);
+  int size() const {
+    return time.size();
+  }
+  int lower_bound(qint64 t) const;	/* first point at or after t */
+  int upper_bound(qint64 t) const;	/* first point after t */
+  int nearest(qint64 t) const;		/* -1 if empty; ties go to the earlier point */
+
+private:
+  void add(const Waypoint* w);
+  void sort();
+};
+
+const time_index* route_time_index(const route_head* rte);
+
+/*
+ * An interval tree over the time spans of many time indexes, so the
+ * routes covering a time or a window are found without looking at the
+ * others.  Entries are numbered in the order they were added and lower
+ * numbers win ties.  Call build() after the last add().
+ */
+class time_tree
+{
+public:
+  void add(const route_head* rte);
+  void add(const time_index* idx, const route_head* owner);
+  void build();
+  int size() const {
+    return entries.size();
+  }
+  const time_index* index(int i) const {
+    return entries[i].idx;
+  }
+  const route_head* owner(int i) const {
+    return entries[i].owner;
+  }
+  /* entries with a point in [lo, hi], in entry order */
+  void overlapping(qint64 lo, qint64 hi, QVector<int>& found) const;
+  /* the point closest to t; false if there are no points at all */
+  bool nearest(qint64 t, int* entry, int* point) const;
+
+private:
+  struct span {
+    const time_index* idx;
+    const route_head* owner;
+    qint64 start;
+    qint64 end;
+  };
+  QVector<span> entries;
+  QVector<int> by_start;	/* non-empty entries by start, then number */
+  QVector<int> by_end;		/* the same by end, then number */
+  QVector<qint64> max_end;	/* latest end in the subtree rooted at by_start[i] */
+
+  qint64 build_node(int lo, int hi);
+  void find(int lo, int hi, qint64 tlo, qint64 thi, QVector<int>& found) const;
+};
 
 /*
  * All shortname functions take a shortname handle as the first arg.
@@ -861,9 +1102,10 @@ typedef struct ff_vecs {
   const char* name;		/* dyn. initialized by find_vec */
 } ff_vecs_t;
 
+struct xcsv_style;
 typedef struct style_vecs {
   const char* name;
-  const char* style_buf;
+  const struct xcsv_style* style;
 } style_vecs_t;
 extern style_vecs_t style_list[];
 
@@ -883,7 +1125,27 @@ void is_fatal(const int condition, const char*, ...) PRINTFLIKE(2, 3);
 void warning(const char*, ...) PRINTFLIKE(1, 2);
 void debug_print(int level, const char* fmt, ...) PRINTFLIKE(2,3);
 
+/*
+ * Work done on another thread must not end the program half way.  A
+ * thread that sets a trap collects the messages of its fatal() and
+ * warning() calls there, and fatal() throws fatal_trapped instead of
+ * exiting.  fatal_trap_set(NULL) clears the trap again.
+ */
+struct fatal_trapped {};
+void fatal_trap_set(QByteArray* messages);
+
+/*
+ * Programs that embed GPSBabel (see libgpsbabel.cc) can take the
+ * messages of fatal() and warning() instead of stderr.  The handler
+ * must not return for a fatal message, or fatal() exits as usual.
+ */
+typedef void (*message_handler_t)(int is_fatal, const char* msg);
+message_handler_t set_message_handler(message_handler_t handler);
+
 ff_vecs_t* find_vec(const char*, const char**);
+typedef struct vec_options vec_options_t;
+vec_options_t* vec_options_save(const char* vecname);
+void vec_options_restore(vec_options_t* saved);
 void assign_option(const char* vecname, arglist_t* ap, const char* val);
 void disp_vec_options(const char* vecname, arglist_t* ap);
 void disp_vecs(void);
@@ -982,6 +1244,8 @@ char* strip_nastyhtml(const QString& in);
 char* convert_human_date_format(const char* human_datef);	/* "MM,YYYY,DD" -> "%m,%Y,%d" */
 char* convert_human_time_format(const char* human_timef);	/* "HH+mm+ss"   -> "%H+%M+%S" */
 char* pretty_deg_format(double lat, double lon, char fmt, const char* sep, int html);    /* decimal ->  dd.dddd or dd mm.mmm or dd mm ss */
+int fixed_dtoa(char* buf, double d, int prec);			/* printf("%.*f") fast path, -1 if not handled */
+QString fixed_to_string(double d, int prec);			/* QString::number(d, 'f', prec) */
 
 const char* get_filename(const char* fname);			/* extract the filename portion */
 
@@ -1004,9 +1268,15 @@ const char* get_filename(const char* fname);			/* extract the filename portion *
 
 /* this lives in gpx.c */
 gpsbabel::DateTime xml_parse_time(const QString& cdatastr);
+gpsbabel::DateTime xml_parse_time(const QStringRef& cdatastr);
 
 QString rot13(const QString& str);
 
+/* Shared copies of repeated per-point strings; see util.cc. */
+QString intern(const QString& s);
+void intern_stats();
+void intern_flush();
+
 /*
  * PalmOS records like fixed-point numbers, which should be rounded
  * to deal with possible floating-point representation errors.
@@ -1006,7 +1006,7 @@ decode_waypoint(const void* data)
   if (f > UNKNOWN_ELEV) {
     wp->altitude = f;
   }
-  wp->icon_descr = waypoint_symbol(p->symbol);
+  wp->AllocExt()->icon_descr = waypoint_symbol(p->symbol);
 //  if (!wp->icon_descr.isNull()) {
 //    wp->icon_descr = wp->icon_descr;
 //  }
@@ -1015,7 +1015,7 @@ decode_waypoint(const void* data)
   }
   s = p->name + p->name_size;
   if (le_readu16(s) &&  s[2]) {
-    wp->notes = xstrdup(s + 2);
+    wp->AllocExt()->notes = xstrdup(s + 2);
   }
   return wp;
 }
@@ -1104,7 +1104,7 @@ read_waypoints(void)
         do {
           notes_max += notes_max;
         } while (notes_max < notes_i + nn);
-        wp->notes = (char*) xmalloc(notes_max);
+        wp->AllocExt()->notes = (char*) xmalloc(notes_max);
 #if NEW_STRINGS
 #else
         if (old) {
@@ -1116,12 +1116,12 @@ read_waypoints(void)
       if (nn) {
 #if NEW_STRINGS
         // Is this really what this code was trying to do?
-        wp->notes += QString::fromUtf8(s + 2, nn);
+        wp->AllocExt()->notes += QString::fromUtf8(s + 2, nn);
 #else
         memcpy(wp->notes + notes_i, s + 2, nn);
 #endif
         notes_i += nn;
-        if (wp->notes[notes_i - 1] == 0) {
+        if (wp->ext->notes[notes_i - 1] == 0) {
           notes_i--;
         }
       }
@@ -1157,7 +1157,7 @@ get_gc_notes(const Waypoint* wp, int* symbol, char** notes, unsigned* notes_size
   const char* size = NULL;
   int gc_sym = 0;
 
-  switch (wp->gc_data->type) {
+  switch (wp->ext->gc_data->type) {
   case gt_traditional:
     gc_sym = 160;
     break;
@@ -1199,13 +1199,13 @@ get_gc_notes(const Waypoint* wp, int* symbol, char** notes, unsigned* notes_size
   case gt_ape:
     break;
   }
-  if (0 == (wp->icon_descr.compare("Geocache Found"))) {
+  if (0 == (wp->ext->icon_descr.compare("Geocache Found"))) {
     gc_sym = 124;
   }
   if (!wp->description.isEmpty()) {
     gbfputs(wp->description, fd);
-    if (!wp->gc_data->placer.isEmpty()) {
-      gbfprintf(fd, " by %s", CSTR(wp->gc_data->placer));
+    if (!wp->ext->gc_data->placer.isEmpty()) {
+      gbfprintf(fd, " by %s", CSTR(wp->ext->gc_data->placer));
     }
     gbfputc('\n', fd);
   }
@@ -1214,10 +1214,10 @@ get_gc_notes(const Waypoint* wp, int* symbol, char** notes, unsigned* notes_size
   if (gc_sym && opt_gcsym && atoi(opt_gcsym)) {
     gbfprintf(fd, "%s\n", waypoint_symbol(gc_sym));
     *symbol = gc_sym;
-  } else if (!wp->icon_descr.isNull()) {
-    gbfprintf(fd, "%s\n", CSTR(wp->icon_descr));
+  } else if (!wp->ext->icon_descr.isNull()) {
+    gbfprintf(fd, "%s\n", CSTR(wp->ext->icon_descr));
   }
-  switch (wp->gc_data->container) {
+  switch (wp->ext->gc_data->container) {
   case gc_micro:
     size = "Micro";
     break;
@@ -1246,37 +1246,37 @@ get_gc_notes(const Waypoint* wp, int* symbol, char** notes, unsigned* notes_size
   if (size) {
     gbfprintf(fd, "SIZE: %s\n", size);
   }
-  if (wp->gc_data->diff % 10) {
-    gbfprintf(fd, "D%.1f", wp->gc_data->diff / 10.0);
+  if (wp->ext->gc_data->diff % 10) {
+    gbfprintf(fd, "D%.1f", wp->ext->gc_data->diff / 10.0);
   } else {
-    gbfprintf(fd, "D%u", wp->gc_data->diff / 10);
+    gbfprintf(fd, "D%u", wp->ext->gc_data->diff / 10);
   }
-  if (wp->gc_data->terr % 10) {
-    gbfprintf(fd, "/T%.1f\n", wp->gc_data->terr / 10.0);
+  if (wp->ext->gc_data->terr % 10) {
+    gbfprintf(fd, "/T%.1f\n", wp->ext->gc_data->terr / 10.0);
   } else {
-    gbfprintf(fd, "/T%u\n", wp->gc_data->terr / 10);
+    gbfprintf(fd, "/T%u\n", wp->ext->gc_data->terr / 10);
   }
-  if (!wp->gc_data->hint.isEmpty() && !opt_hint_at_end) {
-    gbfprintf(fd, "HINT: %s\n", CSTR(wp->gc_data->hint));
+  if (!wp->ext->gc_data->hint.isEmpty() && !opt_hint_at_end) {
+    gbfprintf(fd, "HINT: %s\n", CSTR(wp->ext->gc_data->hint));
   }
-  if (!wp->gc_data->desc_short.utfstring.isEmpty() || !wp->gc_data->desc_long.utfstring.isEmpty()) {
+  if (!wp->ext->gc_data->desc_short.utfstring.isEmpty() || !wp->ext->gc_data->desc_long.utfstring.isEmpty()) {
     gbfputs("DESC: ", fd);
-    if (!wp->gc_data->desc_short.utfstring.isEmpty()) {
-      char* s1 = strip_html(&wp->gc_data->desc_short);
+    if (!wp->ext->gc_data->desc_short.utfstring.isEmpty()) {
+      char* s1 = strip_html(&wp->ext->gc_data->desc_short);
       char* s2 = cet_str_utf8_to_any(s1, global_opts.charset);
       gbfprintf(fd, "%s\n", s2);
       xfree(s2);
       xfree(s1);
     }
-    if (!wp->gc_data->desc_long.utfstring.isEmpty()) {
-      char* s1 = strip_html(&wp->gc_data->desc_long);
+    if (!wp->ext->gc_data->desc_long.utfstring.isEmpty()) {
+      char* s1 = strip_html(&wp->ext->gc_data->desc_long);
       char* s2 = cet_str_utf8_to_any(s1, global_opts.charset);
       gbfputs(s2, fd);
       xfree(s2);
       xfree(s1);
     }
   }
-  fs_gpx = (fs_xml*)fs_chain_find(wp->fs, FS_GPX);
+  fs_gpx = (fs_xml*)fs_chain_find(wp->ext->fs, FS_GPX);
   if (opt_logs && fs_gpx && fs_gpx->tag) {
     root = xml_findfirst(fs_gpx->tag, "groundspeak:logs");
   }
@@ -1311,8 +1311,8 @@ get_gc_notes(const Waypoint* wp, int* symbol, char** notes, unsigned* notes_size
       gbfputc('\n', fd);
     }
   }
-  if (!wp->gc_data->hint.isEmpty() && opt_hint_at_end) {
-    gbfprintf(fd, "\nHINT: %s\n", CSTR(wp->gc_data->hint));
+  if (!wp->ext->gc_data->hint.isEmpty() && opt_hint_at_end) {
+    gbfprintf(fd, "\nHINT: %s\n", CSTR(wp->ext->gc_data->hint));
   }
   gbfputc(0, fd);
   *notes_size = fd->memlen;
@@ -1393,7 +1393,7 @@ write_waypoint(const Waypoint* wp)
   char* pp;
 
   if (wp->EmptyGCData()) {
-    notes = xstrdup(wp->notes);
+    notes = xstrdup(wp->ext->notes);
     if (notes == NULL && wp->description.isEmpty() && wp->shortname != wp->description) {
       notes = xstrdup(wp->description);
     }
@@ -1436,8 +1436,8 @@ write_waypoint(const Waypoint* wp)
   le_write_float(p->elevation, elev);
   if (symbol < 0) {
     symbol = 0;
-    if (!wp->icon_descr.isNull()) {
-      symbol = waypoint_symbol_index(CSTR(wp->icon_descr));
+    if (!wp->ext->icon_descr.isNull()) {
+      symbol = waypoint_symbol_index(CSTR(wp->ext->icon_descr));
     }
   }
   p->symbol = symbol;
@@ -1864,7 +1864,7 @@ decode_route_point(const void* data)
     wp->shortname = p->name;
   }
   // give these a higher priority than the shape points
-  wp->route_priority = 1;
+  wp->AllocExt()->route_priority = 1;
   wp->latitude = delbin_rad2deg(le_read32(p->latitude));
   wp->longitude = delbin_rad2deg(le_read32(p->longitude));
   switch (p->itinerary_type) {
@@ -1929,7 +1929,7 @@ decode_route_point(const void* data)
     gbfputc(0, fd);
 #if NEW_STRINGS
     // Reconsider if there's a less grubby way to do this.
-    wp->notes = QString::fromUtf8((const char*) fd->handle.mem, fd->memlen);
+    wp->AllocExt()->notes = QString::fromUtf8((const char*) fd->handle.mem, fd->memlen);
 #else
     wp->notes = (char*) xmalloc(fd->memlen);
     memcpy(wp->notes, fd->handle.mem, fd->memlen);
@@ -2270,12 +2270,12 @@ read_position(void)
   if (wp->fix > fix_none &&
       message_read_1(MSG_SATELLITE_INFO, &m) == MSG_SATELLITE_INFO) {
     const msg_satellite_t* p = (const msg_satellite_t*) m.data;
-    wp->hdop = le_readu16(p->hdop);
-    wp->hdop /= 100;
-    wp->vdop = le_readu16(p->vdop);
-    wp->vdop /= 100;
-    wp->pdop = le_readu16(p->pdop);
-    wp->pdop /= 100;
+    wp->AllocExt()->hdop = le_readu16(p->hdop);
+    wp->AllocExt()->hdop /= 100;
+    wp->AllocExt()->vdop = le_readu16(p->vdop);
+    wp->AllocExt()->vdop /= 100;
+    wp->AllocExt()->pdop = le_readu16(p->pdop);
+    wp->AllocExt()->pdop /= 100;
   }
   message_free(&m);
   return wp;
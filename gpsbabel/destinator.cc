@@ -55,7 +55,7 @@ gmsd_init(Waypoint* wpt)
   garmin_fs_t* gmsd = GMSD_FIND(wpt);
   if (gmsd == NULL) {
     gmsd = garmin_fs_alloc(-1);
-    fs_chain_add(&wpt->fs, (format_specific_data*) gmsd);
+    fs_chain_add(&wpt->AllocExt()->fs, (format_specific_data*) gmsd);
   }
   return gmsd;
 }
@@ -175,7 +175,7 @@ destinator_read_poi(void)
     wpt = new Waypoint;
 
     wpt->shortname = read_wcstr(0);
-    wpt->notes = read_wcstr(0);		/* comment */
+    wpt->AllocExt()->notes = read_wcstr(0);		/* comment */
 
     hnum = read_wcstr(0);			/* house number */
 
@@ -250,7 +250,7 @@ destinator_read_rte(void)
     wpt = new Waypoint;
 
     wpt->shortname = read_wcstr(0);
-    wpt->notes = read_wcstr(0);
+    wpt->AllocExt()->notes = read_wcstr(0);
 
     (void) gbfgetint32(fin);
     (void) gbfgetdbl(fin);
@@ -392,7 +392,7 @@ destinator_wpt_disp(const Waypoint* wpt)
 
   write_wcstr(DST_DYN_POI);
   write_wcstr((!wpt->shortname.isEmpty()) ? wpt->shortname : "WPT");
-  write_wcstr((!wpt->notes.isEmpty()) ? wpt->notes : wpt->description);
+  write_wcstr((!wpt->ext->notes.isEmpty()) ? wpt->ext->notes : wpt->description);
 
   write_wcstr(NULL);				/* house number */
   write_wcstr(GMSD_GET(addr, NULL));		/* street */
@@ -464,7 +464,7 @@ destinator_rtept_disp(const Waypoint* wpt)
 {
   write_wcstr(DST_ITINERARY);
   write_wcstr((!wpt->shortname.isEmpty()) ? wpt->shortname : "RTEPT");
-  write_wcstr((!wpt->notes.isEmpty()) ? wpt->notes : wpt->description);
+  write_wcstr((!wpt->ext->notes.isEmpty()) ? wpt->ext->notes : wpt->description);
 
   gbfputint32(0, fout);
   gbfputdbl(0, fout);
@@ -34,21 +34,27 @@ static char* fixunknownopt = NULL;
 static char* eleminopt = NULL;
 static char* elemaxopt = NULL;
 static char* nameopt = NULL;
-static QRegExp name_regex;
 static char* descopt = NULL;
-static QRegExp desc_regex;
 static char* cmtopt = NULL;
-static QRegExp cmt_regex;
 static char* iconopt = NULL;
-static QRegExp icon_regex;
+
+/*
+ * A QRegExp keeps its match state, so each thread working on
+ * routes and tracks matches with a copy of these.
+ */
+typedef struct {
+  QRegExp name;
+  QRegExp desc;
+  QRegExp cmt;
+  QRegExp icon;
+} fix_regex_t;
+static fix_regex_t fix_regex;
 
 static double hdopf;
 static double vdopf;
 static int satpf;
 static int eleminpf;
 static int elemaxpf;
-static gpsdata_type what;
-static route_head* head;
 
 static
 arglist_t fix_args[] = {
@@ -110,19 +116,17 @@ arglist_t fix_args[] = {
 /*
  * Decide whether to keep or toss this point.
  */
-static void
-fix_process_wpt(const Waypoint* wpt)
+static int
+fix_discard(const Waypoint* waypointp, fix_regex_t& re)
 {
   int del = 0;
   int delh = 0;
   int delv = 0;
 
-  Waypoint* waypointp = (Waypoint*) wpt;
-
-  if ((hdopf >= 0.0) && (waypointp->hdop > hdopf)) {
+  if ((hdopf >= 0.0) && (waypointp->ext->hdop > hdopf)) {
     delh = 1;
   }
-  if ((vdopf >= 0.0) && (waypointp->vdop > vdopf)) {
+  if ((vdopf >= 0.0) && (waypointp->ext->vdop > vdopf)) {
     delv = 1;
   }
 
@@ -152,57 +156,72 @@ fix_process_wpt(const Waypoint* wpt)
     del = 1;
   }
 
-  if (nameopt && name_regex.indexIn(waypointp->shortname) >= 0) {
+  if (nameopt && re.name.indexIn(waypointp->shortname) >= 0) {
     del = 1;
   }
-  if (descopt && desc_regex.indexIn(waypointp->description) >= 0) {
+  if (descopt && re.desc.indexIn(waypointp->description) >= 0) {
     del = 1;
   }
-  if (cmtopt && cmt_regex.indexIn(waypointp->notes) >= 0) {
+  if (cmtopt && re.cmt.indexIn(waypointp->ext->notes) >= 0) {
     del = 1;
   }
-  if (iconopt && icon_regex.indexIn(waypointp->icon_descr) >= 0) {
+  if (iconopt && re.icon.indexIn(waypointp->ext->icon_descr) >= 0) {
     del = 1;
   }
 
-  if (del) {
-    switch (what) {
-    case wptdata:
-      waypt_del(waypointp);
-      break;
-    case trkdata:
-      track_del_wpt(head, waypointp);
-      break;
-    case rtedata:
-      route_del_wpt(head, waypointp);
-      break;
-    default:
-      return;
+  return del;
+}
+
+static void
+fix_process_wpt(const Waypoint* wpt)
+{
+  if (fix_discard(wpt, fix_regex)) {
+    waypt_del((Waypoint*) wpt);
+    delete wpt;
+  }
+}
+
+static void
+fix_process_trk(route_head* trk, int)
+{
+  fix_regex_t re = fix_regex;
+  queue* elem, *tmp;
+
+  QUEUE_FOR_EACH(&trk->waypoint_list, elem, tmp) {
+    Waypoint* wpt = (Waypoint*) elem;
+    if (fix_discard(wpt, re)) {
+      track_del_wpt(trk, wpt);
+      delete wpt;
     }
-    delete waypointp;
   }
 }
 
 static void
-fix_process_head(const route_head* trk)
+fix_process_rte(route_head* rte, int)
 {
-  head = (route_head*)trk;
+  fix_regex_t re = fix_regex;
+  queue* elem, *tmp;
+
+  QUEUE_FOR_EACH(&rte->waypoint_list, elem, tmp) {
+    Waypoint* wpt = (Waypoint*) elem;
+    if (fix_discard(wpt, re)) {
+      route_del_wpt(rte, wpt);
+      delete wpt;
+    }
+  }
 }
 
 static void
 fix_process(void)
 {
   // Filter waypoints.
-  what = wptdata;
   waypt_disp_all(fix_process_wpt);
 
   // Filter tracks
-  what = trkdata;
-  track_disp_all(fix_process_head, NULL, fix_process_wpt);
+  track_disp_all_parallel(fix_process_trk, NULL);
 
   // And routes
-  what = rtedata;
-  route_disp_all(fix_process_head, NULL, fix_process_wpt);
+  route_disp_all_parallel(fix_process_rte, NULL);
 
 }
 
@@ -236,24 +255,24 @@ fix_init(const char* args)
   }
 
   if (nameopt) {
-    name_regex.setCaseSensitivity(Qt::CaseInsensitive);
-    name_regex.setPatternSyntax(QRegExp::WildcardUnix);
-    name_regex.setPattern(nameopt);
+    fix_regex.name.setCaseSensitivity(Qt::CaseInsensitive);
+    fix_regex.name.setPatternSyntax(QRegExp::WildcardUnix);
+    fix_regex.name.setPattern(nameopt);
   }
   if (descopt) {
-    desc_regex.setCaseSensitivity(Qt::CaseInsensitive);
-    desc_regex.setPatternSyntax(QRegExp::WildcardUnix);
-    desc_regex.setPattern(descopt);
+    fix_regex.desc.setCaseSensitivity(Qt::CaseInsensitive);
+    fix_regex.desc.setPatternSyntax(QRegExp::WildcardUnix);
+    fix_regex.desc.setPattern(descopt);
   }
   if (cmtopt) {
-    cmt_regex.setCaseSensitivity(Qt::CaseInsensitive);
-    cmt_regex.setPatternSyntax(QRegExp::WildcardUnix);
-    cmt_regex.setPattern(cmtopt);
+    fix_regex.cmt.setCaseSensitivity(Qt::CaseInsensitive);
+    fix_regex.cmt.setPatternSyntax(QRegExp::WildcardUnix);
+    fix_regex.cmt.setPattern(cmtopt);
   }
   if (iconopt) {
-    icon_regex.setCaseSensitivity(Qt::CaseInsensitive);
-    icon_regex.setPatternSyntax(QRegExp::WildcardUnix);
-    icon_regex.setPattern(iconopt);
+    fix_regex.icon.setCaseSensitivity(Qt::CaseInsensitive);
+    fix_regex.icon.setPatternSyntax(QRegExp::WildcardUnix);
+    fix_regex.icon.setPattern(iconopt);
   }
 }
 
@@ -526,7 +526,7 @@ read_CTrackFile(const int version)
 
       gbfseek(fin, 36, SEEK_CUR);	/* skip unknown 36 bytes */
 
-      wpt->notes = read_str(fin);
+      wpt->AllocExt()->notes = read_str(fin);
       wpt->description = read_str(fin);
       (void) gbfgetint16(fin);
 
@@ -96,7 +96,7 @@ data_read(void)
         wpt_tmp->description = gbfgetpstr(file_in);
         break;
       case 5:
-        wpt_tmp->notes = gbfgetpstr(file_in);
+        wpt_tmp->AllocExt()->notes = gbfgetpstr(file_in);
         break;
       case 6: {
         QString ult = gbfgetpstr(file_in);
@@ -105,11 +105,11 @@ data_read(void)
       break;
       case 7: {
         QString id = gbfgetpstr(file_in);
-        wpt_tmp->icon_descr = id;
+        wpt_tmp->AllocExt()->icon_descr = id;
       }
       break;
       case 8:  /* NULL Terminated (vs. pascal) descr */
-        wpt_tmp->notes = gbfgetcstr(file_in);
+        wpt_tmp->AllocExt()->notes = gbfgetcstr(file_in);
         break;
       case 9: { /* NULL Terminated (vs. pascal) link */
         QString url = gbfgetcstr(file_in);
@@ -164,18 +164,18 @@ ez_disp(const Waypoint* wpt)
     gbfputc(3, file_out);
     gbfputpstr(wpt->description, file_out);
   }
-  if (!wpt->icon_descr.isNull()) {
+  if (!wpt->ext->icon_descr.isNull()) {
     gbfputc(7, file_out);
-    gbfputpstr(wpt->icon_descr, file_out);
+    gbfputpstr(wpt->ext->icon_descr, file_out);
   }
   gbfputc(0x63, file_out);
   gbfputdbl(wpt->latitude, file_out);
 
   gbfputc(0x64, file_out);
   gbfputdbl(wpt->longitude, file_out);
-  if (!wpt->notes.isEmpty()) {
+  if (!wpt->ext->notes.isEmpty()) {
     gbfputc(5, file_out);
-    gbfputpstr(wpt->notes, file_out);
+    gbfputpstr(wpt->ext->notes, file_out);
   }
   if (wpt->HasUrlLink()) {
     UrlLink link = wpt->GetUrlLink();
@@ -172,13 +172,13 @@ read_point(route_head* gpsbabel_route,gpsbabel::DateTime& gpsDateTime)
     WAYPT_SET(waypt, speed, point.Speed_Speed / 100.0f);
   }
   if (point.HR_Status == 0) {
-    waypt->heartrate = point.HR_Heartrate;
+    waypt->AllocExt()->heartrate = point.HR_Heartrate;
   }
   if (point.Cadence_Status == 0) {
-    waypt->cadence = point.Cadence_Cadence;
+    waypt->AllocExt()->cadence = point.Cadence_Cadence;
   }
   if (point.Power_Status == 0) {
-    waypt->power = point.Power_Power;
+    waypt->AllocExt()->power = point.Power_Power;
   }
   WAYPT_SET(waypt, temperature, point.Temp);
   track_add_wpt(gpsbabel_route, waypt);
@@ -35,8 +35,16 @@
 
 #include "defs.h"
 #include "garmin_tables.h"
+#include "grtcirc.h"
 #include "jeeps/gpsmath.h"
 
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+
 #define MYNAME "exif"
 
 // #define EXIF_DBG
@@ -131,15 +139,42 @@ typedef struct exif_app_s {
   queue ifds;
 } exif_app_t;
 
-static gbfile* fin, *fout;
+/*
+ * The point found for an image's time.  "owner" is the route or track
+ * the point belongs to (NULL for waypoints).
+ */
+typedef struct exif_time_entry_s {
+  qint64 time;			/* milliseconds since the epoch */
+  const Waypoint* wpt;
+  const route_head* owner;
+} exif_time_entry_t;
+
+/*
+ * One image to be tagged by the writer.
+ */
+typedef struct exif_image_s {
+  QString fname;
+  int batch;
+  /* What tagging it opened, so a failure part way can be cleaned up. */
+  gbfile* fimg;
+  gbfile* fout;
+  queue apps;
+  /* What tagging it said in a batch, reported in order when all are done. */
+  QByteArray messages;
+  int failed;
+} exif_image_t;
+
+static gbfile* fin;
 static queue exif_apps;
 static exif_app_t* exif_app;
-const Waypoint* exif_wpt_ref;
-time_t exif_time_ref;
-static char exif_success;
-static char* exif_fout_name;
+static QString exif_fout_name;
+static QList<exif_image_t> exif_images;
+static time_tree exif_time_tree;
+static time_index* exif_wpt_times;
+static QVector<Waypoint*> exif_wpts;
 
 static char* opt_filename, *opt_overwrite, *opt_frame, *opt_name;
+static char* opt_interpolate, *opt_threads;
 
 static uint8_t writer_gps_tag_version[4] = {2, 0, 0, 0};
 
@@ -148,6 +183,8 @@ arglist_t exif_args[] = {
   { "frame", &opt_frame, "Time-frame (in seconds)", "10", ARGTYPE_INT, "0", NULL },
   { "name", &opt_name, "Locate waypoint for tagging by this name", NULL, ARGTYPE_STRING, ARG_NOMINMAX },
   { "overwrite", &opt_overwrite, "!OVERWRITE! the original file. Default=N", "N", ARGTYPE_BOOL, ARG_NOMINMAX },
+  { "interpolate", &opt_interpolate, "Interpolate position between neighbouring track points", "N", ARGTYPE_BOOL, ARG_NOMINMAX },
+  { "threads", &opt_threads, "Number of worker threads for batch tagging (overrides -j)", NULL, ARGTYPE_INT, "0", NULL },
   ARG_TERMINATOR
 };
 
@@ -212,19 +249,10 @@ exif_type_size(const uint16_t type)
   return size;
 }
 
-// TODO: If this were actually ever used (!?!?!) it could probably be 
-// replaced by return QDateTime(time).toString("yyyy/MM/dd, hh:mm:ss);
 static QString
 exif_time_str(const time_t time)
 {
-  struct tm tm;
-
-  tm = *localtime(&time);
-  tm.tm_year += 1900;
-  tm.tm_mon += 1;
-
-  return QString().sprintf("%04d/%02d/%02d, %02d:%02d:%02d",
-         tm.tm_year, tm.tm_mon, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+  return QDateTime::fromTime_t(time).toString("yyyy/MM/dd, hh:mm:ss");
 }
 
 static char*
@@ -326,11 +354,11 @@ exif_release_ifd(exif_ifd_t* ifd)
 }
 
 static void
-exif_release_apps(void)
+exif_release_apps(queue* apps)
 {
   queue* e0, *t0;
 
-  QUEUE_FOR_EACH(&exif_apps, e0, t0) {
+  QUEUE_FOR_EACH(apps, e0, t0) {
     queue* e1, *t1;
     exif_app_t* app = (exif_app_t*)dequeue(e0);
 
@@ -370,14 +398,14 @@ exif_ifd_size(exif_ifd_t* ifd)
 }
 
 static exif_app_t*
-exif_load_apps(void)
+exif_load_apps(gbfile* fin, queue* apps)
 {
   exif_app_t* exif_app = NULL;
 
   while (! gbfeof(fin)) {
     exif_app_t* app = (exif_app_t*) xcalloc(sizeof(*app), 1);
 
-    ENQUEUE_TAIL(&exif_apps, &app->Q);
+    ENQUEUE_TAIL(apps, &app->Q);
     QUEUE_INIT(&app->ifds);
     app->fcache = gbfopen(NULL, "wb", MYNAME);
 
@@ -589,7 +617,7 @@ exif_examine_app(exif_app_t* app)
 {
   uint16_t endianess;
   uint32_t ident;
-  gbfile* ftmp = exif_app->fcache;
+  gbfile* ftmp = app->fcache;
 
   gbfrewind(ftmp);
   ident = gbfgetuint32(ftmp);
@@ -613,7 +641,7 @@ exif_examine_app(exif_app_t* app)
   app->fexif->big_endian = ftmp->big_endian;
   gbfcopyfrom(app->fexif, ftmp, 0x7FFFFFFF);
 
-  exif_read_app(exif_app);
+  exif_read_app(app);
 }
 
 static exif_ifd_t*
@@ -673,7 +701,7 @@ exif_get_exif_time(exif_app_t* app)
 }
 
 static Waypoint*
-exif_waypt_from_exif_app(exif_app_t* app)
+exif_waypt_from_exif_app(exif_app_t* app, const char* fname)
 {
   Waypoint* wpt;
   queue* elem, *tmp;
@@ -831,12 +859,12 @@ exif_waypt_from_exif_app(exif_app_t* app)
   if (mode == '2') {
     wpt->fix = fix_2d;
     if (gpsdop != unknown_alt) {
-      wpt->hdop = gpsdop;
+      wpt->AllocExt()->hdop = gpsdop;
     }
   } else if (mode == '3') {
     wpt->fix = fix_3d;
     if (gpsdop != unknown_alt) {
-      wpt->pdop = gpsdop;
+      wpt->AllocExt()->pdop = gpsdop;
     }
   }
 
@@ -863,20 +891,20 @@ exif_waypt_from_exif_app(exif_app_t* app)
   if (tag && (tag->size > 8)) {
     QString str;
     if (memcmp(tag->data, "ASCII\0\0\0", 8) == 0) {
-      wpt->notes = QString::fromLatin1((char*) tag->data + 8, tag->size - 8);
+      wpt->AllocExt()->notes = QString::fromLatin1((char*) tag->data + 8, tag->size - 8);
     } else if (memcmp(tag->data, "UNICODE\0", 8) == 0) {
       // I'm not at all sure that casting alignment away like this is a good
       // idea in light of arches that don't allow unaligned loads, but in the
       // absence of test data that captures it and the grubbiness of the code
       // that was here before, I'm going to do this and then come back to it
       // if it's a problem.
-      wpt->notes = QString::fromUtf16((const uint16_t*)((char*) tag->data + 8), tag->size - 8);
+      wpt->AllocExt()->notes = QString::fromUtf16((const uint16_t*)((char*) tag->data + 8), tag->size - 8);
     }
   }
 
   if (opt_filename) {
     char* c, *cx;
-    char* str = xstrdup(fin->name);
+    char* str = xstrdup(fname);
 
     cx = str;
     if ((c = strrchr(cx, ':'))) {
@@ -962,20 +990,20 @@ exif_dec2frac(double val, int32_t* num, int32_t* den)
 }
 
 static exif_tag_t*
-exif_put_value(const int ifd_nr, const uint16_t tag_id, const uint16_t type, const uint32_t count, const int index, const void* data)
+exif_put_value(exif_app_t* app, const int ifd_nr, const uint16_t tag_id, const uint16_t type, const uint32_t count, const int index, const void* data)
 {
   exif_tag_t* tag = NULL;
   exif_ifd_t* ifd;
   uint16_t item_size, size;
 
-  ifd = exif_find_ifd(exif_app, ifd_nr);
+  ifd = exif_find_ifd(app, ifd_nr);
   if (ifd == NULL) {
     ifd = (exif_ifd_t*) xcalloc(sizeof(*ifd), 1);
     ifd->nr = ifd_nr;
     QUEUE_INIT(&ifd->tags);
-    ENQUEUE_TAIL(&exif_app->ifds, &ifd->Q);
+    ENQUEUE_TAIL(&app->ifds, &ifd->Q);
   } else {
-    tag = exif_find_tag(exif_app, ifd_nr, tag_id);
+    tag = exif_find_tag(app, ifd_nr, tag_id);
   }
 
   item_size = exif_type_size(type);
@@ -1051,22 +1079,22 @@ exif_put_value(const int ifd_nr, const uint16_t tag_id, const uint16_t type, con
 
 
 static void
-exif_put_double(const int ifd_nr, const int tag_id, const int index, const double val)
+exif_put_double(exif_app_t* app, const int ifd_nr, const int tag_id, const int index, const double val)
 {
   double d = fabs(val);
-  exif_put_value(ifd_nr, tag_id, EXIF_TYPE_RAT, 1, index, &d);
+  exif_put_value(app, ifd_nr, tag_id, EXIF_TYPE_RAT, 1, index, &d);
 }
 
 
 static void
-exif_put_str(const int ifd_nr, const int tag_id, const char* val)
+exif_put_str(exif_app_t* app, const int ifd_nr, const int tag_id, const char* val)
 {
   int len = (val) ? strlen(val) + 1 : 0;
-  exif_put_value(ifd_nr, tag_id, EXIF_TYPE_ASCII, len, 0, val);
+  exif_put_value(app, ifd_nr, tag_id, EXIF_TYPE_ASCII, len, 0, val);
 }
 
 static void
-exif_put_coord(const int ifd_nr, const int tag_id, const double val)
+exif_put_coord(exif_app_t* app, const int ifd_nr, const int tag_id, const double val)
 {
   double  vmin, vsec;
   int     vint;
@@ -1076,44 +1104,139 @@ exif_put_coord(const int ifd_nr, const int tag_id, const double val)
   vsec = 60.0 * (vmin - floor(vmin));
   vmin = floor(vmin);
 
-  exif_put_double(ifd_nr, tag_id, 0, (double)vint);
-  exif_put_double(ifd_nr, tag_id, 1, (double)vmin);
-  exif_put_double(ifd_nr, tag_id, 2, (double)vsec);
+  exif_put_double(app, ifd_nr, tag_id, 0, (double)vint);
+  exif_put_double(app, ifd_nr, tag_id, 1, (double)vmin);
+  exif_put_double(app, ifd_nr, tag_id, 2, (double)vsec);
+}
+
+static void
+exif_put_long(exif_app_t* app, const int ifd_nr, const int tag_id, const int index, const int32_t val)
+{
+  exif_put_value(app, ifd_nr, tag_id, EXIF_TYPE_LONG, 1, index, &val);
 }
 
 static void
-exif_put_long(const int ifd_nr, const int tag_id, const int index, const int32_t val)
+exif_remove_tag(exif_app_t* app, const int ifd_nr, const int tag_id)
 {
-  exif_put_value(ifd_nr, tag_id, EXIF_TYPE_LONG, 1, index, &val);
+  exif_put_value(app, ifd_nr, tag_id, EXIF_TYPE_BYTE, 0, 0, NULL);
 }
 
+/*
+ * The time index: the timestamped points of every track, route and
+ * the waypoint list, so each image costs a few binary searches instead
+ * of a walk over the whole dataset.
+ */
+
 static void
-exif_remove_tag(const int ifd_nr, const int tag_id)
+exif_index_track_cb(const route_head* rte)
 {
-  exif_put_value(ifd_nr, tag_id, EXIF_TYPE_BYTE, 0, 0, NULL);
+  exif_time_tree.add(rte);
 }
 
 static void
-exif_find_wpt_by_time(const Waypoint* wpt)
+exif_index_wpt_cb(const Waypoint* wpt)
 {
-  if (!wpt->creation_time.isValid()) {
-    return;
+  exif_wpts.append((Waypoint*) wpt);
+}
+
+static void
+exif_build_time_index(void)
+{
+  exif_time_tree = time_tree();
+  track_disp_all(exif_index_track_cb, NULL, NULL);
+  route_disp_all(exif_index_track_cb, NULL, NULL);
+
+  exif_wpts.clear();
+  waypt_disp_all(exif_index_wpt_cb);
+  delete exif_wpt_times;
+  exif_wpt_times = new time_index(exif_wpts.constData(), exif_wpts.size());
+  exif_time_tree.add(exif_wpt_times, NULL);
+
+  exif_time_tree.build();
+}
+
+/*
+ * Find the point closest in time to "t".  On equal distance the point
+ * seen first in track, route, waypoint order wins.
+ */
+static bool
+exif_find_wpt_by_time(const time_t t, exif_time_entry_t* ref)
+{
+  int entry, point;
+
+  if (!exif_time_tree.nearest((qint64) t * 1000, &entry, &point)) {
+    return false;
+  }
+  ref->wpt = exif_time_tree.index(entry)->wpt[point];
+  ref->owner = exif_time_tree.owner(entry);
+  ref->time = ref->wpt->GetCreationTime().toMSecsSinceEpoch();
+  return true;
+}
+
+/*
+ * Linear interpolation between the closest point and its neighbour on
+ * the other side of "t" within the same track or route.  Returns NULL
+ * if there is no such neighbour; the caller owns the result.
+ */
+static Waypoint*
+exif_interpolate_wpt(const exif_time_entry_t* ref, const time_t t)
+{
+  const Waypoint* wa, *wb;
+  const queue* next;
+  qint64 ta, tb, tt;
+  double frac;
+  Waypoint* wpt;
+
+  tt = (qint64)t * 1000;
+  if ((ref->owner == NULL) || (ref->time == tt)) {
+    return NULL;
+  }
+
+  if (ref->time < tt) {
+    next = ref->wpt->Q.next;
+    wa = ref->wpt;
+    wb = (const Waypoint*)next;
+  } else {
+    next = ref->wpt->Q.prev;
+    wa = (const Waypoint*)next;
+    wb = ref->wpt;
+  }
+  if (next == &ref->owner->waypoint_list) {
+    return NULL;
+  }
+  if (!wa->creation_time.isValid() || !wb->creation_time.isValid()) {
+    return NULL;
   }
 
-  if (exif_wpt_ref == NULL) {
-    exif_wpt_ref = wpt;
-  } else if (abs(exif_time_ref - wpt->creation_time.toTime_t()) < abs(exif_time_ref - exif_wpt_ref->creation_time.toTime_t())) {
-    exif_wpt_ref = wpt;
+  ta = wa->GetCreationTime().toMSecsSinceEpoch();
+  tb = wb->GetCreationTime().toMSecsSinceEpoch();
+  if ((tt <= ta) || (tt >= tb)) {
+    return NULL;
   }
+  frac = (double)(tt - ta) / (double)(tb - ta);
+
+  wpt = new Waypoint(*ref->wpt);
+  linepart(wa->latitude, wa->longitude, wb->latitude, wb->longitude,
+           frac, &wpt->latitude, &wpt->longitude);
+  if ((wa->altitude != unknown_alt) && (wb->altitude != unknown_alt)) {
+    wpt->altitude = wa->altitude + frac * (wb->altitude - wa->altitude);
+  } else {
+    wpt->altitude = unknown_alt;
+  }
+  wpt->SetCreationTime(t);
+
+  return wpt;
 }
 
+static const Waypoint* exif_wpt_by_name;
+
 static void
 exif_find_wpt_by_name(const Waypoint* wpt)
 {
-  if (exif_wpt_ref != NULL) {
+  if (exif_wpt_by_name != NULL) {
     return;
   } else if ((wpt->shortname != NULL) && (case_ignore_strcmp(wpt->shortname, opt_name) == 0)) {
-    exif_wpt_ref = wpt;
+    exif_wpt_by_name = wpt;
   }
 }
 
@@ -1224,7 +1347,7 @@ exif_write_ifd(const exif_ifd_t* ifd, const char next, gbfile* fout)
             gbfputdbl(*(double*)ptr, fout);
             break;
           default:
-            gbfwrite(ptr, exif_type_size(tag->type), 1, fin);
+            gbfwrite(ptr, exif_type_size(tag->type), 1, fout);
             break;
           }
           ptr += (tag->size / tag->count);
@@ -1237,13 +1360,13 @@ exif_write_ifd(const exif_ifd_t* ifd, const char next, gbfile* fout)
 }
 
 static void
-exif_write_apps(void)
+exif_write_apps(queue* apps, exif_app_t* exif_app, gbfile* fout)
 {
   queue* e0, *t0;
 
   gbfputuint16(0xFFD8, fout);
 
-  QUEUE_FOR_EACH(&exif_apps, e0, t0) {
+  QUEUE_FOR_EACH(apps, e0, t0) {
     exif_app_t* app = (exif_app_t*)e0;
 
     gbfputuint16(app->marker, fout);
@@ -1254,8 +1377,8 @@ exif_write_apps(void)
       gbfile* ftmp;
       exif_tag_t* tag;
 
-      exif_put_long(IFD0, IFD0_TAG_GPS_IFD_OFFS, 0, 0);
-      exif_put_value(GPS_IFD, GPS_IFD_TAG_VERSION, EXIF_TYPE_BYTE, 4, 0, writer_gps_tag_version);
+      exif_put_long(app, IFD0, IFD0_TAG_GPS_IFD_OFFS, 0, 0);
+      exif_put_value(app, GPS_IFD, GPS_IFD_TAG_VERSION, EXIF_TYPE_BYTE, 4, 0, writer_gps_tag_version);
 
       sortqueue(&exif_app->ifds, exif_sort_ifds_cb);
 
@@ -1263,11 +1386,11 @@ exif_write_apps(void)
         exif_ifd_t* ifd = (exif_ifd_t*)e1;
 
         if (ifd->nr == GPS_IFD) {
-          exif_put_long(IFD0, IFD0_TAG_GPS_IFD_OFFS, 0, len);
+          exif_put_long(app, IFD0, IFD0_TAG_GPS_IFD_OFFS, 0, len);
         } else if (ifd->nr == EXIF_IFD) {
-          exif_put_long(IFD0, IFD0_TAG_EXIF_IFD_OFFS, 0, len);
+          exif_put_long(app, IFD0, IFD0_TAG_EXIF_IFD_OFFS, 0, len);
         } else if (ifd->nr == INTER_IFD) {
-          exif_put_long(EXIF_IFD, EXIF_IFD_TAG_INTER_IFD_OFFS, 0, len);
+          exif_put_long(app, EXIF_IFD, EXIF_IFD_TAG_INTER_IFD_OFFS, 0, len);
         }
 
         len += exif_ifd_size(ifd);
@@ -1276,7 +1399,7 @@ exif_write_apps(void)
       len += 4; /* DWORD(0) after last ifd */
 
       if ((exif_find_tag(app, IFD1, IFD1_TAG_JPEG_OFFS))) {
-        exif_put_long(IFD1, IFD1_TAG_JPEG_OFFS, 0, len);
+        exif_put_long(app, IFD1, IFD1_TAG_JPEG_OFFS, 0, len);
       }
 
       QUEUE_FOR_EACH(&app->ifds, e1, t1) {
@@ -1345,7 +1468,7 @@ exif_rd_init(const char* fname)
 static void
 exif_rd_deinit(void)
 {
-  exif_release_apps();
+  exif_release_apps(&exif_apps);
   gbfclose(fin);
 }
 
@@ -1358,191 +1481,361 @@ exif_read(void)
   soi = gbfgetuint16(fin);
   is_fatal(soi != 0xFFD8, MYNAME ": Unknown image file.");	/* only jpeg for now */
 
-  exif_app = exif_load_apps();
+  exif_app = exif_load_apps(fin, &exif_apps);
   is_fatal(exif_app == NULL, MYNAME ": No EXIF header in source file \"%s\".", fin->name);
 
   exif_examine_app(exif_app);
-  wpt = exif_waypt_from_exif_app(exif_app);
+  wpt = exif_waypt_from_exif_app(exif_app, fin->name);
   if (wpt) {
     waypt_add(wpt);
   }
 }
 
+/*
+ * Expand the output "file name" into the list of images to tag.  A
+ * directory means all JPEG files inside it, a name with wildcards is
+ * matched against the files of its directory.  Anything else is a
+ * single image, handled exactly as before.
+ */
 static void
-exif_wr_init(const char* fname)
+exif_collect_images(const QString& fname)
 {
-  uint16_t soi;
-  char* tmpname;
-
-  exif_success = 0;
-  exif_fout_name = xstrdup(fname);
+  QFileInfo info(fname);
+  QStringList filters;
+  QString dirname;
+  QStringList names;
+  exif_image_t image;
+
+  image.fimg = NULL;
+  image.fout = NULL;
+  image.failed = 0;
+  if (info.isDir()) {
+    dirname = fname;
+    filters << "*.jpg" << "*.jpeg" << "*.JPG" << "*.JPEG";
+  } else if (fname.contains(QChar('*')) || fname.contains(QChar('?')) || fname.contains(QChar('['))) {
+    dirname = info.path();
+    filters << info.fileName();
+  } else {
+    image.fname = fname;
+    image.batch = 0;
+    exif_images.append(image);
+    return;
+  }
 
-  QUEUE_INIT(&exif_apps);
+  QDir dir(dirname);
+  dir.setNameFilters(filters);
+  names = dir.entryList(QDir::Files | QDir::Readable, QDir::Name);
+  if (names.isEmpty()) {
+    fatal(MYNAME ": No images found for \"%s\".\n", qPrintable(fname));
+  }
+  for (int i = 0; i < names.size(); i++) {
+    const QString& name = names.at(i);
+    /* On case-insensitive file systems "*.jpg" and "*.JPG" match twice. */
+    if ((i > 0) && (name == names.at(i - 1))) {
+      continue;
+    }
+    /*
+     * Without overwrite the tagged copy of "x" is "x.jpg" (see
+     * exif_tag_image()); don't tag the copies of an earlier run again.
+     */
+    if (name.endsWith(".jpg") && QFile::exists(dir.filePath(name.left(name.size() - 4)))) {
+      continue;
+    }
+    image.fname = dir.filePath(name);
+    image.batch = 1;
+    exif_images.append(image);
+  }
+}
 
-  fin = gbfopen_be(fname, "rb", MYNAME);
-  is_fatal(fin->is_pipe, MYNAME ": Sorry, this format cannot be used with pipes!");
+static void
+exif_wr_init(const char* fname)
+{
+  exif_fout_name = QString::fromUtf8(fname);
+  exif_images.clear();
 
-  soi = gbfgetuint16(fin);
-  is_fatal(soi != 0xFFD8, MYNAME ": Unknown image file.");
-  exif_app = exif_load_apps();
-  is_fatal(exif_app == NULL, MYNAME ": No EXIF header found in source file \"%s\".", fin->name);
-  exif_examine_app(exif_app);
-  gbfclose(fin);
+  is_fatal(strcmp(fname, "-") == 0, MYNAME ": Sorry, this format cannot be used with pipes!");
 
-  exif_time_ref = exif_get_exif_time(exif_app);
-  if (exif_time_ref == 0) {
-    fatal(MYNAME ": No valid timestamp found in picture!\n");
-  }
-abort();
-  xasprintf(&tmpname, "%s.jpg", fname);
-  fout = gbfopen_be(tmpname, "wb", MYNAME);
-  xfree(tmpname);
+  exif_collect_images(exif_fout_name);
 }
 
 static void
 exif_wr_deinit(void)
 {
-  char* tmpname;
-
-  exif_release_apps();
-  tmpname = xstrdup(fout->name);
-  gbfclose(fout);
+  exif_images.clear();
+  exif_time_tree = time_tree();
+  delete exif_wpt_times;
+  exif_wpt_times = NULL;
+  exif_wpts.clear();
+  exif_fout_name.clear();
+}
 
-  if (exif_success) {
-    if (*opt_overwrite == '1') {
-      remove(exif_fout_name);
-      rename(tmpname, exif_fout_name);
+/*
+ * Put the GPS tags of "wpt" into the Exif app of one image.
+ */
+static void
+exif_put_wpt(exif_app_t* app, const Waypoint* wpt)
+{
+  exif_put_long(app, IFD0, IFD0_TAG_GPS_IFD_OFFS, 0, 0);
+  exif_put_value(app, GPS_IFD, GPS_IFD_TAG_VERSION, EXIF_TYPE_BYTE, 4, 0, writer_gps_tag_version);
+  exif_put_str(app, GPS_IFD, GPS_IFD_TAG_DATUM, "WGS-84");
+
+  exif_put_str(app, GPS_IFD, GPS_IFD_TAG_LATREF, wpt->latitude < 0 ? "S" : "N");
+  exif_put_coord(app, GPS_IFD, GPS_IFD_TAG_LAT, fabs(wpt->latitude));
+  exif_put_str(app, GPS_IFD, GPS_IFD_TAG_LONREF, wpt->longitude < 0 ? "W" : "E");
+  exif_put_coord(app, GPS_IFD, GPS_IFD_TAG_LON, fabs(wpt->longitude));
+
+  if (wpt->altitude == unknown_alt) {
+    exif_remove_tag(app, GPS_IFD, GPS_IFD_TAG_ALT);
+    exif_remove_tag(app, GPS_IFD, GPS_IFD_TAG_ALTREF);
+  } else {
+    uint8_t alt_ref;
+    if (wpt->altitude >= 0.0) {
+      alt_ref = 0;
+    } else {
+      alt_ref = 1;
     }
+    exif_put_value(app, GPS_IFD, GPS_IFD_TAG_ALTREF, EXIF_TYPE_BYTE, 1, 0, &alt_ref);
+    exif_put_double(app, GPS_IFD, GPS_IFD_TAG_ALT, 0, wpt->altitude);
+  }
+
+  if (wpt->creation_time.isValid()) {
+    /* QDateTime instead of gmtime(): we may run on a worker thread. */
+    QDateTime dt = wpt->GetCreationTime().toUTC();
+    QDate date = dt.date();
+    QTime time = dt.time();
+    char buf[32];
+
+    exif_put_double(app, GPS_IFD, GPS_IFD_TAG_TIMESTAMP, 0, time.hour());
+    exif_put_double(app, GPS_IFD, GPS_IFD_TAG_TIMESTAMP, 1, time.minute());
+    exif_put_double(app, GPS_IFD, GPS_IFD_TAG_TIMESTAMP, 2, time.second());
+
+    snprintf(buf, sizeof(buf), "%04d:%02d:%02d", date.year(), date.month(), date.day());
+    exif_put_str(app, GPS_IFD, GPS_IFD_TAG_DATESTAMP, buf);
+  } else {
+    exif_remove_tag(app, GPS_IFD, GPS_IFD_TAG_TIMESTAMP);
+    exif_remove_tag(app, GPS_IFD, GPS_IFD_TAG_DATESTAMP);
+  }
+
+  if (wpt->sat > 0) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%d", wpt->sat);
+    exif_put_str(app, GPS_IFD, GPS_IFD_TAG_SAT, buf);
+  } else {
+    exif_remove_tag(app, GPS_IFD, GPS_IFD_TAG_SAT);
+  }
+
+  if (wpt->fix == fix_2d) {
+    exif_put_str(app, GPS_IFD, GPS_IFD_TAG_MODE, "2");
+  } else if (wpt->fix == fix_3d) {
+    exif_put_str(app, GPS_IFD, GPS_IFD_TAG_MODE, "3");
+  } else {
+    exif_remove_tag(app, GPS_IFD, GPS_IFD_TAG_MODE);
+  }
+
+  if (wpt->ext->hdop > 0) {
+    exif_put_double(app, GPS_IFD, GPS_IFD_TAG_DOP, 0, wpt->ext->hdop);
   } else {
-    remove(tmpname);
+    exif_remove_tag(app, GPS_IFD, GPS_IFD_TAG_DOP);
   }
 
-  xfree(exif_fout_name);
-  xfree(tmpname);
+  if WAYPT_HAS(wpt, speed) {
+    exif_put_str(app, GPS_IFD, GPS_IFD_TAG_SPEEDREF, "K");
+    exif_put_double(app, GPS_IFD, GPS_IFD_TAG_SPEED, 0, MPS_TO_KPH(wpt->speed));
+  } else {
+    exif_remove_tag(app, GPS_IFD, GPS_IFD_TAG_SPEEDREF);
+    exif_remove_tag(app, GPS_IFD, GPS_IFD_TAG_SPEED);
+  }
 }
 
+/*
+ * Tag one image.  Everything touched here is local to the image, the
+ * time index is only read, so several images can be tagged at once.
+ * In batch mode a broken or unmatched picture is skipped with a
+ * warning instead of aborting the whole run.
+ */
 static void
-exif_write(void)
+exif_tag_image(exif_image_t* image)
 {
-  time_t frame;
+  QByteArray fname = image->fname.toUtf8();
+  QByteArray tmpname = fname + ".jpg";
+  exif_app_t* app;
+  Waypoint* wpt_interp = NULL;
+  const Waypoint* wpt = NULL;
+  uint16_t soi;
+  time_t time_ref;
 
-  exif_wpt_ref = NULL;
+  QUEUE_INIT(&image->apps);
 
-  if (opt_name) {
-    waypt_disp_all(exif_find_wpt_by_name);
-    if (exif_wpt_ref == NULL) {
-      route_disp_all(NULL, NULL, exif_find_wpt_by_name);
-    }
-    if (exif_wpt_ref == NULL) {
-      track_disp_all(NULL, NULL, exif_find_wpt_by_name);
-    }
-    if (exif_wpt_ref == NULL) {
-      warning(MYNAME ": No matching point with name \"%s\" found.\n", opt_name);
-    }
-  } else {
-    QString str = exif_time_str(exif_time_ref);
+  /* gbfopen() is fatal, so see first whether a batch can go on. */
+  if (!QFileInfo(image->fname).isReadable()) {
+    is_fatal(!image->batch, MYNAME ": Cannot open \"%s\" for reading.\n", fname.constData());
+    warning(MYNAME ": Skipping \"%s\", it can't be read.\n", fname.constData());
+    return;
+  }
+  image->fimg = gbfopen_be(fname.constData(), "rb", MYNAME);
+  soi = gbfgetuint16(image->fimg);
+  if (soi != 0xFFD8) {
+    is_fatal(!image->batch, MYNAME ": Unknown image file.");
+    warning(MYNAME ": Skipping \"%s\", unknown image file.\n", fname.constData());
+    gbfclose(image->fimg);
+    image->fimg = NULL;
+    return;
+  }
+  app = exif_load_apps(image->fimg, &image->apps);
+  gbfclose(image->fimg);
+  image->fimg = NULL;
+  if (app == NULL) {
+    is_fatal(!image->batch, MYNAME ": No EXIF header found in source file \"%s\".", fname.constData());
+    warning(MYNAME ": Skipping \"%s\", no EXIF header found.\n", fname.constData());
+    exif_release_apps(&image->apps);
+    return;
+  }
+  exif_examine_app(app);
 
-    track_disp_all(NULL, NULL, exif_find_wpt_by_time);
-    route_disp_all(NULL, NULL, exif_find_wpt_by_time);
-    waypt_disp_all(exif_find_wpt_by_time);
+  time_ref = exif_get_exif_time(app);
+  if (time_ref == 0) {
+    is_fatal(!image->batch, MYNAME ": No valid timestamp found in picture!\n");
+    warning(MYNAME ": Skipping \"%s\", no valid timestamp found.\n", fname.constData());
+    exif_release_apps(&image->apps);
+    return;
+  }
 
-    frame = atoi(opt_frame);
+  if (opt_name) {
+    wpt = exif_wpt_by_name;
+  } else {
+    exif_time_entry_t ref;
+    qint64 frame = (qint64) atoi(opt_frame) * 1000;
 
-    if (exif_wpt_ref == NULL) {
+    if (!exif_find_wpt_by_time(time_ref, &ref)) {
       warning(MYNAME ": No point with a valid timestamp found.\n");
-    } else if (abs(exif_time_ref - exif_wpt_ref->creation_time.toTime_t()) > frame) {
+    } else if (qAbs((qint64) time_ref * 1000 - ref.time) > frame) {
+      QString str = exif_time_str(time_ref);
       warning(MYNAME ": No matching point found for image date %s!\n", qPrintable(str));
-      if (exif_wpt_ref != NULL) {
-        QString str = exif_time_str(exif_wpt_ref->creation_time.toTime_t());
-        warning(MYNAME ": Best is from %s, %d second(s) away.\n",
-                qPrintable(str), abs(exif_time_ref - exif_wpt_ref->creation_time.toTime_t()));
+      str = exif_time_str(ref.time / 1000);
+      warning(MYNAME ": Best is from %s, %d second(s) away.\n",
+              qPrintable(str), (int)(qAbs((qint64) time_ref * 1000 - ref.time) / 1000));
+    } else {
+      wpt = ref.wpt;
+      if (*opt_interpolate == '1') {
+        wpt_interp = exif_interpolate_wpt(&ref, time_ref);
+        if (wpt_interp) {
+          wpt = wpt_interp;
+        }
       }
-      exif_wpt_ref = NULL;
     }
   }
 
-  if (exif_wpt_ref != NULL) {
-    const Waypoint* wpt = exif_wpt_ref;
-
-    exif_put_long(IFD0, IFD0_TAG_GPS_IFD_OFFS, 0, 0);
-    exif_put_value(GPS_IFD, GPS_IFD_TAG_VERSION, EXIF_TYPE_BYTE, 4, 0, writer_gps_tag_version);
-    exif_put_str(GPS_IFD, GPS_IFD_TAG_DATUM, "WGS-84");
+  if (wpt != NULL) {
+    exif_put_wpt(app, wpt);
 
-    exif_put_str(GPS_IFD, GPS_IFD_TAG_LATREF, wpt->latitude < 0 ? "S" : "N");
-    exif_put_coord(GPS_IFD, GPS_IFD_TAG_LAT, fabs(wpt->latitude));
-    exif_put_str(GPS_IFD, GPS_IFD_TAG_LONREF, wpt->longitude < 0 ? "W" : "E");
-    exif_put_coord(GPS_IFD, GPS_IFD_TAG_LON, fabs(wpt->longitude));
+    image->fout = gbfopen_be(tmpname.constData(), "wb", MYNAME);
+    exif_write_apps(&image->apps, app, image->fout);	/* Success, write the new file */
+    gbfclose(image->fout);
+    image->fout = NULL;
 
-    if (wpt->altitude == unknown_alt) {
-      exif_remove_tag(GPS_IFD, GPS_IFD_TAG_ALT);
-      exif_remove_tag(GPS_IFD, GPS_IFD_TAG_ALTREF);
-    } else {
-      uint8_t alt_ref;
-      if (wpt->altitude >= 0.0) {
-        alt_ref = 0;
-      } else {
-        alt_ref = 1;
-      }
-      exif_put_value(GPS_IFD, GPS_IFD_TAG_ALTREF, EXIF_TYPE_BYTE, 1, 0, &alt_ref);
-      exif_put_double(GPS_IFD, GPS_IFD_TAG_ALT, 0, wpt->altitude);
+    if (*opt_overwrite == '1') {
+      remove(fname.constData());
+      rename(tmpname.constData(), fname.constData());
     }
+  }
 
-    if (wpt->creation_time.isValid()) {
-      struct tm tm;
-      char buf[32];
+  delete wpt_interp;
+  exif_release_apps(&image->apps);
+}
 
-      const time_t tt = wpt->GetCreationTime().toTime_t();
-      tm = *gmtime(&tt);
+/*
+ * Tag one image of a batch.  Its messages are kept for exif_write() to
+ * report, and a fatal error only ends this image: whatever it had open
+ * is closed and a half written copy is removed.
+ */
+static void
+exif_tag_batch_image(exif_image_t* image)
+{
+  fatal_trap_set(&image->messages);
+  try {
+    exif_tag_image(image);
+  } catch (const fatal_trapped&) {
+    image->failed = 1;
+    if (image->fimg) {
+      gbfclose(image->fimg);
+      image->fimg = NULL;
+    }
+    if (image->fout) {
+      gbfclose(image->fout);
+      image->fout = NULL;
+      remove(qPrintable(image->fname + ".jpg"));
+    }
+    exif_release_apps(&image->apps);
+  }
+  fatal_trap_set(NULL);
+}
 
-      tm.tm_year += 1900;
-      tm.tm_mon += 1;
+class ExifTagJob : public QRunnable
+{
+public:
+  ExifTagJob(exif_image_t* image) : image_(image) {}
+  virtual void run() {
+    exif_tag_batch_image(image_);
+  }
+private:
+  exif_image_t* image_;
+};
 
-      exif_put_double(GPS_IFD, GPS_IFD_TAG_TIMESTAMP, 0, tm.tm_hour);
-      exif_put_double(GPS_IFD, GPS_IFD_TAG_TIMESTAMP, 1, tm.tm_min);
-      exif_put_double(GPS_IFD, GPS_IFD_TAG_TIMESTAMP, 2, tm.tm_sec);
+static void
+exif_write(void)
+{
+  int threads;
 
-      snprintf(buf, sizeof(buf), "%04d:%02d:%02d", tm.tm_year, tm.tm_mon, tm.tm_mday);
-      exif_put_str(GPS_IFD, GPS_IFD_TAG_DATESTAMP, buf);
-    } else {
-      exif_remove_tag(GPS_IFD, GPS_IFD_TAG_TIMESTAMP);
-      exif_remove_tag(GPS_IFD, GPS_IFD_TAG_DATESTAMP);
-    }
+  exif_wpt_by_name = NULL;
 
-    if (wpt->sat > 0) {
-      char buf[16];
-      snprintf(buf, sizeof(buf), "%d", wpt->sat);
-      exif_put_str(GPS_IFD, GPS_IFD_TAG_SAT, buf);
-    } else {
-      exif_remove_tag(GPS_IFD, GPS_IFD_TAG_SAT);
+  if (opt_name) {
+    waypt_disp_all(exif_find_wpt_by_name);
+    if (exif_wpt_by_name == NULL) {
+      route_disp_all(NULL, NULL, exif_find_wpt_by_name);
     }
-
-    if (wpt->fix == fix_2d) {
-      exif_put_str(GPS_IFD, GPS_IFD_TAG_MODE, "2");
-    } else if (wpt->fix == fix_3d) {
-      exif_put_str(GPS_IFD, GPS_IFD_TAG_MODE, "3");
-    } else {
-      exif_remove_tag(GPS_IFD, GPS_IFD_TAG_MODE);
+    if (exif_wpt_by_name == NULL) {
+      track_disp_all(NULL, NULL, exif_find_wpt_by_name);
     }
-
-    if (wpt->hdop > 0) {
-      exif_put_double(GPS_IFD, GPS_IFD_TAG_DOP, 0, wpt->hdop);
-    } else {
-      exif_remove_tag(GPS_IFD, GPS_IFD_TAG_DOP);
+    if (exif_wpt_by_name == NULL) {
+      warning(MYNAME ": No matching point with name \"%s\" found.\n", opt_name);
+      return;
     }
+  } else {
+    exif_build_time_index();
+  }
 
-    if WAYPT_HAS(wpt, speed) {
-      exif_put_str(GPS_IFD, GPS_IFD_TAG_SPEEDREF, "K");
-      exif_put_double(GPS_IFD, GPS_IFD_TAG_SPEED, 0, MPS_TO_KPH(wpt->speed));
-    } else {
-      exif_remove_tag(GPS_IFD, GPS_IFD_TAG_SPEEDREF);
-      exif_remove_tag(GPS_IFD, GPS_IFD_TAG_SPEED);
-    }
+  threads = opt_threads ? atoi(opt_threads) : 0;
+  if (threads <= 0) {
+    threads = route_threads();
+  }
 
-    exif_write_apps();	/* Success, write the new file */
+  if (!exif_images.at(0).batch) {
+    exif_tag_image(&exif_images[0]);
+    return;
+  }
 
-    exif_success = 1;
+  if (threads <= 1) {
+    for (int i = 0; i < exif_images.size(); i++) {
+      exif_tag_batch_image(&exif_images[i]);
+    }
+  } else {
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    for (int i = 0; i < exif_images.size(); i++) {
+      pool.start(new ExifTagJob(&exif_images[i]));
+    }
+    pool.waitForDone();
   }
 
+  for (int i = 0; i < exif_images.size(); i++) {
+    const exif_image_t& image = exif_images.at(i);
+    if (!image.messages.isEmpty()) {
+      warning("%s", image.messages.constData());
+    }
+    if (image.failed) {
+      warning(MYNAME ": Skipped \"%s\" after the error above.\n", qPrintable(image.fname));
+    }
+  }
 }
 
 /**************************************************************************/
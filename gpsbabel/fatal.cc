@@ -20,13 +20,74 @@
  */
 
 #include "defs.h"
+#include <QtCore/QThreadStorage>
+
+static message_handler_t message_handler = NULL;
+
+/* The trap of each thread; Qt deletes the slot when the thread ends. */
+typedef struct {
+  QByteArray* messages;
+} fatal_trap_t;
+
+static QThreadStorage<fatal_trap_t*> fatal_traps;
+
+void
+fatal_trap_set(QByteArray* messages)
+{
+  if (!fatal_traps.hasLocalData()) {
+    fatal_traps.setLocalData(new fatal_trap_t);
+  }
+  fatal_traps.localData()->messages = messages;
+}
+
+static QByteArray*
+fatal_trap_get(void)
+{
+  return fatal_traps.hasLocalData() ? fatal_traps.localData()->messages : NULL;
+}
+
+message_handler_t
+set_message_handler(message_handler_t handler)
+{
+  message_handler_t old = message_handler;
+  message_handler = handler;
+  return old;
+}
+
+/* A QByteArray, so the message is freed if a handler unwinds past us. */
+static QByteArray
+message_format(const char* fmt, va_list ap)
+{
+  char* buf;
+  QByteArray msg;
+
+  xvasprintf(&buf, fmt, ap);
+  msg = buf;
+  xfree(buf);
+  return msg;
+}
+
 void
 fatal(const char* fmt, ...)
 {
   va_list ap;
+  QByteArray msg;
+  QByteArray* trap = fatal_trap_get();
+
   va_start(ap, fmt);
-  vfprintf(stderr, fmt, ap);
+  if (trap || message_handler) {
+    msg = message_format(fmt, ap);
+  } else {
+    vfprintf(stderr, fmt, ap);
+  }
   va_end(ap);
+  if (trap) {
+    trap->append(msg);
+    throw fatal_trapped();
+  }
+  if (message_handler) {
+    message_handler(1, msg.constData());
+  }
   exit(1);
 }
 
@@ -34,9 +95,21 @@ void
 warning(const char* fmt, ...)
 {
   va_list ap;
+  QByteArray msg;
+  QByteArray* trap = fatal_trap_get();
+
   va_start(ap, fmt);
-  vfprintf(stderr, fmt, ap);
+  if (trap || message_handler) {
+    msg = message_format(fmt, ap);
+  } else {
+    vfprintf(stderr, fmt, ap);
+  }
   va_end(ap);
+  if (trap) {
+    trap->append(msg);
+  } else if (message_handler) {
+    message_handler(0, msg.constData());
+  }
 }
 
 void
@@ -50,6 +50,8 @@ extern filter_vecs_t transform_vecs;
 extern filter_vecs_t height_vecs;
 extern filter_vecs_t swapdata_vecs;
 extern filter_vecs_t validate_vecs;
+extern filter_vecs_t timewindow_vecs;
+extern filter_vecs_t tile_vecs;
 
 static
 fl_vecs_t filter_vec_list[] = {
@@ -124,6 +126,16 @@ fl_vecs_t filter_vec_list[] = {
     "track",
     "Manipulate track lists"
   },
+  {
+    &tile_vecs,
+    "tile",
+    "Split data into tiles, cutting tracks at tile edges"
+  },
+  {
+    &timewindow_vecs,
+    "timewindow",
+    "Keep track points inside a list of time windows"
+  },
   {
     &transform_vecs,
     "transform",
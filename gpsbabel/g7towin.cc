@@ -113,7 +113,7 @@ parse_line(char* buff, int index, const char* delimiter, Waypoint* wpt)
       break;
 
     case WAYPT__OFS + 2:
-      wpt->icon_descr = gt_find_desc_from_icon_number(
+      wpt->AllocExt()->icon_descr = gt_find_desc_from_icon_number(
                           atoi(cin), PCX);
       break;
 
@@ -275,7 +275,7 @@ parse_waypt(char* buff)
 
   wpt = new Waypoint;
   gmsd = garmin_fs_alloc(-1);
-  fs_chain_add(&wpt->fs, (format_specific_data*) gmsd);
+  fs_chain_add(&wpt->AllocExt()->fs, (format_specific_data*) gmsd);
 
   if (gardown) {
     cin = buff + 6;
@@ -349,7 +349,7 @@ parse_trkpt(char* buff)
 
   wpt = new Waypoint;
   gmsd = garmin_fs_alloc(-1);
-  fs_chain_add(&wpt->fs, (format_specific_data*) gmsd);
+  fs_chain_add(&wpt->AllocExt()->fs, (format_specific_data*) gmsd);
 
   parse_line(buff, TRKPT__OFS, ";", wpt);
 
@@ -467,7 +467,7 @@ data_read(void)
       }
       if (*cdata == ';') {
         cdata++;
-        wpt->icon_descr = gt_find_desc_from_icon_number(
+        wpt->AllocExt()->icon_descr = gt_find_desc_from_icon_number(
                             atoi(cdata), PCX);
       }
       waypt_add(wpt);
@@ -396,10 +396,10 @@ waypt_read(void)
     wpt_tmp->longitude = way[i]->lon;
     wpt_tmp->latitude = way[i]->lat;
     if (gps_waypt_type == 103) {
-      wpt_tmp->icon_descr = d103_symbol_from_icon_number(
+      wpt_tmp->AllocExt()->icon_descr = d103_symbol_from_icon_number(
                               way[i]->smbl);
     } else {
-      wpt_tmp->icon_descr = gt_find_desc_from_icon_number(
+      wpt_tmp->AllocExt()->icon_descr = gt_find_desc_from_icon_number(
                               way[i]->smbl, PCX);
     }
     /*
@@ -528,8 +528,8 @@ track_read(void)
     wpt->longitude = array[i]->lon;
     wpt->latitude = array[i]->lat;
     wpt->altitude = array[i]->alt;
-    wpt->heartrate = array[i]->heartrate;
-    wpt->cadence = array[i]->cadence;
+    wpt->AllocExt()->heartrate = array[i]->heartrate;
+    wpt->AllocExt()->cadence = array[i]->cadence;
     wpt->shortname = array[i]->trk_ident;
     wpt->SetCreationTime(array[i]->Time);
     wpt->wpt_flags.is_split = checkWayPointIsAtSplit(wpt, laps,
@@ -887,25 +887,25 @@ const char*
 get_gc_info(Waypoint* wpt)
 {
   if (global_opts.smart_names) {
-    if (wpt->gc_data->type == gt_virtual) {
+    if (wpt->ext->gc_data->type == gt_virtual) {
       return  "V ";
     }
-    if (wpt->gc_data->type == gt_unknown) {
+    if (wpt->ext->gc_data->type == gt_unknown) {
       return  "? ";
     }
-    if (wpt->gc_data->type == gt_multi) {
+    if (wpt->ext->gc_data->type == gt_multi) {
       return  "Mlt ";
     }
-    if (wpt->gc_data->type == gt_earth) {
+    if (wpt->ext->gc_data->type == gt_earth) {
       return  "EC ";
     }
-    if (wpt->gc_data->type == gt_event) {
+    if (wpt->ext->gc_data->type == gt_event) {
       return  "Ev ";
     }
-    if (wpt->gc_data->container == gc_micro) {
+    if (wpt->ext->gc_data->container == gc_micro) {
       return  "M ";
     }
-    if (wpt->gc_data->container == gc_small) {
+    if (wpt->ext->gc_data->container == gc_small) {
       return  "S ";
     }
   }
@@ -947,8 +947,8 @@ waypoint_prepare(void)
     if (!wpt->description.isEmpty()) {
       src = wpt->description;
     }
-    if (!wpt->notes.isEmpty()) {
-      src = wpt->notes;
+    if (!wpt->ext->notes.isEmpty()) {
+      src = wpt->ext->notes;
     }
 
     /*
@@ -972,14 +972,14 @@ waypoint_prepare(void)
     // If we were explictly given a comment from GPX, use that.
     //  This logic really is horrible and needs to be untangled.
     if (!wpt->description.isEmpty() &&
-        global_opts.smart_names && !wpt->gc_data->diff) {
+        global_opts.smart_names && !wpt->ext->gc_data->diff) {
       memcpy(tx_waylist[i]->cmnt, CSTRc(wpt->description), strlen(CSTRc(wpt->description)));
     } else {
       if (global_opts.smart_names &&
-          wpt->gc_data->diff && wpt->gc_data->terr) {
+          wpt->ext->gc_data->diff && wpt->ext->gc_data->terr) {
         snprintf(obuf, sizeof(obuf), "%s%d/%d %s",
                  get_gc_info(wpt),
-                 wpt->gc_data->diff, wpt->gc_data->terr,
+                 wpt->ext->gc_data->diff, wpt->ext->gc_data->terr,
                  CSTRc(src));
         memcpy(tx_waylist[i]->cmnt, obuf, strlen(obuf));
       } else  {
@@ -998,7 +998,7 @@ waypoint_prepare(void)
       if (get_cache_icon(wpt)) {
         icon = gt_find_icon_number_from_desc(get_cache_icon(wpt), PCX);
       } else {
-        icon = gt_find_icon_number_from_desc(wpt->icon_descr, PCX);
+        icon = gt_find_icon_number_from_desc(wpt->ext->icon_descr, PCX);
       }
     }
 
@@ -1006,7 +1006,7 @@ waypoint_prepare(void)
      * overwrite that and go very literal.
      */
     if (gps_waypt_type == 103) {
-      icon = d103_icon_number_from_symbol(wpt->icon_descr);
+      icon = d103_icon_number_from_symbol(wpt->ext->icon_descr);
     }
     tx_waylist[i]->smbl = icon;
     if (wpt->altitude == unknown_alt) {
@@ -1085,7 +1085,7 @@ route_waypt_pr(const Waypoint* wpt)
 
   rte->lon = wpt->longitude;
   rte->lat = wpt->latitude;
-  rte->smbl = gt_find_icon_number_from_desc(wpt->icon_descr, PCX);
+  rte->smbl = gt_find_icon_number_from_desc(wpt->ext->icon_descr, PCX);
 
   // map class so unit doesn't duplicate routepoints as a waypoint.
   rte->wpt_class = 0x80;
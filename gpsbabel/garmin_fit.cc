@@ -22,16 +22,25 @@
  */
 
 #include "defs.h"
+#include "grtcirc.h"
 #include <ctype.h>
 
 #define MYNAME "fit"
 
+static char* opt_course;
 
 static
 arglist_t fit_args[] = {
+  {
+    "course", &opt_course, "Write tracks as a course rather than an activity",
+    NULL, ARGTYPE_BOOL, ARG_NOMINMAX
+  },
   ARG_TERMINATOR
 };
 
+/* FIT timestamps count seconds from 1989-12-31T00:00:00Z. */
+#define FIT_TIME_OFFSET 631065600
+
 typedef struct {
   int id;
   int size;
@@ -42,18 +51,29 @@ typedef struct {
   int endian;
   int global_id;
   int num_fields;
+  int size;			/* bytes in a data message */
   fit_field_t* fields;
 } fit_message_def;
 
+/*
+ * Records are decoded from a block buffer rather than read from the file
+ * field by field.  A definition allows at most 255 fields of 255 bytes,
+ * so a record always fits.
+ */
+#define FIT_BUFSIZE (128 * 1024)
+
 static struct {
-  int len;
-  int endian;
+  int len;			/* bytes of the data section not yet decoded */
   route_head* track;
   uint32_t last_timestamp;
   fit_message_def message_def[16];
+  unsigned char* buf;
+  int pos;			/* next byte to decode in buf */
+  int end;			/* end of the bytes read into buf */
 } fit_data;
 
 static	gbfile* fin;
+static	gbfile* fout;
 
 /*******************************************************************************
 * %%%        global callbacks called by gpsbabel main process              %%% *
@@ -63,6 +83,8 @@ static void
 fit_rd_init(const char* fname)
 {
   fin = gbfopen_le(fname, "rb", MYNAME);
+  fit_data.buf = (unsigned char*) xmalloc(FIT_BUFSIZE);
+  fit_data.pos = fit_data.end = 0;
 }
 
 static void
@@ -78,6 +100,8 @@ fit_rd_deinit(void)
     }
   }
 
+  xfree(fit_data.buf);
+  fit_data.buf = NULL;
   gbfclose(fin);
 }
 
@@ -130,65 +154,66 @@ fit_parse_header(void)
   }
 }
 
-static uint8_t
-fit_getuint8(void)
+/*
+ * Returns the next n bytes of the data section, refilling the buffer
+ * from the file as needed.
+ */
+static const unsigned char*
+fit_fetch(int n)
 {
-  int val;
-
-  if (fit_data.len == 0) {
-    // fail gracefully for GARMIN Edge 800 with newest firmware, seems to write a wrong record length
-    // for the last record.
-    //fatal(MYNAME ": record truncated: fit_data.len=0\n");
-    if (global_opts.debug_level >= 1) {
-      warning("%s: record truncated: fit_data.len=0\n", MYNAME);
+  const unsigned char* p;
+  int avail = fit_data.end - fit_data.pos;
+
+  if (avail < n) {
+    int want = fit_data.len - avail;
+
+    memmove(fit_data.buf, fit_data.buf + fit_data.pos, avail);
+    fit_data.pos = 0;
+    fit_data.end = avail;
+    if (want > FIT_BUFSIZE - avail) {
+      want = FIT_BUFSIZE - avail;
+    }
+    if (want > 0) {
+      is_fatal(gbfread(fit_data.buf + avail, 1, want, fin) != (gbsize_t) want,
+               MYNAME ": unexpected end of file with fit_data.len=%d\n",fit_data.len);
+      fit_data.end += want;
+      avail += want;
+    }
+    if (avail < n) {
+      // fail gracefully for GARMIN Edge 800 with newest firmware, seems to write a wrong record length
+      // for the last record.
+      if (global_opts.debug_level >= 1) {
+        warning("%s: record truncated: fit_data.len=%d\n", MYNAME, fit_data.len);
+      }
+      memset(fit_data.buf + avail, 0, n - avail);
+      fit_data.end = n;
+      fit_data.len = n;
     }
-    return 0;
-  }
-  val = gbfgetc(fin);
-  if (val == EOF) {
-    fatal(MYNAME ": unexpected end of file with fit_data.len=%d\n",fit_data.len);
   }
-  fit_data.len--;
-  return (uint8_t)val;
-
+  p = fit_data.buf + fit_data.pos;
+  fit_data.pos += n;
+  fit_data.len -= n;
+  return p;
 }
 
 static uint16_t
-fit_getuint16(void)
+fit_read16(const unsigned char* p, int endian)
 {
-  char buf[2];
-
-  if (fit_data.len < 2) {
-    fatal(MYNAME ": record truncated: expecting char[2], but only got %d\n",fit_data.len);
-  }
-  is_fatal(gbfread(buf, 2, 1, fin) != 1,
-           MYNAME ": unexpected end of file with fit_data.len=%d\n",fit_data.len);
-  fit_data.len -= 2;
-  if (fit_data.endian) {
-    return be_read16(buf);
+  if (endian) {
+    return be_read16(p);
   } else {
-    return le_read16(buf);
+    return le_read16(p);
   }
-
 }
 
 static uint32_t
-fit_getuint32(void)
+fit_read32(const unsigned char* p, int endian)
 {
-  char buf[4];
-
-  if (fit_data.len < 4) {
-    fatal(MYNAME ": record truncated: expecting char[4], but only got %d\n",fit_data.len);
-  }
-  is_fatal(gbfread(buf, 4, 1, fin) != 1,
-           MYNAME ": unexpected end of file with fit_data.len=%d\n",fit_data.len);
-  fit_data.len -= 4;
-  if (fit_data.endian) {
-    return be_read32(buf);
+  if (endian) {
+    return be_read32(p);
   } else {
-    return le_read32(buf);
+    return le_read32(p);
   }
-
 }
 
 static void
@@ -196,31 +221,33 @@ fit_parse_definition_message(uint8_t header)
 {
   int local_id = header & 0x0f;
   fit_message_def* def = &fit_data.message_def[local_id];
+  const unsigned char* p;
   int i;
 
   if (def->fields) {
     xfree(def->fields);
   }
 
+  p = fit_fetch(5);
+
   // first byte is reserved.  It's usually 0 and we don't know what it is,
-  // but we've seen some files that are 0x40.  So we just read it and toss it.
-  i = fit_getuint8();
+  // but we've seen some files that are 0x40.  So we just toss it.
 
   // second byte is endianness
-  def->endian = fit_getuint8();
+  def->endian = p[1];
   if (def->endian > 1) {
     fatal(MYNAME ": Bad endian field\n");
   }
-  fit_data.endian = def->endian;
 
   // next two bytes are the global message number
-  def->global_id = fit_getuint16();
+  def->global_id = fit_read16(p + 2, def->endian);
 
   // byte 5 has the number of records in the remainder of the definition message
-  def->num_fields = fit_getuint8();
+  def->num_fields = p[4];
   if (global_opts.debug_level >= 8) {
     debug_print(8,"%s: definition message contains %d records\n",MYNAME, def->num_fields);
   }
+  def->size = 0;
   if (def->num_fields == 0) {
     def->fields = (fit_field_t*) xmalloc(sizeof(fit_field_t));
     return;
@@ -228,10 +255,12 @@ fit_parse_definition_message(uint8_t header)
 
   // remainder of the definition message is data at one byte per field * 3 fields
   def->fields = (fit_field_t*) xmalloc(def->num_fields * sizeof(fit_field_t));
-  for (i = 0; i < def->num_fields; i++) {
-    def->fields[i].id = fit_getuint8();
-    def->fields[i].size = fit_getuint8();
-    def->fields[i].type = fit_getuint8();
+  p = fit_fetch(3 * def->num_fields);
+  for (i = 0; i < def->num_fields; i++, p += 3) {
+    def->fields[i].id = p[0];
+    def->fields[i].size = p[1];
+    def->fields[i].type = p[2];
+    def->size += p[1];
     if (global_opts.debug_level >= 8) {
       debug_print(8,"%s: record %d  ID: %d  SIZE: %d  TYPE: %d  fit_data.len=%d\n",
                   MYNAME, i, def->fields[i].id, def->fields[i].size, def->fields[i].type,fit_data.len);
@@ -240,10 +269,8 @@ fit_parse_definition_message(uint8_t header)
 }
 
 static uint32_t
-fit_read_field(fit_field_t* f)
+fit_read_field(const fit_field_t* f, const unsigned char* p, int endian)
 {
-  int i;
-
   if (global_opts.debug_level >= 8) {
     debug_print(8,"%s: fit_read_field: read data field with f->type=0x%X and f->size=%d fit_data.len=%d\n",
                 MYNAME, f->type, f->size, fit_data.len);
@@ -253,21 +280,18 @@ fit_read_field(fit_field_t* f)
   case 2: // uint8
     is_fatal(f->size != 1,
              MYNAME ": Bad field size in data message\n");
-    return fit_getuint8();
+    return p[0];
   case 0x83: // sint16
   case 0x84: // uint16
     is_fatal(f->size != 2,
              MYNAME ": Bad field size in data message\n");
-    return fit_getuint16();
+    return fit_read16(p, endian);
   case 0x85: // sint32
   case 0x86: // uint32
     is_fatal(f->size != 4,
              MYNAME ": Bad field size in data message\n");
-    return fit_getuint32();
+    return fit_read32(p, endian);
   default: // Ignore everything else for now.
-    for (i = 0; i < f->size; i++) {
-      fit_getuint8();
-    }
     return -1;
   }
 }
@@ -276,6 +300,7 @@ static void
 fit_parse_data(fit_message_def* def, int time_offset)
 {
   fit_field_t* f;
+  const unsigned char* p = fit_fetch(def->size);
   uint32_t timestamp = fit_data.last_timestamp + time_offset;
   uint32_t val;
   int32_t lat = 0x7fffffff;
@@ -297,7 +322,8 @@ fit_parse_data(fit_message_def* def, int time_offset)
       debug_print(7,"%s: parsing field %d\n", MYNAME, i);
     }
     f = &def->fields[i];
-    val = fit_read_field(f);
+    val = fit_read_field(f, p, def->endian);
+    p += f->size;
     if (f->id == 253) {
       if (global_opts.debug_level >= 7) {
         debug_print(7,"%s: parsing fit data: timestamp=%d\n", MYNAME, val);
@@ -386,18 +412,18 @@ fit_parse_data(fit_message_def* def, int time_offset)
     if (alt != 0xffff) {
       waypt->altitude = (alt / 5.0) - 500;
     }
-    waypt->SetCreationTime(QDateTime::fromTime_t(timestamp + 631065600));
+    waypt->SetCreationTime(QDateTime::fromTime_t(timestamp + FIT_TIME_OFFSET));
     if (speed != 0xffff) {
       WAYPT_SET(waypt, speed, speed / 1000.0f);
     }
     if (heartrate != 0xff) {
-      waypt->heartrate = heartrate;
+      waypt->AllocExt()->heartrate = heartrate;
     }
     if (cadence != 0xff) {
-      waypt->cadence = cadence;
+      waypt->AllocExt()->cadence = cadence;
     }
     if (power != 0xffff) {
-      waypt->power = power;
+      waypt->AllocExt()->power = power;
     }
     if (temperature != 0x7f) {
       WAYPT_SET(waypt, temperature, temperature);
@@ -410,7 +436,7 @@ fit_parse_data(fit_message_def* def, int time_offset)
 static void
 fit_parse_data_message(uint8_t header)
 {
-  int local_id = header & 0x1f;
+  int local_id = header & 0x0f;
   fit_message_def* def = &fit_data.message_def[local_id];
   fit_parse_data(def, 0);
 }
@@ -431,7 +457,7 @@ fit_parse_record(void)
 {
   uint8_t header;
 
-  header = fit_getuint8();
+  header = *fit_fetch(1);
   // high bit 7 set -> compressed message (0 for normal)
   // second bit 6 set -> 0 for data message, 1 for definition message
   // bits 5, 4 -> reserved
@@ -477,24 +503,529 @@ fit_read(void)
   }
 }
 
-/**************************************************************************/
+/*******************************************************************************
+* FIT writer
+*
+* Every message we write has a fixed layout, declared below and indexed by
+* the local message type it is sent as.  The definition message for a type
+* goes out the first time the type is used; data messages are then encoded
+* straight from an array of values in layout order into a single output
+* buffer that is written out, with the header and CRC, at the end.
+*******************************************************************************/
+
+#define FIT_HEADER_SIZE 14
+#define FIT_PROFILE_VERSION 1310
+
+#define FIT_ENUM 0x00
+#define FIT_SINT8 0x01
+#define FIT_UINT8 0x02
+#define FIT_STRING 0x07
+#define FIT_UINT16 0x84
+#define FIT_SINT32 0x85
+#define FIT_UINT32 0x86
+#define FIT_UINT32Z 0x8c
+
+#define FIT_INVALID_U8 0xff
+#define FIT_INVALID_S8 0x7f
+#define FIT_INVALID_U16 0xffff
+#define FIT_INVALID_S32 0x7fffffff
+#define FIT_INVALID_U32 0xffffffff
+
+typedef struct {
+  int global_id;
+  int num_fields;
+  const fit_field_t* fields;
+} fit_layout_t;
+
+enum {
+  FIT_LOCAL_FILE_ID,
+  FIT_LOCAL_COURSE,
+  FIT_LOCAL_EVENT,
+  FIT_LOCAL_RECORD,
+  FIT_LOCAL_LAP,
+  FIT_LOCAL_SESSION,
+  FIT_LOCAL_ACTIVITY
+};
+
+static const fit_field_t fit_file_id_fields[] = {
+  { 3, 4, FIT_UINT32Z },	// serial number
+  { 4, 4, FIT_UINT32 },		// time created
+  { 1, 2, FIT_UINT16 },		// manufacturer
+  { 2, 2, FIT_UINT16 },		// product
+  { 0, 1, FIT_ENUM },		// type
+};
+
+static const fit_field_t fit_course_fields[] = {
+  { 5, 16, FIT_STRING },	// name
+  { 4, 1, FIT_ENUM },		// sport
+};
+
+static const fit_field_t fit_event_fields[] = {
+  { 253, 4, FIT_UINT32 },	// timestamp
+  { 0, 1, FIT_ENUM },		// event
+  { 1, 1, FIT_ENUM },		// event type
+};
+
+static const fit_field_t fit_record_fields[] = {
+  { 253, 4, FIT_UINT32 },	// timestamp
+  { 0, 4, FIT_SINT32 },		// latitude
+  { 1, 4, FIT_SINT32 },		// longitude
+  { 5, 4, FIT_UINT32 },		// distance
+  { 2, 2, FIT_UINT16 },		// altitude
+  { 6, 2, FIT_UINT16 },		// speed
+  { 7, 2, FIT_UINT16 },		// power
+  { 3, 1, FIT_UINT8 },		// heart rate
+  { 4, 1, FIT_UINT8 },		// cadence
+  { 13, 1, FIT_SINT8 },		// temperature
+};
 
-// capabilities below means: we can only read and write waypoints
-// please change this depending on your new module
+static const fit_field_t fit_lap_fields[] = {
+  { 253, 4, FIT_UINT32 },	// timestamp
+  { 2, 4, FIT_UINT32 },		// start time
+  { 3, 4, FIT_SINT32 },		// start latitude
+  { 4, 4, FIT_SINT32 },		// start longitude
+  { 5, 4, FIT_SINT32 },		// end latitude
+  { 6, 4, FIT_SINT32 },		// end longitude
+  { 7, 4, FIT_UINT32 },		// total elapsed time
+  { 8, 4, FIT_UINT32 },		// total timer time
+  { 9, 4, FIT_UINT32 },		// total distance
+  { 0, 1, FIT_ENUM },		// event
+  { 1, 1, FIT_ENUM },		// event type
+};
+
+static const fit_field_t fit_session_fields[] = {
+  { 253, 4, FIT_UINT32 },	// timestamp
+  { 2, 4, FIT_UINT32 },		// start time
+  { 3, 4, FIT_SINT32 },		// start latitude
+  { 4, 4, FIT_SINT32 },		// start longitude
+  { 7, 4, FIT_UINT32 },		// total elapsed time
+  { 8, 4, FIT_UINT32 },		// total timer time
+  { 9, 4, FIT_UINT32 },		// total distance
+  { 25, 2, FIT_UINT16 },	// first lap index
+  { 26, 2, FIT_UINT16 },	// number of laps
+  { 0, 1, FIT_ENUM },		// event
+  { 1, 1, FIT_ENUM },		// event type
+  { 5, 1, FIT_ENUM },		// sport
+};
+
+static const fit_field_t fit_activity_fields[] = {
+  { 253, 4, FIT_UINT32 },	// timestamp
+  { 0, 4, FIT_UINT32 },		// total timer time
+  { 1, 2, FIT_UINT16 },		// number of sessions
+  { 2, 1, FIT_ENUM },		// type
+  { 3, 1, FIT_ENUM },		// event
+  { 4, 1, FIT_ENUM },		// event type
+};
+
+#define FIT_LAYOUT(global_id, fields) \
+  { global_id, sizeof(fields) / sizeof(fields[0]), fields }
+
+static const fit_layout_t fit_layout[] = {
+  FIT_LAYOUT(0, fit_file_id_fields),		// FIT_LOCAL_FILE_ID
+  FIT_LAYOUT(31, fit_course_fields),		// FIT_LOCAL_COURSE
+  FIT_LAYOUT(21, fit_event_fields),		// FIT_LOCAL_EVENT
+  FIT_LAYOUT(20, fit_record_fields),		// FIT_LOCAL_RECORD
+  FIT_LAYOUT(19, fit_lap_fields),		// FIT_LOCAL_LAP
+  FIT_LAYOUT(18, fit_session_fields),		// FIT_LOCAL_SESSION
+  FIT_LAYOUT(34, fit_activity_fields),		// FIT_LOCAL_ACTIVITY
+};
+
+typedef struct {
+  uint32_t start_time;
+  uint32_t end_time;
+  const Waypoint* first;
+  const Waypoint* last;
+  double distance;		/* meters */
+} fit_lap_t;
+
+static struct {
+  unsigned char* buf;
+  int len;
+  int size;
+  unsigned int defined;		/* local types whose definition is out */
+  int laps;
+  fit_lap_t lap;		/* the track being written */
+  fit_lap_t total;		/* all tracks so far */
+  const Waypoint* prev;
+  double distance;		/* meters, over all tracks */
+} fit_out;
+
+static uint16_t
+fit_crc16(uint16_t crc, const unsigned char* p, int len)
+{
+  static const uint16_t crc_table[16] = {
+    0x0000, 0xCC01, 0xD801, 0x1400, 0xF001, 0x3C00, 0x2800, 0xE401,
+    0xA001, 0x6C00, 0x7800, 0xB401, 0x5000, 0x9C01, 0x8801, 0x4400
+  };
+
+  while (len--) {
+    uint16_t tmp;
+
+    // compute checksum of lower four bits of byte
+    tmp = crc_table[crc & 0xf];
+    crc = (crc >> 4) & 0x0fff;
+    crc = crc ^ tmp ^ crc_table[*p & 0xf];
+    // now compute checksum of upper four bits of byte
+    tmp = crc_table[crc & 0xf];
+    crc = (crc >> 4) & 0x0fff;
+    crc = crc ^ tmp ^ crc_table[(*p >> 4) & 0xf];
+    p++;
+  }
+  return crc;
+}
+
+static void
+fit_put(const unsigned char* p, int len)
+{
+  if (fit_out.len + len > fit_out.size) {
+    while (fit_out.len + len > fit_out.size) {
+      fit_out.size *= 2;
+    }
+    fit_out.buf = (unsigned char*) xrealloc(fit_out.buf, fit_out.size);
+  }
+  memcpy(fit_out.buf + fit_out.len, p, len);
+  fit_out.len += len;
+}
+
+/*
+ * Encodes one data message of the given local type, preceded by its
+ * definition the first time.  val holds one value per field in layout
+ * order; the value of a string field is ignored and str is used instead.
+ */
+static void
+fit_write_message(int local_id, const uint32_t* val, const char* str)
+{
+  const fit_layout_t* layout = &fit_layout[local_id];
+  unsigned char msg[256];
+  unsigned char* p = msg;
+  int i;
+
+  if (!(fit_out.defined & (1 << local_id))) {
+    *p++ = 0x40 | local_id;
+    *p++ = 0;			// reserved
+    *p++ = 0;			// little endian
+    le_write16(p, layout->global_id);
+    p += 2;
+    *p++ = layout->num_fields;
+    for (i = 0; i < layout->num_fields; i++) {
+      *p++ = layout->fields[i].id;
+      *p++ = layout->fields[i].size;
+      *p++ = layout->fields[i].type;
+    }
+    fit_put(msg, p - msg);
+    fit_out.defined |= 1 << local_id;
+    p = msg;
+  }
+
+  *p++ = local_id;
+  for (i = 0; i < layout->num_fields; i++) {
+    const fit_field_t* f = &layout->fields[i];
+
+    if (f->type == FIT_STRING) {
+      memset(p, 0, f->size);
+      if (str) {
+        strncpy((char*) p, str, f->size - 1);
+      }
+    } else if (f->size == 4) {
+      le_write32(p, val[i]);
+    } else if (f->size == 2) {
+      le_write16(p, val[i]);
+    } else {
+      *p = val[i];
+    }
+    p += f->size;
+  }
+  fit_put(msg, p - msg);
+}
+
+static uint32_t
+fit_time(const Waypoint* wpt)
+{
+  if (wpt == NULL || !wpt->creation_time.isValid()) {
+    return FIT_INVALID_U32;
+  }
+  return wpt->GetCreationTime().toTime_t() - FIT_TIME_OFFSET;
+}
+
+static uint32_t
+fit_semicircles(double deg)
+{
+  int32_t sc = si_round(deg / 180.0 * 0x7fffffff);
+
+  /* +180 would come out as 0x7fffffff, which reads back as "no fix". */
+  if (sc == FIT_INVALID_S32) {
+    sc = FIT_INVALID_S32 - 1;
+  }
+  return sc;
+}
+
+static uint32_t
+fit_elapsed(const fit_lap_t* lap)
+{
+  if (lap->start_time == FIT_INVALID_U32 || lap->end_time == FIT_INVALID_U32) {
+    return FIT_INVALID_U32;
+  }
+  return (lap->end_time - lap->start_time) * 1000;
+}
+
+static void
+fit_write_event(uint32_t timestamp, int event_type)
+{
+  uint32_t val[] = {
+    timestamp,
+    0,				// timer
+    (uint32_t) event_type
+  };
+
+  fit_write_message(FIT_LOCAL_EVENT, val, NULL);
+}
+
+static void
+fit_write_lap(const fit_lap_t* lap)
+{
+  uint32_t val[] = {
+    lap->end_time,
+    lap->start_time,
+    fit_semicircles(lap->first->latitude),
+    fit_semicircles(lap->first->longitude),
+    fit_semicircles(lap->last->latitude),
+    fit_semicircles(lap->last->longitude),
+    fit_elapsed(lap),
+    fit_elapsed(lap),
+    (uint32_t) si_round(lap->distance * 100),
+    9,				// lap
+    1				// stop
+  };
+
+  fit_write_message(FIT_LOCAL_LAP, val, NULL);
+  fit_out.laps++;
+}
+
+/*
+ * Laps of courses precede their records, so the lap summary is collected
+ * before the track is written.
+ */
+static void
+fit_summarize_track(const route_head* trk, fit_lap_t* lap)
+{
+  const Waypoint* prev = NULL;
+  queue* elem, *tmp;
+
+  memset(lap, 0, sizeof(*lap));
+  lap->start_time = lap->end_time = FIT_INVALID_U32;
+  QUEUE_FOR_EACH(&trk->waypoint_list, elem, tmp) {
+    const Waypoint* wpt = (Waypoint*) elem;
+    uint32_t t = fit_time(wpt);
+
+    if (t != FIT_INVALID_U32) {
+      if (lap->start_time == FIT_INVALID_U32) {
+        lap->start_time = t;
+      }
+      lap->end_time = t;
+    }
+    if (prev) {
+      lap->distance += radtometers(gcdist(RAD(prev->latitude), RAD(prev->longitude),
+                                          RAD(wpt->latitude), RAD(wpt->longitude)));
+    } else {
+      lap->first = wpt;
+    }
+    lap->last = prev = wpt;
+  }
+}
+
+static void
+fit_write_track_head(const route_head* trk)
+{
+  fit_lap_t* lap = &fit_out.lap;
+
+  fit_summarize_track(trk, lap);
+  if (lap->first == NULL) {
+    return;
+  }
+  if (opt_course) {
+    if (fit_out.total.first == NULL) {
+      // the course is named after the first track
+      uint32_t val[] = {
+        0,
+        0			// generic
+      };
+      fit_write_message(FIT_LOCAL_COURSE, val, CSTR(trk->rte_name));
+    }
+    fit_write_lap(lap);
+  }
+  if (fit_out.total.first == NULL) {
+    fit_out.total = *lap;
+    fit_write_event(lap->start_time, 0);	// start
+  } else {
+    if (fit_out.total.start_time == FIT_INVALID_U32) {
+      fit_out.total.start_time = lap->start_time;
+    }
+    if (lap->end_time != FIT_INVALID_U32) {
+      fit_out.total.end_time = lap->end_time;
+    }
+    fit_out.total.last = lap->last;
+    fit_out.total.distance += lap->distance;
+  }
+  fit_out.prev = NULL;
+}
+
+static void
+fit_write_track_tail(const route_head*)
+{
+  if (fit_out.lap.first && !opt_course) {
+    fit_write_lap(&fit_out.lap);
+  }
+}
+
+static void
+fit_write_trkpt(const Waypoint* wpt)
+{
+  const waypt_ext* ext = wpt->ext;
+
+  if (fit_out.prev) {
+    fit_out.distance += radtometers(gcdist(RAD(fit_out.prev->latitude), RAD(fit_out.prev->longitude),
+                                           RAD(wpt->latitude), RAD(wpt->longitude)));
+  }
+  fit_out.prev = wpt;
+
+  uint32_t val[] = {
+    fit_time(wpt),
+    fit_semicircles(wpt->latitude),
+    fit_semicircles(wpt->longitude),
+    (uint32_t) si_round(fit_out.distance * 100),
+    FIT_INVALID_U16,
+    FIT_INVALID_U16,
+    FIT_INVALID_U16,
+    FIT_INVALID_U8,
+    FIT_INVALID_U8,
+    FIT_INVALID_S8
+  };
+
+  if (wpt->altitude != unknown_alt) {
+    double alt = (wpt->altitude + 500) * 5;
+    if (alt >= 0 && alt < FIT_INVALID_U16) {
+      val[4] = si_round(alt);
+    }
+  }
+  if (WAYPT_HAS(wpt, speed) && wpt->speed >= 0 && wpt->speed * 1000 < FIT_INVALID_U16) {
+    val[5] = si_round(wpt->speed * 1000);
+  }
+  if (ext->power > 0 && ext->power < FIT_INVALID_U16) {
+    val[6] = si_round(ext->power);
+  }
+  if (ext->heartrate) {
+    val[7] = ext->heartrate;
+  }
+  if (ext->cadence) {
+    val[8] = ext->cadence;
+  }
+  if (WAYPT_HAS(wpt, temperature) && ext->temperature > -128 && ext->temperature < FIT_INVALID_S8) {
+    val[9] = (uint8_t)(int8_t) si_round(ext->temperature);
+  }
+  fit_write_message(FIT_LOCAL_RECORD, val, NULL);
+}
+
+static void
+fit_wr_init(const char* fname)
+{
+  fout = gbfopen_le(fname, "wb", MYNAME);
+  memset(&fit_out, 0, sizeof(fit_out));
+  fit_out.size = 64 * 1024;
+  fit_out.buf = (unsigned char*) xmalloc(fit_out.size);
+}
+
+static void
+fit_wr_deinit(void)
+{
+  xfree(fit_out.buf);
+  fit_out.buf = NULL;
+  gbfclose(fout);
+}
+
+static void
+fit_write(void)
+{
+  const fit_lap_t* total = &fit_out.total;
+  unsigned char* hdr;
+  unsigned char crc[2];
+
+  // room for the header, filled in when the data size is known
+  fit_out.len = FIT_HEADER_SIZE;
+
+  {
+    uint32_t val[] = {
+      0,
+      gpsbabel_time ? (uint32_t)(gpsbabel_time - FIT_TIME_OFFSET) : FIT_INVALID_U32,
+      255,			// development
+      0,
+      opt_course ? 6u : 4u	// course or activity
+    };
+    fit_write_message(FIT_LOCAL_FILE_ID, val, NULL);
+  }
+
+  track_disp_all(fit_write_track_head, fit_write_track_tail, fit_write_trkpt);
+
+  if (total->first) {
+    fit_write_event(total->end_time, 4);	// stop all
+
+    if (!opt_course) {
+      uint32_t session[] = {
+        total->end_time,
+        total->start_time,
+        fit_semicircles(total->first->latitude),
+        fit_semicircles(total->first->longitude),
+        fit_elapsed(total),
+        fit_elapsed(total),
+        (uint32_t) si_round(total->distance * 100),
+        0,
+        (uint32_t) fit_out.laps,
+        8,			// session
+        1,			// stop
+        0			// generic
+      };
+      uint32_t activity[] = {
+        total->end_time,
+        fit_elapsed(total),
+        1,
+        0,			// manual
+        26,			// activity
+        1			// stop
+      };
+
+      fit_write_message(FIT_LOCAL_SESSION, session, NULL);
+      fit_write_message(FIT_LOCAL_ACTIVITY, activity, NULL);
+    }
+  }
+
+  hdr = fit_out.buf;
+  hdr[0] = FIT_HEADER_SIZE;
+  hdr[1] = 0x10;		// protocol version 1.0
+  le_write16(hdr + 2, FIT_PROFILE_VERSION);
+  le_write32(hdr + 4, fit_out.len - FIT_HEADER_SIZE);
+  memcpy(hdr + 8, ".FIT", 4);
+  le_write16(hdr + 12, fit_crc16(0, hdr, 12));
+
+  // the file CRC covers the header too, so it can only be run now
+  le_write16(crc, fit_crc16(0, fit_out.buf, fit_out.len));
+  gbfwrite(fit_out.buf, 1, fit_out.len, fout);
+  gbfwrite(crc, 1, 2, fout);
+}
+
+/**************************************************************************/
 
 ff_vecs_t format_fit_vecs = {
   ff_type_file,
   {
     ff_cap_none			/* waypoints */,
-    ff_cap_read 		/* tracks */,
+    (ff_cap)(ff_cap_read | ff_cap_write) 	/* tracks */,
     ff_cap_none 		/* routes */
   },
   fit_rd_init,
-  NULL,
+  fit_wr_init,
   fit_rd_deinit,
-  NULL,
+  fit_wr_deinit,
   fit_read,
-  NULL,
+  fit_write,
   NULL,
   fit_args,
   CET_CHARSET_ASCII, 0		/* ascii is the expected character set */
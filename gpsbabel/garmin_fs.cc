@@ -25,7 +25,7 @@
 #include "garmin_tables.h"
 #include "inifile.h"
 
-#include <QtCore/QXmlStreamWriter>
+#include "src/core/xmlstreamwriter.h"
 
 #define MYNAME "garmin_fs"
 
@@ -179,7 +179,7 @@ void garmin_fs_convert(void* fs)
 
 void
 garmin_fs_xml_fprint(const Waypoint* waypt,
-                     QXmlStreamWriter* writer)
+                     gpsbabel::XmlStreamWriter* writer)
 {
   const char* phone, *addr;
   garmin_fs_t* gmsd = GMSD_FIND(waypt);
@@ -216,13 +216,13 @@ garmin_fs_xml_fprint(const Waypoint* waypt,
     writer->writeNamespace("http://www.garmin.com/xmlschemas/GpxExtensions/v3",
                            "gpxx");
     if WAYPT_HAS(waypt, proximity) {
-      writer->writeTextElement("gpxx:Proximity", QString::number(waypt->proximity, 'f', 6));
+      writer->writeTextElement("gpxx:Proximity", QString::number(waypt->ext->proximity, 'f', 6));
     }
     if WAYPT_HAS(waypt, temperature) {
-      writer->writeTextElement("gpxx:Temperature",  QString::number(waypt->temperature, 'f', 6));
+      writer->writeTextElement("gpxx:Temperature",  QString::number(waypt->ext->temperature, 'f', 6));
     }
     if WAYPT_HAS(waypt, depth) {
-      writer->writeTextElement("gpxx:Depth", QString::number(waypt->depth, 'f', 6));
+      writer->writeTextElement("gpxx:Depth", QString::number(waypt->ext->depth, 'f', 6));
     }
     if (gmsd->flags.display) {
       const char* cx;
@@ -292,7 +292,7 @@ garmin_fs_xml_convert(const int base_tag, int tag, const QString& Qcdatastr, Way
   gmsd = GMSD_FIND(waypt);
   if (gmsd == NULL) {
     gmsd = garmin_fs_alloc(-1);
-    fs_chain_add(&waypt->fs, (format_specific_data*) gmsd);
+    fs_chain_add(&waypt->AllocExt()->fs, (format_specific_data*) gmsd);
   }
 
   tag -= base_tag;
@@ -417,7 +417,7 @@ garmin_fs_merge_category(const char* category_name, Waypoint* waypt)
 
   if (gmsd == NULL) {
     gmsd = garmin_fs_alloc(-1);
-    fs_chain_add(&waypt->fs, (format_specific_data*) gmsd);
+    fs_chain_add(&waypt->AllocExt()->fs, (format_specific_data*) gmsd);
   }
   GMSD_SET(category, cat);
   return 1;
@@ -429,7 +429,7 @@ garmin_fs_garmin_after_read(const GPS_PWay way, Waypoint* wpt, const int protoid
   garmin_fs_t* gmsd = NULL;
 
   gmsd = garmin_fs_alloc(protoid);
-  fs_chain_add(&wpt->fs, (format_specific_data*) gmsd);
+  fs_chain_add(&wpt->AllocExt()->fs, (format_specific_data*) gmsd);
 
   /* nothing happens until gmsd is allocated some lines above */
 
@@ -38,7 +38,7 @@
 
 /* macros */
 
-#define GMSD_FIND(a) (garmin_fs_t *) fs_chain_find((a)->fs, FS_GMSD)
+#define GMSD_FIND(a) (garmin_fs_t *) fs_chain_find((a)->ext->fs, FS_GMSD)
 #define GMSD_HAS(a) (gmsd && gmsd->flags.a)
 
 /* GMSD_GET(a,b): a = any gmsd field, b = default value */
@@ -125,8 +125,8 @@ char* garmin_fs_xstrdup(const char* src, size_t size);
 
 /* for GPX */
 void garmin_fs_xml_convert(const int base_tag, int tag, const QString& cdatastr, Waypoint* waypt);
-class QXmlStreamWriter;
-void garmin_fs_xml_fprint(const Waypoint* waypt, QXmlStreamWriter*);
+namespace gpsbabel { class XmlStreamWriter; }
+void garmin_fs_xml_fprint(const Waypoint* waypt, gpsbabel::XmlStreamWriter*);
 
 /* common garmin_fs utilities */
 
@@ -235,7 +235,7 @@ gpi_gmsd_init(Waypoint* wpt)
   }
   if (gmsd == NULL) {
     gmsd = garmin_fs_alloc(-1);
-    fs_chain_add(&wpt->fs, (format_specific_data*) gmsd);
+    fs_chain_add(&wpt->AllocExt()->fs, (format_specific_data*) gmsd);
   }
   return gmsd;
 }
@@ -394,7 +394,7 @@ read_poi(const int sz, const int tag)
   pos = gbftell(fin);
 
   wpt = new Waypoint;
-  wpt->icon_descr = DEFAULT_ICON;
+  wpt->AllocExt()->icon_descr = DEFAULT_ICON;
 
   wpt->latitude = GPS_Math_Semi_To_Deg(gbfgetint32(fin));
   wpt->longitude = GPS_Math_Semi_To_Deg(gbfgetint32(fin));
@@ -410,11 +410,11 @@ read_poi(const int sz, const int tag)
     }
   }
 
-  if (wpt->description.isEmpty() && !wpt->notes.isEmpty()) {
-    wpt->description = wpt->notes;
+  if (wpt->description.isEmpty() && !wpt->ext->notes.isEmpty()) {
+    wpt->description = wpt->ext->notes;
   }
-  if (wpt->notes.isEmpty() && !wpt->description.isEmpty()) {
-    wpt->notes = wpt->description;
+  if (wpt->ext->notes.isEmpty() && !wpt->description.isEmpty()) {
+    wpt->AllocExt()->notes = wpt->description;
   }
 
   waypt_add(wpt);
@@ -591,7 +591,7 @@ read_tag(const char* caller, const int tag, Waypoint* wpt)
     }
 
     if (!wpt->description.isEmpty()) {
-      wpt->notes = str;
+      wpt->AllocExt()->notes = str;
     } else {
       wpt->description = str;
     }
@@ -775,8 +775,8 @@ wdata_free(writer_data_t* data)
   QUEUE_FOR_EACH(&data->Q, elem, tmp) {
     Waypoint* wpt = (Waypoint*)elem;
 
-    if (wpt->extra_data) {
-      gpi_waypt_t* dt = (gpi_waypt_t*) wpt->extra_data;
+    if (wpt->ext->extra_data) {
+      gpi_waypt_t* dt = (gpi_waypt_t*) wpt->ext->extra_data;
       if (dt->addr_is_dynamic) {
         xfree(dt->addr);
       }
@@ -903,7 +903,7 @@ wdata_compute_size(writer_data_t* data)
     }
 
     dt = (gpi_waypt_t*) xcalloc(1, sizeof(*dt));
-    wpt->extra_data = dt;
+    wpt->AllocExt()->extra_data = dt;
 
     if (alerts) {
 #if NEW_STRINGS
@@ -940,7 +940,7 @@ wdata_compute_size(writer_data_t* data)
       }
 
       if ((WAYPT_HAS(wpt, speed) && (wpt->speed > 0)) ||
-          (WAYPT_HAS(wpt, proximity) && (wpt->proximity > 0))) {
+          (WAYPT_HAS(wpt, proximity) && (wpt->ext->proximity > 0))) {
         data->alert = 1;
         dt->alerts++;
         res += 20;		/* tag(3) */
@@ -953,8 +953,8 @@ wdata_compute_size(writer_data_t* data)
         str = xstrdup(wpt->description);
       }
     } else if (opt_notes) {
-      if (!wpt->notes.isEmpty()) {
-        str = xstrdup(wpt->notes);
+      if (!wpt->ext->notes.isEmpty()) {
+        str = xstrdup(wpt->ext->notes);
       }
     } else if (opt_pos) {
       str = pretty_deg_format(wpt->latitude, wpt->longitude, 's', " ", 0);
@@ -1003,7 +1003,7 @@ wdata_compute_size(writer_data_t* data)
 
     str = wpt->description;
     if (str.isEmpty()) {
-      str = wpt->notes;
+      str = wpt->ext->notes;
     }
 //		if (str && (strcmp(str, wpt->shortname) == 0)) str = NULL;
     if (!str.isEmpty()) {
@@ -1052,11 +1052,11 @@ wdata_write(const writer_data_t* data)
     QString str;
     int s0, s1;
     Waypoint* wpt = (Waypoint*)elem;
-    gpi_waypt_t* dt = (gpi_waypt_t*) wpt->extra_data;
+    gpi_waypt_t* dt = (gpi_waypt_t*) wpt->ext->extra_data;
 
     str = wpt->description;
     if (str.isEmpty()) {
-      str = wpt->notes;
+      str = wpt->ext->notes;
     }
 
     gbfputint32(0x80002, fout);
@@ -1094,8 +1094,8 @@ wdata_write(const writer_data_t* data)
       gbfputint32(3, fout);	/* tag(3) */
       gbfputint32(12, fout);	/* always 12 */
 
-      if (WAYPT_HAS(wpt, proximity) && (wpt->proximity > 0)) {
-        gbfputint16((int) wpt->proximity, fout);
+      if (WAYPT_HAS(wpt, proximity) && (wpt->ext->proximity > 0)) {
+        gbfputint16((int) wpt->ext->proximity, fout);
         flag = 4;
       } else {
         gbfputint16(0, fout);
@@ -1246,7 +1246,7 @@ enum_waypt_cb(const Waypoint* ref)
         (cmp->latitude == ref->latitude) &&
         (cmp->longitude == ref->longitude) &&
         (compare_strings(cmp->description, ref->description) == 0) &&
-        (compare_strings(cmp->notes, ref->notes) == 0)) {
+        (compare_strings(cmp->ext->notes, ref->ext->notes) == 0)) {
       return;
     }
   }
@@ -563,7 +563,7 @@ write_waypt(const Waypoint* wpt)
 
   gbfprintf(fout, "Waypoint\t%s\t", CSTRc(wpt->shortname));
   if (wpt_class <= gt_waypt_class_airport_ndb) {
-    QString temp = wpt->notes;
+    QString temp = wpt->ext->notes;
     if (temp.isEmpty()) {
       if (wpt->description != wpt->shortname) {
         temp = wpt->description;
@@ -606,7 +606,7 @@ write_waypt(const Waypoint* wpt)
 
   icon = GMSD_GET(icon, -1);
   if (icon == -1) {
-    icon = gt_find_icon_number_from_desc(wpt->icon_descr, GDB);
+    icon = gt_find_icon_number_from_desc(wpt->ext->icon_descr, GDB);
   }
   print_string("%s\t", gt_find_desc_from_icon_number(icon, GDB));
 
@@ -1117,7 +1117,7 @@ parse_waypoint(void)
 
   wpt = new Waypoint;
   gmsd = garmin_fs_alloc(-1);
-  fs_chain_add(&wpt->fs, (format_specific_data*) gmsd);
+  fs_chain_add(&wpt->AllocExt()->fs, (format_specific_data*) gmsd);
 
   while ((str = csv_lineparse(NULL, "\t", "", column++))) {
     int i;
@@ -1129,7 +1129,7 @@ parse_waypoint(void)
       wpt->shortname = DUPSTR(str);
       break;
     case  2:
-      wpt->notes = DUPSTR(str);
+      wpt->AllocExt()->notes = DUPSTR(str);
       break;
     case  3:
       for (i = 0; i <= gt_waypt_class_map_line; i++) {
@@ -1173,7 +1173,7 @@ parse_waypoint(void)
     case 11:
       i = gt_find_icon_number_from_desc(str, GDB);
       GMSD_SET(icon, i);
-      wpt->icon_descr = gt_find_desc_from_icon_number(i, GDB);
+      wpt->AllocExt()->icon_descr = intern(gt_find_desc_from_icon_number(i, GDB));
       break;
     case 12:
       GMSD_SETSTR(facility, str);
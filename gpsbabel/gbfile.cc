@@ -23,6 +23,18 @@
 #include "defs.h"
 #include "gbfile.h"
 
+#include <QtCore/QByteArray>
+#include <QtCore/QDateTime>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMap>
+#include <QtCore/QMutex>
+#include <QtCore/QQueue>
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+#include <QtCore/QWaitCondition>
+
 #include <assert.h>
 #include <ctype.h>
 #include <stdarg.h>
@@ -42,6 +54,9 @@
 #define MYNAME "gbfile"
 #define NO_ZLIB MYNAME ": No zlib support.\n"
 
+/* Writes are collected here before they reach the file api. */
+#define GBFILE_WBUF_SIZE (64 * 1024)
+
 /* About the ZLIB_INHIBITED stuff:
  *
  * If a user goes out of his way to build with ZLIB_INHIBITED set,
@@ -245,6 +260,821 @@ gzapi_error(gbfile* self)
 
   return errnum;
 }
+
+static void
+gzapi_setup(gbfile* file)
+{
+  file->fileclearerr = gzapi_clearerr;
+  file->fileclose = gzapi_close;
+  file->fileeof = gzapi_eof;
+  file->fileerror = gzapi_error;
+  file->fileflush = gzapi_flush;
+  file->fileopen = gzapi_open;
+  file->fileread = gzapi_read;
+  file->fileseek = gzapi_seek;
+  file->filetell = gzapi_tell;
+  file->fileungetc = gzapi_ungetc;
+  file->filewrite = gzapi_write;
+}
+
+/*******************************************************************************/
+/* %%%                Seekable gzip input (gzrapi)                          %%% */
+/*******************************************************************************/
+
+/*
+ * gzseek can only move forward through compressed input; any seek back,
+ * and so every rewind, inflates again from the start of the file.  Here
+ * the inflate state is captured at a block boundary about every
+ * GZR_SPAN bytes of output, as in zlib's examples/zran.c, and a seek
+ * resumes from the last capture before its target.  The start of each
+ * gzip member is a capture that needs no history.  With -Z the captures
+ * are saved beside the input (foo.gz -> foo.gzi) and reused by later runs
+ * as long as the input's size and time are unchanged.
+ *
+ * Input that isn't gzip compressed, and pipes, still go through gzapi.
+ */
+
+#define GZR_SPAN (1024 * 1024)	/* output between checkpoints */
+#define GZR_WINSIZE 32768	/* deflate history */
+#define GZR_CHUNK 16384		/* compressed input read at once */
+#define GZR_INDEX_MAGIC "GBGZI\r\n\001"
+
+typedef struct {
+  gbsize_t out;			/* uncompressed offset */
+  long long in;			/* compressed offset of the next whole byte */
+  int bits;			/* bits used of the byte before in, -1 at a member start */
+  QByteArray window;		/* history, empty at a member start */
+} gzr_point_t;
+
+typedef struct gzreader_s {
+  FILE* in;
+  z_stream zs;
+  int raw;			/* in a raw deflate stream resumed from a checkpoint */
+  int eof;			/* no output left */
+  long long in_end;		/* compressed offset just past what was read */
+  unsigned char input[GZR_CHUNK];
+  unsigned char out[GZR_WINSIZE];	/* output, which is also the history */
+  unsigned int have;		/* bytes of out[] filled */
+  unsigned int next;		/* next byte of out[] to hand out */
+  int wrapped;			/* out[] has been filled at least once */
+  gbsize_t total;		/* uncompressed offset of out[have] */
+  QVector<gzr_point_t> points;	/* ascending; points[0] is the file start */
+  int dirty;			/* points were added after the index was loaded */
+} gzreader_t;
+
+static QString
+gzr_index_name(const gbfile* self)
+{
+  QString name = QString::fromUtf8(self->name);
+
+  if (name.endsWith(".gz", Qt::CaseInsensitive)) {
+    return name + "i";
+  }
+  return name + ".gzi";
+}
+
+static void
+gzr_load_index(gbfile* self)
+{
+  gzreader_t* r = self->handle.gzr;
+  QFileInfo info(QString::fromUtf8(self->name));
+  QFile file(gzr_index_name(self));
+  QVector<gzr_point_t> points;
+  QByteArray data;
+  const char* p;
+  const char* end;
+  unsigned int count;
+
+  if (!file.open(QIODevice::ReadOnly)) {
+    return;
+  }
+  data = file.readAll();
+  p = data.constData();
+  end = p + data.size();
+  if ((data.size() < 24) || (memcmp(p, GZR_INDEX_MAGIC, 8) != 0) ||
+      ((unsigned int) le_read32(p + 8) != (unsigned int) info.size()) ||
+      ((unsigned int) le_read32(p + 12) != (unsigned int) info.lastModified().toTime_t())) {
+    return;
+  }
+  count = le_read32(p + 16);
+  p += 24;
+  while (count--) {
+    gzr_point_t point;
+    unsigned int len;
+
+    if (end - p < 20) {
+      return;
+    }
+    point.out = le_read32(p);
+    point.in = (long long) le_read32(p + 4) | ((long long) le_read32(p + 8) << 32);
+    point.bits = le_read32(p + 12);
+    len = le_read32(p + 16);
+    p += 20;
+    if ((len > GZR_WINSIZE) || ((unsigned int)(end - p) < len) ||
+        (point.bits < -1) || (point.bits > 7) ||
+        (!points.isEmpty() && (point.out <= points.last().out))) {
+      return;
+    }
+    point.window = QByteArray(p, len);
+    p += len;
+    points.append(point);
+  }
+  if (!points.isEmpty() && (points[0].out == 0)) {
+    r->points = points;
+  }
+}
+
+static void
+gzr_save_index(gbfile* self)
+{
+  gzreader_t* r = self->handle.gzr;
+  QFileInfo info(QString::fromUtf8(self->name));
+  QFile file(gzr_index_name(self));
+  QByteArray data;
+  char buf[24];
+
+  memcpy(buf, GZR_INDEX_MAGIC, 8);
+  le_write32(buf + 8, info.size());
+  le_write32(buf + 12, info.lastModified().toTime_t());
+  le_write32(buf + 16, r->points.size());
+  le_write32(buf + 20, 0);
+  data.append(buf, 24);
+  for (int i = 0; i < r->points.size(); i++) {
+    const gzr_point_t& point = r->points.at(i);
+
+    le_write32(buf, point.out);
+    le_write32(buf + 4, point.in & 0xffffffff);
+    le_write32(buf + 8, point.in >> 32);
+    le_write32(buf + 12, point.bits);
+    le_write32(buf + 16, point.window.size());
+    data.append(buf, 20);
+    data.append(point.window);
+  }
+
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+      (file.write(data) != data.size())) {
+    if (global_opts.debug_level > 0) {
+      warning("%s: Could not write the index of '%s'.\n", self->module, self->name);
+    }
+  }
+}
+
+/* Makes at least need bytes of compressed input available, if there are. */
+static void
+gzr_fill(gbfile* self, unsigned int need)
+{
+  gzreader_t* r = self->handle.gzr;
+
+  if (r->zs.avail_in >= need) {
+    return;
+  }
+  if (r->zs.avail_in) {
+    memmove(r->input, r->zs.next_in, r->zs.avail_in);
+  }
+  r->zs.next_in = r->input;
+  while (r->zs.avail_in < need) {
+    size_t n = fread(r->input + r->zs.avail_in, 1, GZR_CHUNK - r->zs.avail_in, r->in);
+    if (n == 0) {
+      if (ferror(r->in)) {
+        fatal("%s: Error occured during read of file '%s'!\n", self->module, self->name);
+      }
+      break;
+    }
+    r->zs.avail_in += n;
+    r->in_end += n;
+  }
+}
+
+static void
+gzr_add_point(gzreader_t* r, int bits)
+{
+  gzr_point_t point;
+
+  point.out = r->total;
+  point.in = r->in_end - r->zs.avail_in;
+  point.bits = bits;
+  if (bits >= 0) {
+    if (r->wrapped) {
+      point.window.reserve(GZR_WINSIZE);
+      point.window.append((const char*) r->out + r->have, GZR_WINSIZE - r->have);
+    }
+    point.window.append((const char*) r->out, r->have);
+  }
+  r->points.append(point);
+  r->dirty = 1;
+}
+
+static void
+gzr_restore(gbfile* self, const gzr_point_t& point)
+{
+  gzreader_t* r = self->handle.gzr;
+  long long at = point.in - (point.bits > 0 ? 1 : 0);
+
+  if (fseek(r->in, (long) at, SEEK_SET) != 0) {
+    fatal("%s: Unable to set file (%s) to position (%lld)!\n",
+          self->module, self->name, at);
+  }
+  r->in_end = at;
+  r->zs.next_in = r->input;
+  r->zs.avail_in = 0;
+  if (point.bits < 0) {
+    inflateReset2(&r->zs, MAX_WBITS + 16);
+    r->raw = 0;
+  } else {
+    inflateReset2(&r->zs, -MAX_WBITS);
+    r->raw = 1;
+    if (point.bits) {
+      int c = getc(r->in);
+      if (c == EOF) {
+        fatal("%s: Unexpected end of file (EOF)!\n", self->module);
+      }
+      r->in_end++;
+      inflatePrime(&r->zs, point.bits, c >> (8 - point.bits));
+    }
+    inflateSetDictionary(&r->zs, (const Bytef*) point.window.constData(), point.window.size());
+  }
+  r->have = r->next = 0;
+  r->wrapped = 0;
+  r->total = point.out;
+  r->eof = 0;
+}
+
+/* A gzip member ended; continue with the next one, if any. */
+static void
+gzr_member_end(gbfile* self)
+{
+  gzreader_t* r = self->handle.gzr;
+
+  if (r->raw) {
+    /* zlib didn't see the header, so it leaves the trailer to us */
+    gzr_fill(self, 8);
+    if (r->zs.avail_in < 8) {
+      r->eof = 1;
+      return;
+    }
+    r->zs.next_in += 8;
+    r->zs.avail_in -= 8;
+  }
+  /* anything but another member is ignored, as gzread does */
+  gzr_fill(self, 2);
+  if ((r->zs.avail_in < 2) || (r->zs.next_in[0] != 0x1f) || (r->zs.next_in[1] != 0x8b)) {
+    r->eof = 1;
+    return;
+  }
+  inflateReset2(&r->zs, MAX_WBITS + 16);
+  r->raw = 0;
+  if (r->total >= r->points.last().out + GZR_SPAN) {
+    gzr_add_point(r, -1);
+  }
+}
+
+/*
+ * Inflates more output into out[] once all of it has been handed out.
+ * Returns the number of new bytes, 0 at the end of the data.
+ */
+static unsigned int
+gzr_produce(gbfile* self)
+{
+  gzreader_t* r = self->handle.gzr;
+
+  assert(r->next == r->have);
+  while (!r->eof) {
+    unsigned int n;
+    int ret;
+
+    if (r->have == GZR_WINSIZE) {
+      r->have = r->next = 0;
+      r->wrapped = 1;
+    }
+    gzr_fill(self, 1);
+    if (r->zs.avail_in == 0) {
+      fatal("%s: zlib returned error %d ('%s')!\n",
+            self->module, Z_BUF_ERROR, "unexpected end of file");
+    }
+    r->zs.next_out = r->out + r->have;
+    r->zs.avail_out = GZR_WINSIZE - r->have;
+    ret = inflate(&r->zs, Z_BLOCK);
+    if ((ret != Z_OK) && (ret != Z_STREAM_END)) {
+      fatal("%s: zlib returned error %d ('%s')!\n",
+            self->module, ret, r->zs.msg ? r->zs.msg : "");
+    }
+    n = (GZR_WINSIZE - r->have) - r->zs.avail_out;
+    r->have += n;
+    r->total += n;
+
+    if (ret == Z_STREAM_END) {
+      gzr_member_end(self);
+    } else if ((r->zs.data_type & 128) && !(r->zs.data_type & 64) &&
+               (r->total >= r->points.last().out + GZR_SPAN)) {
+      /* at a block boundary, other than after the last block */
+      gzr_add_point(r, r->zs.data_type & 7);
+    }
+    if (n) {
+      return n;
+    }
+  }
+  return 0;
+}
+
+static gbfile*
+gzrapi_open(gbfile* self, const char* mode)
+{
+  gzreader_t* r;
+  gzr_point_t start;
+  unsigned char magic[2];
+  FILE* in;
+
+  in = xfopen(self->name, "rb", self->module);
+  if ((fread(magic, 1, 2, in) != 2) || (magic[0] != 0x1f) || (magic[1] != 0x8b)) {
+    /* plain (or empty) input; zlib reads that transparently */
+    fclose(in);
+    gzapi_setup(self);
+    return gzapi_open(self, mode);
+  }
+  rewind(in);
+
+  r = new gzreader_t;
+  r->in = in;
+  memset(&r->zs, 0, sizeof(r->zs));
+  if (inflateInit2(&r->zs, MAX_WBITS + 16) != Z_OK) {
+    fatal(MYNAME ": zlib inflateInit2 failed!\n");
+  }
+  r->zs.next_in = r->input;
+  r->zs.avail_in = 0;
+  r->raw = 0;
+  r->eof = 0;
+  r->in_end = 0;
+  r->have = r->next = 0;
+  r->wrapped = 0;
+  r->total = 0;
+  r->dirty = 0;
+  start.out = 0;
+  start.in = 0;
+  start.bits = -1;
+  r->points.append(start);
+  self->gzapi = 1;
+  self->handle.gzr = r;
+
+  if (global_opts.gzindex) {
+    gzr_load_index(self);
+  }
+  return self;
+}
+
+static int
+gzrapi_close(gbfile* self)
+{
+  gzreader_t* r = self->handle.gzr;
+  int result;
+
+  if (global_opts.gzindex && r->dirty) {
+    gzr_save_index(self);
+  }
+  inflateEnd(&r->zs);
+  result = fclose(r->in);
+  delete r;
+  self->handle.gzr = NULL;
+
+  return result;
+}
+
+static gbsize_t
+gzrapi_read(void* buf, const gbsize_t size, const gbsize_t members, gbfile* self)
+{
+  gzreader_t* r = self->handle.gzr;
+  char* target = (char*) buf;
+  gbsize_t count = size * members;
+  gbsize_t done = 0;
+
+  while (done < count) {
+    gbsize_t n = r->have - r->next;
+
+    if (n == 0) {
+      if (gzr_produce(self) == 0) {
+        break;
+      }
+      continue;
+    }
+    if (n > count - done) {
+      n = count - done;
+    }
+    memcpy(target + done, r->out + r->next, n);
+    r->next += n;
+    done += n;
+  }
+
+  /* Check for an incomplete READ */
+  if ((members == 1) && (size > 1) && (done > 0) && (done < size)) {
+    fatal("%s: Unexpected end of file (EOF)!\n", self->module);
+  }
+  return done / size;
+}
+
+static gbsize_t
+gzrapi_tell(gbfile* self)
+{
+  gzreader_t* r = self->handle.gzr;
+
+  return r->total - (r->have - r->next);
+}
+
+static int
+gzrapi_seek(gbfile* self, int32_t offset, int whence)
+{
+  gzreader_t* r = self->handle.gzr;
+  gbsize_t pos = gzrapi_tell(self);
+  long long target;
+  int lo, hi;
+
+  assert(whence != SEEK_END);
+
+  target = (whence == SEEK_SET) ? offset : (long long) pos + offset;
+  if (target < 0) {
+    fatal("%s: Unable to set file (%s) to position (%lld)!\n",
+          self->module, self->name, target);
+  }
+
+  /* still in out[] */
+  if ((target >= (long long)(r->total - r->have)) && (target <= (long long) r->total)) {
+    r->next = target - (r->total - r->have);
+    return 0;
+  }
+
+  /* the last checkpoint at or before the target */
+  lo = 0;
+  hi = r->points.size() - 1;
+  while (lo < hi) {
+    int mid = (lo + hi + 1) / 2;
+    if ((long long) r->points.at(mid).out <= target) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  if ((target < (long long) pos) || (r->points.at(lo).out > pos)) {
+    gzr_restore(self, r->points.at(lo));
+  }
+
+  /* and inflate from there */
+  r->next = r->have;
+  while ((long long) r->total < target) {
+    if (gzr_produce(self) == 0) {
+      break;
+    }
+    r->next = r->have;
+  }
+  if ((long long) r->total > target) {
+    r->next = r->have - (r->total - target);
+  }
+  return 0;
+}
+
+static int
+gzrapi_eof(gbfile* self)
+{
+  gzreader_t* r = self->handle.gzr;
+
+  if (r->next < r->have) {
+    return 0;
+  }
+  return gzr_produce(self) == 0;
+}
+
+static int
+gzrapi_ungetc(const int c, gbfile* self)
+{
+  gzreader_t* r = self->handle.gzr;
+
+  if (r->next == 0) {
+    fatal(MYNAME ": Cannot store more than one byte back!\n");
+  }
+  r->out[--r->next] = c;
+  return c;
+}
+
+static gbsize_t
+gzrapi_write(const void* buf, const gbsize_t size, const gbsize_t members, gbfile* self)
+{
+  (void)buf;
+  (void)size;
+  (void)members;
+  fatal("%s: Cannot write to input file '%s'!\n", self->module, self->name);
+  return 0;
+}
+
+static int
+gzrapi_flush(gbfile* self)
+{
+  (void)self;
+  return 0;
+}
+
+static void
+gzrapi_clearerr(gbfile* self)
+{
+  clearerr(self->handle.gzr->in);
+}
+
+static int
+gzrapi_error(gbfile* self)
+{
+  return ferror(self->handle.gzr->in);
+}
+
+/*******************************************************************************/
+/* %%%                  Block-parallel gzip output (gzwapi)                 %%% */
+/*******************************************************************************/
+
+/*
+ * Output is cut into independent blocks that are deflated on a thread
+ * pool, each into a complete gzip member, and written in order.  A gzip
+ * file may consist of several members (RFC 1952), so gunzip and gzread
+ * see one stream.  Output smaller than a block is a single member
+ * identical to what gzwrite produces.  The bytes written don't depend on
+ * the number of threads.
+ */
+
+#define GZW_BLOCK_SIZE (256 * 1024)
+
+class GzwJob : public QRunnable
+{
+public:
+  GzwJob(struct gzwriter_s* w, const QByteArray& in) :
+    writer(w), input(in), done(false)
+  {
+    setAutoDelete(false);
+  }
+  void run();
+
+  struct gzwriter_s* writer;
+  QByteArray input;
+  QByteArray output;
+  bool done;
+};
+
+typedef struct gzwriter_s {
+  FILE* out;
+  int level;
+  int threads;
+  QByteArray block;		/* uncompressed data not yet submitted */
+  gbsize_t pos;			/* uncompressed bytes written so far */
+  int members;			/* gzip members written */
+  QThreadPool* pool;
+  QQueue<GzwJob*> jobs;	/* in submission order */
+  QMutex lock;
+  QWaitCondition finished;
+} gzwriter_t;
+
+static QByteArray
+gzw_deflate(const QByteArray& input, int level)
+{
+  z_stream zs;
+  QByteArray output;
+
+  memset(&zs, 0, sizeof(zs));
+  if (deflateInit2(&zs, level, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    fatal(MYNAME ": zlib deflateInit2 failed!\n");
+  }
+  output.resize(deflateBound(&zs, input.size()));
+  zs.next_in = (Bytef*) input.constData();
+  zs.avail_in = input.size();
+  zs.next_out = (Bytef*) output.data();
+  zs.avail_out = output.size();
+  if (deflate(&zs, Z_FINISH) != Z_STREAM_END) {
+    fatal(MYNAME ": zlib deflate failed!\n");
+  }
+  output.resize(zs.total_out);
+  deflateEnd(&zs);
+
+  return output;
+}
+
+void
+GzwJob::run()
+{
+  QByteArray result = gzw_deflate(input, writer->level);
+
+  QMutexLocker locker(&writer->lock);
+  output = result;
+  input = QByteArray();
+  done = true;
+  writer->finished.wakeAll();
+}
+
+static void
+gzwapi_emit(gbfile* self, const QByteArray& member)
+{
+  gzwriter_t* w = self->handle.gzw;
+
+  if (fwrite(member.constData(), 1, member.size(), w->out) != (size_t) member.size()) {
+    fatal("%s: Could not write to %s!\n", self->module, self->name);
+  }
+  w->members++;
+}
+
+/*
+ * Write out finished members from the head of the queue.  Blocks only
+ * while more than keep jobs are queued, or until the queue is empty
+ * when all is set.
+ */
+static void
+gzwapi_drain(gbfile* self, int all, int keep)
+{
+  gzwriter_t* w = self->handle.gzw;
+
+  while (!w->jobs.isEmpty()) {
+    GzwJob* job = w->jobs.head();
+    {
+      QMutexLocker locker(&w->lock);
+      if (!job->done && !all && (w->jobs.size() <= keep)) {
+        break;
+      }
+      while (!job->done) {
+        w->finished.wait(&w->lock);
+      }
+    }
+    w->jobs.dequeue();
+    gzwapi_emit(self, job->output);
+    delete job;
+  }
+}
+
+static void
+gzwapi_submit(gbfile* self)
+{
+  gzwriter_t* w = self->handle.gzw;
+
+  if (w->threads <= 1) {
+    gzwapi_emit(self, gzw_deflate(w->block, w->level));
+  } else {
+    GzwJob* job = new GzwJob(w, w->block);
+    w->jobs.enqueue(job);
+    w->pool->start(job);
+    /* Bound the memory held by blocks in flight. */
+    gzwapi_drain(self, 0, 2 * w->threads);
+  }
+  w->block.clear();
+  w->block.reserve(GZW_BLOCK_SIZE);
+}
+
+static gbfile*
+gzwapi_open(gbfile* self, const char* mode)
+{
+  gzwriter_t* w = new gzwriter_t;
+
+  (void)mode;
+  self->gzapi = 1;
+
+  if (self->is_pipe) {
+    w->out = stdout;
+    SET_BINARY_MODE(w->out);
+  } else {
+    w->out = xfopen(self->name, "wb", self->module);
+  }
+  w->level = global_opts.gzlevel;
+  w->threads = route_threads();
+  w->pos = 0;
+  w->members = 0;
+  w->block.reserve(GZW_BLOCK_SIZE);
+  w->pool = NULL;
+  if (w->threads > 1) {
+    w->pool = new QThreadPool;
+    w->pool->setMaxThreadCount(w->threads);
+  }
+  self->handle.gzw = w;
+
+  return self;
+}
+
+static gbsize_t
+gzwapi_write(const void* buf, const gbsize_t size, const gbsize_t members, gbfile* self)
+{
+  gzwriter_t* w = self->handle.gzw;
+  const char* p = (const char*) buf;
+  gbsize_t len = size * members;
+
+  w->pos += len;
+  while (len > 0) {
+    gbsize_t n = GZW_BLOCK_SIZE - w->block.size();
+    if (n > len) {
+      n = len;
+    }
+    w->block.append(p, n);
+    p += n;
+    len -= n;
+    if (w->block.size() == GZW_BLOCK_SIZE) {
+      gzwapi_submit(self);
+    }
+  }
+  return members;
+}
+
+/* Everything written so far becomes readable; the stream stays open. */
+static int
+gzwapi_flush(gbfile* self)
+{
+  gzwriter_t* w = self->handle.gzw;
+
+  if (!w->block.isEmpty()) {
+    gzwapi_submit(self);
+  }
+  gzwapi_drain(self, 1, 0);
+  return fflush(w->out);
+}
+
+static int
+gzwapi_close(gbfile* self)
+{
+  gzwriter_t* w = self->handle.gzw;
+  int result;
+
+  /* Even an empty file is a valid gzip stream. */
+  if (!w->block.isEmpty() || (w->members == 0 && w->jobs.isEmpty())) {
+    gzwapi_submit(self);
+  }
+  gzwapi_drain(self, 1, 0);
+  delete w->pool;
+
+  if (self->is_pipe) {
+    result = fflush(w->out);
+  } else {
+    result = fclose(w->out);
+  }
+  delete w;
+  self->handle.gzw = NULL;
+
+  return result;
+}
+
+static gbsize_t
+gzwapi_tell(gbfile* self)
+{
+  return self->handle.gzw->pos;
+}
+
+/* Like gzseek on output: only forward, by writing zeros. */
+static int
+gzwapi_seek(gbfile* self, int32_t offset, int whence)
+{
+  gzwriter_t* w = self->handle.gzw;
+  long long target;
+
+  assert(whence != SEEK_END);
+
+  target = (whence == SEEK_SET) ? offset : (long long) w->pos + offset;
+  if (target < (long long) w->pos) {
+    if (self->is_pipe) {
+      fatal("%s: This format cannot be used in piped commands!\n", self->module);
+    }
+    fatal("%s: online compression not yet supported for this format!", self->module);
+  }
+  while ((long long) w->pos < target) {
+    static const char zeros[1024] = { 0 };
+    long long n = target - w->pos;
+    if (n > (long long) sizeof(zeros)) {
+      n = sizeof(zeros);
+    }
+    gzwapi_write(zeros, 1, n, self);
+  }
+  return 0;
+}
+
+static gbsize_t
+gzwapi_read(void* buf, const gbsize_t size, const gbsize_t members, gbfile* self)
+{
+  (void)buf;
+  (void)size;
+  (void)members;
+  fatal("%s: Cannot read from output file '%s'!\n", self->module, self->name);
+  return 0;
+}
+
+static int
+gzwapi_eof(gbfile* self)
+{
+  (void)self;
+  return 0;
+}
+
+static int
+gzwapi_ungetc(const int c, gbfile* self)
+{
+  (void)c;
+  fatal("%s: Cannot read from output file '%s'!\n", self->module, self->name);
+  return EOF;
+}
+
+static void
+gzwapi_clearerr(gbfile* self)
+{
+  clearerr(self->handle.gzw->out);
+}
+
+static int
+gzwapi_error(gbfile* self)
+{
+  return ferror(self->handle.gzw->out);
+}
 #endif	// #if !ZLIB_INHIBITED
 
 
@@ -355,6 +1185,53 @@ stdapi_error(gbfile* self)
 /* %%%                     Memory stream (memapi)                          %%% */
 /*******************************************************************************/
 
+typedef struct {
+  QByteArray data;
+  int opens;
+} gbfmem_t;
+
+static QMap<QString, gbfmem_t> gbfmem_files;
+
+void
+gbfmem_bind(const char* name, const QByteArray& data)
+{
+  gbfmem_t& mem = gbfmem_files[QString::fromUtf8(name)];
+  mem.data = data;
+  mem.opens = 0;
+}
+
+QByteArray*
+gbfmem_open(const char* name)
+{
+  QString key = QString::fromUtf8(name);
+
+  if (!gbfmem_files.contains(key)) {
+    return NULL;
+  }
+  gbfmem_t& mem = gbfmem_files[key];
+  mem.opens++;
+  return &mem.data;
+}
+
+int
+gbfmem_take(const char* name, QByteArray* data)
+{
+  QString key = QString::fromUtf8(name);
+
+  if (!gbfmem_files.contains(key)) {
+    return 0;
+  }
+  gbfmem_t mem = gbfmem_files.take(key);
+  *data = mem.data;
+  return mem.opens;
+}
+
+void
+gbfmem_clear(void)
+{
+  gbfmem_files.clear();
+}
+
 static gbfile*
 memapi_open(gbfile* self, const char* mode)
 {
@@ -364,12 +1241,26 @@ memapi_open(gbfile* self, const char* mode)
   self->memsz = 0;
   self->handle.mem = NULL;
 
+  /* Bound files are read in place; writes go to our own buffer. */
+  if (self->memfile && (self->mode == 'r')) {
+    self->handle.mem = (unsigned char*) self->memfile->data();
+    self->memlen = self->memfile->size();
+    self->memsz = self->memlen;
+  }
+
   return self;
 }
 
 static int
 memapi_close(gbfile* self)
 {
+  if (self->memfile) {
+    if (self->mode == 'w') {
+      *self->memfile = QByteArray((const char*) self->handle.mem, self->memlen);
+    } else {
+      return 0;
+    }
+  }
   if (self->handle.mem) {
     xfree(self->handle.mem);
   }
@@ -428,6 +1319,10 @@ memapi_write(const void* buf, const gbsize_t size, const gbsize_t members, gbfil
     return 0;
   }
 
+  if (self->memfile && (self->mode != 'w')) {
+    fatal("%s: Cannot write to %s.\n", self->module, self->name);
+  }
+
   count = size * members;
 
   if (self->mempos + count > self->memsz) {
@@ -491,6 +1386,29 @@ memapi_error(gbfile* self)
 
 /* GPSBabel 'file' standard calls */
 
+/*
+ * gbfile_drain: hand the coalesced writes to the file api
+ */
+
+static void
+gbfile_drain(gbfile* file)
+{
+  gbsize_t result;
+
+  if (!file->wbuflen) {
+    return;
+  }
+  result = file->filewrite(file->wbuf, 1, file->wbuflen, file);
+  if (result != file->wbuflen) {
+    fatal("%s: Could not write %lld bytes to %s (result %d)!\n",
+          file->module,
+          (long long int)(file->wbuflen - result),
+          file->name,
+          result);
+  }
+  file->wbuflen = 0;
+}
+
 /*
  * gbfopen: (as xfopen) plus the name of the calling GPSBabel module (MYNAME)
  */
@@ -508,7 +1426,8 @@ gbfopen(const char* filename, const char* mode, const char* module)
   file->mode = 'r'; // default
   file->binary = (strchr(mode, 'b') != NULL);
   file->back = -1;
-  file->memapi = (filename == NULL);
+  file->memfile = filename ? gbfmem_open(filename) : NULL;
+  file->memapi = (filename == NULL) || (file->memfile != NULL);
 
   for (m = mode; *m; m++) {
     switch (tolower(*m)) {
@@ -526,7 +1445,7 @@ gbfopen(const char* filename, const char* mode, const char* module)
 
   if (file->memapi) {
     file->gzapi = 0;
-    file->name = xstrdup("(Memory stream)");
+    file->name = xstrdup(filename ? filename : "(Memory stream)");
 
     file->fileclearerr = memapi_clearerr;
     file->fileclose = memapi_close;
@@ -554,20 +1473,37 @@ gbfopen(const char* filename, const char* mode, const char* module)
 #endif
     }
 
-    if (file->gzapi) {
+    if (file->gzapi && (file->mode == 'w')) {
 #if !ZLIB_INHIBITED
-
-      file->fileclearerr = gzapi_clearerr;
-      file->fileclose = gzapi_close;
-      file->fileeof = gzapi_eof;
-      file->fileerror = gzapi_error;
-      file->fileflush = gzapi_flush;
-      file->fileopen = gzapi_open;
-      file->fileread = gzapi_read;
-      file->fileseek = gzapi_seek;
-      file->filetell = gzapi_tell;
-      file->fileungetc = gzapi_ungetc;
-      file->filewrite = gzapi_write;
+      file->fileclearerr = gzwapi_clearerr;
+      file->fileclose = gzwapi_close;
+      file->fileeof = gzwapi_eof;
+      file->fileerror = gzwapi_error;
+      file->fileflush = gzwapi_flush;
+      file->fileopen = gzwapi_open;
+      file->fileread = gzwapi_read;
+      file->fileseek = gzwapi_seek;
+      file->filetell = gzwapi_tell;
+      file->fileungetc = gzwapi_ungetc;
+      file->filewrite = gzwapi_write;
+#endif
+    } else if (file->gzapi) {
+#if !ZLIB_INHIBITED
+      if (file->is_pipe) {
+        gzapi_setup(file);
+      } else {
+        file->fileclearerr = gzrapi_clearerr;
+        file->fileclose = gzrapi_close;
+        file->fileeof = gzrapi_eof;
+        file->fileerror = gzrapi_error;
+        file->fileflush = gzrapi_flush;
+        file->fileopen = gzrapi_open;
+        file->fileread = gzrapi_read;
+        file->fileseek = gzrapi_seek;
+        file->filetell = gzrapi_tell;
+        file->fileungetc = gzrapi_ungetc;
+        file->filewrite = gzrapi_write;
+      }
 #else
       /* This is the only runtime test we make */
       fatal("%s: Zlib was not included in this build.\n", file->module);
@@ -596,6 +1532,10 @@ gbfopen(const char* filename, const char* mode, const char* module)
 #endif
   file->buff = (char*) xmalloc(file->buffsz);
 
+  if ((file->mode == 'w') && !file->memapi) {
+    file->wbuf = (char*) xmalloc(GBFILE_WBUF_SIZE);
+  }
+
   return file;
 }
 
@@ -625,11 +1565,15 @@ gbfclose(gbfile* file)
     return;
   }
 
+  gbfile_drain(file);
   file->fileclose(file);
 
   xfree(file->name);
   xfree(file->module);
   xfree(file->buff);
+  if (file->wbuf) {
+    xfree(file->wbuf);
+  }
   xfree(file);
 }
 
@@ -794,6 +1738,19 @@ int
 gbfwrite(const void* buf, const gbsize_t size, const gbsize_t members, gbfile* file)
 {
   unsigned int result;
+  gbsize_t len = size * members;
+
+  /* Small writes are collected; large ones go straight through. */
+  if (file->wbuf && len) {
+    if (file->wbuflen + len > GBFILE_WBUF_SIZE) {
+      gbfile_drain(file);
+    }
+    if (len < GBFILE_WBUF_SIZE) {
+      memcpy(file->wbuf + file->wbuflen, buf, len);
+      file->wbuflen += len;
+      return members;
+    }
+  }
 
   result = file->filewrite(buf, size, members, file);
   if (result != members) {
@@ -814,6 +1771,7 @@ gbfwrite(const void* buf, const gbsize_t size, const gbsize_t members, gbfile* f
 int
 gbfflush(gbfile* file)
 {
+  gbfile_drain(file);
   return file->fileflush(file);
 }
 
@@ -855,6 +1813,7 @@ gbfrewind(gbfile* file)
 int
 gbfseek(gbfile* file, int32_t offset, int whence)
 {
+  gbfile_drain(file);
   return file->fileseek(file, offset, whence);
 }
 
@@ -869,7 +1828,7 @@ gbftell(gbfile* file)
   if ((signed) result == -1)
     fatal("%s: Could not determine position of file '%s'!\n",
           file->module, file->name);
-  return result;
+  return result + file->wbuflen;
 }
 
 /*
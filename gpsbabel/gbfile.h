@@ -33,6 +33,8 @@
 
 struct gbfile_s;
 typedef struct gbfile_s gbfile;
+struct gzwriter_s;
+struct gzreader_s;
 typedef uint32_t gbsize_t;
 
 typedef void (*gbfclearerr_cb)(gbfile* self);
@@ -56,6 +58,8 @@ typedef struct gbfile_s {
     unsigned char* mem;
 #if !ZLIB_INHIBITED
     gzFile gz;
+    struct gzwriter_s* gzw;	/* block-parallel gzip output */
+    struct gzreader_s* gzr;	/* seekable gzip input */
 #endif
   } handle;
   char*   name;
@@ -67,6 +71,9 @@ typedef struct gbfile_s {
   gbsize_t mempos;	/* curr. position in memory */
   gbsize_t memlen;	/* max. number of written bytes to memory */
   gbsize_t memsz;		/* curr. size of allocated memory */
+  char*   wbuf;		/* write coalescing buffer, NULL for memory streams */
+  QByteArray* memfile;	/* bound by gbfmem_bind(), or NULL */
+  gbsize_t wbuflen;	/* bytes pending in wbuf */
   unsigned char big_endian:1;
   unsigned char binary:1;
   unsigned char gzapi:1;
@@ -137,4 +144,16 @@ int gbfputpstr(const QString& s, gbfile* file);	// write as pascal string
 
 gbsize_t gbfcopyfrom(gbfile* file, gbfile* src, gbsize_t count);
 
+/*
+ * Memory files: names bound to buffers, which gbfopen() and
+ * gpsbabel::File then read and write in place of the file system.
+ * This is how libgpsbabel hands its callers' data to the formats.
+ * gbfmem_open() returns NULL for names that aren't bound;
+ * gbfmem_take() returns how often the name was opened.
+ */
+void gbfmem_bind(const char* name, const QByteArray& data);
+QByteArray* gbfmem_open(const char* name);
+int gbfmem_take(const char* name, QByteArray* data);
+void gbfmem_clear(void);
+
 #endif
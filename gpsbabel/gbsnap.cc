@@ -0,0 +1,1000 @@
+/*
+    GPSBabel binary snapshot.
+
+    Saves the waypoint, route and track lists exactly as they are held in
+    memory so that a dataset parsed once can be reloaded without parsing
+    it again.   The file is only meant to be read back by GPSBabel.
+
+    Copyright (C) 2015 Robert Lipe, robertlipe+source@gpsbabel.org
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111 USA
+
+ */
+
+/*
+ * File layout; all numbers are little endian.
+ *
+ *   "GBSNAP\r\n"		magic
+ *   u32 version		SNAP_VERSION
+ *   u32 reserved
+ *   records		u8 kind, u32 payload length, payload
+ *   u64 offset		of the string table record, from the start
+ *
+ * The last record is the string table ('S'): a u32 count and then, for
+ * each string, a u32 length and that many UTF-16 code units.  String 0
+ * is the empty string.  Everywhere else strings are u32 indexes into
+ * this table, so each distinct string is stored (and loaded) only once.
+ *
+ * 'W' is a waypoint, 'R' and 'T' start a route and a track, and 'P' is
+ * a point of the route or track started last.  Readers skip record kinds
+ * they don't know and ignore payload bytes past the fields they know,
+ * and missing trailing fields read as zero; new fields therefore go at
+ * the end of a payload and don't need a new version.
+ *
+ * Format specific data is kept for the types that have a handler in
+ * fs_handlers[] below; other types are dropped with a warning.
+ */
+
+#include <QtCore/QHash>
+#include <QtCore/QVector>
+
+#include "defs.h"
+#include "garmin_fs.h"
+#include "src/core/xmltag.h"
+
+#define MYNAME "gbsnap"
+
+#define SNAP_MAGIC "GBSNAP\r\n"
+#define SNAP_VERSION 1
+
+#define REC_WAYPOINT 'W'
+#define REC_ROUTE 'R'
+#define REC_TRACK 'T'
+#define REC_POINT 'P'
+#define REC_STRINGS 'S'
+
+static gbfile* fin, *fout;
+
+/*******************************************************************************
+* %%%        encoding                                                      %%% *
+*******************************************************************************/
+
+static QHash<QString, quint32> wr_strings;
+static QVector<QString> wr_string_list;
+static quint64 wr_offset;
+
+static void
+put8(QByteArray& b, int v)
+{
+  b.append((char) v);
+}
+
+static void
+put32(QByteArray& b, quint32 v)
+{
+  char buf[4];
+  le_write32(buf, v);
+  b.append(buf, 4);
+}
+
+static void
+put64(QByteArray& b, qint64 v)
+{
+  put32(b, (quint32)(v & 0xffffffff));
+  put32(b, (quint32)((quint64) v >> 32));
+}
+
+static void
+putd(QByteArray& b, double v)
+{
+  char buf[8];
+  le_write_double(buf, v);
+  b.append(buf, 8);
+}
+
+static void
+putf(QByteArray& b, float v)
+{
+  char buf[4];
+  le_write_float(buf, v);
+  b.append(buf, 4);
+}
+
+static void
+putstr(QByteArray& b, const QString& s)
+{
+  if (s.isEmpty()) {
+    put32(b, 0);
+    return;
+  }
+  QHash<QString, quint32>::const_iterator it = wr_strings.constFind(s);
+  if (it != wr_strings.constEnd()) {
+    put32(b, it.value());
+    return;
+  }
+  quint32 idx = wr_string_list.size();
+  wr_strings.insert(s, idx);
+  wr_string_list.append(s);
+  put32(b, idx);
+}
+
+static void
+putcstr(QByteArray& b, const char* s)
+{
+  putstr(b, s ? QString::fromUtf8(s) : QString());
+}
+
+/* Time as "has a value" and milliseconds since the epoch, plus the time spec. */
+static void
+puttime(QByteArray& b, const QDateTime& t)
+{
+  if (!t.isValid()) {
+    put8(b, 0);
+    return;
+  }
+  put8(b, 1);
+  put8(b, t.timeSpec() == Qt::LocalTime ? 0 : 1);
+  put64(b, t.toMSecsSinceEpoch());
+}
+
+/* Appends a length that is filled in by patch_len() once the payload is done. */
+static int
+begin_len(QByteArray& b)
+{
+  int pos = b.size();
+  put32(b, 0);
+  return pos;
+}
+
+static void
+patch_len(QByteArray& b, int pos)
+{
+  le_write32(b.data() + pos, b.size() - pos - 4);
+}
+
+static void
+write_record(int kind, const QByteArray& payload)
+{
+  char hdr[5];
+
+  hdr[0] = kind;
+  le_write32(hdr + 1, payload.size());
+  gbfwrite(hdr, 1, sizeof(hdr), fout);
+  gbfwrite(payload.constData(), 1, payload.size(), fout);
+  wr_offset += sizeof(hdr) + payload.size();
+}
+
+/*******************************************************************************
+* %%%        decoding                                                      %%% *
+*******************************************************************************/
+
+/* Reads past the end of the payload return zeros; see the layout notes. */
+typedef struct {
+  const unsigned char* p;
+  const unsigned char* end;
+} cursor;
+
+static QVector<QString> rd_strings;
+
+static int
+get8(cursor* c)
+{
+  if (c->p + 1 > c->end) {
+    c->p = c->end;
+    return 0;
+  }
+  return *c->p++;
+}
+
+static quint32
+get32(cursor* c)
+{
+  if (c->p + 4 > c->end) {
+    c->p = c->end;
+    return 0;
+  }
+  quint32 v = le_readu32(c->p);
+  c->p += 4;
+  return v;
+}
+
+static qint64
+get64(cursor* c)
+{
+  quint64 lo = get32(c);
+  quint64 hi = get32(c);
+  return (qint64)(lo | (hi << 32));
+}
+
+static double
+getd(cursor* c)
+{
+  if (c->p + 8 > c->end) {
+    c->p = c->end;
+    return 0;
+  }
+  double v = le_read_double(c->p);
+  c->p += 8;
+  return v;
+}
+
+static float
+getf(cursor* c)
+{
+  if (c->p + 4 > c->end) {
+    c->p = c->end;
+    return 0;
+  }
+  float v = le_read_float(c->p);
+  c->p += 4;
+  return v;
+}
+
+static QString
+getstr(cursor* c)
+{
+  quint32 idx = get32(c);
+  if (idx >= (quint32) rd_strings.size()) {
+    fatal(MYNAME ": String index %u out of range.\n", idx);
+  }
+  return rd_strings.at(idx);
+}
+
+static char*
+getcstr(cursor* c)
+{
+  QString s = getstr(c);
+  return s.isEmpty() ? NULL : xstrdup(s);
+}
+
+static gpsbabel::DateTime
+gettime(cursor* c)
+{
+  if (!get8(c)) {
+    return gpsbabel::DateTime(QDateTime());
+  }
+  int utc = get8(c);
+  QDateTime t = QDateTime::fromMSecsSinceEpoch(get64(c));
+  return utc ? t.toUTC() : t;
+}
+
+/* A nested block: its cursor ends where the block does. */
+static cursor
+get_block(cursor* c)
+{
+  cursor sub;
+  quint32 len = get32(c);
+
+  if (len > (quint32)(c->end - c->p)) {
+    fatal(MYNAME ": Truncated data.\n");
+  }
+  sub.p = c->p;
+  sub.end = c->p + len;
+  c->p += len;
+  return sub;
+}
+
+/*******************************************************************************
+* %%%        format specific data                                          %%% *
+*******************************************************************************/
+
+static void
+put_xml_tag(QByteArray& b, const xml_tag* tag)
+{
+  for (; tag; tag = tag->sibling) {
+    int nattr = 0;
+
+    put8(b, 1);
+    putstr(b, tag->tagname);
+    putstr(b, tag->cdata);
+    putstr(b, tag->parentcdata);
+    if (tag->attributes) {
+      while (tag->attributes[nattr]) {
+        nattr++;
+      }
+    }
+    put32(b, nattr);
+    for (int i = 0; i < nattr; i++) {
+      putcstr(b, tag->attributes[i]);
+    }
+    put_xml_tag(b, tag->child);
+  }
+  put8(b, 0);
+}
+
+static xml_tag*
+get_xml_tag(cursor* c, xml_tag* parent)
+{
+  xml_tag* first = NULL;
+  xml_tag** link = &first;
+
+  while (get8(c)) {
+    xml_tag* tag = new xml_tag;
+    int nattr;
+
+    tag->tagname = getstr(c);
+    tag->cdata = getstr(c);
+    tag->parentcdata = getstr(c);
+    nattr = get32(c);
+    if (nattr > c->end - c->p) {
+      fatal(MYNAME ": Truncated data.\n");
+    }
+    if (nattr) {
+      tag->attributes = (char**) xcalloc(nattr + 1, sizeof(char*));
+      for (int i = 0; i < nattr; i++) {
+        QString s = getstr(c);
+        tag->attributes[i] = xstrdup(s);
+      }
+    }
+    tag->parent = parent;
+    tag->child = get_xml_tag(c, tag);
+    *link = tag;
+    link = &tag->sibling;
+  }
+  return first;
+}
+
+static void
+put_fs_xml(QByteArray& b, const format_specific_data* fs)
+{
+  put_xml_tag(b, ((const fs_xml*) fs)->tag);
+}
+
+static format_specific_data*
+get_fs_xml(cursor* c, long type)
+{
+  fs_xml* fs = fs_xml_alloc(type);
+  fs->tag = get_xml_tag(c, NULL);
+  return (format_specific_data*) fs;
+}
+
+static void
+put_fs_gmsd(QByteArray& b, const format_specific_data* fs)
+{
+  const garmin_fs_t* g = (const garmin_fs_t*) fs;
+  const garmin_ilink_t* il;
+  quint32 flags = 0;
+  int n = 0;
+
+  flags |= g->flags.icon << 0;
+  flags |= g->flags.wpt_class << 1;
+  flags |= g->flags.display << 2;
+  flags |= g->flags.category << 3;
+  flags |= g->flags.city << 4;
+  flags |= g->flags.state << 5;
+  flags |= g->flags.facility << 6;
+  flags |= g->flags.cc << 7;
+  flags |= g->flags.cross_road << 8;
+  flags |= g->flags.addr << 9;
+  flags |= g->flags.country << 10;
+  flags |= g->flags.phone_nr << 11;
+  flags |= g->flags.phone_nr2 << 12;
+  flags |= g->flags.fax_nr << 13;
+  flags |= g->flags.postal_code << 14;
+  flags |= g->flags.email << 15;
+  put32(b, flags);
+  put32(b, g->protocol);
+  put32(b, g->icon);
+  put32(b, g->wpt_class);
+  put32(b, g->display);
+  put32(b, g->category);
+  putcstr(b, g->city);
+  putcstr(b, g->facility);
+  putcstr(b, g->state);
+  putcstr(b, g->cc);
+  putcstr(b, g->cross_road);
+  putcstr(b, g->addr);
+  putcstr(b, g->country);
+  putcstr(b, g->phone_nr);
+  putcstr(b, g->phone_nr2);
+  putcstr(b, g->fax_nr);
+  putcstr(b, g->postal_code);
+  putcstr(b, g->email);
+  for (il = g->ilinks; il; il = il->next) {
+    n++;
+  }
+  put32(b, n);
+  for (il = g->ilinks; il; il = il->next) {
+    putd(b, il->lat);
+    putd(b, il->lon);
+    putd(b, il->alt);
+  }
+}
+
+static format_specific_data*
+get_fs_gmsd(cursor* c, long)
+{
+  quint32 flags = get32(c);
+  garmin_fs_t* g = garmin_fs_alloc(get32(c));
+  garmin_ilink_t** link = &g->ilinks;
+  quint32 n;
+
+  g->flags.icon = (flags >> 0) & 1;
+  g->flags.wpt_class = (flags >> 1) & 1;
+  g->flags.display = (flags >> 2) & 1;
+  g->flags.category = (flags >> 3) & 1;
+  g->flags.city = (flags >> 4) & 1;
+  g->flags.state = (flags >> 5) & 1;
+  g->flags.facility = (flags >> 6) & 1;
+  g->flags.cc = (flags >> 7) & 1;
+  g->flags.cross_road = (flags >> 8) & 1;
+  g->flags.addr = (flags >> 9) & 1;
+  g->flags.country = (flags >> 10) & 1;
+  g->flags.phone_nr = (flags >> 11) & 1;
+  g->flags.phone_nr2 = (flags >> 12) & 1;
+  g->flags.fax_nr = (flags >> 13) & 1;
+  g->flags.postal_code = (flags >> 14) & 1;
+  g->flags.email = (flags >> 15) & 1;
+  g->icon = get32(c);
+  g->wpt_class = get32(c);
+  g->display = get32(c);
+  g->category = get32(c);
+  g->city = getcstr(c);
+  g->facility = getcstr(c);
+  g->state = getcstr(c);
+  g->cc = getcstr(c);
+  g->cross_road = getcstr(c);
+  g->addr = getcstr(c);
+  g->country = getcstr(c);
+  g->phone_nr = getcstr(c);
+  g->phone_nr2 = getcstr(c);
+  g->fax_nr = getcstr(c);
+  g->postal_code = getcstr(c);
+  g->email = getcstr(c);
+  n = get32(c);
+  if (n > (quint32)(c->end - c->p) / 24) {
+    fatal(MYNAME ": Truncated data.\n");
+  }
+  while (n--) {
+    garmin_ilink_t* il = (garmin_ilink_t*) xcalloc(1, sizeof(*il));
+    il->ref_count = 1;
+    il->lat = getd(c);
+    il->lon = getd(c);
+    il->alt = getd(c);
+    *link = il;
+    link = &il->next;
+  }
+  return (format_specific_data*) g;
+}
+
+static const struct {
+  long type;
+  void (*put)(QByteArray&, const format_specific_data*);
+  format_specific_data* (*get)(cursor*, long);
+} fs_handlers[] = {
+  { FS_GPX, put_fs_xml, get_fs_xml },
+  { FS_GMSD, put_fs_gmsd, get_fs_gmsd },
+};
+
+#define NUM_FS_HANDLERS (int)(sizeof(fs_handlers) / sizeof(fs_handlers[0]))
+
+static QHash<long, int> fs_warned;
+
+static void
+put_fs_chain(QByteArray& b, const format_specific_data* fs)
+{
+  int count_pos = b.size();
+  int n = 0;
+
+  put32(b, 0);
+  for (; fs; fs = fs->next) {
+    int h;
+    for (h = 0; h < NUM_FS_HANDLERS && fs_handlers[h].type != fs->type; h++) {
+      ;
+    }
+    if (h == NUM_FS_HANDLERS) {
+      if (!fs_warned.contains(fs->type)) {
+        warning(MYNAME ": Format specific data of type 0x%08lx can't be saved, dropped.\n",
+                fs->type);
+        fs_warned.insert(fs->type, 1);
+      }
+      continue;
+    }
+    put32(b, (quint32) fs->type);
+    int len_pos = begin_len(b);
+    fs_handlers[h].put(b, fs);
+    patch_len(b, len_pos);
+    n++;
+  }
+  le_write32(b.data() + count_pos, n);
+}
+
+static format_specific_data*
+get_fs_chain(cursor* c)
+{
+  format_specific_data* chain = NULL;
+  format_specific_data** link = &chain;
+  quint32 n = get32(c);
+
+  while (n--) {
+    long type = (long) get32(c);
+    cursor sub = get_block(c);
+    for (int h = 0; h < NUM_FS_HANDLERS; h++) {
+      if (fs_handlers[h].type == type) {
+        /* keep the order of the chain; fs_chain_add() would reverse it */
+        *link = fs_handlers[h].get(&sub, type);
+        link = &(*link)->next;
+        break;
+      }
+    }
+  }
+  return chain;
+}
+
+/*******************************************************************************
+* %%%        waypoints, routes and tracks                                  %%% *
+*******************************************************************************/
+
+static quint32
+pack_wp_flags(const wp_flags& f)
+{
+  return (f.shortname_is_synthetic << 0) |
+         (f.cet_converted << 1) |
+         (f.fmt_use << 2) |
+         (f.temperature << 4) |
+         (f.proximity << 5) |
+         (f.course << 6) |
+         (f.speed << 7) |
+         (f.geoidheight << 8) |
+         (f.depth << 9) |
+         (f.is_split << 10) |
+         (f.new_trkseg << 11);
+}
+
+static void
+unpack_wp_flags(wp_flags& f, quint32 v)
+{
+  f.shortname_is_synthetic = (v >> 0) & 1;
+  f.cet_converted = (v >> 1) & 1;
+  f.fmt_use = (v >> 2) & 3;
+  f.temperature = (v >> 4) & 1;
+  f.proximity = (v >> 5) & 1;
+  f.course = (v >> 6) & 1;
+  f.speed = (v >> 7) & 1;
+  f.geoidheight = (v >> 8) & 1;
+  f.depth = (v >> 9) & 1;
+  f.is_split = (v >> 10) & 1;
+  f.new_trkseg = (v >> 11) & 1;
+}
+
+static void
+put_utf_string(QByteArray& b, const utf_string& s)
+{
+  put8(b, s.is_html);
+  putstr(b, s.utfstring);
+}
+
+static void
+get_utf_string(cursor* c, utf_string& s)
+{
+  s.is_html = get8(c);
+  s.utfstring = getstr(c);
+}
+
+static void
+put_gc_data(QByteArray& b, const geocache_data* gc)
+{
+  put32(b, gc->id);
+  put8(b, gc->type);
+  put8(b, gc->container);
+  put8(b, gc->diff);
+  put8(b, gc->terr);
+  put8(b, gc->is_archived);
+  put8(b, gc->is_available);
+  put8(b, gc->is_memberonly);
+  put8(b, gc->has_customcoords);
+  puttime(b, gc->exported);
+  puttime(b, gc->last_found);
+  putstr(b, gc->placer);
+  put32(b, gc->placer_id);
+  putstr(b, gc->hint);
+  put_utf_string(b, gc->desc_short);
+  put_utf_string(b, gc->desc_long);
+  put32(b, gc->favorite_points);
+  putstr(b, gc->personal_note);
+}
+
+static void
+get_gc_data(cursor* c, geocache_data* gc)
+{
+  gc->id = get32(c);
+  gc->type = (geocache_type) get8(c);
+  gc->container = (geocache_container) get8(c);
+  gc->diff = get8(c);
+  gc->terr = get8(c);
+  gc->is_archived = (status_type) get8(c);
+  gc->is_available = (status_type) get8(c);
+  gc->is_memberonly = (status_type) get8(c);
+  gc->has_customcoords = (status_type) get8(c);
+  gc->exported = gettime(c);
+  gc->last_found = gettime(c);
+  gc->placer = getstr(c);
+  gc->placer_id = get32(c);
+  gc->hint = getstr(c);
+  get_utf_string(c, gc->desc_short);
+  get_utf_string(c, gc->desc_long);
+  gc->favorite_points = get32(c);
+  gc->personal_note = getstr(c);
+}
+
+static void
+put_waypoint(int kind, const Waypoint* wpt)
+{
+  QByteArray b;
+
+  b.reserve(96);
+  putd(b, wpt->latitude);
+  putd(b, wpt->longitude);
+  putd(b, wpt->altitude);
+  putstr(b, wpt->shortname);
+  putstr(b, wpt->description);
+  put32(b, pack_wp_flags(wpt->wpt_flags));
+  puttime(b, wpt->creation_time);
+  putf(b, wpt->course);
+  putf(b, wpt->speed);
+  put32(b, wpt->fix);
+  put32(b, wpt->sat);
+
+  if (wpt->HasExt()) {
+    const waypt_ext* e = wpt->ext;
+
+    put8(b, 1);
+    putd(b, e->geoidheight);
+    putd(b, e->depth);
+    putd(b, e->proximity);
+    putstr(b, e->notes);
+    put32(b, e->url_link_list_.size());
+    foreach (const UrlLink& l, e->url_link_list_) {
+      putstr(b, l.url_);
+      putstr(b, l.url_link_text_);
+      putstr(b, l.url_link_type_);
+    }
+    putstr(b, e->icon_descr);
+    put32(b, e->route_priority);
+    putf(b, e->hdop);
+    putf(b, e->vdop);
+    putf(b, e->pdop);
+    put8(b, e->heartrate);
+    put8(b, e->cadence);
+    putf(b, e->power);
+    putf(b, e->temperature);
+    putf(b, e->odometer_distance);
+    if (wpt->EmptyGCData()) {
+      put8(b, 0);
+    } else {
+      put8(b, 1);
+      put_gc_data(b, e->gc_data);
+    }
+    put_fs_chain(b, e->fs);
+  } else {
+    put8(b, 0);
+  }
+
+  write_record(kind, b);
+}
+
+static Waypoint*
+get_waypoint(cursor* c)
+{
+  Waypoint* wpt = new Waypoint;
+
+  wpt->latitude = getd(c);
+  wpt->longitude = getd(c);
+  wpt->altitude = getd(c);
+  wpt->shortname = getstr(c);
+  wpt->description = getstr(c);
+  unpack_wp_flags(wpt->wpt_flags, get32(c));
+  wpt->creation_time = gettime(c);
+  wpt->course = getf(c);
+  wpt->speed = getf(c);
+  wpt->fix = (fix_type)(qint32) get32(c);
+  wpt->sat = (qint32) get32(c);
+
+  if (get8(c)) {
+    waypt_ext* e = wpt->AllocExt();
+    quint32 n;
+
+    e->geoidheight = getd(c);
+    e->depth = getd(c);
+    e->proximity = getd(c);
+    e->notes = getstr(c);
+    n = get32(c);
+    if (n > (quint32)(c->end - c->p) / 12) {
+      fatal(MYNAME ": Truncated data.\n");
+    }
+    while (n--) {
+      QString url = getstr(c);
+      QString text = getstr(c);
+      QString type = getstr(c);
+      e->url_link_list_.append(UrlLink(url, text, type));
+    }
+    e->icon_descr = getstr(c);
+    e->route_priority = get32(c);
+    e->hdop = getf(c);
+    e->vdop = getf(c);
+    e->pdop = getf(c);
+    e->heartrate = get8(c);
+    e->cadence = get8(c);
+    e->power = getf(c);
+    e->temperature = getf(c);
+    e->odometer_distance = getf(c);
+    if (get8(c)) {
+      get_gc_data(c, wpt->AllocGCData());
+    }
+    e->fs = get_fs_chain(c);
+  }
+
+  return wpt;
+}
+
+static void
+put_route_head(int kind, const route_head* rte)
+{
+  QByteArray b;
+
+  putstr(b, rte->rte_name);
+  putstr(b, rte->rte_desc);
+  putstr(b, rte->rte_url);
+  put32(b, rte->rte_num);
+  put32(b, rte->cet_converted);
+  put32(b, rte->line_color.bbggrr);
+  put8(b, rte->line_color.opacity);
+  put32(b, rte->line_width);
+  put_fs_chain(b, rte->fs);
+  write_record(kind, b);
+}
+
+static route_head*
+get_route_head(cursor* c)
+{
+  route_head* rte = route_head_alloc();
+
+  rte->rte_name = getstr(c);
+  rte->rte_desc = getstr(c);
+  rte->rte_url = getstr(c);
+  rte->rte_num = get32(c);
+  rte->cet_converted = get32(c);
+  rte->line_color.bbggrr = get32(c);
+  rte->line_color.opacity = get8(c);
+  rte->line_width = get32(c);
+  rte->fs = get_fs_chain(c);
+  return rte;
+}
+
+/*******************************************************************************
+* %%%        global callbacks called by gpsbabel main process              %%% *
+*******************************************************************************/
+
+static void
+snap_rd_init(const char* fname)
+{
+  fin = gbfopen(fname, "rb", MYNAME);
+  traits_add_complete();
+}
+
+static void
+snap_rd_deinit(void)
+{
+  gbfclose(fin);
+  rd_strings.clear();
+}
+
+static void
+snap_read_strings(cursor c)
+{
+  quint32 n = get32(&c);
+
+  if (n == 0 || n > (quint32)(c.end - c.p) / 4) {
+    fatal(MYNAME ": Invalid string table.\n");
+  }
+  rd_strings.resize(n);
+  for (quint32 i = 1; i < n; i++) {
+    quint32 len = get32(&c);
+    QString& s = rd_strings[i];
+
+    if (len > (quint32)(c.end - c.p) / 2) {
+      fatal(MYNAME ": Invalid string table.\n");
+    }
+    s.resize(len);
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    memcpy(s.data(), c.p, len * 2);
+#else
+    for (quint32 j = 0; j < len; j++) {
+      s[j] = QChar(le_readu16(c.p + j * 2));
+    }
+#endif
+    c.p += len * 2;
+  }
+}
+
+static void
+snap_read(void)
+{
+  QByteArray data;
+  char buf[65536];
+  gbsize_t n;
+  cursor c;
+  quint64 strings_at;
+  route_head* rte = NULL;
+  int rte_kind = 0;
+
+  while ((n = gbfread(buf, 1, sizeof(buf), fin)) > 0) {
+    data.append(buf, n);
+  }
+
+  if (data.size() < 24 || memcmp(data.constData(), SNAP_MAGIC, 8) != 0) {
+    fatal(MYNAME ": '%s' is not a GPSBabel snapshot.\n", fin->name);
+  }
+  c.p = (const unsigned char*) data.constData() + 8;
+  c.end = (const unsigned char*) data.constData() + data.size() - 8;
+  if (get32(&c) != SNAP_VERSION) {
+    fatal(MYNAME ": Unsupported snapshot version %u.\n", le_readu32(data.constData() + 8));
+  }
+  get32(&c);
+
+  /* the string table is at the end but everything refers to it */
+  le_read64(&strings_at, c.end);
+  if (strings_at < 16 || strings_at + 5 > (quint64) data.size() - 8 ||
+      data.at(strings_at) != REC_STRINGS) {
+    fatal(MYNAME ": Invalid snapshot trailer.\n");
+  }
+  {
+    cursor s;
+    s.p = (const unsigned char*) data.constData() + strings_at + 1;
+    s.end = c.end;
+    snap_read_strings(get_block(&s));
+  }
+
+  while (c.p < c.end) {
+    int kind = get8(&c);
+    cursor rec = get_block(&c);
+
+    switch (kind) {
+    case REC_WAYPOINT:
+      waypt_add(get_waypoint(&rec));
+      break;
+    case REC_ROUTE:
+      rte = get_route_head(&rec);
+      route_add_head(rte);
+      rte_kind = kind;
+      break;
+    case REC_TRACK:
+      rte = get_route_head(&rec);
+      track_add_head(rte);
+      rte_kind = kind;
+      break;
+    case REC_POINT:
+      if (rte == NULL) {
+        fatal(MYNAME ": Route or track point outside of a route or track.\n");
+      }
+      if (rte_kind == REC_ROUTE) {
+        route_add_wpt(rte, get_waypoint(&rec));
+      } else {
+        track_add_wpt(rte, get_waypoint(&rec));
+      }
+      break;
+    default:
+      /* the string table, or something newer than us */
+      break;
+    }
+  }
+  rd_strings.clear();
+}
+
+static void
+snap_wr_init(const char* fname)
+{
+  char hdr[16];
+
+  fout = gbfopen(fname, "wb", MYNAME);
+  memcpy(hdr, SNAP_MAGIC, 8);
+  le_write32(hdr + 8, SNAP_VERSION);
+  le_write32(hdr + 12, 0);
+  gbfwrite(hdr, 1, sizeof(hdr), fout);
+  wr_offset = sizeof(hdr);
+
+  wr_strings.clear();
+  wr_string_list.clear();
+  wr_string_list.append(QString());
+  fs_warned.clear();
+}
+
+static void
+snap_wr_deinit(void)
+{
+  gbfclose(fout);
+  wr_strings.clear();
+  wr_string_list.clear();
+}
+
+static void
+snap_write_waypt(const Waypoint* wpt)
+{
+  put_waypoint(REC_WAYPOINT, wpt);
+}
+
+static void
+snap_write_route_head(const route_head* rte)
+{
+  put_route_head(REC_ROUTE, rte);
+}
+
+static void
+snap_write_track_head(const route_head* rte)
+{
+  put_route_head(REC_TRACK, rte);
+}
+
+static void
+snap_write_point(const Waypoint* wpt)
+{
+  put_waypoint(REC_POINT, wpt);
+}
+
+static void
+snap_write_strings(void)
+{
+  QByteArray b;
+  char trailer[8];
+  quint64 at = wr_offset;
+  int total = 4;
+
+  foreach (const QString& s, wr_string_list) {
+    total += 4 + s.size() * 2;
+  }
+  b.reserve(total);
+  put32(b, wr_string_list.size());
+  for (int i = 1; i < wr_string_list.size(); i++) {
+    const QString& s = wr_string_list.at(i);
+    put32(b, s.size());
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    b.append((const char*) s.constData(), s.size() * 2);
+#else
+    for (int j = 0; j < s.size(); j++) {
+      char u[2];
+      le_write16(u, s.at(j).unicode());
+      b.append(u, 2);
+    }
+#endif
+  }
+  write_record(REC_STRINGS, b);
+
+  le_write32(trailer, (quint32)(at & 0xffffffff));
+  le_write32(trailer + 4, (quint32)(at >> 32));
+  gbfwrite(trailer, 1, sizeof(trailer), fout);
+}
+
+static void
+snap_write(void)
+{
+  waypt_disp_all(snap_write_waypt);
+  route_disp_all(snap_write_route_head, NULL, snap_write_point);
+  track_disp_all(snap_write_track_head, NULL, snap_write_point);
+  snap_write_strings();
+}
+
+ff_vecs_t gbsnap_vecs = {
+  ff_type_file,
+  FF_CAP_RW_ALL,
+  snap_rd_init,
+  snap_wr_init,
+  snap_rd_deinit,
+  snap_wr_deinit,
+  snap_read,
+  snap_write,
+  NULL,
+  NULL,
+  CET_CHARSET_UTF8, 1	/* strings are kept as they are in memory */
+};
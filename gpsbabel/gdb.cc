@@ -149,7 +149,7 @@ gdb_flush_waypt_queue(queue* Q)
   QUEUE_FOR_EACH(Q, elem, tmp) {
     Waypoint* wpt = (Waypoint*)elem;
     dequeue(elem);
-    if (wpt->extra_data) {
+    if (wpt->ext->extra_data) {
 #if NEW_STRINGS
       // FIXME
       // wpt->extra_data may be holding a pointer to a QString, courtesy
@@ -542,7 +542,7 @@ read_waypoint(gt_waypt_classes_e* waypt_class_out)
   res = new Waypoint;
 
   gmsd = garmin_fs_alloc(-1);
-  fs_chain_add(&res->fs, (format_specific_data*) gmsd);
+  fs_chain_add(&res->AllocExt()->fs, (format_specific_data*) gmsd);
   res->shortname = fread_cstr();
 #if GDB_DEBUG
   sn = xstrdup(nice(res->shortname));
@@ -586,10 +586,10 @@ read_waypoint(gt_waypt_classes_e* waypt_class_out)
          res->latitude < 0 ? 'S' : 'N', res->latitude,
          res->longitude < 0 ? 'W' : 'E', res->longitude);
 #endif
-  res->notes = fread_cstr();
+  res->AllocExt()->notes = fread_cstr();
 #if GDB_DEBUG
-  DBG(GDB_DBG_WPTe, res->notes) {
-    char* str = gstrsub(res->notes, "\r\n", ", ");
+  DBG(GDB_DBG_WPTe, res->ext->notes) {
+    char* str = gstrsub(res->ext->notes, "\r\n", ", ");
     printf(MYNAME "-wpt \"%s\" (%d): notes = %s\n",
            sn, wpt_class, nice(str));
     xfree(str);
@@ -600,7 +600,7 @@ read_waypoint(gt_waypt_classes_e* waypt_class_out)
 #if GDB_DEBUG
     DBG(GDB_DBG_WPTe, 1)
     printf(MYNAME "-wpt \"%s\" (%d): Proximity = %.1f\n",
-           sn, wpt_class, res->proximity / 1000);
+           sn, wpt_class, res->ext->proximity / 1000);
 #endif
   }
   i = FREAD_i32;
@@ -639,7 +639,7 @@ read_waypoint(gt_waypt_classes_e* waypt_class_out)
 #if GDB_DEBUG
     DBG(GDB_DBG_WPTe, 1)
     printf(MYNAME "-wpt \"%s\" (%d): Depth = %.1f\n",
-           sn, wpt_class, res->depth);
+           sn, wpt_class, res->ext->depth);
 #endif
   }
 
@@ -717,7 +717,7 @@ read_waypoint(gt_waypt_classes_e* waypt_class_out)
 #if GDB_DEBUG
     DBG(GDB_DBG_WPTe, 1)
     printf(MYNAME "-wpt \"%s\" (%d): temperature = %.1f\n",
-           sn, wpt_class, res->temperature);
+           sn, wpt_class, res->ext->temperature);
 #endif
   }
 
@@ -744,12 +744,12 @@ read_waypoint(gt_waypt_classes_e* waypt_class_out)
     GMSD_SETSTR(postal_code, bufp);
   }
 
-  res->icon_descr = gt_find_desc_from_icon_number(icon, GDB);
+  res->AllocExt()->icon_descr = gt_find_desc_from_icon_number(icon, GDB);
 
 #if GDB_DEBUG
   DBG(GDB_DBG_WPTe, icon != GDB_DEF_ICON)
   printf(MYNAME "-wpt \"%s\" (%d): icon = \"%s\" (MapSource symbol %d)\n",
-         sn, wpt_class, nice(qPrintable(res->icon_descr)), icon); // FIXME: qPrintable and nice probably are fighting.
+         sn, wpt_class, nice(qPrintable(res->ext->icon_descr)), icon); // FIXME: qPrintable and nice probably are fighting.
 #endif
   if ((str = GMSD_GET(cc, NULL))) {
     if (! GMSD_HAS(country)) {
@@ -947,7 +947,7 @@ read_route(void)
       garmin_fs_t* gmsd = GMSD_FIND(wpt);
       if (gmsd == NULL) {
         gmsd = garmin_fs_alloc(-1);
-        fs_chain_add(&wpt->fs, (format_specific_data*) gmsd);
+        fs_chain_add(&wpt->AllocExt()->fs, (format_specific_data*) gmsd);
       }
       GMSD_SET(wpt_class, wpt_class);
       gmsd->ilinks = il_root;
@@ -1365,8 +1365,8 @@ write_waypoint(
   FWRITE_LATLON(wpt->latitude);		/* latitude */
   FWRITE_LATLON(wpt->longitude);		/* longitude */
   FWRITE_DBL(wpt->altitude, unknown_alt);	/* altitude */
-  if (!wpt->notes.isEmpty()) {
-    FWRITE_CSTR(wpt->notes);
+  if (!wpt->ext->notes.isEmpty()) {
+    FWRITE_CSTR(wpt->ext->notes);
   } else {
     FWRITE_CSTR(wpt->description);
   }
@@ -1419,7 +1419,7 @@ write_waypoint(
     if (wpt->description == wpt->shortname) {
       d.clear();
     }
-    if (str == wpt->notes) {
+    if (str == wpt->ext->notes) {
       d.clear();
     }
     FWRITE_CSTR(d);				/* instruction */
@@ -1435,7 +1435,7 @@ write_waypoint(
 #endif
 
     cnt = 0;
-    cnt += wpt->url_link_list_.size();
+    cnt += wpt->ext->url_link_list_.size();
     FWRITE_i32(cnt);
     foreach(UrlLink l, wpt->GetUrlLinks()) {
       FWRITE_CSTR(l.url_);
@@ -1462,15 +1462,20 @@ write_waypoint(
 }
 
 static void
-route_compute_bounds(const route_head* rte, bounds* bounds)
+gdb_route_compute_bounds(const route_head* rte, bounds* bounds)
 {
   queue* elem, *tmp;
-  waypt_init_bounds(bounds);
   QUEUE_FOR_EACH((queue*)&rte->waypoint_list, elem, tmp) {
     Waypoint* wpt = (Waypoint*)elem;
+    double lat = wpt->latitude;
+    double lon = wpt->longitude;
     gdb_check_waypt(wpt);
-    waypt_add_to_bounds(bounds, wpt);
+    if ((lat != wpt->latitude) || (lon != wpt->longitude)) {
+      /* The memoized bounds no longer describe this route. */
+      cache_invalidate();
+    }
   }
+  route_compute_bounds(rte, bounds);
 }
 
 static void
@@ -1503,7 +1508,7 @@ write_route(const route_head* rte, const QString& rte_name)
   FWRITE_CSTR(rte_name);
   FWRITE_C(0);				/* display/autoname - 1 byte */
 
-  route_compute_bounds(rte, &bounds);
+  gdb_route_compute_bounds(rte, &bounds);
   route_write_bounds(&bounds);
 
   points = ELEMENTS(rte);
@@ -1539,7 +1544,7 @@ write_route(const route_head* rte, const QString& rte_name)
     gmsd = GMSD_FIND(wpt);
 
     /* extra_data may contain a modified shortname */
-    FWRITE_CSTR((wpt->extra_data) ? (char*)wpt->extra_data : wpt->shortname);
+    FWRITE_CSTR((wpt->ext->extra_data) ? (char*)wpt->ext->extra_data : wpt->shortname);
 
     wpt_class = wpt->wpt_flags.fmt_use;			/* trick */
 
@@ -1688,7 +1693,7 @@ write_waypoint_cb(const Waypoint* refpt)
   }
 
   if ((test != NULL) && (route_flag == 0)) {
-    if (test->notes != refpt->notes) {
+    if (test->ext->notes != refpt->ext->notes) {
       test = NULL;
     }
   }
@@ -1714,10 +1719,10 @@ write_waypoint_cb(const Waypoint* refpt)
 
     icon = GMSD_GET(icon, -1);
     if (icon < 0) {
-      if (wpt->icon_descr.isNull()) {
+      if (wpt->ext->icon_descr.isNull()) {
         icon = GDB_DEF_ICON;
       } else {
-        icon = gt_find_icon_number_from_desc(wpt->icon_descr, GDB);
+        icon = gt_find_icon_number_from_desc(wpt->ext->icon_descr, GDB);
       }
     }
 
@@ -1743,7 +1748,7 @@ write_waypoint_cb(const Waypoint* refpt)
     QString name = wpt->shortname;
 
     if (global_opts.synthesize_shortnames || name.isEmpty()) {
-      name = wpt->notes;
+      name = wpt->ext->notes;
       if (name.isEmpty()) {
         name = wpt->description;
       }
@@ -72,17 +72,17 @@ void GeoReadLoc()
         wpt->latitude = a.value("lat").toString().toDouble();
         wpt->longitude = a.value("lon").toString().toDouble();
       } else if (current_tag == "/loc/waypoint/type") {
-        wpt->icon_descr = reader.readElementText();
+        wpt->AllocExt()->icon_descr = reader.readElementText();
       } else if (current_tag == "/loc/waypoint/link") {
         QXmlStreamAttributes a = reader.attributes();
         waypt_add_url(wpt,
                       reader.readElementText(), a.value("text").toString());
       } else if (current_tag == "/loc/waypoint/difficulty") {
-        wpt->gc_data->diff = reader.readElementText().toInt() * 10;
+        wpt->ext->gc_data->diff = reader.readElementText().toInt() * 10;
       } else if (current_tag == "/loc/waypoint/terrain") {
-        wpt->gc_data->terr = reader.readElementText().toInt() * 10;
+        wpt->ext->gc_data->terr = reader.readElementText().toInt() * 10;
       } else if (current_tag == "/loc/waypoint/container") {
-        wpt->gc_data->container = wpt_container(reader.readElementText());
+        wpt->ext->gc_data->container = wpt_container(reader.readElementText());
       }
     }
 
@@ -197,7 +197,7 @@ geo_waypt_pr(const Waypoint* waypointp)
   writer.writeAttribute("lon", QString::number(waypointp->longitude, 'f'));
   writer.writeEndElement();
 
-  writer.writeTextElement("type", deficon ? deficon : waypointp->icon_descr);
+  writer.writeTextElement("type", deficon ? deficon : waypointp->ext->icon_descr);
 
   if (waypointp->HasUrlLink()) {
     writer.writeStartElement("link");
@@ -207,14 +207,14 @@ geo_waypt_pr(const Waypoint* waypointp)
     writer.writeEndElement();
   }
 
-  if (waypointp->gc_data && waypointp->gc_data->diff) {
+  if (waypointp->ext->gc_data && waypointp->ext->gc_data->diff) {
     writer.writeTextElement("difficulty",
-                            QString::number(waypointp->gc_data->diff/10));
+                            QString::number(waypointp->ext->gc_data->diff/10));
     writer.writeTextElement("terrain",
-                            QString::number(waypointp->gc_data->terr/10));
+                            QString::number(waypointp->ext->gc_data->terr/10));
 
     int v = 1;
-    switch (waypointp->gc_data->container) {
+    switch (waypointp->ext->gc_data->container) {
     case gc_unknown:
       v = 1;
       break;
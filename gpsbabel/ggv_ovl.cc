@@ -342,20 +342,12 @@ route_disp_cb(const route_head* rte)
 
 /* -----------------------------------------------------------------------*/
 
-static void
-waypt_bound_calc(const Waypoint* waypointp)
-{
-  waypt_add_to_bounds(&all_bounds, waypointp);
-}
-
 static void
 write_bounds(void)
 {
-  waypt_init_bounds(&all_bounds);
-
-  waypt_disp_all(waypt_bound_calc);
-  route_disp_all(NULL, NULL, waypt_bound_calc);
-  track_disp_all(NULL, NULL, waypt_bound_calc);
+  waypt_compute_bounds(&all_bounds);
+  route_add_all_to_bounds(&all_bounds);
+  track_add_all_to_bounds(&all_bounds);
 
   if (waypt_bounds_valid(&all_bounds)) {
 
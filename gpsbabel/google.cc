@@ -219,7 +219,7 @@ void goog_poly_e(xg_string args, const QXmlStreamAttributes*)
       Waypoint* wpt_tmp = new Waypoint;
       wpt_tmp->latitude = lat / 100000.0;
       wpt_tmp->longitude = lon / 100000.0;
-      wpt_tmp->route_priority=level;
+      wpt_tmp->AllocExt()->route_priority=level;
       wpt_tmp->shortname = QString().sprintf( "\\%5.5x", serial++);
       route_add_wpt(routehead[goog_segroute], wpt_tmp);
     }
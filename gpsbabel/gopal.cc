@@ -279,7 +279,7 @@ gopal_read(void)
         }
         break;
       case  7: 				/* hdop */
-        wpt->hdop = atof(c);
+        wpt->AllocExt()->hdop = atof(c);
         //sscanf(c, "%lf", &wpt->hdop); does not work ???
         //wpt->vdop=0;wpt->hdop=0;
         break;
@@ -371,7 +371,7 @@ gopal_write_waypt(const Waypoint* wpt)
   //MSVC handles time_t as int64, gcc and mac only int32, so convert it:
   timestamp=(unsigned long)wpt->GetCreationTime().toTime_t();
   gbfprintf(fout, "%lu, %s, %lf, %lf, %5.1lf, %8.5lf, %d, %lf, %d\n",timestamp,tbuffer,  wpt->longitude, wpt->latitude,wpt->altitude,
-            wpt->speed,fix,wpt->hdop,wpt->sat);
+            wpt->speed,fix,wpt->ext->hdop,wpt->sat);
 }
 
 
@@ -130,7 +130,7 @@ data_read(void)
     wpt_tmp->longitude = ilon + (lon - ilon)*(100.0/60.0);
     ilat = (int)(lat);
     wpt_tmp->latitude = ilat + (lat - ilat) * (100.0/60.0);
-    wpt_tmp->icon_descr = mag_find_descr_from_token(icon);
+    wpt_tmp->AllocExt()->icon_descr = mag_find_descr_from_token(icon);
     waypt_add(wpt_tmp);
   }
 }
@@ -142,7 +142,7 @@ gpsutil_disp(const Waypoint* wpt)
   QString icon_token;
   char* tdesc = xstrdup(wpt->description);
 
-  icon_token = mag_find_token_from_descr(wpt->icon_descr);
+  icon_token = mag_find_token_from_descr(wpt->ext->icon_descr);
 
   lon = degrees2ddmm(wpt->longitude);
   lat = degrees2ddmm(wpt->latitude);
@@ -73,6 +73,7 @@ static bounds all_bounds;
 static int next_trkpt_is_new_seg;
 
 static format_specific_data** fs_ptr;
+static Waypoint* fs_wpt;	/* owner of fs_ptr, until it's needed */
 
 
 #define MYNAME "GPX"
@@ -229,12 +230,12 @@ gpx_rm_from_global(gpx_global_entry* ge)
 // zillion reference files.
 static inline QString toString(double d)
 {
-  return QString::number(d, 'f', 9);
+  return fixed_to_string(d, 9);
 };
 
 static inline QString toString(float f)
 {
-  return QString::number(f, 'f', 6);
+  return fixed_to_string(f, 6);
 };
 
 
@@ -483,7 +484,9 @@ tag_wpt(const QXmlStreamAttributes& attr)
   if (attr.hasAttribute("lon")) {
     wpt_tmp->longitude = attr.value("lon").toString().toDouble();
   }
-  fs_ptr = &wpt_tmp->fs;
+  /* don't give every point an extension block for nothing */
+  fs_ptr = NULL;
+  fs_wpt = wpt_tmp;
 }
 
 static void
@@ -529,6 +532,10 @@ start_something_else(const QString el, const QXmlStreamAttributes& attr)
   xml_tag* new_tag;
   fs_xml* fs_gpx;
 
+  if (fs_wpt) {
+    fs_ptr = &fs_wpt->AllocExt()->fs;
+    fs_wpt = NULL;
+  }
   if (!fs_ptr) {
     return;
   }
@@ -659,6 +666,7 @@ gpx_start(const QString& el, const QXmlStreamAttributes& attr)
     rte_head = route_head_alloc();
     route_add_head(rte_head);
     fs_ptr = &rte_head->fs;
+    fs_wpt = NULL;
     break;
   case tt_rte_rtept:
     tag_wpt(attr);
@@ -667,6 +675,7 @@ gpx_start(const QString& el, const QXmlStreamAttributes& attr)
     trk_head = route_head_alloc();
     track_add_head(trk_head);
     fs_ptr = &trk_head->fs;
+    fs_wpt = NULL;
     break;
   case tt_trk_trkseg_trkpt:
     tag_wpt(attr);
@@ -800,8 +809,8 @@ gs_get_container(geocache_container t)
   return "Unknown";
 }
 
-gpsbabel::DateTime
-xml_parse_time(const QString& dateTimeString)
+static gpsbabel::DateTime
+xml_parse_time_generic(const QString& dateTimeString)
 {
   int off_hr = 0;
   int off_min = 0;
@@ -871,6 +880,105 @@ xml_parse_time(const QString& dateTimeString)
   return dt;
 }
 
+/*
+ * Value of the n ASCII digits at p, or -1 if any of them isn't one.
+ */
+static int
+xml_time_digits(const QChar* p, int n)
+{
+  int v = 0;
+  while (n--) {
+    ushort c = (p++)->unicode();
+    if (c < '0' || c > '9') {
+      return -1;
+    }
+    v = v * 10 + (c - '0');
+  }
+  return v;
+}
+
+/*
+ * Parse the common "YYYY-MM-DDTHH:MM:SS[.s+][Z|+HH:MM|-HH:MM]" form
+ * in place, without copying or scanf.  Anything else is handed to
+ * xml_parse_time_generic(), and the result is computed exactly as
+ * it would be there.
+ */
+static gpsbabel::DateTime
+xml_parse_time(const QChar* p, int len)
+{
+  int year, mon, mday, hour, min, sec;
+  int off_hr = 0;
+  int off_min = 0;
+  int off_sign = 1;
+  double fsec = 0;
+  int i = 19;
+
+  if (len < 19 ||
+      p[4] != '-' || p[7] != '-' || p[10] != 'T' ||
+      p[13] != ':' || p[16] != ':' ||
+      (year = xml_time_digits(p, 4)) < 0 ||
+      (mon = xml_time_digits(p + 5, 2)) < 0 ||
+      (mday = xml_time_digits(p + 8, 2)) < 0 ||
+      (hour = xml_time_digits(p + 11, 2)) < 0 ||
+      (min = xml_time_digits(p + 14, 2)) < 0 ||
+      (sec = xml_time_digits(p + 17, 2)) < 0) {
+    return xml_parse_time_generic(QString(p, len));
+  }
+
+  if (i < len && p[i] == '.') {
+    char frac[24];
+    int n = 0;
+    frac[n++] = '.';
+    for (i++; i < len && p[i].unicode() >= '0' && p[i].unicode() <= '9'; i++) {
+      if (n == (int) sizeof(frac) - 1) {
+        return xml_parse_time_generic(QString(p, len));
+      }
+      frac[n++] = p[i].toLatin1();
+    }
+    frac[n] = '\0';
+    fsec = strtod(frac, NULL);
+  }
+
+  if (i < len) {
+    if (p[i] == 'Z' && i + 1 == len) {
+      /* zulu time; offsets stay at defaults */
+    } else if ((p[i] == '+' || p[i] == '-') && i + 6 == len && p[i + 3] == ':' &&
+               (off_hr = xml_time_digits(p + i + 1, 2)) >= 0 &&
+               (off_min = xml_time_digits(p + i + 4, 2)) >= 0) {
+      if (p[i] == '-') {
+        off_sign = -1;
+      }
+    } else {
+      return xml_parse_time_generic(QString(p, len));
+    }
+  }
+
+  QDate date(year, mon, mday);
+  QTime time(hour, min, sec);
+
+  // Fractional part of time.
+  if (fsec) {
+    time = time.addMSecs(lround(fsec * 1000));
+  }
+
+  // Any offsets that were stuck at the end.
+  time = time.addSecs(-off_sign * off_hr * 3600 - off_sign * off_min * 60);
+
+  return QDateTime(date, time, Qt::UTC);
+}
+
+gpsbabel::DateTime
+xml_parse_time(const QString& dateTimeString)
+{
+  return xml_parse_time(dateTimeString.constData(), dateTimeString.size());
+}
+
+gpsbabel::DateTime
+xml_parse_time(const QStringRef& dateTimeString)
+{
+  return xml_parse_time(dateTimeString.constData(), dateTimeString.size());
+}
+
 static void
 gpx_end(const QString& el)
 {
@@ -927,7 +1035,7 @@ gpx_end(const QString& el)
     wpt_tmp = NULL;
     break;
   case tt_cache_name:
-    wpt_tmp->notes = cdatastr;
+    wpt_tmp->AllocExt()->notes = cdatastr;
     break;
   case tt_cache_container:
     wpt_tmp->AllocGCData()->container = gs_mkcont(cdatastr);
@@ -974,7 +1082,7 @@ gpx_end(const QString& el)
      */
   case tt_cache_log_type:
     if ((cdatastr.compare("Found it") == 0) &&
-        (0 == wpt_tmp->gc_data->last_found.toTime_t())) {
+        (0 == wpt_tmp->ext->gc_data->last_found.toTime_t())) {
       wpt_tmp->AllocGCData()->last_found = gc_log_date;
     }
     gc_log_date = QDateTime();
@@ -1076,10 +1184,10 @@ gpx_end(const QString& el)
     WAYPT_SET(wpt_tmp, speed, cdatastr.toDouble());
     break;
   case tt_trk_trkseg_trkpt_heartrate:
-    wpt_tmp->heartrate = cdatastr.toDouble();
+    wpt_tmp->AllocExt()->heartrate = cdatastr.toDouble();
     break;
   case tt_trk_trkseg_trkpt_cadence:
-    wpt_tmp->cadence = cdatastr.toDouble();
+    wpt_tmp->AllocExt()->cadence = cdatastr.toDouble();
     break;
 
     /*
@@ -1092,7 +1200,7 @@ gpx_end(const QString& el)
     wpt_tmp->shortname = cdatastr;
     break;
   case tt_wpttype_sym:
-    wpt_tmp->icon_descr = cdatastr;
+    wpt_tmp->AllocExt()->icon_descr = intern(cdatastr);
     break;
   case tt_wpttype_time:
     wpt_tmp->SetCreationTime(xml_parse_time(cdatastr));
@@ -1104,16 +1212,16 @@ gpx_end(const QString& el)
     wpt_tmp->description = cdatastr;
     break;
   case tt_wpttype_desc:
-    wpt_tmp->notes = cdatastr;
+    wpt_tmp->AllocExt()->notes = cdatastr;
     break;
   case tt_wpttype_pdop:
-    wpt_tmp->pdop = cdatastr.toDouble();
+    wpt_tmp->AllocExt()->pdop = cdatastr.toDouble();
     break;
   case tt_wpttype_hdop:
-    wpt_tmp->hdop = cdatastr.toDouble();
+    wpt_tmp->AllocExt()->hdop = cdatastr.toDouble();
     break;
   case tt_wpttype_vdop:
-    wpt_tmp->vdop = cdatastr.toDouble();
+    wpt_tmp->AllocExt()->vdop = cdatastr.toDouble();
     break;
   case tt_wpttype_sat:
     wpt_tmp->sat = cdatastr.toDouble();
@@ -1213,6 +1321,9 @@ gpx_rd_init(const char* fname)
   }
 
   fs_ptr = NULL;
+  fs_wpt = NULL;
+  /* points are only handed over at their end tags */
+  traits_add_complete();
 }
 
 static
@@ -1332,10 +1443,10 @@ fprint_xml_chain(xml_tag* tag, const Waypoint* wpt)
       if (tag->child) {
         fprint_xml_chain(tag->child, wpt);
       }
-      if (wpt && wpt->gc_data->exported.isValid() &&
+      if (wpt && wpt->ext->gc_data->exported.isValid() &&
           tag->tagname.compare("groundspeak:cache") == 0) {
         writer->writeTextElement("time",
-                                 wpt->gc_data->exported.toPrettyString());
+                                 wpt->ext->gc_data->exported.toPrettyString());
       }
       writer->writeEndElement();
     }
@@ -1436,14 +1547,14 @@ gpx_write_common_acc(const Waypoint* waypointp)
   if (waypointp->sat > 0) {
     writer->writeTextElement("sat", QString::number(waypointp->sat));
   }
-  if (waypointp->hdop) {
-    writer->writeTextElement("hdop", toString(waypointp->hdop));
+  if (waypointp->ext->hdop) {
+    writer->writeTextElement("hdop", toString(waypointp->ext->hdop));
   }
-  if (waypointp->vdop) {
-    writer->writeTextElement("vdop", toString(waypointp->vdop));
+  if (waypointp->ext->vdop) {
+    writer->writeTextElement("vdop", toString(waypointp->ext->vdop));
   }
-  if (waypointp->pdop) {
-    writer->writeTextElement("pdop", toString(waypointp->pdop));
+  if (waypointp->ext->pdop) {
+    writer->writeTextElement("pdop", toString(waypointp->ext->pdop));
   }
   /* TODO: ageofdgpsdata should go here */
   /* TODO: dgpsid should go here */
@@ -1454,7 +1565,7 @@ static void
 gpx_write_common_position(const Waypoint* waypointp, const gpx_point_type point_type)
 {
   if (waypointp->altitude != unknown_alt) {
-    writer->writeTextElement("ele", QString::number(waypointp->altitude, 'f', 6));
+    writer->writeTextElement("ele", fixed_to_string(waypointp->altitude, 6));
   }
   QString t = waypointp->CreationTimeXML();
   writer->writeOptionalTextElement("time", t);
@@ -1469,7 +1580,7 @@ gpx_write_common_position(const Waypoint* waypointp, const gpx_point_type point_
   }
   /* TODO:  magvar should go here */
   if (WAYPT_HAS(waypointp, geoidheight)) {
-    writer->writeOptionalTextElement("geoidheight",QString::number(waypointp->geoidheight, 'f', 1));
+    writer->writeOptionalTextElement("geoidheight",fixed_to_string(waypointp->ext->geoidheight, 1));
   }
 }
 
@@ -1479,15 +1590,15 @@ gpx_write_common_extensions(const Waypoint* waypointp, const gpx_point_type poin
   // gpx version we are writing is >= 1.1.
   if ((opt_humminbirdext && (WAYPT_HAS(waypointp, depth) || WAYPT_HAS(waypointp, temperature))) ||
       (opt_garminext && gpxpt_waypoint==point_type && (WAYPT_HAS(waypointp, proximity) || WAYPT_HAS(waypointp, temperature) || WAYPT_HAS(waypointp, depth))) ||
-      (opt_garminext && gpxpt_track==point_type && (WAYPT_HAS(waypointp, temperature) || WAYPT_HAS(waypointp, depth) || waypointp->heartrate != 0 || waypointp->cadence != 0))) {
+      (opt_garminext && gpxpt_track==point_type && (WAYPT_HAS(waypointp, temperature) || WAYPT_HAS(waypointp, depth) || waypointp->ext->heartrate != 0 || waypointp->ext->cadence != 0))) {
     writer->writeStartElement("extensions");
 
     if (opt_humminbirdext) {
       if (WAYPT_HAS(waypointp, depth)) {
-        writer->writeTextElement("h:depth", toString(waypointp->depth * 100.0));
+        writer->writeTextElement("h:depth", toString(waypointp->ext->depth * 100.0));
       }
       if (WAYPT_HAS(waypointp, temperature)) {
-        writer->writeTextElement("h:temperature", toString(waypointp->temperature));
+        writer->writeTextElement("h:temperature", toString(waypointp->ext->temperature));
       }
     }
 
@@ -1501,13 +1612,13 @@ gpx_write_common_extensions(const Waypoint* waypointp, const gpx_point_type poin
         if (WAYPT_HAS(waypointp, proximity) || WAYPT_HAS(waypointp, temperature) || WAYPT_HAS(waypointp, depth)) {
           writer->writeStartElement("gpxx:WaypointExtension");
           if (WAYPT_HAS(waypointp, proximity)) {
-            writer->writeTextElement("gpxx:Proximity", toString(waypointp->proximity));
+            writer->writeTextElement("gpxx:Proximity", toString(waypointp->ext->proximity));
           }
           if (WAYPT_HAS(waypointp, temperature)) {
-            writer->writeTextElement("gpxx:Temperature", toString(waypointp->temperature));
+            writer->writeTextElement("gpxx:Temperature", toString(waypointp->ext->temperature));
           }
           if (WAYPT_HAS(waypointp, depth)) {
-            writer->writeTextElement("gpxx:Depth", toString(waypointp->depth));
+            writer->writeTextElement("gpxx:Depth", toString(waypointp->ext->depth));
           }
           writer->writeEndElement(); // "gpxx:WaypointExtension"
         }
@@ -1516,20 +1627,20 @@ gpx_write_common_extensions(const Waypoint* waypointp, const gpx_point_type poin
         /* we don't have any appropriate data for the children of gpxx:RoutePointExtension */
         break;
       case gpxpt_track:
-        if (WAYPT_HAS(waypointp, temperature) || WAYPT_HAS(waypointp, depth) || waypointp->heartrate != 0 || waypointp->cadence != 0) {
+        if (WAYPT_HAS(waypointp, temperature) || WAYPT_HAS(waypointp, depth) || waypointp->ext->heartrate != 0 || waypointp->ext->cadence != 0) {
           // gpxtpx:TrackPointExtension is a replacement for gpxx:TrackPointExtension.
           writer->writeStartElement("gpxtpx:TrackPointExtension");
           if (WAYPT_HAS(waypointp, temperature)) {
-            writer->writeTextElement("gpxtpx:atemp", toString(waypointp->temperature));
+            writer->writeTextElement("gpxtpx:atemp", toString(waypointp->ext->temperature));
           }
           if (WAYPT_HAS(waypointp, depth)) {
-            writer->writeTextElement("gpxtpx:depth", toString(waypointp->depth));
+            writer->writeTextElement("gpxtpx:depth", toString(waypointp->ext->depth));
           }
-          if (waypointp->heartrate != 0) {
-            writer->writeTextElement("gpxtpx:hr", QString::number(waypointp->heartrate));
+          if (waypointp->ext->heartrate != 0) {
+            writer->writeTextElement("gpxtpx:hr", QString::number(waypointp->ext->heartrate));
           }
-          if (waypointp->cadence != 0) {
-            writer->writeTextElement("gpxtpx:cad", QString::number(waypointp->cadence));
+          if (waypointp->ext->cadence != 0) {
+            writer->writeTextElement("gpxtpx:cad", QString::number(waypointp->ext->cadence));
           }
           writer->writeEndElement(); // "gpxtpx:TrackPointExtension"
         }
@@ -1547,14 +1658,14 @@ gpx_write_common_description(const Waypoint* waypointp, QString oname)
   writer->writeOptionalTextElement("name", oname);
 
   writer->writeOptionalTextElement("cmt", waypointp->description);
-  if (!waypointp->notes.isEmpty()) {
-    writer->writeTextElement("desc", waypointp->notes);
+  if (!waypointp->ext->notes.isEmpty()) {
+    writer->writeTextElement("desc", waypointp->ext->notes);
   } else {
     writer->writeOptionalTextElement("desc", waypointp->description);
   }
   /* TODO: src should go here */
   write_gpx_url(waypointp);
-  writer->writeOptionalTextElement("sym", waypointp->icon_descr);
+  writer->writeOptionalTextElement("sym", waypointp->ext->icon_descr);
   /* TODO: type should go here */
 }
 
@@ -1577,7 +1688,7 @@ gpx_waypt_pr(const Waypoint* waypointp)
   gpx_write_common_acc(waypointp);
 
   if (!(opt_humminbirdext || opt_garminext)) {
-    fs_gpx = (fs_xml*)fs_chain_find(waypointp->fs, FS_GPX);
+    fs_gpx = (fs_xml*)fs_chain_find(waypointp->ext->fs, FS_GPX);
     gmsd = GMSD_FIND(waypointp);
     if (fs_gpx) {
       if (! gmsd) {
@@ -1663,7 +1774,7 @@ gpx_track_disp(const Waypoint* waypointp)
   gpx_write_common_acc(waypointp);
 
   if (!(opt_humminbirdext || opt_garminext)) {
-    fs_gpx = (fs_xml*)fs_chain_find(waypointp->fs, FS_GPX);
+    fs_gpx = (fs_xml*)fs_chain_find(waypointp->ext->fs, FS_GPX);
     if (fs_gpx) {
       fprint_xml_chain(fs_gpx->tag, waypointp);
     }
@@ -1745,7 +1856,7 @@ gpx_route_disp(const Waypoint* waypointp)
   gpx_write_common_acc(waypointp);
 
   if (!(opt_humminbirdext || opt_garminext)) {
-    fs_gpx = (fs_xml*)fs_chain_find(waypointp->fs, FS_GPX);
+    fs_gpx = (fs_xml*)fs_chain_find(waypointp->ext->fs, FS_GPX);
     if (fs_gpx) {
       fprint_xml_chain(fs_gpx->tag, waypointp);
     }
@@ -1768,20 +1879,12 @@ void gpx_route_pr()
   route_disp_all(gpx_route_hdr, gpx_route_tlr, gpx_route_disp);
 }
 
-static void
-gpx_waypt_bound_calc(const Waypoint* waypointp)
-{
-  waypt_add_to_bounds(&all_bounds, waypointp);
-}
-
 static void
 gpx_write_bounds(void)
 {
-  waypt_init_bounds(&all_bounds);
-
-  waypt_disp_all(gpx_waypt_bound_calc);
-  route_disp_all(NULL, NULL, gpx_waypt_bound_calc);
-  track_disp_all(NULL, NULL, gpx_waypt_bound_calc);
+  waypt_compute_bounds(&all_bounds);
+  route_add_all_to_bounds(&all_bounds);
+  track_add_all_to_bounds(&all_bounds);
 
   if (waypt_bounds_valid(&all_bounds)) {
     writer->writeStartElement("bounds");
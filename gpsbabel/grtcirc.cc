@@ -22,6 +22,7 @@
 #include <errno.h>
 #include <math.h>
 #include <stdio.h>
+#include <limits>
 
 #include "defs.h"
 #include "grtcirc.h"
@@ -307,6 +308,103 @@ double linedist(double lat1, double lon1,
   return linedistprj(lat1, lon1, lat2, lon2, lat3, lon3, &dummy, &dummy, &dummy);
 }
 
+/*
+ * The array kernels keep the operand order of their scalar counterparts
+ * so that the results agree bit for bit on the same inputs.  The win
+ * comes from hoisting the per-point sin/cos of latitude out of the
+ * per-leg work (each point takes part in two legs) and from running
+ * straight-line, branch-free loops over contiguous memory that the
+ * compiler is free to vectorize.
+ */
+
+void gcdist_heading_vec(const double* lat, const double* lon, int n,
+                        double* dist, double* hdg)
+{
+  double* slat;
+  double* clat;
+  int i;
+
+  if (n <= 0) {
+    return;
+  }
+
+  slat = (double*) xmalloc(n * sizeof(double));
+  clat = (double*) xmalloc(n * sizeof(double));
+  for (i = 0; i < n; i++) {
+    slat[i] = sin(lat[i]);
+    clat[i] = cos(lat[i]);
+  }
+
+  if (dist) {
+    dist[0] = 0;
+    for (i = 1; i < n; i++) {
+      double sdlat = sin((lat[i-1] - lat[i]) / 2.0);
+      double sdlon = sin((lon[i-1] - lon[i]) / 2.0);
+      double res = sqrt(sdlat * sdlat + clat[i-1] * clat[i] * sdlon * sdlon);
+      res = res > 1.0 ? 1.0 : res;
+      res = asin(res);
+      /* NaN compares unequal to itself; gcdist() returns 0 there too. */
+      dist[i] = (res == res) ? 2.0 * res : 0;
+    }
+  }
+
+  if (hdg) {
+    hdg[0] = 0;
+    for (i = 1; i < n; i++) {
+      double dlon = lon[i-1] - lon[i];
+      double v1 = sin(dlon) * clat[i];
+      double v2 = clat[i-1] * slat[i] - slat[i-1] * clat[i] * cos(dlon);
+      double h;
+      v1 = fabs(v1) < 1e-15 ? 0.0 : v1;
+      v2 = fabs(v2) < 1e-15 ? 0.0 : v2;
+      h = 360.0 - DEG(atan2(v1, v2));
+      hdg[i] = h >= 360.0 ? h - 360.0 : h;
+    }
+  }
+
+  xfree(slat);
+  xfree(clat);
+}
+
+void gcdist_vec(const double* lat, const double* lon, int n, double* dist)
+{
+  gcdist_heading_vec(lat, lon, n, dist, NULL);
+}
+
+void heading_true_degrees_vec(const double* lat, const double* lon, int n,
+                              double* hdg)
+{
+  gcdist_heading_vec(lat, lon, n, NULL, hdg);
+}
+
+void cumdist_vec(const double* leg, int n, double* cum)
+{
+  double total = 0;
+  int i;
+
+  for (i = 0; i < n; i++) {
+    total += leg[i];
+    cum[i] = total;
+  }
+}
+
+void speed_vec(const double* dist, const double* time, int n, double units,
+               double* speed)
+{
+  const double no_speed = std::numeric_limits<double>::quiet_NaN();
+  int i;
+
+  if (n <= 0) {
+    return;
+  }
+
+  speed[0] = no_speed;
+  for (i = 1; i < n; i++) {
+    double dt = fabs(time[i] - time[i-1]);
+    speed[i] = (dt > 0) ? dist[i] / (dt / units) : no_speed;
+  }
+}
+
 /*
  * Compute the position of a point partially along the geodesic from
  * lat1,lon1 to lat2,lon2
@@ -44,6 +44,28 @@ void linepart(double lat1, double lon1,
               double frac,
               double* reslat, double* reslon);
 
+/*
+ * Array forms of the above for whole tracks.  lat[] and lon[] hold n
+ * points in radians; element i of each output describes the leg from
+ * point i-1 to point i, and element 0 is zero.  Results match gcdist()
+ * and heading_true_degrees() on the same pair of points.
+ */
+void gcdist_vec(const double* lat, const double* lon, int n, double* dist);
+void heading_true_degrees_vec(const double* lat, const double* lon, int n,
+                              double* hdg);
+void gcdist_heading_vec(const double* lat, const double* lon, int n,
+                        double* dist, double* hdg);
+
+/* Running total of leg[]; cum[i] is the sum of leg[0..i]. */
+void cumdist_vec(const double* leg, int n, double* cum);
+
+/*
+ * Speed over each leg: dist[i] / (|time[i] - time[i-1]| / units).
+ * Legs with no elapsed time, or with a NaN time at either end, get NaN.
+ */
+void speed_vec(const double* dist, const double* time, int n, double units,
+               double* speed);
+
 /* Degrees to radians */
 #define DEG(x) ((x)*180.0/M_PI)
 
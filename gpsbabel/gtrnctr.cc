@@ -308,29 +308,29 @@ gtc_waypt_pr(const Waypoint* wpt)
   if (wpt->altitude != unknown_alt) {
     gtc_write_xml(0, "<AltitudeMeters>%.1f</AltitudeMeters>\n", wpt->altitude);
   }
-  if (wpt->odometer_distance) {
-    gtc_write_xml(0, "<DistanceMeters>%.2f</DistanceMeters>\n", wpt->odometer_distance);
+  if (wpt->ext->odometer_distance) {
+    gtc_write_xml(0, "<DistanceMeters>%.2f</DistanceMeters>\n", wpt->ext->odometer_distance);
   }
   // TODO: find a schema extension to include wpt->course and wpt->temperature
   // TODO: find a way to include DistanceMeters from odometer information
-  if (wpt->heartrate) {
+  if (wpt->ext->heartrate) {
     //gtc_write_xml(0, "<HeartRateBpm>%d</HeartRateBpm>\n", wpt->heartrate);
     gtc_write_xml(1, "<HeartRateBpm xsi:type=\"HeartRateInBeatsPerMinute_t\">\n");
-    gtc_write_xml(0,"<Value>%d</Value>\n", wpt->heartrate);
+    gtc_write_xml(0,"<Value>%d</Value>\n", wpt->ext->heartrate);
     gtc_write_xml(-1,"</HeartRateBpm>\n");
   }
-  if (wpt->cadence) {
-    gtc_write_xml(0, "<Cadence>%d</Cadence>\n", wpt->cadence);
+  if (wpt->ext->cadence) {
+    gtc_write_xml(0, "<Cadence>%d</Cadence>\n", wpt->ext->cadence);
   }
-  if (wpt->speed || wpt->power) {
+  if (wpt->speed || wpt->ext->power) {
     gtc_write_xml(1, "<Extensions>\n");
     gtc_write_xml(1, "<TPX xmlns=\"http://www.garmin.com/xmlschemas/ActivityExtension/v2\">\n");
     /* see http://www8.garmin.com/xmlschemas/ActivityExtensionv2.xsd */
     if (wpt->speed) {
       gtc_write_xml(0, "<Speed>%.3f</Speed>\n", wpt->speed);
     }
-    if (wpt->power) {
-      gtc_write_xml(0, "<Watts>%.0f</Watts>\n", wpt->power);
+    if (wpt->ext->power) {
+      gtc_write_xml(0, "<Watts>%.0f</Watts>\n", wpt->ext->power);
     }
     gtc_write_xml(-1, "</TPX>\n");
     gtc_write_xml(-1, "</Extensions>\n");
@@ -550,21 +550,21 @@ gtc_trk_alt(xg_string args, const QXmlStreamAttributes*)
 
 void gtc_trk_dist(const QString& args, const QXmlStreamAttributes*)
 {
-  wpt_tmp->odometer_distance = args.toDouble();
+  wpt_tmp->AllocExt()->odometer_distance = args.toDouble();
 }
 void gtc_trk_hr(const QString& args, const QXmlStreamAttributes*)
 {
-  wpt_tmp->heartrate = args.toDouble();
+  wpt_tmp->AllocExt()->heartrate = args.toDouble();
 }
 void gtc_trk_cad(const QString& args, const QXmlStreamAttributes*)
 {
-  wpt_tmp->cadence = args.toDouble();
+  wpt_tmp->AllocExt()->cadence = args.toDouble();
 }
 
 void
 gtc_trk_pwr(xg_string args, const QXmlStreamAttributes*)
 {
-  wpt_tmp->power = args.toDouble();
+  wpt_tmp->AllocExt()->power = args.toDouble();
 }
 
 void
@@ -617,7 +617,7 @@ void gtc_wpt_ident(const QString& args, const QXmlStreamAttributes*)
 {
   wpt_tmp->shortname = (args);
   /* Set also as notes for compatibility with garmin usb format */
-  wpt_tmp->notes = (args);
+  wpt_tmp->AllocExt()->notes = (args);
 }
 void gtc_wpt_lat(const QString& args, const QXmlStreamAttributes*)
 {
@@ -629,7 +629,7 @@ void gtc_wpt_long(const QString& args, const QXmlStreamAttributes*)
 }
 void gtc_wpt_icon(const QString& args, const QXmlStreamAttributes*)
 {
-  wpt_tmp->icon_descr = args;
+  wpt_tmp->AllocExt()->icon_descr = args;
 }
 void gtc_wpt_notes(const QString& args, const QXmlStreamAttributes*)
 {
@@ -118,6 +118,17 @@ correct_height(const Waypoint* wpt)
 }
 
 
+static void
+correct_route_height(route_head* rte, int)
+{
+  queue* elem, *tmp;
+
+  QUEUE_FOR_EACH(&rte->waypoint_list, elem, tmp) {
+    correct_height((Waypoint*) elem);
+  }
+}
+
+
 static void
 height_init(const char* args)
 {
@@ -141,8 +152,8 @@ static void
 height_process(void)	/* this procedure must be present in vecs */
 {
   waypt_disp_all(correct_height);
-  route_disp_all(NULL, NULL, correct_height);
-  track_disp_all(NULL, NULL, correct_height);
+  route_disp_all_parallel(correct_route_height, NULL);
+  track_disp_all_parallel(correct_route_height, NULL);
 }
 
 
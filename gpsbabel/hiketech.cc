@@ -165,7 +165,7 @@ hiketech_waypt_pr(const Waypoint* wpt)
   writer.writeStartElement("wpt"); 
   writer.setAutoFormattingIndent(-1);
   writer.writeTextElement("ident", wpt->shortname);
-  writer.writeTextElement("sym", wpt->icon_descr);
+  writer.writeTextElement("sym", wpt->ext->icon_descr);
   writer.writeTextElement("lat", QString::number(wpt->latitude, 'f', 6));
   writer.writeTextElement("long", QString::number(wpt->longitude, 'f', 6));
   writer.writeStartElement("color"); 
@@ -206,7 +206,7 @@ void  	ht_ident(xg_string args, const QXmlStreamAttributes*)
 static
 void 	ht_sym(xg_string args, const QXmlStreamAttributes*)
 {
-  wpt_tmp->icon_descr = args;
+  wpt_tmp->AllocExt()->icon_descr = args;
 }
 
 static
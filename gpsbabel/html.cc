@@ -109,50 +109,50 @@ html_disp(const Waypoint* wpt)
     } else {
       gbfprintf(file_out, "%s", CSTRc(wpt->description));
     }
-    if (!wpt->gc_data->placer.isEmpty()) {
-      gbfprintf(file_out, " by %s", CSTR(wpt->gc_data->placer));
+    if (!wpt->ext->gc_data->placer.isEmpty()) {
+      gbfprintf(file_out, " by %s", CSTR(wpt->ext->gc_data->placer));
     }
   }
   gbfprintf(file_out, "</p></td>\n");
 
   gbfprintf(file_out, "<td align=\"right\">");
-  if (wpt->gc_data->terr) {
+  if (wpt->ext->gc_data->terr) {
     gbfprintf(file_out, "<p class=\"gpsbabelcacheinfo\">%d%s / %d%s<br>\n",
-              (int)(wpt->gc_data->diff / 10), (wpt->gc_data->diff%10)?"&frac12;":"",
-              (int)(wpt->gc_data->terr / 10), (wpt->gc_data->terr%10)?"&frac12;":"");
+              (int)(wpt->ext->gc_data->diff / 10), (wpt->ext->gc_data->diff%10)?"&frac12;":"",
+              (int)(wpt->ext->gc_data->terr / 10), (wpt->ext->gc_data->terr%10)?"&frac12;":"");
     gbfprintf(file_out, "%s / %s</p>",
-              gs_get_cachetype(wpt->gc_data->type),
-              gs_get_container(wpt->gc_data->container));
+              gs_get_cachetype(wpt->ext->gc_data->type),
+              gs_get_container(wpt->ext->gc_data->container));
   }
   gbfprintf(file_out, "</td></tr>\n");
 
 
   gbfprintf(file_out, "<tr><td colspan=\"2\">");
-  if (!wpt->gc_data->desc_short.utfstring.isEmpty()) {
-    char* tmpstr = strip_nastyhtml(wpt->gc_data->desc_short.utfstring);
+  if (!wpt->ext->gc_data->desc_short.utfstring.isEmpty()) {
+    char* tmpstr = strip_nastyhtml(wpt->ext->gc_data->desc_short.utfstring);
     gbfprintf(file_out, "<p class=\"gpsbabeldescshort\">%s</p>\n", tmpstr);
     xfree(tmpstr);
   }
-  if (!wpt->gc_data->desc_long.utfstring.isEmpty()) {
-    char* tmpstr = strip_nastyhtml(wpt->gc_data->desc_long.utfstring);
+  if (!wpt->ext->gc_data->desc_long.utfstring.isEmpty()) {
+    char* tmpstr = strip_nastyhtml(wpt->ext->gc_data->desc_long.utfstring);
     gbfprintf(file_out, "<p class=\"gpsbabeldesclong\">%s</p>\n", tmpstr);
     xfree(tmpstr);
   }
-  if (!wpt->gc_data->hint.isEmpty()) {
+  if (!wpt->ext->gc_data->hint.isEmpty()) {
     QString hint;
     if (html_encrypt) {
-      hint = rot13(wpt->gc_data->hint);
+      hint = rot13(wpt->ext->gc_data->hint);
     } else {
-      hint = wpt->gc_data->hint;
+      hint = wpt->ext->gc_data->hint;
     }
     gbfprintf(file_out, "<p class=\"gpsbabelhint\"><strong>Hint:</strong> %s</p>\n", CSTR(hint));
-  } else if (!wpt->notes.isEmpty() && (wpt->description.isEmpty() || wpt->notes != wpt->description)) {
-    gbfprintf(file_out, "<p class=\"gpsbabelnotes\">%s</p>\n", CSTRc(wpt->notes));
+  } else if (!wpt->ext->notes.isEmpty() && (wpt->description.isEmpty() || wpt->ext->notes != wpt->description)) {
+    gbfprintf(file_out, "<p class=\"gpsbabelnotes\">%s</p>\n", CSTRc(wpt->ext->notes));
   }
 
   fs_gpx = NULL;
   if (includelogs) {
-    fs_gpx = (fs_xml*)fs_chain_find(wpt->fs, FS_GPX);
+    fs_gpx = (fs_xml*)fs_chain_find(wpt->ext->fs, FS_GPX);
   }
 
   if (fs_gpx && fs_gpx->tag) {
@@ -306,7 +306,7 @@ humminbird_read_wpt(gbfile* fin)
 
   num_icons = sizeof(humminbird_icons) / sizeof(humminbird_icons[0]);
   if (w.icon < num_icons) {
-    wpt->icon_descr = humminbird_icons[w.icon];
+    wpt->AllocExt()->icon_descr = humminbird_icons[w.icon];
   }
 
   // In newer versions, this is an enum (though it looks like a bitfield)
@@ -703,9 +703,9 @@ humminbird_write_waypoint(const Waypoint* wpt)
   hum.icon   = 255;
 
   // Icon....
-  if (!wpt->icon_descr.isNull()) {
+  if (!wpt->ext->icon_descr.isNull()) {
     for (i = 0; i < num_icons; i++) {
-      if (!wpt->icon_descr.compare(humminbird_icons[i], Qt::CaseInsensitive)) {
+      if (!wpt->ext->icon_descr.compare(humminbird_icons[i], Qt::CaseInsensitive)) {
         hum.icon = i;
         break;
       }
@@ -716,7 +716,7 @@ humminbird_write_waypoint(const Waypoint* wpt)
         char* match;
         int j;
         xasprintf(&match, "*%s*", humminbird_icons[i]);
-        j = wpt->icon_descr.compare(match, Qt::CaseInsensitive);
+        j = wpt->ext->icon_descr.compare(match, Qt::CaseInsensitive);
         xfree(match);
         if (j != 0) {
           hum.icon = i;
@@ -934,7 +934,7 @@ humminbird_write_rtept(const Waypoint* wpt)
   if (humrte == NULL) {
     return;
   }
-  i = gb_ptr2int(wpt->extra_data);
+  i = gb_ptr2int(wpt->ext->extra_data);
   if (i <= 0) {
     return;
   }
@@ -958,12 +958,12 @@ humminbird_write_waypoint_wrapper(const Waypoint* wpt)
   if (!(tmpwpt = map[key])) {
     tmpwpt = (Waypoint*)wpt;
     map[key] = (Waypoint*) wpt;
-    tmpwpt->extra_data = gb_int2ptr(waypoint_num + 1);	/* NOT NULL */
+    tmpwpt->AllocExt()->extra_data = gb_int2ptr(waypoint_num + 1);	/* NOT NULL */
     humminbird_write_waypoint(wpt);
   } else {
-    void* p = tmpwpt->extra_data;
+    void* p = tmpwpt->ext->extra_data;
     tmpwpt = (Waypoint*)wpt;
-    tmpwpt->extra_data = p;
+    tmpwpt->AllocExt()->extra_data = p;
   }
 
   xfree(key);
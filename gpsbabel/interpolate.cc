@@ -51,110 +51,131 @@ arglist_t interpfilt_args[] = {
   ARG_TERMINATOR
 };
 
-void
-interpfilt_process(void)
+/* The points of each new route, built by interpfilt_route(). */
+static QVector<QList<Waypoint*> > interp_points;
+
+static void
+interpfilt_route(route_head* rte_old, int index)
 {
-  queue* backuproute = NULL;
-  queue* elem, *tmp, *elem2, *tmp2;
-  route_head* rte_new;
-  int count = 0;
+  queue* elem2, *tmp2;
+  QList<Waypoint*>& points = interp_points[index];
   int first = 0;
   double lat1 = 0, lon1 = 0;
   unsigned int time1 = 0;
   unsigned int timen;
   double distn;
   double curdist;
-  double rt1, rn1, rt2, rn2;
 
-  if (opt_route) {
-    route_backup(&count, &backuproute);
-    route_flush_all_routes();
-  } else {
-    track_backup(&count, &backuproute);
-    route_flush_all_tracks();
+  /* Leg lengths of the original route, measured in one pass. */
+  QVector<double> legs;
+  if (opt_dist) {
+    track_arrays ta(rte_old);
+    legs.resize(ta.size());
+    gcdist_vec(ta.lat.constData(), ta.lon.constData(), ta.size(),
+               legs.data());
   }
-  QUEUE_FOR_EACH(backuproute, elem, tmp) {
-    route_head* rte_old = (route_head*)elem;
-
-    rte_new = route_head_alloc();
-    rte_new->rte_name = rte_old->rte_name;
-    rte_new->rte_desc = rte_old->rte_desc;
-    rte_new->fs = fs_chain_copy(rte_old->fs);
-    rte_new->rte_num = rte_old->rte_num;
-    if (opt_route) {
-      route_add_head(rte_new);
+  int leg = 0;
+
+  first = 1;
+  QUEUE_FOR_EACH(&rte_old->waypoint_list, elem2, tmp2) {
+    Waypoint* wpt = (Waypoint*)elem2;
+    if (first) {
+      first = 0;
     } else {
-      track_add_head(rte_new);
-    }
-    first = 1;
-    QUEUE_FOR_EACH(&rte_old->waypoint_list, elem2, tmp2) {
-      Waypoint* wpt = (Waypoint*)elem2;
-      if (first) {
-        first = 0;
-      } else {
-        if (opt_interval &&
-            wpt->creation_time.toTime_t() - time1 > interval) {
-          for (timen = time1+interval;
-               timen < wpt->creation_time.toTime_t();
-               timen += interval) {
+      if (opt_interval &&
+          wpt->creation_time.toTime_t() - time1 > interval) {
+        for (timen = time1+interval;
+             timen < wpt->creation_time.toTime_t();
+             timen += interval) {
+          Waypoint* wpt_new = new Waypoint(*wpt);
+          wpt_new->SetCreationTime(timen);
+          wpt_new->shortname = QString();
+          wpt_new->description = QString();
+
+          linepart(lat1, lon1,
+                   wpt->latitude, wpt->longitude,
+                   (double)(timen-time1)/
+                   (double)(wpt->creation_time.toTime_t() - time1),
+                   &wpt_new->latitude,
+                   &wpt_new->longitude);
+          points.append(wpt_new);
+        }
+      } else if (opt_dist) {
+        curdist = radtomiles(legs[leg]);
+        if (curdist > dist) {
+          for (distn = dist;
+               distn < curdist;
+               distn += dist) {
             Waypoint* wpt_new = new Waypoint(*wpt);
-            wpt_new->SetCreationTime(timen);
+            wpt_new->SetCreationTime(distn/curdist*
+                                     (wpt->creation_time.toTime_t() - time1) + time1);
             wpt_new->shortname = QString();
             wpt_new->description = QString();
-
             linepart(lat1, lon1,
                      wpt->latitude, wpt->longitude,
-                     (double)(timen-time1)/
-                     (double)(wpt->creation_time.toTime_t() - time1),
+                     distn/curdist,
                      &wpt_new->latitude,
                      &wpt_new->longitude);
-            if (opt_route) {
-              route_add_wpt(rte_new, wpt_new);
-            } else {
-              track_add_wpt(rte_new, wpt_new);
-            }
-          }
-        } else if (opt_dist) {
-          rt1 = RAD(lat1);
-          rn1 = RAD(lon1);
-          rt2 = RAD(wpt->latitude);
-          rn2 = RAD(wpt->longitude);
-          curdist = gcdist(rt1, rn1, rt2, rn2);
-          curdist = radtomiles(curdist);
-          if (curdist > dist) {
-            for (distn = dist;
-                 distn < curdist;
-                 distn += dist) {
-              Waypoint* wpt_new = new Waypoint(*wpt);
-              wpt_new->SetCreationTime(distn/curdist*
-                                       (wpt->creation_time.toTime_t() - time1) + time1);
-              wpt_new->shortname = QString();
-              wpt_new->description = QString();
-              linepart(lat1, lon1,
-                       wpt->latitude, wpt->longitude,
-                       distn/curdist,
-                       &wpt_new->latitude,
-                       &wpt_new->longitude);
-              if (opt_route) {
-                route_add_wpt(rte_new, wpt_new);
-              } else {
-                track_add_wpt(rte_new, wpt_new);
-              }
-            }
+            points.append(wpt_new);
           }
         }
       }
-      if (opt_route) {
-        route_add_wpt(rte_new, new Waypoint(*wpt));
-      } else {
-        track_add_wpt(rte_new, new Waypoint(*wpt));
-      }
+    }
+    points.append(new Waypoint(*wpt));
+
+    lat1 = wpt->latitude;
+    lon1 = wpt->longitude;
+    time1 = wpt->creation_time.toTime_t();
+    leg++;
+  }
+}
 
-      lat1 = wpt->latitude;
-      lon1 = wpt->longitude;
-      time1 = wpt->creation_time.toTime_t();
+/*
+ * Adding to the route lists names points and bumps the global counts,
+ * so that is done here, in route order.
+ */
+static void
+interpfilt_route_add(route_head* rte_old, int index)
+{
+  route_head* rte_new;
+
+  rte_new = route_head_alloc();
+  rte_new->rte_name = rte_old->rte_name;
+  rte_new->rte_desc = rte_old->rte_desc;
+  rte_new->fs = fs_chain_copy(rte_old->fs);
+  rte_new->rte_num = rte_old->rte_num;
+  if (opt_route) {
+    route_add_head(rte_new);
+  } else {
+    track_add_head(rte_new);
+  }
+
+  foreach (Waypoint* wpt_new, interp_points[index]) {
+    if (opt_route) {
+      route_add_wpt(rte_new, wpt_new);
+    } else {
+      track_add_wpt(rte_new, wpt_new);
     }
   }
+  interp_points[index].clear();
+}
+
+void
+interpfilt_process(void)
+{
+  queue* backuproute = NULL;
+  int count = 0;
+
+  if (opt_route) {
+    route_backup(&count, &backuproute);
+    route_flush_all_routes();
+  } else {
+    track_backup(&count, &backuproute);
+    route_flush_all_tracks();
+  }
+  interp_points.resize(count);
+  route_q_parallel(backuproute, interpfilt_route, interpfilt_route_add);
+  interp_points.clear();
   route_flush(backuproute);
   xfree(backuproute);
 }
@@ -27,6 +27,10 @@
 #include <string.h>
 #include "gpsdatum.h"
 
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+
 
 static int32 GPS_Math_LatLon_To_UTM_Param(double lat, double lon, int32* zone,
     char* zc, double* Mc, double* E0,
@@ -1844,6 +1848,162 @@ void GPS_Math_Known_Datum_To_Known_Datum_C(double Sphi, double Slam, double SH,
 
 
 
+/* @func GPS_Math_Datum_Transform_Init *********************************
+**
+** Prepare a Molodensky transformation between two known datums.
+** All ellipse and shift parameters are looked up and the constants
+** shared by every point are computed once, so that converting many
+** points costs only the per-point trigonometry.
+**
+** The result is the same as GPS_Math_Known_Datum_To_Known_Datum_M()
+** and, for n1 or n2 being WGS84, GPS_Math_Known_Datum_To_WGS84_M() and
+** GPS_Math_WGS84_To_Known_Datum_M().
+**
+** @param [w] t    [GPS_PDatum_Transform] transformation to set up
+** @param [r] n1   [int32] source datum number from GPS_Datum structure
+** @param [r] n2   [int32] dest   datum number from GPS_Datum structure
+**
+** @return [void]
+************************************************************************/
+void GPS_Math_Datum_Transform_Init(GPS_PDatum_Transform t, int32 n1, int32 n2)
+{
+  double Sif;
+  double Dif;
+  double Sf;
+  double Df;
+  int32  idx1;
+  int32  idx2;
+
+  idx1 = GPS_Datum[n1].ellipse;
+  idx2 = GPS_Datum[n2].ellipse;
+
+  t->Sa = GPS_Ellipse[idx1].a;
+  Sif   = GPS_Ellipse[idx1].invf;
+  Dif   = GPS_Ellipse[idx2].invf;
+
+  Sf = (double)1.0 / Sif;
+  Df = (double)1.0 / Dif;
+
+  t->esq = (double)2.0*Sf - Sf*Sf;
+  t->bda = (double)1.0 - Sf;
+  t->da  = GPS_Ellipse[idx2].a - t->Sa;
+  t->df  = Df - Sf;
+
+  t->dx = -(GPS_Datum[n2].dx - GPS_Datum[n1].dx);
+  t->dy = -(GPS_Datum[n2].dy - GPS_Datum[n1].dy);
+  t->dz = -(GPS_Datum[n2].dz - GPS_Datum[n1].dz);
+
+  t->identity = (n1 == n2);
+
+  return;
+}
+
+
+
+/* @func GPS_Math_Datum_Transform_Array *******************************
+**
+** Apply a prepared Molodensky transformation to arrays of points.
+** Input and output arrays may be the same.  The loop body has no
+** branches and no calls except sin/cos/sqrt, so compilers are able
+** to vectorize it.
+**
+** @param [r] t    [const GPS_ODatum_Transform *] prepared transformation
+** @param [r] n    [int32] number of points
+** @param [r] Sphi [const double *] source latitudes (deg)
+** @param [r] Slam [const double *] source longitudes (deg)
+** @param [r] SH   [const double *] source heights (metres), may be NULL
+** @param [w] Dphi [double *] dest latitudes (deg)
+** @param [w] Dlam [double *] dest longitudes (deg)
+** @param [w] DH   [double *] dest heights (metres), may be NULL
+**
+** @return [void]
+************************************************************************/
+void GPS_Math_Datum_Transform_Array(const GPS_ODatum_Transform* t, int32 n,
+                                    const double* Sphi, const double* Slam,
+                                    const double* SH, double* Dphi,
+                                    double* Dlam, double* DH)
+{
+  const double d2r = (double)((double)GPS_PI/(double)180.);
+  const double r2d = (double)((double)180./(double)GPS_PI);
+  const double Sa  = t->Sa;
+  const double esq = t->esq;
+  const double bda = t->bda;
+  const double da  = t->da;
+  const double df  = t->df;
+  const double dx  = t->dx;
+  const double dy  = t->dy;
+  const double dz  = t->dz;
+  int32 i;
+
+  if (t->identity) {
+    for (i = 0; i < n; i++) {
+      Dphi[i] = Sphi[i];
+      Dlam[i] = Slam[i];
+      if (DH) {
+        DH[i] = SH ? SH[i] : (double)0.0;
+      }
+    }
+    return;
+  }
+
+  for (i = 0; i < n; i++) {
+    double phi = Sphi[i] * d2r;
+    double lam = Slam[i] * d2r;
+    double h   = SH ? SH[i] : (double)0.0;
+    double phis = sin(phi);
+    double phic = cos(phi);
+    double lams = sin(lam);
+    double lamc = cos(lam);
+    double w    = (double)1.0 - esq*phis*phis;
+    double sw   = sqrt(w);
+    double N    = Sa / sw;
+    double M    = Sa * ((double)1.0-esq) / (w * sw);
+    double tmp  = df * ((M/bda)+N*bda) * phis * phic;
+    double tmp2 = da * N * esq * phis * phic / Sa;
+    double dphi;
+    double dlambda;
+
+    tmp2 += ((-dx*phis*lamc-dy*phis*lams) + dz*phic);
+    dphi = (tmp2 + tmp) / (M + h);
+    dlambda = (-dx*lams+dy*lamc) / ((N+h)*phic);
+
+    Dphi[i] = (phi + dphi) * r2d;
+    Dlam[i] = (lam + dlambda) * r2d;
+    if (DH) {
+      DH[i] = h + dx*phic*lamc + dy*phic*lams + dz*phis - da*(Sa/N) +
+              df*bda*N*phis*phis;
+    }
+  }
+
+  return;
+}
+
+
+
+/* @func GPS_Math_Datum_Transform *************************************
+**
+** Apply a prepared Molodensky transformation to a single point
+**
+** @param [r] t    [const GPS_ODatum_Transform *] prepared transformation
+** @param [r] Sphi [double] source latitude (deg)
+** @param [r] Slam [double] source longitude (deg)
+** @param [r] SH   [double] source height  (metres)
+** @param [w] Dphi [double *] dest latitude (deg)
+** @param [w] Dlam [double *] dest longitude (deg)
+** @param [w] DH   [double *] dest height  (metres)
+**
+** @return [void]
+************************************************************************/
+void GPS_Math_Datum_Transform(const GPS_ODatum_Transform* t, double Sphi,
+                              double Slam, double SH, double* Dphi,
+                              double* Dlam, double* DH)
+{
+  GPS_Math_Datum_Transform_Array(t, 1, &Sphi, &Slam, &SH, Dphi, Dlam, DH);
+  return;
+}
+
+
+
 /* @func GPS_Math_WGS84_To_UKOSMap_M ***********************************
 **
 ** Convert WGS84 lat/lon to Ordnance survey map code and easting and
@@ -2562,29 +2722,50 @@ void GPS_Math_UTM_EN_to_LatLon(int ReferenceEllipsoid,
 
 /********************************************************************/
 
-int32 GPS_Lookup_Datum_Index(const char* n)
+/*
+ * Datum names and aliases, folded to lower case, mapped to their index
+ * in GPS_Datum.  Built on first use; aliases take precedence over
+ * datum names and the first of several equal names wins, as with the
+ * sequential search this replaces.
+ *
+ * Readers may run on worker threads, so the index is guarded.
+ */
+static QMutex GPS_Datum_Index_Lock;
+static QHash<QString, int32> GPS_Datum_Index;
+
+static void GPS_Build_Datum_Index(void)
 {
   GPS_PDatum dp;
   GPS_PDatum_Alias al;
+  QHash<QString, int32> aliases;
 
-  for (al = GPS_DatumAlias; al->alias; al++) {
-    if (case_ignore_strcmp(al->alias, n) == 0) {
-      return al->datum;
+  for (dp = GPS_Datum; dp->name; dp++) {
+    QString key = QString(dp->name).toLower();
+    if (!GPS_Datum_Index.contains(key)) {
+      GPS_Datum_Index.insert(key, dp - GPS_Datum);
     }
   }
-
-  for (dp = GPS_Datum; dp->name; dp++) {
-    if (0 == case_ignore_strcmp(dp->name, n)) {
-      return dp - GPS_Datum;
+  for (al = GPS_DatumAlias; al->alias; al++) {
+    QString key = QString(al->alias).toLower();
+    if (!aliases.contains(key)) {
+      aliases.insert(key, al->datum);
+      GPS_Datum_Index.insert(key, al->datum);
     }
   }
+}
 
-  return -1;
+int32 GPS_Lookup_Datum_Index(const char* n)
+{
+  return GPS_Lookup_Datum_Index(QString(n));
 }
 
 int32 GPS_Lookup_Datum_Index(const QString& n)
 {
-  return GPS_Lookup_Datum_Index(CSTR(n));
+  QMutexLocker locker(&GPS_Datum_Index_Lock);
+  if (GPS_Datum_Index.isEmpty()) {
+    GPS_Build_Datum_Index();
+  }
+  return GPS_Datum_Index.value(n.toLower(), -1);
 }
 
 const char*
@@ -7,6 +7,22 @@
 #define GPS_FLTMIN 1.75494351E-38
 #define GPS_FLTMAX 3.402823466E+38
 
+  /*
+   * Prepared datum transformation, see GPS_Math_Datum_Transform_Init()
+   */
+  typedef struct GPS_SDatum_Transform {
+    double Sa;		/* source semi-major axis (metres) */
+    double esq;		/* source eccentricity squared */
+    double bda;		/* 1 - source flattening */
+    double da;		/* dest - source semi-major axis */
+    double df;		/* dest - source flattening */
+    double dx;
+    double dy;
+    double dz;
+    int32  identity;	/* source and dest are the same datum */
+  } GPS_ODatum_Transform, *GPS_PDatum_Transform;
+
+
 
   double GPS_Math_Deg_To_Rad(double v);
   double GPS_Math_Rad_To_Deg(double v);
@@ -90,6 +106,14 @@
       double* Dphi, double* Dlam,
       double* DH, int32 n1, int32 n2);
 
+  void GPS_Math_Datum_Transform_Init(GPS_PDatum_Transform t, int32 n1, int32 n2);
+  void GPS_Math_Datum_Transform(const GPS_ODatum_Transform* t, double Sphi,
+                                double Slam, double SH, double* Dphi,
+                                double* Dlam, double* DH);
+  void GPS_Math_Datum_Transform_Array(const GPS_ODatum_Transform* t, int32 n,
+                                      const double* Sphi, const double* Slam,
+                                      const double* SH, double* Dphi,
+                                      double* Dlam, double* DH);
   int32 GPS_Math_WGS84_To_UKOSMap_M(double lat, double lon, double* mE,
                                     double* mN, char* map);
   int32 GPS_Math_UKOSMap_To_WGS84_M(char* map, double mE, double mN,
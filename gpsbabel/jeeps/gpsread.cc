@@ -57,10 +57,24 @@ time_t GPS_Time_Now(void)
 
 
 
+/* Packet framer states */
+enum {
+  RX_DLE,		/* waiting for the leading DLE */
+  RX_ID,		/* packet id */
+  RX_SIZE,		/* payload size */
+  RX_SIZE_DLE,		/* stuffed DLE after a size of DLE */
+  RX_DATA,		/* payload and checksum */
+  RX_DATA_DLE		/* DLE seen: stuffed DLE or DLE ETX follows */
+};
+
 /* @func GPS_Serial_Packet_Read ***********************************************
 **
 ** Read a packet
 **
+** Bytes come from the buffered link layer (GPS_Serial_Getc) and are run
+** through a small state machine that removes DLE stuffing and finds
+** the DLE ETX trailer.
+**
 ** @param [r] fd [int32] file descriptor
 ** @param [w] packet [GPS_PPacket *] packet string
 **
@@ -71,102 +85,115 @@ int32 GPS_Serial_Packet_Read(gpsdevh* fd, GPS_PPacket* packet)
 {
   time_t start;
   int32  n;
-  int32  len;
+  int32  state;
   UC     u;
-  int32  isDLE;
-  UC*     p;
+  UC*    p;
   int32  i;
   UC     chk=0, chk_read;
   const char* m1;
   const char* m2;
 
-  len = 0;
-  isDLE = gpsFalse;
+  state = RX_DLE;
   p = (*packet).data;
 
   start = GPS_Time_Now();
   GPS_Diag("Rx Data:");
   while (GPS_Time_Now() < start+GPS_TIME_OUT) {
-    if ((n=GPS_Serial_Chars_Ready(fd))) {
-      if (GPS_Serial_Read(fd,&u,1)==-1) {
-        perror("read");
-        GPS_Error("GPS_Packet_Read: Read error");
-        gps_errno = FRAMING_ERROR;
+    if ((n = GPS_Serial_Getc(fd, &u, 100)) == 0) {
+      continue;
+    }
+    if (n < 0) {
+      perror("read");
+      GPS_Error("GPS_Packet_Read: Read error");
+      gps_errno = FRAMING_ERROR;
+      return 0;
+    }
+
+    GPS_Diag("%02x ", u);
+
+    switch (state) {
+    case RX_DLE:
+      if (u != DLE) {
+        (void) fprintf(stderr,"GPS_Packet_Read: No DLE.  Data received, but probably not a garmin packet.\n");
+        (void) fflush(stderr);
         return 0;
       }
+      state = RX_ID;
+      continue;
 
-      GPS_Diag("%02x ", u);
+    case RX_ID:
+      (*packet).type = u;
+      state = RX_SIZE;
+      continue;
 
-      if (!len) {
-        if (u != DLE) {
-          (void) fprintf(stderr,"GPS_Packet_Read: No DLE.  Data received, but probably not a garmin packet.\n");
-          (void) fflush(stderr);
-          return 0;
-        }
-        ++len;
-        continue;
-      }
+    case RX_SIZE:
+      (*packet).n = u;
+      state = (u == DLE) ? RX_SIZE_DLE : RX_DATA;
+      continue;
 
-      if (len==1) {
-        (*packet).type = u;
-        ++len;
+    case RX_SIZE_DLE:
+      state = RX_DATA;
+      if (u == DLE) {
         continue;
       }
+      break;
 
+    case RX_DATA:
       if (u == DLE) {
-        if (isDLE) {
-          isDLE = gpsFalse;
-          continue;
-        }
-        isDLE = gpsTrue;
-      }
-
-      if (len == 2) {
-        (*packet).n = u;
-        len = -1;
+        state = RX_DATA_DLE;
         continue;
       }
+      break;
+
+    case RX_DATA_DLE:
+      state = RX_DATA;
+      if (u == ETX) {
+        if (p-(*packet).data-1 != (*packet).n) {
+          GPS_Error("GPS_Packet_Read: Bad count");
+          gps_errno = FRAMING_ERROR;
+          return 0;
+        }
+        chk_read = *(p-1);
 
-      if (u == ETX)
-        if (isDLE) {
-          if (p-(*packet).data-2 != (*packet).n) {
-            GPS_Error("GPS_Packet_Read: Bad count");
-            gps_errno = FRAMING_ERROR;
-            return 0;
-          }
-          chk_read = *(p-2);
-
-          for (i=0,p=(*packet).data; i<(*packet).n; ++i) {
-            chk -= *p++;
-          }
-          chk -= packet->type;
-          chk -= packet->n;
-          if (chk != chk_read) {
-            GPS_Error("CHECKSUM: Read error\n");
-            gps_errno = FRAMING_ERROR;
-            return 0;
-          }
+        for (i=0,p=(*packet).data; i<(*packet).n; ++i) {
+          chk -= *p++;
+        }
+        chk -= packet->type;
+        chk -= packet->n;
+        if (chk != chk_read) {
+          GPS_Error("CHECKSUM: Read error\n");
+          gps_errno = FRAMING_ERROR;
+          return 0;
+        }
 
-          m1 = Get_Pkt_Type((*packet).type, (*packet).data[0], &m2);
-          if (gps_show_bytes) {
-            GPS_Diag(" ");
-            for (i = 0; i < packet->n; i++) {
-              char c = (*packet).data[i];
-              GPS_Diag("%c", isalnum(c) ? c  : '.');
-            }
-            GPS_Diag(" ");
+        m1 = Get_Pkt_Type((*packet).type, (*packet).data[0], &m2);
+        if (gps_show_bytes) {
+          GPS_Diag(" ");
+          for (i = 0; i < packet->n; i++) {
+            char c = (*packet).data[i];
+            GPS_Diag("%c", isalnum(c) ? c  : '.');
           }
-          GPS_Diag("(%-8s%s)\n", m1, m2 ? m2 : "");
-          return (*packet).n;
+          GPS_Diag(" ");
         }
-
-      if (p - packet->data >= MAX_GPS_PACKET_SIZE) {
-        GPS_Error("GPS_Serial_Packet_Read: Bad payload size/no ETX found");
-        gps_errno = FRAMING_ERROR;
-        return 0;
+        GPS_Diag("(%-8s%s)\n", m1, m2 ? m2 : "");
+        return (*packet).n;
       }
-      *p++ = u;
+      if (u != DLE) {
+        /* A lone DLE; keep it along with what follows. */
+        if (p - packet->data >= MAX_GPS_PACKET_SIZE) {
+          break;
+        }
+        *p++ = DLE;
+      }
+      break;
+    }
+
+    if (p - packet->data >= MAX_GPS_PACKET_SIZE) {
+      GPS_Error("GPS_Serial_Packet_Read: Bad payload size/no ETX found");
+      gps_errno = FRAMING_ERROR;
+      return 0;
     }
+    *p++ = u;
   }
 
 
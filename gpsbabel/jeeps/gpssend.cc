@@ -28,6 +28,7 @@
 #include <stdio.h>
 #include <errno.h>
 #include <ctype.h>
+#include <string.h>
 
 
 /* @funcstatic Build_Serial_Packet *************************************
@@ -123,7 +124,7 @@ int32 GPS_Serial_Write_Packet(gpsdevh* fd, GPS_PPacket& packet)
   size_t ret;
   const char* m1, *m2;
   GPS_Serial_OPacket ser_pkt;
-  UC ser_pkt_data[MAX_GPS_PACKET_SIZE * sizeof(UC)];
+  UC ser_pkt_data[(MAX_GPS_PACKET_SIZE + 6) * sizeof(UC)];
   US bytes;
 
   if (packet.type >= 0xff || packet.n >= 0xff) {
@@ -131,33 +132,13 @@ int32 GPS_Serial_Write_Packet(gpsdevh* fd, GPS_PPacket& packet)
     return 0;
   }
 
-  ser_pkt.data = ser_pkt_data;
+  /* Header, stuffed payload and trailer go out in a single write. */
+  ser_pkt.data = ser_pkt_data + 3;
   bytes = Build_Serial_Packet(packet, &ser_pkt);
 
   GPS_Diag("Tx Data:");
   Diag(&ser_pkt.dle, 3);
-  if ((ret=GPS_Serial_Write(fd,(const void*) &ser_pkt.dle,(size_t)3)) == -1) {
-    perror("write");
-    GPS_Error("SEND: Write to GPS failed");
-    return 0;
-  }
-  if (ret!=3) {
-    GPS_Error("SEND: Incomplete write to GPS");
-    return 0;
-  }
-
   Diag(ser_pkt.data, bytes);
-  if ((ret=GPS_Serial_Write(fd,(const void*)ser_pkt.data,(size_t)bytes)) == -1) {
-    perror("write");
-    GPS_Error("SEND: Write to GPS failed");
-    return 0;
-  }
-  if (ret!=bytes) {
-    GPS_Error("SEND: Incomplete write to GPS");
-    return 0;
-  }
-
-
   Diag(&ser_pkt.chk, 3);
 
   GPS_Diag(": ");
@@ -166,12 +147,14 @@ int32 GPS_Serial_Write_Packet(gpsdevh* fd, GPS_PPacket& packet)
   m1 = Get_Pkt_Type(ser_pkt.type, ser_pkt.data[0], &m2);
   GPS_Diag("(%-8s%s)\n", m1, m2 ? m2 : "");
 
-  if ((ret=GPS_Serial_Write(fd,(const void*)&ser_pkt.chk,(size_t)3)) == -1) {
+  memcpy(ser_pkt_data, &ser_pkt.dle, 3);
+  memcpy(ser_pkt.data + bytes, &ser_pkt.chk, 3);
+  if ((ret=GPS_Serial_Write(fd,(const void*)ser_pkt_data,(size_t)bytes + 6)) == -1) {
     perror("write");
     GPS_Error("SEND: Write to GPS failed");
     return 0;
   }
-  if (ret!=3) {
+  if (ret!=(size_t)bytes + 6) {
     GPS_Error("SEND: Incomplete write to GPS");
     return 0;
   }
@@ -64,6 +64,7 @@ char* rxdata[] = {
 
 typedef struct {
   HANDLE comport;
+  GPS_OSerial_Rx rx;
 } win_serial_data;
 
 /*
@@ -174,10 +175,49 @@ int32 GPS_Serial_Chars_Ready(gpsdevh* dh)
   DWORD lpErrors;
   win_serial_data* wsd = (win_serial_data*)dh;
 
+  if (wsd->rx.head != wsd->rx.tail) {
+    return 1;
+  }
   ClearCommError(wsd->comport, &lpErrors, &lpStat);
   return (lpStat.cbInQue > 0);
 }
 
+static GPS_PSerial_Rx GPS_Serial_Rx_Buffer(gpsdevh* dh)
+{
+  return &((win_serial_data*)dh)->rx;
+}
+
+/*
+ * Wait up to msec for input and read whatever is queued, at most size
+ * bytes.  Returns the count, 0 on timeout.
+ */
+static int32 GPS_Serial_Read_Avail(gpsdevh* dh, UC* ibuf, int32 size, int32 msec)
+{
+  COMSTAT lpStat;
+  DWORD lpErrors;
+  DWORD cnt = 0;
+  win_serial_data* wsd = (win_serial_data*)dh;
+
+  for (;;) {
+    ClearCommError(wsd->comport, &lpErrors, &lpStat);
+    if (lpStat.cbInQue > 0) {
+      break;
+    }
+    if (msec <= 0) {
+      return 0;
+    }
+    Sleep(1);
+    msec--;
+  }
+  if (lpStat.cbInQue < (DWORD) size) {
+    size = lpStat.cbInQue;
+  }
+  if (!ReadFile(wsd->comport, ibuf, size, &cnt, NULL)) {
+    return -1;
+  }
+  return cnt;
+}
+
 int32 GPS_Serial_Wait(gpsdevh* fd)
 {
   /* Wait a short time before testing if data is ready.
@@ -193,6 +233,9 @@ int32 GPS_Serial_Wait(gpsdevh* fd)
 
 int32 GPS_Serial_Flush(gpsdevh* fd)
 {
+  win_serial_data* wsd = (win_serial_data*)fd;
+
+  wsd->rx.head = wsd->rx.tail;
   return 1;
 }
 
@@ -318,6 +361,7 @@ int32 GPS_Serial_Set_Baud_Rate(gpsdevh* fd, int br)
 typedef struct {
   int fd;		/* File descriptor */
   struct termios gps_ttysave;
+  GPS_OSerial_Rx rx;
 } posix_serial_data;
 
 /* @func GPS_Serial_Open ***********************************************
@@ -449,6 +493,7 @@ int32 GPS_Serial_Flush(gpsdevh* fd)
 {
   posix_serial_data* psd = (posix_serial_data*)fd;
 
+  psd->rx.head = psd->rx.tail;
   if (tcflush(psd->fd,TCIOFLUSH)) {
     GPS_Serial_Error("SERIAL: tcflush error");
     gps_errno = SERIAL_ERROR;
@@ -506,6 +551,10 @@ int32 GPS_Serial_Chars_Ready(gpsdevh* dh)
   posix_serial_data* psd = (posix_serial_data*)dh;
   int32 fd = psd->fd;
 
+  if (psd->rx.head != psd->rx.tail) {
+    return 1;
+  }
+
 #if GARMULATOR
   static foo;
   /* Return sporadic reads just to torment the rest of the code. */
@@ -531,6 +580,63 @@ int32 GPS_Serial_Chars_Ready(gpsdevh* dh)
 
 
 
+static GPS_PSerial_Rx GPS_Serial_Rx_Buffer(gpsdevh* dh)
+{
+  return &((posix_serial_data*)dh)->rx;
+}
+
+/* @funcstatic GPS_Serial_Read_Avail ***********************************
+**
+** Wait up to msec milliseconds for input, then read all that is
+** available, at most size bytes, in a single read.
+**
+** @param [r] dh [gpsdevh *] device handle
+** @param [w] ibuf [UC *] buffer
+** @param [r] size [int32] buffer size
+** @param [r] msec [int32] milliseconds to wait
+**
+** @return [int32] bytes read, 0 on timeout, -1 on error
+************************************************************************/
+
+static int32 GPS_Serial_Read_Avail(gpsdevh* dh, UC* ibuf, int32 size, int32 msec)
+{
+#if GARMULATOR
+  (void) msec;
+  (void) size;
+  if (!GPS_Serial_Chars_Ready(dh)) {
+    return 0;
+  }
+  return GPS_Serial_Read(dh, ibuf, 1);
+#else
+  fd_set rec;
+  struct timeval t;
+  posix_serial_data* psd = (posix_serial_data*)dh;
+  int32 n;
+
+  FD_ZERO(&rec);
+  FD_SET(psd->fd,&rec);
+
+  t.tv_sec  = msec / 1000;
+  t.tv_usec = (msec % 1000) * 1000;
+  n = select(psd->fd+1,&rec,NULL,NULL,&t);
+  if (n < 0) {
+    return (errno == EINTR) ? 0 : -1;
+  }
+  if (n == 0) {
+    return 0;
+  }
+
+  /* VMIN is 1, so this returns what is queued without blocking. */
+  n = GPS_Serial_Read(dh, ibuf, size);
+  if ((n < 0) && ((errno == EINTR) || (errno == EAGAIN))) {
+    return 0;
+  }
+  return n;
+#endif
+}
+
+
+
 /* @func GPS_Serial_Wait ***********************************************
 **
 ** Wait 80 milliseconds before testing for input. The GPS delay
@@ -696,3 +802,37 @@ int32 GPS_Serial_Set_Baud_Rate(gpsdevh* fd, int br)
 }
 
 #endif /* __WIN32__ */
+
+
+
+/* @func GPS_Serial_Getc ***********************************************
+**
+** Get the next received byte.  When the receive buffer is empty, wait
+** up to msec milliseconds and refill it with everything the port has
+** queued, so a packet costs a handful of reads instead of two system
+** calls per byte.
+**
+** @param [r] dh [gpsdevh *] device handle
+** @param [w] c [UC *] received byte
+** @param [r] msec [int32] milliseconds to wait if nothing is buffered
+**
+** @return [int32] 1 if a byte was returned, 0 on timeout, -1 on error
+************************************************************************/
+
+int32 GPS_Serial_Getc(gpsdevh* dh, UC* c, int32 msec)
+{
+  GPS_PSerial_Rx rx = GPS_Serial_Rx_Buffer(dh);
+
+  if (rx->head == rx->tail) {
+    /* Empty, so everything from tail to the end of the ring is free. */
+    uint32 idx = rx->tail & GPS_SERIAL_RX_MASK;
+    int32 n = GPS_Serial_Read_Avail(dh, rx->data + idx, GPS_SERIAL_RX_SIZE - idx, msec);
+    if (n <= 0) {
+      return n;
+    }
+    rx->tail += n;
+  }
+
+  *c = rx->data[rx->head++ & GPS_SERIAL_RX_MASK];
+  return 1;
+}
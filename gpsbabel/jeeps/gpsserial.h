@@ -7,6 +7,19 @@
 #define usecDELAY 180000	/* Microseconds before GPS sends A001 */
 #define DEFAULT_BAUD 9600
 
+/*
+ * Receive ring buffer.  Whatever the port has available is read in one
+ * go and handed out a byte at a time by GPS_Serial_Getc().
+ */
+#define GPS_SERIAL_RX_SIZE 4096	/* must be a power of two */
+#define GPS_SERIAL_RX_MASK (GPS_SERIAL_RX_SIZE - 1)
+
+  typedef struct GPS_SSerial_Rx {
+    uint32 head;		/* total bytes handed out */
+    uint32 tail;		/* total bytes read from the port */
+    UC     data[GPS_SERIAL_RX_SIZE];
+  } GPS_OSerial_Rx, *GPS_PSerial_Rx;
+
   int32  GPS_Serial_Chars_Ready(gpsdevh* fd);
 // int32  GPS_Serial_Close(int32 fd, const char *port);
 // int32  GPS_Serial_Open(int32 *fd, const char *port);
@@ -19,6 +32,7 @@
   int32  GPS_Serial_Flush(gpsdevh* fd);
 // int32  GPS_Serial_On_NMEA(const char *port, gpsdevh **fd);
   int32  GPS_Serial_Read(gpsdevh* fd, void* ibuf, int size);
+  int32  GPS_Serial_Getc(gpsdevh* fd, UC* c, int32 msec);
   int32  GPS_Serial_Write(gpsdevh* fd, const void* obuf, int size);
   int32  GPS_Serial_Write_Packet(gpsdevh* fd, GPS_PPacket& packet);
   int32  GPS_Serial_Send_Ack(gpsdevh* fd, GPS_PPacket* tra, GPS_PPacket* rec);
@@ -328,7 +328,7 @@ void wpt_coord(const QString& args, const QXmlStreamAttributes*)
 void wpt_icon(xg_string args, const QXmlStreamAttributes*)
 {
   if (wpt_tmp)  {
-    wpt_tmp->icon_descr = args;
+    wpt_tmp->AllocExt()->icon_descr = intern(args);
   }
 }
 
@@ -700,33 +700,33 @@ void kml_output_trkdescription(const route_head* header, computed_trkdata* td)
   if (!header->rte_desc.isEmpty()) {
     kml_td(hwriter, "Description", QString(" %1 ").arg(header->rte_desc));
   }
-  kml_td(hwriter, "Distance", QString(" %1 %2 ").arg(QString::number(distance, 'f', 1)).arg(distance_units));
+  kml_td(hwriter, "Distance", QString(" %1 %2 ").arg(fixed_to_string(distance, 1)).arg(distance_units));
   if (td->min_alt != -unknown_alt) {
-    kml_td(hwriter, "Min Alt", QString(" %1 %2 ").arg(QString::number(min_alt, 'f', 3)).arg(min_alt_units));
+    kml_td(hwriter, "Min Alt", QString(" %1 %2 ").arg(fixed_to_string(min_alt, 3)).arg(min_alt_units));
   }
   if (td->max_alt != unknown_alt) {
-    kml_td(hwriter, "Max Alt", QString(" %1 %2 ").arg(QString::number(max_alt, 'f', 3)).arg(max_alt_units));
+    kml_td(hwriter, "Max Alt", QString(" %1 %2 ").arg(fixed_to_string(max_alt, 3)).arg(max_alt_units));
   }
   if (td->min_spd) {
     const char* spd_units;
     double spd = fmt_speed(td->min_spd, &spd_units);
-    kml_td(hwriter, "Min Speed", QString(" %1 %2 ").arg(QString::number(spd, 'f', 1)).arg(spd_units));
+    kml_td(hwriter, "Min Speed", QString(" %1 %2 ").arg(fixed_to_string(spd, 1)).arg(spd_units));
   }
   if (td->max_spd) {
     const char* spd_units;
     double spd = fmt_speed(td->max_spd, &spd_units);
-    kml_td(hwriter, "Max Speed", QString(" %1 %2 ").arg(QString::number(spd, 'f', 1)).arg(spd_units));
+    kml_td(hwriter, "Max Speed", QString(" %1 %2 ").arg(fixed_to_string(spd, 1)).arg(spd_units));
   }
   if (td->max_spd && td->start && td->end) {
     const char* spd_units;
     time_t elapsed = td->end - td->start;
     double spd = fmt_speed(td->distance_meters / elapsed, &spd_units);
     if (spd > 1.0)  {
-      kml_td(hwriter, "Avg Speed", QString(" %1 %2 ").arg(QString::number(spd, 'f', 1)).arg(spd_units));
+      kml_td(hwriter, "Avg Speed", QString(" %1 %2 ").arg(fixed_to_string(spd, 1)).arg(spd_units));
     }
   }
   if (td->avg_hrt) {
-    kml_td(hwriter, "Avg Heart Rate", QString(" %1 bpm ").arg(QString::number(td->avg_hrt, 'f', 1)));
+    kml_td(hwriter, "Avg Heart Rate", QString(" %1 bpm ").arg(fixed_to_string(td->avg_hrt, 1)));
   }
   if (td->min_hrt < td->max_hrt) {
     kml_td(hwriter, "Min Heart Rate", QString(" %1 bpm ").arg(QString::number(td->min_hrt)));
@@ -735,7 +735,7 @@ void kml_output_trkdescription(const route_head* header, computed_trkdata* td)
     kml_td(hwriter, "Max Heart Rate", QString(" %1 bpm ").arg(QString::number(td->max_hrt)));
   }
   if (td->avg_cad) {
-    kml_td(hwriter, "Avg Cadence", QString(" %1 rpm ").arg(QString::number(td->avg_cad, 'f', 1)));
+    kml_td(hwriter, "Avg Cadence", QString(" %1 rpm ").arg(fixed_to_string(td->avg_cad, 1)));
   }
   if (td->max_cad) {
     kml_td(hwriter, "Max Cadence", QString(" %1 rpm ").arg(QString::number(td->max_cad)));
@@ -810,14 +810,14 @@ void kml_write_coordinates(const Waypoint* waypointp)
 {
   if (kml_altitude_known(waypointp)) {
     writer->writeTextElement("coordinates",
-                             QString::number(waypointp->longitude, 'f', 6) + QString(",") +
-                             QString::number(waypointp->latitude, 'f', 6) + QString(",") +
-                             QString::number(waypointp->altitude, 'f', 2)
+                             fixed_to_string(waypointp->longitude, 6) + QString(",") +
+                             fixed_to_string(waypointp->latitude, 6) + QString(",") +
+                             fixed_to_string(waypointp->altitude, 2)
                             );
   } else {
     writer->writeTextElement("coordinates",
-                             QString::number(waypointp->longitude, 'f', 6) + QString(",") +
-                             QString::number(waypointp->latitude, 'f', 6)
+                             fixed_to_string(waypointp->longitude, 6) + QString(",") +
+                             fixed_to_string(waypointp->latitude, 6)
                             );
   }
 }
@@ -828,8 +828,8 @@ void kml_write_coordinates(const Waypoint* waypointp)
 static void kml_output_lookat(const Waypoint* waypointp)
 {
   writer->writeStartElement("LookAt");
-  writer->writeTextElement("longitude", QString::number(waypointp->longitude, 'f', 6));
-  writer->writeTextElement("latitude", QString::number(waypointp->latitude, 'f', 6));
+  writer->writeTextElement("longitude", fixed_to_string(waypointp->longitude, 6));
+  writer->writeTextElement("latitude", fixed_to_string(waypointp->latitude, 6));
   writer->writeTextElement("tilt","66");
   writer->writeEndElement(); // Close LookAt tag
 }
@@ -864,40 +864,40 @@ static void kml_output_description(const Waypoint* pt)
   hwriter.writeCharacters("\n");
   hwriter.writeStartElement("table");
 
-  kml_td(hwriter, QString("Longitude: %1 ").arg(QString::number(pt->longitude, 'f', 6)));
-  kml_td(hwriter, QString("Latitude: %1 ").arg(QString::number(pt->latitude, 'f', 6)));
+  kml_td(hwriter, QString("Longitude: %1 ").arg(fixed_to_string(pt->longitude, 6)));
+  kml_td(hwriter, QString("Latitude: %1 ").arg(fixed_to_string(pt->latitude, 6)));
 
   if (kml_altitude_known(pt)) {
-    kml_td(hwriter, QString("Altitude: %1 %2 ").arg(QString::number(alt, 'f', 3)).arg(alt_units));
+    kml_td(hwriter, QString("Altitude: %1 %2 ").arg(fixed_to_string(alt, 3)).arg(alt_units));
   }
 
-  if (pt->heartrate) {
-    kml_td(hwriter, QString("Heart rate: %1 ").arg(QString::number(pt->heartrate)));
+  if (pt->ext->heartrate) {
+    kml_td(hwriter, QString("Heart rate: %1 ").arg(QString::number(pt->ext->heartrate)));
   }
 
-  if (pt->cadence) {
-    kml_td(hwriter, QString("Cadence: %1 ").arg(QString::number(pt->cadence)));
+  if (pt->ext->cadence) {
+    kml_td(hwriter, QString("Cadence: %1 ").arg(QString::number(pt->ext->cadence)));
   }
 
   /* Which unit is this temp in? C? F? K? */
   if WAYPT_HAS(pt, temperature) {
-    kml_td(hwriter, QString("Temperature: %1 ").arg(QString::number(pt->temperature, 'f', 1)));
+    kml_td(hwriter, QString("Temperature: %1 ").arg(fixed_to_string(pt->ext->temperature, 1)));
   }
 
   if WAYPT_HAS(pt, depth) {
     const char* depth_units;
-    double depth = fmt_distance(pt->depth, &depth_units);
-    kml_td(hwriter, QString("Depth: %1 %2 ").arg(QString::number(depth, 'f', 1)).arg(depth_units));
+    double depth = fmt_distance(pt->ext->depth, &depth_units);
+    kml_td(hwriter, QString("Depth: %1 %2 ").arg(fixed_to_string(depth, 1)).arg(depth_units));
   }
 
   if WAYPT_HAS(pt, speed) {
     const char* spd_units;
     double spd = fmt_speed(pt->speed, &spd_units);
-    kml_td(hwriter, QString("Speed: %1 %2 ").arg(QString::number(spd, 'f', 1)).arg(spd_units));
+    kml_td(hwriter, QString("Speed: %1 %2 ").arg(fixed_to_string(spd, 1)).arg(spd_units));
   }
 
   if WAYPT_HAS(pt, course) {
-    kml_td(hwriter, QString("Heading: %1 ").arg(QString::number(pt->course, 'f', 1)));
+    kml_td(hwriter, QString("Heading: %1 ").arg(fixed_to_string(pt->course, 1)));
   }
 
   /* This really shouldn't be here, but as of this writing,
@@ -1064,13 +1064,13 @@ static void kml_output_tailer(const route_head* header)
         writer->writeCharacters("\n");
       }
       if (kml_altitude_known(tpt)) {
-        writer->writeCharacters(QString::number(tpt->longitude, 'f', 6) + QString(",") +
-                                QString::number(tpt->latitude, 'f', 6) + QString(",") +
-                                QString::number(tpt->altitude, 'f', 2) + QString("\n")
+        writer->writeCharacters(fixed_to_string(tpt->longitude, 6) + QString(",") +
+                                fixed_to_string(tpt->latitude, 6) + QString(",") +
+                                fixed_to_string(tpt->altitude, 2) + QString("\n")
                                );
       } else {
-        writer->writeCharacters(QString::number(tpt->longitude, 'f', 6) + QString(",") +
-                                QString::number(tpt->latitude, 'f', 6) + QString("\n")
+        writer->writeCharacters(fixed_to_string(tpt->longitude, 6) + QString(",") +
+                                fixed_to_string(tpt->latitude, 6) + QString("\n")
                                );
       }
     }
@@ -1249,7 +1249,7 @@ kml_lookup_gc_icon(const Waypoint* waypointp)
   /* This could be done so much better in C99 with designated
    * initializers...
    */
-  switch (waypointp->gc_data->type) {
+  switch (waypointp->ext->gc_data->type) {
   case gt_traditional:
     icon = "2.png";
     break;
@@ -1303,7 +1303,7 @@ kml_lookup_gc_container(const Waypoint* waypointp)
 {
   const char* cont;
 
-  switch (waypointp->gc_data->container) {
+  switch (waypointp->ext->gc_data->container) {
   case gc_micro:
     cont="micro";
     break;
@@ -1352,7 +1352,7 @@ static QString kml_geocache_get_logs(const Waypoint* wpt)
 {
   QString r;
 
-  fs_xml* fs_gpx = (fs_xml*)fs_chain_find(wpt->fs, FS_GPX);
+  fs_xml* fs_gpx = (fs_xml*)fs_chain_find(wpt->ext->fs, FS_GPX);
   xml_tag* root = NULL;
   xml_tag* curlog = NULL;
   xml_tag* logpart = NULL;
@@ -1431,7 +1431,7 @@ static void kml_write_data_element(const QString& name, const double value)
 {
   writer->writeStartElement("Data");
   writer->writeAttribute("name", name);
-  writer->writeTextElement("value", QString::number(value, 'f', 6));
+  writer->writeTextElement("value", fixed_to_string(value, 6));
   writer->writeEndElement(); // Close Data tag
 }
 
@@ -1487,23 +1487,23 @@ static void kml_geocache_pr(const Waypoint* waypointp)
     kml_write_data_element("gc_name", link.url_link_text_);
   }
 
-  if (!waypointp->gc_data->placer.isEmpty()) {
-    kml_write_data_element("gc_placer", waypointp->gc_data->placer);
+  if (!waypointp->ext->gc_data->placer.isEmpty()) {
+    kml_write_data_element("gc_placer", waypointp->ext->gc_data->placer);
   }
 
-  kml_write_data_element("gc_placer_id", waypointp->gc_data->placer_id);
+  kml_write_data_element("gc_placer_id", waypointp->ext->gc_data->placer_id);
   kml_write_data_element("gc_placed", date_placed);
 
-  kml_write_data_element("gc_diff_stars", kml_gc_mkstar(waypointp->gc_data->diff));
-  kml_write_data_element("gc_terr_stars", kml_gc_mkstar(waypointp->gc_data->terr));
+  kml_write_data_element("gc_diff_stars", kml_gc_mkstar(waypointp->ext->gc_data->diff));
+  kml_write_data_element("gc_terr_stars", kml_gc_mkstar(waypointp->ext->gc_data->terr));
 
   kml_write_data_element("gc_cont_icon", kml_lookup_gc_container(waypointp));
 
   // Highlight any issues with the cache, such as temp unavail
   // or archived.
-  if (waypointp->gc_data->is_archived == status_true) {
+  if (waypointp->ext->gc_data->is_archived == status_true) {
     issues = "&lt;font color=\"red\"&gt;This cache has been archived.&lt;/font&gt;&lt;br/&gt;\n";
-  } else if (waypointp->gc_data->is_available == status_false) {
+  } else if (waypointp->ext->gc_data->is_available == status_false) {
     issues = "&lt;font color=\"red\"&gt;This cache is temporarily unavailable.&lt;/font&gt;&lt;br/&gt;\n";
   }
   kml_write_data_element("gc_issues", issues);
@@ -1511,10 +1511,10 @@ static void kml_geocache_pr(const Waypoint* waypointp)
   kml_write_data_element("gc_lat", waypointp->latitude);
   kml_write_data_element("gc_lon", waypointp->longitude);
 
-  kml_write_data_element("gc_type", gs_get_cachetype(waypointp->gc_data->type));
+  kml_write_data_element("gc_type", gs_get_cachetype(waypointp->ext->gc_data->type));
   kml_write_data_element("gc_icon", is);
-  kml_write_cdata_element("gc_short_desc", waypointp->gc_data->desc_short.utfstring);
-  kml_write_cdata_element("gc_long_desc", waypointp->gc_data->desc_long.utfstring);
+  kml_write_cdata_element("gc_short_desc", waypointp->ext->gc_data->desc_short.utfstring);
+  kml_write_cdata_element("gc_long_desc", waypointp->ext->gc_data->desc_long.utfstring);
   QString logs = kml_geocache_get_logs(waypointp);
   kml_write_cdata_element("gc_logs", logs);
 
@@ -1546,7 +1546,7 @@ static void kml_waypt_pr(const Waypoint* waypointp)
   }
 #endif
 
-  if (waypointp->gc_data->diff && waypointp->gc_data->terr) {
+  if (waypointp->ext->gc_data->diff && waypointp->ext->gc_data->terr) {
     kml_geocache_pr(waypointp);
     return;
   }
@@ -1578,7 +1578,7 @@ static void kml_waypt_pr(const Waypoint* waypointp)
   kml_output_timestamp(waypointp);
 
   // Icon - but only if it looks like a URL.
-  icon = opt_deficon ? opt_deficon : waypointp->icon_descr;
+  icon = opt_deficon ? opt_deficon : waypointp->ext->icon_descr;
   if (icon.contains("://")) {
     writer->writeStartElement("Style");
     writer->writeStartElement("IconStyle");
@@ -1656,19 +1656,19 @@ static void kml_mt_simple_array(const route_head* header,
 
     switch (member) {
     case fld_power:
-      writer->writeTextElement("gx:value", QString::number(wpt->power, 'f', 1));
+      writer->writeTextElement("gx:value", fixed_to_string(wpt->ext->power, 1));
       break;
     case fld_cadence:
-      writer->writeTextElement("gx:value", QString::number(wpt->cadence));
+      writer->writeTextElement("gx:value", QString::number(wpt->ext->cadence));
       break;
     case fld_depth:
-      writer->writeTextElement("gx:value", QString::number(wpt->depth, 'f', 1));
+      writer->writeTextElement("gx:value", fixed_to_string(wpt->ext->depth, 1));
       break;
     case fld_heartrate:
-      writer->writeTextElement("gx:value", QString::number(wpt->heartrate));
+      writer->writeTextElement("gx:value", QString::number(wpt->ext->heartrate));
       break;
     case fld_temperature:
-      writer->writeTextElement("gx:value", QString::number(wpt->temperature, 'f', 1));
+      writer->writeTextElement("gx:value", fixed_to_string(wpt->ext->temperature, 1));
       break;
     default:
       fatal("Bad member type");
@@ -1748,32 +1748,32 @@ static void kml_mt_hdr(const route_head* header)
 
     if (kml_altitude_known(tpt)) {
       writer->writeTextElement("gx:coord",
-                               QString::number(tpt->longitude, 'f', 6) + QString(" ") +
-                               QString::number(tpt->latitude, 'f', 6) + QString(" ") +
-                               QString::number(tpt->altitude, 'f', 2)
+                               fixed_to_string(tpt->longitude, 6) + QString(" ") +
+                               fixed_to_string(tpt->latitude, 6) + QString(" ") +
+                               fixed_to_string(tpt->altitude, 2)
                               );
     } else {
       writer->writeTextElement("gx:coord",
-                               QString::number(tpt->longitude, 'f', 6) + QString(" ") +
-                               QString::number(tpt->latitude, 'f', 6)
+                               fixed_to_string(tpt->longitude, 6) + QString(" ") +
+                               fixed_to_string(tpt->latitude, 6)
                               );
     }
 
     // Capture interesting traits to see if we need to do an ExtendedData
     // section later.
-    if (tpt->cadence) {
+    if (tpt->ext->cadence) {
       has_cadence = 1;
     }
     if (WAYPT_HAS(tpt, depth)) {
       has_depth = 1;
     }
-    if (tpt->heartrate) {
+    if (tpt->ext->heartrate) {
       has_heartrate = 1;
     }
     if (WAYPT_HAS(tpt, temperature)) {
       has_temperature = 1;
     }
-    if (tpt->power) {
+    if (tpt->ext->power) {
       has_power = 1;
     }
   }
@@ -1883,8 +1883,8 @@ void kml_write_AbstractView(void)
     kml_bounds.min_lon = -kml_bounds.max_lon;
   }
 
-  writer->writeTextElement("longitude", QString::number((kml_bounds.min_lon + kml_bounds.max_lon) / 2, 'f', 6));
-  writer->writeTextElement("latitude", QString::number((kml_bounds.min_lat + kml_bounds.max_lat) / 2, 'f', 6));
+  writer->writeTextElement("longitude", fixed_to_string((kml_bounds.min_lon + kml_bounds.max_lon) / 2, 6));
+  writer->writeTextElement("latitude", fixed_to_string((kml_bounds.min_lat + kml_bounds.max_lat) / 2, 6));
 
   // It turns out the length of the diagonal of the bounding box gives us a
   // reasonable guess for setting the camera altitude.
@@ -1894,7 +1894,7 @@ void kml_write_AbstractView(void)
   if (bb_size < 1000) {
     bb_size = 1000;
   }
-  writer->writeTextElement("range", QString::number(bb_size * 1.3, 'f', 6));
+  writer->writeTextElement("range", fixed_to_string(bb_size * 1.3, 6));
 
   writer->writeEndElement(); // Close LookAt tag
 }
@@ -2116,7 +2116,7 @@ kml_wr_position(Waypoint* wpt)
     last_valid_fix = wpt->GetCreationTime();
   }
 
-  wpt->icon_descr = kml_get_posn_icon(wpt->GetCreationTime().toTime_t() - last_valid_fix.toTime_t());
+  wpt->AllocExt()->icon_descr = kml_get_posn_icon(wpt->GetCreationTime().toTime_t() - last_valid_fix.toTime_t());
 
 
   /* In order to avoid clutter while we're sitting still, don't add
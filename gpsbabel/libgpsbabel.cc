@@ -0,0 +1,336 @@
+/*
+    In-process conversions for programs that link GPSBabel.
+
+    Copyright (C) 2015 Robert Lipe, robertlipe+source@gpsbabel.org
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111 USA
+
+ */
+
+#include <QtCore/QByteArray>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QTextCodec>
+
+#include "defs.h"
+#include "filterdefs.h"
+#include "cet.h"
+#include "cet_util.h"
+#include "session.h"
+#include "libgpsbabel.h"
+#include "src/core/usasciicodec.h"
+#include <limits.h>
+#include <stdlib.h>
+
+#define MYNAME "libgpsbabel"
+
+/*
+ * The caller's buffers are bound to these names (see gbfmem_bind()),
+ * which the formats are then given in place of file names.
+ */
+#define LIB_INFILE "(libgpsbabel input)"
+#define LIB_OUTFILE "(libgpsbabel output)"
+
+/* fatal() during a conversion unwinds to gpsbabel_convert() with this. */
+class lib_failure
+{
+};
+
+static QMutex lib_lock;
+static int lib_ready;
+static QByteArray lib_messages;
+static ff_vecs_t* lib_reader;	/* read() failed before rd_deinit() */
+
+static void
+lib_message(int is_fatal, const char* msg)
+{
+  lib_messages.append(msg);
+  if (is_fatal) {
+    throw lib_failure();
+  }
+}
+
+/* What main() does once at startup, done on the first call. */
+static void
+lib_init(void)
+{
+  if (lib_ready) {
+    return;
+  }
+  (void) new gpsbabel::UsAsciiCodec(); /* make sure a US-ASCII codec is available */
+#if (QT_VERSION < QT_VERSION_CHECK(5, 0, 0))
+  QTextCodec::setCodecForCStrings(QTextCodec::codecForName("UTF-8"));
+#endif
+
+  init_vecs();
+  init_filter_vecs();
+  cet_register();
+  session_init();
+  waypt_init();
+  route_init();
+  lib_ready = 1;
+}
+
+/*
+ * Start each call from the options main() starts with.  Filters run on
+ * this thread only, as a fatal() on a worker thread couldn't be
+ * unwound to the caller.
+ */
+static void
+lib_set_options(int objects)
+{
+  global_opts.synthesize_shortnames = 0;
+  global_opts.debug_level = 0;
+  global_opts.objective = wptdata;
+  global_opts.masked_objective = NOTHINGMASK;
+  global_opts.verbose_status = 0;
+  global_opts.smart_icons = 0;
+  global_opts.smart_names = 0;
+  global_opts.inifile = NULL;
+  global_opts.gzlevel = -1;
+  global_opts.gzindex = 0;
+  global_opts.threads = 1;
+  cet_convert_deinit();
+
+  if (objects & GPSBABEL_WAYPOINTS) {
+    global_opts.objective = wptdata;
+    global_opts.masked_objective |= WPTDATAMASK;
+  }
+  if (objects & GPSBABEL_TRACKS) {
+    global_opts.objective = trkdata;
+    global_opts.masked_objective |= TRKDATAMASK;
+  }
+  if (objects & GPSBABEL_ROUTES) {
+    global_opts.objective = rtedata;
+    global_opts.masked_objective |= RTEDATAMASK;
+  }
+  /* simulates the default behaviour of waypoints */
+  if (doing_nothing) {
+    global_opts.masked_objective |= WPTDATAMASK;
+  }
+
+  gpsbabel_now = time(NULL);
+  gpsbabel_time = current_time().toTime_t();
+}
+
+/* As main's -i and -f. */
+static void
+lib_read(const char* in_format)
+{
+  const char* opts;
+  ff_vecs_t* ivecs = find_vec(in_format, &opts);
+
+  if (ivecs == NULL) {
+    fatal("Input type '%s' not recognized\n", in_format);
+  }
+  if (ivecs->rd_init == NULL) {
+    fatal("Format does not support reading.\n");
+  }
+
+  cet_convert_init(ivecs->encode, ivecs->fixed_encode);
+
+  start_session(ivecs->name, LIB_INFILE);
+  traits_begin_read();
+  ivecs->rd_init(LIB_INFILE);
+  lib_reader = ivecs;
+  ivecs->read();
+  lib_reader = NULL;
+  ivecs->rd_deinit();
+  traits_end_read();
+  cache_invalidate();
+
+  cet_convert_strings(global_opts.charset, NULL, NULL);
+  cet_convert_deinit();
+}
+
+/* As main's -x. */
+static void
+lib_filter(const char* filter)
+{
+  QByteArray spec(filter);	/* the filter keeps pointing into it */
+  char* opts = NULL;
+  filter_vecs_t* fvecs = find_filter_vec(spec.data(), &opts);
+
+  if (fvecs == NULL) {
+    fatal("Unknown filter '%s'\n", filter);
+  }
+  traits_invalidate();
+  cache_invalidate();
+  if (fvecs->f_init) {
+    fvecs->f_init(opts);
+  }
+  fvecs->f_process();
+  cache_invalidate();
+  if (fvecs->f_deinit) {
+    fvecs->f_deinit();
+  }
+  free_filter_vec(fvecs);
+}
+
+/* As main's -o and -F. */
+static void
+lib_write(const char* out_format)
+{
+  const char* opts;
+  ff_vecs_t* ovecs = find_vec(out_format, &opts);
+  queue* wpt_head_bak, *rte_head_bak, *trk_head_bak;
+  signed int wpt_ct_bak = -1, rte_ct_bak = -1, trk_ct_bak = -1;
+
+  if (ovecs == NULL) {
+    fatal("Output type '%s' not recognized\n", out_format);
+  }
+  if (ovecs->wr_init == NULL) {
+    fatal("Format does not support writing.\n");
+  }
+
+  cet_convert_init(ovecs->encode, ovecs->fixed_encode);
+
+  rte_head_bak = trk_head_bak = NULL;
+
+  ovecs->wr_init(LIB_OUTFILE);
+
+  if (global_opts.charset != &cet_cs_vec_utf8) {
+    waypt_backup(&wpt_ct_bak, &wpt_head_bak);
+    route_backup(&rte_ct_bak, &rte_head_bak);
+    track_backup(&trk_ct_bak, &trk_head_bak);
+
+    cet_convert_strings(NULL, global_opts.charset, NULL);
+  }
+
+  ovecs->write();
+  ovecs->wr_deinit();
+  traits_invalidate();
+
+  cet_convert_deinit();
+
+  if (wpt_ct_bak != -1) {
+    waypt_restore(wpt_ct_bak, wpt_head_bak);
+  }
+  if (rte_ct_bak != -1) {
+    route_restore(rte_head_bak);
+    xfree(rte_head_bak);
+  }
+  if (trk_ct_bak != -1) {
+    track_restore(trk_head_bak);
+    xfree(trk_head_bak);
+  }
+}
+
+/* Drop everything the call read or made, so the next starts afresh. */
+static void
+lib_flush(void)
+{
+  if (lib_reader) {
+    /* Let a reader that gave up close its file and free its parser. */
+    ff_vecs_t* ivecs = lib_reader;
+    lib_reader = NULL;
+    ivecs->rd_deinit();
+  }
+  cet_convert_deinit();
+  waypt_flush_all();
+  route_flush_all();
+  intern_flush();
+  session_exit();
+  session_init();
+  traits_invalidate();
+  cache_invalidate();
+  gbfmem_clear();
+}
+
+static char*
+lib_strdup(const QByteArray& s)
+{
+  char* res = (char*) malloc(s.size() + 1);
+
+  if (res) {
+    memcpy(res, s.constData(), s.size() + 1);
+  }
+  return res;
+}
+
+int
+gpsbabel_convert(const char* in_format, const void* in_data, size_t in_size,
+                 const char* out_format, void** out_data, size_t* out_size,
+                 const char* const* filters, int objects, char** messages)
+{
+  QMutexLocker locker(&lib_lock);
+  message_handler_t old_handler;
+  QByteArray out;
+  int result = -1;
+
+  *out_data = NULL;
+  *out_size = 0;
+  if (messages) {
+    *messages = NULL;
+  }
+
+  lib_messages.clear();
+  old_handler = set_message_handler(lib_message);
+
+  try {
+    lib_init();
+    lib_set_options(objects);
+
+    if (in_size > INT_MAX) {
+      fatal(MYNAME ": Input of %lu bytes is too large.\n", (unsigned long) in_size);
+    }
+    gbfmem_bind(LIB_INFILE, QByteArray((const char*) in_data, (int) in_size));
+    gbfmem_bind(LIB_OUTFILE, QByteArray());
+
+    lib_read(in_format);
+    for (; filters && *filters; filters++) {
+      lib_filter(*filters);
+    }
+    lib_write(out_format);
+
+    if (gbfmem_take(LIB_OUTFILE, &out) == 0) {
+      fatal(MYNAME ": Output format '%s' can't write to memory.\n", out_format);
+    }
+    *out_data = malloc(out.size() ? out.size() : 1);
+    if (*out_data == NULL) {
+      fatal(MYNAME ": Out of memory for %d bytes of output.\n", out.size());
+    }
+    memcpy(*out_data, out.constData(), out.size());
+    *out_size = out.size();
+    result = 0;
+  } catch (const lib_failure&) {
+    result = -1;
+  }
+
+  try {
+    lib_flush();
+  } catch (const lib_failure&) {
+    result = -1;
+  }
+  if ((result != 0) && *out_data) {
+    free(*out_data);
+    *out_data = NULL;
+    *out_size = 0;
+  }
+
+  set_message_handler(old_handler);
+  if (messages && !lib_messages.isEmpty()) {
+    *messages = lib_strdup(lib_messages);
+  }
+  lib_messages.clear();
+
+  return result;
+}
+
+void
+gpsbabel_free(void* p)
+{
+  free(p);
+}
@@ -0,0 +1,62 @@
+/*
+    In-process conversions for programs that link GPSBabel.
+
+    Copyright (C) 2015 Robert Lipe, robertlipe+source@gpsbabel.org
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111 USA
+
+ */
+
+#ifndef LIBGPSBABEL_H
+#define LIBGPSBABEL_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* What a conversion works on, as -w, -t and -r; 0 means waypoints. */
+#define GPSBABEL_WAYPOINTS	1
+#define GPSBABEL_TRACKS		2
+#define GPSBABEL_ROUTES		4
+
+/*
+ * Convert in_size bytes at in_data from in_format to out_format,
+ * running the filters in between.  Formats and filters are given as on
+ * the command line ("gpx", "unicsv,utc=0", "simplify,count=100");
+ * filters is a NULL terminated list and may be NULL.
+ *
+ * Returns 0 and sets *out_data and *out_size on success, or -1.  The
+ * output is freed with gpsbabel_free().  If messages isn't NULL it gets
+ * any warnings and the error, if there was one, as one string to free
+ * with gpsbabel_free(), or NULL if there were none.
+ *
+ * Calls may be made from any thread; they run one at a time.  Nothing
+ * is kept from one call to the next.  Only formats that do their I/O
+ * through gbfile or gpsbabel::File can be used, and the ini file is
+ * not read.
+ */
+int gpsbabel_convert(const char* in_format, const void* in_data, size_t in_size,
+                     const char* out_format, void** out_data, size_t* out_size,
+                     const char* const* filters, int objects, char** messages);
+
+void gpsbabel_free(void* p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -202,7 +202,7 @@ lmx_print(const Waypoint* wpt)
   /*
    * Desparation time, try very hard to get a good shortname
    */
-  odesc = wpt->notes;
+  odesc = wpt->ext->notes;
   if (odesc.isEmpty()) {
     odesc = wpt->description;
   }
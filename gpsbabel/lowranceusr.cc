@@ -419,11 +419,11 @@ lowranceusr_parse_waypt(Waypoint* wpt_tmp)
   }
 
   /* Symbol ID */
-  wpt_tmp->icon_descr = lowranceusr_find_desc_from_icon_number(gbfgetint32(file_in));
-  if (wpt_tmp->icon_descr.isNull()) {
+  wpt_tmp->AllocExt()->icon_descr = lowranceusr_find_desc_from_icon_number(gbfgetint32(file_in));
+  if (wpt_tmp->ext->icon_descr.isNull()) {
     char nbuf[10];
     snprintf(nbuf, sizeof(nbuf), "%d", le_read32(buff));
-    wpt_tmp->icon_descr = nbuf;
+    wpt_tmp->AllocExt()->icon_descr = nbuf;
   }
 
   /* Waypoint Type (USER, TEMPORARY, POINT_OF_INTEREST) */
@@ -520,7 +520,7 @@ lowranceusr_parse_icons(void)
       snprintf(buff, sizeof(buff), "Icon %d", i+1);
       wpt_tmp->shortname = buff;
       /* symbol */
-      wpt_tmp->icon_descr = lowranceusr_find_desc_from_icon_number(gbfgetint32(file_in));
+      wpt_tmp->AllocExt()->icon_descr = lowranceusr_find_desc_from_icon_number(gbfgetint32(file_in));
       waypt_add(wpt_tmp);
     }
   }
@@ -691,7 +691,7 @@ lowranceusr_waypt_disp(const Waypoint* wpt)
 
   if (writing_version >= 3) {
     float depth = WAYPT_HAS(wpt, depth) ?
-                  METERS_TO_FEET(wpt->depth) : -99999.0;
+                  METERS_TO_FEET(wpt->ext->depth) : -99999.0;
     gbfputflt(depth, file_out);
   }
 
@@ -764,13 +764,13 @@ lowranceusr_waypt_disp(const Waypoint* wpt)
 
   gbfputint32(Time, file_out);
 
-  if (get_cache_icon(wpt) && wpt->icon_descr.compare("Geocache Found") == 0) {
+  if (get_cache_icon(wpt) && wpt->ext->icon_descr.compare("Geocache Found") == 0) {
     SymbolId = lowranceusr_find_icon_number_from_desc(get_cache_icon(wpt));
   } else {
-    SymbolId = lowranceusr_find_icon_number_from_desc(wpt->icon_descr);
+    SymbolId = lowranceusr_find_icon_number_from_desc(wpt->ext->icon_descr);
   }
   /* If the waypoint is archived or disabled, use a "disabled" icon instead. */
-  if ((wpt->gc_data->is_archived==status_true) || (wpt->gc_data->is_available==status_false)) {
+  if ((wpt->ext->gc_data->is_archived==status_true) || (wpt->ext->gc_data->is_available==status_false)) {
     SymbolId = lowranceusr_find_icon_number_from_desc("Disabled Cache");
   }
 
@@ -810,8 +810,8 @@ lowranceusr_write_icon(const Waypoint* wpt)
 {
   int latmm = lat_deg_to_mm(wpt->latitude);
   int lonmm = lon_deg_to_mm(wpt->longitude);
-  int icon = !wpt->icon_descr.isNull() ?
-             lowranceusr_find_icon_number_from_desc(wpt->icon_descr) :
+  int icon = !wpt->ext->icon_descr.isNull() ?
+             lowranceusr_find_icon_number_from_desc(wpt->ext->icon_descr) :
              10003;
 
   gbfputint32(latmm, file_out);
@@ -361,7 +361,7 @@ lowranceusr4_parse_waypoints(void)
 
     wpt_tmp = new Waypoint;
     lowranceusr4_fsdata* fsdata = lowranceusr4_alloc_fsdata();
-    fs_chain_add(&(wpt_tmp->fs), (format_specific_data*) fsdata);
+    fs_chain_add(&(wpt_tmp->AllocExt()->fs), (format_specific_data*) fsdata);
 
     /* read/parse waypoint, with fields as follows (taken mostly
        from http://lowranceusrv4togpxconverter.blogspot.com/):
@@ -463,7 +463,7 @@ lowranceusr4_parse_waypoints(void)
              "uid_seq_low = %d, uid_seq_high = %d, lat = %f, lon = %f, depth = %f\n",
              qPrintable(wpt_tmp->shortname), fsdata->uid_unit,
              fsdata->uid_seq_low, fsdata->uid_seq_high,
-             wpt_tmp->latitude, wpt_tmp->longitude, wpt_tmp->depth);
+             wpt_tmp->latitude, wpt_tmp->longitude, wpt_tmp->ext->depth);
     }
 
     waypt_add(wpt_tmp);
@@ -485,7 +485,7 @@ lowranceusr4_find_waypt(int uid_unit, int uid_seq_low, int uid_seq_high)
   QUEUE_FOR_EACH(&waypt_head, elem, tmp) {
     Waypoint* waypointp = (Waypoint*) elem;
 #endif
-    fs = (lowranceusr4_fsdata*) fs_chain_find(waypointp->fs, FS_LOWRANCEUSR4);
+    fs = (lowranceusr4_fsdata*) fs_chain_find(waypointp->ext->fs, FS_LOWRANCEUSR4);
 
     if (fs && fs->uid_unit == uid_unit &&
         fs->uid_seq_low == uid_seq_low &&
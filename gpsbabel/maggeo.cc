@@ -264,16 +264,16 @@ maggeo_waypt_pr(const Waypoint* waypointp)
    * For some reason, Magellan used exactly the GPX spellings of
    * everything except this one...
    */
-  if (waypointp->gc_data->type == gt_suprise) {
+  if (waypointp->ext->gc_data->type == gt_suprise) {
     ctype = "Mystery Cache";
   } else {
-    ctype = gs_get_cachetype(waypointp->gc_data->type);
+    ctype = gs_get_cachetype(waypointp->ext->gc_data->type);
   }
   QString placeddate = maggeo_fmtdate(waypointp->creation_time);
-  QString lfounddate = maggeo_fmtdate(waypointp->gc_data->last_found);
+  QString lfounddate = maggeo_fmtdate(waypointp->ext->gc_data->last_found);
   QString cname = mkshort(desc_handle,
-                  waypointp->notes.isEmpty() ? waypointp->description : waypointp->notes);
-  placer = waypointp->gc_data->placer;
+                  waypointp->ext->notes.isEmpty() ? waypointp->description : waypointp->ext->notes);
+  placer = waypointp->ext->gc_data->placer;
 
   /*
    * As of this writing on 05/04, the firmware in the units will
@@ -296,21 +296,21 @@ maggeo_waypt_pr(const Waypoint* waypointp)
   append(obuf, CSTRc(waypointp->shortname));
   append(obuf, CSTR(cname));
   append(obuf, CSTR(placer));
-  append(obuf, CSTR(waypointp->gc_data->hint));
+  append(obuf, CSTR(waypointp->ext->gc_data->hint));
   append(obuf, ctype);
   append(obuf, placeddate.toUtf8());
   append(obuf, lfounddate.toUtf8());
 
-  if (waypointp->gc_data->diff/10.0)
+  if (waypointp->ext->gc_data->diff/10.0)
     sprintf(obuf + strlen(obuf), ",%3.1f",
-            waypointp->gc_data->diff/10.0);
+            waypointp->ext->gc_data->diff/10.0);
   else {
     strcat(obuf, ",");
   }
 
-  if (waypointp->gc_data->terr/10.0)
+  if (waypointp->ext->gc_data->terr/10.0)
     sprintf(obuf + strlen(obuf), ",%3.1f",
-            waypointp->gc_data->terr/10.0);
+            waypointp->ext->gc_data->terr/10.0);
   else {
     strcat(obuf, ",");
   }
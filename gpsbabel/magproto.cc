@@ -1257,7 +1257,7 @@ mag_wptparse(char* trkmsg)
   waypt->altitude = alt;
   waypt->shortname = shortname;
   waypt->description = descr;
-  waypt->icon_descr = mag_find_descr_from_token(icon_token);
+  waypt->AllocExt()->icon_descr = mag_find_descr_from_token(icon_token);
 
   return waypt;
 }
@@ -1375,23 +1375,23 @@ mag_waypt_pr(const Waypoint* waypointp)
   if (deficon)  {
     icon_token = mag_find_token_from_descr(deficon);
   } else {
-    icon_token = mag_find_token_from_descr(waypointp->icon_descr);
+    icon_token = mag_find_token_from_descr(waypointp->ext->icon_descr);
   }
 
   if (get_cache_icon(waypointp)) {
     icon_token = mag_find_token_from_descr(get_cache_icon(waypointp));
   }
 
-  QString isrc = waypointp->notes.isEmpty() ? waypointp->description : waypointp->notes;
+  QString isrc = waypointp->ext->notes.isEmpty() ? waypointp->description : waypointp->ext->notes;
   QString owpt = global_opts.synthesize_shortnames ?
          mkshort_from_wpt(mkshort_handle, waypointp) : waypointp->shortname;
   QString odesc = isrc;
   owpt = mag_cleanse(CSTRc(owpt));
 
   if (global_opts.smart_icons &&
-      waypointp->gc_data->diff && waypointp->gc_data->terr) {
-    sprintf(ofmtdesc, "%d/%d %s", waypointp->gc_data->diff,
-            waypointp->gc_data->terr, CSTRc(odesc));
+      waypointp->ext->gc_data->diff && waypointp->ext->gc_data->terr) {
+    sprintf(ofmtdesc, "%d/%d %s", waypointp->ext->gc_data->diff,
+            waypointp->ext->gc_data->terr, CSTRc(odesc));
     odesc = mag_cleanse(ofmtdesc);
   } else {
     odesc = mag_cleanse(CSTRc(odesc));
@@ -1529,7 +1529,7 @@ mag_route_trl(const route_head* rte)
     if (deficon) {
       icon_token = mag_find_token_from_descr(deficon);
     } else {
-      icon_token = mag_find_token_from_descr(waypointp->icon_descr);
+      icon_token = mag_find_token_from_descr(waypointp->ext->icon_descr);
     }
 
     if (i == 1) {
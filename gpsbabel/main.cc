@@ -30,6 +30,16 @@
 #include <ctype.h>
 #include <signal.h>
 
+#if !__WIN32__
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #define MYNAME "main"
 
 void signal_handler(int sig);
@@ -161,9 +171,14 @@ usage(const char* pname, int shorter)
     "    -N               No smart icons on output\n"
     "    -x filtername    Invoke filter (placed between inputs and output) \n"
     "    -D level         Set debug level [%d]\n"
+    "    -z level         Set compression level (0-9) for .gz output\n"
+    "    -Z               Keep seek indexes beside gzip compressed input\n"
+    "    -j threads       Threads for per-track filter work [one per CPU]\n"
     "    -l               Print GPSBabel builtin character sets and exit\n"
     "    -h, -?           Print detailed help and exit\n"
     "    -V               Print GPSBabel version and exit\n"
+    "    --serve SOCKET [JOBS]\n"
+    "                     Run conversions requested over a Unix socket\n"
     "\n"
     , pname
     , pname
@@ -220,8 +235,13 @@ print_extended_info(void)
     "\n");
 }
 
-int
-main(int argc, char* argv[])
+/*
+ * Carry out one command line.  Everything main() sets up once
+ * (formats, filters, character sets, the inifile) is expected to be
+ * in place already.
+ */
+static int
+run(int argc, char* argv[])
 {
   int c;
   int argn;
@@ -239,45 +259,6 @@ main(int argc, char* argv[])
   queue* wpt_head_bak, *rte_head_bak, *trk_head_bak;	/* #ifdef UTF8_SUPPORT */
   signed int wpt_ct_bak, rte_ct_bak, trk_ct_bak;	/* #ifdef UTF8_SUPPORT */
   arg_stack_t* arg_stack = NULL;
-  (void) new gpsbabel::UsAsciiCodec(); /* make sure a US-ASCII codec is available */
-
-#if (QT_VERSION < QT_VERSION_CHECK(5, 0, 0))
-  // Qt 5.0 uses QString::fromUtf8 to convert from character pointers
-  // and QBytreArrays to QStrings while previous version of Qt used
-  // QString::fromAscii.  QString::fromAscii used the codec set
-  // by QTextCode::setCodecForCStrings.
-  // This makes the converstion consistent between Qt4 and Qt5.
-  QTextCodec::setCodecForCStrings(QTextCodec::codecForName("UTF-8"));
-#endif
-
-  global_opts.objective = wptdata;
-  global_opts.masked_objective = NOTHINGMASK;	/* this makes the default mask behaviour slightly different */
-  global_opts.charset = NULL;
-  global_opts.charset_name = NULL;
-  global_opts.inifile = NULL;
-
-  gpsbabel_now = time(NULL);			/* gpsbabel startup-time */
-  gpsbabel_time = current_time().toTime_t();			/* same like gpsbabel_now, but freezed to zero during testo */
-
-#ifdef DEBUG_MEM
-  debug_mem_open();
-  debug_mem_output("command line: ");
-  for (argn = 1; argn < argc; argn++) {
-    debug_mem_output("%s ", argv[argn]);
-  }
-  debug_mem_output("\n");
-#endif
-
-  if (gpsbabel_time != 0) {	/* within testo ? */
-    global_opts.inifile = inifile_init(NULL, MYNAME);
-  }
-
-  init_vecs();
-  init_filter_vecs();
-  cet_register();
-  session_init();
-  waypt_init();
-  route_init();
 
   if (argc < 2) {
     usage(argv[0],1);
@@ -370,9 +351,12 @@ main(int argc, char* argv[])
       cet_convert_init(ivecs->encode, ivecs->fixed_encode);	/* init by module vec */
 
       start_session(ivecs->name, fname);
+      traits_begin_read();
       ivecs->rd_init(fname);
       ivecs->read();
       ivecs->rd_deinit();
+      traits_end_read();
+      cache_invalidate();
 
       cet_convert_strings(global_opts.charset, NULL, NULL);
       cet_convert_deinit();
@@ -423,6 +407,8 @@ main(int argc, char* argv[])
 
         ovecs->write();
         ovecs->wr_deinit();
+        /* writers are free to scribble on the data */
+        traits_invalidate();
 
         cet_convert_deinit();
 
@@ -500,10 +486,13 @@ main(int argc, char* argv[])
       fvecs = find_filter_vec(optarg, &fvec_opts);
 
       if (fvecs) {
+        traits_invalidate();
+        cache_invalidate();
         if (fvecs->f_init) {
           fvecs->f_init(fvec_opts);
         }
         fvecs->f_process();
+        cache_invalidate();
         if (fvecs->f_deinit) {
           fvecs->f_deinit();
         }
@@ -524,6 +513,25 @@ main(int argc, char* argv[])
       }
 
       break;
+    case 'z':
+      optarg = argv[argn][2]
+               ? argv[argn]+2 : argv[++argn];
+      if (!optarg || !isdigit(*optarg) || (atoi(optarg) > 9)) {
+        fatal("Compression level must be 0 to 9.\n");
+      }
+      global_opts.gzlevel = atoi(optarg);
+      break;
+    case 'Z':
+      global_opts.gzindex = 1;
+      break;
+    case 'j':
+      optarg = argv[argn][2]
+               ? argv[argn]+2 : argv[++argn];
+      if (!optarg || !isdigit(*optarg) || (atoi(optarg) < 1)) {
+        fatal("Thread count must be at least 1.\n");
+      }
+      global_opts.threads = atoi(optarg);
+      break;
       /*
        * Undocumented '-vs' option for GUI wrappers.
        */
@@ -604,9 +612,12 @@ main(int argc, char* argv[])
     if (ivecs->rd_init == NULL) {
       fatal("Format does not support reading.\n");
     }
+    traits_begin_read();
     ivecs->rd_init(argv[0]);
     ivecs->read();
     ivecs->rd_deinit();
+    traits_end_read();
+    cache_invalidate();
 
     cet_convert_strings(global_opts.charset, NULL, NULL);
     cet_convert_deinit();
@@ -725,8 +736,12 @@ main(int argc, char* argv[])
   }
 
   cet_deregister();
+  if (global_opts.debug_level >= 1) {
+    intern_stats();
+  }
   waypt_flush_all();
   route_flush_all();
+  intern_flush();
   session_exit();
   exit_vecs();
   exit_filter_vecs();
@@ -735,9 +750,320 @@ main(int argc, char* argv[])
 #ifdef DEBUG_MEM
   debug_mem_close();
 #endif
-  exit(0);
+  return 0;
+}
+
+#if !__WIN32__
+/*
+ * Conversion server.
+ *
+ * A client connects to the socket and sends an argument vector as
+ * NUL-terminated strings followed by an empty string.  Any further
+ * bytes up to the client's shutdown are the job's standard input.
+ * The reply is a series of frames, each a type byte, a 4 byte
+ * big-endian length and that many bytes: 'O' for what the job writes
+ * to standard output, 'E' for what it writes to standard error, and
+ * last 'X' with the exit status as a 4 byte big-endian integer.  So
+ * "-f -" and "-F -" carry data inline while ordinary paths are read
+ * and written by the server, and the client gets the job's messages.
+ *
+ * Every connection gets its own process forked from the fully
+ * initialized server, so formats and filters are set up once, while
+ * no state (or fatal()) carries over from one job to the next.
+ */
+static void
+serve_write(int fd, const void* data, size_t len)
+{
+  const char* p = (const char*) data;
+
+  while (len > 0) {
+    ssize_t res = write(fd, p, len);
+    if (res < 0 && errno == EINTR) {
+      continue;
+    }
+    if (res <= 0) {
+      _exit(1);
+    }
+    p += res;
+    len -= res;
+  }
+}
+
+static void
+serve_frame(int fd, char type, const void* data, int len)
+{
+  unsigned char hdr[5];
+
+  hdr[0] = type;
+  hdr[1] = (len >> 24) & 0xff;
+  hdr[2] = (len >> 16) & 0xff;
+  hdr[3] = (len >> 8) & 0xff;
+  hdr[4] = len & 0xff;
+  serve_write(fd, hdr, sizeof(hdr));
+  serve_write(fd, data, len);
+}
+
+static void
+serve_connection(int fd, const char* prog_name)
+{
+  char* buf = NULL;
+  int len = 0;
+  int nargs = 0;
+  char** argv;
+  int argc;
+  char ch;
+  pid_t pid;
+  int status;
+  int code;
+  unsigned char trailer[4];
+  int out[2], err[2];
+
+  /* One byte at a time so nothing of the job's input is consumed. */
+  for (;;) {
+    ssize_t res = read(fd, &ch, 1);
+    if (res < 0 && errno == EINTR) {
+      continue;
+    }
+    if (res <= 0) {
+      _exit(1);
+    }
+    if ((len % 256) == 0) {
+      buf = (char*) xrealloc(buf, len + 256);
+    }
+    buf[len++] = ch;
+    if (ch == '\0') {
+      if ((len == 1) || (buf[len - 2] == '\0')) {
+        break;
+      }
+      nargs++;
+    }
+  }
+
+  argv = (char**) xcalloc(nargs + 2, sizeof(*argv));
+  argv[0] = (char*) prog_name;
+  argc = 1;
+  for (char* cp = buf; argc <= nargs; cp += strlen(cp) + 1) {
+    argv[argc++] = cp;
+  }
+
+  if ((pipe(out) < 0) || (pipe(err) < 0)) {
+    _exit(1);
+  }
+  pid = fork();
+  if (pid < 0) {
+    _exit(1);
+  }
+  if (pid == 0) {
+    dup2(fd, 0);
+    dup2(out[1], 1);
+    dup2(err[1], 2);
+    close(fd);
+    close(out[0]);
+    close(out[1]);
+    close(err[0]);
+    close(err[1]);
+    gpsbabel_now = time(NULL);
+    gpsbabel_time = current_time().toTime_t();
+    exit(run(argc, argv));
+  }
+  close(out[1]);
+  close(err[1]);
+
+  /* Pass on output and messages in the order they come. */
+  for (int streams = 2; streams > 0;) {
+    struct pollfd pfd[2];
+    char data[65536];
+
+    pfd[0].fd = out[0];
+    pfd[1].fd = err[0];
+    pfd[0].events = pfd[1].events = POLLIN;
+    if (poll(pfd, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      _exit(1);
+    }
+    for (int i = 0; i < 2; i++) {
+      if ((pfd[i].fd < 0) || !pfd[i].revents) {
+        continue;
+      }
+      ssize_t res = read(pfd[i].fd, data, sizeof(data));
+      if (res < 0 && errno == EINTR) {
+        continue;
+      }
+      if (res <= 0) {
+        close(pfd[i].fd);
+        if (i == 0) {
+          out[0] = -1;
+        } else {
+          err[0] = -1;
+        }
+        streams--;
+        continue;
+      }
+      serve_frame(fd, (i == 0) ? 'O' : 'E', data, res);
+    }
+  }
+
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      _exit(1);
+    }
+  }
+  code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+  trailer[0] = (code >> 24) & 0xff;
+  trailer[1] = (code >> 16) & 0xff;
+  trailer[2] = (code >> 8) & 0xff;
+  trailer[3] = code & 0xff;
+  serve_frame(fd, 'X', trailer, sizeof(trailer));
+  close(fd);
+  _exit(0);
+}
+
+static void
+serve(const char* path, int max_jobs, const char* prog_name)
+{
+  struct sockaddr_un sa;
+  struct stat st;
+  mode_t old_mask;
+  int lfd;
+  int jobs = 0;
+
+  if (max_jobs < 1) {
+    max_jobs = 1;
+  }
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(sa.sun_path)) {
+    fatal(MYNAME ": Socket path '%s' is too long.\n", path);
+  }
+  strcpy(sa.sun_path, path);
+
+  lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (lfd < 0) {
+    fatal(MYNAME ": Cannot create socket: %s\n", strerror(errno));
+  }
+  /* Only ever replace a stale socket, never a file. */
+  if (lstat(path, &st) == 0) {
+    if (!S_ISSOCK(st.st_mode)) {
+      fatal(MYNAME ": '%s' exists and is not a socket.\n", path);
+    }
+    unlink(path);
+  }
+  /*
+   * Clients can have the server read and write any file it can, so
+   * only our own user may connect.
+   */
+  old_mask = umask(077);
+  if (bind(lfd, (struct sockaddr*) &sa, sizeof(sa)) < 0) {
+    fatal(MYNAME ": Cannot listen on '%s': %s\n", path, strerror(errno));
+  }
+  umask(old_mask);
+  if (listen(lfd, 64) < 0) {
+    fatal(MYNAME ": Cannot listen on '%s': %s\n", path, strerror(errno));
+  }
+  signal(SIGPIPE, SIG_IGN);
+
+  for (;;) {
+    int fd;
+    pid_t pid;
+
+    /* Reap finished jobs; wait for one if we're at the limit. */
+    while ((jobs > 0) && (waitpid(-1, NULL, (jobs >= max_jobs) ? 0 : WNOHANG) > 0)) {
+      jobs--;
+    }
+
+    fd = accept(lfd, NULL, NULL);
+    if (fd < 0) {
+      if ((errno == EINTR) || (errno == ECONNABORTED)) {
+        continue;
+      }
+      fatal(MYNAME ": accept failed: %s\n", strerror(errno));
+    }
+
+    pid = fork();
+    if (pid < 0) {
+      warning(MYNAME ": Cannot fork: %s\n", strerror(errno));
+      close(fd);
+      continue;
+    }
+    if (pid == 0) {
+      close(lfd);
+      serve_connection(fd, prog_name);
+    }
+    close(fd);
+    jobs++;
+  }
+}
+#else
+static void
+serve(const char*, int, const char*)
+{
+  fatal(MYNAME ": --serve is not available on this platform.\n");
+}
+#endif
+
+int
+main(int argc, char* argv[])
+{
+#ifdef DEBUG_MEM
+  int argn;
+#endif
+  (void) new gpsbabel::UsAsciiCodec(); /* make sure a US-ASCII codec is available */
+
+#if (QT_VERSION < QT_VERSION_CHECK(5, 0, 0))
+  // Qt 5.0 uses QString::fromUtf8 to convert from character pointers
+  // and QBytreArrays to QStrings while previous version of Qt used
+  // QString::fromAscii.  QString::fromAscii used the codec set
+  // by QTextCode::setCodecForCStrings.
+  // This makes the converstion consistent between Qt4 and Qt5.
+  QTextCodec::setCodecForCStrings(QTextCodec::codecForName("UTF-8"));
+#endif
+
+  global_opts.objective = wptdata;
+  global_opts.masked_objective = NOTHINGMASK;	/* this makes the default mask behaviour slightly different */
+  global_opts.charset = NULL;
+  global_opts.charset_name = NULL;
+  global_opts.inifile = NULL;
+  global_opts.gzlevel = -1;
+  global_opts.gzindex = 0;
+  global_opts.threads = 0;
+
+  gpsbabel_now = time(NULL);			/* gpsbabel startup-time */
+  gpsbabel_time = current_time().toTime_t();			/* same like gpsbabel_now, but freezed to zero during testo */
+
+#ifdef DEBUG_MEM
+  debug_mem_open();
+  debug_mem_output("command line: ");
+  for (argn = 1; argn < argc; argn++) {
+    debug_mem_output("%s ", argv[argn]);
+  }
+  debug_mem_output("\n");
+#endif
+
+  if (gpsbabel_time != 0) {	/* within testo ? */
+    global_opts.inifile = inifile_init(NULL, MYNAME);
+  }
+
+  init_vecs();
+  init_filter_vecs();
+  cet_register();
+  session_init();
+  waypt_init();
+  route_init();
+
+  if ((argc > 1) && (strcmp(argv[1], "--serve") == 0)) {
+    if ((argc < 3) || (argc > 4)) {
+      fatal("Usage: %s --serve SOCKET [JOBS]\n", argv[0]);
+    }
+    serve(argv[2], (argc > 3) ? atoi(argv[3]) : 4, argv[0]);
+  }
+
+  return run(argc, argv);
 }
 
+
 void signal_handler(int sig)
 {
   (void)sig;
@@ -19,14 +19,13 @@
 #include "defs.h"
 
 #include <QtCore/QXmlStreamReader>
-#include <QtCore/QXmlStreamWriter>
 #include <QtCore/QDebug>
 #include "src/core/file.h"
 #include "src/core/xmlstreamwriter.h"
 
 
 static gpsbabel::File* oqfile;
-static QXmlStreamWriter* writer;
+static gpsbabel::XmlStreamWriter* writer;
 
 static
 arglist_t mapfactor_args[] = {
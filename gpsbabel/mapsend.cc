@@ -139,7 +139,7 @@ mapsend_wpt_read(void)
     } else {
       sprintf(tbuf, "a%c", wpt_icon - 26 + 'a');
     }
-    wpt_tmp->icon_descr = mag_find_descr_from_token(tbuf);
+    wpt_tmp->AllocExt()->icon_descr = mag_find_descr_from_token(tbuf);
 
     waypt_add(wpt_tmp);
   }
@@ -179,7 +179,7 @@ mapsend_wpt_read(void)
       } else {
         sprintf(tbuf, "a%c", wpt_icon - 26 + 'a');
       }
-      wpt_tmp->icon_descr = mag_find_descr_from_token(tbuf);
+      wpt_tmp->AllocExt()->icon_descr = mag_find_descr_from_token(tbuf);
 
       route_add_wpt(rte_head, wpt_tmp);
     }
@@ -312,8 +312,8 @@ mapsend_waypt_pr(const Waypoint* waypointp)
 
 
   QString iconp;
-  if (!waypointp->icon_descr.isNull()) {
-    iconp = mag_find_token_from_descr(waypointp->icon_descr);
+  if (!waypointp->ext->icon_descr.isNull()) {
+    iconp = mag_find_token_from_descr(waypointp->ext->icon_descr);
     if (1 == iconp.size()) {
       c = iconp[0].toLatin1() - 'a';
     } else {
@@ -388,8 +388,8 @@ mapsend_route_disp(const Waypoint* waypointp)
   gbfputdbl(waypointp->longitude, mapsend_file_out);
   gbfputdbl(-waypointp->latitude, mapsend_file_out);
 
-  if (!waypointp->icon_descr.isNull()) {
-    iconp = mag_find_token_from_descr(waypointp->icon_descr);
+  if (!waypointp->ext->icon_descr.isNull()) {
+    iconp = mag_find_token_from_descr(waypointp->ext->icon_descr);
     if (1 == iconp.size()) {
       c = iconp[0].toLatin1() - 'a';
     } else {
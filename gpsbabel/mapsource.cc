@@ -578,7 +578,7 @@ mps_waypoint_r(gbfile* mps_file, int mps_ver, Waypoint** wpt, unsigned int* mpsc
 
   if ((mps_ver == 4) || (mps_ver == 5)) {
     gbfread(tbuf, 6, 1, mps_file);				/* unknown */
-    thisWaypoint->notes = gbfgetcstr(mps_file);
+    thisWaypoint->AllocExt()->notes = gbfgetcstr(mps_file);
   } else {
     gbfread(tbuf, 2, 1, mps_file);				/* unknown */
   }
@@ -596,7 +596,7 @@ mps_waypoint_r(gbfile* mps_file, int mps_ver, Waypoint** wpt, unsigned int* mpsc
   }
 
   /* might need to change this to handle version dependent icon handling */
-  thisWaypoint->icon_descr = gt_find_desc_from_icon_number(icon, MAPSOURCE);
+  thisWaypoint->AllocExt()->icon_descr = gt_find_desc_from_icon_number(icon, MAPSOURCE);
 
   /* The following Now done elsewhere since it can be useful to read in and
     perhaps not add to the list */
@@ -628,14 +628,14 @@ mps_waypoint_w(gbfile* mps_file, int mps_ver, const Waypoint* wpt, const int isR
   lat = GPS_Math_Deg_To_Semi(wpt->latitude);
   lon = GPS_Math_Deg_To_Semi(wpt->longitude);
   if (WAYPT_HAS(wpt, depth) && mpsusedepth) {
-    mps_depth = wpt->depth;
+    mps_depth = wpt->ext->depth;
   }
   QString src;
   if (!wpt->description.isEmpty()) {
     src = wpt->description;
   }
-  if (!wpt->notes.isEmpty()) {
-    src = wpt->notes;
+  if (!wpt->ext->notes.isEmpty()) {
+    src = wpt->ext->notes;
   }
   QString ident = global_opts.synthesize_shortnames ?
           mkshort(mkshort_handle, src) :
@@ -645,7 +645,7 @@ mps_waypoint_w(gbfile* mps_file, int mps_ver, const Waypoint* wpt, const int isR
   memset(ffbuf, 0xff, sizeof(ffbuf));
 
   /* might need to change this to handle version dependent icon handling */
-  icon = gt_find_icon_number_from_desc(wpt->icon_descr, MAPSOURCE);
+  icon = gt_find_icon_number_from_desc(wpt->ext->icon_descr, MAPSOURCE);
   if (get_cache_icon(wpt)) {
     icon = gt_find_icon_number_from_desc(get_cache_icon(wpt), MAPSOURCE);
   }
@@ -662,8 +662,8 @@ mps_waypoint_w(gbfile* mps_file, int mps_ver, const Waypoint* wpt, const int isR
 										+ NULL (1) + prox(9) + display(4) + colour(4) + symbol(4) + city(sz) +
 										state(sz) + facility(sz) + unknown2(1) + depth(9) + unknown3(7) */
     /* -1 as reclen is interpreted from zero meaning a reclength of one */
-    if (!wpt->notes.isEmpty()) {
-      reclen += strlen(CSTRc(wpt->notes));
+    if (!wpt->ext->notes.isEmpty()) {
+      reclen += strlen(CSTRc(wpt->ext->notes));
     }
   } else {
     /* v3.02 */
@@ -742,8 +742,8 @@ mps_waypoint_w(gbfile* mps_file, int mps_ver, const Waypoint* wpt, const int isR
   gbfwrite(zbuf, 2, 1, mps_file);		/* unknown */
   if ((mps_ver == 4) || (mps_ver == 5)) {
     gbfwrite(zbuf, 4, 1, mps_file);	/* unknown */
-    if (!wpt->notes.isEmpty()) {
-      gbfputs(wpt->notes, mps_file);
+    if (!wpt->ext->notes.isEmpty()) {
+      gbfputs(wpt->ext->notes, mps_file);
     }
     gbfwrite(zbuf, 1, 1, mps_file);	/* string termination */
   }
@@ -1178,8 +1178,8 @@ mps_routehdr_w(gbfile* mps_file, int mps_ver, const route_head* rte)
       if (!testwpt->description.isEmpty()) {
         src = testwpt->description;
       }
-      if (!testwpt->notes.isEmpty()) {
-        src = testwpt->notes;
+      if (!testwpt->ext->notes.isEmpty()) {
+        src = testwpt->ext->notes;
       }
       QString ident = global_opts.synthesize_shortnames ?
               mkshort(mkshort_handle, src) :
@@ -1396,8 +1396,8 @@ mps_routedatapoint_w(gbfile* mps_file, int mps_ver, const Waypoint* rtewpt)
   if (!rtewpt->description.isEmpty()) {
     src = rtewpt->description;
   }
-  if (!rtewpt->notes.isEmpty()) {
-    src = rtewpt->notes;
+  if (!rtewpt->ext->notes.isEmpty()) {
+    src = rtewpt->ext->notes;
   }
   QString ident = global_opts.synthesize_shortnames ?
           mkshort(mkshort_handle, src) :
@@ -1652,7 +1652,7 @@ mps_trackdatapoint_w(gbfile* mps_file, int mps_ver, const Waypoint* wpt)
   lat = GPS_Math_Deg_To_Semi(wpt->latitude);
   lon = GPS_Math_Deg_To_Semi(wpt->longitude);
   if (WAYPT_HAS(wpt, depth) && mpsusedepth) {
-    mps_depth = wpt->depth;
+    mps_depth = wpt->ext->depth;
   }
 
   memset(zbuf, 0, sizeof(zbuf));
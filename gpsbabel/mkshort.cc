@@ -593,17 +593,17 @@ mkshort_from_wpt(short_handle h, const Waypoint* wpt)
    * which contains placer name, diff, terr, and generally way
    * more stuff than should be in any one field...
    */
-  if (wpt->gc_data->diff && wpt->gc_data->terr &&
-      !wpt->notes.isEmpty()) {
-    return mkshort(h, wpt->notes);
+  if (wpt->ext->gc_data->diff && wpt->ext->gc_data->terr &&
+      !wpt->ext->notes.isEmpty()) {
+    return mkshort(h, wpt->ext->notes);
   }
 
   if (!wpt->description.isEmpty()) {
     return mkshort(h, wpt->description);
   }
 
-  if (!wpt->notes.isEmpty()) {
-    return mkshort(h, wpt->notes);
+  if (!wpt->ext->notes.isEmpty()) {
+    return mkshort(h, wpt->ext->notes);
   }
 
   /* Should probably never actually happen... */
@@ -2,29 +2,256 @@
 
 echo "/* This file is machine-generated from the contents of style/ */"
 echo "/* by mkstyle.sh.   Editing it by hand is an exeedingly bad idea. */"
-echo 
+echo
 
 # set the locale for sorting so that the collate order doesn't depend
-# on the users environment.
-LC_COLLATE=C
-export LC_COLLATE
-
-# require gnu sed even though we aren't using gnu extensions.
-# this avoids portability issues with other seds.
-if gsed v /dev/null 1>/dev/null 2>&1; then
-    SED=gsed
-elif sed v /dev/null 1>/dev/null 2>&1; then
-	# sed is gnu sed
-    SED=sed
-elif [ `uname -s` = "FreeBSD" ]; then
-       # BSD sed is fine
-    SED=/usr/bin/sed
-else
-	echo "Error: can't find gnu sed" 1>&2
-	exit 1
-fi
+# on the users environment.  The C locale also keeps awk working on
+# bytes rather than characters.
+LC_ALL=C
+export LC_ALL
+
+# Each style is parsed here, at build time, into the xcsv_style_t
+# tables declared in csv_util.h.  The rules below must follow
+# xcsv_parse_style_line() in xcsv.cc, which still handles style
+# files given with "-i xcsv,style=...".
+STYLE2C='
+function trim(s, enc, smax,    n, p1, p2, elen, stripped)
+{
+  n = length(s)
+  if (n == 0) {
+    return s
+  }
+  p1 = 1
+  p2 = n
+  while (p2 > p1 && substr(s, p2, 1) ~ /[ \t\n\v\f\r]/) {
+    p2--
+  }
+  while (p1 < p2 && substr(s, p1, 1) ~ /[ \t\n\v\f\r]/) {
+    p1++
+  }
+  if (!smax) {
+    smax = 9999
+  }
+  elen = length(enc)
+  stripped = 0
+  if (elen) {
+    while (stripped < smax && p2 - p1 + 1 >= elen * 2 &&
+           substr(s, p1, elen) == enc && substr(s, p2 - elen + 1, elen) == enc) {
+      p2 -= elen
+      p1 += elen
+      stripped++
+    }
+  }
+  return substr(s, p1, p2 - p1 + 1)
+}
+
+function constant(s)
+{
+  return (s in chars) ? chars[s] : s
+}
+
+function atoi(s)
+{
+  if (match(s, /^[ \t\n\v\f\r]*[-+]?[0-9]+/)) {
+    return substr(s, 1, RLENGTH) + 0
+  }
+  return 0
+}
+
+function cstr(s,    i, c, r)
+{
+  if (s == "\001") {
+    return "NULL"
+  }
+  r = "\""
+  for (i = 1; i <= length(s); i++) {
+    c = substr(s, i, 1)
+    if (c == "\\") {
+      r = r "\\\\"
+    } else if (c == "\"") {
+      r = r "\\\""
+    } else if (c == "\t") {
+      r = r "\\t"
+    } else if (c == "\n") {
+      r = r "\\n"
+    } else if (c == "\r") {
+      r = r "\\r"
+    } else {
+      r = r c
+    }
+  }
+  return r "\""
+}
+
+# key, default value and printf conversion of an IFIELD or OFIELD line;
+# fields that are not present are returned as "\001" (NULL).
+function field(s,    n, a, i, r)
+{
+  n = split(s, a, ",")
+  if (n == 0) {
+    n = 1
+    a[1] = ""
+  }
+  r = ""
+  for (i = 1; i <= 3; i++) {
+    r = r ", " cstr(i <= n ? trim(a[i], "\"", 1) : "\001")
+  }
+  nf = n
+  f4 = (n >= 4) ? a[4] : ""
+  return substr(r, 3)
+}
+
+BEGIN {
+  chars["COMMA"] = ","
+  chars["COMMASPACE"] = ", "
+  chars["SINGLEQUOTE"] = "\047"
+  chars["DOUBLEQUOTE"] = "\""
+  chars["COLON"] = ":"
+  chars["SEMICOLON"] = ";"
+  chars["NEWLINE"] = "\n"
+  chars["CR"] = "\n"
+  chars["CRNEWLINE"] = "\r\n"
+  chars["TAB"] = "\t"
+  chars["SPACE"] = " "
+  chars["HASH"] = "#"
+  chars["WHITESPACE"] = "\\w"
+  chars["PIPE"] = "|"
+
+  desc = ext = fdelim = fencl = rdelim = enc = datum = "\001"
+  bad = ""
+  type = "ff_type_file"
+  datatype = "unknown_gpsdata"
+  shortlen = shortwhite = -1
+  nifield = nofield = nprologue = nepilogue = 0
+}
+
+{
+  line = $0
+  if ((i = index(line, "#")) > 0) {
+    if (i > 1 && substr(line, i - 1, 1) == "\\") {
+      line = substr(line, 1, i - 2) substr(line, i)
+    } else {
+      line = substr(line, 1, i - 1)
+    }
+  }
+  if (line == "") {
+    next
+  }
+
+  if (line ~ /^FIELD_DELIMITER/) {
+    fdelim = constant(trim(substr(line, 17), "\"", 1))
+    p = trim(fdelim, " ", 0)
+    if (p == "\\w") {
+      bad = " \n\r"
+    } else {
+      bad = bad p
+    }
+  } else if (line ~ /^FIELD_ENCLOSER/) {
+    fencl = constant(trim(substr(line, 16), "\"", 1))
+    bad = bad trim(fencl, " ", 0)
+  } else if (line ~ /^RECORD_DELIMITER/) {
+    rdelim = constant(trim(substr(line, 18), "\"", 1))
+    bad = bad trim(rdelim, " ", 0)
+  } else if (line ~ /^FORMAT_TYPE/) {
+    p = substr(line, 12)
+    sub(/^[ \t\n\v\f\r]*/, "", p)
+    if (p ~ /^INTERNAL/) {
+      type = "ff_type_internal"
+    }
+    if (p ~ /^SERIAL/) {
+      type = "ff_type_serial"
+    }
+  } else if (line ~ /^DESCRIPTION/) {
+    desc = trim(substr(line, 12), "", 0)
+  } else if (line ~ /^EXTENSION/) {
+    ext = trim(substr(line, 11), "", 0)
+  } else if (line ~ /^SHORTLEN/) {
+    shortlen = atoi(substr(line, 10))
+  } else if (line ~ /^SHORTWHITE/) {
+    shortwhite = atoi(substr(line, 13))
+  } else if (line ~ /^BADCHARS/) {
+    bad = bad constant(trim(substr(line, 10), "\"", 1))
+  } else if (line ~ /^PROLOGUE/) {
+    prologue[nprologue++] = substr(line, 10)
+  } else if (line ~ /^EPILOGUE/) {
+    epilogue[nepilogue++] = substr(line, 10)
+  } else if (line ~ /^ENCODING/) {
+    enc = trim(substr(line, 9), "\"", 1)
+  } else if (line ~ /^DATUM/) {
+    datum = trim(substr(line, 6), "\"", 1)
+  } else if (line ~ /^DATATYPE/) {
+    p = toupper(trim(substr(line, 9), "\"", 1))
+    if (p == "TRACK") {
+      datatype = "trkdata"
+    } else if (p == "ROUTE") {
+      datatype = "rtedata"
+    } else if (p == "WAYPOINT") {
+      datatype = "wptdata"
+    } else {
+      printf("%s: Unknown data type \"%s\"!\n", FILENAME, p) > "/dev/stderr"
+      exit 1
+    }
+  } else if (line ~ /^IFIELD/) {
+    ifield[nifield++] = field(substr(line, 7)) ", 0"
+  } else if (line ~ /^OFIELD/) {
+    r = field(substr(line, 7))
+    o = ""
+    if (nf >= 4) {
+      if (index(f4, "no_delim_before")) {
+        o = o " | OPTIONS_NODELIM"
+      }
+      if (index(f4, "absolute")) {
+        o = o " | OPTIONS_ABSOLUTE"
+      }
+      if (index(f4, "optional")) {
+        o = o " | OPTIONS_OPTIONAL"
+      }
+    }
+    ofield[nofield++] = r ", " (o == "" ? "0" : substr(o, 4))
+  }
+}
+
+END {
+  print "static const xcsv_field_t " name "_ifield[] = {"
+  for (i = 0; i < nifield; i++) {
+    print "  { " ifield[i] " },"
+  }
+  print "  { NULL, NULL, NULL, 0 }"
+  print "};"
+  print "static const xcsv_field_t " name "_ofield[] = {"
+  for (i = 0; i < nofield; i++) {
+    print "  { " ofield[i] " },"
+  }
+  print "  { NULL, NULL, NULL, 0 }"
+  print "};"
+  print "static const char* const " name "_prologue[] = {"
+  for (i = 0; i < nprologue; i++) {
+    print "  " cstr(prologue[i]) ","
+  }
+  print "  NULL"
+  print "};"
+  print "static const char* const " name "_epilogue[] = {"
+  for (i = 0; i < nepilogue; i++) {
+    print "  " cstr(epilogue[i]) ","
+  }
+  print "  NULL"
+  print "};"
+  print "static const xcsv_style_t " name " = {"
+  print "  " cstr(desc) ","
+  print "  " cstr(ext) ","
+  print "  " cstr(fdelim) ", " cstr(fencl) ", " cstr(rdelim) ","
+  print "  " cstr(bad) ","
+  print "  " type ", " datatype ","
+  print "  " shortlen ", " shortwhite ","
+  print "  " cstr(enc) ", " cstr(datum) ","
+  print "  " name "_prologue, " name "_epilogue,"
+  print "  " name "_ifield, " name "_ofield"
+  print "};"
+}
+'
 
 echo "#include \"defs.h\""
+echo "#include \"csv_util.h\""
 echo "#if CSVFMTS_ENABLED"
 nstyles="0"
 for i in `dirname $0`/style/*.style
@@ -32,10 +259,8 @@ do
 	A=`basename $i | sed "s/.style$//"`
 	[ $A = "README" ] && continue
 	[ $A = "custom.style" ] && continue
-	ALIST="{ \"$A\", $A } , $ALIST"
-	echo "static char $A[] ="
-	$SED 's/\\/\\\\/;s/"/\\"/g;s/^\(.\)/"\1/g;s/\(.\)$/\1\\n"/g;s/^\(.\)/  \1/' $i
-	echo "  ;"
+	ALIST="{ \"$A\", &$A } , $ALIST"
+	awk -v name=$A "$STYLE2C" $i || exit 1
 	nstyles=`expr $nstyles + 1`;
 done
 echo "style_vecs_t style_list[] = {$ALIST {0,0}};"
@@ -44,4 +269,3 @@ echo "#else /* CSVFMTS_ENABLED */"
 echo "style_vecs_t style_list[] = {{0,0}};"
 echo "size_t nstyles = 0;"
 echo "#endif /* CSVFMTS_ENABLED */"
-
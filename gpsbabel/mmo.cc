@@ -521,26 +521,26 @@ mmo_read_CObjWaypoint(mmo_data_t* data)
     }
 
     if (*cend++) {
-      wpt->notes = QString::fromLatin1(cend);
+      wpt->AllocExt()->notes = QString::fromLatin1(cend);
     }
 
     if (wpt->HasUrlLink()) {
       DBG((sobj, "url = \"%s\"\n", wpt->url));
     }
   } else if (*str) {
-    wpt->notes = QString::fromLatin1(str);
+    wpt->AllocExt()->notes = QString::fromLatin1(str);
   }
   xfree(str);
-  if (!wpt->notes.isEmpty()) {
-    DBG((sobj, "notes = \"%s\"\n", wpt->notes));
+  if (!wpt->ext->notes.isEmpty()) {
+    DBG((sobj, "notes = \"%s\"\n", wpt->ext->notes));
   }
 
   mmo_fillbuf(buf, 12, 1);
   i = le_read32(&buf[8]);		/* icon */
   if (i != -1) {
     if (icons.contains(i)) {
-      wpt->icon_descr = icons.value(i);
-      DBG((sobj, "icon = \"%s\"\n", qPrintable(wpt->icon_descr)));
+      wpt->AllocExt()->icon_descr = icons.value(i);
+      DBG((sobj, "icon = \"%s\"\n", qPrintable(wpt->ext->icon_descr)));
     }
 #ifdef MMO_DBG
     else {
@@ -549,10 +549,10 @@ mmo_read_CObjWaypoint(mmo_data_t* data)
 #endif
   }
 
-  wpt->proximity = le_read_float(&buf[4]);
-  if (wpt->proximity) {
+  wpt->AllocExt()->proximity = le_read_float(&buf[4]);
+  if (wpt->ext->proximity) {
     wpt->wpt_flags.proximity = 1;
-    DBG((sobj, "proximity = %f\n", wpt->proximity));
+    DBG((sobj, "proximity = %f\n", wpt->ext->proximity));
   }
 
   str = mmo_readstr();	/* name on gps ??? option ??? */
@@ -983,17 +983,17 @@ mmo_finalize_rtept_cb(const Waypoint* wptref)
     wpt->shortname = wpt2->shortname;
 
     wpt->description = wpt2->description;
-    wpt->notes = (wpt2->notes);
+    wpt->AllocExt()->notes = (wpt2->ext->notes);
     if (wpt2->HasUrlLink()) {
       UrlLink l = wpt2->GetUrlLink();
-      wpt->notes = l.url_;
+      wpt->AllocExt()->notes = l.url_;
     }
 
-    wpt->proximity = wpt2->proximity;
+    wpt->AllocExt()->proximity = wpt2->ext->proximity;
     wpt->wpt_flags.proximity = wpt2->wpt_flags.proximity;
 
-    if (!wpt2->icon_descr.isNull()) {
-      wpt->icon_descr = wpt2->icon_descr;
+    if (!wpt2->ext->icon_descr.isNull()) {
+      wpt->AllocExt()->icon_descr = wpt2->ext->icon_descr;
     }
   }
 }
@@ -1289,7 +1289,7 @@ mmo_write_wpt_cb(const Waypoint* wpt)
     str += "\n";
   }
 
-  cx = wpt->notes;
+  cx = wpt->ext->notes;
   if (cx == NULL) {
     cx = wpt->description;
   }
@@ -1312,16 +1312,16 @@ mmo_write_wpt_cb(const Waypoint* wpt)
 
   gbfputuint32(0x01, fout);
   if WAYPT_HAS(wpt, proximity) {
-    gbfputflt((int) wpt->proximity, fout);
+    gbfputflt((int) wpt->ext->proximity, fout);
   } else {
     gbfputflt(0, fout);
   }
 
-  if (!wpt->icon_descr.isNull()) {
+  if (!wpt->ext->icon_descr.isNull()) {
     int i = 0;
 
     while (mmo_icon_value_table[i].icon) {
-      if (wpt->icon_descr.compare(mmo_icon_value_table[i].icon, Qt::CaseInsensitive) == 0) {
+      if (wpt->ext->icon_descr.compare(mmo_icon_value_table[i].icon, Qt::CaseInsensitive) == 0) {
         icon = mmo_icon_value_table[i].value;
         break;
       }
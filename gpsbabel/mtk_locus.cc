@@ -442,7 +442,6 @@ process_pmtklox()
       trkpt->longitude = longitude;
       trkpt->altitude = height;
       trkpt->sat = 0;
-      trkpt->hdop = 0;
       trkpt->fix = fix_3d;
       track_add_wpt(track, trkpt);
     }
@@ -454,7 +453,6 @@ process_pmtklox()
       waypt->longitude = longitude;
       waypt->altitude = height;
       waypt->sat = 0;
-      waypt->hdop = 0;
       waypt->fix = fix_3d;
       waypt_add(waypt);
     }
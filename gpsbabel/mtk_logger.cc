@@ -227,6 +227,8 @@ static char* OPT_erase;  /* erase ? command option */
 static char* OPT_erase_only;  /* erase_only ? command option */
 static char* OPT_log_enable;  /* enable ? command option */
 static char* csv_file; /* csv ? command option */
+static char* OPT_block_size;  /* bytes per read request */
+static char* OPT_window;  /* read requests in flight */
 static enum MTK_DEVICE_TYPE mtk_device = MTK_LOGGER;
 
 struct mtk_loginfo mtk_info;
@@ -267,6 +269,14 @@ static arglist_t mtk_sargs[] = {
     "csv",   &csv_file, "MTK compatible CSV output file",
     NULL, ARGTYPE_STRING, ARG_NOMINMAX
   },
+  {
+    "block_size", &OPT_block_size, "Bytes to request from the device at a time",
+    "1024", ARGTYPE_INT, "256", "65536"
+  },
+  {
+    "window", &OPT_window, "Number of read requests to keep in flight",
+    "1", ARGTYPE_INT, "1", "64"
+  },
   ARG_TERMINATOR
 };
 
@@ -526,16 +536,334 @@ static int mtk_erase(void)
   return 0;
 }
 
+/*
+ * Windowed flash download.
+ *
+ * A read request "$PMTK182,7,addr,len" is answered with one or more
+ * "$PMTK182,8,addr,hexdata" lines and a "$PMTK001,182,7,3" ack.  Waiting
+ * for each reply before sending the next request leaves the link idle
+ * for a round trip per block, so up to `window` requests are kept in
+ * flight.  Replies are matched to their block by address and may arrive
+ * in any order; blocks are handed to the callback in address order.
+ *
+ * A block whose reply fails its checksum is re-requested at once.  When
+ * the link goes quiet for TIMEOUT every block still incomplete is asked
+ * for again, which covers replies that never arrived.  Each block gets
+ * MTK_RETRIES tries.
+ */
+
+#define MTK_RETRIES 3
+
+typedef struct {
+  unsigned int addr;
+  unsigned int got;		/* bytes received so far */
+  int tries;
+  unsigned char* data;
+} mtk_block;
+
+/* Returns 0 to stop the download. */
+typedef int (*mtk_block_cb)(unsigned int addr, const unsigned char* data,
+                            unsigned int len, void* ctx);
+
+static int mtk_hexval(int c)
+{
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 0xA;
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 0xa;
+  }
+  return -1;
+}
+
+static void mtk_request_block(mtk_block* b, unsigned int bsize)
+{
+  char cmd[64];
+  unsigned char crc = 0;
+  int cmdLen, i;
+
+  if (b->tries++ > MTK_RETRIES) {
+    fatal(MYNAME ": No valid reply for block 0x%.8x after %d tries\n",
+          b->addr, MTK_RETRIES + 1);
+  }
+  if (b->tries > 1) {
+    dbg(2, "\nRetry %d at 0x%.8x\n", b->tries - 1, b->addr);
+  }
+  b->got = 0;
+
+  cmdLen = snprintf(cmd, sizeof(cmd), "$PMTK182,7,%.8x,%.8x", b->addr, bsize);
+  for (i=1; i<cmdLen; i++) {
+    crc ^= cmd[i];
+  }
+  cmdLen += snprintf(&cmd[cmdLen], sizeof(cmd)-cmdLen,  "*%.2X\r\n", crc);
+  do_send_cmd(cmd, cmdLen);
+}
+
+/*
+ * Decode a "$PMTK182,8,addr,hexdata*CS" line in place.  Returns the
+ * number of data bytes, or -1 if the line is damaged; *addr is set
+ * whenever the address itself could be read.
+ */
+static int mtk_decode_data(char* line, unsigned int* addr, int* addr_ok,
+                           unsigned char* data, unsigned int data_size)
+{
+  unsigned char crc = 0;
+  char* star;
+  char* p;
+  int len = strlen(line);
+  unsigned int j = 0;
+
+  *addr_ok = 0;
+  if (len < 20 || line[19] != ',') {
+    return -1;
+  }
+  for (p = &line[11]; p < &line[19]; p++) {
+    if (mtk_hexval(*p) < 0) {
+      return -1;
+    }
+  }
+  *addr = strtoul(&line[11], NULL, 16);
+  *addr_ok = 1;
+
+  star = strrchr(line, '*');
+  if (star == NULL || star - line < 20 || strlen(star) < 3 ||
+      mtk_hexval(star[1]) < 0 || mtk_hexval(star[2]) < 0) {
+    return -1;
+  }
+  for (p = &line[1]; p < star; p++) {
+    crc ^= *p;
+  }
+  if (crc != mtk_hexval(star[1]) * 0x10 + mtk_hexval(star[2])) {
+    return -1;
+  }
+  if ((star - &line[20]) % 2) {
+    return -1;
+  }
+  for (p = &line[20]; p < star; p += 2) {
+    int hi = mtk_hexval(p[0]);
+    int lo = mtk_hexval(p[1]);
+    if (hi < 0 || lo < 0 || j >= data_size) {
+      return -1;
+    }
+    data[j++] = hi * 0x10 + lo;
+  }
+  return j;
+}
+
+/*
+ * Read blocks of bsize bytes at addr, addr + stride, ... up to addr_end.
+ */
+static void mtk_fetch(unsigned int addr, unsigned int addr_end,
+                      unsigned int stride, unsigned int bsize, int window,
+                      mtk_block_cb cb, void* ctx)
+{
+  mtk_block* blk;
+  unsigned int line_size = 2*bsize + 32; // logdata as nmea/hex.
+  char* line;
+  unsigned char* data;
+  unsigned int nblocks, next, done, k;
+  int acks_pending = 0;
+  int stopped = 0;
+
+  if (addr >= addr_end) {
+    return;
+  }
+  nblocks = (addr_end - addr + stride - 1) / stride;
+
+  blk = (mtk_block*) xcalloc(window, sizeof(mtk_block));
+  for (k = 0; k < (unsigned int) window; k++) {
+    blk[k].data = (unsigned char*) xmalloc(bsize);
+  }
+  line = (char*) xmalloc(line_size);
+  data = (unsigned char*) xmalloc(bsize);
+
+  next = done = 0;
+  while (done < nblocks && !stopped) {
+    int rc;
+
+    // keep the window full.
+    while (next < nblocks && next - done < (unsigned int) window) {
+      mtk_block* b = &blk[next % window];
+      b->addr = addr + next * stride;
+      b->tries = 0;
+      mtk_request_block(b, bsize);
+      acks_pending++;
+      next++;
+    }
+
+    memset(line, '\0', line_size);
+    rc = gbser_read_line(fd, line, line_size-1, TIMEOUT, 0x0A, 0x0D);
+    if (rc == gbser_TIMEOUT) {
+      // the link went quiet - ask again for whatever is missing.
+      acks_pending = 0;
+      for (k = done; k < next; k++) {
+        mtk_block* b = &blk[k % window];
+        if (b->got < bsize) {
+          mtk_request_block(b, bsize);
+          acks_pending++;
+        }
+      }
+      continue;
+    }
+    if (rc != gbser_OK) {
+      fatal(MYNAME "mtk_read(): Read error (%d)\n", rc);
+    }
+    dbg(8, "Read %d bytes: '%s'\n", (int) strlen(line), line);
+
+    if (strncmp(line, "$PMTK182,8,", 11) == 0) { //  $PMTK182,8,00005000,FFFFFFF
+      unsigned int data_addr = 0;
+      int addr_ok;
+      int len = mtk_decode_data(line, &data_addr, &addr_ok, data, bsize);
+      mtk_block* b = NULL;
+
+      if (addr_ok) {
+        for (k = done; k < next; k++) {
+          mtk_block* c = &blk[k % window];
+          if (data_addr >= c->addr && data_addr < c->addr + bsize) {
+            b = c;
+            break;
+          }
+        }
+      }
+      if (b == NULL) {
+        // a late duplicate of a block already handled, or unreadable.
+        dbg(3, "Ignoring reply at 0x%.8x\n", data_addr);
+        continue;
+      }
+      if (len < 0) {
+        dbg(2, "\nCorrupt reply at 0x%.8x\n", data_addr);
+        mtk_request_block(b, bsize);
+        acks_pending++;
+        continue;
+      }
+      if (data_addr != b->addr + b->got || b->got + len > bsize) {
+        // left over from an earlier request for the same block.
+        continue;
+      }
+      memcpy(b->data + b->got, data, len);
+      b->got += len;
+    } else if (strncmp(line, "$PMTK001,182,7,", 15) == 0) {  // Command ACK
+      acks_pending--;
+      if (line[15] != '3') {
+        dbg(2, "\nLog req. failed (%c)\n", line[15]);
+      }
+    }
+
+    // hand over completed blocks in address order.
+    while (done < next && !stopped) {
+      mtk_block* b = &blk[done % window];
+      if (b->got < bsize) {
+        break;
+      }
+      if (!cb(b->addr, b->data, bsize, ctx)) {
+        stopped = 1;
+      }
+      done++;
+    }
+  }
+
+  // let replies to requests we no longer need drain away.
+  while (acks_pending > 0) {
+    if (gbser_read_line(fd, line, line_size-1, TIMEOUT, 0x0A, 0x0D) != gbser_OK) {
+      break;
+    }
+    if (strncmp(line, "$PMTK001,182,7,", 15) == 0) {
+      acks_pending--;
+    }
+  }
+
+  for (k = 0; k < (unsigned int) window; k++) {
+    xfree(blk[k].data);
+  }
+  xfree(blk);
+  xfree(line);
+  xfree(data);
+}
+
+typedef struct {
+  FILE* dout;
+  unsigned long dsize;
+  unsigned long dpos;
+  unsigned int addr_max;
+  unsigned char* buf;
+} mtk_download;
+
+// first block of each 64kB sector: find the end of the log and how much
+// of an earlier download is still valid.
+static int mtk_scan_block(unsigned int addr, const unsigned char* data,
+                          unsigned int len, void* ctx)
+{
+  mtk_download* dl = (mtk_download*) ctx;
+  unsigned int i;
+
+  if (dl->dsize > 0 && addr < dl->dsize) {
+    fseek(dl->dout, addr, SEEK_SET);
+    if (fread(dl->buf, 1, len, dl->dout) == len && memcmp(dl->buf, data, len) == 0) {
+      dl->dpos = addr;
+      dbg(2, "%s same at %d\n", TEMP_DATA_BIN, addr);
+    } else {
+      dbg(2, "%s differs at %d\n", TEMP_DATA_BIN, addr);
+    }
+  }
+  for (i = 0; i < len && data[i] == 0xff; i++) {
+    ;
+  }
+  if (i == len) {  // data in sector - we've found max sector..
+    dl->addr_max = addr;
+    dbg(1, "Initial scan done - Download %dkB from device\n", (dl->addr_max+1) >> 10);
+    return 0;
+  }
+  return 1;
+}
+
+static int mtk_save_block(unsigned int addr, const unsigned char* data,
+                          unsigned int len, void* ctx)
+{
+  mtk_download* dl = (mtk_download*) ctx;
+  unsigned int i, ff_len = 0, null_len = 0;
+
+  for (i = 0; i < len; i++) {
+    if (data[i] == 0xff) {
+      ff_len++;
+    }
+    if (data[i] == 0x00) {
+      null_len++;
+    }
+  }
+  if (null_len == len) {  // 0x00 block - bad block....
+    fprintf(stderr, "FIXME -- read bad block at 0x%.6x - retry ? skip ?\n", addr);
+  }
+  // blocks arrive in order, so the file is written sequentially.
+  if (fwrite(data, 1, len, dl->dout) != len) {
+    fatal(MYNAME ": Failed to write temp. binary file\n");
+  }
+  addr += len;
+  if (global_opts.verbose_status || (global_opts.debug_level >= 2 && global_opts.debug_level < 5)) {
+    int perc;
+    perc = 100 - 100*(dl->addr_max-addr)/dl->addr_max;
+    if (addr >= dl->addr_max || ff_len == len) {
+      perc = 100;
+    }
+    fprintf(stderr, "\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\bReading 0x%.6x %3d %%", addr, perc);
+  }
+  if (ff_len == len) {  // 0xff block - read complete...
+    dl->addr_max = addr;
+    return 0;
+  }
+  return 1;
+}
+
 static void mtk_read(void)
 {
-  char cmd[256];
-  char* line = NULL;
-  unsigned char crc, *data = NULL;
-  int cmdLen, j, bsize, i, len, ff_len, null_len, rc, init_scan, retry_cnt, log_enabled;
-  unsigned int line_size, data_size, data_addr, addr, addr_max;
+  int i, bsize, window, init_scan, log_enabled;
+  unsigned int addr_max;
   unsigned long dsize, dpos = 0;
   FILE* dout;
   char* fusage = NULL;
+  mtk_download dl;
 
 
   if (*OPT_erase_only != '0') {
@@ -543,6 +871,12 @@ static void mtk_read(void)
     return;
   }
 
+  bsize = atoi(OPT_block_size);
+  if (bsize & (bsize - 1)) {
+    fatal(MYNAME ": block_size must be a power of two.\n");
+  }
+  window = atoi(OPT_window);
+
   log_enabled = 0;
   init_scan = 0;
   dout = fopen(TEMP_DATA_BIN, "r+b");
@@ -608,128 +942,19 @@ static void mtk_read(void)
     }
   }
 
-  bsize = 0x0400;
-  addr  = 0x0000;
+  dl.dout = dout;
+  dl.dsize = dsize;
+  dl.dpos = dpos;
+  dl.addr_max = addr_max;
+  dl.buf = (unsigned char*) xmalloc(bsize);
 
-  line_size = 2*bsize + 32; // logdata as nmea/hex.
-  data_size = bsize + 32;
-  if ((line = (char*) xmalloc(line_size)) == NULL) {
-    fatal(MYNAME ": Can't allocate %u bytes for NMEA buffer\n",  line_size);
+  if (init_scan) {
+    mtk_fetch(0, dl.addr_max, 0x10000, bsize, window, mtk_scan_block, &dl);
   }
-  if ((data = (unsigned char*) xmalloc(data_size)) ==  NULL) {
-    fatal(MYNAME ": Can't allocate %u bytes for data buffer\n",  data_size);
-  }
-  memset(line, '\0', line_size);
-  memset(data, '\0', data_size);
-  retry_cnt = 0;
+  fseek(dout, dl.dpos, SEEK_SET);
+  mtk_fetch(dl.dpos, dl.addr_max, bsize, bsize, window, mtk_save_block, &dl);
+  xfree(dl.buf);
 
-  while (init_scan || addr < addr_max) {
-    // generate - read address NMEA command, add crc.
-    crc = 0;
-    cmdLen = snprintf(cmd, sizeof(cmd), "$PMTK182,7,%.8x,%.8x", addr, bsize);
-    for (i=1; i<cmdLen; i++) {
-      crc ^= cmd[i];
-    }
-
-    cmdLen += snprintf(&cmd[cmdLen], sizeof(cmd)-cmdLen,  "*%.2X\r\n", crc);
-mtk_retry:
-    do_send_cmd(cmd, cmdLen);
-
-    memset(line, '\0', line_size);
-    do {
-      rc = gbser_read_line(fd, line, line_size-1, TIMEOUT, 0x0A, 0x0D);
-      if (rc != gbser_OK) {
-        if (rc == gbser_TIMEOUT && retry_cnt < 3) {
-          dbg(2, "\nRetry %d at 0x%.8x\n", retry_cnt, addr);
-          retry_cnt++;
-          goto mtk_retry;
-        } // else
-        fatal(MYNAME "mtk_read(): Read error (%d)\n", rc);
-      }
-      len = strlen(line);
-      dbg(8, "Read %d bytes: '%s'\n", len, line);
-
-      if (len > 0) {
-        line[len] = '\0';
-        if (strncmp(line, "$PMTK182,8", 10) == 0) { //  $PMTK182,8,00005000,FFFFFFF
-          retry_cnt = 0;
-          data_addr = strtoul(&line[11], NULL, 16);
-          fseek(dout, data_addr, SEEK_SET);
-          i = 20;
-          j = 0;
-          ff_len = 0; // number of 0xff bytes.
-          null_len = 0; // number of 0x00 bytes.
-          while (i < (len-3)) {
-            data[j] = (isdigit(line[i])?(line[i]-'0'):(line[i]-'A'+0xA))*0x10 +
-                      (isdigit(line[i+1])?(line[i+1]-'0'):(line[i+1]-'A'+0xA));
-            if (data[j] == 0xff) {
-              ff_len++;
-            }
-            if (data[j] == 0x00) {
-              null_len++;
-            }
-            i += 2;
-            j++;
-          }
-          if (init_scan) {
-            if (dsize > 0 && addr < dsize) {
-              fseek(dout, addr, SEEK_SET);
-              if (fread(line, 1, bsize, dout) == bsize && memcmp(line, data, bsize) == 0) {
-                dpos = addr;
-                dbg(2, "%s same at %d\n", TEMP_DATA_BIN, addr);
-              } else {
-                dbg(2, "%s differs at %d\n", TEMP_DATA_BIN, addr);
-              }
-            }
-            if (ff_len == j) {  // data in sector - we've found max sector..
-              addr_max = addr;
-              dbg(1, "Initial scan done - Download %dkB from device\n", (addr_max+1) >> 10);
-            }
-            len = 0;
-          } else {
-            if (null_len == j) {  // 0x00 block - bad block....
-              fprintf(stderr, "FIXME -- read bad block at 0x%.6x - retry ? skip ?\n%s\n", data_addr, line);
-            }
-            if (fwrite(data, 1, j, dout) != j) {
-              fatal(MYNAME ": Failed to write temp. binary file\n");
-            }
-            if (ff_len == j) {  // 0xff block - read complete...
-              len = ff_len;
-              addr_max = addr;
-              break;
-            } else {
-              len = 0;
-            }
-          }
-        } else if (strncmp(line, "$PMTK001,182,7,", 15) == 0) {  // Command ACK
-          if (line[15] != '3') {
-            // fixme - we should timeout here when no log data has been received...
-            dbg(2, "\nLog req. failed (%c)\n", line[15]);
-            gb_sleep(10*1000);
-            retry_cnt++;
-            goto mtk_retry;
-          }
-        }
-      }
-    } while (len != 0);
-    if (init_scan) {
-      addr += 0x10000;
-      if (addr >= addr_max) {  // initial scan complete...
-        init_scan = 0;
-        addr = dpos;
-      }
-    } else {
-      addr += bsize;
-      if (global_opts.verbose_status || (global_opts.debug_level >= 2 && global_opts.debug_level < 5)) {
-        int perc;
-        perc = 100 - 100*(addr_max-addr)/addr_max;
-        if (addr >= addr_max) {
-          perc = 100;
-        }
-        fprintf(stderr, "\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\bReading 0x%.6x %3d %%", addr, perc);
-      }
-    }
-  }
   if (dout != NULL) {
     fclose(dout);
   }
@@ -744,12 +969,6 @@ mtk_retry:
   } else {
     dbg(1, "Note !!! -- Logging is DISABLED !\n");
   }
-  if (line != NULL) {
-    xfree(line);
-  }
-  if (data != NULL) {
-    xfree(data);
-  }
 
   file_init(TEMP_DATA_BIN);
   file_read();
@@ -799,13 +1018,13 @@ static int add_trackpoint(int idx, unsigned long bmask, struct data_item* itm)
   }
 
   if (bmask & (1<<PDOP)) {
-    trk->pdop = itm->pdop;
+    trk->AllocExt()->pdop = itm->pdop;
   }
   if (bmask & (1<<HDOP)) {
-    trk->hdop = itm->hdop;
+    trk->AllocExt()->hdop = itm->hdop;
   }
   if (bmask & (1<<VDOP)) {
-    trk->vdop = itm->vdop;
+    trk->AllocExt()->vdop = itm->vdop;
   }
 
   if (bmask & (1<<HEADING)) {
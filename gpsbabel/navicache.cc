@@ -136,13 +136,13 @@ NaviReadCache(const QXmlStreamReader& reader)
     QString t = a.value("cache_type").toString();
     gc_data->type = nc_mktype(t);
     if (t == "normal") {
-      wpt_tmp->icon_descr = "Geocache-regular";
+      wpt_tmp->AllocExt()->icon_descr = "Geocache-regular";
     } else if (t == "multi-part") {
-      wpt_tmp->icon_descr = "Geocache-multi";
+      wpt_tmp->AllocExt()->icon_descr = "Geocache-multi";
     } else if (t == "moving_travelling") {
-      wpt_tmp->icon_descr = "Geocache-moving";
+      wpt_tmp->AllocExt()->icon_descr = "Geocache-moving";
     } else {
-      wpt_tmp->icon_descr = QString("Geocache-%-%1").arg(t);
+      wpt_tmp->AllocExt()->icon_descr = QString("Geocache-%-%1").arg(t);
     }
   }
 
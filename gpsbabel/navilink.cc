@@ -416,7 +416,7 @@ decode_waypoint(const unsigned char* buffer)
   char* s = xstrdup((char*)buffer + 4);
   waypt->shortname = s;
   xfree(s);
-  waypt->icon_descr = icon_table[buffer[28]];
+  waypt->AllocExt()->icon_descr = icon_table[buffer[28]];
   waypt->SetCreationTime(decode_datetime(buffer + 22));
 
   return waypt;
@@ -433,7 +433,7 @@ encode_waypoint(const Waypoint* waypt, unsigned char* buffer)
   buffer[11] = 0;
   encode_position(waypt, buffer + 12);
   encode_datetime(waypt->GetCreationTime().toTime_t(), buffer + 22);
-  buffer[28] = find_icon_from_descr(waypt->icon_descr);
+  buffer[28] = find_icon_from_descr(waypt->ext->icon_descr);
   buffer[29] = 0;
   buffer[30] = 0x00;
   buffer[31] = 0x7e;
@@ -852,7 +852,7 @@ navilink_decode_logpoint(const unsigned char* buffer)
   Waypoint* waypt = NULL;
   waypt = new Waypoint;
 
-  waypt->hdop = ((unsigned char)buffer[0]) * 0.2f;
+  waypt->AllocExt()->hdop = ((unsigned char)buffer[0]) * 0.2f;
   waypt->sat = buffer[1];
   waypt->SetCreationTime(decode_sbp_datetime_packed(buffer + 4), 
                          decode_sbp_msec(buffer + 2));
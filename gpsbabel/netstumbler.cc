@@ -217,15 +217,15 @@ data_read(void)
       }
 
       if (flags & 0x0010) {	/* encrypted? */
-        wpt_tmp->icon_descr = seicon;
+        wpt_tmp->AllocExt()->icon_descr = seicon;
       } else {
-        wpt_tmp->icon_descr = sneicon;
+        wpt_tmp->AllocExt()->icon_descr = sneicon;
       }
     } else {
       if (flags & 0x0010) {	/* encrypted? */
-        wpt_tmp->icon_descr = nseicon;
+        wpt_tmp->AllocExt()->icon_descr = nseicon;
       } else {
-        wpt_tmp->icon_descr = nsneicon;
+        wpt_tmp->AllocExt()->icon_descr = nsneicon;
       }
     }
 
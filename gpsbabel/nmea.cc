@@ -29,6 +29,13 @@
 #include "strptime.h"
 #include "jeeps/gpsmath.h"
 
+#include <QtCore/QMutex>
+#include <QtCore/QQueue>
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+#include <QtCore/QWaitCondition>
+
 /**********************************************************
 
    ' 1      2      3        4 5         6 7 8  9   10   11 12  13 14 15
@@ -176,6 +183,7 @@ static char* opt_baud;
 static char* opt_append;
 static char* opt_gisteq;
 static char* opt_ignorefix;
+static char* opt_threads;
 
 static long sleepus;
 static int getposn;
@@ -206,6 +214,7 @@ arglist_t nmea_args[] = {
   {"baud", &opt_baud, "Speed in bits per second of serial port (baud=4800)", NULL, ARGTYPE_INT, ARG_NOMINMAX },
   {"gisteq", &opt_gisteq, "Write tracks for Gisteq Phototracker", "0", ARGTYPE_BOOL, ARG_NOMINMAX },
   {"ignore_fix", &opt_ignorefix, "Accept position fixes in gpgga marked invalid", "0", ARGTYPE_BOOL, ARG_NOMINMAX },
+  {"threads", &opt_threads, "Parse large files in chunks on this many threads (overrides -j)", NULL, ARGTYPE_INT, "0", NULL },
   ARG_TERMINATOR
 };
 
@@ -370,132 +379,471 @@ nmea_set_waypoint_time(Waypoint* wpt, struct tm* time, double fsec)
   }
 }
 
-static void
-gpgll_parse(char* ibuf)
+/*
+ * Sentences are split once into fields that point back into the line
+ * buffer.  An empty field (",,") is a zero length field; the decoders
+ * below return 0 for it, which is what the parse routines expect for
+ * missing data.
+ */
+#define NMEA_MAXFIELDS 64
+
+typedef struct {
+  const char* p;
+  int len;
+} nmea_field_t;
+
+typedef struct {
+  nmea_field_t fld[NMEA_MAXFIELDS];	/* fld[0] is the address field, e.g. "GPGGA" */
+  int nfld;
+  const char* end;			/* the '*' or the end of the line */
+} nmea_sentence_t;
+
+static const nmea_field_t nmea_empty_field = { "", 0 };
+
+static const nmea_field_t*
+nmea_field(const nmea_sentence_t* s, int i)
 {
-  double latdeg, lngdeg;
+  return (i < s->nfld) ? &s->fld[i] : &nmea_empty_field;
+}
+
+/*
+ * Fields that don't look like a plain decimal number get a NUL
+ * terminated copy and go through sscanf, as the whole line used to.
+ */
+static const char*
+nmea_field_str(const nmea_field_t* f, char* buf, int bufsz)
+{
+  int len = (f->len < bufsz) ? f->len : bufsz - 1;
+
+  memcpy(buf, f->p, len);
+  buf[len] = '\0';
+  return buf;
+}
+
+/*
+ * Split a plain decimal ("-4231.8291") into an integer mantissa and the
+ * number of digits after the point.  Returns 0 for anything else or
+ * for more than 15 significant digits, where the mantissa would no
+ * longer be exact in a double.
+ */
+static int
+nmea_decimal(const nmea_field_t* f, uint64_t* mant, int* scale, int* neg)
+{
+  const char* p = f->p;
+  const char* e = f->p + f->len;
+  uint64_t m = 0;
+  int digits = 0;
+  int frac = -1;
+
+  *neg = 0;
+  if ((p < e) && ((*p == '-') || (*p == '+'))) {
+    *neg = (*p == '-');
+    p++;
+  }
+  for (; p < e; p++) {
+    if ((*p >= '0') && (*p <= '9')) {
+      m = m * 10 + (*p - '0');
+      if (frac >= 0) {
+        frac++;
+      }
+      if (++digits > 15) {
+        return 0;
+      }
+    } else if ((*p == '.') && (frac < 0)) {
+      frac = 0;
+    } else {
+      break;
+    }
+  }
+  if ((digits == 0) || ((p < e) && ((*p == 'e') || (*p == 'E')))) {
+    return 0;
+  }
+  *mant = m;
+  *scale = (frac < 0) ? 0 : frac;
+  return 1;
+}
+
+static const double nmea_pow10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+  1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+/*
+ * Both operands are exact, so the one division is correctly rounded
+ * and gives the same bits as strtod().
+ */
+static double
+nmea_double(const nmea_sentence_t* s, int i)
+{
+  const nmea_field_t* f = nmea_field(s, i);
+  uint64_t m;
+  int scale, neg;
+  double d = 0;
+
+  if (f->len == 0) {
+    return 0;
+  }
+  if (nmea_decimal(f, &m, &scale, &neg)) {
+    d = (double) m / nmea_pow10[scale];
+    return neg ? -d : d;
+  } else {
+    char buf[64];
+    sscanf(nmea_field_str(f, buf, sizeof(buf)), "%lf", &d);
+  }
+  return d;
+}
+
+/*
+ * Same idea in single precision for the fields that were read with
+ * "%f": exact while the mantissa fits in 24 bits and 10^scale is
+ * representable.
+ */
+static float
+nmea_float(const nmea_sentence_t* s, int i)
+{
+  const nmea_field_t* f = nmea_field(s, i);
+  uint64_t m;
+  int scale, neg;
+  float v = 0;
+
+  if (f->len == 0) {
+    return 0;
+  }
+  if (nmea_decimal(f, &m, &scale, &neg) && (m < 0x1000000) && (scale <= 10)) {
+    v = (float) m / (float) nmea_pow10[scale];
+    return neg ? -v : v;
+  } else {
+    char buf[64];
+    sscanf(nmea_field_str(f, buf, sizeof(buf)), "%f", &v);
+  }
+  return v;
+}
+
+static int
+nmea_int(const nmea_sentence_t* s, int i)
+{
+  const nmea_field_t* f = nmea_field(s, i);
+  const char* p = f->p;
+  const char* e = f->p + f->len;
+  int neg = 0;
+  int v = 0;
+
+  if ((p < e) && ((*p == '-') || (*p == '+'))) {
+    neg = (*p == '-');
+    p++;
+  }
+  if ((p < e) && ((*p < '0') || (*p > '9'))) {
+    char buf[64];
+    v = 0;
+    sscanf(nmea_field_str(f, buf, sizeof(buf)), "%d", &v);
+    return v;
+  }
+  for (; (p < e) && (*p >= '0') && (*p <= '9'); p++) {
+    v = v * 10 + (*p - '0');
+  }
+  return neg ? -v : v;
+}
+
+static char
+nmea_char(const nmea_sentence_t* s, int i)
+{
+  const nmea_field_t* f = nmea_field(s, i);
+
+  return f->len ? f->p[0] : '\0';
+}
+
+static int
+nmea_hexdigit(char c)
+{
+  if ((c >= '0') && (c <= '9')) {
+    return c - '0';
+  }
+  if ((c >= 'A') && (c <= 'F')) {
+    return c - 'A' + 10;
+  }
+  if ((c >= 'a') && (c <= 'f')) {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+/*
+ * What the checksum test made of a line.
+ */
+typedef enum {
+  nmea_ck_drop = 0,	/* not a sentence, or a bad checksum */
+  nmea_ck_good,		/* checksum present and correct */
+  nmea_ck_none		/* no checksum */
+} nmea_check_t;
+
+/*
+ * One pass over the line: trim it, compute the checksum, find the
+ * fields.  Returns nmea_ck_drop if the sentence is to be ignored
+ * regardless of what came before it; whether a sentence without a
+ * checksum is acceptable is decided later in nmea_apply().
+ */
+static nmea_check_t
+nmea_split(const char* ibuf, nmea_sentence_t* s, int* dollars)
+{
+  const char* b = ibuf;
+  const char* e;
+  const char* c;
+  const char* star = NULL;
+  int nstar = 0;
+  int x = 0, xstar = 0;
+
+  while (*b && ((unsigned char)*b <= ' ')) {
+    b++;
+  }
+
+  /*
+   * GISTEQ PhotoTracker (stupidly) puts a bogus field in front
+   * of the line.  Look for it and toss it.
+   */
+  if (0 == strncmp(b, "---,", 4)) {
+    b += 4;
+  }
+
+  if (*b != '$') {
+    return nmea_ck_drop;
+  }
+
+  *dollars = 0;
+  e = b + 1;
+  s->fld[0].p = b + 1;
+  s->nfld = 1;
+  for (c = b + 1; *c; c++) {
+    switch (*c) {
+    case ',':
+      if (s->nfld < NMEA_MAXFIELDS) {
+        s->fld[s->nfld - 1].len = c - s->fld[s->nfld - 1].p;
+        s->fld[s->nfld++].p = c + 1;
+      }
+      break;
+    case '*':
+      /* The checksum follows the last '*'. */
+      star = c;
+      xstar = x;
+      nstar = s->nfld;
+      break;
+    case '$':
+      (*dollars)++;
+      break;
+    }
+    if ((unsigned char)*c > ' ') {
+      e = c + 1;
+    }
+    x ^= *c;
+  }
+
+  if (star != NULL) {
+    int hi = nmea_hexdigit(star[1]);
+    int lo = (hi < 0) ? -1 : nmea_hexdigit(star[2]);
+
+    if ((hi < 0) || (xstar != ((lo < 0) ? hi : (hi << 4 | lo)))) {
+      return nmea_ck_drop;
+    }
+    s->nfld = nstar;
+    s->end = star;
+  } else {
+    s->end = e;
+  }
+  s->fld[s->nfld - 1].len = s->end - s->fld[s->nfld - 1].p;
+
+  return (star != NULL) ? nmea_ck_good : nmea_ck_none;
+}
+
+/*
+ * A sentence decoded without looking at any reader state.  Times and
+ * dates are kept as struct tm fields; nmea_apply() then carries the
+ * date from sentence to sentence and builds the points, exactly as
+ * parsing the lines one by one does.  Keeping the two steps apart is
+ * what lets the chunked reader decode on a thread pool.
+ */
+typedef enum {
+  nmea_s_none = 0,	/* nothing we read */
+  nmea_s_gga,
+  nmea_s_rmc,
+  nmea_s_gll,
+  nmea_s_wpl,
+  nmea_s_zda,
+  nmea_s_vtg,
+  nmea_s_gsa,
+  nmea_s_pcmpt,
+  nmea_s_adpmb
+} nmea_stype_t;
+
+typedef struct {
+  unsigned char check;		/* nmea_check_t */
+  unsigned char type;		/* nmea_stype_t */
+  char status;			/* GLL/RMC 'A'ctive, GSA fix, PCMPT altitude flag */
+  int fix;			/* GGA fix quality, PCMPT record type */
+  int nsats;			/* GGA satellites, GSA PRNs in use */
+  int hour, min, sec;
+  int mday, mon, year;		/* as in struct tm */
   double fsec;
-  char lngdir, latdir;
-  double hmsd;
+  double hms;			/* becomes last_read_time */
+  double lat, lon;		/* degrees */
+  double alt;
+  double geoidheight;
+  double hdop, pdop, vdop;
+  double knots, kph;
+  double course;
+  const char* name;		/* WPL name, points into the line */
+  int namelen;
+} nmea_rec_t;
+
+static void
+nmea_decode_hms(double hms, nmea_rec_t* r)
+{
+  r->hms = hms;
+  r->fsec = hms - (int)hms;
+  r->sec = (long) hms % 100;
+  hms = hms / 100;
+  r->min = (long) hms % 100;
+  hms = hms / 100;
+  r->hour = (long) hms % 100;
+}
+
+static double
+nmea_decode_latlon(const nmea_sentence_t* s, int i, char neg)
+{
+  double deg = nmea_double(s, i);
+
+  if (nmea_char(s, i + 1) == neg) {
+    deg = -deg;
+  }
+  return ddmm2degrees(deg);
+}
+
+static void
+nmea_set_tm_time(const nmea_rec_t* r)
+{
+  tm.tm_sec = r->sec;
+  tm.tm_min = r->min;
+  tm.tm_hour = r->hour;
+}
+
+static void
+nmea_set_tm_date(const nmea_rec_t* r)
+{
+  tm.tm_year = r->year;
+  tm.tm_mon = r->mon;
+  tm.tm_mday = r->mday;
+}
+
+static void
+gpgll_decode(const nmea_sentence_t* s, nmea_rec_t* r)
+{
   int hms;
-  char valid = 0;
+  double hmsd;
+
+  r->status = nmea_char(s, 6);
+  r->lat = nmea_decode_latlon(s, 1, 'S');
+  r->lon = nmea_decode_latlon(s, 3, 'W');
+
+  hmsd = nmea_double(s, 5);
+  hms = (int) hmsd;
+  r->hms = hms;
+  r->fsec = hmsd - hms;
+  r->sec = hms % 100;
+  hms = hms / 100;
+  r->min = hms % 100;
+  hms = hms / 100;
+  r->hour = hms % 100;
+}
+
+static void
+gpgll_apply(const nmea_rec_t* r)
+{
   Waypoint* waypt;
 
+  if ((posn_type == gpgga) || (posn_type == gprmc)) {
+    return;
+  }
+
   if (trk_head == NULL) {
     trk_head = route_head_alloc();
     track_add_head(trk_head);
   }
 
-  sscanf(ibuf,"$%*2cGLL,%lf,%c,%lf,%c,%lf,%c,",
-         &latdeg,&latdir,
-         &lngdeg,&lngdir,
-         &hmsd,&valid);
-
-  if (valid != 'A') {
+  if (r->status != 'A') {
     return;
   }
 
-  hms = (int) hmsd;
-  last_read_time = hms;
-  fsec = hmsd - hms;
-
-  tm.tm_sec = hms % 100;
-  hms = hms / 100;
-  tm.tm_min = hms % 100;
-  hms = hms / 100;
-  tm.tm_hour = hms % 100;
+  last_read_time = r->hms;
+  nmea_set_tm_time(r);
 
   waypt = new Waypoint;
 
-  nmea_set_waypoint_time(waypt, &tm, fsec);
-
-  if (latdir == 'S') {
-    latdeg = -latdeg;
-  }
-  waypt->latitude = ddmm2degrees(latdeg);
+  nmea_set_waypoint_time(waypt, &tm, r->fsec);
 
-  if (lngdir == 'W') {
-    lngdeg = -lngdeg;
-  }
-  waypt->longitude = ddmm2degrees(lngdeg);
+  waypt->latitude = r->lat;
+  waypt->longitude = r->lon;
 
   nmea_release_wpt(curr_waypt);
   curr_waypt = waypt;
 }
 
 static void
-gpgga_parse(char* ibuf)
+gpgga_decode(const nmea_sentence_t* s, nmea_rec_t* r)
+{
+  r->fix = (s->nfld > 6) ? nmea_int(s, 6) : (int) fix_unknown;
+  nmea_decode_hms(nmea_double(s, 1), r);
+  r->lat = nmea_decode_latlon(s, 2, 'S');
+  r->lon = nmea_decode_latlon(s, 4, 'W');
+  r->nsats = nmea_int(s, 7);
+  r->hdop = nmea_double(s, 8);
+  r->alt = nmea_double(s, 9);
+  r->geoidheight = nmea_double(s, 11);
+}
+
+static void
+gpgga_apply(const nmea_rec_t* r)
 {
-  double latdeg, lngdeg;
-  char lngdir, latdir;
-  double hms;
-  double alt;
-  int fix = fix_unknown;
-  int nsats = 0;
-  double hdop;
-  char altunits;
-  double geoidheight;
-  char geoidheightunits;
   Waypoint* waypt;
-  double fsec;
+
+  posn_type = gpgga;
 
   if (trk_head == NULL) {
     trk_head = route_head_alloc();
     track_add_head(trk_head);
   }
 
-  sscanf(ibuf,"$%*2cGGA,%lf,%lf,%c,%lf,%c,%d,%d,%lf,%lf,%c,%lf,%c",
-         &hms, &latdeg,&latdir,
-         &lngdeg,&lngdir,
-         &fix,&nsats,&hdop,&alt,&altunits,&geoidheight,&geoidheightunits);
-
   /*
    * In serial mode, allow the fix with an invalid position through
    * as serial units will often spit a remembered position up and
    * that is more comfortable than nothing at all...
    */
   CHECK_BOOL(opt_ignorefix);
-  if ((fix <= 0) && (read_mode != rm_serial) && (!opt_ignorefix)) {
+  if ((r->fix <= 0) && (read_mode != rm_serial) && (!opt_ignorefix)) {
     return;
   }
 
-  last_read_time = hms;
-  fsec = hms - (int)hms;
-
-  tm.tm_sec = (long) hms % 100;
-  hms = hms / 100;
-  tm.tm_min = (long) hms % 100;
-  hms = hms / 100;
-  tm.tm_hour = (long) hms % 100;
+  last_read_time = r->hms;
+  nmea_set_tm_time(r);
 
   waypt  = new Waypoint;
 
-  nmea_set_waypoint_time(waypt, &tm, fsec);
+  nmea_set_waypoint_time(waypt, &tm, r->fsec);
 
-  if (latdir == 'S') {
-    latdeg = -latdeg;
-  }
-  waypt->latitude = ddmm2degrees(latdeg);
-
-  if (lngdir == 'W') {
-    lngdeg = -lngdeg;
-  }
-  waypt->longitude = ddmm2degrees(lngdeg);
+  waypt->latitude = r->lat;
+  waypt->longitude = r->lon;
 
-  waypt->altitude = alt;
+  waypt->altitude = r->alt;
 
-  WAYPT_SET(waypt, geoidheight, geoidheight);
+  WAYPT_SET(waypt, geoidheight, r->geoidheight);
 
-  waypt->sat 	= nsats;
+  waypt->sat 	= r->nsats;
 
-  waypt->hdop 	= hdop;
+  waypt->AllocExt()->hdop 	= r->hdop;
 
-  switch (fix) {
+  switch (r->fix) {
   case 0:
     waypt->fix = fix_none;
     break;
   case 1:
-    waypt->fix  = (nsats>3)?(fix_3d):(fix_2d);
+    waypt->fix  = (r->nsats>3)?(fix_3d):(fix_2d);
     break;
   case 2:
     waypt->fix = fix_dgps;
@@ -510,78 +858,65 @@ gpgga_parse(char* ibuf)
 }
 
 static void
-gprmc_parse(char* ibuf)
+gprmc_decode(const nmea_sentence_t* s, nmea_rec_t* r)
+{
+  int dmy;
+
+  /* If we run out of fields before the date, the sentence is invalid. */
+  r->status = (s->nfld < 10) ? '\0' : nmea_char(s, 2);
+  nmea_decode_hms(nmea_double(s, 1), r);
+  r->lat = nmea_decode_latlon(s, 3, 'S');
+  r->lon = nmea_decode_latlon(s, 5, 'W');
+  r->knots = nmea_double(s, 7);
+  r->course = nmea_double(s, 8);
+
+  dmy = nmea_int(s, 9);
+  r->year = dmy % 100 + 100;
+  dmy = dmy / 100;
+  r->mon  = dmy % 100 - 1;
+  dmy = dmy / 100;
+  r->mday = dmy;
+}
+
+static void
+gprmc_apply(const nmea_rec_t* r)
 {
-  double latdeg, lngdeg;
-  char lngdir, latdir;
-  double hms;
-  char fix;
-  unsigned int dmy;
-  double speed,course;
   Waypoint* waypt;
-  double fsec;
-  char* dmybuf;
-  int i;
+
+  /*
+   * Always read RMC because like ZDA it contains the full date,
+   * but prefer GGA for the position.
+   */
+  if (posn_type != gpgga) {
+    posn_type = gprmc;
+  }
 
   if (trk_head == NULL) {
     trk_head = route_head_alloc();
     track_add_head(trk_head);
   }
 
-  /*
-   * Read everything except the dmy, in case lngdeg
-   * and lngdir are missing.
-   */
-  sscanf(ibuf,"$%*2cRMC,%lf,%c,%lf,%c,%lf,%c,%lf,%lf",
-         &hms, &fix, &latdeg, &latdir,
-         &lngdeg, &lngdir,
-         &speed, &course);
-
-  if (fix != 'A') {
+  if (r->status != 'A') {
     /* ignore this fix - it is invalid */
     return;
   }
 
-  /* Skip past nine commas in ibuf to reach the dmy value */
-  for (dmybuf=ibuf,i=0; i<9; i++) {
-    dmybuf= strchr(dmybuf, ',');
-    if (dmybuf==NULL) {
-      /* If we run out of commas, the sentence is invalid. */
-      return;
-    }
-    dmybuf++;
-  }
-
-  /* Now read dmy from the correct position */
-  sscanf(dmybuf,"%u", &dmy);
-
-  last_read_time = hms;
-  fsec = hms - (int)hms;
-
-  tm.tm_sec = (long) hms % 100;
-  hms = hms / 100;
-  tm.tm_min = (long) hms % 100;
-  hms = hms / 100;
-  tm.tm_hour = (long) hms % 100;
-
-  tm.tm_year = dmy % 100 + 100;
-  dmy = dmy / 100;
-  tm.tm_mon  = dmy % 100 - 1;
-  dmy = dmy / 100;
-  tm.tm_mday = dmy;
+  last_read_time = r->hms;
+  nmea_set_tm_time(r);
+  nmea_set_tm_date(r);
 
   if (posn_type == gpgga) {
     /* capture useful data update and exit */
     if (curr_waypt) {
       if (! WAYPT_HAS(curr_waypt, speed)) {
-        WAYPT_SET(curr_waypt, speed, KNOTS_TO_MPS(speed));
+        WAYPT_SET(curr_waypt, speed, KNOTS_TO_MPS(r->knots));
       }
       if (! WAYPT_HAS(curr_waypt, course)) {
-        WAYPT_SET(curr_waypt, course, course);
+        WAYPT_SET(curr_waypt, course, r->course);
       }
       /* The change of date wasn't recorded when
        * going from 235959 to 000000. */
-      nmea_set_waypoint_time(curr_waypt, &tm, fsec);
+      nmea_set_waypoint_time(curr_waypt, &tm, r->fsec);
     }
     /* This point is both a waypoint and a trackpoint. */
     if (amod_waypoint) {
@@ -593,21 +928,14 @@ gprmc_parse(char* ibuf)
 
   waypt  = new Waypoint;
 
-  WAYPT_SET(waypt, speed, KNOTS_TO_MPS(speed));
+  WAYPT_SET(waypt, speed, KNOTS_TO_MPS(r->knots));
 
-  WAYPT_SET(waypt, course, course);
+  WAYPT_SET(waypt, course, r->course);
 
-  nmea_set_waypoint_time(waypt, &tm, fsec);
+  nmea_set_waypoint_time(waypt, &tm, r->fsec);
 
-  if (latdir == 'S') {
-    latdeg = -latdeg;
-  }
-  waypt->latitude = ddmm2degrees(latdeg);
-
-  if (lngdir == 'W') {
-    lngdeg = -lngdeg;
-  }
-  waypt->longitude = ddmm2degrees(lngdeg);
+  waypt->latitude = r->lat;
+  waypt->longitude = r->lon;
 
   nmea_release_wpt(curr_waypt);
   curr_waypt = waypt;
@@ -620,130 +948,113 @@ gprmc_parse(char* ibuf)
 }
 
 static void
-gpwpl_parse(char* ibuf)
+gpwpl_decode(const nmea_sentence_t* s, nmea_rec_t* r)
 {
-  Waypoint* waypt;
-  double latdeg, lngdeg;
-  char latdir, lngdir;
-  char sname[99];
+  r->lat = nmea_decode_latlon(s, 1, 'S');
+  r->lon = nmea_decode_latlon(s, 3, 'W');
 
-  sscanf(ibuf,"$%*2cWPL,%lf,%c,%lf,%c,%[^*]",
-         &latdeg,&latdir,
-         &lngdeg,&lngdir,
-         sname);
+  /* The name runs to the checksum, commas and all. */
+  if (s->nfld > 5) {
+    r->name = s->fld[5].p;
+    r->namelen = s->end - s->fld[5].p;
+  }
+}
+
+static void
+gpwpl_apply(const nmea_rec_t* r)
+{
+  Waypoint* waypt;
 
   waypt  = new Waypoint;
 
-  if (latdir == 'S') {
-    latdeg = -latdeg;
-  }
-  waypt->latitude = ddmm2degrees(latdeg);
-  if (lngdir == 'W') {
-    lngdeg = -lngdeg;
+  waypt->latitude = r->lat;
+  waypt->longitude = r->lon;
+  if (r->name) {
+    waypt->shortname = QString::fromUtf8(r->name, r->namelen);
   }
-  waypt->longitude = ddmm2degrees(lngdeg);
-
-  waypt->shortname = sname;
 
   curr_waypt = NULL; /* waypoints won't be updated with GPS fixes */
   nmea_add_wpt(waypt, NULL);
 }
 
 static void
-gpzda_parse(char* ibuf)
+gpzda_decode(const nmea_sentence_t* s, nmea_rec_t* r)
 {
-  double hms;
-  int dd, mm, yy, lclhrs, lclmins;
-
-  sscanf(ibuf,"$%*2cZDA,%lf,%d,%d,%d,%d,%d",
-         &hms, &dd, &mm, &yy, &lclhrs, &lclmins);
-  tm.tm_sec  = (int) hms % 100;
-  tm.tm_min  = (((int) hms - tm.tm_sec) / 100) % 100;
-  tm.tm_hour = (int) hms / 10000;
-  tm.tm_mday = dd;
-  tm.tm_mon  = mm - 1;
-  tm.tm_year = yy - 1900;
+  int hms = (int) nmea_double(s, 1);
+
+  r->sec  = hms % 100;
+  r->min  = ((hms - r->sec) / 100) % 100;
+  r->hour = hms / 10000;
+  r->mday = nmea_int(s, 2);
+  r->mon  = nmea_int(s, 3) - 1;
+  r->year = nmea_int(s, 4) - 1900;
 }
 
 static void
-gpgsa_parse(char* ibuf)
+gpzda_apply(const nmea_rec_t* r)
 {
-  char fixauto;
-  char fix;
-  int  prn[12];
-  int  scn,cnt;
-  float pdop=0,hdop=0,vdop=0;
-  char*	tok=0;
+  nmea_set_tm_time(r);
+  nmea_set_tm_date(r);
+}
 
-  memset(prn,0xff,sizeof(prn));
+static void
+gpgsa_decode(const nmea_sentence_t* s, nmea_rec_t* r)
+{
+  int cnt;
 
-  scn = sscanf(ibuf,"$%*2cGSA,%c,%c,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d",
-               &fixauto, &fix,
-               &prn[0],&prn[1],&prn[2],&prn[3],&prn[4],&prn[5],
-               &prn[6],&prn[7],&prn[8],&prn[9],&prn[10],&prn[11]);
+  r->status = nmea_char(s, 2);
 
-  /*
-  	sscanf has scanned all the leftmost elements
-  	we'll rescan by skipping 15 commas to the dops
-  */
-  tok = ibuf;
-  for (cnt=0; (tok)&&(cnt<15); cnt++) {
-    tok = strchr(tok,',');
-    if (!tok) {
-      break;
-    }
-    tok++;
-  }
-  if (tok) {
-    sscanf(tok,"%f,%f,%f",&pdop,&hdop,&vdop);
+  /* fields 3 to 14 are the PRNs of the satellites used, 15 to 17 the dops */
+  for (cnt=3; cnt<15; cnt++) {
+    r->nsats += (nmea_int(s, cnt)>0)?(1):(0);
   }
+  r->pdop = nmea_float(s, 15);
+  r->hdop = nmea_float(s, 16);
+  r->vdop = nmea_float(s, 17);
+}
 
-
+static void
+gpgsa_apply(const nmea_rec_t* r)
+{
   if (curr_waypt) {
 
     if (curr_waypt->fix!=fix_dgps) {
-      if	(fix=='3')	{
+      if	(r->status=='3')	{
         curr_waypt->fix=fix_3d;
-      } else if (fix=='2')	{
+      } else if (r->status=='2')	{
         curr_waypt->fix=fix_2d;
       }
     }
 
-    curr_waypt->pdop = pdop;
-    curr_waypt->hdop = hdop;
-    curr_waypt->vdop = vdop;
+    curr_waypt->AllocExt()->pdop = r->pdop;
+    curr_waypt->AllocExt()->hdop = r->hdop;
+    curr_waypt->AllocExt()->vdop = r->vdop;
 
     if (curr_waypt->sat  <= 0)	{
-      for (cnt=0; cnt<12; cnt++) {
-        curr_waypt->sat += (prn[cnt]>0)?(1):(0);
-      }
+      curr_waypt->sat += r->nsats;
     }
   }
 
 }
 
 static void
-gpvtg_parse(char* ibuf)
+gpvtg_decode(const nmea_sentence_t* s, nmea_rec_t* r)
 {
-  float 	course;
-  char	ct;
-  float	magcourse;
-  char	cm;
-  double	speed_n;
-  char	cn;
-  double	speed_k;
-  char	ck;
-
-  sscanf(ibuf,"$%*2cVTG,%f,%c,%f,%c,%lf,%c,%lf,%c",
-         &course,&ct,&magcourse,&cm,&speed_n,&cn,&speed_k,&ck);
+  r->course = nmea_float(s, 1);
+  r->knots = nmea_double(s, 5);
+  r->kph = nmea_double(s, 7);
+}
 
+static void
+gpvtg_apply(const nmea_rec_t* r)
+{
   if (curr_waypt) {
-    WAYPT_SET(curr_waypt, course, course);
+    WAYPT_SET(curr_waypt, course, r->course);
 
-    if (speed_k>0)
-      WAYPT_SET(curr_waypt, speed, KPH_TO_MPS(speed_k))
+    if (r->kph>0)
+      WAYPT_SET(curr_waypt, speed, KPH_TO_MPS(r->kph))
       else {
-        WAYPT_SET(curr_waypt, speed, KNOTS_TO_MPS(speed_n));
+        WAYPT_SET(curr_waypt, speed, KNOTS_TO_MPS(r->knots));
       }
 
   }
@@ -765,24 +1076,50 @@ double pcmpt_deg(int d)
   return (double) deg + minutes;
 }
 
-void
-pcmpt_parse(char* ibuf)
+static void
+pcmpt_decode(const nmea_sentence_t* s, nmea_rec_t* r)
 {
-  int i, j1, j2, j3, j4, j5, j6;
-  int lat, lon;
-  char altflag, u1, u2;
-  float alt, f1, f2;
+  int i = 0;
+  int lat = 0, lon = 0;
   char coords[20] = {0};
   int dmy, hms;
 
-  dmy = hms = 0;
+  r->status = nmea_char(s, 4);
+  r->alt = nmea_float(s, 5);
+  r->fix = nmea_int(s, 2);
 
-  sscanf(ibuf,"$PCMPT,%d,%d,%d,%c,%f,%d,%[^,],%d,%f,%d,%f,%c,%d,%c,%d",
-         &j1, &j2, &j3, &altflag, &alt, &j4, (char*) &coords,
-         &j5, &f1, &j6, &f2, &u1, &dmy, &u2, &hms);
+  nmea_field_str(nmea_field(s, 7), coords, sizeof(coords));
+  sscanf(coords, "%d%n", &lat, &i);
+  if (coords[i] == 'S') {
+    lat = -lat;
+  }
+  sscanf(coords + i + 1, "%d%n", &lon, &i);
+  if (coords[i] == 'W') {
+    lon= -lon;
+  }
+  r->lat = pcmpt_deg(lat);
+  r->lon = pcmpt_deg(lon);
+
+  hms = nmea_int(s, 15);
+  r->sec = (long) hms % 100;
+  hms = hms / 100;
+  r->min = (long) hms % 100;
+  hms = hms / 100;
+  r->hour = (long) hms % 100;
 
-  if (altflag == 'D' && curr_waypt && alt > 0) {
-    curr_waypt->altitude =  alt /*+ 500*/;
+  dmy = nmea_int(s, 13);
+  r->year = dmy % 10000 - 1900;
+  dmy = dmy / 10000;
+  r->mon  = dmy % 100 - 1;
+  dmy = dmy / 100;
+  r->mday = dmy;
+}
+
+static void
+pcmpt_apply(const nmea_rec_t* r)
+{
+  if (r->status == 'D' && curr_waypt && r->alt > 0) {
+    curr_waypt->altitude =  r->alt /*+ 500*/;
     return;
   }
 
@@ -790,35 +1127,17 @@ pcmpt_parse(char* ibuf)
    * There are a couple of different second line records, but we
    * don't care about them.
    */
-  if (j2 != 1) {
+  if (r->fix != 1) {
     return;
   }
 
-  sscanf(coords, "%d%n", &lat, &i);
-  if (coords[i] == 'S') {
-    lat = -lat;
-  }
-  sscanf(coords + i + 1, "%d%n", &lon, &i);
-  if (coords[i] == 'W') {
-    lon= -lon;
-  }
-
-  if (lat || lon) {
+  if (r->lat || r->lon) {
     curr_waypt = new Waypoint;
-    curr_waypt->longitude = pcmpt_deg(lon);
-    curr_waypt->latitude = pcmpt_deg(lat);
-
-    tm.tm_sec = (long) hms % 100;
-    hms = hms / 100;
-    tm.tm_min = (long) hms % 100;
-    hms = hms / 100;
-    tm.tm_hour = (long) hms % 100;
-
-    tm.tm_year = dmy % 10000 - 1900;
-    dmy = dmy / 10000;
-    tm.tm_mon  = dmy % 100 - 1;
-    dmy = dmy / 100;
-    tm.tm_mday = dmy;
+    curr_waypt->longitude = r->lon;
+    curr_waypt->latitude = r->lat;
+
+    nmea_set_tm_time(r);
+    nmea_set_tm_date(r);
     nmea_set_waypoint_time(curr_waypt, &tm, 0);
     ENQUEUE_HEAD(&pcmpt_head, &curr_waypt->Q);
   } else {
@@ -904,110 +1223,295 @@ nmea_fix_timestamps(route_head* track)
   }
 }
 
-static int
-notalkerid_strmatch(const char * s1, const char *sentenceFormatterMnemonicCode)
-{
 /*
- * compare leading start of parametric sentence character ('$'), sentence address field, and trailing comma
- * to the desired sentence formatter mneumonic code (the 3rd-5th characters of the sentence address field).
- * The talker identifier mneumonic (the 1st-2nd characters of the sentence address field)
- * is likely "GP" for Global Posilioning System (GPS)
- * but other talkers like "IN" for Integrated Navigation can emit relevant sentences,
- * so we ignore the talker identifier mneumonic.
+ * Sentences we read, keyed on the sentence formatter mnemonic (the 3rd-5th
+ * characters of the address field).  The talker identifier is likely "GP"
+ * for Global Positioning System (GPS), but other talkers like "IN" for
+ * Integrated Navigation can emit relevant sentences, so we ignore it.
  */
-return strncmp(s1,"$",1) || strncmp(s1+3,sentenceFormatterMnemonicCode,3) || strncmp(s1+6,",",1);
-}
+static const struct {
+  char formatter[4];
+  char** option;			/* turns the sentence off when NULL */
+  nmea_stype_t type;
+  void (*decode)(const nmea_sentence_t*, nmea_rec_t*);
+} nmea_sentences[] = {
+  { "WPL", NULL, nmea_s_wpl, gpwpl_decode },
+  { "GGA", &opt_gpgga, nmea_s_gga, gpgga_decode },
+  { "RMC", &opt_gprmc, nmea_s_rmc, gprmc_decode },
+  { "GLL", NULL, nmea_s_gll, gpgll_decode },
+  { "ZDA", NULL, nmea_s_zda, gpzda_decode },
+  { "VTG", &opt_gpvtg, nmea_s_vtg, gpvtg_decode },	/* speed and course */
+  { "GSA", &opt_gpgsa, nmea_s_gsa, gpgsa_decode }	/* GPS fix */
+};
 
-void
-nmea_parse_one_line(char* ibuf)
+static void
+nmea_decode_line(const char* ibuf, nmea_rec_t* r)
 {
-  char* ck;
-  int ckval, ckcmp;
-  char* tbuf = lrtrim(ibuf);
-
-  /*
-   * GISTEQ PhotoTracker (stupidly) puts a bogus field in front
-   * of the line.  Look for it and toss it.
-   */
-  if (0 == strncmp(tbuf, "---,", 4)) {
-    tbuf += 4;
+  nmea_sentence_t s;
+  const nmea_field_t* addr;
+  unsigned int i;
+  int dollars;
+
+  memset(r, 0, sizeof(*r));
+  r->check = nmea_split(ibuf, &s, &dollars);
+  if ((r->check == nmea_ck_drop) || dollars) {
+    /* If line has more than one $, there is probably an error in it. */
+    return;
   }
 
-  if (*tbuf != '$') {
+  addr = &s.fld[0];
+  if ((s.nfld < 2) || (addr->len != 5)) {
     return;
   }
 
-  ck = strrchr(tbuf, '*');
-  if (ck != NULL) {
-    *ck = '\0';
-    ckval = nmea_cksum(&tbuf[1]);
-    *ck = '*';
-    ck++;
-    sscanf(ck, "%2X", &ckcmp);
-    if (ckval != ckcmp) {
-#if 0
-      printf("ckval %X, %X, %s\n", ckval, ckcmp, ck);
-      printf("NMEA %s\n", tbuf);
-#endif
+  for (i = 0; i < sizeof(nmea_sentences) / sizeof(nmea_sentences[0]); i++) {
+    if (0 == memcmp(addr->p + 2, nmea_sentences[i].formatter, 3)) {
+      if ((nmea_sentences[i].option == NULL) || *nmea_sentences[i].option) {
+        r->type = nmea_sentences[i].type;
+        nmea_sentences[i].decode(&s, r);
+      }
       return;
     }
+  }
 
-    had_checksum = 1;
-  } else if (had_checksum) {
-    /* we have had a checksum on all previous sentences, but not on this
-    one, which probably indicates this line is truncated */
-    had_checksum = 0;
-    return;
+  /* Proprietary sentences. */
+  if (0 == memcmp(addr->p, "PCMPT", 5)) {
+    r->type = nmea_s_pcmpt;
+    pcmpt_decode(&s, r);
+  } else if ((0 == memcmp(addr->p, "ADPMB", 5)) &&
+             (nmea_int(&s, 1) == 5) && (s.fld[1].len == 1) &&
+             (nmea_char(&s, 2) == '0')) {
+    r->type = nmea_s_adpmb;
   }
+}
 
-  if (strstr(tbuf+1,"$")!=NULL) {
-    /* If line has more than one $, there is probably an error in it. */
+static void
+nmea_apply(const nmea_rec_t* r)
+{
+  switch (r->check) {
+  case nmea_ck_drop:
     return;
+  case nmea_ck_good:
+    had_checksum = 1;
+    break;
+  case nmea_ck_none:
+    if (had_checksum) {
+      /* we have had a checksum on all previous sentences, but not on this
+      one, which probably indicates this line is truncated */
+      had_checksum = 0;
+      return;
+    }
+    break;
   }
 
-  /* @@@ zmarties: The parse routines all assume all fields are present, but
-     the NMEA format allows any field to be missed out if there is no data
-     for that field.  Rather than change all the parse routines, we first
-     substitute a default value of zero for any missing field.
-  */
-  if (strstr(tbuf, ",,")) {
-    tbuf = gstrsub(tbuf, ",,", ",0,");
+  switch (r->type) {
+  case nmea_s_gga:
+    gpgga_apply(r);
+    break;
+  case nmea_s_rmc:
+    gprmc_apply(r);
+    break;
+  case nmea_s_gll:
+    gpgll_apply(r);
+    break;
+  case nmea_s_wpl:
+    gpwpl_apply(r);
+    break;
+  case nmea_s_zda:
+    gpzda_apply(r);
+    break;
+  case nmea_s_vtg:
+    gpvtg_apply(r);
+    break;
+  case nmea_s_gsa:
+    gpgsa_apply(r);
+    break;
+  case nmea_s_pcmpt:
+    pcmpt_apply(r);
+    break;
+  case nmea_s_adpmb:
+    amod_waypoint = 1;
+    break;
   }
+}
 
-  if (0 == notalkerid_strmatch(tbuf, "WPL")) {
-    gpwpl_parse(tbuf);
-  } else if (opt_gpgga && (0 == notalkerid_strmatch(tbuf, "GGA"))) {
-    posn_type = gpgga;
-    gpgga_parse(tbuf);
-  } else if (opt_gprmc && (0 == notalkerid_strmatch(tbuf, "RMC"))) {
-    if (posn_type != gpgga) {
-      posn_type = gprmc;
+void
+nmea_parse_one_line(char* ibuf)
+{
+  nmea_rec_t r;
+
+  nmea_decode_line(ibuf, &r);
+  nmea_apply(&r);
+}
+
+/*
+ * After each line, a fix with a new time goes into the track.
+ */
+static void
+nmea_add_fix(double* lt)
+{
+  if (*lt != last_read_time && curr_waypt && trk_head) {
+    if (curr_waypt != last_waypt) {
+      nmea_add_wpt(curr_waypt, trk_head);
+      last_waypt = curr_waypt;
     }
-    /*
-     * Always call gprmc_parse() because like GPZDA
-     * it contains the full date.
-     */
-    gprmc_parse(tbuf);
-  } else if (0 == notalkerid_strmatch(tbuf, "GLL")) {
-    if ((posn_type != gpgga) && (posn_type != gprmc)) {
-      gpgll_parse(tbuf);
+    *lt = last_read_time;
+  }
+}
+
+/*
+ * Chunked reading of large files.  The input is cut at line ends into
+ * chunks that are split and decoded on a thread pool.  The decoded
+ * sentences of each chunk are then applied in file order, which carries
+ * the date, the GGA/RMC/GLL precedence and the checksum state across
+ * chunk boundaries, so the track comes out as if read line by line.
+ */
+#define NMEA_CHUNK_SIZE (1024 * 1024)
+
+class NmeaChunkJob : public QRunnable
+{
+public:
+  NmeaChunkJob(const QByteArray& t) : text(t), eof(false), done(false)
+  {
+    setAutoDelete(false);
+  }
+  void run();
+
+  QByteArray text;
+  QVector<nmea_rec_t> recs;
+  bool eof;			/* a ^Z at the start of a line ends the input */
+  bool done;
+};
+
+static QMutex nmea_chunk_lock;
+static QWaitCondition nmea_chunk_finished;
+
+/*
+ * Lines end at CR, LF or CR/LF, as with gbfgetstr().  Lines that can't
+ * be sentences are not recorded; they wouldn't change any state.
+ */
+void
+NmeaChunkJob::run()
+{
+  char* p = text.data();
+  char* end = p + text.size();
+  QVector<nmea_rec_t> out;
+  nmea_rec_t r;
+
+  while (p < end) {
+    char* line = p;
+
+    if (*p == 0x1A) {
+      eof = true;
+      break;
     }
-  } else if (0 == notalkerid_strmatch(tbuf, "ZDA")) {
-    gpzda_parse(tbuf);
-  } else if (0 == strncmp(tbuf, "$PCMPT,", 7)) {
-    pcmpt_parse(tbuf);
-  } else if (opt_gpvtg && (0 == notalkerid_strmatch(tbuf, "VTG"))) {
-    gpvtg_parse(tbuf); /* speed and course */
-  } else if (opt_gpgsa && (0 == notalkerid_strmatch(tbuf, "GSA"))) {
-    gpgsa_parse(tbuf); /* GPS fix */
-  } else if (0 == strncmp(tbuf, "$ADPMB,5,0", 10)) {
-    amod_waypoint = 1;
+    while ((p < end) && (*p != '\r') && (*p != '\n') && (*p != 0x1A)) {
+      p++;
+    }
+    if (p < end) {
+      if ((*p == '\r') && (p + 1 < end) && (p[1] == '\n')) {
+        *p++ = '\0';
+      }
+      *p++ = '\0';
+    }
+    /* The last line is terminated by the NUL QByteArray keeps past the data. */
+
+    nmea_decode_line(line, &r);
+    if (r.check != nmea_ck_drop) {
+      out.append(r);
+    }
+  }
+
+  QMutexLocker locker(&nmea_chunk_lock);
+  recs = out;
+  done = true;
+  nmea_chunk_finished.wakeAll();
+}
+
+/*
+ * Apply finished chunks from the head of the queue.  Blocks only while
+ * more than keep jobs are queued, or until the queue is empty when all
+ * is set.  Returns 0 once the end of the input was seen.
+ */
+static int
+nmea_drain_chunks(QQueue<NmeaChunkJob*>* jobs, double* lt, int all, int keep)
+{
+  int more = 1;
+
+  while (!jobs->isEmpty()) {
+    NmeaChunkJob* job = jobs->head();
+    {
+      QMutexLocker locker(&nmea_chunk_lock);
+      if (!job->done && !all && (jobs->size() <= keep)) {
+        break;
+      }
+      while (!job->done) {
+        nmea_chunk_finished.wait(&nmea_chunk_lock);
+      }
+    }
+    jobs->dequeue();
+    if (more) {
+      for (int i = 0; i < job->recs.size(); i++) {
+        nmea_apply(&job->recs.at(i));
+        nmea_add_fix(lt);
+      }
+      more = !job->eof;
+    }
+    delete job;
   }
+  return more;
+}
 
-  if (tbuf != ibuf) {
-    /* clear up the dynamic buffer we used because substition was required */
-    xfree(tbuf);
+static void
+nmea_read_chunks(int threads, double* lt)
+{
+  QThreadPool pool;
+  QQueue<NmeaChunkJob*> jobs;
+  QByteArray carry;
+  int more = 1;
+
+  pool.setMaxThreadCount(threads);
+
+  while (more) {
+    QByteArray chunk = carry;
+    int n, cut;
+
+    chunk.resize(carry.size() + NMEA_CHUNK_SIZE);
+    n = gbfread(chunk.data() + carry.size(), 1, NMEA_CHUNK_SIZE, file_in);
+    chunk.resize(carry.size() + n);
+    if (chunk.isEmpty()) {
+      break;
+    }
+
+    /* Cut after the last line end; the rest goes into the next chunk. */
+    if (n == 0) {
+      cut = chunk.size();
+      more = 0;
+    } else {
+      for (cut = chunk.size(); cut > 0; cut--) {
+        if ((chunk[cut - 1] == '\n') || (chunk[cut - 1] == '\r')) {
+          break;
+        }
+      }
+      if (cut == 0) {
+        /* No line end in sight yet, read on. */
+        carry = chunk;
+        continue;
+      }
+    }
+    carry = chunk.mid(cut);
+    chunk.truncate(cut);
+
+    NmeaChunkJob* job = new NmeaChunkJob(chunk);
+    chunk.clear();	/* so the job's copy isn't shared */
+    jobs.enqueue(job);
+    pool.start(job);
+    /* Bound the memory held by chunks in flight. */
+    if (!nmea_drain_chunks(&jobs, lt, 0, 2 * threads)) {
+      break;
+    }
   }
+  nmea_drain_chunks(&jobs, lt, 1, 0);
 }
 
 static void
@@ -1017,6 +1521,7 @@ nmea_read(void)
   char* ck;
   double lt = -1;
   int line = -1;
+  int threads;
 
   posn_type = gp_unknown;
   trk_head = NULL;
@@ -1042,6 +1547,14 @@ nmea_read(void)
 
   curr_waypt = NULL;
 
+  threads = global_opts.threads;
+  if (opt_threads) {
+    threads = atoi(opt_threads);
+    if (threads <= 0) {
+      threads = route_threads();
+    }
+  }
+
   while ((ibuf = gbfgetstr(file_in))) {
     char* sdatum, *cx;
 
@@ -1075,16 +1588,15 @@ nmea_read(void)
           fatal(MYNAME "/SonyGPS: Unsupported datum \"%s\" in source data!\n", sdatum);
         }
       }
-      continue;
+    } else {
+      nmea_parse_one_line(ibuf);
+      nmea_add_fix(&lt);
     }
 
-    nmea_parse_one_line(ibuf);
-    if (lt != last_read_time && curr_waypt && trk_head) {
-      if (curr_waypt != last_waypt) {
-        nmea_add_wpt(curr_waypt, trk_head);
-        last_waypt = curr_waypt;
-      }
-      lt = last_read_time;
+    if ((line == 0) && (threads > 1) && !file_in->unicode) {
+      /* The first line settled the encoding; chunk the rest. */
+      nmea_read_chunks(threads, &lt);
+      break;
     }
   }
 
@@ -1335,9 +1847,9 @@ nmea_trackpt_pr(const Waypoint* wpt)
              fabs(lon), lon < 0 ? 'W' : 'E',
              fix,
              (wpt->sat>0)?(wpt->sat):(0),
-             (wpt->hdop>0)?(wpt->hdop):(0.0),
+             (wpt->ext->hdop>0)?(wpt->ext->hdop):(0.0),
              wpt->altitude == unknown_alt ? 0 : wpt->altitude,
-             WAYPT_HAS(wpt, geoidheight)? (wpt->geoidheight) : (0)); /* TODO: we could look up the geoidheight if needed */
+             WAYPT_HAS(wpt, geoidheight)? (wpt->ext->geoidheight) : (0)); /* TODO: we could look up the geoidheight if needed */
     cksum = nmea_cksum(obuf);
     gbfprintf(file_out, "$%s*%02X\n", obuf, cksum);
   }
@@ -1367,9 +1879,9 @@ nmea_trackpt_pr(const Waypoint* wpt)
     }
     snprintf(obuf,sizeof(obuf),"GPGSA,A,%c,,,,,,,,,,,,,%.1f,%.1f,%.1f",
              fix,
-             (wpt->pdop>0)?(wpt->pdop):(0),
-             (wpt->hdop>0)?(wpt->hdop):(0),
-             (wpt->vdop>0)?(wpt->vdop):(0));
+             (wpt->ext->pdop>0)?(wpt->ext->pdop):(0),
+             (wpt->ext->hdop>0)?(wpt->ext->hdop):(0),
+             (wpt->ext->vdop>0)?(wpt->ext->vdop):(0));
     cksum = nmea_cksum(obuf);
     gbfprintf(file_out, "$%s*%02X\n", obuf, cksum);
   }
@@ -44,6 +44,7 @@ static QHash<QString, const struct osm_icon_mapping_s*> icons;
 
 static gbfile* fout;
 static int node_id;
+static QHash<const Waypoint*, int> node_ids;
 static int skip_rte;
 
 static route_head* rte;
@@ -515,8 +516,7 @@ osm_node(xg_string args, const QXmlStreamAttributes* attrv)
   }
 
   if (attrv->hasAttribute("timestamp")) {
-    QString ts = attrv->value("timestamp").toString();
-    wpt->creation_time = xml_parse_time(ts);
+    wpt->creation_time = xml_parse_time(attrv->value("timestamp"));
   }
 }
 
@@ -544,20 +544,20 @@ osm_node_tag(xg_string args, const QXmlStreamAttributes* attrv)
   } else if (key == QLatin1String("name:en")) {
     wpt->shortname = str;
   } else if ((ikey = osm_feature_ikey(key)) >= 0) {
-    wpt->icon_descr = osm_feature_symbol(ikey, CSTR(value));
+    wpt->AllocExt()->icon_descr = osm_feature_symbol(ikey, CSTR(value));
   } else if (key == QLatin1String("note")) {
-    if (wpt->notes.isEmpty()) {
-      wpt->notes = str;
+    if (wpt->ext->notes.isEmpty()) {
+      wpt->AllocExt()->notes = str;
     } else {
-      wpt->notes += "; ";
-      wpt->notes += str;
+      wpt->AllocExt()->notes += "; ";
+      wpt->AllocExt()->notes += str;
     }
   } else if (key == QLatin1String("gps:hdop")) {
-    wpt->hdop = str.toDouble();
+    wpt->AllocExt()->hdop = str.toDouble();
   } else if (key == QLatin1String("gps:vdop")) {
-    wpt->vdop = str.toDouble();
+    wpt->AllocExt()->vdop = str.toDouble();
   } else if (key == QLatin1String("gps:pdop")) {
-    wpt->pdop = str.toDouble();
+    wpt->AllocExt()->pdop = str.toDouble();
   } else if (key == QLatin1String("gps:sat")) {
     wpt->sat = str.toDouble();
   } else if (key == QLatin1String("gps:fix")) {
@@ -632,13 +632,13 @@ osm_way_tag(xg_string args, const QXmlStreamAttributes* attrv)
     wpt->shortname = str;
    // The remaining cases only apply to the center node
   } else if ((ikey = osm_feature_ikey(key)) >= 0) {
-    wpt->icon_descr = osm_feature_symbol(ikey, CSTR(value));
+    wpt->AllocExt()->icon_descr = osm_feature_symbol(ikey, CSTR(value));
   } else if (key == "note") {
-    if (wpt->notes.isEmpty()) {
-      wpt->notes = str;
+    if (wpt->ext->notes.isEmpty()) {
+      wpt->AllocExt()->notes = str;
     } else {
-      wpt->notes += "; ";
-      wpt->notes += str;
+      wpt->AllocExt()->notes += "; ";
+      wpt->AllocExt()->notes += str;
     }
   }
 }
@@ -735,8 +735,8 @@ osm_disp_feature(const Waypoint* wpt)
 {
   const osm_icon_mapping_t* map;
 
-  if (icons.contains(wpt->icon_descr)) {
-    map = icons.value(wpt->icon_descr);
+  if (icons.contains(wpt->ext->icon_descr)) {
+    map = icons.value(wpt->ext->icon_descr);
     osm_write_tag(osm_features[map->key], map->value);
   }
 }
@@ -770,16 +770,6 @@ osm_write_opt_tag(const char* atag)
   xfree(tag);
 }
 
-static void
-osm_release_ids(const Waypoint* wpt)
-{
-  if (wpt && wpt->extra_data) {
-    Waypoint* tmp = (Waypoint*)wpt;
-    xfree(tmp->extra_data);
-    tmp->extra_data = NULL;
-  }
-}
-
 static QString
 osm_name_from_wpt(const Waypoint* wpt)
 {
@@ -801,27 +791,24 @@ osm_waypt_disp(const Waypoint* wpt)
 
   waypoints.insert(name, wpt);
 
-  int* id;
-
-  id = (int*) xmalloc(sizeof(*id));
-  *id = --node_id;
-  ((Waypoint*)(wpt))->extra_data = id;
+  int id = --node_id;
+  node_ids.insert(wpt, id);
 
-  gbfprintf(fout, "  <node id='%d' visible='true' lat='%0.7f' lon='%0.7f'", *id, wpt->latitude, wpt->longitude);
+  gbfprintf(fout, "  <node id='%d' visible='true' lat='%0.7f' lon='%0.7f'", id, wpt->latitude, wpt->longitude);
   if (wpt->creation_time.isValid()) {
     QString time_string = wpt->CreationTimeXML();
     gbfprintf(fout, " timestamp='%s'", qPrintable(time_string));
   }
   gbfprintf(fout, ">\n");
 
-  if (wpt->hdop) {
-    gbfprintf(fout, "    <tag k='gps:hdop' v='%f' />\n", wpt->hdop);
+  if (wpt->ext->hdop) {
+    gbfprintf(fout, "    <tag k='gps:hdop' v='%f' />\n", wpt->ext->hdop);
   }
-  if (wpt->vdop) {
-    gbfprintf(fout, "    <tag k='gps:vdop' v='%f' />\n", wpt->vdop);
+  if (wpt->ext->vdop) {
+    gbfprintf(fout, "    <tag k='gps:vdop' v='%f' />\n", wpt->ext->vdop);
   }
-  if (wpt->pdop) {
-    gbfprintf(fout, "    <tag k='gps:pdop' v='%f' />\n", wpt->pdop);
+  if (wpt->ext->pdop) {
+    gbfprintf(fout, "    <tag k='gps:pdop' v='%f' />\n", wpt->ext->pdop);
   }
   if (wpt->sat > 0) {
     gbfprintf(fout, "    <tag k='gps:sat' v='%d' />\n", wpt->sat);
@@ -858,8 +845,8 @@ osm_waypt_disp(const Waypoint* wpt)
   }
 
   osm_write_tag("name", wpt->shortname);
-  osm_write_tag("note", (wpt->notes.isEmpty()) ? wpt->description : wpt->notes);
-  if (!wpt->icon_descr.isNull()) {
+  osm_write_tag("note", (wpt->ext->notes.isEmpty()) ? wpt->description : wpt->ext->notes);
+  if (!wpt->ext->icon_descr.isNull()) {
     osm_disp_feature(wpt);
   }
 
@@ -892,8 +879,7 @@ osm_rtept_disp(const Waypoint* wpt_ref)
 
   if (waypoints.contains(name)) {
     wpt = waypoints.value(name);
-    int* id = (int*) wpt->extra_data;
-    gbfprintf(fout, "    <nd ref='%d'/>\n", *id);
+    gbfprintf(fout, "    <nd ref='%d'/>\n", node_ids.value(wpt));
   }
 }
 
@@ -932,6 +918,7 @@ osm_wr_init(const char* fname)
 
   osm_init_icons();
   waypoints.clear();
+  node_ids.clear();
   node_id = 0;
 }
 
@@ -960,11 +947,8 @@ osm_wr_deinit(void)
 {
   gbfclose(fout);
 
-  waypt_disp_all(osm_release_ids);
-  route_disp_all(NULL, NULL, osm_release_ids);
-  track_disp_all(NULL, NULL, osm_release_ids);
-
   waypoints.clear();
+  node_ids.clear();
 }
 
 static void
@@ -522,7 +522,7 @@ ozi_parse_waypt(int field, const QString& str, Waypoint* wpt_tmp, ozi_fsdata* fs
        other types, but it at least maintains fidelity for an ozi->ozi
        operation. */
     if (str.toInt() > 0) {
-      wpt_tmp->icon_descr = str;
+      wpt_tmp->AllocExt()->icon_descr = str;
     }
     break;
   case 6:
@@ -839,7 +839,7 @@ data_read(void)
       case unknown_gpsdata:
         if (linecount > 4) {  /* skipping over file header */
           ozi_fsdata_used = true;
-          fs_chain_add(&(wpt_tmp->fs),
+          fs_chain_add(&(wpt_tmp->AllocExt()->fs),
                        (format_specific_data*) fsdata);
           ozi_convert_datum(wpt_tmp);
           waypt_add(wpt_tmp);
@@ -875,7 +875,7 @@ ozi_waypt_pr(const Waypoint* wpt)
   ozi_fsdata* fs = NULL;
   int icon = 0;
 
-  fs = (ozi_fsdata*) fs_chain_find(wpt->fs, FS_OZI);
+  fs = (ozi_fsdata*) fs_chain_find(wpt->ext->fs, FS_OZI);
 
   if (!fs) {
     fs = ozi_alloc_fsdata();
@@ -915,16 +915,16 @@ ozi_waypt_pr(const Waypoint* wpt)
 
   index++;
 
-  if (wpt->icon_descr.toInt()) {
-    icon = wpt->icon_descr.toInt();
+  if (wpt->ext->icon_descr.toInt()) {
+    icon = wpt->ext->icon_descr.toInt();
   }
 
   gbfprintf(file_out,
             "%d,%s,%.6f,%.6f,%s,%d,%d,%d,%d,%d,%s,%d,%d,",
             index, CSTRc(shortname), wpt->latitude, wpt->longitude, ozi_time, icon,
             1, 3, fs->fgcolor, fs->bgcolor, CSTRc(description), 0, 0);
-  if (WAYPT_HAS(wpt, proximity) && (wpt->proximity > 0)) {
-    gbfprintf(file_out, "%.1f,", wpt->proximity * prox_scale);
+  if (WAYPT_HAS(wpt, proximity) && (wpt->ext->proximity > 0)) {
+    gbfprintf(file_out, "%.1f,", wpt->ext->proximity * prox_scale);
   } else if (proximity > 0) {
     gbfprintf(file_out,"%.1f,", proximity * prox_scale);
   } else {
@@ -163,7 +163,7 @@ data_read(void)
       if (*cp != '\0') {
         wpt_tmp->description = cp;
       }
-      wpt_tmp->icon_descr = gt_find_desc_from_icon_number(symnum, PCX);
+      wpt_tmp->AllocExt()->icon_descr = gt_find_desc_from_icon_number(symnum, PCX);
 
       if (read_as_degrees || read_gpsu) {
         human_to_dec(tbuf, &lat, &lon, 1);
@@ -335,7 +335,7 @@ gpsutil_disp(const Waypoint* wpt)
   if (deficon) {
     icon_token = atoi(deficon);
   } else {
-    icon_token = gt_find_icon_number_from_desc(wpt->icon_descr, PCX);
+    icon_token = gt_find_icon_number_from_desc(wpt->ext->icon_descr, PCX);
     if (get_cache_icon(wpt)) {
       icon_token = gt_find_icon_number_from_desc(get_cache_icon(wpt), PCX);
     }
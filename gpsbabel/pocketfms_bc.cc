@@ -109,9 +109,9 @@ read_tracks(void)
     wpt->longitude = le_read_float(&bc.longitude);
     wpt->altitude = FEET_TO_METERS(le_read_float(&bc.altitude));
     wpt->SetCreationTime(mkgmtime(&tm));
-    wpt->hdop = le_read_float(&bc.ehpe);
-    wpt->vdop = le_read_float(&bc.evpe);
-    wpt->pdop = le_read_float(&bc.espe);
+    wpt->AllocExt()->hdop = le_read_float(&bc.ehpe);
+    wpt->AllocExt()->vdop = le_read_float(&bc.evpe);
+    wpt->AllocExt()->pdop = le_read_float(&bc.espe);
     wpt->course = le_read_float(&bc.course);
     wpt->speed = le_read_float(&bc.speed);
     wpt->fix = (fix_type)(le_readu16(&bc.fix) - 1);
@@ -152,9 +152,9 @@ pocketfms_waypt_disp(const Waypoint* wpt)
     le_write16(&bc.minute, tm->tm_min);
     le_write16(&bc.second, tm->tm_sec);
   }
-  le_write_float(&bc.ehpe, wpt->hdop);
-  le_write_float(&bc.evpe, wpt->vdop);
-  le_write_float(&bc.espe, wpt->pdop);
+  le_write_float(&bc.ehpe, wpt->ext->hdop);
+  le_write_float(&bc.evpe, wpt->ext->vdop);
+  le_write_float(&bc.espe, wpt->ext->pdop);
   le_write_float(&bc.course, wpt->course);
   le_write_float(&bc.speed, wpt->speed);
   le_write16(&bc.fix, wpt->fix+1);
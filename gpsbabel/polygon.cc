@@ -275,13 +275,13 @@ polygon_process(void)
       QUEUE_FOR_EACH(&waypt_head, elem, tmp) {
         waypointp = (Waypoint*)elem;
 #endif
-        if (waypointp->extra_data) {
-          ed = (extra_data*) waypointp->extra_data;
+        if (waypointp->ext->extra_data) {
+          ed = (extra_data*) waypointp->ext->extra_data;
         } else {
           ed = (extra_data*) xcalloc(1, sizeof(*ed));
           ed->state = OUTSIDE;
           ed->override = 0;
-          waypointp->extra_data = (extra_data*) ed;
+          waypointp->AllocExt()->extra_data = (extra_data*) ed;
         }
         if (lat2 == waypointp->latitude &&
             lon2 == waypointp->longitude) {
@@ -324,8 +324,8 @@ polygon_process(void)
   QUEUE_FOR_EACH(&waypt_head, elem, tmp) {
     Waypoint* wp = (Waypoint*) elem;
 #endif
-    ed = (extra_data*) wp->extra_data;
-    wp->extra_data = NULL;
+    ed = (extra_data*) wp->ext->extra_data;
+    wp->AllocExt()->extra_data = NULL;
     if (ed) {
       if (ed->override) {
         ed->state = INSIDE;
@@ -326,7 +326,7 @@ psit_waypoint_r(gbfile* psit_file, Waypoint** wpt)
     /* since PsiTrex only deals with Garmins, let's use the "proper" Garmin icon name */
     /* convert the PsiTrex name to the number, which is the PCX one; from there to Garmin desc */
     garmin_icon_num = psit_find_icon_number_from_desc(psit_current_token);
-    thisWaypoint->icon_descr = gt_find_desc_from_icon_number(garmin_icon_num, PCX);
+    thisWaypoint->AllocExt()->icon_descr = gt_find_desc_from_icon_number(garmin_icon_num, PCX);
 
     waypt_add(thisWaypoint);
 
@@ -362,9 +362,9 @@ psit_waypoint_w(gbfile* psit_file, const Waypoint* wpt)
   gbfprintf(psit_file, " %-6s, ", ident);
   xfree(ident);
 
-  icon = gt_find_icon_number_from_desc(wpt->icon_descr, PCX);
+  icon = gt_find_icon_number_from_desc(wpt->ext->icon_descr, PCX);
 
-  if (get_cache_icon(wpt) && wpt->icon_descr.compare("Geocache Found") != 0) {
+  if (get_cache_icon(wpt) && wpt->ext->icon_descr.compare("Geocache Found") != 0) {
     icon = gt_find_icon_number_from_desc(get_cache_icon(wpt), PCX);
   }
 
@@ -448,7 +448,7 @@ psit_route_r(gbfile* psit_file, route_head** rte)
       /* since PsiTrex only deals with Garmins, let's use the "proper" Garmin icon name */
       /* convert the PsiTrex name to the number, which is the PCX one; from there to Garmin desc */
       garmin_icon_num = psit_find_icon_number_from_desc(psit_current_token);
-      thisWaypoint->icon_descr = gt_find_desc_from_icon_number(garmin_icon_num, PCX);
+      thisWaypoint->AllocExt()->icon_descr = gt_find_desc_from_icon_number(garmin_icon_num, PCX);
 
       route_add_wpt(rte_head, thisWaypoint);
 
@@ -93,8 +93,8 @@ dist_comp(const void* a, const void* b)
 {
   const Waypoint* x1 = *(Waypoint**)a;
   const Waypoint* x2 = *(Waypoint**)b;
-  extra_data* x1e = (extra_data*) x1->extra_data;
-  extra_data* x2e = (extra_data*) x2->extra_data;
+  extra_data* x1e = (extra_data*) x1->ext->extra_data;
+  extra_data* x2e = (extra_data*) x2->ext->extra_data;
 
   if (x1e->distance > x2e->distance) {
     return 1;
@@ -139,7 +139,7 @@ radius_process(void)
 
     extra_data* ed = (extra_data*) xcalloc(1, sizeof(*ed));
     ed->distance = dist;
-    waypointp->extra_data = ed;
+    waypointp->AllocExt()->extra_data = ed;
   }
 
   wc = waypt_count();
@@ -184,8 +184,8 @@ radius_process(void)
   for (i = 0; i < wc; i++) {
     Waypoint* wp = comp[i];
 
-    xfree(wp->extra_data);
-    wp->extra_data = NULL;
+    xfree(wp->ext->extra_data);
+    wp->AllocExt()->extra_data = NULL;
 
     if (maxctarg && i >= maxct) {
       continue;
@@ -147,7 +147,7 @@ random_read(void)
 
     wpt = new Waypoint;
     gmsd = garmin_fs_alloc(-1);
-    fs_chain_add(&wpt->fs, (format_specific_data*) gmsd);
+    fs_chain_add(&wpt->AllocExt()->fs, (format_specific_data*) gmsd);
 
     do {
       wpt->shortname = rand_qstr(8, "Wpt_%s");
@@ -177,7 +177,7 @@ random_read(void)
       }
     }
     if RND(3) {
-      wpt->icon_descr = rand_qstr(3, "Icon_%s");
+      wpt->AllocExt()->icon_descr = rand_qstr(3, "Icon_%s");
     }
 
     wpt->SetCreationTime(time);
@@ -194,15 +194,15 @@ random_read(void)
         WAYPT_SET(wpt, speed, waypt_speed(prev, wpt));
       }
       wpt->sat = rand_int(12 + 1);
-      wpt->hdop = (rand_int(500)) / 10.0;
-      wpt->vdop = (rand_int(500)) / 10.0;
-      wpt->pdop = (rand_int(500)) / 10.0;
+      wpt->AllocExt()->hdop = (rand_int(500)) / 10.0;
+      wpt->AllocExt()->vdop = (rand_int(500)) / 10.0;
+      wpt->AllocExt()->pdop = (rand_int(500)) / 10.0;
       wpt->fix = (fix_type)(rand_int(6) - 1);
       if RND(3) {
-        wpt->cadence = rand_int(255);
+        wpt->AllocExt()->cadence = rand_int(255);
       }
       if RND(3) {
-        wpt->heartrate = rand_int(255);
+        wpt->AllocExt()->heartrate = rand_int(255);
       }
     } else {
       if (doing_rtes && (i > 0)) {
@@ -213,7 +213,7 @@ random_read(void)
         wpt->description = rand_qstr(16, "Des_%s");
       }
       if RND(3) {
-        wpt->notes = rand_qstr(16, "Nts_%s");
+        wpt->AllocExt()->notes = rand_qstr(16, "Nts_%s");
       }
       if RND(3) {
         GMSD_SET(addr, rand_str(8, "Adr_%s"));
@@ -215,7 +215,7 @@ raymarine_read(void)
 
     /* try to read optional values */
     if (((str = inifile_readstr(fin, sect, "Notes"))) && *str) {
-      wpt->notes = str;
+      wpt->AllocExt()->notes = str;
     }
     if (((str = inifile_readstr(fin, sect, "Time"))) && *str) {
       wpt->SetCreationTime(EXCEL_TO_TIMET(atof(str)));
@@ -226,7 +226,7 @@ raymarine_read(void)
       if ((symbol < 3) && (symbol >= RAYMARINE_SYMBOL_CT)) {
         symbol = RAYMARINE_STD_SYMBOL;
       }
-      wpt->icon_descr = raymarine_symbols[symbol].name;
+      wpt->AllocExt()->icon_descr = raymarine_symbols[symbol].name;
     }
   }
 
@@ -293,7 +293,7 @@ register_waypt(const Waypoint* ref, const char is_rtept)
     Waypoint* cmp = waypt_table[i];
 
     if (same_points(wpt, cmp)) {
-      wpt->extra_data = cmp->extra_data;
+      wpt->AllocExt()->extra_data = cmp->ext->extra_data;
       return;
     }
   }
@@ -307,7 +307,7 @@ register_waypt(const Waypoint* ref, const char is_rtept)
     }
   }
 
-  wpt->extra_data = (void*)mkshort(hshort_wpt, CSTRc(wpt->shortname));
+  wpt->AllocExt()->extra_data = (void*)mkshort(hshort_wpt, CSTRc(wpt->shortname));
 
   waypt_table[waypt_table_ct] = (Waypoint*)wpt;
   waypt_table_ct++;
@@ -340,7 +340,7 @@ write_waypoint(gbfile* fout, const Waypoint* wpt, const int waypt_no, const char
   char* name;
   double time;
 
-  notes = wpt->notes;
+  notes = wpt->ext->notes;
   if (notes == NULL) {
     notes = wpt->description;
     if (notes == NULL) {
@@ -349,7 +349,7 @@ write_waypoint(gbfile* fout, const Waypoint* wpt, const int waypt_no, const char
   }
   notes = csv_stringclean(notes, LINE_FEED);
   time = wpt->creation_time.isValid() ? TIMET_TO_EXCEL(wpt->GetCreationTime().toTime_t()) : TIMET_TO_EXCEL(gpsbabel_time);
-  name = (char*)wpt->extra_data;
+  name = (char*)wpt->ext->extra_data;
 
   gbfprintf(fout, "[Wp%d]" LINE_FEED
             "Loc=%s" LINE_FEED
@@ -365,7 +365,7 @@ write_waypoint(gbfile* fout, const Waypoint* wpt, const int waypt_no, const char
             "Locked=0" LINE_FEED
             "Notes=%s" LINE_FEED,
             0.0, 0.0,
-            find_symbol_num(wpt->icon_descr),
+            find_symbol_num(wpt->ext->icon_descr),
             CSTR(notes)
            );
   gbfprintf(fout, "Rel=" LINE_FEED
@@ -417,7 +417,7 @@ write_route_wpt_cb(const Waypoint* wpt)
     "PredictedTws"
   };
 
-  gbfprintf(fout, "Mk%d=%s" LINE_FEED, rte_wpt_index, (char*)wpt->extra_data);
+  gbfprintf(fout, "Mk%d=%s" LINE_FEED, rte_wpt_index, (char*)wpt->ext->extra_data);
   for (unsigned i = 0; i < sizeof(items) / sizeof(char*); i++) {
     gbfprintf(fout, "%s%d=%.15f" LINE_FEED, items[i], rte_wpt_index, 0.0);
   }
@@ -501,8 +501,8 @@ raymarine_write(void)
   /* release local used data */
   for (i = 0; i < waypt_table_ct; i++) {
     wpt = waypt_table[i];
-    xfree(wpt->extra_data);
-    wpt->extra_data = NULL;
+    xfree(wpt->ext->extra_data);
+    wpt->AllocExt()->extra_data = NULL;
   }
   xfree(waypt_table);
 }
@@ -18,9 +18,19 @@
  */
 
 #include <stdio.h>
+#include <algorithm>
+#include <limits>
+#include <utility>
 #include "defs.h"
 #include "grtcirc.h"
 #include "session.h"
+#include <QtCore/QMutex>
+#include <QtCore/QQueue>
+#include <QtCore/QRunnable>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+#include <QtCore/QWaitCondition>
 
 static queue my_route_head;
 static queue my_track_head;
@@ -29,7 +39,77 @@ static int rte_waypts;
 static int trk_head_ct;
 static int trk_waypts;
 
-extern void update_common_traits(const Waypoint* wpt);
+extern void update_common_traits(const Waypoint* wpt, gpsdata_type type);
+
+/*
+ * While route_parallel() has work running on other threads, the counts
+ * and traits shared by all routes are only touched under route_lock.
+ */
+static QMutex route_lock;
+static int route_locking;
+
+class RouteLocker
+{
+public:
+  RouteLocker() : locked(route_locking) {
+    if (locked) {
+      route_lock.lock();
+    }
+  }
+  ~RouteLocker() {
+    if (locked) {
+      route_lock.unlock();
+    }
+  }
+
+private:
+  int locked;
+};
+
+/*
+ * Memoized per-route results.  Each part is valid while its generation
+ * matches cache_generation.  Appends extend the bounds in place and are
+ * folded into the track stats by the next track_recompute(); the time
+ * index is rebuilt.  Anything else that reshapes the route sets the
+ * generations back to 0.
+ */
+struct route_cache {
+  bounds bds;
+  unsigned int bds_gen;
+
+  computed_trkdata stats;
+  unsigned int stats_gen;
+  const Waypoint* stats_last;	/* last point folded into stats */
+  int stats_ct;
+  int pts_hrt;
+  double tot_hrt;
+  int pts_cad;
+  double tot_cad;
+
+  time_index* times;
+  unsigned int times_gen;
+};
+
+static route_cache*
+route_get_cache(const route_head* rte)
+{
+  /* Cast away const-ness; the cache is not part of the route's value. */
+  route_head* rh = (route_head*) rte;
+  if (!rh->cache) {
+    rh->cache = (route_cache*) xcalloc(1, sizeof(route_cache));
+  }
+  return rh->cache;
+}
+
+static void
+route_cache_reset(const route_head* rte)
+{
+  if (rte->cache) {
+    rte->cache->bds_gen = 0;
+    rte->cache->stats_gen = 0;
+    rte->cache->times_gen = 0;
+  }
+}
 
 void
 route_init(void)
@@ -87,6 +167,10 @@ any_route_add_head(route_head* rte, queue* head)
 static void
 any_route_del_head(route_head* rte)
 {
+  if (rte->rte_waypt_ct) {
+    RouteLocker locker;
+    traits_invalidate();
+  }
   dequeue(&rte->Q);
   any_route_free(rte);
 }
@@ -101,7 +185,10 @@ route_add_head(route_head* rte)
 void
 route_del_head(route_head* rte)
 {
-  rte_waypts -= rte->rte_waypt_ct;
+  {
+    RouteLocker locker;
+    rte_waypts -= rte->rte_waypt_ct;
+  }
   any_route_del_head(rte);
   rte_head_ct--;
 }
@@ -116,7 +203,10 @@ track_add_head(route_head* rte)
 void
 track_del_head(route_head* rte)
 {
-  trk_waypts -= rte->rte_waypt_ct;
+  {
+    RouteLocker locker;
+    trk_waypts -= rte->rte_waypt_ct;
+  }
   any_route_del_head(rte);
   trk_head_ct--;
 }
@@ -162,6 +252,13 @@ any_route_add_wpt(route_head* rte, Waypoint* wpt, int* ct, int synth, const QStr
 {
   ENQUEUE_TAIL(&rte->waypoint_list, &wpt->Q);
   rte->rte_waypt_ct++;	/* waypoints in this route */
+  if (rte->cache) {
+    if (rte->cache->bds_gen == cache_generation) {
+      waypt_add_to_bounds(&rte->cache->bds, wpt);
+    }
+    rte->cache->times_gen = 0;
+  }
+  RouteLocker locker;
   if (ct) {
     (*ct)++;
   }
@@ -169,7 +266,9 @@ any_route_add_wpt(route_head* rte, Waypoint* wpt, int* ct, int synth, const QStr
     wpt->shortname = QString().sprintf("%s%0*d", CSTRc(namepart), number_digits, *ct);
     wpt->wpt_flags.shortname_is_synthetic = 1;
   }
-  update_common_traits(wpt);
+  /* route_backup() copies pass no count; they aren't on either list */
+  update_common_traits(wpt, (ct == &trk_waypts) ? trkdata :
+                       (ct == &rte_waypts) ? rtedata : unknown_gpsdata);
 }
 
 void
@@ -236,9 +335,13 @@ any_route_del_wpt(route_head* rte, Waypoint* wpt, int* ct)
   wpt->wpt_flags.new_trkseg = 0;
   dequeue(&wpt->Q);
   rte->rte_waypt_ct--;
+  route_cache_reset(rte);
+
+  RouteLocker locker;
   if (ct) {
     (*ct)--;
   }
+  traits_invalidate();
 }
 
 void
@@ -277,6 +380,7 @@ route_reverse(const route_head* rte_hd)
   QUEUE_FOR_EACH(&rh->waypoint_list, elem, tmp) {
     ENQUEUE_HEAD(&rh->waypoint_list, dequeue(elem));
   }
+  route_cache_reset(rh);
 }
 
 static void
@@ -339,6 +443,159 @@ track_disp_session(const session_t* se, route_hdr rh, route_trl rt, waypt_cb wc)
   common_disp_session(se, &my_track_head, rh, rt, wc);
 }
 
+/*
+ * Run work() on each of n routes on a pool of threads, and finish() on
+ * each of them on this thread, in order.  Consecutive routes are handed
+ * out in chunks of about RTE_PAR_CHUNK points so that short tracks don't
+ * cost a job each; idle threads take the next chunk from the pool's
+ * queue.  finish() for a chunk runs as soon as it and all chunks before
+ * it are done, while later chunks are still being worked on.
+ *
+ * work() may change and delete the points of the route it was given,
+ * but nothing else that isn't its own.  Lists, new routes and anything
+ * that has to happen in order belong in finish().
+ */
+#define RTE_PAR_CHUNK 8192
+
+typedef struct route_par_s {
+  QMutex lock;
+  QWaitCondition finished;
+} route_par_t;
+
+class RouteJob : public QRunnable
+{
+public:
+  RouteJob(route_par_t* p, route_head* const* r, int f, int c, route_work w) :
+    par(p), rtes(r), first(f), count(c), work(w), done(false)
+  {
+    setAutoDelete(false);
+  }
+  void run();
+
+  route_par_t* par;
+  route_head* const* rtes;
+  int first;
+  int count;
+  route_work work;
+  bool done;
+};
+
+void
+RouteJob::run()
+{
+  for (int i = first; i < first + count; i++) {
+    work(rtes[i], i);
+  }
+
+  QMutexLocker locker(&par->lock);
+  done = true;
+  par->finished.wakeAll();
+}
+
+static QThreadPool* route_pool;
+
+int
+route_threads(void)
+{
+  if (global_opts.threads > 0) {
+    return global_opts.threads;
+  }
+  return QThread::idealThreadCount();
+}
+
+void
+route_parallel(route_head* const* rtes, int n, route_work work, route_work finish)
+{
+  QQueue<RouteJob*> jobs;
+  route_par_t par;
+  int threads = route_threads();
+  int points = 0;
+  int i, next;
+
+  for (i = 0; i < n; i++) {
+    points += rtes[i]->rte_waypt_ct;
+  }
+
+  /*
+   * Not worth the threads for a handful of points, unless we were
+   * asked for them.
+   */
+  if ((threads <= 1) || (n < 2) ||
+      ((global_opts.threads == 0) && (points < 2 * RTE_PAR_CHUNK))) {
+    for (i = 0; i < n; i++) {
+      work(rtes[i], i);
+      if (finish) {
+        finish(rtes[i], i);
+      }
+    }
+    return;
+  }
+
+  if (!route_pool) {
+    route_pool = new QThreadPool;
+  }
+  route_pool->setMaxThreadCount(threads);
+  route_locking = 1;
+
+  next = 0;
+  while ((next < n) || !jobs.isEmpty()) {
+    /* Keep a couple of chunks per thread queued up. */
+    while ((next < n) && (jobs.size() < 2 * threads)) {
+      int count = 0;
+      points = 0;
+      while ((next + count < n) && ((count == 0) || (points < RTE_PAR_CHUNK))) {
+        points += rtes[next + count]->rte_waypt_ct + 1;
+        count++;
+      }
+      RouteJob* job = new RouteJob(&par, rtes, next, count, work);
+      jobs.enqueue(job);
+      route_pool->start(job);
+      next += count;
+    }
+
+    RouteJob* job = jobs.dequeue();
+    {
+      QMutexLocker locker(&par.lock);
+      while (!job->done) {
+        par.finished.wait(&par.lock);
+      }
+    }
+    if (finish) {
+      for (i = job->first; i < job->first + job->count; i++) {
+        finish(rtes[i], i);
+      }
+    }
+    delete job;
+  }
+
+  route_locking = 0;
+}
+
+/* As above, for every route on a list.  finish() may delete its route. */
+void
+route_q_parallel(queue* qh, route_work work, route_work finish)
+{
+  QVector<route_head*> rtes;
+  queue* elem, *tmp;
+
+  QUEUE_FOR_EACH(qh, elem, tmp) {
+    rtes.append((route_head*) elem);
+  }
+  route_parallel(rtes.constData(), rtes.size(), work, finish);
+}
+
+void
+route_disp_all_parallel(route_work work, route_work finish)
+{
+  route_q_parallel(&my_route_head, work, finish);
+}
+
+void
+track_disp_all_parallel(route_work work, route_work finish)
+{
+  route_q_parallel(&my_track_head, work, finish);
+}
+
 static void
 route_flush_q(queue* head)
 {
@@ -354,6 +611,7 @@ route_flush_q(queue* head)
 void
 route_flush_all_routes(void)
 {
+  traits_invalidate();
   route_flush_q(&my_route_head);
   rte_head_ct = 0;
   rte_waypts = 0;
@@ -362,6 +620,7 @@ route_flush_all_routes(void)
 void
 route_flush_all_tracks(void)
 {
+  traits_invalidate();
   route_flush_q(&my_track_head);
   trk_head_ct = 0;
   trk_waypts = 0;
@@ -559,66 +818,403 @@ tracks_to_routes(void)
  * If trkdatap is non-null upon entry, a pointer to an allocated collection
  * (hopefully interesting) statistics about the track will be placed there.
  */
-void track_recompute(const route_head* trk, computed_trkdata** trkdatap)
+track_arrays::track_arrays(const route_head* trk)
 {
-  Waypoint first;
-  Waypoint* thisw;
-  Waypoint* prev = &first;
-  queue* elem, *tmp;
-  int tkpt = 0;
-  int pts_hrt = 0;
-  double tot_hrt = 0.0;
-  int pts_cad = 0;
-  double tot_cad = 0.0;
-  computed_trkdata* tdata = (computed_trkdata*)xcalloc(1, sizeof(computed_trkdata));
+  const queue* elem, *tmp;
+
+  wpt.reserve(trk->rte_waypt_ct);
+  lat.reserve(trk->rte_waypt_ct);
+  lon.reserve(trk->rte_waypt_ct);
+  alt.reserve(trk->rte_waypt_ct);
+  time.reserve(trk->rte_waypt_ct);
+  QUEUE_FOR_EACH(&trk->waypoint_list, elem, tmp) {
+    add((Waypoint*)elem);
+  }
+}
 
-  if (trkdatap) {
-    *trkdatap = tdata;
+track_arrays::track_arrays(Waypoint* const* pts, int n)
+{
+  wpt.reserve(n);
+  lat.reserve(n);
+  lon.reserve(n);
+  alt.reserve(n);
+  time.reserve(n);
+  for (int i = 0; i < n; i++) {
+    add(pts[i]);
   }
+}
 
-//  first.latitude = 0;
-//  first.longitude = 0;
-//  first.creation_time = 0;
-  tdata->min_hrt =  9999;
-  tdata->min_alt = -unknown_alt;
-  tdata->max_alt =  unknown_alt;
+void
+track_arrays::add(Waypoint* w)
+{
+  wpt.append(w);
+  lat.append(RAD(w->latitude));
+  lon.append(RAD(w->longitude));
+  alt.append(w->altitude);
+  if (w->GetCreationTime().isValid()) {
+    time.append(w->GetCreationTime().toMSecsSinceEpoch());
+  } else {
+    time.append(std::numeric_limits<double>::quiet_NaN());
+  }
+}
 
-  QUEUE_FOR_EACH((queue*)&trk->waypoint_list, elem, tmp) {
-    double tlat, tlon, plat, plon, dist;
+time_index::time_index(const route_head* rte)
+{
+  const queue* elem, *tmp;
 
-    thisw = (Waypoint*)elem;
+  time.reserve(rte->rte_waypt_ct);
+  wpt.reserve(rte->rte_waypt_ct);
+  QUEUE_FOR_EACH(&rte->waypoint_list, elem, tmp) {
+    add((const Waypoint*)elem);
+  }
+  sort();
+}
 
-    /*
-     * gcdist and heading want radians, not degrees.
-     */
-    tlat = RAD(thisw->latitude);
-    tlon = RAD(thisw->longitude);
-    plat = RAD(prev->latitude);
-    plon = RAD(prev->longitude);
-    WAYPT_SET(thisw, course, heading_true_degrees(plat, plon,
-              tlat, tlon));
-    dist = radtometers(gcdist(plat, plon, tlat, tlon));
+time_index::time_index(Waypoint* const* pts, int n)
+{
+  time.reserve(n);
+  wpt.reserve(n);
+  for (int i = 0; i < n; i++) {
+    add(pts[i]);
+  }
+  sort();
+}
+
+void
+time_index::add(const Waypoint* w)
+{
+  if (w->GetCreationTime().isValid()) {
+    time.append(w->GetCreationTime().toMSecsSinceEpoch());
+    wpt.append(w);
+  }
+}
+
+/* Tracks are nearly always in time order already; only sort if not. */
+void
+time_index::sort()
+{
+  int i, n = size();
+
+  for (i = 1; i < n; i++) {
+    if (time[i] < time[i - 1]) {
+      break;
+    }
+  }
+  if (i >= n) {
+    return;
+  }
+
+  /* The position breaks ties, which keeps equal times in route order. */
+  QVector<std::pair<qint64, int> > order(n);
+  for (i = 0; i < n; i++) {
+    order[i] = std::make_pair(time[i], i);
+  }
+  std::sort(order.begin(), order.end());
+
+  QVector<const Waypoint*> pts = wpt;
+  for (i = 0; i < n; i++) {
+    time[i] = order[i].first;
+    wpt[i] = pts[order[i].second];
+  }
+}
+
+int
+time_index::lower_bound(qint64 t) const
+{
+  return std::lower_bound(time.constBegin(), time.constEnd(), t) - time.constBegin();
+}
+
+int
+time_index::upper_bound(qint64 t) const
+{
+  return std::upper_bound(time.constBegin(), time.constEnd(), t) - time.constBegin();
+}
+
+int
+time_index::nearest(qint64 t) const
+{
+  int above = lower_bound(t);
+
+  if (above == 0) {
+    return size() ? 0 : -1;
+  }
+  /* the first of the points sharing the closest earlier time */
+  int below = lower_bound(time[above - 1]);
+  if ((above == size()) || (t - time[below] <= time[above] - t)) {
+    return below;
+  }
+  return above;
+}
+
+const time_index*
+route_time_index(const route_head* rte)
+{
+  route_cache* rc = route_get_cache(rte);
+
+  if (!rc->times || (rc->times_gen != cache_generation)) {
+    delete rc->times;
+    rc->times = new time_index(rte);
+    rc->times_gen = cache_generation;
+  }
+  return rc->times;
+}
+
+void
+time_tree::add(const route_head* rte)
+{
+  add(route_time_index(rte), rte);
+}
+
+void
+time_tree::add(const time_index* idx, const route_head* owner)
+{
+  span sp;
+
+  sp.idx = idx;
+  sp.owner = owner;
+  sp.start = idx->size() ? idx->time.first() : 0;
+  sp.end = idx->size() ? idx->time.last() : 0;
+  entries.append(sp);
+}
+
+class time_tree_key_lt
+{
+public:
+  explicit time_tree_key_lt(const QVector<qint64>& k) : key(k) {}
+  bool operator()(int a, int b) const {
+    return (key[a] < key[b]) || ((key[a] == key[b]) && (a < b));
+  }
+
+private:
+  const QVector<qint64>& key;
+};
+
+void
+time_tree::build()
+{
+  QVector<qint64> starts, ends;
+  int i;
+
+  by_start.clear();
+  for (i = 0; i < entries.size(); i++) {
+    starts.append(entries[i].start);
+    ends.append(entries[i].end);
+    if (entries[i].idx->size()) {
+      by_start.append(i);
+    }
+  }
+  by_end = by_start;
+  std::sort(by_start.begin(), by_start.end(), time_tree_key_lt(starts));
+  std::sort(by_end.begin(), by_end.end(), time_tree_key_lt(ends));
+
+  max_end.resize(by_start.size());
+  build_node(0, by_start.size());
+}
+
+/*
+ * The tree is implicit: the node for by_start[lo, hi) is its middle
+ * element, with the two halves as children.
+ */
+qint64
+time_tree::build_node(int lo, int hi)
+{
+  if (lo >= hi) {
+    return std::numeric_limits<qint64>::min();
+  }
+  int mid = lo + (hi - lo) / 2;
+  qint64 m = entries[by_start[mid]].end;
+  m = qMax(m, build_node(lo, mid));
+  m = qMax(m, build_node(mid + 1, hi));
+  max_end[mid] = m;
+  return m;
+}
+
+void
+time_tree::find(int lo, int hi, qint64 tlo, qint64 thi, QVector<int>& found) const
+{
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (max_end[mid] < tlo) {
+      return;
+    }
+    find(lo, mid, tlo, thi, found);
+
+    const span& sp = entries[by_start[mid]];
+    if (sp.start > thi) {
+      return;		/* and so does everything after it */
+    }
+    if (sp.end >= tlo) {
+      found.append(by_start[mid]);
+    }
+    lo = mid + 1;
+  }
+}
+
+void
+time_tree::overlapping(qint64 lo, qint64 hi, QVector<int>& found) const
+{
+  QVector<int> spans;
+
+  /* A span can meet the window with no point inside it. */
+  find(0, by_start.size(), lo, hi, spans);
+  std::sort(spans.begin(), spans.end());
+  found.clear();
+  foreach (int e, spans) {
+    const time_index* idx = entries[e].idx;
+    if (idx->lower_bound(lo) < idx->upper_bound(hi)) {
+      found.append(e);
+    }
+  }
+}
+
+bool
+time_tree::nearest(qint64 t, int* entry, int* point) const
+{
+  QVector<int> cand;
+  int n;
+  qint64 best = 0;
+
+  /* Every route that spans t, ... */
+  find(0, by_start.size(), t, t, cand);
+
+  /* ... the one ending last before t, ... */
+  n = by_end.size();
+  int lo = 0, hi = n;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (entries[by_end[mid]].end < t) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo > 0) {
+    qint64 end = entries[by_end[lo - 1]].end;
+    while ((lo > 0) && (entries[by_end[lo - 1]].end == end)) {
+      lo--;
+    }
+    cand.append(by_end[lo]);
+  }
+
+  /* ... and the one starting first after it. */
+  n = by_start.size();
+  lo = 0;
+  hi = n;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (entries[by_start[mid]].start <= t) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < n) {
+    cand.append(by_start[lo]);
+  }
+
+  *entry = -1;
+  foreach (int e, cand) {
+    const time_index* idx = entries[e].idx;
+    int p = idx->nearest(t);
+    qint64 d = qAbs(idx->time[p] - t);
+    if ((*entry < 0) || (d < best) || ((d == best) && (e < *entry))) {
+      *entry = e;
+      *point = p;
+      best = d;
+    }
+  }
+  return *entry >= 0;
+}
+
+/*
+ * Summary statistics for a route or track.  Also fills in each point's
+ * course, speed (when it has none) and an empty shortname, as writers
+ * rely on that.  The results are memoized on the route; when points have
+ * only been appended since the last call, just the new ones are walked.
+ */
+void track_recompute(const route_head* trk, computed_trkdata** trkdatap)
+{
+  route_cache* rc = route_get_cache(trk);
+  computed_trkdata* tdata = &rc->stats;
+  QVector<Waypoint*> pts;
+  const queue* elem;
+  int first = 0;
+
+  if (rc->stats_gen != cache_generation) {
+    memset(tdata, 0, sizeof(*tdata));
+    tdata->min_hrt =  9999;
+    tdata->min_alt = -unknown_alt;
+    tdata->max_alt =  unknown_alt;
+    rc->stats_last = NULL;
+    rc->stats_ct = 0;
+    rc->pts_hrt = 0;
+    rc->tot_hrt = 0.0;
+    rc->pts_cad = 0;
+    rc->tot_cad = 0.0;
+  }
+
+  /*
+   * Resume after the last point seen, keeping it in the arrays as the
+   * start of the first new leg.
+   */
+  if (rc->stats_last) {
+    pts.append((Waypoint*) rc->stats_last);
+    elem = QUEUE_NEXT(&rc->stats_last->Q);
+    first = 1;
+  } else {
+    elem = QUEUE_FIRST(&trk->waypoint_list);
+  }
+  for (; elem != &trk->waypoint_list; elem = QUEUE_NEXT(elem)) {
+    pts.append((Waypoint*) elem);
+  }
+
+  track_arrays ta(pts.constData(), pts.size());
+  int n = ta.size();
+  QVector<double> dist(n);
+  QVector<double> course(n);
+  QVector<double> speed(n);
+
+  /*
+   * Legs, headings and speeds for the whole track at once.  The arrays
+   * are in radians and meters from here on.
+   */
+  gcdist_heading_vec(ta.lat.constData(), ta.lon.constData(), n,
+                     dist.data(), course.data());
+  for (int i = 0; i < n; i++) {
+    dist[i] = radtometers(dist[i]);
+  }
+  speed_vec(dist.constData(), ta.time.constData(), n, 1000.0, speed.data());
+
+  /*
+   * The first point is measured from 0,0, as it always has been; that
+   * leg never counts toward the distance or produces a speed.
+   */
+  if (n > 0 && first == 0) {
+    course[0] = heading_true_degrees(0, 0, ta.lat[0], ta.lon[0]);
+    dist[0] = radtometers(gcdist(0, 0, ta.lat[0], ta.lon[0]));
+  }
+
+  for (int i = first; i < n; i++) {
+    Waypoint* thisw = ta.wpt[i];
+
+    WAYPT_SET(thisw, course, course[i]);
 
     /*
      * Avoid that 6300 mile jump as we move from 0,0.
      */
-    if (plat && plon) {
-      tdata->distance_meters += dist;
+    if (i > 0 && ta.lat[i-1] && ta.lon[i-1]) {
+      tdata->distance_meters += dist[i];
     }
 
     /*
      * If we've moved as much as a meter,
      * conditionally recompute speeds.
      */
-    if (!WAYPT_HAS(thisw, speed) && (dist > 1)) {
+    if (!WAYPT_HAS(thisw, speed) && (dist[i] > 1)) {
       // Only recompute speed if the waypoint
       // didn't already have a speed
-      if (thisw->GetCreationTime().isValid() &&
-          prev->GetCreationTime().isValid() &&
-          thisw->GetCreationTime() > prev->GetCreationTime()) {
-        double timed =
-          prev->GetCreationTime().msecsTo(thisw->GetCreationTime()) / 1000.0;
-        WAYPT_SET(thisw, speed, dist / timed);
+      if (i > 0 && ta.time[i] > ta.time[i-1]) {
+        WAYPT_SET(thisw, speed, speed[i]);
       }
     }
     if (WAYPT_HAS(thisw, speed)) {
@@ -639,26 +1235,26 @@ void track_recompute(const route_head* trk, computed_trkdata** trkdatap)
       }
     }
 
-    if (thisw->heartrate > 0) {
-      pts_hrt++;
-      tot_hrt += (float) thisw->heartrate;
+    if (thisw->ext->heartrate > 0) {
+      rc->pts_hrt++;
+      rc->tot_hrt += (float) thisw->ext->heartrate;
     }
 
-    if ((thisw->heartrate > 0) && (thisw->heartrate < tdata->min_hrt)) {
-      tdata->min_hrt = (int) thisw->heartrate;
+    if ((thisw->ext->heartrate > 0) && (thisw->ext->heartrate < tdata->min_hrt)) {
+      tdata->min_hrt = (int) thisw->ext->heartrate;
     }
 
-    if ((thisw->heartrate > 0) && (thisw->heartrate > tdata->max_hrt)) {
-      tdata->max_hrt = (int) thisw->heartrate;
+    if ((thisw->ext->heartrate > 0) && (thisw->ext->heartrate > tdata->max_hrt)) {
+      tdata->max_hrt = (int) thisw->ext->heartrate;
     }
 
-    if (thisw->cadence > 0) {
-      pts_cad++;
-      tot_cad += (float) thisw->cadence;
+    if (thisw->ext->cadence > 0) {
+      rc->pts_cad++;
+      rc->tot_cad += (float) thisw->ext->cadence;
     }
 
-    if ((thisw->cadence > 0) && (thisw->cadence > tdata->max_cad)) {
-      tdata->max_cad = (int) thisw->cadence;
+    if ((thisw->ext->cadence > 0) && (thisw->ext->cadence > tdata->max_cad)) {
+      tdata->max_cad = (int) thisw->ext->cadence;
     }
 
     if (thisw->GetCreationTime().isValid() && (thisw->GetCreationTime().toTime_t() < tdata->start)) {
@@ -671,26 +1267,71 @@ void track_recompute(const route_head* trk, computed_trkdata** trkdatap)
         tdata->start = tdata->end;
       }
     }
-    prev = thisw;
     if (thisw->shortname.isEmpty()) {
-      thisw->shortname = QString("%1-%2").arg(trk->rte_name).arg(tkpt);
+      thisw->shortname = QString("%1-%2").arg(trk->rte_name).arg(rc->stats_ct);
     }
-    tkpt++;
+    rc->stats_ct++;
   }
 
-  if (pts_hrt > 0) {
-    tdata->avg_hrt = tot_hrt / (float) pts_hrt;
+  if (rc->pts_hrt > 0) {
+    tdata->avg_hrt = rc->tot_hrt / (float) rc->pts_hrt;
   }
 
-  if (pts_cad > 0) {
-    tdata->avg_cad = tot_cad / (float) pts_cad;
+  if (rc->pts_cad > 0) {
+    tdata->avg_cad = rc->tot_cad / (float) rc->pts_cad;
   }
 
-  if (!trkdatap) {
-    xfree(tdata);
+  if (n > 0) {
+    rc->stats_last = ta.wpt[n - 1];
+  }
+  rc->stats_gen = cache_generation;
+
+  if (trkdatap) {
+    *trkdatap = (computed_trkdata*) xmalloc(sizeof(computed_trkdata));
+    **trkdatap = *tdata;
   }
 }
 
+void
+route_compute_bounds(const route_head* rte, bounds* bds)
+{
+  route_cache* rc = route_get_cache(rte);
+  const queue* elem;
+
+  if (rc->bds_gen != cache_generation) {
+    waypt_init_bounds(&rc->bds);
+    for (elem = QUEUE_FIRST(&rte->waypoint_list); elem != &rte->waypoint_list;
+         elem = QUEUE_NEXT(elem)) {
+      waypt_add_to_bounds(&rc->bds, (const Waypoint*) elem);
+    }
+    rc->bds_gen = cache_generation;
+  }
+  *bds = rc->bds;
+}
+
+static void
+common_add_all_to_bounds(queue* qh, bounds* bds)
+{
+  queue* elem, *tmp;
+  QUEUE_FOR_EACH(qh, elem, tmp) {
+    bounds rb;
+    route_compute_bounds((const route_head*) elem, &rb);
+    waypt_merge_bounds(bds, &rb);
+  }
+}
+
+void
+route_add_all_to_bounds(bounds* bds)
+{
+  common_add_all_to_bounds(&my_route_head, bds);
+}
+
+void
+track_add_all_to_bounds(bounds* bds)
+{
+  common_add_all_to_bounds(&my_track_head, bds);
+}
+
 route_head::route_head() :
   rte_num(0),
   rte_waypt_ct(0),
@@ -698,7 +1339,8 @@ route_head::route_head() :
   cet_converted(0),
   // line_color(),
   line_width(-1),
-  session(curr_session())
+  session(curr_session()),
+  cache(NULL)
 {
   QUEUE_INIT(&Q);
   QUEUE_INIT(&waypoint_list);
@@ -710,4 +1352,8 @@ route_head::~route_head()
   if (fs) {
     fs_chain_destroy(fs);
   }
+  if (cache) {
+    delete cache->times;
+    xfree(cache);
+  }
 }
@@ -227,7 +227,7 @@ my_read(void)
         cmtlen = le_read16(&record[obase+2+addrlen]);
 #if NEW_STRINGS
         wpt_tmp->shortname = "booger";
-        wpt_tmp->notes = "goober";
+        wpt_tmp->AllocExt()->notes = "goober";
 #else
         wpt_tmp->shortname = (char*) xmalloc(addrlen+1);
         wpt_tmp->shortname[addrlen]='\0';
@@ -414,7 +414,7 @@ my_read(void)
           oldlon = lon;
         }
         if (turns_important && stringlen) {
-          wpt_tmp->route_priority=1;
+          wpt_tmp->AllocExt()->route_priority=1;
         }
         if (!turns_only || stringlen) {
           if (timesynth) {
@@ -253,7 +253,7 @@ decode_sbn_record(unsigned char* buffer)
   WAYPT_SET(waypt, speed, be_read16(buffer + 39) * 0.01f);
   WAYPT_SET(waypt, course, be_read16(buffer + 41) * 0.01f);
   waypt->sat = buffer[87];
-  waypt->hdop = buffer[88] * 0.2f;
+  waypt->AllocExt()->hdop = buffer[88] * 0.2f;
 
   return waypt;
 }
@@ -28,6 +28,7 @@
 
 #include "defs.h"
 #include "gbser.h"
+#include <QtCore/QFile>
 
 #define MYNAME "skytraq"
 
@@ -57,6 +58,7 @@
 static char* port;			/* port name */
 static void* serial_handle = 0;		/* IO file descriptor */
 static int skytraq_baud = 0;		/* detected baud rate */
+static uint8_t skytraq_ident[12];	/* kernel, ODM and revision of the probed device */
 static gbfile* file_handle = 0;		/* file descriptor (used by skytraq-bin format) */
 
 static char* opt_erase = 0;		/* erase after read? (0/1) */
@@ -69,6 +71,7 @@ static char* opt_dump_file = 0;		/* dump raw data to this file (optional) */
 static char* opt_no_output = 0;		/* disable output? (0/1) */
 static char* opt_set_location = 0;	/* set if the "targetlocation" options was used */
 static char* opt_configure_logging = 0;
+static char* opt_cache = 0;		/* keep finished sectors in this file (optional) */
 
 static
 arglist_t skytraq_args[] = {
@@ -112,6 +115,10 @@ arglist_t skytraq_args[] = {
     "no-output", &opt_no_output, "Disable output (useful with erase)",
     "0", ARGTYPE_BOOL, ARG_NOMINMAX
   },
+  {
+    "cache", &opt_cache, "Keep downloaded sectors in this file and only read new ones",
+    NULL, ARGTYPE_STRING, ARG_NOMINMAX
+  },
   ARG_TERMINATOR
 };
 
@@ -515,7 +522,8 @@ skytraq_configure_logging(void)
 }
 
 static int
-skytraq_get_log_buffer_status(uint32_t* log_wr_ptr, uint16_t* sectors_free, uint16_t* sectors_total)
+skytraq_get_log_buffer_status(uint32_t* log_wr_ptr, uint16_t* sectors_free, uint16_t* sectors_total,
+                              uint8_t* fifo_mode)
 {
   uint8_t MSG_LOG_STATUS_CONTROL = 0x17;
   struct {
@@ -542,6 +550,7 @@ skytraq_get_log_buffer_status(uint32_t* log_wr_ptr, uint16_t* sectors_free, uint
   *log_wr_ptr = le_readu32(&MSG_LOG_STATUS_OUTPUT.log_wr_ptr);
   *sectors_free = le_readu16(&MSG_LOG_STATUS_OUTPUT.sectors_free);
   *sectors_total = le_readu16(&MSG_LOG_STATUS_OUTPUT.sectors_total);
+  *fifo_mode = MSG_LOG_STATUS_OUTPUT.log_fifo_mode[0];
 
   // print logging parameters -- useful, but does this belong here?
   unsigned int tmax, tmin, dmax, dmin, vmax, vmin;
@@ -1031,23 +1040,226 @@ skytraq_read_multiple_sectors(int first_sector, unsigned int sector_count, uint8
   return res_OK;
 }
 
+struct read_ctl {
+  int read_at_once;		/* sectors to ask for with the next multi read */
+  int multi_read_supported;
+};
+
+/* Reads between 1 and max_count sectors beginning at first into buf; returns the number read. */
+static int
+skytraq_read_sectors(struct read_ctl* ctl, int first, int max_count, uint8_t* buf)
+{
+  int t, rc, got_sectors;
+
+  for (t = 0, got_sectors = 0; (t < SECTOR_RETRIES) && (got_sectors <= 0); t++) {
+    if (atoi(opt_read_at_once) == 0  ||  ctl->multi_read_supported == 0) {
+      rc = skytraq_read_single_sector(first, buf);
+      if (rc == res_OK) {
+        got_sectors = 1;
+      }
+    } else {
+      /* Try to read read_at_once sectors at once.
+       * If tere aren't any so many interesting ones, read the remainder (max_count).
+       * And read at least 1 sector.
+       */
+      ctl->read_at_once = MAX(MIN(ctl->read_at_once, max_count), 1);
+
+      rc = skytraq_read_multiple_sectors(first, ctl->read_at_once, buf);
+      switch (rc) {
+      case res_OK:
+        got_sectors = ctl->read_at_once;
+        ctl->read_at_once = MIN(ctl->read_at_once*2, atoi(opt_read_at_once));
+        break;
+
+      case res_NACK:
+        db(1, MYNAME ": Device doesn't seem to support reading multiple "
+           "sectors at once, falling back to single read.\n");
+        ctl->multi_read_supported = 0;
+        break;
+
+      default:
+        /* On failure, try with less sectors */
+        ctl->read_at_once = MAX(ctl->read_at_once/2, 1);
+      }
+    }
+  }
+  if (got_sectors <= 0) {
+    fatal(MYNAME ": Error reading sector %i\n", first);
+  }
+
+  return got_sectors;
+}
+
+/*
+ * Sector cache (option "cache").
+ *
+ * The logger only appends, so a sector is final as soon as the device
+ * has begun writing the one after it.  Final sectors are saved together
+ * with the identity of the device and a CRC per sector.  On the next
+ * download the last saved sector is read back from the device as a
+ * spot check; when it still matches, all saved sectors are taken from
+ * disk and only the newer ones are read over the serial line.  Erasing
+ * the log, FIFO (overwrite) mode, another device or a damaged file all
+ * fall back to reading everything.
+ *
+ * File layout (little endian): "STQCACHE", version (16 bit), device
+ * identity (12 bytes), total sectors (16), write pointer (32), sector
+ * count (32), then per sector its CRC-32 (32) and SECTOR_SIZE bytes.
+ */
+
+#define CACHE_MAGIC		"STQCACHE"
+#define CACHE_VERSION		1
+
+static struct {
+  uint8_t* data;		/* sectors 0..count-1 */
+  unsigned int count;
+  unsigned int alloc;
+  unsigned int trusted;		/* sectors known to match the device */
+} sector_cache;
+
+static void
+cache_store(unsigned int sector, const uint8_t* buf)
+{
+  if (sector > sector_cache.count) {
+    return;			/* keep the cache contiguous from sector 0 */
+  }
+  if (sector == sector_cache.count) {
+    if (sector_cache.count == sector_cache.alloc) {
+      sector_cache.alloc = sector_cache.alloc ? sector_cache.alloc*2 : 64;
+      sector_cache.data = (uint8_t*) xrealloc(sector_cache.data, sector_cache.alloc*SECTOR_SIZE);
+    }
+    sector_cache.count++;
+  }
+  memcpy(sector_cache.data + sector*SECTOR_SIZE, buf, SECTOR_SIZE);
+}
+
+static void
+cache_free(void)
+{
+  if (sector_cache.data) {
+    xfree(sector_cache.data);
+  }
+  memset(&sector_cache, 0, sizeof(sector_cache));
+}
+
+static void
+cache_load(uint32_t log_wr_ptr, uint16_t sectors_total, uint8_t fifo_mode)
+{
+  gbfile* f;
+  char magic[sizeof(CACHE_MAGIC)-1];
+  uint8_t ident[sizeof(skytraq_ident)];
+  uint8_t* buf;
+  unsigned int i, count;
+  uint32_t cached_wr_ptr;
+
+  cache_free();
+  if (!QFile::exists(QString::fromUtf8(opt_cache))) {
+    db(1, MYNAME ": No sector cache yet\n");
+    return;
+  }
+  if (fifo_mode) {
+    db(1, MYNAME ": Log is in FIFO mode, not using the sector cache\n");
+    return;
+  }
+
+  f = gbfopen(opt_cache, "rb", MYNAME);
+  gbfread(magic, 1, sizeof(magic), f);
+  if (memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0 || gbfgetuint16(f) != CACHE_VERSION) {
+    db(1, MYNAME ": '%s' is not a sector cache, ignoring it\n", opt_cache);
+    gbfclose(f);
+    return;
+  }
+  gbfread(ident, 1, sizeof(ident), f);
+  if (memcmp(ident, skytraq_ident, sizeof(ident)) != 0 || gbfgetuint16(f) != sectors_total) {
+    db(1, MYNAME ": Sector cache belongs to another device\n");
+    gbfclose(f);
+    return;
+  }
+  cached_wr_ptr = gbfgetuint32(f);
+  if (log_wr_ptr < cached_wr_ptr) {
+    db(1, MYNAME ": Log has been erased since the last download\n");
+    gbfclose(f);
+    return;
+  }
+  count = gbfgetuint32(f);
+
+  buf = (uint8_t*) xmalloc(SECTOR_SIZE);
+  for (i = 0; i < count && i < sectors_total; i++) {
+    uint32_t crc = gbfgetuint32(f);
+    if (gbfread(buf, 1, SECTOR_SIZE, f) != SECTOR_SIZE ||
+        (uint32_t) get_crc32(buf, SECTOR_SIZE) != crc) {
+      db(1, MYNAME ": Sector cache is damaged at sector #%i\n", i);
+      break;
+    }
+    cache_store(i, buf);
+  }
+  xfree(buf);
+  gbfclose(f);
+  db(1, MYNAME ": %i sectors in cache\n", sector_cache.count);
+}
+
+/* Reads the last cached sector back from the device; all or nothing is trusted after that. */
+static void
+cache_verify(struct read_ctl* ctl, uint8_t* buffer)
+{
+  unsigned int last;
+  int read_at_once = ctl->read_at_once;
+
+  if (sector_cache.count == 0) {
+    return;
+  }
+  last = sector_cache.count - 1;
+  skytraq_read_sectors(ctl, last, 1, buffer);
+  ctl->read_at_once = read_at_once;
+  if (memcmp(buffer, sector_cache.data + last*SECTOR_SIZE, SECTOR_SIZE) == 0) {
+    sector_cache.trusted = sector_cache.count;
+  } else {
+    db(1, MYNAME ": Sector #%i has changed on the device, discarding the cache\n", last);
+    sector_cache.count = 0;
+  }
+}
+
+static void
+cache_save(uint32_t log_wr_ptr, uint16_t sectors_total, unsigned int final_sectors)
+{
+  gbfile* f;
+  unsigned int i, count = MIN(sector_cache.count, final_sectors);
+
+  f = gbfopen(opt_cache, "wb", MYNAME);
+  gbfwrite(CACHE_MAGIC, 1, sizeof(CACHE_MAGIC)-1, f);
+  gbfputuint16(CACHE_VERSION, f);
+  gbfwrite(skytraq_ident, 1, sizeof(skytraq_ident), f);
+  gbfputuint16(sectors_total, f);
+  gbfputuint32(log_wr_ptr, f);
+  gbfputuint32(count, f);
+  for (i = 0; i < count; i++) {
+    const uint8_t* p = sector_cache.data + i*SECTOR_SIZE;
+    gbfputuint32(get_crc32(p, SECTOR_SIZE), f);
+    gbfwrite(p, 1, SECTOR_SIZE, f);
+  }
+  gbfclose(f);
+  db(1, MYNAME ": Saved %i sectors to cache\n", count);
+}
+
 static void
 skytraq_read_tracks(void)
 {
   struct read_state st;
+  struct read_ctl ctl;
   uint32_t log_wr_ptr;
   uint16_t sectors_free, sectors_total, /*sectors_used_a, sectors_used_b,*/ sectors_used;
-  int i, t, s, rc, got_sectors, total_sectors_read = 0;
-  int read_at_once = MAX(atoi(opt_read_at_once), 1);
+  uint8_t fifo_mode;
+  int i, s, rc, got_sectors, total_sectors_read = 0, cached_sectors = 0;
+  int max_at_once = MAX(atoi(opt_read_at_once), 1);
   int opt_first_sector_val = atoi(opt_first_sector);
   int opt_last_sector_val = atoi(opt_last_sector);
-  int multi_read_supported = 1;
+  unsigned int final_sectors = 0;
   uint8_t* buffer = NULL;
   gbfile* dumpfile = NULL;
 
   state_init(&st);
 
-  if (skytraq_get_log_buffer_status(&log_wr_ptr, &sectors_free, &sectors_total) != res_OK) {
+  if (skytraq_get_log_buffer_status(&log_wr_ptr, &sectors_free, &sectors_total, &fifo_mode) != res_OK) {
     fatal(MYNAME ": Can't get log buffer status\n");
   }
 
@@ -1082,8 +1294,15 @@ skytraq_read_tracks(void)
     }
   }
 
-  buffer = (uint8_t*) xmalloc(SECTOR_SIZE*read_at_once+sizeof(SECTOR_READ_END)+6);
+  buffer = (uint8_t*) xmalloc(SECTOR_SIZE*max_at_once+sizeof(SECTOR_READ_END)+6);
   // m.ad/090930: removed code that tried reducing read_at_once if necessary since doesn't work with xmalloc
+  ctl.read_at_once = max_at_once;
+  ctl.multi_read_supported = 1;
+
+  if (opt_cache) {
+    cache_load(log_wr_ptr, sectors_total, fifo_mode);
+    cache_verify(&ctl, buffer);
+  }
 
   if (opt_dump_file) {
     dumpfile = gbfopen(opt_dump_file, "w", MYNAME);
@@ -1093,40 +1312,12 @@ skytraq_read_tracks(void)
   db(1, MYNAME ": start=%d used=%d\n", opt_first_sector_val, sectors_used);
   db(1, MYNAME ": opt_last_sector_val=%d\n", opt_last_sector_val);
   for (i = opt_first_sector_val; i < sectors_used; i += got_sectors) {
-    for (t = 0, got_sectors = 0; (t < SECTOR_RETRIES) && (got_sectors <= 0); t++) {
-      if (atoi(opt_read_at_once) == 0  ||  multi_read_supported == 0) {
-        rc = skytraq_read_single_sector(i, buffer);
-        if (rc == res_OK) {
-          got_sectors = 1;
-        }
-      } else {
-        /* Try to read read_at_once sectors at once.
-         * If tere aren't any so many interesting ones, read the remainder (sectors_used-i).
-         * And read at least 1 sector.
-         */
-        read_at_once = MAX(MIN(read_at_once, sectors_used-i), 1);
-
-        rc = skytraq_read_multiple_sectors(i, read_at_once, buffer);
-        switch (rc) {
-        case res_OK:
-          got_sectors = read_at_once;
-          read_at_once = MIN(read_at_once*2, atoi(opt_read_at_once));
-          break;
-
-        case res_NACK:
-          db(1, MYNAME ": Device doesn't seem to support reading multiple "
-             "sectors at once, falling back to single read.\n");
-          multi_read_supported = 0;
-          break;
-
-        default:
-          /* On failure, try with less sectors */
-          read_at_once = MAX(read_at_once/2, 1);
-        }
-      }
-    }
-    if (got_sectors <= 0) {
-      fatal(MYNAME ": Error reading sector %i\n", i);
+    if (i < (int) sector_cache.trusted) {
+      got_sectors = MIN(MIN(sectors_used - i, (int) sector_cache.trusted - i), max_at_once);
+      memcpy(buffer, sector_cache.data + i*SECTOR_SIZE, got_sectors*SECTOR_SIZE);
+      cached_sectors += got_sectors;
+    } else {
+      got_sectors = skytraq_read_sectors(&ctl, i, sectors_used - i, buffer);
     }
 
     total_sectors_read += got_sectors;
@@ -1135,6 +1326,16 @@ skytraq_read_tracks(void)
       gbfwrite(buffer, SECTOR_SIZE, got_sectors, dumpfile);
     }
 
+    if (opt_cache) {
+      /* a sector is final once the device has written to a later one. */
+      for (s = 0; s < got_sectors; s++) {
+        cache_store(i+s, buffer+s*SECTOR_SIZE);
+        if (buffer[s*SECTOR_SIZE] != 0xFF) {
+          final_sectors = i+s;
+        }
+      }
+    }
+
     if (*opt_no_output == '1') {
       continue;		// skip decoding
     }
@@ -1155,7 +1356,13 @@ skytraq_read_tracks(void)
     }
   }
   free(buffer);
-  db(1, MYNAME ": Got %i trackpoints from %i sectors.\n", st.tpn, total_sectors_read);
+  db(1, MYNAME ": Got %i trackpoints from %i sectors (%i from cache).\n",
+     st.tpn, total_sectors_read, cached_sectors);
+
+  if (opt_cache) {
+    cache_save(log_wr_ptr, sectors_total, final_sectors);
+    cache_free();
+  }
 
   if (dumpfile) {
     gbfclose(dumpfile);
@@ -1230,6 +1437,9 @@ skytraq_probe(void)
          MSG_SOFTWARE_VERSION.revision[1], MSG_SOFTWARE_VERSION.revision[2],
          MSG_SOFTWARE_VERSION.revision[3]);
 
+      memcpy(&skytraq_ident[0], MSG_SOFTWARE_VERSION.kernel_ver, 4);
+      memcpy(&skytraq_ident[4], MSG_SOFTWARE_VERSION.odm_ver, 4);
+      memcpy(&skytraq_ident[8], MSG_SOFTWARE_VERSION.revision, 4);
       return baud_rates[i];
     }
   }
@@ -1328,7 +1538,9 @@ skytraq_read(void)
   }
 
   if (*opt_erase == '1') {
-    skytraq_erase();
+    if (skytraq_erase() == res_OK && opt_cache) {
+      QFile::remove(QString::fromUtf8(opt_cache));
+    }
   }
 
   if (dlbaud != 0  &&  dlbaud != skytraq_baud) {
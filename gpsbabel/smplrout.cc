@@ -182,7 +182,7 @@ compute_xte(struct xte* xte_rec)
                           gcdist(wpt1->latitude, wpt1->longitude,
                                  wpt2->latitude, wpt2->longitude));
   } else if (relopt) {
-    if (wpt3->hdop == 0) {
+    if (wpt3->ext->hdop == 0) {
       fatal(MYNAME ": relative needs hdop information.\n");
     }
     // if timestamps exist, distance to interpolated point
@@ -202,7 +202,7 @@ compute_xte(struct xte* xte_rec)
                                         wpt3->latitude, wpt3->longitude));
     }
     // error relative to horizontal precision
-    xte_rec->distance /= (6 * wpt3->hdop);
+    xte_rec->distance /= (6 * wpt3->ext->hdop);
     // (hdop->meters following to J. Person at <http://www.developerfusion.co.uk/show/4652/3/>)
 
   }
@@ -214,8 +214,8 @@ compare_xte(const void* a, const void* b)
 {
   double distdiff = ((struct xte*)a)->distance -
                     ((struct xte*)b)->distance;
-  int priodiff = ((struct xte*)a)->intermed->wpt->route_priority -
-                 ((struct xte*)b)->intermed->wpt->route_priority;
+  int priodiff = ((struct xte*)a)->intermed->wpt->ext->route_priority -
+                 ((struct xte*)b)->intermed->wpt->ext->route_priority;
 
   if (HUGEVAL == ((struct xte*)a)->distance) {
     return -1;
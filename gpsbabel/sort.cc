@@ -64,7 +64,7 @@ sort_comp(const queue* a, const queue* b)
 
   switch (sort_mode)  {
   case sm_gcid:
-    return x1->gc_data->id - x2->gc_data->id;
+    return x1->ext->gc_data->id - x2->ext->gc_data->id;
   case sm_shortname:
     return x1->shortname.compare(x2->shortname);
   case sm_description:
@@ -30,12 +30,25 @@ namespace gpsbabel
 class File : public QFile
 {
 public:
-  File(const QString& s) : QFile(s) {}
+  File(const QString& s) : QFile(s), memfile(NULL), mempos(0) {}
+  ~File() {
+    close();
+  }
 
   /* in the tradition of gbfile we assume WriteOnly or ReadOnly, not ReadWrite */
   bool open(OpenMode mode) {
     bool status;
 
+    /* Names bound with gbfmem_bind() are read and written in memory. */
+    memfile = gbfmem_open(CSTR(QFile::fileName()));
+    if (memfile) {
+      if (mode & QIODevice::WriteOnly) {
+        memfile->clear();
+      }
+      mempos = 0;
+      return QIODevice::open(mode | QIODevice::Unbuffered);
+    }
+
     if (QFile::fileName() == "-") {
       if (mode & QIODevice::WriteOnly) {
         status = QFile::open(stdout, mode);
@@ -55,6 +68,68 @@ public:
     return status;
   }
 
+  void close() {
+    if (memfile) {
+      QIODevice::close();
+      memfile = NULL;
+    } else {
+      QFile::close();
+    }
+  }
+
+  bool isSequential() const {
+    return memfile ? false : QFile::isSequential();
+  }
+  qint64 size() const {
+    return memfile ? memfile->size() : QFile::size();
+  }
+  qint64 pos() const {
+    return memfile ? QIODevice::pos() : QFile::pos();
+  }
+  bool seek(qint64 offset) {
+    if (memfile) {
+      if (!QIODevice::seek(offset)) {
+        return false;
+      }
+      mempos = offset;
+      return true;
+    }
+    return QFile::seek(offset);
+  }
+  bool atEnd() const {
+    return memfile ? QIODevice::atEnd() : QFile::atEnd();
+  }
+
+protected:
+  qint64 readData(char* data, qint64 maxlen) {
+    if (!memfile) {
+      return QFile::readData(data, maxlen);
+    }
+    qint64 count = qMin(maxlen, (qint64) memfile->size() - mempos);
+    if (count > 0) {
+      memcpy(data, memfile->constData() + mempos, count);
+      mempos += count;
+    }
+    return qMax(count, (qint64) 0);
+  }
+  qint64 readLineData(char* data, qint64 maxlen) {
+    return memfile ? QIODevice::readLineData(data, maxlen) : QFile::readLineData(data, maxlen);
+  }
+  qint64 writeData(const char* data, qint64 len) {
+    if (!memfile) {
+      return QFile::writeData(data, len);
+    }
+    if (mempos + len > memfile->size()) {
+      memfile->resize(mempos + len);
+    }
+    memcpy(memfile->data() + mempos, data, len);
+    mempos += len;
+    return len;
+  }
+
+private:
+  QByteArray* memfile;
+  qint64 mempos;
 };
 
 }; // namespace gpsbabel
@@ -21,23 +21,37 @@
 
 // A wrapper for QTextStream that provides a sensible Warning() and Fatal()
 // with convenient stream operators.
+//
+// The message is collected and handed to warning() or fatal() at the end
+// of the statement, so it goes wherever theirs do.  When GPSBabel runs as
+// a library fatal() throws (see libgpsbabel.cc), hence the destructor
+// that may throw.
 
 #include <QtCore/QTextStream>
-#include <QtCore/QFile>
+#include <QtCore/QString>
+
+/* From defs.h, which is more than this header needs. */
+void fatal(const char*, ...);
+void warning(const char*, ...);
+
+#if (__cplusplus >= 201103L) || (defined(_MSC_VER) && (_MSC_VER >= 1900))
+#  define LOGGING_DTOR_MAY_THROW noexcept(false)
+#else
+#  define LOGGING_DTOR_MAY_THROW
+#endif
 
 class Warning {
  public:
   Warning(bool fatal = false) :
    fatal_(fatal) {
-    file_.open(stderr, QIODevice::WriteOnly);
-    fileStream_.setDevice(&file_);
+    fileStream_.setString(&message_);
   }
-  ~Warning() {
-    fileStream_ << '\n';
+  ~Warning() LOGGING_DTOR_MAY_THROW {
+    fileStream_.flush();
     if (fatal_) {
-      fileStream_.flush();
-      exit(1);
+      fatal("%s\n", qPrintable(message_));
     }
+    warning("%s\n", qPrintable(message_));
   }
   inline Warning& operator << (char d) { fileStream_ << d; return optionalSpace(); }
   inline Warning& operator << (signed short d) { fileStream_ << d; return optionalSpace(); }
@@ -59,7 +73,7 @@ class Warning {
     return *this;
   }
 private:
-  QFile file_;
+  QString message_;
   QTextStream fileStream_;
   bool fatal_;
 };
@@ -19,66 +19,424 @@
 
 #include "src/core/xmlstreamwriter.h"
 
-#include <QtCore/QFile>
-#include <QtCore/QTextCodec>
-#include <QtCore/QXmlStreamWriter>
+#include <QtCore/QIODevice>
+#include <string.h>
 
 // As this code began in C, we have several hundred places that write
 // c strings.  Add a test that the string contains anything useful
 // before serializing an empty tag.
 // We also strip out characters that are illegal in xml.  These can creep
 // into our structures from other formats where they are legal.
+//
+// The element, indentation and escaping rules follow QXmlStreamWriter
+// so that the output doesn't change; what's different is that text
+// is encoded to UTF-8 once, straight into buf_, and buf_ is handed to
+// the device only when it gets big.
 
 namespace gpsbabel
 {
 
-XmlTextCodec* XmlTextCodec::instance = new XmlTextCodec();
+static const int kFlushSize = 64 * 1024;
 
-XmlTextCodec::XmlTextCodec() : QTextCodec()
+XmlStreamWriter::XmlStreamWriter(QString* string) :
+  device_(NULL), string_(string)
 {
-  utf8Codec = QTextCodec::codecForName("UTF-8");
+  init();
+  // Strings have no codec, so nothing was ever scrubbed there.
+  scrub_ = false;
 }
 
-QByteArray XmlTextCodec::convertFromUnicode(const QChar* chars, int len, QTextCodec::ConverterState* state) const
+XmlStreamWriter::XmlStreamWriter(QIODevice* device) :
+  device_(device), string_(NULL)
 {
-// Qt 4.7.4, 4.6.2 don't have IgnoreHeader set on the first call, which can
-// result in a BOM being output by utf8Codec.
-  state->flags |= QTextCodec::IgnoreHeader;
-  QByteArray r = utf8Codec->fromUnicode(chars, len, state);
-  char* data = r.data();
-  for (int i = 0; i < r.size(); i++) {
-    if ((0x00 <= data[i] && data[i] <= 0x08) ||
-        (0x0b <= data[i] && data[i] <= 0x0c) ||
-        (0x0e <= data[i] && data[i] <= 0x1f)) {
-      data[i] = ' ';
+  init();
+}
+
+XmlStreamWriter::~XmlStreamWriter()
+{
+  flush();
+}
+
+void XmlStreamWriter::init()
+{
+  buf_.reserve(kFlushSize + 4096);
+  indent_ = QByteArray(4, ' ');
+  autoFormatting_ = false;
+  inStartElement_ = false;
+  inEmptyElement_ = false;
+  lastWasStartElement_ = false;
+  wroteSomething_ = false;
+  scrub_ = true;
+}
+
+void XmlStreamWriter::setAutoFormatting(bool enable)
+{
+  autoFormatting_ = enable;
+}
+
+bool XmlStreamWriter::autoFormatting() const
+{
+  return autoFormatting_;
+}
+
+void XmlStreamWriter::setAutoFormattingIndent(int spacesOrTabs)
+{
+  indent_ = QByteArray(spacesOrTabs < 0 ? -spacesOrTabs : spacesOrTabs,
+                       spacesOrTabs >= 0 ? ' ' : '\t');
+}
+
+int XmlStreamWriter::autoFormattingIndent() const
+{
+  if (indent_.isEmpty()) {
+    return 0;
+  }
+  return indent_.at(0) == '\t' ? -indent_.size() : indent_.size();
+}
+
+// Output is always UTF-8.  Asking for a plain UTF-8 codec means control
+// characters are passed through rather than turned into spaces.
+void XmlStreamWriter::setCodec(const char* codecName)
+{
+  scrub_ = qstricmp(codecName, "utf-8") != 0 && qstricmp(codecName, "utf8") != 0;
+}
+
+void XmlStreamWriter::flush()
+{
+  if (buf_.isEmpty()) {
+    return;
+  }
+  if (string_) {
+    string_->append(QString::fromUtf8(buf_.constData(), buf_.size()));
+  } else if (device_) {
+    device_->write(buf_.constData(), buf_.size());
+  }
+  buf_.resize(0);
+}
+
+// End of every public call: strings see each write as it happens,
+// devices get it in big pieces.
+void XmlStreamWriter::done()
+{
+  if (string_ || buf_.size() >= kFlushSize) {
+    flush();
+  }
+}
+
+void XmlStreamWriter::put(const char* s)
+{
+  buf_.append(s);
+}
+
+void XmlStreamWriter::put(const char* s, int len)
+{
+  buf_.append(s, len);
+}
+
+void XmlStreamWriter::put(const QString& s, Escape escape)
+{
+  const QChar* p = s.constData();
+  const QChar* end = p + s.size();
+  int pos = buf_.size();
+
+  // Worst case is "&quot;" for each char.
+  buf_.resize(pos + 6 * s.size());
+  char* d = buf_.data() + pos;
+
+  for (; p < end; p++) {
+    ushort c = p->unicode();
+    if (c < 0x80) {
+      switch (c) {
+      case '<':
+        if (escape != kRaw) {
+          memcpy(d, "&lt;", 4);
+          d += 4;
+          continue;
+        }
+        break;
+      case '>':
+        if (escape != kRaw) {
+          memcpy(d, "&gt;", 4);
+          d += 4;
+          continue;
+        }
+        break;
+      case '&':
+        if (escape != kRaw) {
+          memcpy(d, "&amp;", 5);
+          d += 5;
+          continue;
+        }
+        break;
+      case '"':
+        if (escape != kRaw) {
+          memcpy(d, "&quot;", 6);
+          d += 6;
+          continue;
+        }
+        break;
+      case '\t':
+        if (escape == kAttribute) {
+          memcpy(d, "&#9;", 4);
+          d += 4;
+          continue;
+        }
+        break;
+      case '\n':
+        if (escape == kAttribute) {
+          memcpy(d, "&#10;", 5);
+          d += 5;
+          continue;
+        }
+        break;
+      case '\r':
+        if (escape == kAttribute) {
+          memcpy(d, "&#13;", 5);
+          d += 5;
+          continue;
+        }
+        break;
+      default:
+        if (c < 0x20 && scrub_) {
+          c = ' ';
+        }
+        break;
+      }
+      *d++ = (char) c;
+    } else if (c < 0x800) {
+      *d++ = (char)(0xc0 | (c >> 6));
+      *d++ = (char)(0x80 | (c & 0x3f));
+    } else if (p->isHighSurrogate() && p + 1 < end && p[1].isLowSurrogate()) {
+      uint u = QChar::surrogateToUcs4(c, p[1].unicode());
+      p++;
+      *d++ = (char)(0xf0 | (u >> 18));
+      *d++ = (char)(0x80 | ((u >> 12) & 0x3f));
+      *d++ = (char)(0x80 | ((u >> 6) & 0x3f));
+      *d++ = (char)(0x80 | (u & 0x3f));
+    } else if (c >= 0xd800 && c <= 0xdfff) {
+      // Unpaired surrogate; the UTF-8 codec replaces these too.
+      *d++ = '?';
+    } else {
+      *d++ = (char)(0xe0 | (c >> 12));
+      *d++ = (char)(0x80 | ((c >> 6) & 0x3f));
+      *d++ = (char)(0x80 | (c & 0x3f));
     }
   }
-  return r;
+  buf_.resize(d - buf_.constData());
+}
+
+void XmlStreamWriter::indent(int level)
+{
+  buf_.append('\n');
+  for (int i = level; i > 0; --i) {
+    buf_.append(indent_);
+  }
+}
+
+bool XmlStreamWriter::finishStartElement(bool contents)
+{
+  bool hadSomethingWritten = wroteSomething_;
+  wroteSomething_ = contents;
+  if (!inStartElement_) {
+    return hadSomethingWritten;
+  }
+
+  if (inEmptyElement_) {
+    put("/>");
+    tagNames_.resize(tagStarts_.last());
+    tagStarts_.pop_back();
+    lastWasStartElement_ = false;
+  } else {
+    put(">");
+  }
+  inStartElement_ = inEmptyElement_ = false;
+  return hadSomethingWritten;
+}
+
+void XmlStreamWriter::startElement(const char* name, int len)
+{
+  if (!finishStartElement(false) && autoFormatting_) {
+    indent(tagStarts_.size());
+  }
+  tagStarts_.append(tagNames_.size());
+  tagNames_.append(name, len);
+  put("<");
+  put(name, len);
+  inStartElement_ = lastWasStartElement_ = true;
+  if (!pendingNamespaces_.isEmpty()) {
+    buf_.append(pendingNamespaces_);
+    pendingNamespaces_.resize(0);
+  }
+}
+
+void XmlStreamWriter::writeStartElement(const char* qualifiedName)
+{
+  startElement(qualifiedName, strlen(qualifiedName));
+  done();
+}
+
+void XmlStreamWriter::writeStartElement(const QString& qualifiedName)
+{
+  QByteArray name = qualifiedName.toUtf8();
+  startElement(name.constData(), name.size());
+  done();
+}
+
+void XmlStreamWriter::writeEmptyElement(const char* qualifiedName)
+{
+  startElement(qualifiedName, strlen(qualifiedName));
+  inEmptyElement_ = true;
+  done();
+}
+
+void XmlStreamWriter::writeEmptyElement(const QString& qualifiedName)
+{
+  QByteArray name = qualifiedName.toUtf8();
+  startElement(name.constData(), name.size());
+  inEmptyElement_ = true;
+  done();
+}
+
+void XmlStreamWriter::writeEndElement()
+{
+  if (tagStarts_.isEmpty()) {
+    return;
+  }
+
+  // shortcut: if nothing was written, close as empty tag
+  if (inStartElement_ && !inEmptyElement_) {
+    put("/>");
+    lastWasStartElement_ = inStartElement_ = false;
+    tagNames_.resize(tagStarts_.last());
+    tagStarts_.pop_back();
+    done();
+    return;
+  }
+
+  if (!finishStartElement(false) && !lastWasStartElement_ && autoFormatting_) {
+    indent(tagStarts_.size() - 1);
+  }
+  if (tagStarts_.isEmpty()) {
+    done();
+    return;
+  }
+  lastWasStartElement_ = false;
+  int start = tagStarts_.last();
+  put("</");
+  put(tagNames_.constData() + start, tagNames_.size() - start);
+  put(">");
+  tagNames_.resize(start);
+  tagStarts_.pop_back();
+  done();
 }
 
-QString XmlTextCodec::convertToUnicode(const char* chars, int len, QTextCodec::ConverterState* state) const
+void XmlStreamWriter::writeAttribute(const char* qualifiedName, const QString& value)
 {
-  return utf8Codec->toUnicode(chars, len, state);
+  put(" ");
+  put(qualifiedName);
+  put("=\"");
+  put(value, kAttribute);
+  put("\"");
+  done();
 }
 
-int XmlTextCodec::mibEnum() const
+void XmlStreamWriter::writeAttribute(const QString& qualifiedName, const QString& value)
 {
-  return UTF8_FOR_XML_MIB;
+  put(" ");
+  put(qualifiedName);
+  put("=\"");
+  put(value, kAttribute);
+  put("\"");
+  done();
 }
 
-// Our name must not overlap with UTF-8 or it may be returned by QTextCodec::codecForName("UTF-8")
-QByteArray XmlTextCodec::name() const
+void XmlStreamWriter::writeAttributes(const QXmlStreamAttributes& attributes)
 {
-  return QByteArray("UTF-8-XML");
+  for (int i = 0; i < attributes.size(); ++i) {
+    writeAttribute(attributes.at(i).qualifiedName().toString(),
+                   attributes.at(i).value().toString());
+  }
 }
 
-XmlStreamWriter::XmlStreamWriter(QString* string) : QXmlStreamWriter(string)
+void XmlStreamWriter::writeNamespace(const QString& namespaceUri, const QString& prefix)
 {
+  QByteArray decl;
+
+  if (prefix.isEmpty()) {
+    decl = " xmlns=\"";
+  } else {
+    decl = " xmlns:";
+    decl += prefix.toUtf8();
+    decl += "=\"";
+  }
+  decl += namespaceUri.toUtf8();
+  decl += "\"";
+
+  if (inStartElement_) {
+    buf_.append(decl);
+  } else {
+    // Held until the next start tag, as QXmlStreamWriter does.
+    pendingNamespaces_.append(decl);
+  }
+  done();
 }
 
-XmlStreamWriter::XmlStreamWriter(QFile* f) : QXmlStreamWriter(f)
+void XmlStreamWriter::writeCharacters(const QString& text)
 {
-  setCodec(XmlTextCodec::instance);
+  finishStartElement();
+  put(text, kText);
+  done();
+}
+
+void XmlStreamWriter::writeTextElement(const char* qualifiedName, const QString& text)
+{
+  startElement(qualifiedName, strlen(qualifiedName));
+  writeCharacters(text);
+  writeEndElement();
+}
+
+void XmlStreamWriter::writeTextElement(const QString& qualifiedName, const QString& text)
+{
+  writeStartElement(qualifiedName);
+  writeCharacters(text);
+  writeEndElement();
+}
+
+void XmlStreamWriter::writeCDATA(const QString& text)
+{
+  finishStartElement();
+  QString copy(text);
+  copy.replace(QLatin1String("]]>"), QLatin1String("]]]]><![CDATA[>"));
+  put("<![CDATA[");
+  put(copy);
+  put("]]>");
+  done();
+}
+
+void XmlStreamWriter::writeComment(const QString& text)
+{
+  if (!finishStartElement(false) && autoFormatting_) {
+    indent(tagStarts_.size());
+  }
+  put("<!--");
+  put(text);
+  put("-->");
+  inStartElement_ = lastWasStartElement_ = false;
+  done();
+}
+
+void XmlStreamWriter::writeProcessingInstruction(const QString& target, const QString& data)
+{
+  if (!finishStartElement(false) && autoFormatting_) {
+    indent(tagStarts_.size());
+  }
+  put("<?");
+  put(target);
+  if (!data.isNull()) {
+    put(" ");
+    put(data);
+  }
+  put("?>");
+  done();
 }
 
 // We must overide the encoding, we don't want to use XmlTextCode::name().
@@ -87,19 +445,35 @@ void XmlStreamWriter::writeStartDocument()
   writeProcessingInstruction("xml version=\"1.0\" encoding=\"UTF-8\"");
 }
 
+void XmlStreamWriter::writeEndDocument()
+{
+  while (!tagStarts_.isEmpty()) {
+    writeEndElement();
+  }
+  put("\n");
+  done();
+}
+
 // Dont emit the attribute if there's nothing interesting in it.
 void XmlStreamWriter::writeOptionalAttribute(const QString& qualifiedName, const QString& value)
 {
   if (!value.isEmpty()) {
-    QXmlStreamWriter::writeAttribute(qualifiedName, value);
+    writeAttribute(qualifiedName, value);
   }
 }
 
 // Dont emit the element if there's nothing interesting in it.
+void XmlStreamWriter::writeOptionalTextElement(const char* qualifiedName, const QString& text)
+{
+  if (!text.isEmpty()) {
+    writeTextElement(qualifiedName, text);
+  }
+}
+
 void XmlStreamWriter::writeOptionalTextElement(const QString& qualifiedName, const QString& text)
 {
   if (!text.isEmpty()) {
-    QXmlStreamWriter::writeTextElement(qualifiedName, text);
+    writeTextElement(qualifiedName, text);
   }
 }
 
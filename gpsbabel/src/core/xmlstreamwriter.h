@@ -20,44 +20,85 @@
 #ifndef XMLSTREAMWRITER_H
 #define XMLSTREAMWRITER_H
 
-#include <QtCore/QTextCodec>
-#include <QtCore/QXmlStreamWriter>
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+#include <QtCore/QXmlStreamAttributes>
 
-class QFile;
+class QIODevice;
 
 namespace gpsbabel
 {
 
-// From the "vendor" range, see:
-// https://www.iana.org/assignments/character-sets/character-sets.xhtml
-const int UTF8_FOR_XML_MIB = 2000;
-
-class XmlTextCodec : public QTextCodec
-{
-private:
-  QTextCodec* utf8Codec;
-public:
-  XmlTextCodec();
-  static XmlTextCodec *instance;
-  virtual QByteArray name() const;
-  virtual int mibEnum() const;
-protected:
-  virtual QByteArray convertFromUnicode(const QChar* chars, int len, QTextCodec::ConverterState* state) const;
-  virtual QString convertToUnicode(const char* chars, int len, QTextCodec::ConverterState* state) const;
-};
-
-class XmlStreamWriter : public QXmlStreamWriter
+// A small XML writer that produces the same output as QXmlStreamWriter
+// (for the subset of it we use) but encodes straight to UTF-8 into a
+// reusable buffer that is written to the device in large chunks.
+class XmlStreamWriter
 {
 public:
   XmlStreamWriter(QString* string);
-  XmlStreamWriter(QFile* f);
+  XmlStreamWriter(QIODevice* device);
+  ~XmlStreamWriter();
+
+  void setAutoFormatting(bool enable);
+  bool autoFormatting() const;
+  void setAutoFormattingIndent(int spacesOrTabs);
+  int autoFormattingIndent() const;
+  void setCodec(const char* codecName);
 
   void writeStartDocument(void);
+  void writeEndDocument(void);
+  void writeStartElement(const char* qualifiedName);
+  void writeStartElement(const QString& qualifiedName);
+  void writeEmptyElement(const char* qualifiedName);
+  void writeEmptyElement(const QString& qualifiedName);
+  void writeEndElement(void);
+  void writeAttribute(const char* qualifiedName, const QString& value);
+  void writeAttribute(const QString& qualifiedName, const QString& value);
+  void writeAttributes(const QXmlStreamAttributes& attributes);
+  void writeNamespace(const QString& namespaceUri, const QString& prefix = QString());
+  void writeCharacters(const QString& text);
+  void writeTextElement(const char* qualifiedName, const QString& text);
+  void writeTextElement(const QString& qualifiedName, const QString& text);
+  void writeCDATA(const QString& text);
+  void writeComment(const QString& text);
+  void writeProcessingInstruction(const QString& target, const QString& data = QString());
+
   void writeOptionalAttribute(const QString& qualifiedName, const QString& value);
+  void writeOptionalTextElement(const char* qualifiedName, const QString& text);
   void writeOptionalTextElement(const QString& qualifiedName, const QString& text);
+
+  void flush(void);
+
+private:
+  enum Escape { kRaw, kText, kAttribute };
+
+  void init(void);
+  void put(const char* s);
+  void put(const char* s, int len);
+  void put(const QString& s, Escape escape = kRaw);
+  void indent(int level);
+  bool finishStartElement(bool contents = true);
+  void startElement(const char* name, int len);
+  void done(void);
+
+  QIODevice* device_;
+  QString* string_;
+  QByteArray buf_;
+  QByteArray indent_;
+  // Names of the open elements, back to back, and where each one starts.
+  QByteArray tagNames_;
+  QVector<int> tagStarts_;
+  // Namespaces declared outside of a start tag wait for the next one.
+  QByteArray pendingNamespaces_;
+  bool autoFormatting_;
+  bool inStartElement_;
+  bool inEmptyElement_;
+  bool lastWasStartElement_;
+  bool wroteSomething_;
+  bool scrub_;
 };
 
 } // namespace gpsbabel
 
 #endif // XMLSTREAMWRITER_H
-
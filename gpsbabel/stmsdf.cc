@@ -302,7 +302,7 @@ parse_point(char* line)
         break;
       case 3:
         WAYPT_SET(wpt, proximity, atof(str));
-        wpt->notes = QString().sprintf("Alarm point: radius=%s", str);
+        wpt->AllocExt()->notes = QString().sprintf("Alarm point: radius=%s", str);
         break;
       }
       break;
@@ -118,14 +118,14 @@ subrip_prevwp_pr(const Waypoint* waypointp)
           prevwpp->latitude+.000005, prevwpp->longitude+.000005);
         break;
       case 'c':
-        if (prevwpp->cadence != 0)
-          gbfprintf(fout, "%3u", prevwpp->cadence);
+        if (prevwpp->ext->cadence != 0)
+          gbfprintf(fout, "%3u", prevwpp->ext->cadence);
         else
           gbfprintf(fout, "  -");
         break;
       case 'h':
-        if (prevwpp->heartrate != 0)
-          gbfprintf(fout, "%3u", prevwpp->heartrate);
+        if (prevwpp->ext->heartrate != 0)
+          gbfprintf(fout, "%3u", prevwpp->ext->heartrate);
         else
           gbfprintf(fout, "  -");
         break;
@@ -195,11 +195,11 @@ waypoint_final()
   wpt_tmp->wpt_flags.fmt_use  = 0;
 
   if (version < 2) {	/* keep the old behaviour */
-    wpt_tmp->notes = wpt_tmp->description;
+    wpt_tmp->AllocExt()->notes = wpt_tmp->description;
     wpt_tmp->description = QString();
   }
 
-  wpt_tmp->notes = fix_notes(wpt_tmp->shortname, wpt_tmp->notes);
+  wpt_tmp->AllocExt()->notes = fix_notes(wpt_tmp->shortname, wpt_tmp->ext->notes);
 
   if (via != 0) {
     waypt_add(wpt_tmp);
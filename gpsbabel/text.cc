@@ -131,44 +131,44 @@ text_disp(const Waypoint* wpt)
 
   if (wpt->description != wpt->shortname) {
     gbfputs(wpt->description, file_out);
-    if (!wpt->gc_data->placer.isEmpty()) {
+    if (!wpt->ext->gc_data->placer.isEmpty()) {
       gbfputs(" by ", file_out);
-      gbfputs(wpt->gc_data->placer, file_out);
+      gbfputs(wpt->ext->gc_data->placer, file_out);
     }
   }
-  if (wpt->gc_data->terr) {
+  if (wpt->ext->gc_data->terr) {
     gbfprintf(file_out, " - %s / %s - (%d%s / %d%s)\n",
-              gs_get_cachetype(wpt->gc_data->type), gs_get_container(wpt->gc_data->container),
-              (int)(wpt->gc_data->diff / 10), (wpt->gc_data->diff%10)?".5":"",
-              (int)(wpt->gc_data->terr / 10), (wpt->gc_data->terr%10)?".5":"");
-    if (!wpt->gc_data->desc_short.utfstring.isEmpty()) {
-      char* stripped_html = strip_html(&wpt->gc_data->desc_short);
+              gs_get_cachetype(wpt->ext->gc_data->type), gs_get_container(wpt->ext->gc_data->container),
+              (int)(wpt->ext->gc_data->diff / 10), (wpt->ext->gc_data->diff%10)?".5":"",
+              (int)(wpt->ext->gc_data->terr / 10), (wpt->ext->gc_data->terr%10)?".5":"");
+    if (!wpt->ext->gc_data->desc_short.utfstring.isEmpty()) {
+      char* stripped_html = strip_html(&wpt->ext->gc_data->desc_short);
       gbfprintf(file_out, "\n%s\n", stripped_html);
       xfree(stripped_html);
     }
-    if (!wpt->gc_data->desc_long.utfstring.isEmpty()) {
-      char* stripped_html = strip_html(&wpt->gc_data->desc_long);
+    if (!wpt->ext->gc_data->desc_long.utfstring.isEmpty()) {
+      char* stripped_html = strip_html(&wpt->ext->gc_data->desc_long);
       gbfprintf(file_out, "\n%s\n", stripped_html);
       xfree(stripped_html);
     }
-    if (!wpt->gc_data->hint.isEmpty()) {
+    if (!wpt->ext->gc_data->hint.isEmpty()) {
       QString hint;
       if (txt_encrypt) {
-        hint = rot13(wpt->gc_data->hint);
+        hint = rot13(wpt->ext->gc_data->hint);
       } else {
-        hint = xstrdup(wpt->gc_data->hint);
+        hint = xstrdup(wpt->ext->gc_data->hint);
       }
       gbfprintf(file_out, "\nHint: %s\n", CSTR(hint));
     }
-  } else if (!wpt->notes.isEmpty() && (wpt->description.isEmpty() || wpt->notes != wpt->description)) {
+  } else if (!wpt->ext->notes.isEmpty() && (wpt->description.isEmpty() || wpt->ext->notes != wpt->description)) {
     gbfputs("\n", file_out);
-    gbfputs(wpt->notes, file_out);
+    gbfputs(wpt->ext->notes, file_out);
     gbfputs("\n", file_out);
   }
 
   fs_gpx = NULL;
   if (includelogs) {
-    fs_gpx = (fs_xml*)fs_chain_find(wpt->fs, FS_GPX);
+    fs_gpx = (fs_xml*)fs_chain_find(wpt->ext->fs, FS_GPX);
   }
 
   if (fs_gpx && fs_gpx->tag) {
@@ -186,8 +186,8 @@ tiger_disp(const Waypoint* wpt)
   double lon = wpt->longitude;
 
   if (iconismarker) {
-    pin = wpt->icon_descr;
-  } else if (wpt->icon_descr.contains("-unfound")) {
+    pin = wpt->ext->icon_descr;
+  } else if (wpt->ext->icon_descr.contains("-unfound")) {
     pin = unfoundmarker;
   } else if (wpt->GetCreationTime() > current_time().addSecs(-3600 * 24 * thresh_days)) {
     pin = newmarker;
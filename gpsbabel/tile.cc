@@ -0,0 +1,479 @@
+/*
+    Tile filter: split data into a grid of tiles, cutting tracks at the
+    tile edges.
+
+    Copyright (C) 2002-2014 Robert Lipe, robertlipe+source@gpsbabel.org
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111 USA
+
+ */
+
+#include "defs.h"
+#include "filterdefs.h"
+#include <QtCore/QList>
+#include <QtCore/QMap>
+#include <QtCore/QVector>
+#include <math.h>
+#include <algorithm>
+
+#if FILTERS_ENABLED
+#define MYNAME "tile"
+
+static char* opt_grid = NULL;
+static char* opt_zoom = NULL;
+static char* opt_bbox = NULL;
+static char* opt_file = NULL;
+static char* opt_format = NULL;
+
+static
+arglist_t tile_args[] = {
+  {
+    "grid", &opt_grid, "Tile size in degrees",
+    NULL, ARGTYPE_FLOAT, ARG_NOMINMAX
+  },
+  {
+    "zoom", &opt_zoom, "Web map zoom level for z/x/y tiles",
+    NULL, ARGTYPE_INT, "0", "24"
+  },
+  {
+    "bbox", &opt_bbox, "Clip to minlat:minlon:maxlat:maxlon",
+    NULL, ARGTYPE_STRING, ARG_NOMINMAX
+  },
+  {
+    "file", &opt_file, "Write each tile to a file named by %x, %y and %z",
+    NULL, ARGTYPE_OUTFILE, ARG_NOMINMAX
+  },
+  {
+    "format", &opt_format, "Format of the tile files",
+    "gpx", ARGTYPE_STRING, ARG_NOMINMAX
+  },
+  ARG_TERMINATOR
+};
+
+/*
+ * The grid.  Positions are mapped to grid coordinates in which the
+ * tiles are unit squares, (0, 0) to (cols, rows).  For a plain grid
+ * that is linear in latitude and longitude; for zoom it is the web
+ * Mercator projection with y growing to the south.
+ */
+static int zoom;			/* -1 for a plain grid */
+static double grid_lat0, grid_lon0;
+static double grid_dlat, grid_dlon;
+static int grid_cols, grid_rows;
+
+/* What goes into one tile's file. */
+typedef struct {
+  QList<Waypoint*> wpts;
+  QList<route_head*> trks;
+  QList<QList<Waypoint*> > trk_pts;
+  const route_head* src;		/* source of trks.last() */
+} tile_t;
+
+static QMap<qint64, tile_t*> tiles;	/* by row, then column */
+
+static void
+tile_to_grid(double lat, double lon, double* gx, double* gy)
+{
+  if (zoom >= 0) {
+    double n = grid_cols;
+    if (lat > 89.9999) {
+      lat = 89.9999;
+    } else if (lat < -89.9999) {
+      lat = -89.9999;
+    }
+    *gx = (lon + 180.0) / 360.0 * n;
+    *gy = (1.0 - log(tan(RAD(lat)) + 1.0 / cos(RAD(lat))) / M_PI) / 2.0 * n;
+  } else {
+    *gx = (lon - grid_lon0) / grid_dlon;
+    *gy = (lat - grid_lat0) / grid_dlat;
+  }
+}
+
+static void
+tile_from_grid(double gx, double gy, double* lat, double* lon)
+{
+  if (zoom >= 0) {
+    double n = grid_cols;
+    *lon = gx / n * 360.0 - 180.0;
+    *lat = DEG(atan(sinh(M_PI * (1.0 - 2.0 * gy / n))));
+  } else {
+    *lon = grid_lon0 + gx * grid_dlon;
+    *lat = grid_lat0 + gy * grid_dlat;
+  }
+}
+
+/* The tile holding a grid position; false if it is off the grid. */
+static int
+tile_cell(double gx, double gy, int* cx, int* cy)
+{
+  *cx = (int) floor(gx);
+  *cy = (int) floor(gy);
+  /* The far edges belong to the last row and column. */
+  if ((*cx == grid_cols) && (gx == grid_cols)) {
+    (*cx)--;
+  }
+  if ((*cy == grid_rows) && (gy == grid_rows)) {
+    (*cy)--;
+  }
+  return (*cx >= 0) && (*cx < grid_cols) && (*cy >= 0) && (*cy < grid_rows);
+}
+
+static tile_t*
+tile_get(int cx, int cy)
+{
+  qint64 key = (qint64) cy * grid_cols + cx;
+  tile_t* tile = tiles.value(key);
+
+  if (!tile) {
+    tile = new tile_t;
+    tile->src = NULL;
+    tiles.insert(key, tile);
+  }
+  return tile;
+}
+
+/* Add a point to the rebuilt track, and to its tile if we write them. */
+static void
+tile_emit(route_head* trk, Waypoint* wpt, int cx, int cy)
+{
+  track_add_wpt(trk, wpt);
+  if (!opt_file) {
+    return;
+  }
+
+  tile_t* tile = tile_get(cx, cy);
+  if (tile->src != trk) {
+    route_head* head = route_head_alloc();
+    head->rte_name = trk->rte_name;
+    head->rte_desc = trk->rte_desc;
+    head->rte_url = trk->rte_url;
+    head->rte_num = trk->rte_num;
+    head->fs = fs_chain_copy(trk->fs);
+    tile->trks.append(head);
+    tile->trk_pts.append(QList<Waypoint*>());
+    tile->src = trk;
+  }
+  tile->trk_pts.last().append(new Waypoint(*wpt));
+}
+
+/*
+ * The point at fraction t of the straight line, in grid coordinates,
+ * from a to b.  Time and altitude are interpolated too.  A point that
+ * starts a piece of track starts a new segment.
+ */
+static Waypoint*
+tile_point(const Waypoint* a, double ax, double ay,
+           const Waypoint* b, double bx, double by, double t, int start)
+{
+  Waypoint* wpt = new Waypoint(*a);
+
+  wpt->shortname = QString();
+  wpt->description = QString();
+  if (t > 0) {
+    tile_from_grid(ax + (bx - ax) * t, ay + (by - ay) * t,
+                   &wpt->latitude, &wpt->longitude);
+    if ((a->altitude != unknown_alt) && (b->altitude != unknown_alt)) {
+      wpt->altitude = a->altitude + t * (b->altitude - a->altitude);
+    } else {
+      wpt->altitude = unknown_alt;
+    }
+    if (a->creation_time.isValid() && b->creation_time.isValid()) {
+      qint64 ta = a->GetCreationTime().toMSecsSinceEpoch();
+      qint64 tb = b->GetCreationTime().toMSecsSinceEpoch();
+      wpt->creation_time = a->GetCreationTime().addMSecs((qint64)(t * (tb - ta)));
+    } else {
+      wpt->creation_time = QDateTime();
+    }
+  }
+  wpt->wpt_flags.new_trkseg = start;
+  return wpt;
+}
+
+/* Where the line from a to b crosses the integer grid lines. */
+static void
+tile_crossings(double a, double b, QVector<double>& ts)
+{
+  double lo = qMin(a, b);
+  double hi = qMax(a, b);
+
+  for (double k = floor(lo) + 1; k < hi; k++) {
+    ts.append((k - a) / (b - a));
+  }
+}
+
+/*
+ * Walk the segment from a to b, one tile at a time.  Where it leaves a
+ * tile the current piece of track ends with a point on the edge, and
+ * where it enters one a new piece starts with a copy of that point.
+ */
+static void
+tile_segment(route_head* trk, const Waypoint* a, double ax, double ay,
+             const Waypoint* b, double bx, double by,
+             int* cx, int* cy, int* inside)
+{
+  QVector<double> ts;
+
+  ts.append(0);
+  tile_crossings(ax, bx, ts);
+  tile_crossings(ay, by, ts);
+  ts.append(1);
+  std::sort(ts.begin(), ts.end());
+
+  for (int i = 0; i + 1 < ts.size(); i++) {
+    double t0 = ts[i];
+    double tm = (t0 + ts[i + 1]) / 2;
+    int mx, my, in;
+
+    if (ts[i + 1] <= t0) {
+      continue;		/* a corner, crossed in x and y at once */
+    }
+    in = tile_cell(ax + (bx - ax) * tm, ay + (by - ay) * tm, &mx, &my);
+    if ((in == *inside) && (!in || ((mx == *cx) && (my == *cy)))) {
+      continue;
+    }
+    if (*inside && (t0 > 0)) {
+      tile_emit(trk, tile_point(a, ax, ay, b, bx, by, t0, 0), *cx, *cy);
+    }
+    if (in) {
+      tile_emit(trk, tile_point(a, ax, ay, b, bx, by, t0, 1), mx, my);
+    }
+    *cx = mx;
+    *cy = my;
+    *inside = in;
+  }
+}
+
+static void
+tile_track(const route_head* trk_c)
+{
+  route_head* trk = (route_head*) trk_c;
+  QList<Waypoint*> pts, dropped;
+  queue* elem, *tmp;
+  Waypoint* prev = NULL;
+  double px = 0, py = 0;
+  int cx = 0, cy = 0, inside = 0;
+
+  QUEUE_FOR_EACH(&trk->waypoint_list, elem, tmp) {
+    Waypoint* wpt = (Waypoint*) elem;
+    pts.append(wpt);
+    track_del_wpt(trk, wpt);
+  }
+
+  foreach (Waypoint* wpt, pts) {
+    double gx, gy;
+
+    tile_to_grid(wpt->latitude, wpt->longitude, &gx, &gy);
+    if ((prev == NULL) || wpt->wpt_flags.new_trkseg) {
+      inside = tile_cell(gx, gy, &cx, &cy);
+    } else {
+      tile_segment(trk, prev, px, py, wpt, gx, gy, &cx, &cy, &inside);
+    }
+    if (inside) {
+      tile_emit(trk, wpt, cx, cy);
+    } else {
+      dropped.append(wpt);	/* still needed as prev */
+    }
+    prev = wpt;
+    px = gx;
+    py = gy;
+  }
+
+  foreach (Waypoint* wpt, dropped) {
+    delete wpt;
+  }
+}
+
+static void
+tile_waypoint(const Waypoint* wpt)
+{
+  double gx, gy;
+  int cx, cy;
+
+  tile_to_grid(wpt->latitude, wpt->longitude, &gx, &gy);
+  if (!tile_cell(gx, gy, &cx, &cy)) {
+    waypt_del((Waypoint*) wpt);
+    delete wpt;
+  } else if (opt_file) {
+    tile_get(cx, cy)->wpts.append(new Waypoint(*wpt));
+  }
+}
+
+static QVector<route_head*> empty_tracks;
+
+static void
+tile_empty_cb(const route_head* trk)
+{
+  if (trk->rte_waypt_ct == 0) {
+    empty_tracks.append((route_head*) trk);
+  }
+}
+
+static QString
+tile_name(int cx, int cy)
+{
+  QString name(opt_file);
+
+  name.replace("%x", QString::number(cx));
+  name.replace("%y", QString::number(cy));
+  name.replace("%z", QString::number(zoom >= 0 ? zoom : 0));
+  return name;
+}
+
+/*
+ * Swap each tile in for the loaded data in turn and hand it to the
+ * writer, then put the data back.  The format may be the one given
+ * with -o (or a later -i), so its options are put back as well.
+ */
+static void
+tile_write(void)
+{
+  ff_vecs_t* vecs;
+  const char* opts;
+  vec_options_t* saved_opts;
+  queue* wpt_bak, *rte_bak, *trk_bak;
+  int wpt_ct, rte_ct, trk_ct;
+
+  saved_opts = vec_options_save(opt_format);
+  vecs = find_vec(opt_format, &opts);
+  if (vecs == NULL) {
+    fatal(MYNAME ": Unknown format \"%s\".\n", opt_format);
+  }
+  if (vecs->wr_init == NULL) {
+    fatal(MYNAME ": Format \"%s\" does not support writing.\n", opt_format);
+  }
+
+  waypt_backup(&wpt_ct, &wpt_bak);
+  route_backup(&rte_ct, &rte_bak);
+  track_backup(&trk_ct, &trk_bak);
+  waypt_flush_all();
+  route_flush_all();
+
+  for (QMap<qint64, tile_t*>::const_iterator it = tiles.constBegin(); it != tiles.constEnd(); ++it) {
+    tile_t* tile = it.value();
+    int cx = it.key() % grid_cols;
+    int cy = it.key() / grid_cols;
+
+    foreach (Waypoint* wpt, tile->wpts) {
+      waypt_add(wpt);
+    }
+    for (int i = 0; i < tile->trks.size(); i++) {
+      track_add_head(tile->trks[i]);
+      foreach (Waypoint* wpt, tile->trk_pts[i]) {
+        track_add_wpt(tile->trks[i], wpt);
+      }
+    }
+
+    traits_invalidate();
+    cache_invalidate();
+    cet_convert_init(vecs->encode, vecs->fixed_encode);
+    vecs->wr_init(qPrintable(tile_name(cx, cy)));
+    vecs->write();
+    vecs->wr_deinit();
+    cet_convert_deinit();
+
+    waypt_flush_all();
+    route_flush_all_tracks();
+    delete tile;
+  }
+  tiles.clear();
+  vec_options_restore(saved_opts);
+
+  waypt_restore(wpt_ct, wpt_bak);
+  route_restore(rte_bak);
+  xfree(rte_bak);
+  track_restore(trk_bak);
+  xfree(trk_bak);
+  traits_invalidate();
+  cache_invalidate();
+}
+
+static void
+tile_process(void)
+{
+  waypt_disp_all(tile_waypoint);
+  track_disp_all(tile_track, NULL, NULL);
+
+  if (opt_file) {
+    tile_write();
+  }
+
+  empty_tracks.clear();
+  track_disp_all(tile_empty_cb, NULL, NULL);
+  foreach (route_head* trk, empty_tracks) {
+    track_del_head(trk);
+  }
+  empty_tracks.clear();
+}
+
+static void
+tile_init(const char* args)
+{
+  double lat0 = -90, lon0 = -180, lat1 = 90, lon1 = 180;
+
+  if (opt_grid && opt_zoom) {
+    fatal(MYNAME ": Use either grid or zoom, not both.\n");
+  }
+  if (opt_bbox) {
+    if (opt_zoom) {
+      fatal(MYNAME ": bbox can't be used with zoom.\n");
+    }
+    if ((sscanf(opt_bbox, "%lf:%lf:%lf:%lf", &lat0, &lon0, &lat1, &lon1) != 4) ||
+        (lat0 >= lat1) || (lon0 >= lon1)) {
+      fatal(MYNAME ": bbox must be minlat:minlon:maxlat:maxlon.\n");
+    }
+  } else if (!opt_grid && !opt_zoom) {
+    fatal(MYNAME ": One of grid, zoom or bbox is required.\n");
+  }
+  if (opt_file && (!strstr(opt_file, "%x") || !strstr(opt_file, "%y"))) {
+    fatal(MYNAME ": The file name needs both %%x and %%y.\n");
+  }
+
+  if (opt_zoom) {
+    zoom = atoi(opt_zoom);
+    if ((zoom < 0) || (zoom > 24)) {
+      fatal(MYNAME ": zoom must be from 0 to 24.\n");
+    }
+    grid_cols = grid_rows = 1 << zoom;
+    return;
+  }
+
+  /*
+   * A whole number of tiles fills the box, so they are stretched a
+   * little where the size doesn't divide it evenly.
+   */
+  zoom = -1;
+  grid_lat0 = lat0;
+  grid_lon0 = lon0;
+  grid_cols = grid_rows = 1;
+  if (opt_grid) {
+    double size = atof(opt_grid);
+    if (size <= 0) {
+      fatal(MYNAME ": The grid size must be positive.\n");
+    }
+    grid_cols = qMax(1, (int) floor((lon1 - lon0) / size + 0.5));
+    grid_rows = qMax(1, (int) floor((lat1 - lat0) / size + 0.5));
+  }
+  grid_dlon = (lon1 - lon0) / grid_cols;
+  grid_dlat = (lat1 - lat0) / grid_rows;
+}
+
+filter_vecs_t tile_vecs = {
+  tile_init,
+  tile_process,
+  NULL,
+  NULL,
+  tile_args
+};
+#endif // FILTERS_ENABLED
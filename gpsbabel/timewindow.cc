@@ -0,0 +1,257 @@
+/*
+    Time window filter: keep the track points inside a list of time windows.
+
+    Copyright (C) 2002-2014 Robert Lipe, robertlipe+source@gpsbabel.org
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111 USA
+
+ */
+
+#include "defs.h"
+#include "filterdefs.h"
+#include <QtCore/QRegExp>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+#include <algorithm>
+
+#if FILTERS_ENABLED
+#define MYNAME "timewindow"
+
+static char* opt_file = NULL;
+static char* opt_pad = NULL;
+static char* opt_nearest = NULL;
+
+static
+arglist_t timewindow_args[] = {
+  {
+    "file", &opt_file, "File of time windows, one per line",
+    NULL, ARGTYPE_FILE | ARGTYPE_REQUIRED, ARG_NOMINMAX
+  },
+  {
+    "pad", &opt_pad, "Seconds to widen each window by on either side",
+    "0", ARGTYPE_FLOAT, ARG_NOMINMAX
+  },
+  {
+    "nearest", &opt_nearest, "Keep only the point nearest each window's middle",
+    NULL, ARGTYPE_BOOL, ARG_NOMINMAX
+  },
+  ARG_TERMINATOR
+};
+
+typedef struct {
+  qint64 start;			/* milliseconds since the epoch */
+  qint64 stop;
+} timewindow_t;
+
+static QVector<timewindow_t> windows;
+static qint64 pad;			/* milliseconds */
+static QVector<route_head*> tracks;
+static QVector<QVector<char> > keep;	/* per track, per time index point */
+
+static bool
+timewindow_lt(const timewindow_t& a, const timewindow_t& b)
+{
+  return (a.start < b.start) || ((a.start == b.start) && (a.stop < b.stop));
+}
+
+/*
+ * Each line holds a time, or a start and a stop time, in ISO 8601
+ * form and separated by blanks or a comma.  '#' starts a comment.
+ */
+static void
+timewindow_read(void)
+{
+  gbfile* fin;
+  char* line;
+  int lineno = 0;
+
+  pad = opt_pad ? (qint64)(atof(opt_pad) * 1000) : 0;
+  if (pad < 0) {
+    fatal(MYNAME ": The pad must not be negative.\n");
+  }
+
+  windows.clear();
+  fin = gbfopen(opt_file, "r", MYNAME);
+  while ((line = gbfgetstr(fin))) {
+    char* pound = strchr(line, '#');
+    if (pound) {
+      *pound = '\0';
+    }
+    lineno++;
+
+    QStringList fields = QString(line).split(QRegExp("[\\s,]+"), QString::SkipEmptyParts);
+    if (fields.isEmpty()) {
+      continue;
+    }
+    if (fields.size() > 2) {
+      warning(MYNAME ": Skipping line %d, more than two times.\n", lineno);
+      continue;
+    }
+
+    QDateTime start = xml_parse_time(fields.first());
+    QDateTime stop = xml_parse_time(fields.last());
+    if (!start.isValid() || !stop.isValid()) {
+      warning(MYNAME ": Skipping line %d, bad time.\n", lineno);
+      continue;
+    }
+
+    timewindow_t w;
+    w.start = start.toMSecsSinceEpoch();
+    w.stop = stop.toMSecsSinceEpoch();
+    if (w.stop < w.start) {
+      qSwap(w.start, w.stop);
+    }
+    windows.append(w);
+  }
+  gbfclose(fin);
+}
+
+static void
+timewindow_track_cb(const route_head* trk)
+{
+  tracks.append((route_head*) trk);
+}
+
+/*
+ * Pad the windows and merge the ones that overlap, so no point is
+ * marked more than once however much the windows do.
+ */
+static void
+timewindow_merge(void)
+{
+  int i, n = 0;
+
+  for (i = 0; i < windows.size(); i++) {
+    windows[i].start -= pad;
+    windows[i].stop += pad;
+  }
+  std::sort(windows.begin(), windows.end(), timewindow_lt);
+  for (i = 0; i < windows.size(); i++) {
+    if (n && (windows[i].start <= windows[n - 1].stop)) {
+      windows[n - 1].stop = qMax(windows[n - 1].stop, windows[i].stop);
+    } else {
+      windows[n++] = windows[i];
+    }
+  }
+  windows.resize(n);
+}
+
+static void
+timewindow_mark(const time_tree& tree)
+{
+  QVector<int> found;
+
+  if (opt_nearest) {
+    foreach (const timewindow_t& w, windows) {
+      qint64 mid = w.start + (w.stop - w.start) / 2;
+      int e, p;
+      if (tree.nearest(mid, &e, &p)) {
+        qint64 t = tree.index(e)->time[p];
+        if ((t >= w.start - pad) && (t <= w.stop + pad)) {
+          keep[e][p] = 1;
+        }
+      }
+    }
+    return;
+  }
+
+  timewindow_merge();
+  foreach (const timewindow_t& w, windows) {
+    tree.overlapping(w.start, w.stop, found);
+    foreach (int e, found) {
+      const time_index* idx = tree.index(e);
+      int last = idx->upper_bound(w.stop);
+      for (int p = idx->lower_bound(w.start); p < last; p++) {
+        keep[e][p] = 1;
+      }
+    }
+  }
+}
+
+static void
+timewindow_trim(route_head* trk, int i)
+{
+  /* a copy, as deleting points lets the index go stale */
+  QVector<const Waypoint*> pts = route_time_index(trk)->wpt;
+  queue* elem, *tmp;
+
+  /* Points without a time can't be in any window. */
+  QUEUE_FOR_EACH(&trk->waypoint_list, elem, tmp) {
+    Waypoint* wpt = (Waypoint*) elem;
+    if (!wpt->GetCreationTime().isValid()) {
+      track_del_wpt(trk, wpt);
+      delete wpt;
+    }
+  }
+  for (int p = 0; p < pts.size(); p++) {
+    if (!keep[i][p]) {
+      Waypoint* wpt = (Waypoint*) pts[p];
+      track_del_wpt(trk, wpt);
+      delete wpt;
+    }
+  }
+}
+
+static void
+timewindow_drop_empty(route_head* trk, int)
+{
+  if (trk->rte_waypt_ct == 0) {
+    track_del_head(trk);
+  }
+}
+
+static void
+timewindow_process(void)
+{
+  time_tree tree;
+  int i;
+
+  tracks.clear();
+  track_disp_all(timewindow_track_cb, NULL, NULL);
+
+  keep.resize(tracks.size());
+  for (i = 0; i < tracks.size(); i++) {
+    tree.add(tracks[i]);
+    keep[i].fill(0, tree.index(i)->size());
+  }
+  tree.build();
+
+  timewindow_mark(tree);
+  route_parallel(tracks.constData(), tracks.size(), timewindow_trim, timewindow_drop_empty);
+
+  tracks.clear();
+  keep.clear();
+}
+
+static void
+timewindow_init(const char* args)
+{
+  timewindow_read();
+}
+
+static void
+timewindow_deinit(void)
+{
+  windows.clear();
+}
+
+filter_vecs_t timewindow_vecs = {
+  timewindow_init,
+  timewindow_process,
+  timewindow_deinit,
+  NULL,
+  timewindow_args
+};
+#endif // FILTERS_ENABLED
@@ -0,0 +1,2009 @@
+/*
+    Pseudo-terminal GPS receiver emulator.
+
+    Creates a pty and speaks the Garmin serial link protocol
+    (L001/A010), a stream of NMEA 0183 sentences, the MTK logger's
+    PMTK182 download protocol or the SkyTraq Venus binary protocol on
+    it, so the serial code paths of the garmin, nmea, mtk and skytraq
+    formats can be exercised and timed without hardware.   Point
+    gpsbabel at the slave name printed on stdout.
+
+    Copyright (C) 2015 Robert Lipe, robertlipe+source@gpsbabel.org
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111 USA
+
+ */
+
+/*
+ * This is a test tool, not part of gpsbabel proper.  It deliberately
+ * shares no code with jeeps so that it is an independent check of the
+ * link layer.  POSIX only.
+ *
+ * Build:   make gpsemu
+ * Use:     ./gpsemu -w 500 -t 10000 garmin &
+ *          gpsbabel -t -i garmin -f /dev/pts/N -o gpx -F out.gpx
+ *
+ * A device profile is a text file of "key value" lines; see usage().
+ */
+
+#define _XOPEN_SOURCE 600
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MYNAME "gpsemu"
+
+/* Garmin link layer, L000/L001 and A010 */
+#define DLE 0x10
+#define ETX 0x03
+
+#define Pid_Ack_Byte 6
+#define Pid_Command_Data 10
+#define Pid_Xfer_Cmplt 12
+#define Pid_Date_Time_Data 14
+#define Pid_Position_Data 17
+#define Pid_Nak_Byte 21
+#define Pid_Records 27
+#define Pid_Rte_Hdr 29
+#define Pid_Rte_Wpt_Data 30
+#define Pid_Trk_Data 34
+#define Pid_Wpt_Data 35
+#define Pid_Pvt_Data 51
+#define Pid_Rte_Link_Data 98
+#define Pid_Trk_Hdr 99
+#define Pid_Protocol_Array 253
+#define Pid_Product_Rqst 254
+#define Pid_Product_Data 255
+
+#define Cmnd_Abort_Transfer 0
+#define Cmnd_Transfer_Posn 2
+#define Cmnd_Transfer_Rte 4
+#define Cmnd_Transfer_Time 5
+#define Cmnd_Transfer_Trk 6
+#define Cmnd_Transfer_Wpt 7
+#define Cmnd_Turn_Off_Pwr 8
+#define Cmnd_Start_Pvt_Data 49
+#define Cmnd_Stop_Pvt_Data 50
+
+#define MAX_PACKET 255
+#define ACK_TIMEOUT 2000	/* ms to wait for the host to acknowledge */
+#define ACK_RETRIES 3
+
+/* Garmin time zero is 1989-12-31 00:00:00 UTC */
+#define GARMIN_EPOCH 631065600
+#define LEAP_SECONDS 17
+
+#define MAX_PROTOCOLS 64
+
+typedef struct {
+  int product;
+  int version;
+  char description[128];
+  int nprotocols;
+  char ptag[MAX_PROTOCOLS];
+  int pnum[MAX_PROTOCOLS];
+
+  int waypoints;
+  int routes;
+  int routepoints;
+  int tracks;
+  int trackpoints;
+
+  double latitude;
+  double longitude;
+  time_t start;		/* device clock at first fix / first trackpoint */
+  double rate;		/* fixes per second, 0 for as fast as possible */
+  long fixes;		/* NMEA fixes per session, 0 for no limit */
+
+  char image[1024];	/* MTK flash contents, empty for an erased log */
+  int latency;		/* ms before an MTK reply goes out */
+  int reorder;		/* MTK read replies sent in reversed groups of this */
+  int drop;		/* leave every n'th MTK read request unanswered */
+  int corrupt;		/* damage every n'th MTK data sentence */
+  int sectors;		/* SkyTraq sectors of the image written so far, 0 for all */
+
+  /* Derived from the protocol array */
+  int wpt_type;
+  int rte_proto;
+  int rte_hdr_type;
+  int rte_wpt_type;
+  int rte_link_type;
+  int trk_hdr_type;
+  int trk_type;
+  int has_time;
+  int has_posn;
+  int has_pvt;
+} profile_t;
+
+typedef struct {
+  unsigned long packets_out;
+  unsigned long packets_in;
+  unsigned long bytes_out;
+  unsigned long bytes_in;
+  unsigned long retries;
+} counters_t;
+
+static profile_t prof;
+static counters_t ctr;
+static int master = -1;
+static const char* link_name;
+static int quiet;
+static volatile sig_atomic_t stop;
+
+/* Receive side of the framer */
+static unsigned char rxbuf[4096];
+static int rxhead, rxtail;
+
+typedef struct {
+  int id;
+  int n;
+  unsigned char data[MAX_PACKET];
+} packet_t;
+
+static void
+fatal(const char* fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  fprintf(stderr, MYNAME ": ");
+  vfprintf(stderr, fmt, ap);
+  va_end(ap);
+  if (link_name) {
+    unlink(link_name);
+  }
+  exit(1);
+}
+
+static void
+note(const char* fmt, ...)
+{
+  va_list ap;
+
+  if (quiet) {
+    return;
+  }
+  va_start(ap, fmt);
+  fprintf(stderr, MYNAME ": ");
+  vfprintf(stderr, fmt, ap);
+  va_end(ap);
+}
+
+static double
+now(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void
+on_signal(int)
+{
+  stop = 1;
+}
+
+/*
+ * Profile handling
+ */
+
+static void
+profile_defaults(profile_t* p)
+{
+  memset(p, 0, sizeof(*p));
+  p->product = 411;
+  p->version = 360;
+  strcpy(p->description, "eTrex Legend Software Version 3.60");
+  p->waypoints = 100;
+  p->routes = 2;
+  p->routepoints = 10;
+  p->tracks = 1;
+  p->trackpoints = 1000;
+  p->latitude = 35.9728;
+  p->longitude = -87.1341;
+  p->start = 1420070400;	/* 2015-01-01 00:00:00 */
+  p->rate = 1;
+}
+
+static void
+profile_set_protocols(profile_t* p, const char* s)
+{
+  p->nprotocols = 0;
+  while (*s) {
+    char tag;
+    int num;
+    int used;
+
+    while (*s == ' ' || *s == '\t' || *s == ',') {
+      s++;
+    }
+    if (!*s) {
+      break;
+    }
+    if (sscanf(s, "%c%d%n", &tag, &num, &used) != 2 ||
+        !strchr("PLAD", tag)) {
+      fatal("bad protocol entry near '%s'\n", s);
+    }
+    if (p->nprotocols == MAX_PROTOCOLS) {
+      fatal("too many protocols\n");
+    }
+    p->ptag[p->nprotocols] = tag;
+    p->pnum[p->nprotocols] = num;
+    p->nprotocols++;
+    s += used;
+  }
+}
+
+/*
+ * Work out the data types the way a host does from the A001 array: each
+ * A protocol is followed by the D types it uses.
+ */
+static void
+profile_derive(profile_t* p)
+{
+  int i;
+
+  p->wpt_type = p->rte_proto = p->rte_hdr_type = p->rte_wpt_type = 0;
+  p->rte_link_type = p->trk_hdr_type = p->trk_type = 0;
+  p->has_time = p->has_posn = p->has_pvt = 0;
+
+  for (i = 0; i < p->nprotocols; i++) {
+    int d0 = (i + 1 < p->nprotocols && p->ptag[i + 1] == 'D') ? p->pnum[i + 1] : 0;
+    int d1 = (i + 2 < p->nprotocols && p->ptag[i + 2] == 'D') ? p->pnum[i + 2] : 0;
+    int d2 = (i + 3 < p->nprotocols && p->ptag[i + 3] == 'D') ? p->pnum[i + 3] : 0;
+
+    if (p->ptag[i] != 'A') {
+      continue;
+    }
+    switch (p->pnum[i]) {
+    case 100:
+      p->wpt_type = d0;
+      break;
+    case 200:
+      p->rte_proto = 200;
+      p->rte_hdr_type = d0;
+      p->rte_wpt_type = d1;
+      break;
+    case 201:
+      p->rte_proto = 201;
+      p->rte_hdr_type = d0;
+      p->rte_wpt_type = d1;
+      p->rte_link_type = d2;
+      break;
+    case 301:
+      p->trk_hdr_type = d0;
+      p->trk_type = d1;
+      break;
+    case 600:
+      p->has_time = 1;
+      break;
+    case 700:
+      p->has_posn = 1;
+      break;
+    case 800:
+      p->has_pvt = 1;
+      break;
+    }
+  }
+
+  switch (p->wpt_type) {
+  case 0:
+  case 100:
+  case 108:
+  case 109:
+    break;
+  default:
+    fatal("waypoint type D%d is not emulated\n", p->wpt_type);
+  }
+  if (p->rte_wpt_type && p->rte_wpt_type != p->wpt_type) {
+    fatal("route waypoint type must match the A100 waypoint type\n");
+  }
+  switch (p->rte_hdr_type) {
+  case 0:
+  case 200:
+  case 201:
+  case 202:
+    break;
+  default:
+    fatal("route header type D%d is not emulated\n", p->rte_hdr_type);
+  }
+  if (p->rte_link_type && p->rte_link_type != 210) {
+    fatal("route link type D%d is not emulated\n", p->rte_link_type);
+  }
+  if (p->trk_hdr_type && p->trk_hdr_type != 310 && p->trk_hdr_type != 312) {
+    fatal("track header type D%d is not emulated\n", p->trk_hdr_type);
+  }
+  if (p->trk_type && p->trk_type != 300 && p->trk_type != 301) {
+    fatal("track type D%d is not emulated\n", p->trk_type);
+  }
+}
+
+static void
+profile_read(profile_t* p, const char* fname)
+{
+  char line[1024];
+  int lineno = 0;
+  FILE* f = fopen(fname, "r");
+
+  if (!f) {
+    fatal("cannot open profile '%s': %s\n", fname, strerror(errno));
+  }
+  while (fgets(line, sizeof(line), f)) {
+    char* key;
+    char* val;
+    char* e;
+
+    lineno++;
+    if ((e = strchr(line, '#'))) {
+      *e = 0;
+    }
+    for (e = line + strlen(line); e > line && strchr(" \t\r\n", e[-1]); e--) {
+      e[-1] = 0;
+    }
+    key = line + strspn(line, " \t");
+    if (!*key) {
+      continue;
+    }
+    val = key + strcspn(key, " \t=");
+    if (*val) {
+      *val++ = 0;
+    }
+    val += strspn(val, " \t=");
+
+    if (!strcmp(key, "product")) {
+      p->product = atoi(val);
+    } else if (!strcmp(key, "version")) {
+      p->version = atoi(val);
+    } else if (!strcmp(key, "description")) {
+      snprintf(p->description, sizeof(p->description), "%s", val);
+    } else if (!strcmp(key, "protocols")) {
+      profile_set_protocols(p, val);
+    } else if (!strcmp(key, "waypoints")) {
+      p->waypoints = atoi(val);
+    } else if (!strcmp(key, "routes")) {
+      p->routes = atoi(val);
+    } else if (!strcmp(key, "routepoints")) {
+      p->routepoints = atoi(val);
+    } else if (!strcmp(key, "tracks")) {
+      p->tracks = atoi(val);
+    } else if (!strcmp(key, "trackpoints")) {
+      p->trackpoints = atoi(val);
+    } else if (!strcmp(key, "latitude")) {
+      p->latitude = atof(val);
+    } else if (!strcmp(key, "longitude")) {
+      p->longitude = atof(val);
+    } else if (!strcmp(key, "start")) {
+      p->start = strtol(val, NULL, 10);
+    } else if (!strcmp(key, "rate")) {
+      p->rate = atof(val);
+    } else if (!strcmp(key, "fixes")) {
+      p->fixes = atol(val);
+    } else if (!strcmp(key, "image")) {
+      snprintf(p->image, sizeof(p->image), "%s", val);
+    } else if (!strcmp(key, "latency")) {
+      p->latency = atoi(val);
+    } else if (!strcmp(key, "reorder")) {
+      p->reorder = atoi(val);
+    } else if (!strcmp(key, "drop")) {
+      p->drop = atoi(val);
+    } else if (!strcmp(key, "corrupt")) {
+      p->corrupt = atoi(val);
+    } else if (!strcmp(key, "sectors")) {
+      p->sectors = atoi(val);
+    } else {
+      fatal("%s:%d: unknown key '%s'\n", fname, lineno, key);
+    }
+  }
+  fclose(f);
+}
+
+/*
+ * Scripted device content.   Everything is a pure function of the index
+ * so that a transfer can be checked on the host side.
+ */
+
+static void
+waypoint_pos(int i, double* lat, double* lon)
+{
+  *lat = prof.latitude + (i / 100) * 0.001;
+  *lon = prof.longitude + (i % 100) * 0.001;
+}
+
+static void
+fix_pos(long i, double* lat, double* lon, double* alt)
+{
+  /* A slow northeasterly walk: about 5 m/s. */
+  *lat = prof.latitude + i * 0.00003;
+  *lon = prof.longitude + i * 0.00004;
+  *alt = 100.0 + (i % 200) * 0.5;
+}
+
+/*
+ * Flash of size bytes, erased (0xFF) except for the profile's image at
+ * the start.  *used is set to the length of the image.
+ */
+static unsigned char*
+image_load(unsigned long size, unsigned long* used)
+{
+  unsigned char* flash = (unsigned char*) malloc(size);
+
+  if (!flash) {
+    fatal("out of memory\n");
+  }
+  memset(flash, 0xff, size);
+  *used = 0;
+  if (prof.image[0]) {
+    FILE* f = fopen(prof.image, "rb");
+    if (!f) {
+      fatal("cannot open image '%s': %s\n", prof.image, strerror(errno));
+    }
+    *used = fread(flash, 1, size, f);
+    fclose(f);
+  }
+  return flash;
+}
+
+/*
+ * pty plumbing
+ */
+
+static void
+open_pty(void)
+{
+  struct termios tty;
+  const char* slave;
+
+  if ((master = posix_openpt(O_RDWR | O_NOCTTY)) < 0 ||
+      grantpt(master) < 0 || unlockpt(master) < 0 ||
+      !(slave = ptsname(master))) {
+    fatal("cannot create pty: %s\n", strerror(errno));
+  }
+
+  /*
+   * Raw from the start so nothing is echoed or mangled before the
+   * host has configured the line itself.
+   */
+  if (tcgetattr(master, &tty) == 0) {
+    tty.c_iflag = 0;
+    tty.c_oflag = 0;
+    tty.c_lflag = 0;
+    tty.c_cflag = (tty.c_cflag & ~CSIZE) | CS8 | CREAD | CLOCAL;
+    tty.c_cc[VMIN] = 1;
+    tty.c_cc[VTIME] = 0;
+    tcsetattr(master, TCSANOW, &tty);
+  }
+  fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+  if (link_name) {
+    unlink(link_name);
+    if (symlink(slave, link_name) < 0) {
+      fatal("cannot link %s to %s: %s\n", link_name, slave, strerror(errno));
+    }
+  }
+  printf("%s\n", slave);
+  fflush(stdout);
+}
+
+/*
+ * Nobody has the slave open while the master reports a hangup.  Every
+ * open of the slave by the host therefore starts a session.
+ */
+static int
+wait_for_host(void)
+{
+  while (!stop) {
+    struct pollfd pfd = { master, POLLIN, 0 };
+    if (poll(&pfd, 1, 50) < 0 && errno != EINTR) {
+      fatal("poll: %s\n", strerror(errno));
+    }
+    if (!(pfd.revents & POLLHUP)) {
+      return 1;
+    }
+    usleep(20000);
+  }
+  return 0;
+}
+
+static int
+write_all(const unsigned char* buf, int len)
+{
+  while (len > 0) {
+    struct pollfd pfd = { master, POLLOUT, 0 };
+    ssize_t n;
+
+    if (stop) {
+      return 0;
+    }
+    if (poll(&pfd, 1, 1000) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return 0;
+    }
+    if (pfd.revents & POLLHUP) {
+      return 0;
+    }
+    if (!(pfd.revents & POLLOUT)) {
+      continue;
+    }
+    n = write(master, buf, len);
+    if (n < 0) {
+      if (errno == EAGAIN || errno == EINTR) {
+        continue;
+      }
+      return 0;
+    }
+    buf += n;
+    len -= n;
+  }
+  return 1;
+}
+
+/* Returns a byte, -1 on timeout or -2 when the host went away. */
+static int
+read_byte(int msec)
+{
+  if (rxhead == rxtail) {
+    struct pollfd pfd = { master, POLLIN, 0 };
+    ssize_t n;
+
+    rxhead = rxtail = 0;
+    if (poll(&pfd, 1, msec) <= 0) {
+      return stop ? -2 : -1;
+    }
+    if (!(pfd.revents & POLLIN)) {
+      return (pfd.revents & POLLHUP) ? -2 : -1;
+    }
+    n = read(master, rxbuf, sizeof(rxbuf));
+    if (n <= 0) {
+      return (n < 0 && errno == EAGAIN) ? -1 : -2;
+    }
+    rxtail = n;
+    ctr.bytes_in += n;
+  }
+  return rxbuf[rxhead++];
+}
+
+/*
+ * Garmin link layer
+ */
+
+static void
+put16(unsigned char* p, unsigned v)
+{
+  p[0] = v & 0xff;
+  p[1] = (v >> 8) & 0xff;
+}
+
+static void
+put32(unsigned char* p, unsigned long v)
+{
+  put16(p, v & 0xffff);
+  put16(p + 2, (v >> 16) & 0xffff);
+}
+
+static void
+putf(unsigned char* p, float f)
+{
+  unsigned int u;
+  memcpy(&u, &f, sizeof(u));
+  put32(p, u);
+}
+
+static void
+putd(unsigned char* p, double d)
+{
+  unsigned long long u;
+  memcpy(&u, &d, sizeof(u));
+  put32(p, (unsigned long)(u & 0xffffffffUL));
+  put32(p + 4, (unsigned long)(u >> 32));
+}
+
+static long
+semicircles(double deg)
+{
+  return (long) floor(deg * 2147483648.0 / 180.0 + 0.5);
+}
+
+static int
+send_packet(int id, const unsigned char* data, int n)
+{
+  unsigned char frame[2 * MAX_PACKET + 16];
+  unsigned char chk;
+  int len = 0;
+  int i;
+
+  chk = -(id + n);
+  frame[len++] = DLE;
+  frame[len++] = id;
+  frame[len++] = n;
+  if (n == DLE) {
+    frame[len++] = DLE;
+  }
+  for (i = 0; i < n; i++) {
+    frame[len++] = data[i];
+    if (data[i] == DLE) {
+      frame[len++] = DLE;
+    }
+    chk -= data[i];
+  }
+  frame[len++] = chk;
+  if (chk == DLE) {
+    frame[len++] = DLE;
+  }
+  frame[len++] = DLE;
+  frame[len++] = ETX;
+
+  ctr.packets_out++;
+  ctr.bytes_out += len;
+  return write_all(frame, len);
+}
+
+/*
+ * Read one packet.  Returns 1 on success, 0 on timeout or a framing
+ * error (the caller NAKs or retries) and -1 when the host went away.
+ */
+static int
+recv_packet(packet_t* pkt, int msec)
+{
+  enum { S_DLE, S_ID, S_DATA, S_DATA_DLE } state = S_DLE;
+  unsigned char raw[MAX_PACKET + 4];
+  int len = 0;
+  int c;
+  int i;
+  unsigned char sum;
+
+  for (;;) {
+    c = read_byte(msec);
+    if (c == -2) {
+      return -1;
+    }
+    if (c == -1) {
+      return 0;
+    }
+    switch (state) {
+    case S_DLE:
+      if (c == DLE) {
+        state = S_ID;
+      }
+      break;
+    case S_ID:
+      if (c == DLE || c == ETX) {
+        state = S_DLE;
+        break;
+      }
+      raw[len++] = c;
+      state = S_DATA;
+      break;
+    case S_DATA:
+      if (c == DLE) {
+        state = S_DATA_DLE;
+        break;
+      }
+      if (len == (int) sizeof(raw)) {
+        return 0;
+      }
+      raw[len++] = c;
+      break;
+    case S_DATA_DLE:
+      if (c == DLE) {
+        if (len == (int) sizeof(raw)) {
+          return 0;
+        }
+        raw[len++] = c;
+        state = S_DATA;
+        break;
+      }
+      if (c != ETX) {
+        return 0;
+      }
+      /* raw is id, size, data..., checksum */
+      if (len < 3 || raw[1] != len - 3) {
+        return 0;
+      }
+      for (sum = 0, i = 0; i < len; i++) {
+        sum += raw[i];
+      }
+      if (sum != 0) {
+        return 0;
+      }
+      pkt->id = raw[0];
+      pkt->n = raw[1];
+      memcpy(pkt->data, raw + 2, pkt->n);
+      ctr.packets_in++;
+      return 1;
+    }
+  }
+}
+
+static int
+send_ack(int pid, int id)
+{
+  unsigned char d[2];
+  put16(d, id);
+  return send_packet(pid, d, 2);
+}
+
+/*
+ * Send a packet and wait for the host to acknowledge it, retransmitting
+ * on NAK or timeout like a real unit does.  Returns 1 when acknowledged,
+ * 0 when the transfer should be abandoned.
+ */
+static int
+send_reliable(int id, const unsigned char* data, int n)
+{
+  int tries;
+
+  for (tries = 0; tries < ACK_RETRIES; tries++) {
+    packet_t pkt;
+    int r;
+
+    if (tries) {
+      ctr.retries++;
+    }
+    if (!send_packet(id, data, n)) {
+      return 0;
+    }
+    r = recv_packet(&pkt, ACK_TIMEOUT);
+    if (r < 0) {
+      return 0;
+    }
+    if (r == 0 || pkt.id == Pid_Nak_Byte) {
+      continue;
+    }
+    if (pkt.id == Pid_Ack_Byte && pkt.data[0] == id) {
+      return 1;
+    }
+    /* Anything else from the host in mid-transfer is an abort. */
+    if (pkt.id != Pid_Ack_Byte) {
+      send_ack(Pid_Ack_Byte, pkt.id);
+      return 0;
+    }
+  }
+  return 0;
+}
+
+static int
+send_records(int n)
+{
+  unsigned char d[2];
+  put16(d, n);
+  return send_reliable(Pid_Records, d, 2);
+}
+
+static int
+send_xfer_cmplt(int cmd)
+{
+  unsigned char d[2];
+  put16(d, cmd);
+  return send_reliable(Pid_Xfer_Cmplt, d, 2);
+}
+
+static int
+put_string(unsigned char* p, const char* s)
+{
+  int n = strlen(s) + 1;
+  memcpy(p, s, n);
+  return n;
+}
+
+static int
+build_waypoint(unsigned char* d, int i)
+{
+  char ident[16];
+  char cmnt[48];
+  double lat, lon;
+  unsigned char* p = d;
+
+  waypoint_pos(i, &lat, &lon);
+  snprintf(ident, sizeof(ident), "W%05d", i);
+  snprintf(cmnt, sizeof(cmnt), "EMULATED WAYPOINT %d", i);
+
+  switch (prof.wpt_type) {
+  case 100:
+    memcpy(p, ident, 6);
+    p += 6;
+    put32(p, semicircles(lat));
+    p += 4;
+    put32(p, semicircles(lon));
+    p += 4;
+    put32(p, 0);
+    p += 4;
+    memset(p, ' ', 40);
+    memcpy(p, cmnt, strlen(cmnt));
+    p += 40;
+    break;
+  case 108:
+  case 109:
+    if (prof.wpt_type == 109) {
+      *p++ = 0x01;		/* dtyp */
+      *p++ = 0;		/* wpt_class: user */
+      *p++ = 0x1f | (0 << 5);	/* default colour, dspl symbol+name */
+      *p++ = 0x70;		/* attr */
+    } else {
+      *p++ = 0;		/* wpt_class: user */
+      *p++ = 0xff;		/* default colour */
+      *p++ = 0;		/* dspl */
+      *p++ = 0x60;		/* attr */
+    }
+    put16(p, 18);		/* smbl: sym_wpt_dot */
+    p += 2;
+    memset(p, 0xff, 18);	/* subclass */
+    p += 18;
+    put32(p, semicircles(lat));
+    p += 4;
+    put32(p, semicircles(lon));
+    p += 4;
+    putf(p, 100.0f + (i % 50));	/* alt */
+    p += 4;
+    putf(p, 1.0e25f);		/* dpth: unknown */
+    p += 4;
+    putf(p, 0.0f);		/* dist */
+    p += 4;
+    memcpy(p, "    ", 4);	/* state, cc */
+    p += 4;
+    if (prof.wpt_type == 109) {
+      put32(p, 0xffffffffUL);	/* ete */
+      p += 4;
+    }
+    p += put_string(p, ident);
+    p += put_string(p, cmnt);
+    p += put_string(p, "");	/* facility */
+    p += put_string(p, "");	/* city */
+    p += put_string(p, "");	/* addr */
+    p += put_string(p, "");	/* cross_road */
+    break;
+  }
+  return p - d;
+}
+
+static int
+transfer_waypoints(void)
+{
+  unsigned char d[MAX_PACKET];
+  int i;
+
+  if (!prof.wpt_type) {
+    return send_records(0) && send_xfer_cmplt(Cmnd_Transfer_Wpt);
+  }
+  if (!send_records(prof.waypoints)) {
+    return 0;
+  }
+  for (i = 0; i < prof.waypoints; i++) {
+    if (!send_reliable(Pid_Wpt_Data, d, build_waypoint(d, i))) {
+      return 0;
+    }
+  }
+  note("sent %d waypoints\n", prof.waypoints);
+  return send_xfer_cmplt(Cmnd_Transfer_Wpt);
+}
+
+static int
+transfer_routes(void)
+{
+  unsigned char d[MAX_PACKET];
+  int per_route;
+  int r, i;
+  int n;
+
+  if (!prof.rte_proto) {
+    return send_records(0) && send_xfer_cmplt(Cmnd_Transfer_Rte);
+  }
+
+  per_route = 1 + prof.routepoints;
+  if (prof.rte_proto == 201 && prof.routepoints > 1) {
+    per_route += prof.routepoints - 1;
+  }
+  if (!send_records(prof.routes * per_route)) {
+    return 0;
+  }
+
+  for (r = 0; r < prof.routes; r++) {
+    unsigned char* p = d;
+    char name[24];
+
+    snprintf(name, sizeof(name), "ROUTE %d", r + 1);
+    switch (prof.rte_hdr_type) {
+    case 200:
+      *p++ = r + 1;
+      break;
+    case 201:
+      *p++ = r + 1;
+      memset(p, ' ', 20);
+      memcpy(p, name, strlen(name));
+      p += 20;
+      break;
+    case 202:
+      p += put_string(p, name);
+      break;
+    }
+    if (!send_reliable(Pid_Rte_Hdr, d, p - d)) {
+      return 0;
+    }
+
+    for (i = 0; i < prof.routepoints; i++) {
+      if (i && prof.rte_proto == 201) {
+        p = d;
+        put16(p, 0);		/* class: line */
+        p += 2;
+        memset(p, 0, 18);
+        p += 18;
+        p += put_string(p, "");
+        if (!send_reliable(Pid_Rte_Link_Data, d, p - d)) {
+          return 0;
+        }
+      }
+      /* Route points are the stored waypoints, so they resolve. */
+      n = build_waypoint(d, (r * prof.routepoints + i) % (prof.waypoints ? prof.waypoints : 1));
+      if (!send_reliable(Pid_Rte_Wpt_Data, d, n)) {
+        return 0;
+      }
+    }
+  }
+  note("sent %d routes of %d points\n", prof.routes, prof.routepoints);
+  return send_xfer_cmplt(Cmnd_Transfer_Rte);
+}
+
+static int
+transfer_tracks(void)
+{
+  unsigned char d[MAX_PACKET];
+  int ntracks = prof.tracks > 0 ? prof.tracks : 1;
+  int per_track;
+  int t, i, k;
+
+  if (!prof.trk_type) {
+    return send_records(0) && send_xfer_cmplt(Cmnd_Transfer_Trk);
+  }
+
+  per_track = (prof.trackpoints + ntracks - 1) / ntracks;
+  if (!send_records(prof.trackpoints + (prof.trk_hdr_type ? ntracks : 0))) {
+    return 0;
+  }
+
+  for (t = 0, k = 0; t < ntracks; t++) {
+    if (prof.trk_hdr_type) {
+      unsigned char* p = d;
+      char name[24];
+
+      snprintf(name, sizeof(name), "TRACK %d", t + 1);
+      *p++ = 1;		/* dspl */
+      *p++ = 0xff;	/* colour */
+      p += put_string(p, name);
+      if (!send_reliable(Pid_Trk_Hdr, d, p - d)) {
+        return 0;
+      }
+    }
+    for (i = 0; i < per_track && k < prof.trackpoints; i++, k++) {
+      unsigned char* p = d;
+      double lat, lon, alt;
+
+      fix_pos(k, &lat, &lon, &alt);
+      put32(p, semicircles(lat));
+      p += 4;
+      put32(p, semicircles(lon));
+      p += 4;
+      put32(p, (unsigned long)(prof.start + k - GARMIN_EPOCH));
+      p += 4;
+      if (prof.trk_type == 301) {
+        putf(p, alt);
+        p += 4;
+        putf(p, 1.0e25f);	/* dpth: unknown */
+        p += 4;
+      }
+      *p++ = (i == 0);	/* new_trk */
+      if (!send_reliable(Pid_Trk_Data, d, p - d)) {
+        return 0;
+      }
+    }
+  }
+  note("sent %d track points in %d tracks\n", prof.trackpoints, ntracks);
+  return send_xfer_cmplt(Cmnd_Transfer_Trk);
+}
+
+static int
+send_time(time_t t)
+{
+  unsigned char d[8];
+  struct tm* tm = gmtime(&t);
+
+  d[0] = tm->tm_mon + 1;
+  d[1] = tm->tm_mday;
+  put16(d + 2, tm->tm_year + 1900);
+  put16(d + 4, tm->tm_hour);
+  d[6] = tm->tm_min;
+  d[7] = tm->tm_sec;
+  return send_reliable(Pid_Date_Time_Data, d, 8);
+}
+
+static int
+send_posn(void)
+{
+  unsigned char d[16];
+
+  putd(d, prof.latitude * M_PI / 180.0);
+  putd(d + 8, prof.longitude * M_PI / 180.0);
+  return send_reliable(Pid_Position_Data, d, 16);
+}
+
+static int
+send_pvt(long i)
+{
+  unsigned char d[64];
+  unsigned char* p = d;
+  double lat, lon, alt;
+  long g = prof.start + i - GARMIN_EPOCH;
+  long wn_days = (g / 86400) - (g / 86400) % 7;
+
+  fix_pos(i, &lat, &lon, &alt);
+  putf(p, alt);		/* alt above ellipsoid */
+  p += 4;
+  putf(p, 5.0f);	/* epe */
+  p += 4;
+  putf(p, 4.0f);	/* eph */
+  p += 4;
+  putf(p, 3.0f);	/* epv */
+  p += 4;
+  put16(p, 3);		/* fix: 3D */
+  p += 2;
+  putd(p, (double)(g - wn_days * 86400 + LEAP_SECONDS));	/* tow */
+  p += 8;
+  putd(p, lat * M_PI / 180.0);
+  p += 8;
+  putd(p, lon * M_PI / 180.0);
+  p += 8;
+  putf(p, 3.0f);	/* east */
+  p += 4;
+  putf(p, 4.0f);	/* north */
+  p += 4;
+  putf(p, 0.0f);	/* up */
+  p += 4;
+  putf(p, -30.0f);	/* msl_hght */
+  p += 4;
+  put16(p, LEAP_SECONDS);
+  p += 2;
+  put32(p, wn_days);
+  p += 4;
+  return send_reliable(Pid_Pvt_Data, d, p - d);
+}
+
+static int
+send_product(void)
+{
+  unsigned char d[MAX_PACKET];
+  unsigned char* p = d;
+  int i;
+
+  put16(p, prof.product);
+  p += 2;
+  put16(p, prof.version);
+  p += 2;
+  p += put_string(p, prof.description);
+  if (!send_reliable(Pid_Product_Data, d, p - d)) {
+    return 0;
+  }
+
+  /* L000-only units have no protocol capability array. */
+  if (!prof.nprotocols) {
+    return 1;
+  }
+  for (p = d, i = 0; i < prof.nprotocols && p - d + 3 <= MAX_PACKET; i++) {
+    *p++ = prof.ptag[i];
+    put16(p, prof.pnum[i]);
+    p += 2;
+  }
+  return send_reliable(Pid_Protocol_Array, d, p - d);
+}
+
+static void
+report(const char* what, const counters_t* c, double secs)
+{
+  note("%s: %lu packets out, %lu in, %lu bytes out, %lu in, "
+       "%lu retries, %.3fs\n", what, c->packets_out, c->packets_in,
+       c->bytes_out, c->bytes_in, c->retries, secs);
+}
+
+static void
+garmin_session(void)
+{
+  int pvt = 0;
+  long pvt_fix = 0;
+  double pvt_next = 0;
+  double t0 = now();
+  unsigned long uploads = 0;
+  int records = -1;
+
+  memset(&ctr, 0, sizeof(ctr));
+  rxhead = rxtail = 0;
+
+  while (!stop) {
+    packet_t pkt;
+    int wait = 500;
+    int r;
+
+    if (pvt) {
+      double dt = pvt_next - now();
+      if (dt <= 0) {
+        if (!send_pvt(pvt_fix++)) {
+          pvt = 0;
+          continue;
+        }
+        pvt_next = prof.rate > 0 ? pvt_next + 1.0 / prof.rate : 0;
+        continue;
+      }
+      wait = (int)(dt * 1000) + 1;
+    }
+
+    r = recv_packet(&pkt, wait);
+    if (r < 0) {
+      break;
+    }
+    if (r == 0) {
+      continue;
+    }
+    if (pkt.id == Pid_Ack_Byte || pkt.id == Pid_Nak_Byte) {
+      continue;
+    }
+    if (!send_ack(Pid_Ack_Byte, pkt.id)) {
+      break;
+    }
+
+    switch (pkt.id) {
+    case Pid_Product_Rqst:
+      send_product();
+      break;
+    case Pid_Command_Data: {
+      int cmd = pkt.data[0] | (pkt.data[1] << 8);
+      double t = now();
+      counters_t before = ctr;
+      const char* what = NULL;
+
+      switch (cmd) {
+      case Cmnd_Transfer_Wpt:
+        what = "waypoint download";
+        transfer_waypoints();
+        break;
+      case Cmnd_Transfer_Rte:
+        what = "route download";
+        transfer_routes();
+        break;
+      case Cmnd_Transfer_Trk:
+        what = "track download";
+        transfer_tracks();
+        break;
+      case Cmnd_Transfer_Time:
+        send_time(prof.start + (time_t)(now() - t0));
+        break;
+      case Cmnd_Transfer_Posn:
+        send_posn();
+        break;
+      case Cmnd_Start_Pvt_Data:
+        if (prof.has_pvt) {
+          pvt = 1;
+          pvt_next = now();
+        }
+        break;
+      case Cmnd_Stop_Pvt_Data:
+        pvt = 0;
+        break;
+      case Cmnd_Abort_Transfer:
+      case Cmnd_Turn_Off_Pwr:
+        break;
+      default:
+        note("ignoring command %d\n", cmd);
+        break;
+      }
+      if (what) {
+        counters_t c;
+        c.packets_out = ctr.packets_out - before.packets_out;
+        c.packets_in = ctr.packets_in - before.packets_in;
+        c.bytes_out = ctr.bytes_out - before.bytes_out;
+        c.bytes_in = ctr.bytes_in - before.bytes_in;
+        c.retries = ctr.retries - before.retries;
+        report(what, &c, now() - t);
+      }
+      break;
+    }
+    case Pid_Records:
+      records = pkt.data[0] | (pkt.data[1] << 8);
+      uploads = 0;
+      break;
+    case Pid_Xfer_Cmplt:
+      note("received %lu of %d records\n", uploads, records);
+      records = -1;
+      break;
+    default:
+      uploads++;
+      break;
+    }
+  }
+  if (pvt_fix) {
+    note("sent %ld PVT fixes\n", pvt_fix);
+  }
+  report("session", &ctr, now() - t0);
+}
+
+/*
+ * NMEA
+ */
+
+static int
+nmea_send(char* buf, int len)
+{
+  unsigned char sum = 0;
+  int i;
+
+  for (i = 1; i < len; i++) {
+    sum ^= buf[i];
+  }
+  len += sprintf(buf + len, "*%02X\r\n", sum);
+  ctr.bytes_out += len;
+  ctr.packets_out++;
+  return write_all((unsigned char*)buf, len);
+}
+
+static int
+nmea_coord(char* buf, double v, int degwidth, char pos, char neg)
+{
+  char hemi = v < 0 ? neg : pos;
+  double a = fabs(v);
+  int deg = (int) a;
+  double min = (a - deg) * 60.0;
+
+  return sprintf(buf, "%0*d%07.4f,%c", degwidth, deg, min, hemi);
+}
+
+static int
+nmea_fix(long i)
+{
+  char buf[256];
+  int n;
+  double lat, lon, alt;
+  time_t t = prof.start + i;
+  struct tm* tm = gmtime(&t);
+
+  fix_pos(i, &lat, &lon, &alt);
+
+  n = sprintf(buf, "$GPGGA,%02d%02d%02d.00,", tm->tm_hour, tm->tm_min, tm->tm_sec);
+  n += nmea_coord(buf + n, lat, 2, 'N', 'S');
+  buf[n++] = ',';
+  n += nmea_coord(buf + n, lon, 3, 'E', 'W');
+  n += sprintf(buf + n, ",1,08,0.9,%.1f,M,-30.0,M,,", alt);
+  if (!nmea_send(buf, n)) {
+    return 0;
+  }
+
+  n = sprintf(buf, "$GPGSA,A,3,04,05,09,12,17,24,25,29,,,,,1.8,0.9,1.5");
+  if (!nmea_send(buf, n)) {
+    return 0;
+  }
+
+  n = sprintf(buf, "$GPRMC,%02d%02d%02d.00,A,", tm->tm_hour, tm->tm_min, tm->tm_sec);
+  n += nmea_coord(buf + n, lat, 2, 'N', 'S');
+  buf[n++] = ',';
+  n += nmea_coord(buf + n, lon, 3, 'E', 'W');
+  n += sprintf(buf + n, ",9.7,36.9,%02d%02d%02d,,,A",
+               tm->tm_mday, tm->tm_mon + 1, tm->tm_year % 100);
+  return nmea_send(buf, n);
+}
+
+static void
+nmea_session(void)
+{
+  double t0 = now();
+  double next = t0;
+  long i;
+
+  memset(&ctr, 0, sizeof(ctr));
+
+  for (i = 0; !stop && (!prof.fixes || i < prof.fixes); i++) {
+    unsigned char junk[256];
+
+    if (prof.rate > 0) {
+      double dt = next - now();
+      if (dt > 0) {
+        usleep((useconds_t)(dt * 1e6));
+      }
+      next += 1.0 / prof.rate;
+    }
+    /* Hosts may send configuration sentences; discard them. */
+    while (read(master, junk, sizeof(junk)) > 0) {
+      ;
+    }
+    if (!nmea_fix(i)) {
+      break;
+    }
+  }
+
+  /* Hold the line until the host lets go. */
+  while (!stop) {
+    struct pollfd pfd = { master, POLLIN, 0 };
+    unsigned char junk[256];
+
+    poll(&pfd, 1, 100);
+    if (pfd.revents & POLLHUP) {
+      break;
+    }
+    if (pfd.revents & POLLIN) {
+      while (read(master, junk, sizeof(junk)) > 0) {
+        ;
+      }
+    }
+  }
+
+  {
+    double secs = now() - t0;
+    note("nmea: %ld fixes, %lu sentences, %lu bytes in %.3fs, %.0f sentences/s\n",
+         i, ctr.packets_out, ctr.bytes_out, secs,
+         secs > 0 ? ctr.packets_out / secs : 0.0);
+  }
+}
+
+/*
+ * MTK logger.  Answers the PMTK182 log commands from a flash image;
+ * "$PMTK182,7,addr,len" reads come back as PMTK182,8 sentences of at
+ * most MTK_CHUNK bytes followed by an ack.  Replies can be delayed,
+ * handed back out of order, dropped or damaged to exercise the host's
+ * recovery.
+ */
+
+#define MTK_FLASH 0x200000
+#define MTK_CHUNK 0x800
+#define MTK_MAX_PENDING 256
+#define MTK_HOLD 0.05		/* s a reordered reply waits for company */
+
+typedef struct {
+  double due;
+  int read;		/* answer to a read request */
+  char* text;
+} mtk_reply_t;
+
+static unsigned char* mtk_flash;
+static unsigned long mtk_used;
+static mtk_reply_t mtk_pending[MTK_MAX_PENDING];
+static int mtk_npending;
+static unsigned long mtk_reads, mtk_lines, mtk_dropped, mtk_damaged;
+
+
+/* Append "$body*CS\r\n" to buf; returns the new length. */
+static int
+mtk_sentence(char* buf, int len, const char* body)
+{
+  unsigned char sum = 0;
+  const char* p;
+
+  for (p = body; *p; p++) {
+    sum ^= *p;
+  }
+  return len + sprintf(buf + len, "$%s*%02X\r\n", body, sum);
+}
+
+static void
+mtk_queue(char* text, int read)
+{
+  if (mtk_npending == MTK_MAX_PENDING) {
+    fatal("too many replies pending\n");
+  }
+  mtk_pending[mtk_npending].due = now() + prof.latency / 1000.0;
+  mtk_pending[mtk_npending].read = read;
+  mtk_pending[mtk_npending].text = text;
+  mtk_npending++;
+}
+
+static void
+mtk_reply(const char* body)
+{
+  char* buf = (char*) malloc(strlen(body) + 8);
+  mtk_sentence(buf, 0, body);
+  mtk_queue(buf, 0);
+}
+
+static void
+mtk_read_reply(unsigned long addr, unsigned long len)
+{
+  char* buf;
+  char* body;
+  int n = 0;
+  unsigned long off;
+
+  mtk_reads++;
+  if (prof.drop && mtk_reads % prof.drop == 0) {
+    mtk_dropped++;
+    return;
+  }
+  if (addr >= MTK_FLASH || len > MTK_FLASH - addr) {
+    mtk_reply("PMTK001,182,7,1");
+    return;
+  }
+
+  buf = (char*) malloc(2 * len + (len / MTK_CHUNK + 2) * 40);
+  body = (char*) malloc(2 * MTK_CHUNK + 40);
+  for (off = 0; off < len; off += MTK_CHUNK) {
+    unsigned long chunk = len - off < MTK_CHUNK ? len - off : MTK_CHUNK;
+    unsigned long i;
+    int b = sprintf(body, "PMTK182,8,%08lX,", addr + off);
+    int start = n;
+
+    for (i = 0; i < chunk; i++) {
+      b += sprintf(body + b, "%02X", mtk_flash[addr + off + i]);
+    }
+    n = mtk_sentence(buf, n, body);
+    mtk_lines++;
+    if (prof.corrupt && mtk_lines % prof.corrupt == 0) {
+      /* Flip a data digit after the checksum has been computed. */
+      char* d = buf + start + 20;
+      *d = (*d == '0') ? '1' : '0';
+      mtk_damaged++;
+    }
+  }
+  free(body);
+  n = mtk_sentence(buf, n, "PMTK001,182,7,3");
+  mtk_queue(buf, 1);
+}
+
+static void
+mtk_command(char* line)
+{
+  char* body = strchr(line, '$');
+  char* e;
+  unsigned long a, l;
+
+  if (!body) {
+    return;
+  }
+  body++;
+  if ((e = strchr(body, '*'))) {
+    *e = 0;
+  }
+
+  if (!strcmp(body, "PMTK605")) {
+    mtk_reply("PMTK705,AXN_1.0-B_1.3_C01,0001,GPSEMU,1.0");
+  } else if (!strcmp(body, "PMTK182,2,7")) {
+    mtk_reply("PMTK182,3,7,0");		/* not logging */
+    mtk_reply("PMTK001,182,2,3");
+  } else if (!strcmp(body, "PMTK182,2,8")) {
+    char r[64];
+    sprintf(r, "PMTK182,3,8,%08lX", mtk_used);
+    mtk_reply(r);
+    mtk_reply("PMTK001,182,2,3");
+  } else if (!strcmp(body, "PMTK182,2,2")) {
+    mtk_reply("PMTK182,3,2,0002003F");
+    mtk_reply("PMTK001,182,2,3");
+  } else if (!strcmp(body, "PMTK182,4")) {
+    mtk_reply("PMTK001,182,4,3");
+  } else if (!strcmp(body, "PMTK182,5")) {
+    mtk_reply("PMTK001,182,5,3");
+  } else if (!strcmp(body, "PMTK182,6,1")) {
+    memset(mtk_flash, 0xff, MTK_FLASH);
+    mtk_used = 0;
+    mtk_reply("PMTK001,182,6,3");
+  } else if (sscanf(body, "PMTK182,7,%lx,%lx", &a, &l) == 2) {
+    mtk_read_reply(a, l);
+  } else if (!strncmp(body, "PMTK", 4)) {
+    char r[64];
+    snprintf(r, sizeof(r), "PMTK001,%.3s,1", body + 4);
+    mtk_reply(r);
+  }
+}
+
+static int
+mtk_send(int i)
+{
+  mtk_reply_t* r = &mtk_pending[i];
+  size_t len = strlen(r->text);
+
+  ctr.packets_out++;
+  ctr.bytes_out += len;
+  if (!write_all((unsigned char*) r->text, len)) {
+    return 0;
+  }
+  free(r->text);
+  memmove(r, r + 1, (mtk_npending - i - 1) * sizeof(*r));
+  mtk_npending--;
+  return 1;
+}
+
+/*
+ * Send whatever is due, oldest first.  With reordering, due read
+ * replies are held until prof.reorder of them are ready (or the oldest
+ * has waited MTK_HOLD) and then go out newest first.
+ */
+static int
+mtk_send_due(double t)
+{
+  while (mtk_npending && mtk_pending[0].due <= t) {
+    int k;
+
+    if (prof.reorder <= 1 || !mtk_pending[0].read) {
+      if (!mtk_send(0)) {
+        return 0;
+      }
+      continue;
+    }
+    for (k = 0; k < mtk_npending && k < prof.reorder; k++) {
+      if (!mtk_pending[k].read || mtk_pending[k].due > t) {
+        break;
+      }
+    }
+    if (k < prof.reorder && t - mtk_pending[0].due < MTK_HOLD) {
+      break;
+    }
+    while (k-- > 0) {
+      if (!mtk_send(k)) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+static void
+mtk_session(void)
+{
+  char line[256];
+  int n = 0;
+
+  while (!stop) {
+    struct pollfd pfd;
+    double t = now();
+    int wait = 50;
+    int r;
+    unsigned char buf[256];
+
+    if (!mtk_send_due(t)) {
+      break;
+    }
+    if (mtk_npending) {
+      double next = mtk_pending[0].due;
+      if (prof.reorder > 1 && mtk_pending[0].read && next <= t) {
+        next += MTK_HOLD;
+      }
+      wait = (int)((next - t) * 1000) + 1;
+      if (wait > 50) {
+        wait = 50;
+      }
+      if (wait < 1) {
+        wait = 1;
+      }
+    }
+
+    pfd.fd = master;
+    pfd.events = POLLIN;
+    r = poll(&pfd, 1, wait);
+    if (r <= 0) {
+      continue;
+    }
+    if (!(pfd.revents & POLLIN)) {
+      break;			/* host closed the slave */
+    }
+    while ((r = read(master, buf, sizeof(buf))) > 0) {
+      int i;
+
+      ctr.bytes_in += r;
+      for (i = 0; i < r; i++) {
+        if (buf[i] == '\n' || buf[i] == '\r') {
+          if (n) {
+            line[n] = 0;
+            ctr.packets_in++;
+            mtk_command(line);
+          }
+          n = 0;
+        } else if (n < (int) sizeof(line) - 1) {
+          line[n++] = buf[i];
+        }
+      }
+    }
+  }
+
+  while (mtk_npending) {
+    free(mtk_pending[--mtk_npending].text);
+  }
+  note("mtk: %lu reads, %lu data sentences, %lu dropped, %lu damaged\n",
+       mtk_reads, mtk_lines, mtk_dropped, mtk_damaged);
+}
+
+/*
+ * SkyTraq Venus logger.  Binary messages are "A0 A1 len payload cs
+ * 0D 0A"; every request is acknowledged with message 0x83.  Sectors
+ * come back raw, followed by "END\0CHECKSUM=" and an XOR checksum.
+ */
+
+#define STQ_SECTOR 4096
+#define STQ_SECTORS 256
+
+static const unsigned char stq_end[13] = { 'E','N','D', 0, 'C','H','E','C','K','S','U','M','=' };
+static unsigned char* stq_flash;
+static unsigned long stq_used;
+static unsigned long stq_sectors_sent;
+
+static void
+stq_load(void)
+{
+  stq_flash = image_load(STQ_SECTOR * STQ_SECTORS, &stq_used);
+  if (prof.sectors > 0 && (unsigned long) prof.sectors * STQ_SECTOR < stq_used) {
+    /* the rest of the log hasn't been recorded yet */
+    stq_used = (unsigned long) prof.sectors * STQ_SECTOR;
+    memset(stq_flash + stq_used, 0xff, STQ_SECTOR * STQ_SECTORS - stq_used);
+  }
+}
+
+static int
+stq_send(const unsigned char* payload, int len)
+{
+  unsigned char buf[64];
+  unsigned char cs = 0;
+  int i;
+
+  buf[0] = 0xa0;
+  buf[1] = 0xa1;
+  buf[2] = len >> 8;
+  buf[3] = len;
+  for (i = 0; i < len; i++) {
+    buf[4 + i] = payload[i];
+    cs ^= payload[i];
+  }
+  buf[4 + len] = cs;
+  buf[5 + len] = 0x0d;
+  buf[6 + len] = 0x0a;
+  ctr.packets_out++;
+  ctr.bytes_out += len + 7;
+  return write_all(buf, len + 7);
+}
+
+static int
+stq_ack(unsigned char id, int ok)
+{
+  unsigned char m[2];
+
+  m[0] = ok ? 0x83 : 0x84;
+  m[1] = id;
+  return stq_send(m, 2);
+}
+
+static void
+put_le32(unsigned char* p, unsigned long v)
+{
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+}
+
+/*
+ * len bytes of flash at addr, then the end tag and the checksum.  pad
+ * is the number of trailing bytes the host reads after the checksum;
+ * -1 pads the reply to a multiple of 16 bytes instead.
+ */
+static int
+stq_send_flash(unsigned long addr, unsigned long len, int pad)
+{
+  unsigned char tail[sizeof(stq_end) + 16];
+  unsigned char cs = 0;
+  unsigned long i;
+  const unsigned char* p = stq_flash + addr;
+  int tlen = sizeof(stq_end) + 1;
+
+  for (i = 0; i < len; i++) {
+    cs ^= p[i];
+  }
+  memcpy(tail, stq_end, sizeof(stq_end));
+  tail[sizeof(stq_end)] = cs;
+  if (pad < 0) {
+    pad = (16 - (len + tlen) % 16) % 16;
+  }
+  memset(tail + tlen, 0, pad);
+  tlen += pad;
+  ctr.bytes_out += len + tlen;
+  return write_all(p, len) && write_all(tail, tlen);
+}
+
+static int
+stq_message(const unsigned char* m, int len)
+{
+  switch (m[0]) {
+  case 0x02: {		/* query software version */
+    unsigned char r[14] = { 0x80, 0x01, 0, 1, 8, 4, 0, 1, 6, 8, 0, 11, 3, 10 };
+    return stq_ack(m[0], 1) && stq_send(r, sizeof(r));
+  }
+  case 0x17: {		/* log status */
+    unsigned char r[35];
+    unsigned long used = (stq_used + STQ_SECTOR - 1) / STQ_SECTOR;
+    memset(r, 0, sizeof(r));
+    r[0] = 0x94;
+    put_le32(&r[1], stq_used);
+    r[5] = (STQ_SECTORS - used) & 0xff;
+    r[6] = (STQ_SECTORS - used) >> 8;
+    r[7] = STQ_SECTORS & 0xff;
+    r[8] = STQ_SECTORS >> 8;
+    put_le32(&r[9], 3600);		/* max time */
+    put_le32(&r[13], 5);		/* min time */
+    put_le32(&r[17], 10000);	/* max distance */
+    put_le32(&r[29], 0xffff);	/* max speed */
+    r[33] = 1;			/* logging enabled, not FIFO */
+    return stq_ack(m[0], 1) && stq_send(r, sizeof(r));
+  }
+  case 0x1b: {		/* read one sector: only the part written so far */
+    unsigned long addr = (unsigned long) m[1] * STQ_SECTOR;
+    unsigned long used = STQ_SECTOR;
+    if (len < 2) {
+      return stq_ack(m[0], 0);
+    }
+    while (used > 0 && stq_flash[addr + used - 1] == 0xff) {
+      used--;
+    }
+    stq_sectors_sent++;
+    return stq_ack(m[0], 1) && stq_send_flash(addr, used, -1);
+  }
+  case 0x1d: {		/* read sectors */
+    unsigned first, count;
+    if (len < 5) {
+      return stq_ack(m[0], 0);
+    }
+    first = (m[1] << 8) | m[2];
+    count = (m[3] << 8) | m[4];
+    if (first + count > STQ_SECTORS) {
+      return stq_ack(m[0], 0);
+    }
+    stq_sectors_sent += count;
+    return stq_ack(m[0], 1) &&
+           stq_send_flash((unsigned long) first * STQ_SECTOR, (unsigned long) count * STQ_SECTOR, 5);
+  }
+  case 0x19:		/* erase */
+    memset(stq_flash, 0xff, STQ_SECTOR * STQ_SECTORS);
+    stq_used = 0;
+    return stq_ack(m[0], 1);
+  case 0x01:		/* restart */
+  case 0x05:		/* configure serial port */
+  case 0x18:		/* configure logging */
+    return stq_ack(m[0], 1);
+  default:
+    return stq_ack(m[0], 0);
+  }
+}
+
+static void
+stq_session(void)
+{
+  unsigned char msg[256];
+  int state = 0, len = 0, n = 0;
+  int hangup = 0;
+  unsigned char cs = 0;
+
+  memset(&ctr, 0, sizeof(ctr));
+  stq_sectors_sent = 0;
+
+  while (!stop && !hangup) {
+    struct pollfd pfd = { master, POLLIN, 0 };
+    unsigned char buf[256];
+    int r, i;
+
+    if (poll(&pfd, 1, 100) <= 0) {
+      continue;
+    }
+    if (!(pfd.revents & POLLIN)) {
+      break;			/* host closed the slave */
+    }
+    while ((r = read(master, buf, sizeof(buf))) > 0) {
+      ctr.bytes_in += r;
+      for (i = 0; i < r; i++) {
+        unsigned char c = buf[i];
+        switch (state) {
+        case 0:
+          state = (c == 0xa0);
+          break;
+        case 1:
+          state = (c == 0xa1) ? 2 : (c == 0xa0);
+          break;
+        case 2:
+          len = c << 8;
+          state = 3;
+          break;
+        case 3:
+          len |= c;
+          n = 0;
+          cs = 0;
+          state = (len > 0 && len <= (int) sizeof(msg)) ? 4 : 0;
+          break;
+        case 4:
+          msg[n++] = c;
+          cs ^= c;
+          if (n == len) {
+            state = 5;
+          }
+          break;
+        case 5:
+          state = 0;
+          if (c != cs) {
+            ctr.retries++;
+            break;
+          }
+          ctr.packets_in++;
+          if (!stq_message(msg, len)) {
+            hangup = 1;
+          }
+          break;
+        }
+      }
+    }
+  }
+
+  note("skytraq: %lu sectors sent, %lu bytes\n", stq_sectors_sent, ctr.bytes_out);
+}
+
+static void
+usage(void)
+{
+  fprintf(stderr,
+          "Usage: " MYNAME " [options] garmin|nmea|mtk|skytraq\n"
+          "  -f file   read a device profile\n"
+          "  -l path   also make the pty reachable as a symlink at path\n"
+          "  -w n      number of waypoints\n"
+          "  -r n      number of routes\n"
+          "  -R n      points per route\n"
+          "  -k n      number of tracks\n"
+          "  -t n      total number of track points\n"
+          "  -P id     Garmin product id\n"
+          "  -z hz     NMEA / PVT fix rate, 0 for as fast as possible\n"
+          "  -n n      NMEA fixes per session, 0 for no limit\n"
+          "  -i file   MTK or SkyTraq flash image (default: an empty log)\n"
+          "  -L ms     MTK reply latency\n"
+          "  -o n      return MTK read replies in reversed groups of n\n"
+          "  -d n      leave every n'th MTK read request unanswered\n"
+          "  -c n      damage every n'th MTK data sentence\n"
+          "  -S n      only the first n SkyTraq sectors of the image are written\n"
+          "  -q        quiet\n"
+          "\n"
+          "A profile holds 'key value' lines; keys are product, version,\n"
+          "description, protocols (e.g. P000 L001 A010 A100 D108 ...),\n"
+          "waypoints, routes, routepoints, tracks, trackpoints, latitude,\n"
+          "longitude, start (unix time), rate, fixes, image, latency, reorder,\n"
+          "drop, corrupt and sectors.\n"
+          "\n"
+          "The pty name is printed on stdout.  Statistics for each transfer\n"
+          "and session go to stderr.\n");
+  exit(1);
+}
+
+int
+main(int argc, char* argv[])
+{
+  struct sigaction sa;
+  int mode;
+  int c;
+
+  profile_defaults(&prof);
+  profile_set_protocols(&prof,
+                        "P000 L001 A010 A100 D108 A201 D202 D108 D210 "
+                        "A301 D310 D301 A600 D600 A700 D700 A800 D800");
+
+  /* The profile is read first so the command line can override it. */
+  for (c = 1; c < argc - 1; c++) {
+    if (!strcmp(argv[c], "-f")) {
+      profile_read(&prof, argv[c + 1]);
+    }
+  }
+
+  while ((c = getopt(argc, argv, "f:l:w:r:R:k:t:P:z:n:i:L:o:d:c:S:q")) != -1) {
+    switch (c) {
+    case 'f':
+      break;
+    case 'l':
+      link_name = optarg;
+      break;
+    case 'w':
+      prof.waypoints = atoi(optarg);
+      break;
+    case 'r':
+      prof.routes = atoi(optarg);
+      break;
+    case 'R':
+      prof.routepoints = atoi(optarg);
+      break;
+    case 'k':
+      prof.tracks = atoi(optarg);
+      break;
+    case 't':
+      prof.trackpoints = atoi(optarg);
+      break;
+    case 'P':
+      prof.product = atoi(optarg);
+      break;
+    case 'z':
+      prof.rate = atof(optarg);
+      break;
+    case 'n':
+      prof.fixes = atol(optarg);
+      break;
+    case 'i':
+      snprintf(prof.image, sizeof(prof.image), "%s", optarg);
+      break;
+    case 'L':
+      prof.latency = atoi(optarg);
+      break;
+    case 'o':
+      prof.reorder = atoi(optarg);
+      break;
+    case 'd':
+      prof.drop = atoi(optarg);
+      break;
+    case 'c':
+      prof.corrupt = atoi(optarg);
+      break;
+    case 'S':
+      prof.sectors = atoi(optarg);
+      break;
+    case 'q':
+      quiet = 1;
+      break;
+    default:
+      usage();
+    }
+  }
+  if (optind != argc - 1) {
+    usage();
+  }
+  if (!strcmp(argv[optind], "garmin")) {
+    mode = 'g';
+  } else if (!strcmp(argv[optind], "nmea")) {
+    mode = 'n';
+  } else if (!strcmp(argv[optind], "mtk")) {
+    mode = 'm';
+    mtk_flash = image_load(MTK_FLASH, &mtk_used);
+  } else if (!strcmp(argv[optind], "skytraq")) {
+    mode = 's';
+    stq_load();
+  } else {
+    usage();
+  }
+  profile_derive(&prof);
+  if (mode == 'g' && (prof.waypoints > 0xffff || prof.trackpoints + prof.tracks > 0xffff)) {
+    fatal("too many records for one transfer\n");
+  }
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_signal;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  open_pty();
+
+  while (wait_for_host()) {
+    if (mode == 'g') {
+      garmin_session();
+    } else if (mode == 'n') {
+      nmea_session();
+    } else if (mode == 'm') {
+      mtk_session();
+    } else {
+      stq_session();
+    }
+  }
+
+  if (link_name) {
+    unlink(link_name);
+  }
+  return 0;
+}
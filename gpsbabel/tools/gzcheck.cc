@@ -0,0 +1,186 @@
+/*
+    Check seeks in gzip compressed input against the plain file.
+
+    Copyright (C) 2015 Robert Lipe, robertlipe+source@gpsbabel.org
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111 USA
+
+ */
+
+/*
+ * This is a test tool, not part of gpsbabel proper.
+ *
+ * Build:   make gzcheck
+ * Use:     ./gzcheck [-Z] [-n seeks] file.gz file
+ *
+ * file.gz is opened through gbfopen(), so it is read by the seekable
+ * gzip reader in gbfile.cc, and every byte read is compared with the
+ * same offset of the plain file.  Seeks go to random offsets (from a
+ * fixed seed), back and forth, then a few are made relative to the
+ * current position; at the end the whole file is read from the start.
+ * Input larger than the reader's checkpoint spacing, made of several
+ * gzip members, makes it resume inside members from saved checkpoints.
+ * -Z keeps the checkpoints beside the input, as gpsbabel -Z does, so a
+ * second run resumes from checkpoints it never made itself.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include "defs.h"
+#include "gbfile.h"
+
+#define MYNAME "gzcheck"
+
+/* Largest piece read after each seek. */
+#define PIECE 4096
+
+static int failures = 0;
+
+/* A small LCG, so every run and platform sees the same offsets. */
+static uint64_t seed = 20150101;
+
+static long
+pick(long n)
+{
+  seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return (long)((seed >> 33) % (uint64_t) n);
+}
+
+static void
+check_piece(gbfile* fin, const std::vector<char>& plain, long pos, long len, const char* what)
+{
+  char buf[PIECE];
+  long got;
+
+  got = gbfread(buf, 1, len, fin);
+  if ((got != len) || (memcmp(buf, &plain[pos], len) != 0)) {
+    if (failures++ < 5) {
+      fprintf(stderr, MYNAME ": %s: %ld bytes at %ld differ\n", what, len, pos);
+    }
+  }
+  if ((long) gbftell(fin) != pos + got) {
+    if (failures++ < 5) {
+      fprintf(stderr, MYNAME ": %s: at %ld instead of %ld\n", what,
+              (long) gbftell(fin), pos + got);
+    }
+  }
+}
+
+static void
+usage(void)
+{
+  fprintf(stderr, "Usage: " MYNAME " [-Z] [-n seeks] file.gz file\n");
+  exit(1);
+}
+
+int
+main(int argc, char* argv[])
+{
+  std::vector<char> plain;
+  char buf[PIECE];
+  int nseeks = 500;
+  long size, pos;
+  size_t n;
+  FILE* f;
+  gbfile* fin;
+  int c;
+
+  while ((c = getopt(argc, argv, "Zn:")) != -1) {
+    switch (c) {
+    case 'Z':
+      global_opts.gzindex = 1;
+      break;
+    case 'n':
+      nseeks = atoi(optarg);
+      break;
+    default:
+      usage();
+    }
+  }
+  if ((optind + 2 != argc) || (nseeks < 1)) {
+    usage();
+  }
+
+  f = fopen(argv[optind + 1], "rb");
+  if (f == NULL) {
+    fprintf(stderr, MYNAME ": cannot open '%s'\n", argv[optind + 1]);
+    return 1;
+  }
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    plain.insert(plain.end(), buf, buf + n);
+  }
+  fclose(f);
+  size = plain.size();
+  if (size < PIECE) {
+    fprintf(stderr, MYNAME ": '%s' is too small to check\n", argv[optind + 1]);
+    return 1;
+  }
+
+  fin = gbfopen(argv[optind], "rb", MYNAME);
+
+  /* Random offsets: about half of them are behind the last one. */
+  for (int i = 0; i < nseeks; i++) {
+    long len = 1 + pick(PIECE);
+
+    pos = pick(size - len + 1);
+    gbfseek(fin, pos, SEEK_SET);
+    check_piece(fin, plain, pos, len, "seek");
+  }
+
+  /* Relative seeks, short ones both ways and a long one back. */
+  pos = size / 2;
+  gbfseek(fin, pos, SEEK_SET);
+  for (int i = 0; i < 50; i++) {
+    long len = 1 + pick(PIECE / 4);
+    long step = pick(2 * PIECE) - PIECE;
+
+    if ((pos + step < 0) || (pos + step + len > size)) {
+      step = -step;
+    }
+    if ((pos + step < 0) || (pos + step + len > size)) {
+      step = 0;
+      pos = size / 2;
+      gbfseek(fin, pos, SEEK_SET);
+    }
+    gbfseek(fin, step, SEEK_CUR);
+    pos += step;
+    check_piece(fin, plain, pos, len, "relative seek");
+    pos += len;
+  }
+  gbfseek(fin, -(pos - PIECE), SEEK_CUR);
+  check_piece(fin, plain, PIECE, PIECE, "seek back");
+
+  /* And the whole file in order. */
+  gbfrewind(fin);
+  for (pos = 0; pos < size; pos += PIECE) {
+    check_piece(fin, plain, pos, (size - pos < PIECE) ? size - pos : PIECE, "read");
+  }
+  if (gbfread(buf, 1, 1, fin) != 0) {
+    fprintf(stderr, MYNAME ": more data than in the plain file\n");
+    failures++;
+  }
+  gbfclose(fin);
+
+  if (failures) {
+    fprintf(stderr, MYNAME ": %d check(s) failed.\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,321 @@
+/*
+    Time conversions through libgpsbabel against running gpsbabel for
+    each of them.
+
+    Copyright (C) 2015 Robert Lipe, robertlipe+source@gpsbabel.org
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111 USA
+
+ */
+
+/*
+ * This is a test tool, not part of gpsbabel proper.  POSIX only.
+ *
+ * Build:   make libbench
+ * Use:     ./libbench -n 200 -t -i gpx -o unicsv reference/track/trackfilter.gpx
+ *
+ * Every call converts the whole input file.  The exec path does what a
+ * program shelling out to gpsbabel does: write the input to a temporary
+ * file, fork and exec gpsbabel, wait for it and read the output back.
+ * With -O the output of the last library call is saved, so it can be
+ * compared with what gpsbabel writes after the library has been used
+ * a few times over.  With -e the library is first given a file it
+ * must reject: the call has to fail with a message, and the calls
+ * after it have to work as if it never happened.
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+#include "libgpsbabel.h"
+
+#define MYNAME "libbench"
+
+static const char* gpsbabel = "./gpsbabel";
+static const char* in_format = NULL;
+static const char* out_format = NULL;
+static std::vector<const char*> filters;
+static int objects = 0;
+
+static void
+die(const char* fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  fprintf(stderr, MYNAME ": ");
+  vfprintf(stderr, fmt, ap);
+  va_end(ap);
+  exit(1);
+}
+
+static void
+usage(void)
+{
+  fprintf(stderr,
+          "Usage: " MYNAME " [-b gpsbabel] [-n calls] [-O outfile] [-e badfile]\n"
+          "                [-w] [-t] [-r] [-x filter]... -i informat -o outformat infile\n");
+  exit(1);
+}
+
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static std::vector<char>
+read_file(const char* name)
+{
+  std::vector<char> data;
+  char buf[65536];
+  size_t n;
+  FILE* f = fopen(name, "rb");
+
+  if (!f) {
+    die("Cannot open '%s': %s\n", name, strerror(errno));
+  }
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    data.insert(data.end(), buf, buf + n);
+  }
+  fclose(f);
+  return data;
+}
+
+static void
+write_file(const char* name, const void* data, size_t size)
+{
+  FILE* f = fopen(name, "wb");
+
+  if (!f || (fwrite(data, 1, size, f) != size) || fclose(f)) {
+    die("Cannot write '%s': %s\n", name, strerror(errno));
+  }
+}
+
+static void
+lib_call(const std::vector<char>& in, const char* save)
+{
+  void* out;
+  size_t out_size;
+  char* messages;
+
+  filters.push_back(NULL);
+  int res = gpsbabel_convert(in_format, in.empty() ? "" : &in[0], in.size(),
+                             out_format, &out, &out_size, &filters[0],
+                             objects, &messages);
+  filters.pop_back();
+
+  if (messages) {
+    fputs(messages, stderr);
+    gpsbabel_free(messages);
+  }
+  if (res != 0) {
+    die("Conversion failed.\n");
+  }
+  if (save) {
+    write_file(save, out, out_size);
+  }
+  gpsbabel_free(out);
+}
+
+/* A conversion that must fail, cleanly. */
+static void
+lib_fail_call(const std::vector<char>& in)
+{
+  void* out;
+  size_t out_size;
+  char* messages;
+
+  filters.push_back(NULL);
+  int res = gpsbabel_convert(in_format, in.empty() ? "" : &in[0], in.size(),
+                             out_format, &out, &out_size, &filters[0],
+                             objects, &messages);
+  filters.pop_back();
+
+  if (res != -1) {
+    die("Bad input gave %d, not -1.\n", res);
+  }
+  if ((out != NULL) || (out_size != 0)) {
+    die("Bad input gave output.\n");
+  }
+  if (!messages || !*messages) {
+    die("Bad input gave no message.\n");
+  }
+  gpsbabel_free(messages);
+}
+
+static void
+exec_call(const std::vector<char>& in, const char* dir)
+{
+  std::vector<const char*> args;
+  char fin[1024], fout[1024];
+  int status;
+  pid_t pid;
+
+  snprintf(fin, sizeof(fin), "%s/in", dir);
+  snprintf(fout, sizeof(fout), "%s/out", dir);
+  write_file(fin, in.empty() ? "" : &in[0], in.size());
+
+  args.push_back(gpsbabel);
+  if (objects & GPSBABEL_WAYPOINTS) {
+    args.push_back("-w");
+  }
+  if (objects & GPSBABEL_TRACKS) {
+    args.push_back("-t");
+  }
+  if (objects & GPSBABEL_ROUTES) {
+    args.push_back("-r");
+  }
+  args.push_back("-i");
+  args.push_back(in_format);
+  args.push_back("-f");
+  args.push_back(fin);
+  for (size_t i = 0; i < filters.size(); i++) {
+    args.push_back("-x");
+    args.push_back(filters[i]);
+  }
+  args.push_back("-o");
+  args.push_back(out_format);
+  args.push_back("-F");
+  args.push_back(fout);
+  args.push_back(NULL);
+
+  pid = fork();
+  if (pid < 0) {
+    die("Cannot fork: %s\n", strerror(errno));
+  }
+  if (pid == 0) {
+    execv(gpsbabel, (char* const*) &args[0]);
+    _exit(127);
+  }
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      die("waitpid: %s\n", strerror(errno));
+    }
+  }
+  if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+    die("%s failed.\n", gpsbabel);
+  }
+  read_file(fout);
+}
+
+static void
+report(const char* label, std::vector<double>& t)
+{
+  double sum = 0;
+
+  std::sort(t.begin(), t.end());
+  for (size_t i = 0; i < t.size(); i++) {
+    sum += t[i];
+  }
+  printf("  %-12s %8.3f ms mean %8.3f ms median %8.3f ms min\n", label,
+         1000 * sum / t.size(), 1000 * t[t.size() / 2], 1000 * t[0]);
+}
+
+int
+main(int argc, char* argv[])
+{
+  const char* save = NULL;
+  const char* bad = NULL;
+  int calls = 100;
+  int c;
+
+  while ((c = getopt(argc, argv, "b:n:O:e:wtrx:i:o:")) != -1) {
+    switch (c) {
+    case 'b':
+      gpsbabel = optarg;
+      break;
+    case 'n':
+      calls = atoi(optarg);
+      break;
+    case 'O':
+      save = optarg;
+      break;
+    case 'e':
+      bad = optarg;
+      break;
+    case 'w':
+      objects |= GPSBABEL_WAYPOINTS;
+      break;
+    case 't':
+      objects |= GPSBABEL_TRACKS;
+      break;
+    case 'r':
+      objects |= GPSBABEL_ROUTES;
+      break;
+    case 'x':
+      filters.push_back(optarg);
+      break;
+    case 'i':
+      in_format = optarg;
+      break;
+    case 'o':
+      out_format = optarg;
+      break;
+    default:
+      usage();
+    }
+  }
+  if (!in_format || !out_format || (optind != argc - 1) || (calls < 1)) {
+    usage();
+  }
+
+  std::vector<char> in = read_file(argv[optind]);
+  std::vector<double> lib_t, exec_t;
+  char dir[] = "/tmp/libbench.XXXXXX";
+
+  if (!mkdtemp(dir)) {
+    die("Cannot make a temporary directory: %s\n", strerror(errno));
+  }
+
+  if (bad) {
+    lib_fail_call(read_file(bad));
+  }
+
+  /* The first call sets the library up; it's timed like the rest. */
+  for (int i = 0; i < calls; i++) {
+    double t0 = now();
+    lib_call(in, (i == calls - 1) ? save : NULL);
+    lib_t.push_back(now() - t0);
+  }
+  for (int i = 0; i < calls; i++) {
+    double t0 = now();
+    exec_call(in, dir);
+    exec_t.push_back(now() - t0);
+  }
+
+  char fin[1024], fout[1024];
+  snprintf(fin, sizeof(fin), "%s/in", dir);
+  snprintf(fout, sizeof(fout), "%s/out", dir);
+  unlink(fin);
+  unlink(fout);
+  rmdir(dir);
+
+  printf("%s, %lu bytes, %d calls:\n", argv[optind], (unsigned long) in.size(), calls);
+  report("library", lib_t);
+  report("fork/exec", exec_t);
+  return 0;
+}
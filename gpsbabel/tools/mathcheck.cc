@@ -0,0 +1,340 @@
+/*
+    Check the batched math routines against the scalar ones they replace.
+
+    Copyright (C) 2015 Robert Lipe, robertlipe+source@gpsbabel.org
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111 USA
+
+ */
+
+/*
+ * This is a test tool, not part of gpsbabel proper.
+ *
+ * Build:   make mathcheck
+ * Use:     ./mathcheck [-n points] [-v]
+ *
+ * Checked are the prepared datum transforms (jeeps/gpsmath.cc) and the
+ * great circle array kernels (grtcirc.cc).
+ *
+ * Random points (from a fixed seed) and a few edge cases go through
+ * both the batched and the scalar version of each routine; any result
+ * further apart than the stated tolerance is reported and makes the
+ * exit status non-zero.  -v prints the largest difference found for
+ * each check.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include "jeeps/gpsport.h"
+#include "jeeps/gpsmath.h"
+#include "grtcirc.h"
+
+#define MYNAME "mathcheck"
+
+/* Datum transforms: degrees for positions, metres for heights. */
+#define DATUM_TOL_DEG	1e-9
+#define DATUM_TOL_M	1e-6
+/* Great circle kernels: relative error. */
+#define GC_TOL_REL	1e-9
+
+static int verbose = 0;
+static int failures = 0;
+
+/* A small LCG, so every run and platform sees the same points. */
+static uint64_t seed = 20150101;
+
+static double
+uniform(double lo, double hi)
+{
+  seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return lo + (hi - lo) * ((seed >> 11) * (1.0 / 9007199254740992.0));
+}
+
+/* Track the largest difference of one check and count the misses. */
+typedef struct {
+  const char* what;
+  double tol;
+  int relative;			/* tol is relative to the wanted value */
+  double worst;
+  int bad;
+} check_t;
+
+static void
+check_init(check_t* c, const char* what, double tol, int relative = 0)
+{
+  c->what = what;
+  c->tol = tol;
+  c->relative = relative;
+  c->worst = 0;
+  c->bad = 0;
+}
+
+static void
+check_value(check_t* c, double got, double want, const char* detail)
+{
+  double diff = fabs(got - want);
+
+  if (isnan(got) && isnan(want)) {
+    diff = 0;
+  } else if (c->relative && (diff != 0)) {
+    diff /= fabs(want);
+  }
+  if (!(diff <= c->tol)) {	/* NaN fails too */
+    if (c->bad++ < 5) {
+      fprintf(stderr, MYNAME ": %s: %s: got %.15g, want %.15g\n",
+              c->what, detail, got, want);
+    }
+  }
+  if (diff > c->worst) {
+    c->worst = diff;
+  }
+}
+
+static void
+check_done(check_t* c)
+{
+  if (c->bad) {
+    fprintf(stderr, MYNAME ": %s: %d value(s) off by more than %g\n",
+            c->what, c->bad, c->tol);
+    failures++;
+  }
+  if (verbose) {
+    printf("%-32s max diff %.3g (tolerance %g)\n", c->what, c->worst, c->tol);
+  }
+}
+
+/*
+ * GPS_Math_Datum_Transform_Array() and GPS_Math_Datum_Transform() for
+ * every known datum to and from WGS 84, against
+ * GPS_Math_Known_Datum_To_WGS84_M() and GPS_Math_WGS84_To_Known_Datum_M().
+ */
+static void
+check_datums(int npts)
+{
+  std::vector<double> lat, lon, ht;
+  int32 wgs84 = GPS_Lookup_Datum_Index("WGS 84");
+  check_t to_pos, to_ht, from_pos, from_ht, single;
+  char detail[128];
+
+  if (wgs84 < 0) {
+    fprintf(stderr, MYNAME ": WGS 84 isn't a known datum.\n");
+    exit(1);
+  }
+
+  /* The equator, the antimeridian, near the poles, and random points. */
+  static const double edge[][3] = {
+    { 0, 0, 0 }, { 0, 180, 0 }, { 0, -180, 0 }, { 89.9, 45, 0 },
+    { -89.9, -135, 0 }, { 45, 179.9999, 8848 }, { -45, -0.0001, -400 }
+  };
+  for (unsigned int i = 0; i < sizeof(edge) / sizeof(edge[0]); i++) {
+    lat.push_back(edge[i][0]);
+    lon.push_back(edge[i][1]);
+    ht.push_back(edge[i][2]);
+  }
+  while ((int) lat.size() < npts) {
+    lat.push_back(uniform(-89.5, 89.5));
+    lon.push_back(uniform(-180, 180));
+    ht.push_back(uniform(-100, 5000));
+  }
+
+  int n = lat.size();
+  std::vector<double> olat(n), olon(n), oht(n);
+
+  check_init(&to_pos, "datum to WGS 84, position", DATUM_TOL_DEG);
+  check_init(&to_ht, "datum to WGS 84, height", DATUM_TOL_M);
+  check_init(&from_pos, "WGS 84 to datum, position", DATUM_TOL_DEG);
+  check_init(&from_ht, "WGS 84 to datum, height", DATUM_TOL_M);
+  check_init(&single, "single point transform", DATUM_TOL_DEG);
+
+  for (int32 d = 0; GPS_Math_Get_Datum_Name(d); d++) {
+    GPS_ODatum_Transform to, from;
+    const char* name = GPS_Math_Get_Datum_Name(d);
+
+    GPS_Math_Datum_Transform_Init(&to, d, wgs84);
+    GPS_Math_Datum_Transform_Init(&from, wgs84, d);
+
+    GPS_Math_Datum_Transform_Array(&to, n, &lat[0], &lon[0], &ht[0],
+                                   &olat[0], &olon[0], &oht[0]);
+    for (int i = 0; i < n; i++) {
+      double rlat, rlon, rht;
+      GPS_Math_Known_Datum_To_WGS84_M(lat[i], lon[i], ht[i], &rlat, &rlon, &rht, d);
+      snprintf(detail, sizeof(detail), "%s, point %d", name, i);
+      check_value(&to_pos, olat[i], rlat, detail);
+      check_value(&to_pos, olon[i], rlon, detail);
+      check_value(&to_ht, oht[i], rht, detail);
+    }
+
+    GPS_Math_Datum_Transform_Array(&from, n, &lat[0], &lon[0], &ht[0],
+                                   &olat[0], &olon[0], &oht[0]);
+    for (int i = 0; i < n; i++) {
+      double rlat, rlon, rht;
+      GPS_Math_WGS84_To_Known_Datum_M(lat[i], lon[i], ht[i], &rlat, &rlon, &rht, d);
+      snprintf(detail, sizeof(detail), "%s, point %d", name, i);
+      check_value(&from_pos, olat[i], rlat, detail);
+      check_value(&from_pos, olon[i], rlon, detail);
+      check_value(&from_ht, oht[i], rht, detail);
+    }
+
+    /* The single point entry is the same loop; check it agrees. */
+    for (int i = 0; i < n; i += 97) {
+      double slat, slon, sht;
+      GPS_Math_Datum_Transform(&to, lat[i], lon[i], ht[i], &slat, &slon, &sht);
+      GPS_Math_Datum_Transform_Array(&to, 1, &lat[i], &lon[i], &ht[i],
+                                     &olat[i], &olon[i], &oht[i]);
+      snprintf(detail, sizeof(detail), "%s, point %d", name, i);
+      check_value(&single, slat, olat[i], detail);
+      check_value(&single, slon, olon[i], detail);
+    }
+  }
+
+  check_done(&to_pos);
+  check_done(&to_ht);
+  check_done(&from_pos);
+  check_done(&from_ht);
+  check_done(&single);
+}
+
+/*
+ * gcdist_heading_vec() and the kernels beside it against gcdist() and
+ * heading_true_degrees() leg by leg.
+ */
+static void
+check_great_circle(int npts)
+{
+  std::vector<double> lat, lon, tim;
+  check_t dist, hdg, dist_only, hdg_only, cum, speed;
+  char detail[64];
+
+  /*
+   * Edge cases first, in degrees: zero-length legs, across the
+   * antimeridian both ways, over and onto the poles, along the equator
+   * and to the antipode.
+   */
+  static const double edge[][2] = {
+    { 10, 20 }, { 10, 20 }, { 10, 20 },
+    { 0, 179.9999 }, { 0, -179.9999 }, { 0.0001, 179.9999 },
+    { 89.9999, 0 }, { 90, 0 }, { 90, 90 }, { 89.9999, 180 },
+    { -90, 0 }, { -90, 0 }, { -89.9999, -45 },
+    { 0, 0 }, { 0, 1e-9 }, { 0, 180 }, { 0, 0 }, { 0, -180 }
+  };
+  for (unsigned int i = 0; i < sizeof(edge) / sizeof(edge[0]); i++) {
+    lat.push_back(edge[i][0] * M_PI / 180.0);
+    lon.push_back(edge[i][1] * M_PI / 180.0);
+  }
+  /* Then random points: long legs, and short ones like a real track. */
+  while ((int) lat.size() < npts / 2) {
+    lat.push_back(uniform(-M_PI / 2, M_PI / 2));
+    lon.push_back(uniform(-M_PI, M_PI));
+  }
+  while ((int) lat.size() < npts) {
+    double la = lat.back() + uniform(-1e-4, 1e-4);
+    double lo = lon.back() + uniform(-1e-4, 1e-4);
+    lat.push_back(la < -M_PI / 2 ? -M_PI / 2 : la > M_PI / 2 ? M_PI / 2 : la);
+    lon.push_back(lo);
+  }
+  /* Times with repeats, so some legs have no elapsed time. */
+  for (int i = 0; i < (int) lat.size(); i++) {
+    tim.push_back(i - (i % 7 == 3));
+  }
+
+  int n = lat.size();
+  std::vector<double> d(n), h(n), d1(n), h1(n), c(n), sp(n);
+
+  check_init(&dist, "gcdist_heading_vec distance", GC_TOL_REL, 1);
+  check_init(&hdg, "gcdist_heading_vec heading", GC_TOL_REL, 1);
+  check_init(&dist_only, "gcdist_vec", GC_TOL_REL, 1);
+  check_init(&hdg_only, "heading_true_degrees_vec", GC_TOL_REL, 1);
+  check_init(&cum, "cumdist_vec", GC_TOL_REL, 1);
+  check_init(&speed, "speed_vec", GC_TOL_REL, 1);
+
+  gcdist_heading_vec(&lat[0], &lon[0], n, &d[0], &h[0]);
+  gcdist_vec(&lat[0], &lon[0], n, &d1[0]);
+  heading_true_degrees_vec(&lat[0], &lon[0], n, &h1[0]);
+  cumdist_vec(&d[0], n, &c[0]);
+  speed_vec(&d[0], &tim[0], n, 3600.0, &sp[0]);
+
+  double total = 0;
+  for (int i = 0; i < n; i++) {
+    double want_d = 0, want_h = 0, want_s = NAN;
+    if (i > 0) {
+      want_d = gcdist(lat[i-1], lon[i-1], lat[i], lon[i]);
+      want_h = heading_true_degrees(lat[i-1], lon[i-1], lat[i], lon[i]);
+      double dt = fabs(tim[i] - tim[i-1]);
+      if (dt > 0) {
+        want_s = want_d / (dt / 3600.0);
+      }
+    }
+    total += want_d;
+    snprintf(detail, sizeof(detail), "leg %d", i);
+    check_value(&dist, d[i], want_d, detail);
+    check_value(&hdg, h[i], want_h, detail);
+    check_value(&dist_only, d1[i], want_d, detail);
+    check_value(&hdg_only, h1[i], want_h, detail);
+    check_value(&cum, c[i], total, detail);
+    check_value(&speed, sp[i], want_s, detail);
+  }
+
+  check_done(&dist);
+  check_done(&hdg);
+  check_done(&dist_only);
+  check_done(&hdg_only);
+  check_done(&cum);
+  check_done(&speed);
+}
+
+static void
+usage(void)
+{
+  fprintf(stderr, "Usage: " MYNAME " [-n points] [-v]\n");
+  exit(1);
+}
+
+int
+main(int argc, char* argv[])
+{
+  int npts = 2000;
+  int c;
+
+  while ((c = getopt(argc, argv, "n:v")) != -1) {
+    switch (c) {
+    case 'n':
+      npts = atoi(optarg);
+      break;
+    case 'v':
+      verbose = 1;
+      break;
+    default:
+      usage();
+    }
+  }
+  if ((optind != argc) || (npts < 1)) {
+    usage();
+  }
+
+  check_datums(npts);
+  check_great_circle(npts);
+
+  if (failures) {
+    fprintf(stderr, MYNAME ": %d check(s) failed.\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,112 @@
+/*
+    Check the string pool behind intern().
+
+    Copyright (C) 2015 Robert Lipe, robertlipe+source@gpsbabel.org
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111 USA
+
+ */
+
+/*
+ * This is a test tool, not part of gpsbabel proper.
+ *
+ * Build:   make poolcheck
+ * Use:     ./poolcheck
+ *
+ * Checked are intern() and intern_flush() in util.cc: equal strings come
+ * back sharing one buffer, empty strings pass through, a flush forgets
+ * what was pooled, and the pool stops growing once it is full.  Every
+ * failed check is reported and makes the exit status non-zero.
+ */
+
+#include <stdio.h>
+
+#include <QtCore/QString>
+
+#include "defs.h"
+
+#define MYNAME "poolcheck"
+
+/* Far more distinct strings than the pool will ever hold. */
+#define FLOOD	(1 << 20)
+
+static int failures = 0;
+
+static void
+check(int ok, const char* what)
+{
+  if (!ok) {
+    fprintf(stderr, MYNAME ": %s\n", what);
+    failures++;
+  }
+}
+
+/* A copy of s in a buffer of its own, as a reader would produce it. */
+static QString
+fresh(const char* s)
+{
+  return QString::fromUtf8(s);
+}
+
+static int
+shared(const QString& a, const QString& b)
+{
+  return a.constData() == b.constData();
+}
+
+int
+main(int argc, char* argv[])
+{
+  (void) argv;
+  if (argc != 1) {
+    fprintf(stderr, "Usage: " MYNAME "\n");
+    return 1;
+  }
+
+  QString empty = intern(QString());
+  check(empty.isEmpty(), "empty string didn't pass through");
+
+  QString first = intern(fresh("Flag, Blue"));
+  QString second = intern(fresh("Flag, Blue"));
+  check(first == "Flag, Blue", "pooled string changed");
+  check(shared(first, second), "equal strings don't share a buffer");
+
+  QString other = intern(fresh("Flag, Red"));
+  check(!shared(first, other), "different strings share a buffer");
+
+  intern_flush();
+  QString after = fresh("Flag, Blue");
+  check(shared(intern(after), after), "flushed pool still returns old string");
+  check(!shared(intern(after), first), "flushed pool still holds old string");
+
+  /* Fill the pool; it has to stop taking new strings at some point. */
+  intern_flush();
+  QString early = intern(fresh("early"));
+  for (int i = 0; i < FLOOD; i++) {
+    intern(QString::number(i));
+  }
+  QString late = fresh("late");
+  check(shared(intern(late), late), "full pool didn't pass new string through");
+  check(!shared(intern(fresh("late")), late), "pool kept growing when full");
+  check(shared(intern(fresh("early")), early), "full pool lost a pooled string");
+
+  intern_flush();
+
+  if (failures) {
+    fprintf(stderr, MYNAME ": %d check(s) failed.\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,190 @@
+/*
+    Client for gpsbabel --serve: run one conversion through the socket.
+
+    Copyright (C) 2015 Robert Lipe, robertlipe+source@gpsbabel.org
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111 USA
+
+ */
+
+/*
+ * This is a test tool, not part of gpsbabel proper.  POSIX only.
+ *
+ * Build:   make serveclient
+ * Use:     gpsbabel --serve /tmp/gb.sock &
+ *          ./serveclient /tmp/gb.sock -i gpx -f - -o unicsv -F - < in.gpx
+ *
+ * The arguments after the socket are sent as the job's command line and
+ * standard input as its input; the job's output goes to standard output,
+ * its messages to standard error and its exit status becomes ours.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define MYNAME "serveclient"
+
+static void
+die(const char* msg)
+{
+  fprintf(stderr, MYNAME ": %s: %s\n", msg, strerror(errno));
+  exit(1);
+}
+
+static void
+write_all(int fd, const char* buf, size_t len)
+{
+  while (len > 0) {
+    ssize_t res = write(fd, buf, len);
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      die("write");
+    }
+    buf += res;
+    len -= res;
+  }
+}
+
+int
+main(int argc, char* argv[])
+{
+  struct sockaddr_un sa;
+  unsigned char hdr[5];
+  int hdr_len = 0;
+  size_t left = 0;		/* of the current frame's data */
+  unsigned int status = 0;
+  int have_status = 0;
+  int input_open = 1;
+  int fd;
+
+  if (argc < 2) {
+    fprintf(stderr, "Usage: " MYNAME " SOCKET [gpsbabel arguments...]\n");
+    return 1;
+  }
+  signal(SIGPIPE, SIG_IGN);
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sun_family = AF_UNIX;
+  if (strlen(argv[1]) >= sizeof(sa.sun_path)) {
+    fprintf(stderr, MYNAME ": socket path too long\n");
+    return 1;
+  }
+  strcpy(sa.sun_path, argv[1]);
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    die("socket");
+  }
+  if (connect(fd, (struct sockaddr*) &sa, sizeof(sa)) < 0) {
+    die(argv[1]);
+  }
+
+  for (int i = 2; i < argc; i++) {
+    write_all(fd, argv[i], strlen(argv[i]) + 1);
+  }
+  write_all(fd, "", 1);
+
+  /*
+   * Feed standard input and drain the reply at the same time, as the
+   * job may write before it has read all of its input.  The reply is
+   * frames of a type byte, a 4 byte length and the data: 'O' output,
+   * 'E' messages and last 'X', the exit status.
+   */
+  for (;;) {
+    struct pollfd pfd[2];
+    char buf[65536];
+    int n = 0;
+
+    pfd[n].fd = fd;
+    pfd[n].events = POLLIN;
+    n++;
+    if (input_open) {
+      pfd[n].fd = 0;
+      pfd[n].events = POLLIN;
+      n++;
+    }
+    if (poll(pfd, n, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      die("poll");
+    }
+    if (input_open && pfd[1].revents) {
+      ssize_t res = read(0, buf, sizeof(buf));
+      if (res < 0 && errno == EINTR) {
+        continue;
+      }
+      if (res <= 0) {
+        shutdown(fd, SHUT_WR);
+        input_open = 0;
+      } else {
+        write_all(fd, buf, res);
+      }
+    }
+    if (pfd[0].revents) {
+      ssize_t res = read(fd, buf, sizeof(buf));
+      if (res < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        die("read");
+      }
+      if (res == 0) {
+        break;
+      }
+      for (ssize_t i = 0; i < res;) {
+        if (hdr_len < 5) {
+          hdr[hdr_len++] = buf[i++];
+          if (hdr_len == 5) {
+            left = ((size_t) hdr[1] << 24) | (hdr[2] << 16) | (hdr[3] << 8) | hdr[4];
+          }
+        } else {
+          size_t len = ((size_t)(res - i) < left) ? (size_t)(res - i) : left;
+          if (hdr[0] == 'O') {
+            write_all(1, buf + i, len);
+          } else if (hdr[0] == 'E') {
+            write_all(2, buf + i, len);
+          } else if (hdr[0] == 'X') {
+            for (size_t k = 0; k < len; k++) {
+              status = (status << 8) | (unsigned char) buf[i + k];
+            }
+          }
+          i += len;
+          left -= len;
+        }
+        if ((hdr_len == 5) && (left == 0)) {
+          have_status |= (hdr[0] == 'X');
+          hdr_len = 0;
+        }
+      }
+    }
+  }
+
+  close(fd);
+
+  if (!have_status) {
+    fprintf(stderr, MYNAME ": connection closed without a status\n");
+    return 1;
+  }
+  return status;
+}
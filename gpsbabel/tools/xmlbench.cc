@@ -0,0 +1,286 @@
+/*
+    Time gpsbabel::XmlStreamWriter against the QXmlStreamWriter based
+    writer it replaced.
+
+    Copyright (C) 2015 Robert Lipe, robertlipe+source@gpsbabel.org
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111 USA
+
+ */
+
+/*
+ * This is a test tool, not part of gpsbabel proper.
+ *
+ * Build:   make xmlbench
+ * Use:     ./xmlbench [-n points] [-r runs] [-d dir]
+ *
+ * A track of the given size is written as GPX with the calls gpx.cc
+ * makes, once through each writer, to files in dir (default /tmp).
+ * The best of the runs is reported for each, with whether the new one
+ * reaches the goal of three times the speed of the old.  The two files
+ * must be identical or the exit status is non-zero.  The strings are
+ * made before the clock starts, so only the writers are timed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QString>
+#include <QtCore/QTextCodec>
+#include <QtCore/QVector>
+#include <QtCore/QXmlStreamWriter>
+
+#include "src/core/xmlstreamwriter.h"
+
+#define MYNAME "xmlbench"
+
+#define SPEEDUP_GOAL	3.0
+
+/*
+ * The writer as it was: QXmlStreamWriter with a codec that encodes to
+ * UTF-8 and blanks control characters.
+ */
+class OldXmlTextCodec : public QTextCodec
+{
+public:
+  OldXmlTextCodec() : QTextCodec()
+  {
+    utf8Codec = QTextCodec::codecForName("UTF-8");
+  }
+  virtual QByteArray name() const
+  {
+    return QByteArray("UTF-8-XML-BENCH");
+  }
+  virtual int mibEnum() const
+  {
+    return 2001;
+  }
+protected:
+  virtual QByteArray convertFromUnicode(const QChar* chars, int len, QTextCodec::ConverterState* state) const
+  {
+    state->flags |= QTextCodec::IgnoreHeader;
+    QByteArray r = utf8Codec->fromUnicode(chars, len, state);
+    char* data = r.data();
+    for (int i = 0; i < r.size(); i++) {
+      if ((0x00 <= data[i] && data[i] <= 0x08) ||
+          (0x0b <= data[i] && data[i] <= 0x0c) ||
+          (0x0e <= data[i] && data[i] <= 0x1f)) {
+        data[i] = ' ';
+      }
+    }
+    return r;
+  }
+  virtual QString convertToUnicode(const char* chars, int len, QTextCodec::ConverterState* state) const
+  {
+    return utf8Codec->toUnicode(chars, len, state);
+  }
+private:
+  QTextCodec* utf8Codec;
+};
+
+static OldXmlTextCodec* old_codec = NULL;
+
+class OldXmlStreamWriter : public QXmlStreamWriter
+{
+public:
+  OldXmlStreamWriter(QFile* f) : QXmlStreamWriter(f)
+  {
+    setCodec(old_codec);
+  }
+  void writeStartDocument(void)
+  {
+    writeProcessingInstruction("xml version=\"1.0\" encoding=\"UTF-8\"");
+  }
+  void writeOptionalTextElement(const QString& qualifiedName, const QString& text)
+  {
+    if (!text.isEmpty()) {
+      QXmlStreamWriter::writeTextElement(qualifiedName, text);
+    }
+  }
+};
+
+/* What goes into the file, made up front. */
+typedef struct {
+  QVector<QString> lat, lon, ele, time, name;
+} track_t;
+
+static void
+make_track(track_t* trk, int n)
+{
+  double lat = 47.6, lon = -122.3;
+
+  srand(1);
+  for (int i = 0; i < n; i++) {
+    lat += (rand() % 2001 - 1000) * 1e-7;
+    lon += (rand() % 2001 - 1000) * 1e-7;
+    trk->lat.append(QString::number(lat, 'f', 9));
+    trk->lon.append(QString::number(lon, 'f', 9));
+    trk->ele.append(QString::number((rand() % 100000) / 100.0, 'f', 6));
+    trk->time.append(QString("2015-06-%1T%2:%3:%4Z")
+                     .arg(1 + (i / 86400) % 28, 2, 10, QChar('0'))
+                     .arg((i / 3600) % 24, 2, 10, QChar('0'))
+                     .arg((i / 60) % 60, 2, 10, QChar('0'))
+                     .arg(i % 60, 2, 10, QChar('0')));
+    /* Every so often a name that needs escaping. */
+    trk->name.append((i % 50) ? QString() :
+                     QString::fromUtf8("Caf\xc3\xa9 <%1> & \"more\"").arg(i));
+  }
+}
+
+/* The calls gpx_write() and gpx_track_disp() make for a track. */
+template <class W>
+static void
+write_track(W& w, const track_t& trk)
+{
+  w.setAutoFormatting(true);
+  w.writeStartDocument();
+  w.writeStartElement("gpx");
+  w.writeAttribute("version", "1.0");
+  w.writeAttribute("creator", "GPSBabel - http://www.gpsbabel.org");
+  w.writeAttribute("xmlns", "http://www.topografix.com/GPX/1/0");
+  w.writeTextElement("time", "1970-01-01T00:00:00Z");
+  w.writeStartElement("trk");
+  w.writeTextElement("name", "xmlbench");
+  w.writeStartElement("trkseg");
+  for (int i = 0; i < trk.lat.size(); i++) {
+    w.writeStartElement("trkpt");
+    w.writeAttribute("lat", trk.lat.at(i));
+    w.writeAttribute("lon", trk.lon.at(i));
+    w.writeTextElement("ele", trk.ele.at(i));
+    w.writeOptionalTextElement("time", trk.time.at(i));
+    w.writeOptionalTextElement("name", trk.name.at(i));
+    w.writeEndElement();
+  }
+  w.writeEndElement();
+  w.writeEndElement();
+  w.writeEndElement();
+  w.writeEndDocument();
+}
+
+static qint64
+time_old(const QString& fname, const track_t& trk)
+{
+  QFile f(fname);
+  QElapsedTimer timer;
+
+  if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    fprintf(stderr, MYNAME ": Cannot write '%s'.\n", qPrintable(fname));
+    exit(1);
+  }
+  timer.start();
+  {
+    OldXmlStreamWriter w(&f);
+    write_track(w, trk);
+  }
+  f.close();
+  return timer.nsecsElapsed();
+}
+
+static qint64
+time_new(const QString& fname, const track_t& trk)
+{
+  QFile f(fname);
+  QElapsedTimer timer;
+
+  if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    fprintf(stderr, MYNAME ": Cannot write '%s'.\n", qPrintable(fname));
+    exit(1);
+  }
+  timer.start();
+  {
+    gpsbabel::XmlStreamWriter w(&f);
+    write_track(w, trk);
+  }
+  f.close();
+  return timer.nsecsElapsed();
+}
+
+static void
+usage(void)
+{
+  fprintf(stderr, "Usage: " MYNAME " [-n points] [-r runs] [-d dir]\n");
+  exit(1);
+}
+
+int
+main(int argc, char* argv[])
+{
+  int points = 500000;
+  int runs = 5;
+  const char* dir = "/tmp";
+  qint64 best_old = -1, best_new = -1;
+  track_t trk;
+  int c;
+
+  while ((c = getopt(argc, argv, "n:r:d:")) != -1) {
+    switch (c) {
+    case 'n':
+      points = atoi(optarg);
+      break;
+    case 'r':
+      runs = atoi(optarg);
+      break;
+    case 'd':
+      dir = optarg;
+      break;
+    default:
+      usage();
+    }
+  }
+  if ((optind != argc) || (points < 1) || (runs < 1)) {
+    usage();
+  }
+
+  old_codec = new OldXmlTextCodec();
+  make_track(&trk, points);
+
+  QString fold = QString("%1/xmlbench-old.%2.gpx").arg(dir).arg(getpid());
+  QString fnew = QString("%1/xmlbench-new.%2.gpx").arg(dir).arg(getpid());
+
+  for (int i = 0; i < runs; i++) {
+    qint64 t = time_old(fold, trk);
+    if ((best_old < 0) || (t < best_old)) {
+      best_old = t;
+    }
+    t = time_new(fnew, trk);
+    if ((best_new < 0) || (t < best_new)) {
+      best_new = t;
+    }
+  }
+
+  QFile a(fold), b(fnew);
+  int same = a.open(QIODevice::ReadOnly) && b.open(QIODevice::ReadOnly) &&
+             (a.readAll() == b.readAll());
+  qint64 size = a.size();
+  a.close();
+  b.close();
+  QFile::remove(fold);
+  QFile::remove(fnew);
+
+  printf("%d points, %lld bytes, best of %d:\n", points, (long long) size, runs);
+  printf("  QXmlStreamWriter    %9.2f ms\n", best_old / 1e6);
+  printf("  XmlStreamWriter     %9.2f ms\n", best_new / 1e6);
+  double speedup = (double) best_old / (best_new ? best_new : 1);
+  printf("  speedup             %9.2fx\n", speedup);
+  printf("goal of %.0fx %s\n", SPEEDUP_GOAL, (speedup >= SPEEDUP_GOAL) ? "met" : "NOT met");
+  if (!same) {
+    fprintf(stderr, MYNAME ": The two writers' output differs.\n");
+    return 1;
+  }
+  return 0;
+}
@@ -210,6 +210,18 @@ trackfilter_opt_count(void)
   return res;
 }
 
+/* track_list's tracks in order, for route_parallel() */
+static QVector<route_head*>
+trackfilter_tracks(void)
+{
+  QVector<route_head*> tracks(track_ct);
+
+  for (int i = 0; i < track_ct; i++) {
+    tracks[i] = track_list[i].track;
+  }
+  return tracks;
+}
+
 static int
 trackfilter_parse_time_opt(const char* arg)
 {
@@ -693,6 +705,14 @@ trackfilter_split(void)
 
   curr = NULL;	/* will be set by first new track */
 
+  /* Leg lengths along the original order, before buff[] is reshuffled. */
+  QVector<double> legs;
+  if (distance > 0) {
+    track_arrays ta(buff, count);
+    legs.resize(count);
+    gcdist_vec(ta.lat.constData(), ta.lon.constData(), count, legs.data());
+  }
+
   for (i=0, j=1; j<count; i++, j++) {
     int new_track_flag;
 
@@ -716,12 +736,7 @@ trackfilter_split(void)
       new_track_flag = 1;
 
       if (distance > 0) {
-        double rt1 = RAD(buff[i]->latitude);
-        double rn1 = RAD(buff[i]->longitude);
-        double rt2 = RAD(buff[j]->latitude);
-        double rn2 = RAD(buff[j]->longitude);
-        double curdist = gcdist(rt1, rn1, rt2, rn2);
-        curdist = radtomiles(curdist);
+        double curdist = radtomiles(legs[j]);
         if (curdist <= distance) {
           new_track_flag = 0;
         }
@@ -767,95 +782,115 @@ trackfilter_split(void)
 * option "move"
 *******************************************************************************/
 
+static time_t move_delta;
+
 static void
-trackfilter_move(void)
+trackfilter_move_track(route_head* track, int i)
 {
-  int i;
   queue* elem, *tmp;
   Waypoint* wpt;
-  time_t delta;
 
-  delta = trackfilter_parse_time_opt(opt_move);
-  if (delta == 0) {
-    return;
+  QUEUE_FOR_EACH((queue*)&track->waypoint_list, elem, tmp) {
+    wpt = (Waypoint*)elem;
+    wpt->creation_time += move_delta;
   }
 
-  for (i = 0; i < track_ct; i++) {
-    route_head* track = track_list[i].track;
-    QUEUE_FOR_EACH((queue*)&track->waypoint_list, elem, tmp) {
-      wpt = (Waypoint*)elem;
-      wpt->creation_time += delta;
-    }
+  track_list[i].first_time = track_list[i].first_time.addSecs(move_delta);
+  track_list[i].last_time = track_list[i].last_time.addSecs(move_delta);
+}
 
-    track_list[i].first_time = track_list[i].first_time.addSecs(delta);
-    track_list[i].last_time = track_list[i].last_time.addSecs(delta);
+static void
+trackfilter_move(void)
+{
+  move_delta = trackfilter_parse_time_opt(opt_move);
+  if (move_delta == 0) {
+    return;
   }
+
+  QVector<route_head*> tracks = trackfilter_tracks();
+  route_parallel(tracks.constData(), track_ct, trackfilter_move_track, NULL);
 }
 
 /*******************************************************************************
 * options "fix", "course", "speed"
 *******************************************************************************/
 
+static fix_type synth_fix;
+static int synth_nsats;
+
 static void
-trackfilter_synth(void)
+trackfilter_synth_track(route_head* track, int index)
 {
-  int i;
-  queue* elem, *tmp;
-  Waypoint* wpt;
-
-  double oldlat = -999;
-  double oldlon = -999;
-  time_t oldtime = 0;
-  int first = 1;
-  fix_type fix;
-  int nsats = 0;
-
-  fix = trackfilter_parse_fix(&nsats);
+  int j;
+  track_arrays ta(track);
+  int n = ta.size();
+  QVector<double> course;
+  QVector<double> dist;
+  QVector<double> secs;
+  QVector<double> speed;
+
+  if (opt_course) {
+    course.resize(n);
+  }
+  if (opt_speed) {
+    dist.resize(n);
+    secs.resize(n);
+    speed.resize(n);
+  }
+  if (opt_course || opt_speed) {
+    gcdist_heading_vec(ta.lat.constData(), ta.lon.constData(), n,
+                       opt_speed ? dist.data() : NULL,
+                       opt_course ? course.data() : NULL);
+  }
+  if (opt_speed) {
+    /* Synthesized speeds have always worked in whole seconds. */
+    for (j = 0; j < n; j++) {
+      dist[j] = radtometers(dist[j]);
+      secs[j] = ta.wpt[j]->GetCreationTime().toTime_t();
+    }
+    speed_vec(dist.constData(), secs.constData(), n, 1.0, speed.data());
+  }
 
-  for (i = 0; i < track_ct; i++) {
-    route_head* track = track_list[i].track;
-    first = 1;
-    QUEUE_FOR_EACH((queue*)&track->waypoint_list, elem, tmp) {
-      wpt = (Waypoint*)elem;
-      if (opt_fix) {
-        wpt->fix = fix;
-        if (wpt->sat == 0) {
-          wpt->sat = nsats;
-        }
+  for (j = 0; j < n; j++) {
+    Waypoint* wpt = ta.wpt[j];
+    if (opt_fix) {
+      wpt->fix = synth_fix;
+      if (wpt->sat == 0) {
+        wpt->sat = synth_nsats;
       }
-      if (first) {
-        if (opt_course) {
-          WAYPT_SET(wpt, course, 0);
-        }
-        if (opt_speed) {
-          WAYPT_SET(wpt, speed, 0);
-        }
-        first = 0;
-      } else {
-        if (opt_course) {
-          WAYPT_SET(wpt, course, heading_true_degrees(RAD(oldlat),
-                    RAD(oldlon),RAD(wpt->latitude),
-                    RAD(wpt->longitude)));
-        }
-        if (opt_speed) {
-          if (oldtime != wpt->GetCreationTime().toTime_t()) {
-            WAYPT_SET(wpt, speed, radtometers(gcdist(
-                                                RAD(oldlat), RAD(oldlon),
-                                                RAD(wpt->latitude),
-                                                RAD(wpt->longitude))) /
-                      labs(wpt->GetCreationTime().toTime_t()-oldtime));
-          } else {
-            WAYPT_UNSET(wpt, speed);
-          }
+    }
+    if (j == 0) {
+      if (opt_course) {
+        WAYPT_SET(wpt, course, 0);
+      }
+      if (opt_speed) {
+        WAYPT_SET(wpt, speed, 0);
+      }
+    } else {
+      if (opt_course) {
+        WAYPT_SET(wpt, course, course[j]);
+      }
+      if (opt_speed) {
+        if (secs[j] != secs[j-1]) {
+          WAYPT_SET(wpt, speed, speed[j]);
+        } else {
+          WAYPT_UNSET(wpt, speed);
         }
       }
-      oldlat = wpt->latitude;
-      oldlon = wpt->longitude;
-      oldtime = wpt->GetCreationTime().toTime_t();
     }
   }
 }
 
+static void
+trackfilter_synth(void)
+{
+  synth_nsats = 0;
+  synth_fix = trackfilter_parse_fix(&synth_nsats);
+
+  QVector<route_head*> tracks = trackfilter_tracks();
+  route_parallel(tracks.constData(), track_ct, trackfilter_synth_track, NULL);
+}
+
 
 /*******************************************************************************
 * option: "start" / "stop"
@@ -892,52 +927,67 @@ trackfilter_range_check(const char* timestr)
   return mkgmtime(&time);
 }
 
+static time_t range_start, range_stop;
+static QVector<int> range_dropped;
+
+static void
+trackfilter_range_track(route_head* track, int i)
+{
+  queue* elem, *tmp;
+  int inside = 0;
+
+  QUEUE_FOR_EACH((queue*)&track->waypoint_list, elem, tmp) {
+    Waypoint* wpt = (Waypoint*)elem;
+    if (wpt->creation_time.isValid()) {
+      inside = ((wpt->GetCreationTime().toTime_t() >= range_start) && (wpt->GetCreationTime().toTime_t() <= range_stop));
+    }
+    // If the time is mangled so horribly that it's
+    // negative, toss it.
+    if (!wpt->creation_time.isValid()) {
+      inside = 0;
+    }
+
+    if (! inside) {
+      track_del_wpt(track, wpt);
+      delete wpt;
+      range_dropped[i]++;
+    }
+  }
+}
+
+static void
+trackfilter_range_finish(route_head* track, int i)
+{
+  if (track->rte_waypt_ct == 0) {
+    track_del_head(track);
+    track_list[i].track = NULL;
+  }
+}
+
 static int
 trackfilter_range(void)		/* returns number of track points left after filtering */
 {
-  time_t start, stop;
-  queue* elem, *tmp;
-  int i, dropped, inside = 0;
+  int i, dropped;
 
   if (opt_start != 0) {
-    start = trackfilter_range_check(opt_start);
+    range_start = trackfilter_range_check(opt_start);
   } else {
-    start = 0;
+    range_start = 0;
   }
 
   if (opt_stop != 0) {
-    stop = trackfilter_range_check(opt_stop);
+    range_stop = trackfilter_range_check(opt_stop);
   } else {
-    stop = 0x7FFFFFFF;
+    range_stop = 0x7FFFFFFF;
   }
 
-  dropped = inside = 0;
+  range_dropped.fill(0, track_ct);
+  QVector<route_head*> tracks = trackfilter_tracks();
+  route_parallel(tracks.constData(), track_ct, trackfilter_range_track, trackfilter_range_finish);
 
+  dropped = 0;
   for (i = 0; i < track_ct; i++) {
-    route_head* track = track_list[i].track;
-
-    QUEUE_FOR_EACH((queue*)&track->waypoint_list, elem, tmp) {
-      Waypoint* wpt = (Waypoint*)elem;
-      if (wpt->creation_time.isValid()) {
-        inside = ((wpt->GetCreationTime().toTime_t() >= start) && (wpt->GetCreationTime().toTime_t() <= stop));
-      }
-      // If the time is mangled so horribly that it's
-      // negative, toss it.
-      if (!wpt->creation_time.isValid()) {
-        inside = 0;
-      }
-
-      if (! inside) {
-        track_del_wpt(track, wpt);
-        delete wpt;
-        dropped++;
-      }
-    }
-
-    if (track->rte_waypt_ct == 0) {
-      track_del_head(track);
-      track_list[i].track = NULL;
-    }
+    dropped += range_dropped[i];
   }
 
   if ((track_pts > 0) && (dropped == track_pts)) {
@@ -1101,34 +1151,73 @@ trackfilter_faketime_check(const char* timestr)
   return result;
 }
 
+static faketime_t faketime;
+static QVector<int> faketime_first;	/* step count before each track */
+
 static int
-trackfilter_faketime(void)             /* returns number of track points left after filtering */
+trackfilter_faketime_wanted(const Waypoint* wpt)
 {
-  faketime_t faketime;
+  return !wpt->creation_time.isValid() || faketime.force;
+}
 
+static void
+trackfilter_faketime_count(route_head* track, int i)
+{
   queue* elem, *tmp;
-  int i, dropped, inside = 0;
+  int n = 0;
 
-  if (opt_faketime != 0) {
-    faketime = trackfilter_faketime_check(opt_faketime);
+  if (faketime.force) {
+    n = track->rte_waypt_ct;
+  } else {
+    QUEUE_FOR_EACH((queue*)&track->waypoint_list, elem, tmp) {
+      n += trackfilter_faketime_wanted((Waypoint*)elem);
+    }
   }
+  faketime_first[i] = n;
+}
 
-  dropped = inside = 0;
-
-  for (i = 0; i < track_ct; i++) {
-    route_head* track = track_list[i].track;
+static void
+trackfilter_faketime_track(route_head* track, int i)
+{
+  queue* elem, *tmp;
+  time_t t = faketime.start + (time_t) faketime_first[i] * faketime.step;
 
-    QUEUE_FOR_EACH((queue*)&track->waypoint_list, elem, tmp) {
-      Waypoint* wpt = (Waypoint*)elem;
+  QUEUE_FOR_EACH((queue*)&track->waypoint_list, elem, tmp) {
+    Waypoint* wpt = (Waypoint*)elem;
 
-      if (opt_faketime != 0 && (!wpt->creation_time.isValid() || faketime.force)) {
-        wpt->creation_time = QDateTime::fromTime_t(faketime.start);
-        faketime.start += faketime.step;
-      }
+    if (trackfilter_faketime_wanted(wpt)) {
+      wpt->creation_time = QDateTime::fromTime_t(t);
+      t += faketime.step;
     }
   }
+}
 
-  return track_pts - dropped;
+static int
+trackfilter_faketime(void)             /* returns number of track points left after filtering */
+{
+  int i, n, total;
+
+  if (opt_faketime == 0) {
+    return track_pts;
+  }
+  faketime = trackfilter_faketime_check(opt_faketime);
+
+  /*
+   * Each changed point takes the next time step, in track order.
+   * Count the changes per track first so that every track knows
+   * where its steps start.
+   */
+  faketime_first.resize(track_ct);
+  QVector<route_head*> tracks = trackfilter_tracks();
+  route_parallel(tracks.constData(), track_ct, trackfilter_faketime_count, NULL);
+  for (i = 0, total = 0; i < track_ct; i++) {
+    n = faketime_first[i];
+    faketime_first[i] = total;
+    total += n;
+  }
+  route_parallel(tracks.constData(), track_ct, trackfilter_faketime_track, NULL);
+
+  return track_pts;
 }
 
 static int
@@ -1150,13 +1239,13 @@ trackfilter_points_are_same(const Waypoint* wpta, const Waypoint* wptb)
     (WAYPT_HAS(wpta,course) == WAYPT_HAS(wptb,course)) &&
     (wpta->course == wptb->course) &&
     (wpta->speed == wptb->speed) &&
-    (wpta->heartrate == wptb->heartrate) &&
-    (wpta->cadence == wptb->cadence) &&
-    (wpta->temperature == wptb->temperature);
+    (wpta->ext->heartrate == wptb->ext->heartrate) &&
+    (wpta->ext->cadence == wptb->ext->cadence) &&
+    (wpta->ext->temperature == wptb->ext->temperature);
 }
 
 static void
-trackfilter_segment_head(const route_head* rte)
+trackfilter_segment_head(route_head* rte, int)
 {
   queue* elem, *tmp;
   double avg_dist = 0;
@@ -1183,7 +1272,7 @@ trackfilter_segment_head(const route_head* rte)
           Waypoint* next_wpt = (Waypoint*) QUEUE_NEXT(&wpt->Q);
           if (trackfilter_points_are_same(prev_wpt, wpt) &&
               trackfilter_points_are_same(wpt, next_wpt)) {
-            track_del_wpt((route_head*)rte, wpt);
+            track_del_wpt(rte, wpt);
             continue;
           }
         }
@@ -1232,7 +1321,7 @@ trackfilter_init(const char* args)
 
   // Perform segmenting first.
   if (opt_segment) {
-    track_disp_all(trackfilter_segment_head, NULL, NULL);
+    track_disp_all_parallel(trackfilter_segment_head, NULL);
   }
 
   if (count > 0) {
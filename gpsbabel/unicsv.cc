@@ -19,7 +19,11 @@
     Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111 USA
 */
 
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
 #include <math.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
@@ -241,8 +245,6 @@ static field_t fields_def[] = {
   { NULL,		fld_terminator, 0 }
 };
 
-static QVector<field_e> unicsv_fields_tab;
-static int unicsv_fields_tab_ct;
 static double unicsv_altscale, unicsv_depthscale, unicsv_proximityscale
 ;
 static const char* unicsv_fieldsep;
@@ -252,11 +254,27 @@ static route_head* unicsv_track, *unicsv_route;
 static char unicsv_outp_flags[(fld_terminator + 8) / 8];
 static grid_type unicsv_grid_idx;
 static int unicsv_datum_idx;
+static GPS_ODatum_Transform unicsv_datum_xform;
 static char* opt_datum, *opt_grid, *opt_utc, *opt_filename, *opt_format, *opt_prec;
 static int unicsv_waypt_ct;
 static char unicsv_detect;
 static int llprec;
 
+/*
+ * Points read are collected and converted to WGS84 in batches before
+ * they are handed over to the waypoint, route and track lists.
+ */
+#define UNICSV_BATCH 256
+
+typedef struct {
+  Waypoint* wpt;
+  gpsdata_type type;
+  char convert;
+} unicsv_pending_t;
+
+static unicsv_pending_t unicsv_pending[UNICSV_BATCH];
+static int unicsv_pending_ct;
+
 static arglist_t unicsv_args[] = {
   {
     "datum", &opt_datum, "GPS datum (def. WGS 84)",
@@ -451,6 +469,615 @@ unicsv_adjust_time(const time_t time, time_t* date)
   return QDateTime::fromTime_t(res);
 }
 
+/*
+ * The header is compiled into one decoder per column.  Each line is then
+ * cut into fields in place and every field is handed, as a trimmed and
+ * NUL terminated byte span, straight to its column's decoder.  Numbers
+ * never take the detour through QString; only text that ends up in a
+ * QString member is converted.
+ */
+
+typedef struct {
+  Waypoint* wpt;
+  int utm_zone;
+  double utm_easting;
+  double utm_northing;
+  char utm_zc;
+  // Zones are always two bytes.  Spare one for null termination..
+  char bng_zone[3];
+  double bng_easting;
+  double bng_northing;
+  double swiss_easting;
+  double swiss_northing;
+  time_t date;
+  time_t time;
+  int usec;
+  char is_localtime;
+  struct tm ymd;
+  int src_datum;
+  int ns;
+  int ew;
+} unicsv_line_t;
+
+typedef void (*unicsv_decoder_t)(unicsv_line_t* ln, field_e type, const char* s);
+
+typedef struct {
+  field_e type;
+  unicsv_decoder_t decode;	/* NULL for unhandled columns */
+} unicsv_column_t;
+
+static QVector<unicsv_column_t> unicsv_columns;
+
+/* These follow QString::toDouble() and QString::toInt(): anything but a
+ * complete number is zero. */
+static double
+unicsv_to_double(const char* s)
+{
+  char* end;
+  double d;
+
+  if (strpbrk(s, "xX")) {	/* strtod() would take hex */
+    return 0;
+  }
+  d = strtod(s, &end);
+  if ((end == s) || *end) {
+    return 0;
+  }
+  return d;
+}
+
+static int
+unicsv_to_int(const char* s)
+{
+  char* end;
+  long l;
+
+  errno = 0;
+  l = strtol(s, &end, 10);
+  if ((end == s) || *end || errno || (l < INT_MIN) || (l > INT_MAX)) {
+    return 0;
+  }
+  return l;
+}
+
+static void
+unicsv_dec_latitude(unicsv_line_t* ln, field_e, const char* s)
+{
+  human_to_dec(s, &ln->wpt->latitude, &ln->wpt->longitude, 1);
+  ln->wpt->latitude = ln->wpt->latitude * ln->ns;
+}
+
+static void
+unicsv_dec_longitude(unicsv_line_t* ln, field_e, const char* s)
+{
+  human_to_dec(s, &ln->wpt->latitude, &ln->wpt->longitude, 2);
+  ln->wpt->longitude = ln->wpt->longitude * ln->ew;
+}
+
+static void
+unicsv_dec_text(unicsv_line_t* ln, field_e type, const char* s)
+{
+  Waypoint* wpt = ln->wpt;
+
+  switch (type) {
+  case fld_shortname:
+    wpt->shortname = QString::fromUtf8(s);
+    break;
+  case fld_description:
+    wpt->description = QString::fromUtf8(s);
+    break;
+  case fld_notes:
+    wpt->AllocExt()->notes = QString::fromUtf8(s);
+    break;
+  case fld_url:
+    wpt->AddUrlLink(QString::fromUtf8(s));
+    break;
+  case fld_symbol:
+    wpt->AllocExt()->icon_descr = intern(QString::fromUtf8(s));
+    break;
+  default:
+    break;
+  }
+}
+
+static void
+unicsv_dec_altitude(unicsv_line_t* ln, field_e, const char* s)
+{
+  double d;
+
+  if (parse_distance(s, &d, unicsv_altscale, MYNAME)) {
+    if (fabs(d) < fabs(unknown_alt)) {
+      ln->wpt->altitude = d;
+    }
+  }
+}
+
+static void
+unicsv_dec_grid(unicsv_line_t* ln, field_e type, const char* s)
+{
+  switch (type) {
+  case fld_utm_zone:
+    ln->utm_zone = unicsv_to_int(s);
+    break;
+  case fld_utm_easting:
+    ln->utm_easting = unicsv_to_double(s);
+    break;
+  case fld_utm_northing:
+    ln->utm_northing = unicsv_to_double(s);
+    break;
+  case fld_utm_zone_char:
+    ln->utm_zc = QString::fromUtf8(s)[0].toUpper().toLatin1();
+    break;
+  case fld_bng_zone:
+    strncpy(ln->bng_zone, s, sizeof(ln->bng_zone) -1);
+    strupper(ln->bng_zone);
+    break;
+  case fld_bng_northing:
+    ln->bng_northing = unicsv_to_double(s);
+    break;
+  case fld_bng_easting:
+    ln->bng_easting = unicsv_to_double(s);
+    break;
+  case fld_swiss_easting:
+    ln->swiss_easting = unicsv_to_double(s);
+    break;
+  case fld_swiss_northing:
+    ln->swiss_northing = unicsv_to_double(s);
+    break;
+  default:
+    break;
+  }
+}
+
+static void
+unicsv_dec_coordinates(unicsv_line_t* ln, field_e type, const char* s)
+{
+  switch (type) {
+  case fld_utm:
+    parse_coordinates(s, unicsv_datum_idx, grid_utm,
+                      &ln->wpt->latitude, &ln->wpt->longitude, MYNAME);
+    break;
+  case fld_bng:
+    parse_coordinates(s, DATUM_OSGB36, grid_bng,
+                      &ln->wpt->latitude, &ln->wpt->longitude, MYNAME);
+    break;
+  case fld_swiss:
+    parse_coordinates(s, DATUM_WGS84, grid_swiss,
+                      &ln->wpt->latitude, &ln->wpt->longitude, MYNAME);
+    break;
+  default:
+    return;
+  }
+  /* coordinates from parse_coordinates are in WGS84
+     don't convert a second time */
+  ln->src_datum = DATUM_WGS84;
+}
+
+/* Fields that make a point look like part of a track. */
+static void
+unicsv_dec_track(unicsv_line_t* ln, field_e type, const char* s)
+{
+  Waypoint* wpt = ln->wpt;
+  double d;
+
+  switch (type) {
+  case fld_hdop:
+    wpt->AllocExt()->hdop = unicsv_to_double(s);
+    break;
+  case fld_pdop:
+    wpt->AllocExt()->pdop = unicsv_to_double(s);
+    break;
+  case fld_vdop:
+    wpt->AllocExt()->vdop = unicsv_to_double(s);
+    break;
+  case fld_sat:
+    wpt->sat = unicsv_to_int(s);
+    break;
+  case fld_fix:
+    if (case_ignore_strcmp(s, "none") == 0) {
+      wpt->fix = fix_none;
+    } else if (case_ignore_strcmp(s, "2d") == 0) {
+      wpt->fix = fix_2d;
+    } else if (case_ignore_strcmp(s, "3d") == 0) {
+      wpt->fix = fix_3d;
+    } else if (case_ignore_strcmp(s, "dgps") == 0) {
+      wpt->fix = fix_dgps;
+    } else if (case_ignore_strcmp(s, "pps") == 0) {
+      wpt->fix = fix_pps;
+    } else {
+      wpt->fix = fix_unknown;
+    }
+    break;
+  case fld_speed:
+    if (! parse_speed(s, &d, 1.0, MYNAME)) {
+      return;
+    }
+    WAYPT_SET(wpt, speed, d);
+    break;
+  case fld_course:
+    WAYPT_SET(wpt, course, unicsv_to_double(s));
+    break;
+  case fld_heartrate:
+    wpt->AllocExt()->heartrate = unicsv_to_int(s);
+    break;
+  case fld_cadence:
+    wpt->AllocExt()->cadence = unicsv_to_int(s);
+    break;
+  case fld_power:
+    wpt->AllocExt()->power = unicsv_to_double(s);
+    break;
+  default:
+    return;
+  }
+  if (unicsv_detect) {
+    unicsv_data_type = trkdata;
+  }
+}
+
+static void
+unicsv_dec_measure(unicsv_line_t* ln, field_e type, const char* s)
+{
+  Waypoint* wpt = ln->wpt;
+  double d;
+
+  switch (type) {
+  case fld_temperature:
+    d = unicsv_to_double(s);
+    if (fabs(d) < 999999) {
+      WAYPT_SET(wpt, temperature, d);
+    }
+    break;
+  case fld_temperature_f:
+    d = unicsv_to_double(s);
+    if (fabs(d) < 999999) {
+      WAYPT_SET(wpt, temperature, FAHRENHEIT_TO_CELSIUS(d));
+    }
+    break;
+  case fld_proximity:
+    if (parse_distance(s, &d, unicsv_proximityscale, MYNAME)) {
+      WAYPT_SET(wpt, proximity, d);
+    }
+    break;
+  case fld_depth:
+    if (parse_distance(s, &d, unicsv_depthscale, MYNAME)) {
+      WAYPT_SET(wpt, depth, d);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+static void
+unicsv_dec_time(unicsv_line_t* ln, field_e type, const char* s)
+{
+  switch (type) {
+  case fld_utc_date:
+  case fld_date:
+    if ((ln->is_localtime < 2) && (ln->date < 0)) {
+      ln->date = unicsv_parse_date(s, NULL);
+      ln->is_localtime = (type == fld_date);
+    }
+    break;
+  case fld_utc_time:
+  case fld_time:
+    if ((ln->is_localtime < 2) && (ln->time < 0)) {
+      ln->time = unicsv_parse_time(s, &ln->usec, &ln->date);
+      ln->is_localtime = (type == fld_time);
+    }
+    break;
+  case fld_datetime:
+    if ((ln->is_localtime < 2) && (ln->date < 0) && (ln->time < 0)) {
+      ln->time = unicsv_parse_time(s, &ln->usec, &ln->date);
+      ln->is_localtime = 1;
+    }
+    break;
+  case fld_iso_time:
+    ln->is_localtime = 2;	/* fix result */
+    ln->wpt->SetCreationTime(xml_parse_time(QString::fromUtf8(s)));
+    break;
+  default:
+    break;
+  }
+}
+
+static void
+unicsv_dec_ymd(unicsv_line_t* ln, field_e type, const char* s)
+{
+  switch (type) {
+  case fld_year:
+    ln->ymd.tm_year = unicsv_to_int(s);
+    break;
+  case fld_month:
+    ln->ymd.tm_mon = unicsv_to_int(s);
+    break;
+  case fld_day:
+    ln->ymd.tm_mday = unicsv_to_int(s);
+    break;
+  case fld_hour:
+    ln->ymd.tm_hour = unicsv_to_int(s);
+    break;
+  case fld_min:
+    ln->ymd.tm_min = unicsv_to_int(s);
+    break;
+  case fld_sec:
+    ln->ymd.tm_sec = unicsv_to_int(s);
+    break;
+  default:
+    break;
+  }
+}
+
+static void
+unicsv_dec_hemisphere(unicsv_line_t* ln, field_e type, const char* s)
+{
+  if (type == fld_ns) {
+    ln->ns = (tolower((unsigned char)*s) == 'n') ? 1 : -1;
+    ln->wpt->latitude *= ln->ns;
+  } else {
+    ln->ew = (tolower((unsigned char)*s) == 'e') ? 1 : -1;
+    ln->wpt->longitude *= ln->ew;
+  }
+}
+
+static void
+unicsv_dec_garmin(unicsv_line_t* ln, field_e type, const char* s)
+{
+  Waypoint* wpt = ln->wpt;
+  garmin_fs_t* gmsd = GMSD_FIND(wpt);
+  QString qs = QString::fromUtf8(s);
+
+  if (! gmsd) {
+    gmsd = garmin_fs_alloc(-1);
+    fs_chain_add(&wpt->AllocExt()->fs, (format_specific_data*) gmsd);
+  }
+  switch (type) {
+  case fld_garmin_city:
+    GMSD_SETQSTR(city, qs);
+    break;
+  case fld_garmin_postal_code:
+    GMSD_SETQSTR(postal_code, qs);
+    break;
+  case fld_garmin_state:
+    GMSD_SETQSTR(state, qs);
+    break;
+  case fld_garmin_country:
+    GMSD_SETQSTR(country, qs);
+    break;
+  case fld_garmin_addr:
+    GMSD_SETQSTR(addr, qs);
+    break;
+  case fld_garmin_phone_nr:
+    GMSD_SETQSTR(phone_nr, qs);
+    break;
+  case fld_garmin_phone_nr2:
+    GMSD_SETQSTR(phone_nr2, qs);
+    break;
+  case fld_garmin_fax_nr:
+    GMSD_SETQSTR(fax_nr, qs);
+    break;
+  case fld_garmin_email:
+    GMSD_SETQSTR(email, qs);
+    break;
+  case fld_garmin_facility:
+    GMSD_SETQSTR(facility, qs);
+    break;
+  default:
+    break;
+  }
+}
+
+static void
+unicsv_dec_geocache(unicsv_line_t* ln, field_e type, const char* s)
+{
+  geocache_data* gc_data = ln->wpt->AllocGCData();
+  time_t time, date;
+  int usec;
+
+  switch (type) {
+  case fld_gc_id:
+    gc_data->id = unicsv_to_int(s);
+    if (gc_data->id == 0) {
+      gc_data->id = unicsv_parse_gc_id(QString::fromUtf8(s));
+    }
+    break;
+  case fld_gc_type:
+    gc_data->type = gs_mktype(QString::fromUtf8(s));
+    break;
+  case fld_gc_container:
+    gc_data->container = gs_mkcont(QString::fromUtf8(s));
+    break;
+  case fld_gc_terr:
+    gc_data->terr = unicsv_to_double(s) * 10;
+    break;
+  case fld_gc_diff:
+    gc_data->diff = unicsv_to_double(s) * 10;
+    break;
+  case fld_gc_is_archived:
+    gc_data->is_archived = unicsv_parse_status(QString::fromUtf8(s));
+    break;
+  case fld_gc_is_available:
+    gc_data->is_available = unicsv_parse_status(QString::fromUtf8(s));
+    break;
+  case fld_gc_exported:
+    time = unicsv_parse_time(s, &usec, &date);
+    if (date || time) {
+      gc_data->exported = unicsv_adjust_time(time, &date);
+    }
+    break;
+  case fld_gc_last_found:
+    time = unicsv_parse_time(s, &usec, &date);
+    if (date || time) {
+      gc_data->last_found = unicsv_adjust_time(time, &date);
+    }
+    break;
+  case fld_gc_placer:
+    gc_data->placer = QString::fromUtf8(s);
+    break;
+  case fld_gc_placer_id:
+    gc_data->placer_id = unicsv_to_int(s);
+    break;
+  case fld_gc_hint:
+    gc_data->hint = QString::fromUtf8(s);
+    break;
+  default:
+    break;
+  }
+}
+
+static unicsv_decoder_t
+unicsv_decoder(field_e type)
+{
+  switch (type) {
+  case fld_latitude:
+    return unicsv_dec_latitude;
+  case fld_longitude:
+    return unicsv_dec_longitude;
+  case fld_shortname:
+  case fld_description:
+  case fld_notes:
+  case fld_url:
+  case fld_symbol:
+    return unicsv_dec_text;
+  case fld_altitude:
+    return unicsv_dec_altitude;
+  case fld_utm_zone:
+  case fld_utm_easting:
+  case fld_utm_northing:
+  case fld_utm_zone_char:
+  case fld_bng_zone:
+  case fld_bng_northing:
+  case fld_bng_easting:
+  case fld_swiss_easting:
+  case fld_swiss_northing:
+    return unicsv_dec_grid;
+  case fld_utm:
+  case fld_bng:
+  case fld_swiss:
+    return unicsv_dec_coordinates;
+  case fld_hdop:
+  case fld_pdop:
+  case fld_vdop:
+  case fld_sat:
+  case fld_fix:
+  case fld_speed:
+  case fld_course:
+  case fld_heartrate:
+  case fld_cadence:
+  case fld_power:
+    return unicsv_dec_track;
+  case fld_temperature:
+  case fld_temperature_f:
+  case fld_proximity:
+  case fld_depth:
+    return unicsv_dec_measure;
+  case fld_utc_date:
+  case fld_utc_time:
+  case fld_iso_time:
+  case fld_time:
+  case fld_date:
+  case fld_datetime:
+    return unicsv_dec_time;
+  case fld_year:
+  case fld_month:
+  case fld_day:
+  case fld_hour:
+  case fld_min:
+  case fld_sec:
+    return unicsv_dec_ymd;
+  case fld_ns:
+  case fld_ew:
+    return unicsv_dec_hemisphere;
+  case fld_garmin_city:
+  case fld_garmin_postal_code:
+  case fld_garmin_state:
+  case fld_garmin_country:
+  case fld_garmin_addr:
+  case fld_garmin_phone_nr:
+  case fld_garmin_phone_nr2:
+  case fld_garmin_fax_nr:
+  case fld_garmin_email:
+  case fld_garmin_facility:
+    return unicsv_dec_garmin;
+  case fld_gc_id:
+  case fld_gc_type:
+  case fld_gc_container:
+  case fld_gc_terr:
+  case fld_gc_diff:
+  case fld_gc_is_archived:
+  case fld_gc_is_available:
+  case fld_gc_exported:
+  case fld_gc_last_found:
+  case fld_gc_placer:
+  case fld_gc_placer_id:
+  case fld_gc_hint:
+    return unicsv_dec_geocache;
+  default:
+    return NULL;
+  }
+}
+
+static void
+unicsv_add_column(field_e type)
+{
+  unicsv_column_t col;
+
+  col.type = type;
+  col.decode = unicsv_decoder(type);
+  unicsv_columns.append(col);
+}
+
+/*
+ * Cut the next field off the line at *pp.  This sees the same fields as
+ * csv_lineparse(), csv_stringtrim() and QString::trimmed() did: quotes
+ * hide separators, a quoted field loses its outer pairs of quotes, and
+ * surrounding white space goes.  The field is terminated in place; *pp
+ * moves past the separator or becomes NULL after the last field.
+ */
+static char*
+unicsv_next_field(char** pp, char sep)
+{
+  char* p = *pp;
+  char* sp = p;
+  char* ep;
+  int enclosed = 0;
+  int quoted = 0;
+
+  while (*p && (enclosed || (*p != sep))) {
+    if (*p == '"') {
+      enclosed = !enclosed;
+      quoted = 1;
+    }
+    p++;
+  }
+  if (enclosed) {
+    warning("CSV_UTIL: Warning- Unbalanced Field Enclosures (\") on line 0\n");
+  }
+  *pp = (*p) ? p + 1 : NULL;
+
+  ep = p;
+  while ((ep > sp) && isspace((unsigned char)ep[-1])) {
+    ep--;
+  }
+  while ((sp < ep) && isspace((unsigned char)*sp)) {
+    sp++;
+  }
+  if (quoted) {
+    while ((ep - sp >= 2) && (*sp == '"') && (ep[-1] == '"')) {
+      sp++;
+      ep--;
+    }
+    while ((ep > sp) && isspace((unsigned char)ep[-1])) {
+      ep--;
+    }
+    while ((sp < ep) && isspace((unsigned char)*sp)) {
+      sp++;
+    }
+  }
+  *ep = '\0';
+  return sp;
+}
+
 static char
 unicsv_compare_fields(const char* s, const field_t* f)
 {
@@ -510,7 +1137,6 @@ unicsv_fondle_header(QString s)
   // TODO: clean up this back and forth between QString and char*.
   char* buf = NULL;
   char* cbuf_start = NULL;
-  int column;
   const cet_cs_vec_t* ascii = &cet_cs_vec_ansi_x3_4_1968;	/* us-ascii */
 
   /* Convert the entire header to lower case for convenience.
@@ -533,24 +1159,20 @@ unicsv_fondle_header(QString s)
     cbuf = buf;
   }
 
-  column = -1;
   while ((s = csv_lineparse(cbuf, unicsv_fieldsep, "\"", 0)) , !s.isEmpty()) {
     s = s.trimmed();
 
     field_t* f = &fields_def[0];
 
     cbuf = NULL;
-    column++;
-    unicsv_fields_tab_ct++;
 
-    unicsv_fields_tab.append(fld_terminator);
     while (f->name) {
       if (unicsv_compare_fields(s, f)) {
-        unicsv_fields_tab[column] = f->type;
         break;
       }
       f++;
     }
+    unicsv_add_column(f->type);
     if ((! f->name) && global_opts.debug_level) {
       warning(MYNAME ": Unhandled column \"%s\".\n", qPrintable(s));
     }
@@ -593,13 +1215,14 @@ unicsv_rd_init(const char* fname)
   unicsv_depthscale = 1.0;
   unicsv_proximityscale = 1.0;
 
-  unicsv_fields_tab.clear();
-  unicsv_fields_tab_ct = 0;
+  unicsv_columns.clear();
   unicsv_data_type = global_opts.objective;
   unicsv_detect = (!(global_opts.masked_objective & (WPTDATAMASK | TRKDATAMASK | RTEDATAMASK | POSNDATAMASK)));
 
   unicsv_track = unicsv_route = NULL;
   unicsv_datum_idx = gt_lookup_datum_index(opt_datum, MYNAME);
+  GPS_Math_Datum_Transform_Init(&unicsv_datum_xform, unicsv_datum_idx, DATUM_WGS84);
+  unicsv_pending_ct = 0;
 
   fin = gbfopen(fname, "rb", MYNAME);
 
@@ -611,490 +1234,135 @@ unicsv_rd_init(const char* fname)
   if (fin->unicode) {
     cet_convert_init(CET_CHARSET_UTF8, 1);
   }
+  /* points are finished before unicsv_flush_pending() hands them over */
+  traits_add_complete();
 }
 
 static void
 unicsv_rd_deinit(void)
 {
   gbfclose(fin);
-  unicsv_fields_tab.clear();
+  unicsv_columns.clear();
 }
 
 static void
-unicsv_parse_one_line(char* ibuf)
+unicsv_flush_pending(void)
 {
-  Waypoint* wpt = NULL;
-  int column;
-  int  utm_zone = -9999;
-  double utm_easting = 0;
-  double utm_northing = 0;
-  char utm_zc = 'N';
-  // Zones are always two bytes.  Spare one for null termination..
-  char bng_zone[3] = "";
-  double bng_easting = 0;
-  double bng_northing = 0;
-  double swiss_easting = unicsv_unknown;
-  double swiss_northing = unicsv_unknown;
-  int checked = 0;
-  time_t date = -1; 
-  time_t time = -1;
-  int usec = -1;
-  char is_localtime = 0;
-  garmin_fs_t* gmsd;
-  double d;
-  struct tm ymd;
-  int src_datum = unicsv_datum_idx;
-  int ns = 1;
-  int ew = 1;
-  geocache_data* gc_data = NULL;
-  wpt = new Waypoint;
-  wpt->latitude = unicsv_unknown;
-  wpt->longitude = unicsv_unknown;
-  memset(&ymd, 0, sizeof(ymd));
+  double lat[UNICSV_BATCH];
+  double lon[UNICSV_BATCH];
+  int i, ct;
 
-  column = -1;
-  QString s;
-  while ((s = csv_lineparse(ibuf, unicsv_fieldsep, "\"", 0)), !s.isNull()) {
-    if (column > unicsv_fields_tab_ct) {
-      break;  /* ignore extra fields on line */
+  for (i = ct = 0; i < unicsv_pending_ct; i++) {
+    if (unicsv_pending[i].convert) {
+      lat[ct] = unicsv_pending[i].wpt->latitude;
+      lon[ct] = unicsv_pending[i].wpt->longitude;
+      ct++;
     }
+  }
+  if (ct) {
+    GPS_Math_Datum_Transform_Array(&unicsv_datum_xform, ct, lat, lon, NULL,
+                                   lat, lon, NULL);
+  }
 
-    ibuf = NULL;
+  for (i = ct = 0; i < unicsv_pending_ct; i++) {
+    Waypoint* wpt = unicsv_pending[i].wpt;
 
-    column++;
-    checked++;
-    s = s.trimmed();
-    if (s.isEmpty()) {
-      continue;  /* skip empty columns */
+    if (unicsv_pending[i].convert) {
+      wpt->latitude = lat[ct];
+      wpt->longitude = lon[ct];
+      ct++;
     }
-    switch (unicsv_fields_tab[column]) {
 
-    case fld_time:
-    case fld_date:
-    case fld_datetime:
-      /* switch column type if it looks like an iso time string */
-      if (s.contains('T')) {
-        unicsv_fields_tab[column] = fld_iso_time;
+    switch (unicsv_pending[i].type) {
+    case rtedata:
+      if (! unicsv_route) {
+        unicsv_route = route_head_alloc();
+        route_add_head(unicsv_route);
+      }
+      route_add_wpt(unicsv_route, wpt);
+      break;
+    case trkdata:
+      if (! unicsv_track) {
+        unicsv_track = route_head_alloc();
+        track_add_head(unicsv_track);
       }
+      track_add_wpt(unicsv_track, wpt);
       break;
     default:
-      ;
+      waypt_add(wpt);
     }
+  }
+  unicsv_pending_ct = 0;
+}
 
+static void
+unicsv_parse_one_line(char* ibuf)
+{
+  unicsv_line_t ln;
+  Waypoint* wpt;
+  unicsv_column_t* cols = unicsv_columns.data();
+  int ncols = unicsv_columns.size();
+  int column;
+  int checked = 0;
+  char sep = *unicsv_fieldsep;
 
-    switch (unicsv_fields_tab[column]) {
-
-    case fld_latitude:
-      human_to_dec(CSTR(s), &wpt->latitude, &wpt->longitude, 1);
-      wpt->latitude = wpt->latitude * ns;
-      break;
-
-    case fld_longitude:
-      human_to_dec(CSTR(s), &wpt->latitude, &wpt->longitude, 2);
-      wpt->longitude = wpt->longitude * ew;
-      break;
-
-    case fld_shortname:
-      wpt->shortname = s;
-      break;
-
-    case fld_description:
-      wpt->description = s;
-      break;
-
-    case fld_notes:
-      wpt->notes = s;
-      break;
+  wpt = ln.wpt = new Waypoint;
+  wpt->latitude = unicsv_unknown;
+  wpt->longitude = unicsv_unknown;
+  ln.utm_zone = -9999;
+  ln.utm_easting = 0;
+  ln.utm_northing = 0;
+  ln.utm_zc = 'N';
+  ln.bng_zone[0] = '\0';
+  ln.bng_easting = 0;
+  ln.bng_northing = 0;
+  ln.swiss_easting = unicsv_unknown;
+  ln.swiss_northing = unicsv_unknown;
+  ln.date = -1;
+  ln.time = -1;
+  ln.usec = -1;
+  ln.is_localtime = 0;
+  memset(&ln.ymd, 0, sizeof(ln.ymd));
+  ln.src_datum = unicsv_datum_idx;
+  ln.ns = 1;
+  ln.ew = 1;
+
+  for (column = 0; ibuf && (column < ncols); column++) {
+    unicsv_column_t* col = &cols[column];
+    const char* s = unicsv_next_field(&ibuf, sep);
+    QByteArray wide;
+    size_t len;
 
-    case fld_url: {
-      wpt->AddUrlLink(s);
+    checked++;
+    len = strlen(s);
+    if (len && (((unsigned char)s[0] & 0x80) || ((unsigned char)s[len - 1] & 0x80))) {
+      /* QString::trimmed() also knows the non-ASCII spaces */
+      wide = QString::fromUtf8(s).trimmed().toUtf8();
+      s = wide.constData();
+    }
+    if (*s == '\0') {
+      continue;  /* skip empty columns */
+    }
+    if (col->decode == NULL) {
+      checked--;
+      continue;
     }
-    break;
-
-    case fld_altitude:
-      if (parse_distance(s, &d, unicsv_altscale, MYNAME)) {
-        if (fabs(d) < fabs(unknown_alt)) {
-          wpt->altitude = d;
-        }
-      }
-      break;
-
-    case fld_utm_zone:
-      utm_zone = s.toInt();
-      break;
-
-    case fld_utm_easting:
-      utm_easting = s.toDouble();
-      break;
-
-    case fld_utm_northing:
-      utm_northing = s.toDouble();
-      break;
-
-    case fld_utm_zone_char:
-      utm_zc = s[0].toUpper().toLatin1();
-      break;
-
-    case fld_utm:
-      parse_coordinates(s, unicsv_datum_idx, grid_utm,
-                        &wpt->latitude, &wpt->longitude, MYNAME);
-      /* coordinates from parse_coordinates are in WGS84
-         don't convert a second time */
-      src_datum = DATUM_WGS84;
-      break;
-
-    case fld_bng:
-      parse_coordinates(s, DATUM_OSGB36, grid_bng,
-                        &wpt->latitude, &wpt->longitude, MYNAME);
-      /* coordinates from parse_coordinates are in WGS84
-         don't convert a second time */
-      src_datum = DATUM_WGS84;
-      break;
-
-    case fld_bng_zone:
-      strncpy(bng_zone, CSTR(s), sizeof(bng_zone) -1);
-      strupper(bng_zone);
-      break;
-
-    case fld_bng_northing:
-      bng_northing = s.toDouble();
-      break;
-
-    case fld_bng_easting:
-      bng_easting = s.toDouble();
-      break;
-
-    case fld_swiss:
-      parse_coordinates(s, DATUM_WGS84, grid_swiss,
-                        &wpt->latitude, &wpt->longitude, MYNAME);
-      /* coordinates from parse_coordinates are in WGS84
-         don't convert a second time */
-      src_datum = DATUM_WGS84;
-      break;
-
-    case fld_swiss_easting:
-      swiss_easting = s.toDouble();
-      break;
-
-    case fld_swiss_northing:
-      swiss_northing = s.toDouble();
-      break;
-
-    case fld_hdop:
-      wpt->hdop = s.toDouble();
-      if (unicsv_detect) {
-        unicsv_data_type = trkdata;
-      }
-      break;
-
-    case fld_pdop:
-      wpt->pdop = s.toDouble();
-      if (unicsv_detect) {
-        unicsv_data_type = trkdata;
-      }
-      break;
-
-    case fld_vdop:
-      wpt->vdop = s.toDouble();
-      if (unicsv_detect) {
-        unicsv_data_type = trkdata;
-      }
-      break;
-
-    case fld_sat:
-      wpt->sat = s.toInt();
-      if (unicsv_detect) {
-        unicsv_data_type = trkdata;
-      }
-      break;
-
-    case fld_fix:
-      if (unicsv_detect) {
-        unicsv_data_type = trkdata;
-      }
-      if (case_ignore_strcmp(s, "none") == 0) {
-        wpt->fix = fix_none;
-      } else if (case_ignore_strcmp(s, "2d") == 0) {
-        wpt->fix = fix_2d;
-      } else if (case_ignore_strcmp(s, "3d") == 0) {
-        wpt->fix = fix_3d;
-      } else if (case_ignore_strcmp(s, "dgps") == 0) {
-        wpt->fix = fix_dgps;
-      } else if (case_ignore_strcmp(s, "pps") == 0) {
-        wpt->fix = fix_pps;
-      } else {
-        wpt->fix = fix_unknown;
-      }
-      break;
-
-    case fld_utc_date:
-      if ((is_localtime < 2) && (date < 0)) {
-        date = unicsv_parse_date(CSTR(s), NULL);
-        is_localtime = 0;
-      }
-      break;
-
-    case fld_utc_time:
-      if ((is_localtime < 2) && (time < 0)) {
-        time = unicsv_parse_time(s, &usec, &date);
-        is_localtime = 0;
-      }
-      break;
-
-    case fld_speed:
-      if (parse_speed(s, &d, 1.0, MYNAME)) {
-        WAYPT_SET(wpt, speed, d);
-        if (unicsv_detect) {
-          unicsv_data_type = trkdata;
-        }
-      }
-      break;
-
-    case fld_course:
-      WAYPT_SET(wpt, course, s.toDouble());
-      if (unicsv_detect) {
-        unicsv_data_type = trkdata;
-      }
-      break;
-
-    case fld_temperature:
-      d = s.toDouble();
-      if (fabs(d) < 999999) {
-        WAYPT_SET(wpt, temperature, d);
-      }
-      break;
-
-    case fld_temperature_f:
-      d = s.toDouble();
-      if (fabs(d) < 999999) {
-        WAYPT_SET(wpt, temperature, FAHRENHEIT_TO_CELSIUS(d));
-      }
-      break;
-
-    case fld_heartrate:
-      wpt->heartrate = s.toInt();
-      if (unicsv_detect) {
-        unicsv_data_type = trkdata;
-      }
-      break;
-
-    case fld_cadence:
-      wpt->cadence = s.toInt();
-      if (unicsv_detect) {
-        unicsv_data_type = trkdata;
-      }
-      break;
-
-    case fld_power:
-      wpt->power = s.toDouble();
-      if (unicsv_detect) {
-        unicsv_data_type = trkdata;
-      }
-      break;
-
-    case fld_proximity:
-      if (parse_distance(s, &d, unicsv_proximityscale, MYNAME)) {
-        WAYPT_SET(wpt, proximity, d);
-      }
-      break;
-
-    case fld_depth:
-      if (parse_distance(s, &d, unicsv_depthscale, MYNAME)) {
-        WAYPT_SET(wpt, depth, d);
-      }
-      break;
-
-    case fld_symbol:
-      wpt->icon_descr = s;
-      break;
-
-    case fld_iso_time:
-      is_localtime = 2;	/* fix result */
-      wpt->SetCreationTime(xml_parse_time(s));
-      break;
 
+    switch (col->type) {
     case fld_time:
-      if ((is_localtime < 2) && (time < 0)) {
-        time = unicsv_parse_time(s, &usec, &date);
-        is_localtime = 1;
-      }
-      break;
-
     case fld_date:
-      if ((is_localtime < 2) && (date < 0)) {
-        date = unicsv_parse_date(CSTR(s), NULL);
-        is_localtime = 1;
-      }
-      break;
-
-    case fld_year:
-      ymd.tm_year = s.toInt();
-      break;
-
-    case fld_month:
-      ymd.tm_mon = s.toInt();
-      break;
-
-    case fld_day:
-      ymd.tm_mday = s.toInt();
-      break;
-
-    case fld_hour:
-      ymd.tm_hour = s.toInt();
-      break;
-
-    case fld_min:
-      ymd.tm_min = s.toInt();
-      break;
-
-    case fld_sec:
-      ymd.tm_sec = s.toInt();
-      break;
-
     case fld_datetime:
-      if ((is_localtime < 2) && (date < 0) && (time < 0)) {
-        time = unicsv_parse_time(s, &usec, &date);
-        is_localtime = 1;
-      }
-      break;
-
-    case fld_ns:
-      ns = s.startsWith('n', Qt::CaseInsensitive) ? 1 : -1;
-      wpt->latitude *= ns;
-      break;
-
-    case fld_ew:
-      ns = s.startsWith('e', Qt::CaseInsensitive) ? 1 : -1;
-      wpt->longitude *= ew;
-      break;
-
-    case fld_garmin_city:
-    case fld_garmin_postal_code:
-    case fld_garmin_state:
-    case fld_garmin_country:
-    case fld_garmin_addr:
-    case fld_garmin_phone_nr:
-    case fld_garmin_phone_nr2:
-    case fld_garmin_fax_nr:
-    case fld_garmin_email:
-    case fld_garmin_facility:
-      gmsd = GMSD_FIND(wpt);
-      if (! gmsd) {
-        gmsd = garmin_fs_alloc(-1);
-        fs_chain_add(&wpt->fs, (format_specific_data*) gmsd);
-      }
-      switch (unicsv_fields_tab[column]) {
-      case fld_garmin_city:
-        GMSD_SETQSTR(city, s);
-        break;
-      case fld_garmin_postal_code:
-        GMSD_SETQSTR(postal_code, s);
-        break;
-      case fld_garmin_state:
-        GMSD_SETQSTR(state, s);
-        break;
-      case fld_garmin_country:
-        GMSD_SETQSTR(country, s);
-        break;
-      case fld_garmin_addr:
-        GMSD_SETQSTR(addr, s);
-        break;
-      case fld_garmin_phone_nr:
-        GMSD_SETQSTR(phone_nr, s);
-        break;
-      case fld_garmin_phone_nr2:
-        GMSD_SETQSTR(phone_nr2, s);
-        break;
-      case fld_garmin_fax_nr:
-        GMSD_SETQSTR(fax_nr, s);
-        break;
-      case fld_garmin_email:
-        GMSD_SETQSTR(email, s);
-        break;
-      case fld_garmin_facility:
-        GMSD_SETQSTR(facility, s);
-        break;
-      default:
-        break;
-      }
-      break;
-    case fld_gc_id:
-    case fld_gc_type:
-    case fld_gc_container:
-    case fld_gc_terr:
-    case fld_gc_diff:
-    case fld_gc_is_archived:
-    case fld_gc_is_available:
-    case fld_gc_exported:
-    case fld_gc_last_found:
-    case fld_gc_placer:
-    case fld_gc_placer_id:
-    case fld_gc_hint:
-
-      gc_data = wpt->AllocGCData();
-
-      switch (unicsv_fields_tab[column]) {
-
-      case fld_gc_id:
-        gc_data->id = s.toInt();
-        if (gc_data->id == 0) {
-          gc_data->id = unicsv_parse_gc_id(s);
-        }
-        break;
-      case fld_gc_type:
-        gc_data->type = gs_mktype(s);
-        break;
-      case fld_gc_container:
-        gc_data->container = gs_mkcont(s);
-        break;
-      case fld_gc_terr:
-        gc_data->terr = s.toDouble() * 10;
-        break;
-      case fld_gc_diff:
-        gc_data->diff = s.toDouble() * 10;
-        break;
-      case fld_gc_is_archived:
-        gc_data->is_archived = unicsv_parse_status(s);
-        break;
-      case fld_gc_is_available:
-        gc_data->is_available = unicsv_parse_status(s);
-        break;
-      case fld_gc_exported: {
-        time_t time, date;
-        int usec;
-        time = unicsv_parse_time(s, &usec, &date);
-        if (date || time) {
-          gc_data->exported = unicsv_adjust_time(time, &date);
-        }
-      }
-      break;
-      case fld_gc_last_found: {
-        time_t time, date;
-        int usec;
-        time = unicsv_parse_time(s, &usec, &date);
-        if (date || time) {
-          gc_data->last_found = unicsv_adjust_time(time, &date);
-        }
-      }
-      break;
-      case fld_gc_placer:
-        gc_data->placer = s;
-        break;
-      case fld_gc_placer_id:
-        gc_data->placer_id = s.toInt();
-        break;
-      case fld_gc_hint:
-        gc_data->hint = s;
-        break;
-
-      default:
-        break;
+      /* switch column type if it looks like an iso time string */
+      if (strchr(s, 'T')) {
+        col->type = fld_iso_time;
+        col->decode = unicsv_decoder(fld_iso_time);
       }
       break;
-    case fld_terminator: /* dummy */
-      checked--;
-      break;
+    default:
+      ;
     }
+
+    col->decode(&ln, col->type, s);
   }
 
   if (checked == 0) {
@@ -1102,11 +1370,11 @@ unicsv_parse_one_line(char* ibuf)
     return;
   }
 
-  if (is_localtime < 2) {	/* not fixed */
-    if ((time >= 0) && (date >= 0)) {
-      time_t t = date + time;
+  if (ln.is_localtime < 2) {	/* not fixed */
+    if ((ln.time >= 0) && (ln.date >= 0)) {
+      time_t t = ln.date + ln.time;
 
-      if (is_localtime) {
+      if (ln.is_localtime) {
         struct tm tm;
         tm = *gmtime(&t);
         if (opt_utc) {
@@ -1117,43 +1385,43 @@ unicsv_parse_one_line(char* ibuf)
       } else {
         wpt->SetCreationTime(t);
       }
-    } else if (time >= 0) {
-      wpt->SetCreationTime(time);
-    } else if (date >= 0) {
-      wpt->SetCreationTime(date);
-    } else if (ymd.tm_year || ymd.tm_mon || ymd.tm_mday) {
-      if (ymd.tm_year < 100) {
-        if (ymd.tm_year <= 70) {
-          ymd.tm_year += 2000;
+    } else if (ln.time >= 0) {
+      wpt->SetCreationTime(ln.time);
+    } else if (ln.date >= 0) {
+      wpt->SetCreationTime(ln.date);
+    } else if (ln.ymd.tm_year || ln.ymd.tm_mon || ln.ymd.tm_mday) {
+      if (ln.ymd.tm_year < 100) {
+        if (ln.ymd.tm_year <= 70) {
+          ln.ymd.tm_year += 2000;
         } else {
-          ymd.tm_year += 1900;
+          ln.ymd.tm_year += 1900;
         }
       }
-      ymd.tm_year -= 1900;
+      ln.ymd.tm_year -= 1900;
 
-      if (ymd.tm_mon == 0) {
-        ymd.tm_mon = 1;
+      if (ln.ymd.tm_mon == 0) {
+        ln.ymd.tm_mon = 1;
       }
-      if (ymd.tm_mday == 0) {
-        ymd.tm_mday = 1;
+      if (ln.ymd.tm_mday == 0) {
+        ln.ymd.tm_mday = 1;
       }
 
-      ymd.tm_mon--;
+      ln.ymd.tm_mon--;
       if (opt_utc) {
-        wpt->SetCreationTime(mkgmtime(&ymd));
+        wpt->SetCreationTime(mkgmtime(&ln.ymd));
       } else {
-        wpt->SetCreationTime(mklocaltime(&ymd));
+        wpt->SetCreationTime(mklocaltime(&ln.ymd));
       }
-    } else if (ymd.tm_hour || ymd.tm_min || ymd.tm_sec) {
+    } else if (ln.ymd.tm_hour || ln.ymd.tm_min || ln.ymd.tm_sec) {
       if (opt_utc) {
-        wpt->SetCreationTime(mkgmtime(&ymd));
+        wpt->SetCreationTime(mkgmtime(&ln.ymd));
       } else {
-        wpt->SetCreationTime(mklocaltime(&ymd));
+        wpt->SetCreationTime(mklocaltime(&ln.ymd));
       }
     }
 
-    if (usec >= 0) {
-      wpt->creation_time = wpt->creation_time.addMSecs(MICRO_TO_MILLI(usec));
+    if (ln.usec >= 0) {
+      wpt->creation_time = wpt->creation_time.addMSecs(MICRO_TO_MILLI(ln.usec));
     }
 
     if (opt_utc) {
@@ -1164,47 +1432,29 @@ unicsv_parse_one_line(char* ibuf)
   /* utm/bng/swiss can be optional */
 
   if ((wpt->latitude == unicsv_unknown) && (wpt->longitude == unicsv_unknown)) {
-    if (utm_zone != -9999) {
+    if (ln.utm_zone != -9999) {
       GPS_Math_UTM_EN_To_Known_Datum(&wpt->latitude, &wpt->longitude,
-                                     utm_easting, utm_northing, utm_zone, utm_zc, unicsv_datum_idx);
-    } else if (bng_zone[0]) {
+                                     ln.utm_easting, ln.utm_northing, ln.utm_zone, ln.utm_zc, unicsv_datum_idx);
+    } else if (ln.bng_zone[0]) {
       if (! GPS_Math_UKOSMap_To_WGS84_M(
-            bng_zone, bng_easting, bng_northing,
+            ln.bng_zone, ln.bng_easting, ln.bng_northing,
             &wpt->latitude, &wpt->longitude))
         fatal(MYNAME ": Unable to convert BNG coordinates (%s %.f %.f)!\n",
-              bng_zone, bng_easting, bng_northing);
-      src_datum = DATUM_WGS84;	/* don't convert afterwards */
-    } else if ((swiss_easting != unicsv_unknown) && (swiss_northing != unicsv_unknown)) {
-      GPS_Math_Swiss_EN_To_WGS84(swiss_easting, swiss_northing,
+              ln.bng_zone, ln.bng_easting, ln.bng_northing);
+      ln.src_datum = DATUM_WGS84;	/* don't convert afterwards */
+    } else if ((ln.swiss_easting != unicsv_unknown) && (ln.swiss_northing != unicsv_unknown)) {
+      GPS_Math_Swiss_EN_To_WGS84(ln.swiss_easting, ln.swiss_northing,
                                  &wpt->latitude, &wpt->longitude);
-      src_datum = DATUM_WGS84;	/* don't convert afterwards */
+      ln.src_datum = DATUM_WGS84;	/* don't convert afterwards */
     }
   }
 
-  if ((src_datum != DATUM_WGS84) &&
-      (wpt->latitude != unicsv_unknown) && (wpt->longitude != unicsv_unknown)) {
-    double alt;
-    GPS_Math_Known_Datum_To_WGS84_M(wpt->latitude, wpt->longitude, (double) 0.0,
-                                    &wpt->latitude, &wpt->longitude, &alt, src_datum);
-  }
-
-  switch (unicsv_data_type) {
-  case rtedata:
-    if (! unicsv_route) {
-      unicsv_route = route_head_alloc();
-      route_add_head(unicsv_route);
-    }
-    route_add_wpt(unicsv_route, wpt);
-    break;
-  case trkdata:
-    if (! unicsv_track) {
-      unicsv_track = route_head_alloc();
-      track_add_head(unicsv_track);
-    }
-    track_add_wpt(unicsv_track, wpt);
-    break;
-  default:
-    waypt_add(wpt);
+  unicsv_pending[unicsv_pending_ct].wpt = wpt;
+  unicsv_pending[unicsv_pending_ct].type = unicsv_data_type;
+  unicsv_pending[unicsv_pending_ct].convert = (ln.src_datum != DATUM_WGS84) &&
+      (wpt->latitude != unicsv_unknown) && (wpt->longitude != unicsv_unknown);
+  if (++unicsv_pending_ct == UNICSV_BATCH) {
+    unicsv_flush_pending();
   }
 }
 
@@ -1224,6 +1474,7 @@ unicsv_rd(void)
     }
     unicsv_parse_one_line(buff);
   }
+  unicsv_flush_pending();
 }
 
 /* =========================================================================== */
@@ -1287,14 +1538,14 @@ unicsv_waypt_enum_cb(const Waypoint* wpt)
   if (wpt->altitude != unknown_alt) {
     gb_setbit(&unicsv_outp_flags, fld_altitude);
   }
-  if (!wpt->icon_descr.isNull()) {
+  if (!wpt->ext->icon_descr.isNull()) {
     gb_setbit(&unicsv_outp_flags, fld_symbol);
   }
   if (!wpt->description.isEmpty() && shortname != wpt->description) {
     gb_setbit(&unicsv_outp_flags, fld_description);
   }
-  if (!wpt->notes.isEmpty() && shortname != wpt->notes) {
-    if ((wpt->description.isEmpty()) || (wpt->description != wpt->notes)) {
+  if (!wpt->ext->notes.isEmpty() && shortname != wpt->ext->notes) {
+    if ((wpt->description.isEmpty()) || (wpt->description != wpt->ext->notes)) {
       gb_setbit(&unicsv_outp_flags, fld_notes);
     }
   }
@@ -1311,25 +1562,25 @@ unicsv_waypt_enum_cb(const Waypoint* wpt)
   if (wpt->fix != fix_unknown) {
     gb_setbit(&unicsv_outp_flags, fld_fix);
   }
-  if (wpt->vdop > 0) {
+  if (wpt->ext->vdop > 0) {
     gb_setbit(&unicsv_outp_flags, fld_vdop);
   }
-  if (wpt->hdop > 0) {
+  if (wpt->ext->hdop > 0) {
     gb_setbit(&unicsv_outp_flags, fld_hdop);
   }
-  if (wpt->pdop > 0) {
+  if (wpt->ext->pdop > 0) {
     gb_setbit(&unicsv_outp_flags, fld_pdop);
   }
   if (wpt->sat > 0) {
     gb_setbit(&unicsv_outp_flags, fld_sat);
   }
-  if (wpt->heartrate != 0) {
+  if (wpt->ext->heartrate != 0) {
     gb_setbit(&unicsv_outp_flags, fld_heartrate);
   }
-  if (wpt->cadence != 0) {
+  if (wpt->ext->cadence != 0) {
     gb_setbit(&unicsv_outp_flags, fld_cadence);
   }
-  if (wpt->power > 0) {
+  if (wpt->ext->power > 0) {
     gb_setbit(&unicsv_outp_flags, fld_power);
   }
 
@@ -1384,7 +1635,7 @@ unicsv_waypt_enum_cb(const Waypoint* wpt)
   }
 
   if (! wpt->EmptyGCData()) {
-    const geocache_data* gc_data = wpt->gc_data;
+    const geocache_data* gc_data = wpt->ext->gc_data;
 
     if (gc_data->id) {
       gb_setbit(&unicsv_outp_flags, fld_gc_id);
@@ -1425,6 +1676,76 @@ unicsv_waypt_enum_cb(const Waypoint* wpt)
   }
 }
 
+/* The same as unicsv_waypt_enum_cb() over every point, for lists
+ * without garmin or geocache data. */
+static void
+unicsv_traits_to_fields(const global_trait* traits)
+{
+  if (traits->trait_shortname) {
+    gb_setbit(&unicsv_outp_flags, fld_shortname);
+  }
+  if (traits->trait_altitude) {
+    gb_setbit(&unicsv_outp_flags, fld_altitude);
+  }
+  if (traits->trait_icon) {
+    gb_setbit(&unicsv_outp_flags, fld_symbol);
+  }
+  if (traits->trait_description) {
+    gb_setbit(&unicsv_outp_flags, fld_description);
+  }
+  if (traits->trait_notes) {
+    gb_setbit(&unicsv_outp_flags, fld_notes);
+  }
+  if (traits->trait_url) {
+    gb_setbit(&unicsv_outp_flags, fld_url);
+  }
+  if (traits->trait_time) {
+    gb_setbit(&unicsv_outp_flags, fld_time);
+  }
+  if (traits->trait_date) {
+    gb_setbit(&unicsv_outp_flags, fld_date);
+  }
+  if (traits->trait_fix) {
+    gb_setbit(&unicsv_outp_flags, fld_fix);
+  }
+  if (traits->trait_vdop) {
+    gb_setbit(&unicsv_outp_flags, fld_vdop);
+  }
+  if (traits->trait_hdop) {
+    gb_setbit(&unicsv_outp_flags, fld_hdop);
+  }
+  if (traits->trait_pdop) {
+    gb_setbit(&unicsv_outp_flags, fld_pdop);
+  }
+  if (traits->trait_sat) {
+    gb_setbit(&unicsv_outp_flags, fld_sat);
+  }
+  if (traits->trait_heartrate) {
+    gb_setbit(&unicsv_outp_flags, fld_heartrate);
+  }
+  if (traits->trait_cadence) {
+    gb_setbit(&unicsv_outp_flags, fld_cadence);
+  }
+  if (traits->trait_power) {
+    gb_setbit(&unicsv_outp_flags, fld_power);
+  }
+  if (traits->trait_course) {
+    gb_setbit(&unicsv_outp_flags, fld_course);
+  }
+  if (traits->trait_depth) {
+    gb_setbit(&unicsv_outp_flags, fld_depth);
+  }
+  if (traits->trait_speed) {
+    gb_setbit(&unicsv_outp_flags, fld_speed);
+  }
+  if (traits->trait_proximity) {
+    gb_setbit(&unicsv_outp_flags, fld_proximity);
+  }
+  if (traits->trait_temperature) {
+    gb_setbit(&unicsv_outp_flags, fld_temperature);
+  }
+}
+
 static void
 unicsv_waypt_disp_cb(const Waypoint* wpt)
 {
@@ -1442,8 +1763,8 @@ unicsv_waypt_disp_cb(const Waypoint* wpt)
     lon = wpt->longitude;
     alt = wpt->altitude;
   } else {
-    GPS_Math_WGS84_To_Known_Datum_M(wpt->latitude, wpt->longitude, 0.0,
-                                    &lat, &lon, &alt, unicsv_datum_idx);
+    GPS_Math_Datum_Transform(&unicsv_datum_xform, wpt->latitude, wpt->longitude,
+                             0.0, &lat, &lon, &alt);
   }
 
   gbfprintf(fout, "%d%s", unicsv_waypt_ct, unicsv_fieldsep);
@@ -1536,28 +1857,28 @@ unicsv_waypt_disp_cb(const Waypoint* wpt)
     unicsv_print_str(wpt->description);
   }
   if FIELD_USED(fld_notes) {
-    unicsv_print_str(wpt->notes);
+    unicsv_print_str(wpt->ext->notes);
   }
   if FIELD_USED(fld_symbol) {
-    unicsv_print_str(wpt->icon_descr.isNull() ? "Waypoint" : wpt->icon_descr);
+    unicsv_print_str(wpt->ext->icon_descr.isNull() ? "Waypoint" : wpt->ext->icon_descr);
   }
   if FIELD_USED(fld_depth) {
     if WAYPT_HAS(wpt, depth) {
-      gbfprintf(fout, "%s%.3f", unicsv_fieldsep, wpt->depth);
+      gbfprintf(fout, "%s%.3f", unicsv_fieldsep, wpt->ext->depth);
     } else {
       gbfputs(unicsv_fieldsep, fout);
     }
   }
   if FIELD_USED(fld_proximity) {
     if WAYPT_HAS(wpt, proximity) {
-      gbfprintf(fout, "%s%.f", unicsv_fieldsep, wpt->proximity);
+      gbfprintf(fout, "%s%.f", unicsv_fieldsep, wpt->ext->proximity);
     } else {
       gbfputs(unicsv_fieldsep, fout);
     }
   }
   if FIELD_USED(fld_temperature) {
     if WAYPT_HAS(wpt, temperature) {
-      gbfprintf(fout, "%s%.3f", unicsv_fieldsep, wpt->temperature);
+      gbfprintf(fout, "%s%.3f", unicsv_fieldsep, wpt->ext->temperature);
     } else {
       gbfputs(unicsv_fieldsep, fout);
     }
@@ -1604,22 +1925,22 @@ unicsv_waypt_disp_cb(const Waypoint* wpt)
     }
   }
   if FIELD_USED(fld_hdop) {
-    if (wpt->hdop > 0) {
-      gbfprintf(fout, "%s%.2f", unicsv_fieldsep, wpt->hdop);
+    if (wpt->ext->hdop > 0) {
+      gbfprintf(fout, "%s%.2f", unicsv_fieldsep, wpt->ext->hdop);
     } else {
       gbfputs(unicsv_fieldsep, fout);
     }
   }
   if FIELD_USED(fld_vdop) {
-    if (wpt->vdop > 0) {
-      gbfprintf(fout, "%s%.2f", unicsv_fieldsep, wpt->vdop);
+    if (wpt->ext->vdop > 0) {
+      gbfprintf(fout, "%s%.2f", unicsv_fieldsep, wpt->ext->vdop);
     } else {
       gbfputs(unicsv_fieldsep, fout);
     }
   }
   if FIELD_USED(fld_pdop) {
-    if (wpt->pdop > 0) {
-      gbfprintf(fout, "%s%.2f", unicsv_fieldsep, wpt->pdop);
+    if (wpt->ext->pdop > 0) {
+      gbfprintf(fout, "%s%.2f", unicsv_fieldsep, wpt->ext->pdop);
     } else {
       gbfputs(unicsv_fieldsep, fout);
     }
@@ -1632,22 +1953,22 @@ unicsv_waypt_disp_cb(const Waypoint* wpt)
     }
   }
   if FIELD_USED(fld_heartrate) {
-    if (wpt->heartrate != 0) {
-      gbfprintf(fout, "%s%u", unicsv_fieldsep, wpt->heartrate);
+    if (wpt->ext->heartrate != 0) {
+      gbfprintf(fout, "%s%u", unicsv_fieldsep, wpt->ext->heartrate);
     } else {
       gbfputs(unicsv_fieldsep, fout);
     }
   }
   if FIELD_USED(fld_cadence) {
-    if (wpt->cadence != 0) {
-      gbfprintf(fout, "%s%u", unicsv_fieldsep, wpt->cadence);
+    if (wpt->ext->cadence != 0) {
+      gbfprintf(fout, "%s%u", unicsv_fieldsep, wpt->ext->cadence);
     } else {
       gbfputs(unicsv_fieldsep, fout);
     }
   }
   if FIELD_USED(fld_power) {
-    if (wpt->power > 0) {
-      gbfprintf(fout, "%s%.1f", unicsv_fieldsep, wpt->power);
+    if (wpt->ext->power > 0) {
+      gbfprintf(fout, "%s%.1f", unicsv_fieldsep, wpt->ext->power);
     } else {
       gbfputs(unicsv_fieldsep, fout);
     }
@@ -1733,7 +2054,7 @@ unicsv_waypt_disp_cb(const Waypoint* wpt)
   if (wpt->EmptyGCData()) {
     gc_data = NULL;
   } else {
-    gc_data = wpt->gc_data;
+    gc_data = wpt->ext->gc_data;
   }
 
   if FIELD_USED(fld_gc_id) {
@@ -1865,6 +2186,7 @@ unicsv_wr_init(const char* filename)
   } else {
     unicsv_datum_idx = gt_lookup_datum_index(opt_datum, MYNAME);
   }
+  GPS_Math_Datum_Transform_Init(&unicsv_datum_xform, DATUM_WGS84, unicsv_datum_idx);
 
   llprec = atoi(opt_prec);
 }
@@ -1878,21 +2200,34 @@ unicsv_wr_deinit(void)
 static void
 unicsv_wr(void)
 {
+  const global_trait* traits;
+
   switch (global_opts.objective) {
   case wptdata:
   case unknown_gpsdata:
-    waypt_disp_all(unicsv_waypt_enum_cb);
+    traits = get_traits(wptdata);
     break;
   case trkdata:
-    track_disp_all(NULL, NULL, unicsv_waypt_enum_cb);
-    break;
   case rtedata:
-    route_disp_all(NULL, NULL, unicsv_waypt_enum_cb);
+    traits = get_traits(global_opts.objective);
     break;
   case posndata:
+  default:
     fatal(MYNAME ": Realtime positioning not supported.\n");
   }
 
+  /* Skip the walk over all points when the lists already know what's
+   * in them; the garmin and geocache columns need a closer look. */
+  if (traits && !traits->trait_gmsd && !traits->trait_gc_data) {
+    unicsv_traits_to_fields(traits);
+  } else if (global_opts.objective == trkdata) {
+    track_disp_all(NULL, NULL, unicsv_waypt_enum_cb);
+  } else if (global_opts.objective == rtedata) {
+    route_disp_all(NULL, NULL, unicsv_waypt_enum_cb);
+  } else {
+    waypt_disp_all(unicsv_waypt_enum_cb);
+  }
+
   gbfprintf(fout, "No%s", unicsv_fieldsep);
 
   switch (unicsv_grid_idx) {
@@ -23,6 +23,9 @@
 #include "src/core/xmltag.h"
 #include "jeeps/gpsmath.h"
 
+#include <QtCore/QMutex>
+#include <QtCore/QSet>
+
 #include <ctype.h>
 #include <errno.h>
 #include <math.h>
@@ -884,7 +887,7 @@ get_cache_icon(const Waypoint* waypointp)
    * For icons, type overwrites container.  So a multi-micro will
    * get the icons for "multi".
    */
-  switch (waypointp->gc_data->type) {
+  switch (waypointp->ext->gc_data->type) {
   case gt_virtual:
     return "Virtual cache";
   case gt_multi:
@@ -899,7 +902,7 @@ get_cache_icon(const Waypoint* waypointp)
     break;
   }
 
-  switch (waypointp->gc_data->container) {
+  switch (waypointp->ext->gc_data->container) {
   case gc_micro:
     return "Micro-Cache";
     break;
@@ -907,7 +910,7 @@ get_cache_icon(const Waypoint* waypointp)
     break;
   }
 
-  if (waypointp->gc_data->diff > 1) {
+  if (waypointp->ext->gc_data->diff > 1) {
     return "Geocache";
   }
 
@@ -1190,6 +1193,66 @@ rot13(const QString& s)
   return r;
 }
 
+/*
+ * String pool for per-point values that take few distinct values across
+ * a file, such as symbol names.  The returned copy shares its buffer with
+ * every other string of the same contents, so a million points carrying
+ * "Flag, Blue" hold a single allocation between them.  Free text such as
+ * comments and descriptions doesn't belong here: each call takes a lock
+ * and a hash lookup, and the pool would mostly fill with one-off strings.
+ *
+ * Readers may run on worker threads, so the pool is guarded.  Once it
+ * holds INTERN_MAX entries the field clearly isn't low-cardinality for
+ * this input and new strings are passed through untouched.
+ */
+
+#define INTERN_MAX 65536
+
+static QMutex intern_lock;
+static QSet<QString> intern_pool;
+static unsigned long intern_hits;
+static unsigned long intern_misses;
+
+QString
+intern(const QString& s)
+{
+  if (s.isEmpty()) {
+    return s;
+  }
+
+  QMutexLocker locker(&intern_lock);
+  QSet<QString>::const_iterator it = intern_pool.constFind(s);
+  if (it != intern_pool.constEnd()) {
+    intern_hits++;
+    return *it;
+  }
+  intern_misses++;
+  if (intern_pool.size() < INTERN_MAX) {
+    intern_pool.insert(s);
+  }
+  return s;
+}
+
+void
+intern_stats()
+{
+  QMutexLocker locker(&intern_lock);
+  unsigned long total = intern_hits + intern_misses;
+  if (total == 0) {
+    return;
+  }
+  fprintf(stderr, "intern: %lu lookups, %lu hits (%.1f%%), %d pooled strings\n",
+          total, intern_hits, 100.0 * intern_hits / total, intern_pool.size());
+}
+
+void
+intern_flush()
+{
+  QMutexLocker locker(&intern_lock);
+  intern_pool.clear();
+  intern_hits = intern_misses = 0;
+}
+
 /*
  * Convert a human readable date format (i.e. "YYYY/MM/DD") into
  * a format usable for strftime and others
@@ -1352,6 +1415,81 @@ convert_human_time_format(const char* human_timef)
 }
 
 
+/*
+ * Write d with prec (0..9) decimals to buf, which must hold at least 32
+ * chars, exactly as printf("%.*f", prec, d) would, and return the length.
+ * Values where scaling by 10^prec can't be trusted to round the same way
+ * as the library (very large magnitudes, near-ties, negative zero, NaN)
+ * return -1 and leave the work to the caller.
+ */
+int
+fixed_dtoa(char* buf, double d, int prec)
+{
+  static const double scale[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+  };
+  static const unsigned long long iscale[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL,
+    1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL
+  };
+  char digits[24];
+  char* p = buf;
+  int n = 0;
+
+  if (prec < 0 || prec > 9 || !(d > -1e9 && d < 1e9)) {
+    return -1;
+  }
+
+  double a = fabs(d) * scale[prec];
+  if (a >= 1e15) {
+    return -1;
+  }
+  double ip = floor(a);
+  double frac = a - ip;
+  /* the product may be off by an ulp or so; don't guess near a tie. */
+  if (fabs(frac - 0.5) <= a * 1e-15 + 1e-12) {
+    return -1;
+  }
+  unsigned long long q = (unsigned long long) ip + (frac > 0.5);
+  if (signbit(d)) {
+    if (q == 0) {
+      return -1;
+    }
+    *p++ = '-';
+  }
+
+  unsigned long long ipart = q / iscale[prec];
+  unsigned long long fpart = q % iscale[prec];
+  do {
+    digits[n++] = '0' + (char)(ipart % 10);
+    ipart /= 10;
+  } while (ipart);
+  while (n) {
+    *p++ = digits[--n];
+  }
+  if (prec) {
+    *p++ = '.';
+    for (n = prec; n--; fpart /= 10) {
+      p[n] = '0' + (char)(fpart % 10);
+    }
+    p += prec;
+  }
+  *p = '\0';
+  return p - buf;
+}
+
+QString
+fixed_to_string(double d, int prec)
+{
+  char buf[32];
+  int len = fixed_dtoa(buf, d, prec);
+
+  if (len < 0) {
+    return QString::number(d, 'f', prec);
+  }
+  return QString::fromLatin1(buf, len);
+}
+
 /*
  * Return a decimal degree pair as
  * DD.DDDDD  DD MM.MMM or DD MM SS.S
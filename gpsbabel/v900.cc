@@ -336,9 +336,9 @@ v900_read(void)
     wpt->wpt_flags.course = 1;
 
     if (is_advanced_mode) {
-      wpt->hdop = atof(line.adv.hdop);
-      wpt->vdop = atof(line.adv.vdop);
-      wpt->pdop = atof(line.adv.pdop);
+      wpt->AllocExt()->hdop = atof(line.adv.hdop);
+      wpt->AllocExt()->vdop = atof(line.adv.vdop);
+      wpt->AllocExt()->pdop = atof(line.adv.pdop);
 
       /* handle fix mode (2d, 3d, etc.) */
       if (!strcmp(line.adv.valid,"DGPS")) {
@@ -118,15 +118,15 @@ vcf_disp(const Waypoint* wpt)
   }
 
   gbfprintf(file_out, "NOTE:");
-  vcf_print_utf(&wpt->gc_data->desc_short);
+  vcf_print_utf(&wpt->ext->gc_data->desc_short);
   gbfprintf(file_out, "\\n");
-  vcf_print_utf(&wpt->gc_data->desc_long);
+  vcf_print_utf(&wpt->ext->gc_data->desc_long);
   gbfprintf(file_out, "\\n\\nHINT:\\n");
   if (vcf_encrypt) {
-    QString s = rot13(wpt->gc_data->hint);
+    QString s = rot13(wpt->ext->gc_data->hint);
     vcf_print(s);
   } else {
-    vcf_print(CSTR(wpt->gc_data->hint));
+    vcf_print(CSTR(wpt->ext->gc_data->hint));
   }
 
   gbfprintf(file_out, "\nEND:VCARD\n");
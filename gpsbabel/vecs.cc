@@ -178,6 +178,7 @@ extern ff_vecs_t format_fit_vecs;
 extern ff_vecs_t mapbar_track_vecs;
 extern ff_vecs_t f90g_track_vecs;
 extern ff_vecs_t mapfactor_vecs;
+extern ff_vecs_t gbsnap_vecs;
 
 static
 vecs_t vec_list[] = {
@@ -1084,6 +1085,13 @@ vecs_t vec_list[] = {
     "cpo",
     NULL,
   },
+  {
+    &gbsnap_vecs,
+    "gbsnap",
+    "GPSBabel binary snapshot",
+    "gbsnap",
+    NULL,
+  },
 #endif // MAXIMAL_ENABLED
   {
     NULL,
@@ -1362,7 +1370,7 @@ find_vec(const char* vecname, const char** opts)
       disp_vec_options(svec->name, vec_list[0].vec->args);
     }
 #if CSVFMTS_ENABLED
-    xcsv_setup_internal_style(svec->style_buf);
+    xcsv_setup_internal_style(svec->style);
 #endif // CSVFMTS_ENABLED
 
     xfree(v);
@@ -1377,6 +1385,94 @@ find_vec(const char* vecname, const char** opts)
   return NULL;
 }
 
+/*
+ * The option values of a format, held while code that runs between the
+ * command line's find_vec() and its use of the format (a filter, say)
+ * sets the same format up with options of its own.
+ */
+struct vec_options {
+  ff_vecs_t* vec;
+  const char* name;
+  const xcsv_style_t* style;
+  char** argval;		/* *ap->argval */
+  char** argvalptr;		/* ap->argvalptr, ours while saved */
+};
+
+/*
+ * Take the options of the format find_vec() would give for vecname out
+ * of its arglist, or return NULL if there is no such format.
+ */
+vec_options_t*
+vec_options_save(const char* vecname)
+{
+  char* v = xstrdup(vecname);
+  char* svecname = strtok(v, ",");
+  ff_vecs_t* found = NULL;
+  vec_options_t* saved;
+  int n = 0;
+
+  for (vecs_t* vec = vec_list; vec->vec && !found; vec++) {
+    if (svecname && (case_ignore_strcmp(svecname, vec->name) == 0)) {
+      found = vec->vec;
+    }
+  }
+  for (style_vecs_t* svec = style_list; svec->name && !found; svec++) {
+    if (svecname && (case_ignore_strcmp(svecname, svec->name) == 0)) {
+      found = vec_list[0].vec;
+    }
+  }
+  xfree(v);
+  if (found == NULL) {
+    return NULL;
+  }
+
+  for (arglist_t* ap = found->args; ap && ap->argstring; ap++) {
+    n++;
+  }
+  saved = (vec_options_t*) xcalloc(1, sizeof(*saved));
+  saved->vec = found;
+  saved->name = found->name;
+  saved->style = xcsv_get_internal_style();
+  saved->argval = (char**) xcalloc(n + 1, sizeof(char*));
+  saved->argvalptr = (char**) xcalloc(n + 1, sizeof(char*));
+  n = 0;
+  for (arglist_t* ap = found->args; ap && ap->argstring; ap++, n++) {
+    saved->argval[n] = ap->argval ? *ap->argval : NULL;
+    saved->argvalptr[n] = ap->argvalptr;
+    ap->argvalptr = NULL;	/* so assign_option() won't free it */
+  }
+  return saved;
+}
+
+/* Put back what vec_options_save() took, dropping any options since. */
+void
+vec_options_restore(vec_options_t* saved)
+{
+  int n = 0;
+
+  if (saved == NULL) {
+    return;
+  }
+  for (arglist_t* ap = saved->vec->args; ap && ap->argstring; ap++, n++) {
+    if (ap->argvalptr) {
+      xfree(ap->argvalptr);
+    }
+    ap->argvalptr = saved->argvalptr[n];
+    if (ap->argval) {
+      *ap->argval = saved->argval[n];
+    }
+  }
+  saved->vec->name = saved->name;
+#if CSVFMTS_ENABLED
+  if (saved->vec == vec_list[0].vec) {
+    xcsv_setup_internal_style(saved->style);
+  }
+#endif // CSVFMTS_ENABLED
+  xfree(saved->argval);
+  xfree(saved->argvalptr);
+  xfree(saved);
+}
+
 /*
  * Find and return a specific argument in an arg list.
  * Modelled approximately after getenv.
@@ -1478,19 +1574,18 @@ sort_and_unify_vecs(int* ctp)
   }
 
 #if CSVFMTS_ENABLED
-  /* Walk the style list, parse the entries, dummy up a "normal" vec */
+  /* Walk the (pre-parsed) style list, dummy up a "normal" vec */
   for (svec = style_list; svec->name; svec++, i++)  {
-    xcsv_read_internal_style(svec->style_buf);
     svp[i] = (vecs_t*) xcalloc(1, sizeof** svp);
     svp[i]->name = svec->name;
     svp[i]->vec = (ff_vecs_t*) xmalloc(sizeof(*svp[i]->vec));
-    svp[i]->extension = xcsv_file.extension;
+    svp[i]->extension = svec->style->extension;
     *svp[i]->vec = *vec_list[0].vec; /* Interits xcsv opts */
     /* Reset file type to inherit ff_type from xcsv for everything
      * except the xcsv format itself, which we leave as "internal"
      */
     if (case_ignore_strcmp(svec->name, "xcsv")) {
-      svp[i]->vec->type = xcsv_file.type;
+      svp[i]->vec->type = svec->style->type;
       /* Skip over the first help entry for all but the
        * actual 'xcsv' format - so we don't expose the
        * 'full path to xcsv style file' argument to any
@@ -1499,7 +1594,7 @@ sort_and_unify_vecs(int* ctp)
       svp[i]->vec->args++;
     }
     memset(&svp[i]->vec->cap, 0, sizeof(svp[i]->vec->cap));
-    switch (xcsv_file.datatype) {
+    switch (svec->style->datatype) {
     case 0:
     case wptdata:
       svp[i]->vec->cap[ff_cap_rw_wpt] = (ff_cap)(ff_cap_read | ff_cap_write);
@@ -1513,7 +1608,7 @@ sort_and_unify_vecs(int* ctp)
     default:
       ;
     }
-    svp[i]->desc = xcsv_file.description;
+    svp[i]->desc = svec->style->description;
     svp[i]->parent = "xcsv";
   }
 #endif // CSVFMTS_ENABLED
@@ -174,7 +174,7 @@ vitosmt_read(void)
 
     WAYPT_SET(wpt_tmp, speed, KNOTS_TO_MPS(speed)); /* meters per second */
     WAYPT_SET(wpt_tmp, course, course);
-    wpt_tmp->pdop	= pdop;
+    wpt_tmp->AllocExt()->pdop	= pdop;
 
     /*
     	GPS Fix data
@@ -277,8 +277,8 @@ vitosmt_waypt_pr(const Waypoint* waypointp)
   position += sizeof(double);
 
   /* pdop */
-  if (waypointp->pdop>0) {
-    WriteDouble(&workbuffer[position], waypointp->pdop);
+  if (waypointp->ext->pdop>0) {
+    WriteDouble(&workbuffer[position], waypointp->ext->pdop);
   }
   position += sizeof(double);
 
@@ -41,14 +41,71 @@ queue waypt_head;
 
 static unsigned int waypt_ct;
 static short_handle mkshort_handle;
-geocache_data Waypoint::empty_gc_data;
+geocache_data waypt_ext::empty_gc_data;
+waypt_ext Waypoint::empty_ext;
 static global_trait traits;
+static global_trait list_traits[posndata];	/* by gpsdata_type */
+static int list_traits_exact = 1;
+static int list_traits_reader_ok;
+unsigned int cache_generation = 1;
+static bounds waypt_bounds;		/* memoized waypt_compute_bounds() */
+static unsigned int waypt_bounds_gen;	/* == cache_generation while valid */
 
 const global_trait* get_traits(void)
 {
   return &traits;
 }
 
+const global_trait* get_traits(gpsdata_type type)
+{
+  if (! list_traits_exact) {
+    return NULL;
+  }
+  switch (type) {
+  case wptdata:
+  case trkdata:
+  case rtedata:
+    return &list_traits[type];
+  default:
+    return NULL;
+  }
+}
+
+void
+traits_begin_read(void)
+{
+  list_traits_reader_ok = 0;
+}
+
+void
+traits_add_complete(void)
+{
+  list_traits_reader_ok = 1;
+}
+
+void
+traits_end_read(void)
+{
+  if (! list_traits_reader_ok) {
+    traits_invalidate();
+  }
+}
+
+void
+traits_invalidate(void)
+{
+  list_traits_exact = 0;
+}
+
+void
+cache_invalidate(void)
+{
+  /* 0 is reserved for "never computed". */
+  if (++cache_generation == 0) {
+    cache_generation = 1;
+  }
+}
+
 void
 waypt_init(void)
 {
@@ -60,20 +117,63 @@ waypt_init(void)
 #endif
 }
 
-void update_common_traits(const Waypoint* wpt)
+void update_common_traits(const Waypoint* wpt, gpsdata_type type)
 {
+  global_trait* lt;
+
   /* This is a bit tacky, but it allows a hint whether we've seen
    * this data or not in the life cycle of this run.   Of course,
    * the caches could have been filtered out of existance and not
    * all waypoints may have this and a few other pitfalls, but it's
    * an easy and fast test here.
    */
-  traits.trait_geocaches |= (wpt->gc_data->diff && wpt->gc_data->terr);
-  traits.trait_heartrate |= wpt->heartrate > 0;
-  traits.trait_cadence |= wpt->cadence > 0;
-  traits.trait_power |= wpt->power > 0;
+  traits.trait_geocaches |= (wpt->ext->gc_data->diff && wpt->ext->gc_data->terr);
+  traits.trait_heartrate |= wpt->ext->heartrate > 0;
+  traits.trait_cadence |= wpt->ext->cadence > 0;
+  traits.trait_power |= wpt->ext->power > 0;
   traits.trait_depth |= WAYPT_HAS(wpt, depth);
   traits.trait_temperature |= WAYPT_HAS(wpt, temperature);
+
+  if (! list_traits_exact) {
+    return;
+  }
+  if ((type != wptdata) && (type != trkdata) && (type != rtedata)) {
+    return;
+  }
+  lt = &list_traits[type];
+  lt->trait_geocaches |= (wpt->ext->gc_data->diff && wpt->ext->gc_data->terr);
+  lt->trait_heartrate |= wpt->ext->heartrate > 0;
+  lt->trait_cadence |= wpt->ext->cadence > 0;
+  lt->trait_power |= wpt->ext->power > 0;
+  lt->trait_depth |= WAYPT_HAS(wpt, depth);
+  lt->trait_temperature |= WAYPT_HAS(wpt, temperature);
+
+  lt->trait_shortname |= !wpt->shortname.isEmpty();
+  lt->trait_altitude |= wpt->altitude != unknown_alt;
+  lt->trait_icon |= !wpt->ext->icon_descr.isNull();
+  if (!wpt->description.isEmpty() && (wpt->shortname != wpt->description)) {
+    lt->trait_description = 1;
+  }
+  if (!wpt->ext->notes.isEmpty() && (wpt->shortname != wpt->ext->notes)) {
+    if (wpt->description.isEmpty() || (wpt->description != wpt->ext->notes)) {
+      lt->trait_notes = 1;
+    }
+  }
+  lt->trait_url |= wpt->HasUrlLink();
+  if (wpt->creation_time.isValid()) {
+    lt->trait_time = 1;
+    lt->trait_date |= wpt->creation_time.toTime_t() >= SECONDS_PER_DAY;
+  }
+  lt->trait_fix |= wpt->fix != fix_unknown;
+  lt->trait_hdop |= wpt->ext->hdop > 0;
+  lt->trait_vdop |= wpt->ext->vdop > 0;
+  lt->trait_pdop |= wpt->ext->pdop > 0;
+  lt->trait_sat |= wpt->sat > 0;
+  lt->trait_course |= WAYPT_HAS(wpt, course);
+  lt->trait_speed |= WAYPT_HAS(wpt, speed);
+  lt->trait_proximity |= WAYPT_HAS(wpt, proximity);
+  lt->trait_gmsd |= GMSD_FIND(wpt) != NULL;
+  lt->trait_gc_data |= !wpt->EmptyGCData();
 }
 
 void
@@ -119,8 +219,8 @@ waypt_add(Waypoint* wpt)
   if (wpt->shortname.isNull()) {
     if (!wpt->description.isNull()) {
       wpt->shortname = wpt->description;
-    } else if (!wpt->notes.isNull()) {
-      wpt->shortname = wpt->notes;
+    } else if (!wpt->ext->notes.isNull()) {
+      wpt->shortname = wpt->ext->notes;
     } else {
       QString n;
       n.sprintf("%03d", waypt_count());
@@ -129,8 +229,8 @@ waypt_add(Waypoint* wpt)
   }
 
   if (wpt->description.isEmpty()) {
-    if (!wpt->notes.isNull()) {
-      wpt->description = wpt->notes;
+    if (!wpt->ext->notes.isNull()) {
+      wpt->description = wpt->ext->notes;
     } else {
       if (!wpt->shortname.isNull()) {
         wpt->description = wpt->shortname;
@@ -138,8 +238,11 @@ waypt_add(Waypoint* wpt)
     }
   }
 
-  update_common_traits(wpt);
+  update_common_traits(wpt, wptdata);
 
+  if (waypt_bounds_gen == cache_generation) {
+    waypt_add_to_bounds(&waypt_bounds, wpt);
+  }
 }
 
 void
@@ -152,6 +255,8 @@ waypt_del(Waypoint* wpt)
   dequeue(&wpt->Q);
   waypt_ct--;
 #endif
+  waypt_bounds_gen = 0;
+  traits_invalidate();
 }
 
 unsigned int
@@ -279,23 +384,54 @@ waypt_add_to_bounds(bounds* bounds, const Waypoint* waypointp)
 
 
 /*
- *  Makes another pass over the data to compute bounding
- *  box data and populates bounding box information.
+ *  Bounding box of the waypoint list.  The pass over the data is
+ *  only made when the list has changed in ways waypt_add() can't
+ *  track incrementally.
  */
 
 void
 waypt_compute_bounds(bounds* bounds)
 {
-  waypt_init_bounds(bounds);
+  if (waypt_bounds_gen != cache_generation) {
+    waypt_init_bounds(&waypt_bounds);
 #if NEWQ
-  foreach(Waypoint* waypointp, waypt_list) {
+    foreach(Waypoint* waypointp, waypt_list) {
 #else
-  queue* elem, *tmp;
-  Waypoint* waypointp;
-  QUEUE_FOR_EACH(&waypt_head, elem, tmp) {
-    waypointp = (Waypoint*) elem;
+    queue* elem, *tmp;
+    Waypoint* waypointp;
+    QUEUE_FOR_EACH(&waypt_head, elem, tmp) {
+      waypointp = (Waypoint*) elem;
 #endif
-    waypt_add_to_bounds(bounds, waypointp);
+      waypt_add_to_bounds(&waypt_bounds, waypointp);
+    }
+    waypt_bounds_gen = cache_generation;
+  }
+  *bounds = waypt_bounds;
+}
+
+/*
+ * Widen a bounding box to take in another one.
+ */
+void
+waypt_merge_bounds(bounds* bds, const bounds* other)
+{
+  if (other->max_lat > bds->max_lat) {
+    bds->max_lat = other->max_lat;
+  }
+  if (other->max_lon > bds->max_lon) {
+    bds->max_lon = other->max_lon;
+  }
+  if (other->min_lat < bds->min_lat) {
+    bds->min_lat = other->min_lat;
+  }
+  if (other->min_lon < bds->min_lon) {
+    bds->min_lon = other->min_lon;
+  }
+  if (other->min_alt < bds->min_alt) {
+    bds->min_alt = other->min_alt;
+  }
+  if (other->max_alt > bds->max_alt) {
+    bds->max_alt = other->max_alt;
   }
 }
 
@@ -333,6 +469,7 @@ waypt_flush(queue* head)
     while (!waypt_list.isEmpty()) {
       delete waypt_list.takeFirst();
     }
+    waypt_bounds_gen = 0;
   }
 }
 #else
@@ -348,12 +485,16 @@ waypt_flush(queue* head)
       waypt_ct--;
     }
   }
+  if (head == &waypt_head) {
+    waypt_bounds_gen = 0;
+  }
 }
 #endif
 
 void
 waypt_flush_all()
 {
+  traits_invalidate();
   if (mkshort_handle) {
     mkshort_del_handle(&mkshort_handle);
   }
@@ -374,6 +515,7 @@ waypt_backup(signed int* count, queue** head_bak)
 
   qbackup = (queue*) xcalloc(1, sizeof(*qbackup));
   QUEUE_INIT(qbackup);
+  waypt_bounds_gen = 0;
 #if NEWQ
 // Why does this code exist?
 //abort();
@@ -409,19 +551,20 @@ waypt_restore(signed int count, queue* head_bak)
   QUEUE_MOVE(&waypt_head, head_bak);
 #endif
   waypt_ct = count;
+  waypt_bounds_gen = 0;
   xfree(head_bak);
 }
 
 void
 waypt_add_url(Waypoint* wpt, const QString& link, const QString& url_link_text)
 {
-  wpt->url_link_list_.push_back(UrlLink(link, url_link_text));
+  wpt->AllocExt()->url_link_list_.push_back(UrlLink(link, url_link_text));
 }
 
 void
 waypt_add_url(Waypoint* wpt, const QString& link, const QString& url_link_text, const QString& url_link_type)
 {
-  wpt->url_link_list_.push_back(UrlLink(link, url_link_text, url_link_type));
+  wpt->AllocExt()->url_link_list_.push_back(UrlLink(link, url_link_text, url_link_type));
 }
 
 double
@@ -560,36 +703,25 @@ Waypoint::Waypoint() :
   latitude(0),  // These should probably use some invalid data, but
   longitude(0), // it looks like we have code that relies on them being zero.
   altitude(unknown_alt),
-  geoidheight(0),
-  depth(0),
-  proximity(0),
-  route_priority(0),
-  hdop(0),
-  vdop(0),
-  pdop(0),
   course(0),
   speed(0),
   fix(fix_unknown),
   sat(-1),
-  heartrate(0),
-  cadence(0),
-  power(0),
-  temperature(0),
-  odometer_distance(0),
-  gc_data(&Waypoint::empty_gc_data),
-  fs(NULL),
   session(curr_session()),
-  extra_data(NULL)
+  ext(&Waypoint::empty_ext)
 {
   QUEUE_INIT(&Q);
 }
 
 Waypoint::~Waypoint()
 {
-  if (gc_data != &Waypoint::empty_gc_data) {
-    delete gc_data;
+  if (ext != &Waypoint::empty_ext) {
+    if (ext->gc_data != &waypt_ext::empty_gc_data) {
+      delete ext->gc_data;
+    }
+    fs_chain_destroy(ext->fs);
+    delete ext;
   }
-  fs_chain_destroy(fs);
 }
 
 Waypoint::Waypoint(const Waypoint& other) :
@@ -597,50 +729,35 @@ Waypoint::Waypoint(const Waypoint& other) :
   latitude(other.latitude),
   longitude(other.longitude),
   altitude(other.altitude),
-  geoidheight(other.geoidheight),
-  depth(other.depth),
-  proximity(other.proximity),
   shortname(other.shortname),
   description(other.description),
-  notes(other.notes),
-  url_link_list_(other.url_link_list_),
   wpt_flags(other.wpt_flags),
-  icon_descr(other.icon_descr),
   creation_time(other.creation_time),
-  route_priority(other.route_priority),
-  hdop(other.hdop),
-  vdop(other.vdop),
-  pdop(other.pdop),
   course(other.course),
   speed(other.speed),
   fix(other.fix),
   sat(other.sat),
-  heartrate(other.heartrate),
-  cadence(other.cadence),
-  power(other.power),
-  temperature(other.temperature),
-  odometer_distance(other.odometer_distance),
-  gc_data(other.gc_data),
-  fs(other.fs),
   session(other.session),
-  extra_data(other.extra_data)
+  ext(other.ext)
 {
-  // deep copy geocache data unless it is the specail static empty_gc_data.
-  if (other.gc_data != &Waypoint::empty_gc_data) {
-    gc_data = new geocache_data(*other.gc_data);
-  }
-
   /*
    * It's important that this duplicated waypoint not appear
    * on the master Q.
    */
   QUEUE_INIT(&Q);
 
-  // deep copy fs chain data.
-  fs = fs_chain_copy(other.fs);
-
+  // deep copy the extension block, its fs chain data and
+  // geocache data unless it is the specail static empty_gc_data.
   // note: session is not deep copied.
   // note: extra_data is not deep copied.
+  if (other.ext != &Waypoint::empty_ext) {
+    waypt_ext* e = new waypt_ext(*other.ext);
+    if (other.ext->gc_data != &waypt_ext::empty_gc_data) {
+      e->gc_data = new geocache_data(*other.ext->gc_data);
+    }
+    e->fs = fs_chain_copy(other.ext->fs);
+    ext = e;
+  }
 }
 
 Waypoint& Waypoint::operator=(const Waypoint& other)
@@ -654,25 +771,25 @@ Waypoint& Waypoint::operator=(const Waypoint& other)
 bool
 Waypoint::HasUrlLink() const
 {
-  return !url_link_list_.isEmpty();
+  return !ext->url_link_list_.isEmpty();
 }
 
 const UrlLink&
 Waypoint::GetUrlLink() const
 {
-  return url_link_list_[0];
+  return ext->url_link_list_[0];
 }
 
 const QList<UrlLink>
 Waypoint::GetUrlLinks() const
 {
-  return url_link_list_;
+  return ext->url_link_list_;
 }
 
 void
 Waypoint::AddUrlLink(const UrlLink l)
 {
-  url_link_list_.push_back(l);
+  AllocExt()->url_link_list_.push_back(l);
 }
 
 QString
@@ -721,14 +838,31 @@ Waypoint::SetCreationTime(time_t t, int ms)
 geocache_data*
 Waypoint::AllocGCData()
 {
-  if (gc_data == &Waypoint::empty_gc_data) {
-    gc_data = new geocache_data;
+  waypt_ext* e = AllocExt();
+
+  if (e->gc_data == &waypt_ext::empty_gc_data) {
+    e->gc_data = new geocache_data;
   }
-  return gc_data;
+  return e->gc_data;
 }
 
 int
 Waypoint::EmptyGCData() const
 {
-  return (gc_data == &Waypoint::empty_gc_data);
+  return (ext->gc_data == &waypt_ext::empty_gc_data);
+}
+
+bool
+Waypoint::HasExt() const
+{
+  return ext != &Waypoint::empty_ext;
+}
+
+waypt_ext*
+Waypoint::AllocExt()
+{
+  if (ext == &Waypoint::empty_ext) {
+    ext = new waypt_ext;
+  }
+  return (waypt_ext*) ext;
 }
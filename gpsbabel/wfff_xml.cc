@@ -170,7 +170,7 @@ void wfff_e(xg_string args, const QXmlStreamAttributes*)
 
     wpt_tmp->latitude = ap_lat;
     wpt_tmp->longitude = ap_lon;
-    wpt_tmp->hdop = ap_hdop;
+    wpt_tmp->AllocExt()->hdop = ap_hdop;
     wpt_tmp->altitude = unknown_alt;
     wpt_tmp->fix = fix_unknown;
 
@@ -178,15 +178,15 @@ void wfff_e(xg_string args, const QXmlStreamAttributes*)
     QString ap_type_(ap_type);
     if (ap_wep_.startsWith("on", Qt::CaseInsensitive)) {
       if (ap_type_.startsWith("AP", Qt::CaseInsensitive)) {
-        wpt_tmp->icon_descr = aicicon; /* Infra Closed */
+        wpt_tmp->AllocExt()->icon_descr = aicicon; /* Infra Closed */
       } else {
-        wpt_tmp->icon_descr = ahcicon; /* AdHoc Closed */
+        wpt_tmp->AllocExt()->icon_descr = ahcicon; /* AdHoc Closed */
       }
     } else {
       if (ap_type_.startsWith("AP", Qt::CaseInsensitive)) {
-        wpt_tmp->icon_descr = aioicon; /* Infra Open */
+        wpt_tmp->AllocExt()->icon_descr = aioicon; /* Infra Open */
       } else {
-        wpt_tmp->icon_descr = ahoicon;	/* AdHoc Open */
+        wpt_tmp->AllocExt()->icon_descr = ahoicon;	/* AdHoc Open */
       }
     }
 
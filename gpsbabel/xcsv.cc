@@ -41,7 +41,7 @@ char* prefer_shortnames = NULL;
 char* xcsv_urlbase = NULL;
 static char* opt_datum;
 
-static const char* intstylebuf = NULL;
+static const xcsv_style_t* intstyle = NULL;
 
 static
 arglist_t xcsv_args[] = {
@@ -122,14 +122,16 @@ xcsv_destroy_style(void)
   /* destroy the ifields */
   QUEUE_FOR_EACH(&xcsv_file.ifield, elem, tmp) {
     fmp = (field_map_t*) elem;
-    if (fmp->key) {
-      xfree(fmp->key);
-    }
-    if (fmp->val) {
-      xfree(fmp->val);
-    }
-    if (fmp->printfc) {
-      xfree(fmp->printfc);
+    if (!xcsv_file.is_internal) {
+      if (fmp->key) {
+        xfree(fmp->key);
+      }
+      if (fmp->val) {
+        xfree(fmp->val);
+      }
+      if (fmp->printfc) {
+        xfree(fmp->printfc);
+      }
     }
     if (elem) {
       xfree(elem);
@@ -140,14 +142,16 @@ xcsv_destroy_style(void)
   if (xcsv_file.ofield != &xcsv_file.ifield) {
     QUEUE_FOR_EACH(xcsv_file.ofield, elem, tmp) {
       fmp = (field_map_t*) elem;
-      if (fmp->key) {
-        xfree(fmp->key);
-      }
-      if (fmp->val) {
-        xfree(fmp->val);
-      }
-      if (fmp->printfc) {
-        xfree(fmp->printfc);
+      if (!xcsv_file.is_internal) {
+        if (fmp->key) {
+          xfree(fmp->key);
+        }
+        if (fmp->val) {
+          xfree(fmp->val);
+        }
+        if (fmp->printfc) {
+          xfree(fmp->printfc);
+        }
       }
       if (elem) {
         xfree(elem);
@@ -165,12 +169,14 @@ xcsv_destroy_style(void)
   xcsv_file.record_delimiter = QString();
   xcsv_file.badchars = QString();
 
-  if (xcsv_file.description) {
-    xfree(xcsv_file.description);
-  }
+  if (!xcsv_file.is_internal) {
+    if (xcsv_file.description) {
+      xfree(xcsv_file.description);
+    }
 
-  if (xcsv_file.extension) {
-    xfree(xcsv_file.extension);
+    if (xcsv_file.extension) {
+      xfree(xcsv_file.extension);
+    }
   }
 
   if (xcsv_file.mkshort_handle) {
@@ -324,11 +330,11 @@ xcsv_parse_style_line(char* sbuff)
                     } else
 
                       if (ISSTOKEN(sbuff, "PROLOGUE")) {
-                        xcsv_prologue_add(sbuff + 9);
+                        xcsv_prologue_add(sbuff[8] ? sbuff + 9 : sbuff + 8);
                       } else
 
                         if (ISSTOKEN(sbuff, "EPILOGUE")) {
-                          xcsv_epilogue_add(sbuff + 9);
+                          xcsv_epilogue_add(sbuff[8] ? sbuff + 9 : sbuff + 8);
                         } else
 
                           if (ISSTOKEN(sbuff, "ENCODING")) {
@@ -441,34 +447,6 @@ xcsv_parse_style_line(char* sbuff)
 }
 
 
-/*
- * A wrapper for xcsv_parse_style_line that reads until it hits
- * a terminating null.   Makes multiple calls to that function so
- * that "ignore to end of line" comments work right.
- */
-static void
-xcsv_parse_style_buff(const char* sbuff)
-{
-  // FIXME: should not be a static buf.  Should not be a raw character
-  // buffer at all!
-  char ibuf[4096];
-  char* ibufp;
-  size_t i;
-
-  while (*sbuff) {
-    ibuf[0] = 0;
-    i = 0;
-    for (ibufp = ibuf; *sbuff != '\n' && i++ < sizeof(ibuf);) {
-      *ibufp++ = *sbuff++;
-    }
-    while (*sbuff == '\n' || *sbuff == '\r') {
-      sbuff++;
-    }
-    *ibufp = 0;
-    xcsv_parse_style_line(ibuf);
-  }
-}
-
 static void
 xcsv_read_style(const char* fname)
 {
@@ -496,17 +474,54 @@ xcsv_read_style(const char* fname)
 }
 
 /*
- * Passed a pointer to an internal buffer that would be identical
- * to the series of bytes that would be in a style file, we set up
- * the xcsv parser and make it ready for general use.
+ * Passed one of the internal styles that mkstyle.sh parsed from style/
+ * at build time, we set up the xcsv parser and make it ready for general
+ * use.  The field maps point straight into the style tables.
  */
 void
-xcsv_read_internal_style(const char* style_buf)
+xcsv_read_internal_style(const xcsv_style_t* style)
 {
+  const char* const* line;
+  const xcsv_field_t* f;
+
   xcsv_file_init();
   xcsv_file.is_internal = 1;
 
-  xcsv_parse_style_buff(style_buf);
+  xcsv_file.description = (char*) style->description;
+  xcsv_file.extension = (char*) style->extension;
+  xcsv_file.field_delimiter = style->field_delimiter;
+  xcsv_file.field_encloser = style->field_encloser;
+  xcsv_file.record_delimiter = style->record_delimiter;
+  xcsv_file.badchars = style->badchars;
+  xcsv_file.type = style->type;
+  xcsv_file.datatype = style->datatype;
+
+  if (style->shortlen >= 0) {
+    setshort_length(xcsv_file.mkshort_handle, style->shortlen);
+  }
+  if (style->shortwhite >= 0) {
+    setshort_whitespace_ok(xcsv_file.mkshort_handle, style->shortwhite);
+  }
+  if (style->encoding) {
+    cet_convert_init(style->encoding, 1);
+  }
+  if (style->datum) {
+    xcsv_file.gps_datum = GPS_Lookup_Datum_Index(style->datum);
+    is_fatal(xcsv_file.gps_datum < 0, MYNAME ": datum \"%s\" is not supported.", style->datum);
+  }
+
+  for (line = style->prologue; *line; line++) {
+    xcsv_file.prologue.append(*line);
+  }
+  for (line = style->epilogue; *line; line++) {
+    xcsv_file.epilogue.append(*line);
+  }
+  for (f = style->ifield; f->key; f++) {
+    xcsv_ifield_add((char*) f->key, (char*) f->val, (char*) f->printfc);
+  }
+  for (f = style->ofield; f->key; f++) {
+    xcsv_ofield_add((char*) f->key, (char*) f->val, (char*) f->printfc, f->options);
+  }
 
   /* if we have no output fields, use input fields as output fields */
   if (xcsv_file.ofield_ct == 0) {
@@ -519,12 +534,19 @@ xcsv_read_internal_style(const char* style_buf)
 }
 
 void
-xcsv_setup_internal_style(const char* style_buf)
+xcsv_setup_internal_style(const xcsv_style_t* style)
 {
   xcsv_file_init();
   xcsv_destroy_style();
-  xcsv_file.is_internal = !!style_buf;
-  intstylebuf = style_buf;
+  xcsv_file.is_internal = !!style;
+  intstyle = style;
+}
+
+/* The style set up above, or NULL if a style file is used. */
+const xcsv_style_t*
+xcsv_get_internal_style(void)
+{
+  return xcsv_file.is_internal ? intstyle : NULL;
 }
 
 
@@ -537,7 +559,7 @@ xcsv_rd_init(const char* fname)
    * read it from a user-supplied style file, or die trying.
    */
   if (xcsv_file.is_internal) {
-    xcsv_read_internal_style(intstylebuf);
+    xcsv_read_internal_style(intstyle);
   } else {
     if (!styleopt) {
       fatal(MYNAME ": XCSV input style not declared.  Use ... -i xcsv,style=path/to/file.style\n");
@@ -574,7 +596,7 @@ xcsv_wr_init(const char* fname)
    * after a read of a style works.
    */
   if (xcsv_file.is_internal && !styleopt) {
-    xcsv_read_internal_style(intstylebuf);
+    xcsv_read_internal_style(intstyle);
   } else {
 
     if (!styleopt) {
@@ -669,6 +691,10 @@ ff_vecs_t xcsv_vecs = {
 
 };
 #else
-void xcsv_read_internal_style(const char* style_buf) {}
-void xcsv_setup_internal_style(const char* style_buf) {}
+void xcsv_read_internal_style(const xcsv_style_t* style) {}
+void xcsv_setup_internal_style(const xcsv_style_t* style) {}
+const xcsv_style_t* xcsv_get_internal_style(void)
+{
+  return NULL;
+}
 #endif //CSVFMTS_ENABLED
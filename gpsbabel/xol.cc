@@ -87,7 +87,7 @@ xol_shape(xg_string args, const QXmlStreamAttributes* attrv)
 
   if (wpt) {
     if (attrv->hasAttribute("comment")) {
-      wpt->notes = attrv->value("comment").toString();
+      wpt->AllocExt()->notes = attrv->value("comment").toString();
     }
 
     if (attrv->hasAttribute("alt")) {
@@ -95,11 +95,11 @@ xol_shape(xg_string args, const QXmlStreamAttributes* attrv)
     }
 
     if (attrv->hasAttribute("timestamp")) {
-      wpt->creation_time = xml_parse_time(attrv->value("timestamp").toString().toUtf8().constData());
+      wpt->creation_time = xml_parse_time(attrv->value("timestamp"));
     }
 
     if (attrv->hasAttribute("icon")) {
-      wpt->icon_descr = attrv->value("icon").toString();
+      wpt->AllocExt()->icon_descr = attrv->value("icon").toString();
     }
   }
 }
@@ -190,12 +190,6 @@ xol_write_string(const QString& name, const QString& str)
   }
 }
 
-static void
-xol_waypt_bound_calc(const Waypoint* wpt)
-{
-  waypt_add_to_bounds(&all_bounds, wpt);
-}
-
 static void
 xol_wr_init(const char* fname)
 {
@@ -239,8 +233,8 @@ xol_waypt_disp_cb(const Waypoint* wpt)
 
   gbfprintf(fout, "%*s<shape type=\"waypoint\"", space++*2, "");
   xol_write_string("name", name);
-  xol_write_string("comment", wpt->notes);
-  xol_write_string("icon", wpt->icon_descr);
+  xol_write_string("comment", wpt->ext->notes);
+  xol_write_string("icon", wpt->ext->icon_descr);
   if (wpt->creation_time.isValid()) {
     xol_write_time(wpt);
   }
@@ -299,8 +293,8 @@ xol_write(void)
 {
   double x, y;
 
-  waypt_disp_all(xol_waypt_bound_calc);
-  track_disp_all(NULL, NULL, xol_waypt_bound_calc);
+  waypt_compute_bounds(&all_bounds);
+  track_add_all_to_bounds(&all_bounds);
 
   if (! waypt_bounds_valid(&all_bounds)) {
     fatal(MYNAME ": No data available!\n");
@@ -102,10 +102,10 @@ void	wpt_lon(xg_string args, const QXmlStreamAttributes*)
 
 void	wpt_addr(xg_string args, const QXmlStreamAttributes*)
 {
-  if (!wpt_tmp->notes.isEmpty()) {
-    wpt_tmp->notes += as;
+  if (!wpt_tmp->ext->notes.isEmpty()) {
+    wpt_tmp->AllocExt()->notes += as;
   }
-  wpt_tmp->notes += args;
+  wpt_tmp->AllocExt()->notes += args;
 }
 
 ff_vecs_t yahoo_vecs = {